@@ -0,0 +1,345 @@
+/*
+* @file bench_utils.cpp
+*
+* Defines the keys, key distributions and treemap callbacks that are
+* used to benchmark the treemap implementation.
+*
+* @author Collector
+* @data 10/17/2026
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <numeric>
+#include <random>
+#include <algorithm>
+
+#include "bench_utils.h"
+
+#ifdef __linux__
+#include <malloc.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+namespace {
+	/*
+	* Seed of all random key orders, so every run measures the same keys.
+	*/
+	constexpr uint64_t benchmarkSeed{ 0x5eed };
+
+	/*
+	* Prime that scatters the zipfian ranks over the keys. It is bigger than
+	* every treemap size, so the scattering is a permutation.
+	*/
+	constexpr uint64_t zipfianScatter{ 2654435761 };
+
+	/*
+	* Draws key indices with a zipf distribution as described by Gray et al. in
+	* "Quickly Generating Billion-Record Synthetic Databases". The ranks are scattered
+	* over the keys, so the hot keys don't sit next to each other in the tree.
+	*/
+	class ZipfianGenerator {
+	public:
+		ZipfianGenerator(size_t keyAmount, double theta) :
+			keyAmount{ keyAmount }, theta{ theta }, zetaN{ computeZeta(keyAmount, theta) },
+			alpha{ 1.0 / (1.0 - theta) } {
+			double zeta2{ computeZeta(2, theta) };
+
+			eta = (1.0 - std::pow(2.0 / keyAmount, 1.0 - theta)) / (1.0 - zeta2 / zetaN);
+		}
+
+		template <typename Engine>
+		uint32_t next(Engine& engine) {
+			double u{ std::uniform_real_distribution<double>{ 0.0, 1.0 }(engine) };
+			double uz{ u * zetaN };
+			uint64_t rank;
+
+			if (uz < 1.0) {
+				rank = 0;
+			} else if (uz < 1.0 + std::pow(0.5, theta)) {
+				rank = 1;
+			} else {
+				rank = static_cast<uint64_t>(keyAmount * std::pow(eta * u - eta + 1.0, alpha));
+			}
+
+			rank = std::min<uint64_t>(rank, keyAmount - 1);
+
+			return static_cast<uint32_t>(rank * zipfianScatter % keyAmount);
+		}
+
+	private:
+		/*
+		* Sums 1 / i^theta for i from 1 to n. The sums are cached because they take
+		* a while for the big treemaps.
+		*/
+		static double computeZeta(size_t n, double theta) {
+			static std::map<std::pair<size_t, double>, double> zetas;
+			auto found{ zetas.find({ n, theta }) };
+
+			if (found != zetas.end()) {
+				return found->second;
+			}
+
+			double zeta{ 0.0 };
+
+			for (size_t i{ 1 }; i <= n; i++) {
+				zeta += 1.0 / std::pow(static_cast<double>(i), theta);
+			}
+
+			zetas[{ n, theta }] = zeta;
+
+			return zeta;
+		}
+
+		size_t keyAmount;
+		double theta;
+		double zetaN;
+		double alpha;
+		double eta;
+	};
+
+	long compareIntegerKey(const void* tKey, const void* insertedKey) {
+		size_t x{ *reinterpret_cast<const size_t*>(tKey) }, y{ *reinterpret_cast<const size_t*>(insertedKey) };
+
+		return y < x ? -1 : (y > x ? 1 : 0);
+	}
+
+	long compareStringKey(const void* tKey, const void* insertedKey) {
+		int result{ std::memcmp(insertedKey, tKey, sizeof(StringKey)) };
+
+		return result < 0 ? -1 : (result > 0 ? 1 : 0);
+	}
+
+	bool equalsSizeValue(const void* tValue, const void* tValueSearched) {
+		return *reinterpret_cast<const size_t*>(tValue) == *reinterpret_cast<const size_t*>(tValueSearched);
+	}
+
+	Status copyIntegerKey(void* dstKey, const void* srcKey, TreeMap* tm) {
+		*reinterpret_cast<size_t*>(dstKey) = *reinterpret_cast<const size_t*>(srcKey);
+
+		return Status::SUCCESS;
+	}
+
+	Status copyStringKey(void* dstKey, const void* srcKey, TreeMap* tm) {
+		*reinterpret_cast<StringKey*>(dstKey) = *reinterpret_cast<const StringKey*>(srcKey);
+
+		return Status::SUCCESS;
+	}
+
+	Status copySizeValue(void* dstValue, const void* srcValue, bool replaceValue, TreeMap* tm) {
+		*reinterpret_cast<size_t*>(dstValue) = *reinterpret_cast<const size_t*>(srcValue);
+
+		return Status::SUCCESS;
+	}
+
+#ifdef __linux__
+	/*
+	* Opens a hardware counter of the calling thread that starts disabled and doesn't
+	* count the kernel. The first counter leads the group, the others join it.
+	*/
+	int openPerfCounter(uint32_t type, uint64_t config, int groupFd) {
+		perf_event_attr attributes{};
+
+		attributes.size = sizeof(attributes);
+		attributes.type = type;
+		attributes.config = config;
+		attributes.disabled = groupFd == -1;
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+		attributes.read_format = PERF_FORMAT_GROUP;
+
+		return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, groupFd, 0));
+	}
+#endif
+}
+
+PerfCounters::PerfCounters() : instructionsFd{ -1 }, cacheMissesFd{ -1 }, tlbMissesFd{ -1 } {
+#ifdef __linux__
+	instructionsFd = openPerfCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, -1);
+
+	if (instructionsFd != -1) {
+		cacheMissesFd = openPerfCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, instructionsFd);
+	}
+
+	// Virtual machines often don't pass the tlb events through, the other counters work without it.
+	if (cacheMissesFd != -1) {
+		tlbMissesFd = openPerfCounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB
+			| PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16, instructionsFd);
+	}
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+	if (tlbMissesFd != -1) {
+		close(tlbMissesFd);
+	}
+
+	if (cacheMissesFd != -1) {
+		close(cacheMissesFd);
+	}
+
+	if (instructionsFd != -1) {
+		close(instructionsFd);
+	}
+#endif
+}
+
+bool PerfCounters::isAvailable() const {
+	return cacheMissesFd != -1;
+}
+
+void PerfCounters::start() {
+#ifdef __linux__
+	if (isAvailable()) {
+		ioctl(instructionsFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+#endif
+}
+
+void PerfCounters::stop() {
+#ifdef __linux__
+	if (isAvailable()) {
+		ioctl(instructionsFd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+	}
+#endif
+}
+
+void PerfCounters::report(benchmark::State& state, size_t operations) const {
+#ifdef __linux__
+	// The group is read as the amount of counters followed by their values.
+	uint64_t values[4]{};
+	ssize_t readSize{ static_cast<ssize_t>((tlbMissesFd != -1 ? 4 : 3) * sizeof(uint64_t)) };
+
+	if (!isAvailable() || operations == 0 || read(instructionsFd, values, readSize) != readSize) {
+		return;
+	}
+
+	state.counters["instructions_per_op"] = static_cast<double>(values[1]) / operations;
+	state.counters["cache_misses_per_op"] = static_cast<double>(values[2]) / operations;
+
+	if (tlbMissesFd != -1) {
+		state.counters["dtlb_misses_per_op"] = static_cast<double>(values[3]) / operations;
+	}
+#endif
+}
+
+BenchmarkPause::BenchmarkPause(benchmark::State& state, PerfCounters& counters) : state{ state }, counters{ counters } {
+	counters.stop();
+	state.PauseTiming();
+}
+
+BenchmarkPause::~BenchmarkPause() {
+	state.ResumeTiming();
+	counters.start();
+}
+
+size_t getHeapBytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+	return mallinfo2().uordblks;
+#else
+	return 0;
+#endif
+}
+
+void reportTimePerOperation(benchmark::State& state, size_t operations) {
+	state.counters["time_per_op"] = benchmark::Counter(static_cast<double>(operations),
+		benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+TreeMap* IntegerKeys::createMap() {
+	Status s;
+
+	return createTreeMap(sizeof(size_t), sizeof(size_t), compareIntegerKey,
+		equalsSizeValue, copyIntegerKey, copySizeValue, nullptr, &s);
+}
+
+void IntegerKeys::makeKey(size_t number, Key* key) {
+	*key = number;
+}
+
+TreeMap* StringKeys::createMap() {
+	Status s;
+
+	return createTreeMap(sizeof(StringKey), sizeof(size_t), compareStringKey,
+		equalsSizeValue, copyStringKey, copySizeValue, nullptr, &s);
+}
+
+void StringKeys::makeKey(size_t number, Key* key) {
+	std::memset(key->text, 0, sizeof(key->text));
+	std::snprintf(key->text, sizeof(key->text), "key%020zu", number);
+}
+
+const char* getDistributionName(KeyDistribution distribution) {
+	switch (distribution) {
+	case KeyDistribution::SEQUENTIAL:
+		return "sequential";
+	case KeyDistribution::UNIFORM:
+		return "uniform";
+	default:
+		return "zipfian";
+	}
+}
+
+std::vector<uint32_t> createKeyOrder(KeyDistribution distribution, size_t keyAmount) {
+	std::vector<uint32_t> order(keyAmount);
+	std::mt19937_64 engine{ benchmarkSeed };
+
+	if (distribution == KeyDistribution::ZIPFIAN) {
+		ZipfianGenerator zipfian{ keyAmount, 0.99 };
+
+		for (uint32_t& index : order) {
+			index = zipfian.next(engine);
+		}
+
+		return order;
+	}
+
+	std::iota(order.begin(), order.end(), 0);
+
+	if (distribution == KeyDistribution::UNIFORM) {
+		std::shuffle(order.begin(), order.end(), engine);
+	}
+
+	return order;
+}
+
+std::vector<uint32_t> createKeyQueries(KeyDistribution distribution, size_t keyAmount, size_t amount) {
+	std::vector<uint32_t> queries(amount);
+	std::mt19937_64 engine{ benchmarkSeed };
+
+	if (distribution == KeyDistribution::SEQUENTIAL) {
+		for (size_t i{ 0 }; i < amount; i++) {
+			queries[i] = static_cast<uint32_t>(i % keyAmount);
+		}
+	} else if (distribution == KeyDistribution::UNIFORM) {
+		std::uniform_int_distribution<uint32_t> uniform{ 0, static_cast<uint32_t>(keyAmount - 1) };
+
+		for (uint32_t& index : queries) {
+			index = uniform(engine);
+		}
+	} else {
+		ZipfianGenerator zipfian{ keyAmount, 0.99 };
+
+		for (uint32_t& index : queries) {
+			index = zipfian.next(engine);
+		}
+	}
+
+	return queries;
+}
+
+std::vector<size_t> getBenchmarkSizes(size_t maxSize) {
+	std::vector<size_t> sizes;
+
+	for (size_t size{ 1'000 }; size <= maxSize && size <= 100'000'000; size *= 10) {
+		sizes.push_back(size);
+	}
+
+	return sizes;
+}
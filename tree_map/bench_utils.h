@@ -0,0 +1,279 @@
+/*
+* @file bench_utils.h
+*
+* Declares the keys, key distributions and treemap callbacks that are
+* used to benchmark the treemap implementation.
+*
+* @author Collector
+* @data 10/17/2026
+*/
+
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "tree_map.h"
+
+/*
+* Amount of keys that are precomputed for the lookup benchmarks. The benchmarks
+* cycle through them, so the key generation isn't part of the measurement.
+*/
+constexpr size_t benchmarkQueryAmount{ 1 << 20 };
+
+/*
+* Order in which the benchmarks visit the keys of a treemap with N keys.
+*/
+enum class KeyDistribution {
+	SEQUENTIAL, // Ascending keys.
+	UNIFORM, // Every key with the same probability.
+	ZIPFIAN // A few hot keys with a zipf distribution of theta 0.99.
+};
+
+/*
+* String key of the benchmarks. The number is written with leading zeros,
+* so the keys order the same way as their numbers.
+*
+* @var text - Zero terminated decimal number.
+*/
+struct StringKey {
+	char text[24];
+};
+
+/*
+* Pair of the treemaps with integer keys.
+*/
+struct IntegerPair {
+	size_t key;
+	size_t value;
+};
+
+/*
+* Pair of the treemaps with string keys.
+*/
+struct StringPair {
+	StringKey key;
+	size_t value;
+};
+
+/*
+* Key type of the benchmarks with integer keys. The key of index i is 2 * i, so
+* the odd numbers are free for the floor and ceiling family.
+*/
+struct IntegerKeys {
+	using Key = size_t;
+	using Pair = IntegerPair;
+
+	static constexpr const char* name{ "int" };
+
+	static TreeMap* createMap();
+	static void makeKey(size_t number, Key* key);
+};
+
+/*
+* Key type of the benchmarks with string keys. Uses the same numbers as IntegerKeys.
+*/
+struct StringKeys {
+	using Key = StringKey;
+	using Pair = StringPair;
+
+	static constexpr const char* name{ "string" };
+
+	static TreeMap* createMap();
+	static void makeKey(size_t number, Key* key);
+};
+
+/*
+* Fills a pair with the key of the given index and a value derived from it.
+*
+* @param[in] index - Index of the key inside the treemap.
+* @param[out] pair - Pair that gets its key and value set.
+*/
+template <typename Keys>
+void makeBenchmarkPair(size_t index, typename Keys::Pair* pair) {
+	Keys::makeKey(2 * index, &pair->key);
+	pair->value = index;
+}
+
+/*
+* Creates a treemap of the given key type that holds the keys of the indices 0 to amount - 1.
+* The keys are inserted in ascending order.
+*
+* @param[in] amount - Amount of pairs inside of the treemap.
+*
+* @return The filled treemap.
+*/
+template <typename Keys>
+TreeMap* createBenchmarkMap(size_t amount) {
+	TreeMap* tm{ Keys::createMap() };
+	typename Keys::Pair pair{};
+
+	for (size_t i{ 0 }; i < amount; i++) {
+		makeBenchmarkPair<Keys>(i, &pair);
+		putPair(tm, &pair);
+	}
+
+	return tm;
+}
+
+/*
+* Counts the instructions, the cache misses and the data tlb misses of the calling thread with
+* the hardware performance counters of linux. Without access to the counters the benchmarks only
+* report their times, the tlb misses are left out if the processor doesn't expose them.
+*/
+class PerfCounters {
+public:
+	PerfCounters();
+	~PerfCounters();
+
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+
+	/*
+	* Indicator if the hardware counters could be opened.
+	*/
+	bool isAvailable() const;
+
+	/*
+	* Continues counting.
+	*/
+	void start();
+
+	/*
+	* Pauses counting, the counted events are kept.
+	*/
+	void stop();
+
+	/*
+	* Adds the instructions, cache misses and data tlb misses per operation as counters to the benchmark.
+	*
+	* @param[in, out] state - State of the benchmark that gets the counters.
+	* @param[in] operations - Amount of operations the events are divided by.
+	*/
+	void report(benchmark::State& state, size_t operations) const;
+
+private:
+	int instructionsFd;
+	int cacheMissesFd;
+	int tlbMissesFd;
+};
+
+/*
+* Pauses the benchmark timing together with the performance counters, so the
+* preparation of an iteration isn't counted.
+*/
+class BenchmarkPause {
+public:
+	BenchmarkPause(benchmark::State& state, PerfCounters& counters);
+	~BenchmarkPause();
+
+private:
+	benchmark::State& state;
+	PerfCounters& counters;
+};
+
+/*
+* Amount of heap memory that the process currently uses.
+*
+* @return The allocated bytes or 0 if the c library can't tell.
+*/
+size_t getHeapBytes();
+
+/*
+* Adds the average time per operation as a counter to the benchmark. The counter is
+* needed by the benchmarks that execute many operations in one iteration.
+*
+* @param[in, out] state - State of the benchmark that gets the counter.
+* @param[in] operations - Amount of operations of all iterations.
+*/
+void reportTimePerOperation(benchmark::State& state, size_t operations);
+
+/*
+* Name of a key distribution as it appears in the benchmark names.
+*
+* @param[in] distribution - Distribution that gets named.
+*
+* @return The lower case name of the distribution.
+*/
+const char* getDistributionName(KeyDistribution distribution);
+
+/*
+* Creates the order in which a stream of operations visits the keys of a treemap with N keys.
+* Sequential and uniform orders visit every key once, ascending or shuffled. The zipfian order
+* draws N keys, so the hot keys repeat and some keys are never visited.
+*
+* @param[in] distribution - Distribution of the indices.
+* @param[in] keyAmount - Amount of keys N, every index is smaller than it.
+*
+* @return N indices of keys.
+*/
+std::vector<uint32_t> createKeyOrder(KeyDistribution distribution, size_t keyAmount);
+
+/*
+* Creates indices of keys that are drawn from the distribution for the lookup benchmarks.
+* The sequential distribution wraps around after the last key.
+*
+* @param[in] distribution - Distribution of the indices.
+* @param[in] keyAmount - Amount of keys N, every index is smaller than it.
+* @param[in] amount - Amount of indices to create.
+*
+* @return The drawn indices.
+*/
+std::vector<uint32_t> createKeyQueries(KeyDistribution distribution, size_t keyAmount, size_t amount);
+
+/*
+* Sizes of the benchmarked treemaps, from 1K up to the given maximum.
+*
+* @param[in] maxSize - Biggest treemap size that is benchmarked.
+*
+* @return The sizes in ascending order.
+*/
+std::vector<size_t> getBenchmarkSizes(size_t maxSize);
+
+/*
+* Registers the benchmarks of the basic treemap operations.
+*
+* @param[in] maxSize - Biggest treemap size that is benchmarked.
+*/
+void registerTreeMapBenchmarks(size_t maxSize);
+
+/*
+* Registers the benchmarks that compare the treemap with std::map, a btree map and
+* a sorted vector.
+*
+* @param[in] maxSize - Biggest container size that is benchmarked.
+*/
+void registerCompareBenchmarks(size_t maxSize);
+
+/*
+* Registers the benchmarks that measure the overhead of the user callbacks.
+*
+* @param[in] maxSize - Biggest treemap size that is benchmarked.
+*/
+void registerCallbackBenchmarks(size_t maxSize);
+
+/*
+* Registers the benchmarks that compare the data tlb misses of treenodes on the heap
+* and in node arenas.
+*
+* @param[in] maxSize - Biggest treemap size that is benchmarked.
+*/
+void registerArenaBenchmarks(size_t maxSize);
+
+/*
+* Registers the benchmarks that compare loadTreeMap with inserting the pairs of the snapshot again.
+*
+* @param[in] maxSize - Biggest treemap size that is benchmarked.
+*/
+void registerSnapshotBenchmarks(size_t maxSize);
+
+/*
+* Registers the benchmarks of the durable write throughput of logPutPair for several batch sizes.
+*/
+void registerLogBenchmarks();
+
+#endif
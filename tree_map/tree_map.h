@@ -11,6 +11,8 @@
 #ifndef TREEMAP_H
 #define TREEMAP_H
 
+#include <cstdio>
+
 /*
 * Status values that functions return
 * to indicate if something went wrong.
@@ -35,7 +37,95 @@ enum class Status {
 	TREE_NODE_PAIR_NULLPTR, // The given treenode pair is a nullptr.
 	KEY_BUFFER_NULLPTR, // The given key buffer is a nullptr.
 	VALUE_BUFFER_NULLPTR, // The given value buffer is a nullptr.
-	PAIR_BUFFER_NULLPTR // The given pair buffer is a nullptr.
+	PAIR_BUFFER_NULLPTR, // The given pair buffer is a nullptr.
+	TREE_MAP_NOT_EMPTY, // The flags of the treemap can only be set while it is empty.
+	AMOUNT_BUFFER_NULLPTR, // The given amount buffer is a nullptr.
+	INLINE_SIZE_MISMATCH, // Inline pairs need the size of InlineData as key and value size.
+	BLOCK_SIZE_ZERO, // The block size for createPayloadArena is 0.
+	PAYLOAD_ARENA_EXISTS, // The treemap already has a payload arena.
+	PAYLOAD_ARENA_NULLPTR, // The treemap has no payload arena.
+	RELOCATE_FUNC_NULLPTR, // The relocate function for compactPayloadArena is a nullptr.
+	VALUE_DICTIONARY_EXISTS, // The treemap already has a value dictionary.
+	NODE_ARENA_EXISTS, // The treemap already has a node arena.
+	CHUNK_SIZE_TOO_SMALL, // The chunk size for createNodeArena can't hold a single treenode.
+	NODE_ARENA_NULLPTR, // The treemap has no node arena.
+	COMPACTION_PENDING, // compactTreeMap used up its budget and needs to be called again.
+	FILE_NULLPTR, // The given file is a nullptr.
+	ERR_FILE_IO, // Writing, opening or mapping a file failed.
+	SNAPSHOT_INVALID, // The file isn't a complete snapshot of a treemap with the same pair sizes.
+	ERR_SERIALIZE_PAIR, // The serialize function returned an empty or too big record.
+	MAPPED_READ_ONLY, // The mapped treemap wasn't opened writable.
+	SHARED_CAPACITY_EXCEEDED, // The treemap holds more pairs than the shared treemap has room for.
+	BATCH_SIZE_ZERO, // The batch size for createTreeMapLog is 0.
+	CHECKPOINT_PENDING, // continueCheckpoint used up its budget and needs to be called again.
+	CHECKPOINT_RUNNING, // The treemap has a running checkpoint.
+	CHECKPOINT_NULLPTR, // The treemap has no running checkpoint.
+	CHECKPOINT_MULTI_MAP, // Checkpoints can't tell the pairs of a multimap apart.
+	MEMTABLE_LIMIT_ZERO, // The memtable limit for createLsmTree is 0.
+	MEMTABLE_MULTI_MAP, // The memtable of a lsm tree can't be a multimap.
+	SPILL_MULTI_MAP, // The treenodes of a multimap can't be spilled.
+	SPILL_NULLPTR, // The treemap has no memory budget.
+	PAGE_SIZE_INVALID, // The page size isn't a power of two from 4 KB to 16 KB or a treenode doesn't fit into a page.
+	POOL_SIZE_INVALID, // The buffer pool holds less than 4 pages or reads ahead more than half of them.
+	STREAM_CAPACITY_INVALID, // The capacity of a change stream isn't a power of two.
+	CHANGE_STREAM_EXISTS, // The treemap already has a change stream.
+	CHANGES_LOST, // The change stream was full, so the replicas have to be synchronised from a snapshot.
+	HASH_UNSUPPORTED, // The pairs of the treemap can't be hashed or the treemaps don't have the same pair hash function.
+	TREE_MAPS_DIFFER, // The treemaps don't hold the same pairs.
+	VISIT_FUNC_NULLPTR, // The visit function is a nullptr.
+	COUNTERS_UNSUPPORTED, // The library is built without TREE_MAP_COUNTERS.
+	STATS_BUFFER_NULLPTR, // The buffer for the statistics is a nullptr.
+	LOG_EXISTS, // The treemap already has a log.
+	VALUE_DICTIONARY_NULLPTR // The treemap has no value dictionary that interns its values.
+};
+
+/*
+* Flags that change the behaviour of a treemap.
+* They can be combined and are set with setTreeMapFlags.
+*/
+enum TreeMapFlags : size_t {
+	MULTI_MAP = 1, // Equal keys are stored in insertion order instead of being rejected.
+	INLINE_PAIRS = 2 // Keys and values are InlineData whose bytes are stored inside the treenode.
+};
+
+/*
+* Flags that select how the chunks of a node arena are allocated.
+* They can be combined and are given to createNodeArena.
+*/
+enum NodeArenaFlags : size_t {
+	LARGE_PAGES = 1, // Chunks are backed by large pages if the system grants them, otherwise by normal pages.
+	CACHE_LINE_ALIGNED = 2 // Treenodes start on a cache line so that small ones never straddle two lines.
+};
+
+/*
+* Kinds of the records of a change stream. A record starts with its kind as a size_t followed by the key
+* and the value, or by the old and the new key of a rekey, padded to the record size of the stream.
+*/
+enum ChangeKind : size_t {
+	CHANGE_PUT = 1, // putPair inserted the pair.
+	CHANGE_DELETE = 2, // deletePair deleted the pair of the key.
+	CHANGE_REPLACE = 3, // replaceValue stored the value for the key.
+	CHANGE_POLL_FIRST = 4, // pollFirstPair deleted the minimum pair, the record holds no pair.
+	CHANGE_POLL_LAST = 5, // pollLastPair deleted the maximum pair, the record holds no pair.
+	CHANGE_REKEY = 6, // rekeyPair moved the pair of the old key to the new key.
+	CHANGE_CLEAR = 7 // clearTreeMap deleted every pair, the record holds no pair.
+};
+
+/*
+* Key or value of variable length for a treemap with the INLINE_PAIRS flag.
+* The treemap copies the bytes behind the links of the treenode, so a treenode
+* is a single allocation and its key and value point into it.
+* 
+* The comparison and equality functions receive InlineData that point into the treenode.
+* The copy functions are only used to copy keys and values out of the treemap and have to
+* deep copy the bytes. A free pair function isn't needed.
+* 
+* @var bytes - The bytes of the key or value.
+* @var byteAmount - Amount of bytes.
+*/
+struct InlineData {
+	const void* bytes;
+	size_t byteAmount;
 };
 
 /*
@@ -66,15 +156,20 @@ using KeyComparison = long (*)(const void* k1, const void* k2);
 */
 using ValueEquality = bool (*)(const void* v1, const void* v2);
 
+struct TreeMap;
+
 /*
 * Typedef for a copy function that copies a source key into the destination key buffer.
 * 
 * @param[out] dstTreeNodeKey - TreeNode key that will receive srcTreeNodeKey's data.
 * @param[in] srcTreeNodeKey - TreeNode key that gives it's data to dstTreeNodeKey.
+* @param[in, out] tm - Treemap that stores the copy, so nested data can be allocated with allocatePayload,
+*					   or a nullptr if the key is copied out of the treemap into a buffer of the caller.
+*					   Copy functions written before the payload arena existed lack this parameter and have to add it.
 * 
 * @return A status value that indicates if the copying was successful or not.
 */
-using KeyCopy = Status (*)(void* dstTreeNodeKey, const void* srcTreeNodeKey);
+using KeyCopy = Status (*)(void* dstTreeNodeKey, const void* srcTreeNodeKey, TreeMap* tm);
 
 /*
 * Typedef for a copy function that copies a source value into the given destination value.
@@ -84,10 +179,13 @@ using KeyCopy = Status (*)(void* dstTreeNodeKey, const void* srcTreeNodeKey);
 * @param[out] destTreeNodeValue - Value buffer that stores the contents of srcTreeNodeValue.
 * @param[in] srcTreeNodeValue - Value buffer that provides data for dstTreeNodeValue.
 * @param[in] replaceValue - Flag to indicate if the old data of dstTreeNodeValue should be completely replaced.
+* @param[in, out] tm - Treemap that stores the copy, so nested data can be allocated with allocatePayload,
+*					   or a nullptr if the value is copied out of the treemap into a buffer of the caller.
+*					   Like for KeyCopy the parameter was added with the payload arena.
 * 
 * @return A status value that indicates if the copying was successful or not.
 */
-using ValueCopy = Status (*)(void* dstTreeNodeValue, const void* srcTreeNodeValue, bool replaceValue);
+using ValueCopy = Status (*)(void* dstTreeNodeValue, const void* srcTreeNodeValue, bool replaceValue, TreeMap* tm);
 
 /*
 * Typedef for a function that is used to free all nested heap memory
@@ -99,6 +197,246 @@ using ValueCopy = Status (*)(void* dstTreeNodeValue, const void* srcTreeNodeValu
 */
 using FreePair = void (*)(void* treeNodePair);
 
+/*
+* Typedef for a function that frees the nested heap memory of a value
+* interned by the value dictionary of a treemap.
+* 
+* @param[out] treeNodeValue - Treenode value that gets its heap memory freed.
+*/
+using FreeValue = void (*)(void* treeNodeValue);
+
+/*
+* Typedef for a function that hashes a value for the hash index of a value dictionary.
+* Equal values have to get equal hashes, so nested data is hashed by its content.
+* The low bits of the hash select the bucket, so they should be well distributed.
+* 
+* @param[in] treeNodeValue - Treenode value that is hashed.
+* 
+* @return The hash of the value.
+*/
+using HashValue = size_t (*)(const void* treeNodeValue);
+
+/*
+* Typedef for a function that moves the nested data of a tree nodes pair into
+* the payload arena while it is compacted. The nested data has to be allocated again
+* with allocatePayload and the pair has to point at the new copy.
+* 
+* @param[in, out] treeNodePair - Treenode pair whose nested data is relocated.
+* @param[in, out] tm - Treemap whose payload arena is compacted.
+* 
+* @return A status value that indicates if the relocation was successful or not.
+*/
+using RelocatePair = Status (*)(void* treeNodePair, TreeMap* tm);
+
+/*
+* Typedef for a function that writes a tree nodes pair with its nested heap memory
+* as a record into a snapshot. The record must not depend on addresses of the process.
+* 
+* @param[out] record - Buffer of the maximum record size given to saveTreeMap.
+* @param[in] treeNodePair - Treenode pair that is serialized.
+* 
+* @return Size of the record in bytes or zero if the pair can't be serialized.
+*/
+using SerializePair = size_t (*)(void* record, const void* treeNodePair);
+
+/*
+* Typedef for a function that turns a record of a snapshot back into a tree nodes pair.
+* 
+* @param[out] treeNodePair - Treenode pair that is created from the record.
+* @param[in] record - Record that was written by the matching SerializePair function.
+* @param[in] recordSize - Size of the record in bytes.
+* 
+* @return A status value that indicates if the pair was created or not.
+*/
+using DeserializePair = Status (*)(void* treeNodePair, const void* record, size_t recordSize);
+
+/*
+* Typedef for a function that hashes a tree nodes pair for the subtree hashes. Equal pairs
+* have to get equal hashes, also in different treemaps, so nested data is hashed by its content.
+* 
+* @param[in] treeNodePair - Treenode pair that is hashed.
+* 
+* @return The hash of the pair.
+*/
+using HashPair = size_t (*)(const void* treeNodePair);
+
+/*
+* Typedef for a function that diffTreeMaps calls for every key whose pair differs between two treemaps.
+* 
+* @param[in] pairA - Pair of the first treemap or a nullptr if it misses the key.
+* @param[in] pairB - Pair of the second treemap or a nullptr if it misses the key.
+* 
+* @return A status value of success to continue, any other status stops the diff and is returned by it.
+*/
+using VisitDifference = Status (*)(const void* pairA, const void* pairB);
+
+/*
+* Append only arena of a treemap that copy functions can allocate the nested data
+* of keys and values from. Memory is bump allocated from blocks and is released all at once
+* when the treemap is cleared or deleted. Payload of deleted pairs stays inside the arena
+* until it is compacted.
+* 
+* @var blocks - Blocks of the arena with the newest block first.
+* @var blockSize - Minimum capacity of a block in bytes.
+* @var blockUsed - Bytes that are used inside the newest block.
+* @var usedBytes - Bytes that have been allocated from the arena in total.
+*/
+struct PayloadArena {
+	void* blocks;
+	size_t blockSize;
+	size_t blockUsed;
+	size_t usedBytes;
+};
+
+/*
+* Dictionary of a treemap that interns its values. Every distinct value is deep copied
+* once into a reference counted entry and the treenodes only hold the address of the entry
+* as the ID of their value. An entry is freed as soon as no pair refers to it anymore.
+* 
+* @var entries - Entries of the interned values with the newest entry first.
+* @var valueSize - Size of an interned value.
+* @var entryAmount - Count of the distinct values.
+* @var freeValueFunc - Function that frees heap memory of a value or a nullptr.
+* @var hashValueFunc - Function that hashes the values for the hash index or a nullptr.
+* @var buckets - Buckets of the hash index that chain the entries with the same low bits of their hash or a nullptr.
+* @var bucketAmount - Count of the buckets, a power of two that grows with the entries.
+* @var interned - Indicator if equal values share an entry. Values separated by
+*				  separateLargeValues get an entry each.
+*/
+struct ValueDictionary {
+	void* entries;
+	size_t valueSize;
+	size_t entryAmount;
+	FreeValue freeValueFunc;
+	HashValue hashValueFunc;
+	void* buckets;
+	size_t bucketAmount;
+	bool interned;
+};
+
+/*
+* Arena of a treemap that its treenodes are carved out of. Chunks are allocated
+* with the virtual memory functions of the system and hold many treenodes of the same stride,
+* so that the tree spans fewer pages. Treenodes of deleted pairs are kept on a free list
+* and reused before the chunks grow. All chunks are released when the treemap is cleared or deleted.
+* 
+* @var chunks - Chunks of the arena with the newest chunk first. The first cache line of a chunk is its header
+*				which holds the next chunk and the capacity of the chunk.
+* @var freeNodes - Released treenodes linked through their first quadword.
+* @var freeNodeAmount - Count of the released treenodes.
+* @var nodeStride - Distance between two treenodes inside a chunk in bytes.
+* @var chunkSize - Size of a chunk in bytes.
+* @var chunkUsed - Bytes that are used inside the newest chunk including its header.
+* @var flags - NodeArenaFlags the arena was created with.
+* @var largePageChunks - Count of the chunks that are backed by large pages.
+* @var compaction - State of a running compactTreeMap or a nullptr.
+*/
+struct NodeArena {
+	void* chunks;
+	void* freeNodes;
+	size_t freeNodeAmount;
+	size_t nodeStride;
+	size_t chunkSize;
+	size_t chunkUsed;
+	size_t flags;
+	size_t largePageChunks;
+	void* compaction;
+};
+
+/*
+* Memory budget of a treemap. Cold subtrees are written into the file and their links hold the offsets
+* of the records instead, until an operation that reaches them faults them back in.
+* 
+* @var file - File that receives the records of the spilled treenodes.
+* @var budget - Bytes the resident treenodes may take.
+* @var residentLimit - Amount of resident treenodes that fit into the budget.
+* @var residentTarget - Amount of resident treenodes that a spill goes down to.
+* @var recordSize - Size of the record of a treenode.
+* @var spilledAmount - Count of the spilled treenodes.
+* @var fileEnd - Offset the next record is written at.
+* @var faultAmount - Count of the treenodes that were faulted back in.
+*/
+struct Spill {
+	FILE* file;
+	size_t budget;
+	size_t residentLimit;
+	size_t residentTarget;
+	size_t recordSize;
+	size_t spilledAmount;
+	size_t fileEnd;
+	size_t faultAmount;
+};
+
+/*
+* Lock free ring of the change records of a treemap with a single producer, the thread that changes
+* the treemap, and a single consumer. Each side only writes its own counters, which are kept on
+* different cache lines. The counters only grow, a record lives in the slot of its counter modulo the capacity.
+* 
+* @var treeMap - Treemap whose changes are recorded.
+* @var records - Slots of the records.
+* @var recordSize - Size of a record in bytes.
+* @var capacity - Amount of slots.
+* @var head - Count of the appended records, written by the producer.
+* @var cachedTail - Tail the producer read last.
+* @var lostAmount - Count of the records that didn't fit, written by the producer.
+* @var tail - Count of the drained records, written by the consumer.
+*/
+struct ChangeStream {
+	struct TreeMap* treeMap;
+	void* records;
+	size_t recordSize;
+	size_t capacity;
+	size_t headPadding[4];
+	size_t head;
+	size_t cachedTail;
+	size_t lostAmount;
+	size_t tailPadding[5];
+	size_t tail;
+	size_t endPadding[7];
+};
+
+/*
+* Counters of the work a treemap does, which setTreeMapCounters attaches to it. They are only
+* counted if the library is built with TREE_MAP_COUNTERS and are never reset by the treemap.
+* 
+* @var comparisons - Calls of the key comparison function.
+* @var rotations - Left and right rotations of the tree.
+* @var flips - Color flips of a treenode and its children.
+* @var moveRedLefts - Calls of moveRedLeft by the deletions.
+* @var moveRedRights - Calls of moveRedRight by the deletions.
+* @var allocations - Treenodes that were taken from the heap or the node arena. Reused spare
+*					 treenodes aren't counted.
+* @var frees - Treenodes that were given back to the heap or the node arena. Treenodes that
+*			   are kept as spare treenodes aren't counted.
+*/
+struct TreeMapCounters {
+	size_t comparisons;
+	size_t rotations;
+	size_t flips;
+	size_t moveRedLefts;
+	size_t moveRedRights;
+	size_t allocations;
+	size_t frees;
+};
+
+/*
+* Shape and memory of a treemap as getTreeMapStats measures them.
+* 
+* @var height - Amount of treenodes on the longest path from the root to a leaf.
+* @var blackHeight - Amount of black treenodes on every path from the root to a leaf.
+* @var averageDepth - Average amount of treenodes on the path from the root to a treenode,
+*					  which is the amount of comparisons a successful search needs.
+* @var bytesUsed - Bytes of the treemap structure, its treenodes with their inline pairs and the spare
+*				   treenodes. With a node arena the arena and its chunks are counted instead of the treenodes.
+*				   The memory of payload arenas, value dictionaries and nested data of the pairs isn't counted.
+*/
+struct TreeMapStats {
+	size_t height;
+	size_t blackHeight;
+	double averageDepth;
+	size_t bytesUsed;
+};
+
 /*
 * Treemap structure that builds the core of this application.
 * 
@@ -113,6 +451,23 @@ using FreePair = void (*)(void* treeNodePair);
 * @var keyCopyFunc - Function that is used to copy tree node keys.
 * @var valueCopyFunc - Function that is used to copy tree node values.
 * @var freePairFunc - Function that frees heap memory of a tree nodes pair.
+* @var spareTreeNode - Treenode memory of the last deleted pair that is reused by the next insertion.
+*						Its first quadword links the spare treenode that was released before it.
+* @var flags - TreeMapFlags that change the behaviour of the treemap.
+* @var payloadArena - Arena for the nested data of the pairs or a nullptr if it isn't used.
+* @var valueDictionary - Dictionary of the interned values or a nullptr if it isn't used.
+* @var nodeArena - Arena the treenodes are taken from or a nullptr if they are allocated one by one.
+* @var spareAmount - Count of the spare treenodes.
+* @var spareLimit - Maximum amount of spare treenodes that are kept.
+* @var modificationCount - Count of the changes to the links of the tree. Lets compactTreeMap
+*						   detect that the tree changed between two calls.
+* @var checkpoint - State of a running checkpoint or a nullptr.
+* @var spill - Memory budget of the treenodes or a nullptr.
+* @var changeStream - Stream that records the changes or a nullptr.
+* @var hashPairFunc - Function that hashes the pairs or a nullptr. With it every treenode holds the hash
+*					  of its pair and the sum of the hashes of its subtree behind its links.
+* @var counters - Counters of the work of the treemap or a nullptr.
+* @var log - Write ahead log that records the mutations or a nullptr.
 */
 struct TreeMap {
 	void* root;
@@ -124,6 +479,183 @@ struct TreeMap {
 	KeyCopy keyCopyFunc;
 	ValueCopy valueCopyFunc;
 	FreePair freePairFunc;
+	void* spareTreeNode;
+	size_t flags;
+	PayloadArena* payloadArena;
+	ValueDictionary* valueDictionary;
+	NodeArena* nodeArena;
+	size_t spareAmount;
+	size_t spareLimit;
+	size_t modificationCount;
+	void* checkpoint;
+	Spill* spill;
+	ChangeStream* changeStream;
+	HashPair hashPairFunc;
+	TreeMapCounters* counters;
+	struct TreeMapLog* log;
+};
+
+/*
+* Read mostly view of a treemap image that is mapped into the address space.
+* The treenodes inside the image link their children through offsets from the base,
+* so the image can be mapped at any address and is searched without being loaded.
+* 
+* @var base - Start of the mapped image.
+* @var keySize - Size of a key.
+* @var valueSize - Size of a value.
+* @var nodeAmount - Count of the pairs.
+* @var nodeStride - Distance between two treenodes that follow each other in key order.
+* @var root - Offset of the root treenode or zero for an empty image.
+* @var compareKeyFunc - Function that compares the keys.
+* @var fileHandle - Handle of the image file.
+* @var mappingHandle - Handle of the file mapping.
+* @var writable - Indicator if values can be replaced.
+*/
+struct MappedTreeMap {
+	void* base;
+	size_t keySize;
+	size_t valueSize;
+	size_t nodeAmount;
+	size_t nodeStride;
+	size_t root;
+	KeyComparison compareKeyFunc;
+	void* fileHandle;
+	void* mappingHandle;
+	bool writable;
+};
+
+/*
+* View of a treemap inside named shared memory that several processes map. The memory holds
+* two areas with the treenodes of a version each, linked through offsets like a mapped image.
+* The writer fills the inactive area and activates it through a sequence number, readers search
+* the active area and repeat a search if the writer began to overwrite it meanwhile.
+* 
+* @var base - Start of the mapped shared memory.
+* @var keySize - Size of a key.
+* @var valueSize - Size of a value.
+* @var nodeStride - Distance between two treenodes of an area.
+* @var nodeCapacity - Maximum amount of pairs of a version.
+* @var areaSize - Size of an area in bytes.
+* @var compareKeyFunc - Function that compares the keys.
+* @var mappingHandle - Handle of the shared memory.
+* @var writable - Indicator if this process created the shared treemap and publishes its versions.
+*/
+struct SharedTreeMap {
+	void* base;
+	size_t keySize;
+	size_t valueSize;
+	size_t nodeStride;
+	size_t nodeCapacity;
+	size_t areaSize;
+	KeyComparison compareKeyFunc;
+	void* mappingHandle;
+	bool writable;
+};
+
+/*
+* Write ahead log that records the mutations of a treemap. The records are collected in a buffer
+* and committed in batches, so the file is flushed to the storage once per batch instead of once per mutation.
+* 
+* @var treeMap - Treemap whose mutations are logged.
+* @var file - File the batches are appended to.
+* @var buffer - Frame and records of the pending batch.
+* @var used - Bytes of the buffer that are used.
+* @var pendingAmount - Count of the records that aren't committed yet.
+* @var batchSize - Amount of records that are committed together.
+* @var commitAmount - Count of the committed batches.
+*/
+struct TreeMapLog {
+	TreeMap* treeMap;
+	FILE* file;
+	void* buffer;
+	size_t used;
+	size_t pendingAmount;
+	size_t batchSize;
+	size_t commitAmount;
+};
+
+/*
+* Log structured merge tree that uses a treemap as its memtable. The flushed pairs are kept in sorted run files
+* that are mapped into the address space, ordered from the oldest to the newest run.
+* 
+* @var memtable - Treemap that takes the writes.
+* @var tombstones - Treemap of the keys that were deleted since the last flush.
+* @var memtableLimit - Amount of pairs and tombstones that trigger a flush.
+* @var pathPrefix - Path prefix of the run files.
+* @var nextRunId - Counter that names the next run file.
+* @var keySize - Size of the keys.
+* @var valueSize - Size of the values.
+* @var recordStride - Distance between two records of a run.
+* @var keyStride - Distance between two keys of the block index of a run.
+* @var runAmount - Count of the runs.
+* @var runs - Runs from the oldest to the newest one.
+*/
+struct LsmTree {
+	TreeMap* memtable;
+	TreeMap* tombstones;
+	size_t memtableLimit;
+	char* pathPrefix;
+	size_t nextRunId;
+	size_t keySize;
+	size_t valueSize;
+	size_t recordStride;
+	size_t keyStride;
+	size_t runAmount;
+	void* runs[16];
+};
+
+/*
+* Treemap whose treenodes are packed into the pages of a file and read through a buffer pool.
+* A page holds the top levels of a subtree or several small subtrees, the links of its treenodes hold
+* the page and slot of the children plus one. The pool replaces pages with the clock algorithm and never evicts a pinned page.
+* The counters tell how many pages were read, written or found inside the pool.
+* 
+* @var file - File that holds the pages.
+* @var keySize - Size of a key.
+* @var valueSize - Size of a value.
+* @var nodeAmount - Count of the pairs.
+* @var nodeStride - Distance between two treenodes of a page.
+* @var pageSize - Size of a page.
+* @var slotAmount - Amount of treenodes a page holds.
+* @var pageAmount - Count of the pages behind the header page.
+* @var root - Link of the root treenode or zero for an empty treemap.
+* @var compareKeyFunc - Function that compares the keys.
+* @var frames - Frames of the buffer pool.
+* @var frameMemory - Pages of the frames.
+* @var frameAmount - Amount of pages the buffer pool holds.
+* @var clockHand - Frame the clock looks at next.
+* @var pageTable - Frame plus one of every resident page.
+* @var readAhead - Amount of pages that a scan reads with the missed page.
+* @var readBuffer - Buffer the pages of a request are read into.
+* @var lastMiss - Last page that was read.
+* @var readAmount - Count of the pages that were read.
+* @var readRequestAmount - Count of the read requests.
+* @var writeAmount - Count of the pages that were written back.
+* @var hitAmount - Count of the page accesses that the buffer pool served.
+*/
+struct PagedTreeMap {
+	FILE* file;
+	size_t keySize;
+	size_t valueSize;
+	size_t nodeAmount;
+	size_t nodeStride;
+	size_t pageSize;
+	size_t slotAmount;
+	size_t pageAmount;
+	size_t root;
+	KeyComparison compareKeyFunc;
+	void* frames;
+	void* frameMemory;
+	size_t frameAmount;
+	size_t clockHand;
+	size_t* pageTable;
+	size_t readAhead;
+	void* readBuffer;
+	size_t lastMiss;
+	size_t readAmount;
+	size_t readRequestAmount;
+	size_t writeAmount;
+	size_t hitAmount;
 };
 
 extern "C" {
@@ -152,6 +684,49 @@ extern "C" {
 	TreeMap* createTreeMap(size_t keySize, size_t valueSize, KeyComparison kComp,
 		ValueEquality vEqual, KeyCopy kCopy, ValueCopy vCopy, FreePair fPair, Status* s);
 
+	/*
+	* Sets the flags that change the behaviour of the treemap.
+	* The flags can only be set while the treemap is empty.
+	* 
+	* @runtime O(1).
+	* 
+	* @param[in, out] tm - Treemap that gets its flags set.
+	* @param[in] flags - Combination of TreeMapFlags.
+	* 
+	* @return A status value of success, tree map not empty, inline size mismatch if INLINE_PAIRS is set
+	*		  for a treemap whose key or value size isn't sizeof(InlineData), hash unsupported for a treemap with
+	*		  subtree hashes or an error if the treemap is a nullptr.
+	*/
+	Status setTreeMapFlags(TreeMap* tm, size_t flags);
+
+	/*
+	* Sets how many treenodes of deleted pairs the treemap keeps for reuse. The spare treenodes
+	* form a LIFO list, so an insertion reuses the treenode that was released last while it's still cached.
+	* A new treemap keeps a single spare treenode, spare treenodes above the new limit are freed.
+	* Treemaps with a node arena keep their released treenodes inside the arena instead.
+	* 
+	* @runtime O(S) where S is the count of freed spare treenodes.
+	* 
+	* @param[in, out] tm - Treemap whose limit is set.
+	* @param[in] limit - Maximum amount of spare treenodes.
+	* 
+	* @return A status value of success or an error if the treemap is a nullptr.
+	*/
+	Status setSpareTreeNodeLimit(TreeMap* tm, size_t limit);
+
+	/*
+	* Frees spare treenodes of the treemap until at most the given amount is left.
+	* The limit of spare treenodes stays unchanged.
+	* 
+	* @runtime O(S) where S is the count of freed spare treenodes.
+	* 
+	* @param[in, out] tm - Treemap whose spare treenodes are freed.
+	* @param[in] keep - Amount of spare treenodes that are kept.
+	* 
+	* @return A status value of success or an error if the treemap is a nullptr.
+	*/
+	Status trimSpareTreeNodes(TreeMap* tm, size_t keep);
+
 	/*
 	* Clears the complete tree of the treemap, freeing all its treenode memory.
 	* 
@@ -165,7 +740,7 @@ extern "C" {
 
 	/*
 	* Deletes the specified treemap freeing all nodes allocated inside of it
-	* and freeing the treemap structure too.
+	* and freeing the treemap structure too. An attached log is closed first.
 	* 
 	* @runtime O(N).
 	* 
@@ -177,6 +752,7 @@ extern "C" {
 
 	/*
 	* Inserts a treenode into a treemap if the specified key does not already exist.
+	* A multimap always inserts the pair after the pairs with an equal key.
 	* 
 	* @runtime O(Log(N)).
 	* 
@@ -190,11 +766,14 @@ extern "C" {
 	
 	/*
 	* Deletes a key value pair from the treemap by the given key.
+	* A multimap deletes the oldest pair with the key.
 	* The deleted pair can be copied into a buffer if it is provided.
 	* If a nullptr is given the pair will be deleted without a copy return.
 	* 
 	* The returned pairBuffer is a shallow copy meaning any nested heap
-	* memory still has to be freed manually.
+	* memory still has to be freed manually. Inline pairs are deep copied
+	* by the copy functions instead. An interned value is moved out of the
+	* value dictionary or deep copied if other pairs still share it.
 	* 
 	* @runtime O(Log(N)).
 	* 
@@ -209,9 +788,12 @@ extern "C" {
 	/*
 	* Deletes the minimum from the specified treemap and returns it inside the buffer.
 	* If the buffer is a nullptr no copy will be returned.
+	* A multimap deletes the oldest pair of the minimum key.
 	* 
 	* The returned pairBuffer is a shallow copy meaning any nested heap
-	* memory still has to be freed manually.
+	* memory still has to be freed manually. Inline pairs are deep copied
+	* by the copy functions instead. An interned value is moved out of the
+	* value dictionary or deep copied if other pairs still share it.
 	* 
 	* @runtime O(Log(N)).
 	* 
@@ -226,9 +808,12 @@ extern "C" {
 	/*
 	* Deletes the maximum key value pair from the given treemap.
 	* If a buffer is specified the deleted pair will be copied into it.
+	* A multimap deletes the newest pair of the maximum key.
 	* 
 	* The returned pairBuffer is a shallow copy meaning any nested heap
-	* memory still has to be freed manually.
+	* memory still has to be freed manually. Inline pairs are deep copied
+	* by the copy functions instead. An interned value is moved out of the
+	* value dictionary or deep copied if other pairs still share it.
 	* 
 	* @runtime O(Log(N)).
 	* 
@@ -241,6 +826,30 @@ extern "C" {
 	*/
 	Status pollLastPair(TreeMap* tm, const void* pairBuffer);
 
+	/*
+	* Changes the key of a key value pair without allocating a new treenode.
+	* If the new key keeps the order to the neighbouring pairs the key is replaced in place.
+	* Otherwise the pair is unlinked and relinked at the new position reusing its treenode.
+	* A multimap always relinks the oldest pair with the old key behind the pairs with the new key.
+	* 
+	* The new key is deep copied. The old key is returned as a shallow copy
+	* inside the keyBuffer meaning any nested heap memory still has to be freed manually.
+	* Inline pairs are always relinked inside a new treenode and the old key is
+	* deep copied into the keyBuffer by the key copy function.
+	* 
+	* @runtime O(Log(N)).
+	* 
+	* @param[in, out] tm - Treemap that holds the pair.
+	* @param[in] oldKey - Key that identifies the pair.
+	* @param[in] newKey - Key that replaces the old key.
+	* @param[out] keyBuffer - Buffer that stores the old key.
+	* 
+	* @return A status value for success, does not contain if the old key is missing, already contains
+	*		  if the new key belongs to another pair, an error if the key copy function fails or the
+	*		  treemap/keyBuffer is a nullptr.
+	*/
+	Status rekeyPair(TreeMap* tm, const void* oldKey, const void* newKey, void* keyBuffer);
+
 	// ----------------------------------------------------------- Everything below is part of the utility implementation. -----------------------------------------------------------
 
 	/*
@@ -249,14 +858,14 @@ extern "C" {
 	* 
 	* @runtime O(Log(N)).
 	* 
-	* @param[in] tm - The treemap that is searched for the specified key value pair. 
+	* @param[in, out] tm - The treemap that is searched for the specified key value pair. 
 	* @param[in] key - Key that identifies the key value pair.
 	* @param[out] valueBuffer - Buffer that stores the value of the key value pair.
 	* 
 	* @return A status value of success, does not contains or an error if the
 	*		  copy functions fail or the treemap/valueBuffer is a nullptr.
 	*/
-	Status getValue(const TreeMap* tm, const void* key, void* valueBuffer);
+	Status getValue(TreeMap* tm, const void* key, void* valueBuffer);
 
 	/*
 	* Retrieves the given key for the specified value if such a key value pair exists.
@@ -264,46 +873,47 @@ extern "C" {
 	* 
 	* @runtime O(N).
 	* 
-	* @param[in] tm - Treemap thats searched for a key that holds the given value.
+	* @param[in, out] tm - Treemap thats searched for a key that holds the given value.
 	* @param[in] value - Value that is used to find the given key.
 	* @param[out] keyBuffer - Buffer that stores the found key.
 	* 
 	* @return A status value for success, does not contain or an error if the
 	*		  the copy functions fail or the treemap/keybuffer is a nullptr.
 	*/
-	Status getKey(const TreeMap* tm, const void* value, void* keyBuffer);
+	Status getKey(TreeMap* tm, const void* value, void* keyBuffer);
 	
 	/*
 	* Tests if the given value is inside of the treemap.
 	* 
 	* @runtime O(N).
 	* 
-	* @param[in] tm - Treemap that is searched for the given value.
+	* @param[in, out] tm - Treemap that is searched for the given value.
 	* @param[in] value - Value that is searched inside the treemap.
 	* 
 	* @return A status value for success, meaning the value is inside of
 	*		  the treemap, does not contain meaning the value is not in the treemap
 	*		  or an error for the treemap being a nullptr.
 	*/
-	Status containsValue(const TreeMap* tm, const void* value);
+	Status containsValue(TreeMap* tm, const void* value);
 
 	/*
 	* Test if the given key is inside the treemap.
 	* 
 	* @runtime O(Log(N)).
 	* 
-	* @param[in] tm - Treemap that is searched for the given key.
+	* @param[in, out] tm - Treemap that is searched for the given key.
 	* @param[in] key - The key that is searched inside the treemap.
 	* 
 	* @return A status flag of success meaning the key is inside the map,
 	*		  does not contain meaning it is not or an error for the treemap
 	*		  being a nullptr.
 	*/
-	Status containsKey(const TreeMap* tm, const void* key);
+	Status containsKey(TreeMap* tm, const void* key);
 
 	/*
 	* Replaces a value identified by the given key with the specifed replacement value
 	* if it exists. The replaced value is automatically freed if nested heap was acquired.
+	* An inline value that is longer than the old one moves the pair into a new treenode.
 	* 
 	* @runtime O(Log(N)).
 	* 
@@ -312,7 +922,7 @@ extern "C" {
 	* @param[in] replacementValue - Value that replaces the old one.
 	* 
 	* @return A status value of success, does not contain or an error if the
-	*		  treemap is a nullptr.
+	*		  treemap is a nullptr or the replacement fails.
 	*/
 	Status replaceValue(TreeMap* tm, const void* key, const void* replacementValue);
 
@@ -324,14 +934,14 @@ extern "C" {
 	* 
 	* @runtime O(Log(N)).
 	* 
-	* @param[in] tm - Treemap thats searched for the ceiling pair.
+	* @param[in, out] tm - Treemap thats searched for the ceiling pair.
 	* @param[in] key - Key that is used to find the next ceiling pair.
 	* @param[out] pairBuffer - Buffer that is used to store the ceiling pair.
 	* 
 	* @return A status value of success, does not contain or an error if the copy functions
 	*		  fail or the treemap/pairBuffer is a nullptr.
 	*/
-	Status ceilingPair(const TreeMap* tm, const void* key, void* pairBuffer);
+	Status ceilingPair(TreeMap* tm, const void* key, void* pairBuffer);
 	
 	/*
 	* Fetches the next lower or equal key value pair in relation to the given key
@@ -340,14 +950,14 @@ extern "C" {
 	* 
 	* @runtime O(Log(N)).
 	* 
-	* @param[in] tm - Treemap that is searched for a floor pair.
+	* @param[in, out] tm - Treemap that is searched for a floor pair.
 	* @param[in] key - Key that is used to find the floor pair for the key.
 	* @param[out] pairBuffer - Buffer that stores the floor pair.
 	* 
 	* @return A status value of success, does not contain or an error the copy functions fail
 	*		  or the treemap/pairBuffer is a nullptr.
 	*/
-	Status floorPair(const TreeMap* tm, const void* key, void* pairBuffer);
+	Status floorPair(TreeMap* tm, const void* key, void* pairBuffer);
 
 	/*
 	* Fetches the next lower key value pair in relation to the given key.
@@ -355,14 +965,14 @@ extern "C" {
 	* 
 	* @runtime O(Log(N)).
 	* 
-	* @param[in] tm - Treemap that is searched for a lower pair.
+	* @param[in, out] tm - Treemap that is searched for a lower pair.
 	* @param[in] key - Key that is used to find the lower pair.
 	* @param[out] pairBuffer - Buffer that holds the lower pair.
 	* 
 	* @return A status value of success, does not contain or an error
 	*		  if the copy functions fail or the treemap/pairBuffer is a nullptr.
 	*/
-	Status lowerPair(const TreeMap* tm, const void* key, void* pairBuffer);
+	Status lowerPair(TreeMap* tm, const void* key, void* pairBuffer);
 	
 	/*
 	* Fetches the next higher key value pair in relation to the given key.
@@ -370,42 +980,1266 @@ extern "C" {
 	* 
 	* @runtime O(Log(N)).
 	* 
-	* @param[in] tm - Treemap that is searched for a higher pair.
+	* @param[in, out] tm - Treemap that is searched for a higher pair.
 	* @param[in] key - Key that is used to find the higher pair.
 	* @param[out] pairBuffer - Buffer that holds the higher pair.
 	* 
 	* @return A status value of success, does not contain or an error
 	*		  if the copy functions fail or the treemap/pairBuffer is a nullptr.
 	*/
-	Status higherPair(const TreeMap* tm, const void* key, void* pairBuffer);
+	Status higherPair(TreeMap* tm, const void* key, void* pairBuffer);
 
 	/*
 	* Retrieves the most left key value pair inside the treemap.
 	* 
 	* @runtime O(Log(N)).
 	* 
-	* @param[in] tm - Treemap that is used to retrieve the minimum key value pair.
+	* @param[in, out] tm - Treemap that is used to retrieve the minimum key value pair.
 	* @param[out] pairBuffer - Buffer that is used to store a copy of the minimum
 	*						   key value pair.
 	* 
 	* @return A status value of success, does not contain or an error if the copy
 	*		  functions fail or the treemap/pairBuffer is a nullptr.
 	*/
-	Status minPair(const TreeMap* map, void* pairBuffer);
+	Status minPair(TreeMap* tm, void* pairBuffer);
 	
 	/*
 	* Retrieves the most right key value pair inside the treemap.
 	*
 	* @runtime O(Log(N)).
 	* 
-	* @param[in] tm - Treemap that is used to retrieve the minimum key value pair.
+	* @param[in, out] tm - Treemap that is used to retrieve the minimum key value pair.
 	* @param[out] pairBuffer - Buffer that is used to store a copy of the minimum
 	*						   key value pair.
 	*
 	* @return A status value of success, does not contain or an error if the copy
 	*		  functions fail or the treemap/pairBuffer is a nullptr.
 	*/
-	Status maxPair(const TreeMap* map, void* pairBuffer);
+	Status maxPair(TreeMap* tm, void* pairBuffer);
+
+	// ----------------------------------------------------------- Everything below is part of the multimap implementation. -----------------------------------------------------------
+
+	/*
+	* Copies all key value pairs with the specified key in insertion order into the buffer.
+	* If the buffer is too small only the oldest pairs that fit into it are copied.
+	* 
+	* @runtime O(Log(N) + M) where M is the amount of pairs with the key.
+	* 
+	* @param[in, out] tm - Treemap that is searched for the key.
+	* @param[in] key - Key of the pairs.
+	* @param[out] pairBuffer - Buffer of consecutive pairs that receives the copies.
+	* @param[in] bufferLength - Amount of pairs the buffer can hold.
+	* @param[out] pairAmount - Receives the amount of pairs with the key.
+	* 
+	* @return A status value of success, does not contain or an error if the copy
+	*		  functions fail or the treemap/pairBuffer/pairAmount is a nullptr.
+	*/
+	Status equalRange(TreeMap* tm, const void* key, void* pairBuffer, size_t bufferLength, size_t* pairAmount);
+
+	/*
+	* Counts the key value pairs with the specified key.
+	* 
+	* @runtime O(Log(N) + M) where M is the amount of pairs with the key.
+	* 
+	* @param[in, out] tm - Treemap that is searched for the key.
+	* @param[in] key - Key of the pairs.
+	* @param[out] pairAmount - Receives the amount of pairs with the key.
+	* 
+	* @return A status value of success, does not contain or an error if
+	*		  the treemap/pairAmount is a nullptr.
+	*/
+	Status countKey(TreeMap* tm, const void* key, size_t* pairAmount);
+
+	/*
+	* Deletes all key value pairs with the specified key.
+	* 
+	* @runtime O(M * Log(N)) where M is the amount of pairs with the key.
+	* 
+	* @param[in, out] tm - Treemap that gets the pairs deleted.
+	* @param[in] key - Key of the pairs.
+	* 
+	* @return A status value of success, does not contain or an error if the treemap is a nullptr.
+	*/
+	Status deleteAllForKey(TreeMap* tm, const void* key);
+
+	// ----------------------------------------------------------- Everything below is part of the payload arena implementation. -----------------------------------------------------------
+
+	/*
+	* Attaches an empty payload arena to the treemap.
+	* 
+	* @runtime O(1).
+	* 
+	* @param[in, out] tm - Treemap that gets the payload arena.
+	* @param[in] blockSize - Minimum capacity of a block of the arena in bytes.
+	* 
+	* @return A status value of success, payload arena exists or an error if the allocation
+	*		  fails, the block size is zero or the treemap is a nullptr.
+	*/
+	Status createPayloadArena(TreeMap* tm, size_t blockSize);
+
+	/*
+	* Allocates memory from the payload arena of the treemap. The memory is aligned
+	* on a quadword boundary and must not be freed separately. It stays valid until the treemap
+	* is cleared, deleted or its arena is compacted.
+	* 
+	* @runtime O(1).
+	* 
+	* @param[in, out] tm - Treemap whose payload arena is used.
+	* @param[in] size - Size of the memory in bytes.
+	* 
+	* @return Pointer to the memory or a nullptr if the treemap has no payload arena or
+	*		  a new block can't be allocated.
+	*/
+	void* allocatePayload(TreeMap* tm, size_t size);
+
+	/*
+	* Moves the nested data of all pairs into a single new block and frees the old blocks.
+	* This reclaims the memory of deleted pairs.
+	* 
+	* @runtime O(N).
+	* 
+	* @param[in, out] tm - Treemap whose payload arena is compacted.
+	* @param[in] relocate - Function that moves the nested data of a pair.
+	* 
+	* @return A status value of success, the status of a failing relocation, checkpoint running or an error if
+	*		  the allocation fails or the treemap/payloadArena/relocate is a nullptr. After a failing relocation
+	*		  the old blocks stay part of the arena.
+	*/
+	Status compactPayloadArena(TreeMap* tm, RelocatePair relocate);
+
+	// ----------------------------------------------------------- Everything below is part of the value dictionary implementation. -----------------------------------------------------------
+
+	/*
+	* Attaches an empty value dictionary to the treemap. Afterwards equal values are stored once
+	* and every treenode only holds the ID of its value, so the valueSize of the treemap becomes
+	* the size of an ID and the dictionary keeps the size of the values. Buffers for values and pairs
+	* still need the size of the values.
+	* 
+	* getValue, replaceValue, containsValue, getKey and the functions that copy pairs resolve the IDs
+	* through the dictionary. containsValue and getKey reject a value that isn't interned without
+	* visiting the treenodes, otherwise they compare IDs instead of calling the value equality function.
+	* The free pair function only receives the key of a pair and its value ID,
+	* values are freed by the free value function once no pair refers to them.
+	* 
+	* @runtime O(1). Interning a value takes O(D) where D is the count of distinct values,
+	*		   with a hash index set by setValueDictionaryHash only the values with the same hash are compared.
+	* 
+	* @param[in, out] tm - Empty treemap that gets the value dictionary.
+	* @param[in] freeValueFunc - Function that frees nested heap memory of a value or a nullptr.
+	* 
+	* @return A status value of success, value dictionary exists, tree map not empty, inline size mismatch
+	*		  for treemaps with inline pairs, hash unsupported for treemaps with subtree hashes or an error if the
+	*		  allocation fails or the treemap is a nullptr.
+	*/
+	Status createValueDictionary(TreeMap* tm, FreeValue freeValueFunc);
+
+	/*
+	* Moves the values out of the treenodes if the value size is bigger than the threshold.
+	* The treenodes then only hold the key, the address of the value and the links, so that
+	* searching and inserting touch less memory. A value is only read when a function returns it.
+	* 
+	* The values are stored inside a value dictionary that doesn't intern them, so the same rules
+	* as for createValueDictionary apply. containsValue and getKey still compare the values.
+	* 
+	* @runtime O(1).
+	* 
+	* @param[in, out] tm - Empty treemap whose values are separated.
+	* @param[in] threshold - Value size in bytes up to which the values stay inside the treenodes.
+	* @param[in] freeValueFunc - Function that frees nested heap memory of a value or a nullptr.
+	* 
+	* @return A status value of success if the values are separated or small enough to stay inside
+	*		  the treenodes or the errors of createValueDictionary.
+	*/
+	Status separateLargeValues(TreeMap* tm, size_t threshold, FreeValue freeValueFunc);
+
+	/*
+	* Sets the function that hashes the values of the value dictionary. The entries are then kept inside
+	* the buckets of a hash index, so interning a value, containsValue and getKey only compare the values
+	* with the same hash instead of every interned value. The index keeps about one entry per bucket.
+	* The function can be changed at any time, the interned values are hashed again.
+	* 
+	* @runtime O(D) where D is the count of distinct values.
+	* 
+	* @param[in, out] tm - Treemap whose value dictionary gets the hash index.
+	* @param[in] hashValueFunc - Function that hashes a value or a nullptr to remove the hash index.
+	* 
+	* @return A status value of success, value dictionary nullptr if the treemap doesn't intern its values
+	*		  or an error if the allocation fails or the treemap is a nullptr. The dictionary has no hash index
+	*		  after a failed allocation.
+	*/
+	Status setValueDictionaryHash(TreeMap* tm, HashValue hashValueFunc);
+
+	// ----------------------------------------------------------- Everything below is part of the node arena implementation. -----------------------------------------------------------
+
+	/*
+	* Attaches an empty node arena to the treemap. Afterwards the treenodes are carved out of
+	* chunks instead of being allocated one by one, which keeps them close together in memory
+	* and reduces TLB misses while searching. With LARGE_PAGES the chunk size is rounded up to the
+	* large page size, locking large pages needs the SeLockMemoryPrivilege and chunks fall back to
+	* normal pages without it. On linux the chunks are aligned to the large page size and advised
+	* for transparent huge pages, reserved hugetlbfs pages are only taken if the environment variable
+	* TREE_MAP_HUGETLB is 1. With CACHE_LINE_ALIGNED the stride of the treenodes is rounded up
+	* to a multiple of 64 bytes.
+	* 
+	* @runtime O(1).
+	* 
+	* @param[in, out] tm - Empty treemap that gets the node arena.
+	* @param[in] chunkSize - Size of a chunk in bytes.
+	* @param[in] flags - NodeArenaFlags that select large pages and cache line aligned treenodes.
+	* 
+	* @return A status value of success, node arena exists, tree map not empty, inline size mismatch
+	*		  for treemaps with inline pairs, chunk size too small if a chunk can't hold a treenode
+	*		  or an error if the allocation fails or the treemap is a nullptr.
+	*/
+	Status createNodeArena(TreeMap* tm, size_t chunkSize, size_t flags);
+
+	/*
+	* Reserves treenodes for the given amount of insertions, so that they neither allocate nor
+	* wait for the system allocator. Released treenodes and the rest of the newest chunk count towards
+	* the reservation, the missing treenodes are allocated in a single chunk. Deleted pairs give their
+	* treenodes back to the node arena, so churn keeps reusing the reserved memory.
+	* 
+	* An empty treemap without a node arena gets one with a chunk size of 64 KiB and no flags.
+	* 
+	* @runtime O(1) if the missing treenodes fit into the newest chunk, otherwise O(C)
+	*		   where C is the count of treenodes that are left in the newest chunk.
+	* 
+	* @param[in, out] tm - Treemap whose treenodes are reserved.
+	* @param[in] amount - Amount of treenodes that are reserved.
+	* 
+	* @return A status value of success, tree map not empty if the treemap holds treenodes without a node arena,
+	*		  inline size mismatch for treemaps with inline pairs or an error if the allocation fails or the
+	*		  treemap is a nullptr.
+	*/
+	Status reserveTreeMap(TreeMap* tm, size_t amount);
+
+	/*
+	* Relocates the treenodes in order into new chunks of the node arena and releases the old chunks,
+	* so that range scans with higherPair walk through memory linearly after a long time of churn.
+	* The compaction is incremental: every call visits at most the given amount of treenodes and returns
+	* compaction pending until all treenodes were relocated. The treemap can be used and modified
+	* between the calls, the next call then continues after the key of the last visited treenode.
+	* Treenodes of pairs deleted during the compaction aren't reused until the old chunks are released.
+	* 
+	* @runtime O(B + log N) per call where B is the budget, O(N) for the whole compaction.
+	* 
+	* @param[in, out] tm - Treemap whose treenodes are compacted.
+	* @param[in] budget - Maximum amount of treenodes visited by this call. Zero finishes the compaction.
+	* 
+	* @return A status value of success if the compaction is finished, compaction pending if another
+	*		  call is needed or an error if the allocation fails or the treemap/nodeArena is a nullptr.
+	*		  After an allocation failure the compaction can be continued.
+	*/
+	Status compactTreeMap(TreeMap* tm, size_t budget);
+
+	// ----------------------------------------------------------- Everything below is part of the snapshot implementation. -----------------------------------------------------------
+
+	/*
+	* Saves the pairs of the treemap in key order as a snapshot into the file. The snapshot starts
+	* with a versioned header that holds the key and value size and the amount of pairs, every pair is
+	* a record of its size and bytes and the records are followed by their checksum. The file is written
+	* in blocks of 64 KiB at the current position and isn't flushed or closed.
+	* 
+	* Without a serialize function the bytes of the pairs are written as they are, which only works for
+	* pairs without pointers. Otherwise the function writes every pair as a record of at most maxRecordSize bytes.
+	* Treemaps with inline pairs or a value dictionary can't be saved.
+	* 
+	* @runtime O(N).
+	* 
+	* @param[in, out] tm - Treemap that is saved.
+	* @param[in, out] file - File that was opened in binary mode for writing.
+	* @param[in] serialize - Function that writes a pair as a record or a nullptr for the raw pairs.
+	* @param[in] maxRecordSize - Maximum size of a record in bytes, ignored without a serialize function.
+	* 
+	* @return A status value of success, file nullptr, inline size mismatch, value dictionary exists,
+	*		  error serialize pair if a record is empty or too big, error file io if the file can't
+	*		  be written or an error if the allocation fails or the treemap is a nullptr.
+	*/
+	Status saveTreeMap(TreeMap* tm, FILE* file, SerializePair serialize, size_t maxRecordSize);
+
+	/*
+	* Loads a snapshot written by saveTreeMap into the empty treemap. The records are read sequentially
+	* in blocks of 64 KiB and the tree is built bottom up, so every treenode is linked once at its final place
+	* and no rotation or comparison happens. The built tree is a valid left leaning red black tree with
+	* minimal height. The treemap keeps its functions, flags and arenas, only the key and value size have to match.
+	* 
+	* Without a deserialize function the records are copied into the treenodes as they are. Otherwise the
+	* function turns every record into a pair and may allocate nested data from the payload arena.
+	* If loading fails the treemap is cleared again.
+	* 
+	* @runtime O(N).
+	* 
+	* @param[in, out] tm - Empty treemap that receives the pairs.
+	* @param[in, out] file - File that was opened in binary mode for reading and is positioned at the snapshot.
+	* @param[in] deserialize - Function that turns a record into a pair or a nullptr for the raw pairs.
+	* 
+	* @return A status value of success, file nullptr, tree map not empty, inline size mismatch,
+	*		  value dictionary exists, snapshot invalid if the file is truncated, corrupted or has
+	*		  other pair sizes, the status of the deserialize function or an error if the allocation
+	*		  fails or the treemap is a nullptr.
+	*/
+	Status loadTreeMap(TreeMap* tm, FILE* file, DeserializePair deserialize);
+
+	// ----------------------------------------------------------- Everything below is part of the mapped treemap implementation. -----------------------------------------------------------
+
+	/*
+	* Writes the treemap as an image that openMappedTreeMap can map into the address space.
+	* The treenodes are laid out in key order and link their children through offsets from the
+	* start of the image, so it doesn't depend on the address it's mapped at. The pairs are copied
+	* byte by byte and must not hold pointers. The image is built in memory and written at once.
+	* 
+	* @runtime O(N).
+	* 
+	* @param[in, out] tm - Treemap that is saved.
+	* @param[in, out] file - File that was opened in binary mode for writing.
+	* 
+	* @return A status value of success, file nullptr, inline size mismatch, value dictionary exists,
+	*		  error file io if the file can't be written or an error if the allocation fails
+	*		  or the treemap is a nullptr.
+	*/
+	Status saveMappedTreeMap(TreeMap* tm, FILE* file);
+
+	/*
+	* Maps an image written by saveMappedTreeMap into the address space. Only the header is read,
+	* so opening takes the same time for every image and pages are loaded when a search touches them.
+	* The links of the treenodes aren't checked, so the image has to come from a trusted source.
+	* 
+	* @runtime O(1).
+	* 
+	* @param[in] path - Path of the image file.
+	* @param[in] compareKeyFunc - Function that compares the keys like the one of the saved treemap.
+	* @param[in] writable - Indicator if the values can be replaced with replaceMappedValue.
+	* @param[out] status - Status value of success, file nullptr, key comp func nullptr, error file io if
+	*					   the file can't be opened or mapped, snapshot invalid if the file isn't an image
+	*					   or an error if the allocation fails.
+	* 
+	* @return The mapped treemap or a nullptr if it can't be opened.
+	*/
+	MappedTreeMap* openMappedTreeMap(const char* path, KeyComparison compareKeyFunc, bool writable, Status* status);
+
+	/*
+	* Unmaps the image and frees the mapped treemap. Pairs returned by the search functions
+	* become invalid.
+	* 
+	* @runtime O(1).
+	* 
+	* @param[in, out] mtm - Mapped treemap that is closed.
+	* 
+	* @return A status value of success or an error if the mapped treemap is a nullptr.
+	*/
+	Status closeMappedTreeMap(MappedTreeMap* mtm);
+
+	/*
+	* Writes the replaced values back to the image file and waits until they are stored,
+	* like msync followed by fsync.
+	* 
+	* @runtime O(P) where P is the amount of changed pages.
+	* 
+	* @param[in] mtm - Mapped treemap that is flushed.
+	* 
+	* @return A status value of success, error file io or an error if the mapped treemap is a nullptr.
+	*/
+	Status flushMappedTreeMap(const MappedTreeMap* mtm);
+
+	/*
+	* Copies the value of the key out of the image.
+	* 
+	* @runtime O(log N).
+	* 
+	* @param[in] mtm - Mapped treemap that is searched.
+	* @param[in] key - Key whose value is searched.
+	* @param[out] valueBuffer - Buffer that receives the value.
+	* 
+	* @return A status value of success, does not contain, value buffer nullptr
+	*		  or an error if the mapped treemap is a nullptr.
+	*/
+	Status getMappedValue(const MappedTreeMap* mtm, const void* key, void* valueBuffer);
+
+	/*
+	* Overwrites the value of the key inside the image. The change is visible to every
+	* process that maps the image and is stored by flushMappedTreeMap. Pairs can't be
+	* inserted or deleted, the image has to be saved again for that.
+	* 
+	* @runtime O(log N).
+	* 
+	* @param[in, out] mtm - Writable mapped treemap.
+	* @param[in] key - Key whose value is replaced.
+	* @param[in] value - New value that is copied byte by byte.
+	* 
+	* @return A status value of success, does not contain, mapped read only, value buffer nullptr
+	*		  or an error if the mapped treemap is a nullptr.
+	*/
+	Status replaceMappedValue(MappedTreeMap* mtm, const void* key, const void* value);
+
+	/*
+	* Searches the pair with the smallest key that is bigger or equal to the given key.
+	* The pair points into the image and is valid until the mapped treemap is closed.
+	* 
+	* @runtime O(log N).
+	* 
+	* @param[in] mtm - Mapped treemap that is searched.
+	* @param[in] key - Key that is searched.
+	* 
+	* @return The pair or a nullptr if no key is bigger or equal.
+	*/
+	const void* ceilingMappedPair(const MappedTreeMap* mtm, const void* key);
+
+	/*
+	* Searches the pair with the biggest key that is smaller or equal to the given key.
+	* The pair points into the image and is valid until the mapped treemap is closed.
+	* 
+	* @runtime O(log N).
+	* 
+	* @param[in] mtm - Mapped treemap that is searched.
+	* @param[in] key - Key that is searched.
+	* 
+	* @return The pair or a nullptr if no key is smaller or equal.
+	*/
+	const void* floorMappedPair(const MappedTreeMap* mtm, const void* key);
+
+	/*
+	* Searches the pair with the smallest key that is bigger than the given key.
+	* The pair points into the image and is valid until the mapped treemap is closed.
+	* 
+	* @runtime O(log N).
+	* 
+	* @param[in] mtm - Mapped treemap that is searched.
+	* @param[in] key - Key that is searched.
+	* 
+	* @return The pair or a nullptr if no key is bigger.
+	*/
+	const void* higherMappedPair(const MappedTreeMap* mtm, const void* key);
+
+	/*
+	* Searches the pair with the biggest key that is smaller than the given key.
+	* The pair points into the image and is valid until the mapped treemap is closed.
+	* 
+	* @runtime O(log N).
+	* 
+	* @param[in] mtm - Mapped treemap that is searched.
+	* @param[in] key - Key that is searched.
+	* 
+	* @return The pair or a nullptr if no key is smaller.
+	*/
+	const void* lowerMappedPair(const MappedTreeMap* mtm, const void* key);
+
+	/*
+	* Steps to the pair that follows the given one in key order. The treenodes lie
+	* in key order inside the image, so a scan started at ceilingMappedPair reads the file linearly.
+	* 
+	* @runtime O(1).
+	* 
+	* @param[in] mtm - Mapped treemap that is scanned.
+	* @param[in] pair - Pair of the image or a nullptr to get the first pair.
+	* 
+	* @return The next pair or a nullptr behind the last pair.
+	*/
+	const void* nextMappedPair(const MappedTreeMap* mtm, const void* pair);
+
+	// ----------------------------------------------------------- Everything below is part of the shared treemap implementation. -----------------------------------------------------------
+
+	/*
+	* Creates named shared memory for a shared treemap and maps it writable. The process that creates it
+	* is the only writer and publishes treemaps into it, every other process opens it with openSharedTreeMap.
+	* Both areas are reserved up front, so the memory takes twice the size of a version with the capacity.
+	* 
+	* @runtime O(1).
+	* 
+	* @param[in] name - Name of the shared memory.
+	* @param[in] keySize - Size of a key.
+	* @param[in] valueSize - Size of a value.
+	* @param[in] nodeCapacity - Maximum amount of pairs a published treemap can hold.
+	* @param[in] compareKeyFunc - Function that compares the keys.
+	* @param[out] status - Status value of success, file nullptr, key size zero, value size zero, key comp func nullptr,
+	*					   shared capacity exceeded if the memory would be too big, error file io if the name is taken
+	*					   or the memory can't be mapped or an error if the allocation fails.
+	* 
+	* @return The shared treemap or a nullptr if it can't be created.
+	*/
+	SharedTreeMap* createSharedTreeMap(const char* name, size_t keySize, size_t valueSize, size_t nodeCapacity,
+		KeyComparison compareKeyFunc, Status* status);
+
+	/*
+	* Maps the named shared memory of a shared treemap for reading. The readers see every version the
+	* writer publishes and need no lock, so any amount of processes can search the treemap at once.
+	* 
+	* @runtime O(1).
+	* 
+	* @param[in] name - Name of the shared memory.
+	* @param[in] compareKeyFunc - Function that compares the keys like the one of the writer.
+	* @param[out] status - Status value of success, file nullptr, key comp func nullptr, error file io if the memory
+	*					   doesn't exist or can't be mapped, snapshot invalid if it doesn't belong to a shared treemap
+	*					   or an error if the allocation fails.
+	* 
+	* @return The shared treemap or a nullptr if it can't be opened.
+	*/
+	SharedTreeMap* openSharedTreeMap(const char* name, KeyComparison compareKeyFunc, Status* status);
+
+	/*
+	* Unmaps the shared memory and frees the shared treemap. The system releases
+	* the memory once no process maps it anymore.
+	* 
+	* @runtime O(1).
+	* 
+	* @param[in, out] stm - Shared treemap that is closed.
+	* 
+	* @return A status value of success or an error if the shared treemap is a nullptr.
+	*/
+	Status closeSharedTreeMap(SharedTreeMap* stm);
+
+	/*
+	* Copies the treemap as the next version into the shared treemap. The treenodes are written in
+	* key order into the inactive area, which becomes active once it is complete. Readers keep searching
+	* the previous version meanwhile, so the writer doesn't wait for them and they don't wait for it.
+	* The pairs are copied byte by byte and must not hold pointers.
+	* 
+	* @runtime O(N).
+	* 
+	* @param[in, out] stm - Shared treemap that was created by this process.
+	* @param[in, out] tm - Treemap that is published.
+	* 
+	* @return A status value of success, mapped read only if the shared treemap was opened, inline size mismatch,
+	*		  value dictionary exists, snapshot invalid if the pair sizes differ, shared capacity exceeded
+	*		  or an error if a treemap is a nullptr.
+	*/
+	Status publishSharedTreeMap(SharedTreeMap* stm, TreeMap* tm);
+
+	/*
+	* Copies the value of the key out of the active version of the shared treemap.
+	* 
+	* @runtime O(log N) unless the writer overwrites the searched version meanwhile.
+	* 
+	* @param[in] stm - Shared treemap that is searched.
+	* @param[in] key - Key whose value is searched.
+	* @param[out] valueBuffer - Buffer that receives the value.
+	* 
+	* @return A status value of success, does not contain, value buffer nullptr, snapshot invalid
+	*		  if the shared memory is broken or an error if the shared treemap is a nullptr.
+	*/
+	Status getSharedValue(const SharedTreeMap* stm, const void* key, void* valueBuffer);
+
+	/*
+	* Copies the pair with the smallest key that is bigger or equal to the given key
+	* out of the active version of the shared treemap.
+	* 
+	* @runtime O(log N) unless the writer overwrites the searched version meanwhile.
+	* 
+	* @param[in] stm - Shared treemap that is searched.
+	* @param[in] key - Key that is searched.
+	* @param[out] pairBuffer - Buffer that receives the key followed by the value.
+	* 
+	* @return A status value of success, does not contain, pair buffer nullptr, snapshot invalid
+	*		  if the shared memory is broken or an error if the shared treemap is a nullptr.
+	*/
+	Status ceilingSharedPair(const SharedTreeMap* stm, const void* key, void* pairBuffer);
+
+	/*
+	* Copies the pair with the biggest key that is smaller or equal to the given key
+	* out of the active version of the shared treemap.
+	* 
+	* @runtime O(log N) unless the writer overwrites the searched version meanwhile.
+	* 
+	* @param[in] stm - Shared treemap that is searched.
+	* @param[in] key - Key that is searched.
+	* @param[out] pairBuffer - Buffer that receives the key followed by the value.
+	* 
+	* @return A status value of success, does not contain, pair buffer nullptr, snapshot invalid
+	*		  if the shared memory is broken or an error if the shared treemap is a nullptr.
+	*/
+	Status floorSharedPair(const SharedTreeMap* stm, const void* key, void* pairBuffer);
+
+	/*
+	* Copies the pair with the smallest key that is bigger than the given key
+	* out of the active version of the shared treemap.
+	* 
+	* @runtime O(log N) unless the writer overwrites the searched version meanwhile.
+	* 
+	* @param[in] stm - Shared treemap that is searched.
+	* @param[in] key - Key that is searched.
+	* @param[out] pairBuffer - Buffer that receives the key followed by the value.
+	* 
+	* @return A status value of success, does not contain, pair buffer nullptr, snapshot invalid
+	*		  if the shared memory is broken or an error if the shared treemap is a nullptr.
+	*/
+	Status higherSharedPair(const SharedTreeMap* stm, const void* key, void* pairBuffer);
+
+	/*
+	* Copies the pair with the biggest key that is smaller than the given key
+	* out of the active version of the shared treemap.
+	* 
+	* @runtime O(log N) unless the writer overwrites the searched version meanwhile.
+	* 
+	* @param[in] stm - Shared treemap that is searched.
+	* @param[in] key - Key that is searched.
+	* @param[out] pairBuffer - Buffer that receives the key followed by the value.
+	* 
+	* @return A status value of success, does not contain, pair buffer nullptr, snapshot invalid
+	*		  if the shared memory is broken or an error if the shared treemap is a nullptr.
+	*/
+	Status lowerSharedPair(const SharedTreeMap* stm, const void* key, void* pairBuffer);
+
+	// ----------------------------------------------------------- Everything below is part of the log implementation. -----------------------------------------------------------
+
+	/*
+	* Creates a write ahead log and attaches it to the treemap. From then on every successful putPair, deletePair,
+	* replaceValue, poll, rekeyPair and clearTreeMap is recorded, and the records are committed in batches of the
+	* given size, each commit flushes the file to the storage once. If a full batch can't be committed the mutation
+	* returns error file io although it changed the treemap.
+	* The log belongs to the snapshot that was saved right before it, replayTreeMapLog applies it onto that snapshot.
+	* The pairs are recorded byte by byte and must not hold pointers.
+	* 
+	* @runtime O(1).
+	* 
+	* @param[in] tm - Treemap whose mutations are logged.
+	* @param[in, out] file - New file that was opened in binary mode for writing.
+	* @param[in] batchSize - Amount of records that are committed together.
+	* @param[out] status - Status value of success, tree map nullptr, file nullptr, batch size zero, inline size mismatch,
+	*					   value dictionary exists, log exists, error file io or an error if the allocation fails.
+	* 
+	* @return The log or a nullptr if it can't be created.
+	*/
+	TreeMapLog* createTreeMapLog(TreeMap* tm, FILE* file, size_t batchSize, Status* status);
+
+	/*
+	* Commits the pending records, detaches the log from its treemap and frees it. The file stays open.
+	* 
+	* @runtime O(B) where B is the amount of pending records.
+	* 
+	* @param[in, out] log - Log that is closed.
+	* 
+	* @return A status value of success, error file io or an error if the log is a nullptr.
+	*/
+	Status closeTreeMapLog(TreeMapLog* log);
+
+	/*
+	* Writes the pending records as one batch and waits until the file is stored. Calling it
+	* periodically bounds the time a mutation stays uncommitted if the batches fill slowly.
+	* 
+	* @runtime O(B) where B is the amount of pending records.
+	* 
+	* @param[in, out] log - Log that is committed.
+	* 
+	* @return A status value of success, error file io or an error if the log is a nullptr.
+	*/
+	Status commitTreeMapLog(TreeMapLog* log);
+
+	/*
+	* Inserts the pair into the treemap of the log with putPair, which records the insertion.
+	* A mutation is durable once the batch it belongs to is committed.
+	* 
+	* @runtime O(log N).
+	* 
+	* @param[in, out] log - Log of the treemap.
+	* @param[in] pair - Pair that is inserted.
+	* 
+	* @return The status of putPair, error file io if a full batch can't be committed
+	*		  or an error if the log is a nullptr.
+	*/
+	Status logPutPair(TreeMapLog* log, const void* pair);
+
+	/*
+	* Deletes the pair of the key from the treemap of the log with deletePair, which records the deletion.
+	* 
+	* @runtime O(log N).
+	* 
+	* @param[in, out] log - Log of the treemap.
+	* @param[in] key - Key of the pair that is deleted.
+	* @param[out] pairBuffer - Buffer that receives the deleted pair or a nullptr.
+	* 
+	* @return The status of deletePair, error file io if a full batch can't be committed
+	*		  or an error if the log is a nullptr.
+	*/
+	Status logDeletePair(TreeMapLog* log, const void* key, void* pairBuffer);
+
+	/*
+	* Replaces the value of the key inside the treemap of the log with replaceValue, which records the replacement.
+	* 
+	* @runtime O(log N).
+	* 
+	* @param[in, out] log - Log of the treemap.
+	* @param[in] key - Key whose value is replaced.
+	* @param[in] replacementValue - New value.
+	* 
+	* @return The status of replaceValue, error file io if a full batch can't be committed
+	*		  or an error if the log is a nullptr.
+	*/
+	Status logReplaceValue(TreeMapLog* log, const void* key, const void* replacementValue);
+
+	/*
+	* Deletes the minimum pair of the treemap of the log with pollFirstPair, which records the deletion.
+	* 
+	* @runtime O(log N).
+	* 
+	* @param[in, out] log - Log of the treemap.
+	* @param[out] pairBuffer - Buffer that receives the deleted pair or a nullptr.
+	* 
+	* @return The status of pollFirstPair, error file io if a full batch can't be committed
+	*		  or an error if the log is a nullptr.
+	*/
+	Status logPollFirstPair(TreeMapLog* log, void* pairBuffer);
+
+	/*
+	* Deletes the maximum pair of the treemap of the log with pollLastPair, which records the deletion.
+	* 
+	* @runtime O(log N).
+	* 
+	* @param[in, out] log - Log of the treemap.
+	* @param[out] pairBuffer - Buffer that receives the deleted pair or a nullptr.
+	* 
+	* @return The status of pollLastPair, error file io if a full batch can't be committed
+	*		  or an error if the log is a nullptr.
+	*/
+	Status logPollLastPair(TreeMapLog* log, void* pairBuffer);
+
+	/*
+	* Applies the records of a log onto the treemap, which has to hold the snapshot that was saved before
+	* the log was created. Replaying stops at the first batch that is incomplete or damaged, because a crash
+	* can only tear the batch that was committed last. If a record fails the treemap holds the records before it.
+	* 
+	* @runtime O(R log N) where R is the amount of records.
+	* 
+	* @param[in, out] tm - Treemap that holds the snapshot of the log.
+	* @param[in, out] file - Log file that was opened in binary mode for reading.
+	* 
+	* @return A status value of success, file nullptr, inline size mismatch, value dictionary exists,
+	*		  snapshot invalid if the log belongs to other pair sizes or holds an unknown record,
+	*		  the status of a failed mutation or an error if the allocation fails or the treemap is a nullptr.
+	*/
+	Status replayTreeMapLog(TreeMap* tm, FILE* file);
+
+	// ----------------------------------------------------------- Everything below is part of the checkpoint implementation. -----------------------------------------------------------
+
+	/*
+	* Starts a checkpoint that writes the treemap as it is now into the file, in the snapshot format of saveTreeMap.
+	* The pairs are written by continueCheckpoint while the treemap keeps being modified. Until the checkpoint is
+	* finished every mutation copies the pair it changes first, if its key wasn't written yet, which costs O(log N).
+	* clearTreeMap and deleteTreeMap cancel the checkpoint and compactPayloadArena fails while it runs.
+	* 
+	* @runtime O(1).
+	* 
+	* @param[in, out] tm - Treemap that is written.
+	* @param[in, out] file - File that was opened in binary mode for writing.
+	* @param[in] serialize - Function that writes a pair as a record or a nullptr to write the bytes of the pairs.
+	* @param[in] maxRecordSize - Maximum size of a record of the serialize function. Ignored without it.
+	* 
+	* @return A status value of success, file nullptr, inline size mismatch, value dictionary exists, checkpoint
+	*		  multi map, checkpoint running, error serialize pair or an error if the allocation fails or the treemap is a nullptr.
+	*/
+	Status beginCheckpoint(TreeMap* tm, FILE* file, SerializePair serialize, size_t maxRecordSize);
+
+	/*
+	* Writes the next records of the running checkpoint. A background thread can call it with a small budget
+	* while it holds the lock of the treemap, so the writers wait for one slice at most. After the last record
+	* the file holds a snapshot that loadTreeMap reads. The file isn't flushed or closed.
+	* 
+	* @runtime O(B log N) per call where B is the budget.
+	* 
+	* @param[in, out] tm - Treemap whose checkpoint is continued.
+	* @param[in] budget - Maximum amount of records written by this call. Zero finishes the checkpoint.
+	* 
+	* @return A status value of success if the checkpoint is finished, checkpoint pending if another call is needed,
+	*		  checkpoint nullptr, error serialize pair, error file io or an error if the allocation fails or the treemap
+	*		  is a nullptr. An error cancels the checkpoint.
+	*/
+	Status continueCheckpoint(TreeMap* tm, size_t budget);
+
+	/*
+	* Cancels the running checkpoint and frees the copied pairs. The file holds an incomplete snapshot.
+	* 
+	* @runtime O(C) where C is the amount of copied pairs.
+	* 
+	* @param[in, out] tm - Treemap whose checkpoint is cancelled.
+	* 
+	* @return A status value of success, checkpoint nullptr or tree map nullptr.
+	*/
+	Status cancelCheckpoint(TreeMap* tm);
+
+	// ----------------------------------------------------------- Everything below is part of the lsm implementation. -----------------------------------------------------------
+
+	/*
+	* Creates a log structured merge tree on top of the empty treemap, which becomes its memtable. When the memtable
+	* holds as many pairs and tombstones as the limit, they are flushed in key order into a new run file. The run files
+	* are named after the path prefix with a counter and belong to the tree, closeLsmTree deletes them.
+	* There is no function that opens the runs of an earlier lsm tree, so the runs don't outlive the process and
+	* the tree only lets the data outgrow the memory. A write ahead log keeps the memtable across a crash,
+	* but not the runs.
+	* The pairs are stored byte by byte and must not hold pointers.
+	* 
+	* @runtime O(1).
+	* 
+	* @param[in, out] memtable - Treemap that is used as the memtable. It must only be modified through the tree.
+	* @param[in] pathPrefix - Path prefix of the run files, for example a directory with a trailing separator.
+	* @param[in] memtableLimit - Amount of pairs and tombstones the memtable holds before it is flushed.
+	* @param[out] status - Status value of success, tree map nullptr, file nullptr, memtable limit zero, inline size
+	*					   mismatch, value dictionary exists, memtable multi map or an error if the allocation fails.
+	* 
+	* @return The lsm tree or a nullptr if it can't be created.
+	*/
+	LsmTree* createLsmTree(TreeMap* memtable, const char* pathPrefix, size_t memtableLimit, Status* status);
+
+	/*
+	* Deletes the run files and frees the lsm tree. The memtable isn't flushed or deleted.
+	* The pairs of the runs are lost, flush the memtable into another store first to keep them.
+	* 
+	* @runtime O(R) where R is the amount of runs.
+	* 
+	* @param[in, out] lsm - Lsm tree that is closed.
+	* 
+	* @return A status value of success or an error if the lsm tree is a nullptr.
+	*/
+	Status closeLsmTree(LsmTree* lsm);
+
+	/*
+	* Inserts the pair or replaces the value of its key. The memtable is flushed if it reaches its limit.
+	* 
+	* @runtime O(log M) where M is the memtable limit, or O(M) if the memtable is flushed.
+	* 
+	* @param[in, out] lsm - Lsm tree the pair is put into.
+	* @param[in] pair - Pair that is inserted.
+	* 
+	* @return A status value of success, the status of putPair, replaceValue or flushLsmTree, tree node pair nullptr
+	*		  or an error if the lsm tree is a nullptr.
+	*/
+	Status putLsmPair(LsmTree* lsm, const void* pair);
+
+	/*
+	* Deletes the key. If runs exist a tombstone hides the key in them until compactLsmTree drops it.
+	* The key doesn't have to exist. The memtable is flushed if it reaches its limit.
+	* 
+	* @runtime O(log M) where M is the memtable limit, or O(M) if the memtable is flushed.
+	* 
+	* @param[in, out] lsm - Lsm tree the key is deleted out of.
+	* @param[in] key - Key that is deleted.
+	* 
+	* @return A status value of success, the status of putPair or flushLsmTree, key buffer nullptr
+	*		  or an error if the lsm tree is a nullptr.
+	*/
+	Status deleteLsmPair(LsmTree* lsm, const void* key);
+
+	/*
+	* Writes the pairs and tombstones of the memtable into a new run, waits until the run is stored and clears
+	* the memtable. If 16 runs exist they are compacted first, inside the call of the writer that filled the memtable.
+	* 
+	* @runtime O(M) where M is the size of the memtable, or O(N R) if the runs are compacted.
+	* 
+	* @param[in, out] lsm - Lsm tree whose memtable is flushed.
+	* 
+	* @return A status value of success, the status of compactLsmTree, error file io or an error if the allocation
+	*		  fails or the lsm tree is a nullptr. The memtable keeps its pairs if the run can't be written.
+	*/
+	Status flushLsmTree(LsmTree* lsm);
+
+	/*
+	* Merges all runs into a single run that holds the newest pair of every key that isn't deleted and deletes the
+	* old run files. The tree has no background thread, flushLsmTree calls it when 16 runs exist. A thread
+	* of the caller can call it earlier while it holds the lock of the lsm tree.
+	* 
+	* @runtime O(N R) where N is the amount of records and R the amount of runs.
+	* 
+	* @param[in, out] lsm - Lsm tree whose runs are compacted.
+	* 
+	* @return A status value of success, error file io or an error if the allocation fails or the lsm tree
+	*		  is a nullptr. The runs stay as they are if the new run can't be written.
+	*/
+	Status compactLsmTree(LsmTree* lsm);
+
+	/*
+	* Copies the value of the key. The runs whose Bloom filter rules the key out aren't searched
+	* and every other run reads a single block besides its block index.
+	* 
+	* @runtime O(log M + R log N) where M is the memtable limit, R the amount of runs and N the amount of records.
+	* 
+	* @param[in] lsm - Lsm tree the value is searched in.
+	* @param[in] key - Key whose value is searched.
+	* @param[out] valueBuffer - Buffer the value is copied into.
+	* 
+	* @return A status value of success, does not contain, value buffer nullptr or an error if the lsm tree is a nullptr.
+	*/
+	Status getLsmValue(const LsmTree* lsm, const void* key, void* valueBuffer);
+
+	/*
+	* Copies the pair with the smallest key that is bigger or equal to the given key.
+	* 
+	* @runtime O(log M + R log N) per skipped tombstone where M is the memtable limit, R the amount of runs
+	*		   and N the amount of records.
+	* 
+	* @param[in] lsm - Lsm tree the pair is searched in.
+	* @param[in] key - Key the search starts at.
+	* @param[out] pairBuffer - Buffer the pair is copied into.
+	* 
+	* @return A status value of success, does not contain, pair buffer nullptr or an error if the lsm tree is a nullptr.
+	*/
+	Status ceilingLsmPair(const LsmTree* lsm, const void* key, void* pairBuffer);
+
+	/*
+	* Copies the pair with the smallest key that is bigger than the given key. A range scan starts with
+	* ceilingLsmPair and passes the key of the last pair to this function.
+	* 
+	* @runtime O(log M + R log N) per skipped tombstone where M is the memtable limit, R the amount of runs
+	*		   and N the amount of records.
+	* 
+	* @param[in] lsm - Lsm tree the pair is searched in.
+	* @param[in] key - Key the search starts after.
+	* @param[out] pairBuffer - Buffer the pair is copied into.
+	* 
+	* @return A status value of success, does not contain, pair buffer nullptr or an error if the lsm tree is a nullptr.
+	*/
+	Status higherLsmPair(const LsmTree* lsm, const void* key, void* pairBuffer);
+
+	// ----------------------------------------------------------- Everything below is part of the spill implementation. -----------------------------------------------------------
+
+	/*
+	* Gives the treemap a budget for the memory of its treenodes. Whenever an insertion lets the resident treenodes
+	* exceed it, the subtrees that weren't visited since the last spill are written into the file and freed, until
+	* an eighth of the budget is free again. Operations that reach a spilled treenode fault it back in, functions
+	* that visit every treenode fault all of them back in. Nested data of the pairs stays in memory.
+	* A budget of 0 faults every treenode back in and removes the budget.
+	* 
+	* Faulting in relinks treenodes and sets their access bits, so the searches, the save functions and
+	* publishSharedTreeMap take a mutable treemap. A treemap with a budget mustn't be searched by several
+	* threads at once, while one without a budget is never changed by them.
+	* 
+	* @runtime O(N) for the spill that follows.
+	* 
+	* @param[in, out] tm - Treemap that gets the budget.
+	* @param[in, out] file - File opened for reading and writing that keeps the spilled treenodes while the treemap exists.
+	* @param[in] budget - Bytes the resident treenodes may take or 0.
+	* 
+	* @return A status value of success, file nullptr, inline size mismatch, spill multimap, hash unsupported,
+	*		  checkpoint running, error file io or an error if the allocation fails or the treemap is a nullptr.
+	*/
+	Status setTreeMapBudget(TreeMap* tm, FILE* file, size_t budget);
+
+	/*
+	* Spills the cold treenodes if the resident ones exceed the budget, like putPair does after every insertion.
+	* 
+	* @runtime O(N).
+	* 
+	* @param[in, out] tm - Treemap whose treenodes are spilled.
+	* 
+	* @return A status value of success, spill nullptr, checkpoint running, error file io or tree map nullptr.
+	*/
+	Status spillTreeMap(TreeMap* tm);
+
+	/*
+	* Faults every spilled treenode back in. The budget stays.
+	* 
+	* @runtime O(N).
+	* 
+	* @param[in, out] tm - Treemap whose treenodes are faulted in.
+	* 
+	* @return A status value of success, spill nullptr, error file io or an error if the allocation fails
+	*		  or the treemap is a nullptr.
+	*/
+	Status restoreTreeMap(TreeMap* tm);
+
+	// ----------------------------------------------------------- Everything below is part of the paged treemap implementation. -----------------------------------------------------------
+
+	/*
+	* Writes the treemap into pages that openPagedTreeMap reads through a buffer pool. A page takes as many
+	* full levels of a subtree as fit into it, so a search reads a page for every few levels. Below them
+	* subtrees that fit into a page are packed together and bigger ones start pages of their own. The pages follow each other in pre-order with the smaller keys first,
+	* which lets a scan in key order read the file front to back. The pairs are copied byte by byte and must
+	* not hold pointers.
+	* 
+	* @runtime O(N).
+	* 
+	* @param[in, out] tm - Treemap that is saved.
+	* @param[in, out] file - File that was opened in binary mode for writing.
+	* @param[in] pageSize - Size of a page, a power of two from 4 KB to 16 KB.
+	* 
+	* @return A status value of success, file nullptr, page size invalid, inline size mismatch, value dictionary exists,
+	*		  error file io if the file can't be written or an error if the allocation fails or the treemap is a nullptr.
+	*/
+	Status savePagedTreeMap(TreeMap* tm, FILE* file, size_t pageSize);
+
+	/*
+	* Opens the paged treemap inside the file with an empty buffer pool. Only the header is read, the pages
+	* are read when a search reaches them. A page that is read right behind the previously read page starts
+	* a read ahead of the following pages with the same request. The links of the treenodes aren't checked,
+	* so the file has to come from a trusted source.
+	* 
+	* @runtime O(P) where P is the amount of pages.
+	* 
+	* @param[in, out] file - File that was opened in binary mode for reading and optionally writing. It stays open until
+	*						 the paged treemap is closed.
+	* @param[in] compareKeyFunc - Function that compares the keys like the one of the saved treemap.
+	* @param[in] poolPages - Amount of pages the buffer pool holds, at least 4.
+	* @param[in] readAhead - Amount of pages that are read ahead during a scan, at most half of the pool.
+	* @param[out] status - Status value of success, file nullptr, key comp func nullptr, pool size invalid,
+	*					   error file io, snapshot invalid if the file isn't a paged treemap or an error if
+	*					   the allocation fails.
+	* 
+	* @return The paged treemap or a nullptr if it can't be opened.
+	*/
+	PagedTreeMap* openPagedTreeMap(FILE* file, KeyComparison compareKeyFunc, size_t poolPages, size_t readAhead, Status* status);
+
+	/*
+	* Writes the dirty pages back and frees the paged treemap with its buffer pool. The file isn't closed.
+	* 
+	* @runtime O(F) where F is the amount of frames.
+	* 
+	* @param[in, out] ptm - Paged treemap that is closed.
+	* 
+	* @return A status value of success, error file io or an error if the paged treemap is a nullptr.
+	*		  The paged treemap is freed either way.
+	*/
+	Status closePagedTreeMap(PagedTreeMap* ptm);
+
+	/*
+	* Writes the dirty pages of the buffer pool back to the file and waits until it is stored.
+	* 
+	* @runtime O(F) where F is the amount of frames.
+	* 
+	* @param[in, out] ptm - Paged treemap that is flushed.
+	* 
+	* @return A status value of success, error file io or an error if the paged treemap is a nullptr.
+	*/
+	Status flushPagedTreeMap(PagedTreeMap* ptm);
+
+	/*
+	* Copies the value of the key out of its page.
+	* 
+	* @runtime O(log N) with O(log N / log B) page reads where B is the amount of treenodes of a page.
+	* 
+	* @param[in, out] ptm - Paged treemap that is searched.
+	* @param[in] key - Key whose value is searched.
+	* @param[out] valueBuffer - Buffer that receives the value.
+	* 
+	* @return A status value of success, does not contain, value buffer nullptr, error file io
+	*		  or an error if the paged treemap is a nullptr.
+	*/
+	Status getPagedValue(PagedTreeMap* ptm, const void* key, void* valueBuffer);
+
+	/*
+	* Overwrites the value of the key inside its page. The page is written back when the buffer pool
+	* evicts it or the paged treemap is flushed. Pairs can't be inserted or deleted, the treemap has
+	* to be saved again for that.
+	* 
+	* @runtime O(log N) with O(log N / log B) page reads where B is the amount of treenodes of a page.
+	* 
+	* @param[in, out] ptm - Paged treemap whose file was opened for writing.
+	* @param[in] key - Key whose value is replaced.
+	* @param[in] value - New value that is copied byte by byte.
+	* 
+	* @return A status value of success, does not contain, value buffer nullptr, error file io if an evicted
+	*		  page can't be written or an error if the paged treemap is a nullptr.
+	*/
+	Status replacePagedValue(PagedTreeMap* ptm, const void* key, const void* value);
+
+	/*
+	* Copies the pair with the smallest key that is bigger or equal to the given key.
+	* 
+	* @runtime O(log N).
+	* 
+	* @param[in, out] ptm - Paged treemap that is searched.
+	* @param[in] key - Key that is searched.
+	* @param[out] pairBuffer - Buffer that receives the pair.
+	* 
+	* @return A status value of success, does not contain, pair buffer nullptr, error file io
+	*		  or an error if the paged treemap is a nullptr.
+	*/
+	Status ceilingPagedPair(PagedTreeMap* ptm, const void* key, void* pairBuffer);
+
+	/*
+	* Copies the pair with the biggest key that is smaller or equal to the given key.
+	* 
+	* @runtime O(log N).
+	* 
+	* @param[in, out] ptm - Paged treemap that is searched.
+	* @param[in] key - Key that is searched.
+	* @param[out] pairBuffer - Buffer that receives the pair.
+	* 
+	* @return A status value of success, does not contain, pair buffer nullptr, error file io
+	*		  or an error if the paged treemap is a nullptr.
+	*/
+	Status floorPagedPair(PagedTreeMap* ptm, const void* key, void* pairBuffer);
+
+	/*
+	* Copies the pair with the smallest key that is bigger than the given key. A range scan starts with
+	* ceilingPagedPair and passes the key of the last pair to this function. Its pages are read in file order,
+	* so the read ahead fetches them before the scan reaches them.
+	* 
+	* @runtime O(log N), the pages near the root stay inside the buffer pool during a scan.
+	* 
+	* @param[in, out] ptm - Paged treemap that is searched.
+	* @param[in] key - Key the search starts after.
+	* @param[out] pairBuffer - Buffer that receives the pair.
+	* 
+	* @return A status value of success, does not contain, pair buffer nullptr, error file io
+	*		  or an error if the paged treemap is a nullptr.
+	*/
+	Status higherPagedPair(PagedTreeMap* ptm, const void* key, void* pairBuffer);
+
+	/*
+	* Copies the pair with the biggest key that is smaller than the given key.
+	* 
+	* @runtime O(log N).
+	* 
+	* @param[in, out] ptm - Paged treemap that is searched.
+	* @param[in] key - Key that is searched.
+	* @param[out] pairBuffer - Buffer that receives the pair.
+	* 
+	* @return A status value of success, does not contain, pair buffer nullptr, error file io
+	*		  or an error if the paged treemap is a nullptr.
+	*/
+	Status lowerPagedPair(PagedTreeMap* ptm, const void* key, void* pairBuffer);
+
+	// ----------------------------------------------------------- Everything below is part of the change stream implementation. -----------------------------------------------------------
+
+	/*
+	* Attaches a change stream to the treemap. From then on putPair, deletePair, replaceValue, pollFirstPair,
+	* pollLastPair, rekeyPair and clearTreeMap append a record of every successful change to its ring, which
+	* another thread drains with drainChangeStream. If the ring is full the record is lost and no further records
+	* are appended until resetChangeStream is called. deleteTreeMap frees the stream of the treemap.
+	* The pairs are recorded byte by byte, so they must not hold pointers.
+	* 
+	* @runtime O(1) for every recorded change.
+	* 
+	* @param[in, out] tm - Treemap whose changes are recorded.
+	* @param[in] capacity - Amount of records the ring holds, a power of two.
+	* @param[out] status - Status value of success, tree map nullptr, stream capacity invalid, inline size mismatch,
+	*					   value dictionary exists, change stream exists or an error if the allocation fails.
+	* 
+	* @return The change stream or a nullptr.
+	*/
+	ChangeStream* createChangeStream(TreeMap* tm, size_t capacity, Status* status);
+
+	/*
+	* Detaches the change stream from its treemap and frees it. The consumer has to stop before.
+	* 
+	* @param[in, out] cs - Change stream that is closed.
+	* 
+	* @return A status value of success or an error if the change stream is a nullptr.
+	*/
+	Status closeChangeStream(ChangeStream* cs);
+
+	/*
+	* Empties the ring and lets the producer append again after records were lost. Neither the treemap nor
+	* the consumer may use the stream meanwhile, e.g. while the snapshot that synchronises the replicas is taken.
+	* 
+	* @param[in, out] cs - Change stream that is reset.
+	* 
+	* @return A status value of success or an error if the change stream is a nullptr.
+	*/
+	Status resetChangeStream(ChangeStream* cs);
+
+	/*
+	* Moves the oldest records into the buffer. Only a single consumer thread may drain the stream, concurrently
+	* to the thread that changes the treemap. Once records were lost, the records in front of the loss are drained
+	* first and then changes lost is returned.
+	* 
+	* @runtime O(N) for the drained records.
+	* 
+	* @param[in, out] cs - Change stream that is drained.
+	* @param[out] records - Buffer for maxAmount records of the record size of the stream.
+	* @param[in] maxAmount - Maximum amount of records that are drained.
+	* @param[out] recordAmount - Amount of records that were drained.
+	* 
+	* @return A status value of success, changes lost, pair buffer nullptr, amount buffer nullptr
+	*		  or an error if the change stream is a nullptr.
+	*/
+	Status drainChangeStream(ChangeStream* cs, void* records, size_t maxAmount, size_t* recordAmount);
+
+	/*
+	* Replays drained records onto a replica that held the same pairs as the treemap when the first of them
+	* was recorded. The replica needs the key and value sizes and the comparison of the treemap. Puts with ascending
+	* keys into an empty replica, like the pairs that follow a clear, are built at once like loadTreeMap does.
+	* 
+	* @runtime O(N log M) for N records and M pairs, O(N) for a run of ascending puts into an empty replica.
+	* 
+	* @param[in, out] replica - Treemap the records are applied to.
+	* @param[in] records - Records of the record size of a stream of the same key and value sizes.
+	* @param[in] recordAmount - Amount of records.
+	* 
+	* @return A status value of success, pair buffer nullptr, inline size mismatch, value dictionary exists,
+	*		  snapshot invalid for an unknown record, the status of a change that fails or an error
+	*		  if the allocation fails or the replica is a nullptr.
+	*/
+	Status applyChangeBatch(TreeMap* replica, const void* records, size_t recordAmount);
+
+	// ----------------------------------------------------------- Everything below is part of the subtree hash implementation. -----------------------------------------------------------
+
+	/*
+	* Sets the function that hashes the pairs of the treemap. Every treenode then keeps the hash of its pair and
+	* the hash of its subtree, the sum of the hashes of its pairs, which the insertions, deletions, rotations and
+	* replacements keep up to date. The treenodes grow by two size_t, so the function can only be changed while the
+	* treemap is empty and before a node arena is created. Multimaps, inline pairs, value dictionaries and memory budgets
+	* can't be combined with the hashes.
+	* 
+	* @runtime O(1), every change of a pair costs one call of the function.
+	* 
+	* @param[in, out] tm - Treemap whose pairs are hashed.
+	* @param[in] hashPairFunc - Function that hashes a pair or a nullptr to remove the hashes.
+	* 
+	* @return A status value of success, tree map not empty, node arena exists, hash unsupported
+	*		  or an error if the treemap is a nullptr.
+	*/
+	Status setTreeMapHash(TreeMap* tm, HashPair hashPairFunc);
+
+	/*
+	* Checks if two treemaps hold the same pairs. Treemaps with the same pair hash function only compare the
+	* hashes of their roots, which are equal for equal pairs no matter how the trees are shaped. Different pairs
+	* get the same hash with a probability of 2^-64. Otherwise every pair of the first treemap is searched in the second one.
+	* 
+	* @runtime O(1) with subtree hashes, otherwise O(N log N).
+	* 
+	* @param[in] tm1 - First treemap.
+	* @param[in] tm2 - Second treemap.
+	* 
+	* @return A status value of success if the pairs are equal, tree maps differ if they aren't, hash unsupported
+	*		  for a multimap or a treemap with a memory budget without subtree hashes or an error if a treemap is a nullptr.
+	*/
+	Status treeMapsEqual(const TreeMap* tm1, const TreeMap* tm2);
+
+	/*
+	* Calls the visit function for every key, in key order, whose pair is missing in one of the treemaps or has
+	* values that aren't equal. Subtrees of the first treemap whose hash matches the pairs of the second treemap
+	* between the same keys are skipped, so only the paths to the differences are walked.
+	* 
+	* @runtime O(D log^2 N) for D differences.
+	* 
+	* @param[in] tm1 - First treemap.
+	* @param[in] tm2 - Second treemap with the same pair hash function.
+	* @param[in] visitFunc - Function that visits a difference.
+	* 
+	* @return A status value of success, the status of the visit function if it isn't success, visit func nullptr,
+	*		  hash unsupported if the treemaps don't have the same pair hash function or an error if a treemap is a nullptr.
+	*/
+	Status diffTreeMaps(const TreeMap* tm1, const TreeMap* tm2, VisitDifference visitFunc);
+
+	// ----------------------------------------------------------- Everything below is part of the statistics implementation. -----------------------------------------------------------
+
+	/*
+	* Attaches counters to the treemap that count its comparisons, rotations, color flips, moveRedLeft and
+	* moveRedRight calls, allocations and frees from then on. The counters are only compiled into the library
+	* if the assembler gets TREE_MAP_COUNTERS defined, otherwise no operation pays for them. The treemap doesn't
+	* take ownership of the counters and adds to the values they hold.
+	* 
+	* @runtime O(1), every counted event costs a load and an increment.
+	* 
+	* @param[in, out] tm - Treemap whose work is counted.
+	* @param[in] counters - Counters that are incremented or a nullptr to detach the counters.
+	* 
+	* @return A status value of success, counters unsupported if the library is built without
+	*		  TREE_MAP_COUNTERS or an error if the treemap is a nullptr.
+	*/
+	Status setTreeMapCounters(TreeMap* tm, TreeMapCounters* counters);
+
+	/*
+	* Measures the height, the black height, the average depth and the used bytes of the treemap.
+	* Spilled treenodes are faulted back in first, because every treenode is visited, so the treemap
+	* can change and mustn't be shared with other threads meanwhile.
+	* 
+	* @runtime O(N)
+	* 
+	* @param[in, out] tm - Treemap that is measured and whose spilled treenodes are faulted in.
+	* @param[out] stats - Buffer that receives the statistics.
+	* 
+	* @return A status value of success, stats buffer nullptr, the status of faulting in spilled treenodes
+	*		  or an error if the treemap is a nullptr.
+	*/
+	Status getTreeMapStats(TreeMap* tm, TreeMapStats* stats);
 }
 
 
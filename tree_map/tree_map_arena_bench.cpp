@@ -0,0 +1,164 @@
+/*
+* @file tree_map_arena_bench.cpp
+*
+* Defines the benchmarks that measure the data tlb misses of lookups and ordered
+* scans with treenodes on the heap, in a node arena with normal pages and in a
+* node arena with large pages.
+*
+* @author Collector
+* @data 10/17/2026
+*/
+
+#include <algorithm>
+#include <string>
+
+#include "utils.h"
+#include "bench_utils.h"
+
+namespace {
+	/*
+	* Biggest treemap of the arena benchmarks. Bigger treemaps only repeat the misses
+	* of the 10M treemaps and take minutes to build per layout.
+	*/
+	constexpr size_t arenaMaxSize{ 10'000'000 };
+
+	/*
+	* Size of the chunks of the node arenas, a large page on most processors.
+	*/
+	constexpr size_t arenaChunkSize{ 2 * 1024 * 1024 };
+
+	/*
+	* Places where the treenodes of a benchmarked treemap are stored.
+	*/
+	enum class NodeLayout {
+		HEAP, // Every treenode is allocated on its own.
+		ARENA, // Chunks of normal pages.
+		ARENA_LARGE_PAGES // Chunks of large pages.
+	};
+
+	const char* getLayoutName(NodeLayout layout) {
+		switch (layout) {
+		case NodeLayout::HEAP:
+			return "heap";
+		case NodeLayout::ARENA:
+			return "arena";
+		default:
+			return "arena_large_pages";
+		}
+	}
+
+	/*
+	* Creates a treemap with integer keys in the given layout. The keys are inserted in a shuffled
+	* order, so the treenodes of the heap lie in insertion order. The node arenas are compacted
+	* afterwards and hold the treenodes in key order.
+	*/
+	TreeMap* createLayoutMap(NodeLayout layout, size_t amount) {
+		TreeMap* tm{ IntegerKeys::createMap() };
+		IntegerPair pair{};
+
+		if (layout != NodeLayout::HEAP) {
+			createNodeArena(tm, arenaChunkSize, layout == NodeLayout::ARENA_LARGE_PAGES ? size_t{ LARGE_PAGES } : size_t{ 0 });
+		}
+
+		for (uint32_t index : createKeyOrder(KeyDistribution::UNIFORM, amount)) {
+			makeBenchmarkPair<IntegerKeys>(index, &pair);
+			putPair(tm, &pair);
+		}
+
+		if (layout != NodeLayout::HEAP) {
+			compactTreeMap(tm, 0);
+		}
+
+		return tm;
+	}
+
+	/*
+	* Adds the chunks of the node arena that large pages back as a counter to the benchmark.
+	* Without it a large page run that fell back to normal pages can't be told apart.
+	*/
+	void reportLargePageChunks(benchmark::State& state, const TreeMap* tm) {
+		state.counters["large_page_chunks"] = static_cast<double>(tm->nodeArena != nullptr ? tm->nodeArena->largePageChunks : 0);
+	}
+
+	/*
+	* Sums the values of the treenodes in key order. The path holds the treenodes whose
+	* right subtree is still to be visited, a red black tree of 2^64 treenodes is at most
+	* 128 treenodes high.
+	*/
+	size_t scanTreeNodes(const TreeMap* tm) {
+		const NumberTreeNode* path[128];
+		const NumberTreeNode* node{ reinterpret_cast<const NumberTreeNode*>(tm->root) };
+		size_t depth{ 0 };
+		size_t sum{ 0 };
+
+		while (node != nullptr || depth != 0) {
+			for (; node != nullptr; node = node->left) {
+				path[depth++] = node;
+			}
+
+			node = path[--depth];
+			sum += node->value;
+			node = node->right;
+		}
+
+		return sum;
+	}
+
+	void benchmarkArenaLookup(benchmark::State& state, NodeLayout layout, size_t amount) {
+		TreeMap* tm{ createLayoutMap(layout, amount) };
+		std::vector<uint32_t> queries{ createKeyQueries(KeyDistribution::UNIFORM, amount, benchmarkQueryAmount) };
+		std::vector<size_t> keys(queries.size());
+		PerfCounters counters;
+		size_t value;
+		size_t i{ 0 };
+
+		for (size_t j{ 0 }; j < queries.size(); j++) {
+			IntegerKeys::makeKey(2 * size_t{ queries[j] }, &keys[j]);
+		}
+
+		counters.start();
+
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(getValue(tm, &keys[i++ & (benchmarkQueryAmount - 1)], &value));
+		}
+
+		counters.stop();
+
+		reportLargePageChunks(state, tm);
+		reportTimePerOperation(state, state.iterations());
+		counters.report(state, state.iterations());
+		deleteTreeMap(tm);
+	}
+
+	void benchmarkArenaScan(benchmark::State& state, NodeLayout layout, size_t amount) {
+		TreeMap* tm{ createLayoutMap(layout, amount) };
+		PerfCounters counters;
+
+		counters.start();
+
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(scanTreeNodes(tm));
+		}
+
+		counters.stop();
+
+		reportLargePageChunks(state, tm);
+		reportTimePerOperation(state, state.iterations() * amount);
+		counters.report(state, state.iterations() * amount);
+		deleteTreeMap(tm);
+	}
+}
+
+void registerArenaBenchmarks(size_t maxSize) {
+	const NodeLayout layouts[]{ NodeLayout::HEAP, NodeLayout::ARENA, NodeLayout::ARENA_LARGE_PAGES };
+
+	for (size_t amount : getBenchmarkSizes(std::min(maxSize, arenaMaxSize))) {
+		for (NodeLayout layout : layouts) {
+			std::string suffix{ std::string{ "/" } + getLayoutName(layout) + "/" + std::to_string(amount) };
+
+			benchmark::RegisterBenchmark(("arena/lookup" + suffix).c_str(), benchmarkArenaLookup, layout, amount);
+			benchmark::RegisterBenchmark(("arena/scan" + suffix).c_str(), benchmarkArenaScan, layout, amount)
+				->Unit(benchmark::kMillisecond);
+		}
+	}
+}
@@ -97,6 +97,23 @@ fetchAndStoreParams:
 	cmp r10, parameterStackLimit
 	jle fetchAndStoreParams
 
+	; No spare treenode, payload arena, value dictionary or node arena exists yet and no flags are set.
+	; A single spare treenode is kept until setSpareTreeNodeLimit changes it.
+	mov [rax].TreeMap.spareTreeNode, nullptr
+	mov [rax].TreeMap.spareAmount, 0
+	mov [rax].TreeMap.spareLimit, defaultSpareLimit
+	mov [rax].TreeMap.modificationCount, 0
+	mov [rax].TreeMap.flags, 0
+	mov [rax].TreeMap.payloadArena, nullptr
+	mov [rax].TreeMap.valueDictionary, nullptr
+	mov [rax].TreeMap.nodeArena, nullptr
+	mov [rax].TreeMap.checkpoint, nullptr
+	mov [rax].TreeMap.spill, nullptr
+	mov [rax].TreeMap.changeStream, nullptr
+	mov [rax].TreeMap.hashPairFunc, nullptr
+	mov [rax].TreeMap.counters, nullptr
+	mov [rax].TreeMap.log, nullptr
+
 	mov edx, success
 	jmp setStatus
 
@@ -147,34 +164,212 @@ functionReturn:
 createTreeMap endp
 
 
+	public setTreeMapFlags
+
+; Sets the flags that change the behaviour of the treemap.
+; The flags can only be changed while the treemap is empty.
+;
+; @RCX qword[in,out] - Pointer to the treemap whose flags are set.
+; @RDX qword[in] - The flags that are set, e.g. multiMapFlag to permit equal keys.
+;
+; @return Status flag of a success, treeMapNotEmpty if the treemap holds pairs, inlineSizeMismatch
+;		  if inline pairs are requested but the key or value size isn't the size of InlineData or the
+;		  treemap has a node arena, hashUnsupported if the treemap has subtree hashes or that the specified
+;		  treemap is a nullptr.
+setTreeMapFlags proc
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the treemap is empty.
+	mov eax, treeMapNotEmpty
+	cmp [rcx].TreeMap.nodeAmount, 0
+	jne functionReturn
+
+	; Subtree hashes need unique keys whose pairs are stored inside the treenodes.
+	cmp [rcx].TreeMap.hashPairFunc, nullptr
+	je checkInlinePairs
+
+	mov eax, hashUnsupported
+	cmp rdx, 0
+	jne functionReturn
+
+checkInlinePairs:
+	; Inline pairs are described by an InlineData for the key and the value.
+	test rdx, inlinePairsFlag
+	jz setFlags
+
+	; Their treenodes differ in size and can't be taken from a node arena.
+	mov eax, inlineSizeMismatch
+	cmp [rcx].TreeMap.nodeArena, nullptr
+	jne functionReturn
+
+	cmp [rcx].TreeMap.keySize, sizeof InlineData
+	jne functionReturn
+
+	cmp [rcx].TreeMap.valueSize, sizeof InlineData
+	jne functionReturn
+
+setFlags:
+	mov [rcx].TreeMap.flags, rdx
+	mov eax, success
+
+functionReturn:
+	ret
+
+setTreeMapFlags endp
+
+
+	public setSpareTreeNodeLimit
+
+; Sets how many treenodes of deleted pairs the treemap keeps for reuse.
+; Spare treenodes above the new limit are freed.
+;
+; @RCX qword[in,out] - Pointer to the treemap whose limit is set.
+; @RDX qword[in] - Maximum amount of spare treenodes.
+;
+; @return Status flag of a success or that the specified treemap is a nullptr.
+setSpareTreeNodeLimit proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov [rcx].TreeMap.spareLimit, rdx
+	call trimSpareTreeNodes
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	ret
+
+setSpareTreeNodeLimit endp
+
+
+	public trimSpareTreeNodes
+
+; Frees the most recently released spare treenodes of the treemap until
+; at most the given amount is left.
+;
+; @RCX qword[in,out] - Pointer to the treemap whose spare treenodes are freed.
+; @RDX qword[in] - Amount of spare treenodes that are kept.
+;
+; @return Status flag of a success or that the specified treemap is a nullptr.
+trimSpareTreeNodes proc
+
+	push rbx
+	push rsi
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+	mov rbx, rdx
+
+freeSpareTreeNode:
+	cmp [rsi].TreeMap.spareAmount, rbx
+	jbe trimmed
+
+	; Unlink the first spare treenode and free it.
+	mov rcx, [rsi].TreeMap.spareTreeNode
+	mov rax, [rcx]
+	mov [rsi].TreeMap.spareTreeNode, rax
+	dec [rsi].TreeMap.spareAmount
+	countTreeMapEvent rsi, frees
+	call free
+
+	jmp freeSpareTreeNode
+
+trimmed:
+	mov eax, success
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rsi
+	pop rbx
+	ret
+
+trimSpareTreeNodes endp
+
+
 	public deleteTreeMap
 
-; Deletes the specified treemap freeing all nodes allocated inside of it
-; and finally freeing the treemap structure itself.
+; Deletes the specified treemap freeing all nodes allocated inside of it, its payload arena,
+; its value dictionary, its node arena, its budget and finally the treemap structure itself.
+; An attached log is closed before, so it commits its pending records but not the clear.
 ;
 ; @RCX qword[in,out] - Pointer to the treemap that should be deleted.
 ;
 ; @return Status flag of a success or that the specified treemap is a nullptr.
 deleteTreeMap proc
 
-	; sub 16 bytes so that the stack is still aligned after calling
-	; clearTreeMap.
-	sub rsp, 2 * qwordSize
+	; Allocate the shadow storage and 8 bytes for the treemap
+	; so that the stack is aligned when calling clearTreeMap and free.
+	sub rsp, shadowStorage + qwordSize
 
-	; Save the treemap and clear the nodes.
-	mov [rsp], rcx
+	; Save the treemap, close its log and clear the nodes.
+	mov [rsp + shadowStorage], rcx
+	cmp rcx, nullptr
+	je clearTreeNodes
+
+	mov rcx, [rcx].TreeMap.log
+	call closeTreeMapLog
+
+	mov rcx, [rsp + shadowStorage]
+
+clearTreeNodes:
 	call clearTreeMap
 
 	; Check if everything was successful.
 	cmp eax, success
 	jne functionReturn
 
+	; Free the payload arena, the value dictionary and the node arena, free ignores a nullptr.
+	mov rcx, [rsp + shadowStorage]
+	mov rcx, [rcx].TreeMap.payloadArena
+	call free
+
+	; Free the buckets of the hash index of the value dictionary.
+	mov rcx, [rsp + shadowStorage]
+	mov rcx, [rcx].TreeMap.valueDictionary
+	cmp rcx, nullptr
+	je freeValueDictionary
+
+	mov rcx, [rcx].ValueDictionary.buckets
+	call free
+
+freeValueDictionary:
+	mov rcx, [rsp + shadowStorage]
+	mov rcx, [rcx].TreeMap.valueDictionary
+	call free
+
+	mov rcx, [rsp + shadowStorage]
+	mov rcx, [rcx].TreeMap.nodeArena
+	call free
+
+	mov rcx, [rsp + shadowStorage]
+	mov rcx, [rcx].TreeMap.spill
+	call free
+
+	mov rcx, [rsp + shadowStorage]
+	mov rcx, [rcx].TreeMap.changeStream
+	call free
+
 	; Free the treemap.
-	mov rcx, [rsp]
+	mov rcx, [rsp + shadowStorage]
 	call free
 
+	mov eax, success
+
 functionReturn:
-	add rsp, 2 * qwordSize
+	add rsp, shadowStorage + qwordSize
 	ret
 
 deleteTreeMap endp
@@ -184,6 +379,8 @@ deleteTreeMap endp
 
 ; Resets a treemap so that it's root is back to a nullptr and
 ; the count will be at 0. All nodes will be freed separately.
+; The spare treenodes kept for reuse are freed as well and the blocks of the payload arena,
+; the interned values and the chunks of the node arena are released at once.
 ;
 ; @RCX qword[in,out] - Pointer to the treemap that will be cleared.
 ;
@@ -191,22 +388,73 @@ deleteTreeMap endp
 clearTreeMap proc
 	
 	push rsi
+	sub rsp, shadowStorage
 
 	; Check if the treemap is a nullptr.
 	mov eax, treeMapNullptr
 	cmp rcx, nullptr
 	je functionReturn
 
-	; Free the tree nodes.
+	; A running checkpoint can't copy the pairs anymore.
 	mov rsi, rcx
+	call cancelCheckpoint
+
+	; Free the tree nodes.
 	mov rcx, [rsi].TreeMap.root
 	call freeTreeNodes
 
 	; Set the root to a nullptr.
 	mov [rsi].TreeMap.root, nullptr
+
+	; Spilled treenodes without nested memory were dropped without counting them.
+	mov rcx, [rsi].TreeMap.spill
+	cmp rcx, nullptr
+	je freeSpareTreeNodes
+
+	mov [rsi].TreeMap.nodeAmount, 0
+	mov [rcx].Spill.spilledAmount, 0
+	mov [rcx].Spill.fileEnd, 0
+
+freeSpareTreeNodes:
+
+	; Free all spare treenodes.
+	mov rcx, rsi
+	mov rdx, 0
+	call trimSpareTreeNodes
+
+	mov rcx, [rsi].TreeMap.payloadArena
+	call clearPayloadArena
+
+	mov rcx, [rsi].TreeMap.valueDictionary
+	call clearValueDictionary
+
+	mov rcx, [rsi].TreeMap.nodeArena
+	call clearNodeArena
+
 	mov eax, success
 
+	; The change stream and the log record that every pair is gone.
+	cmp [rsi].TreeMap.changeStream, nullptr
+	je logClear
+
+	mov rcx, rsi
+	mov edx, changeClearRecord
+	mov r8, nullptr
+	mov r9, nullptr
+	call recordChange
+
+logClear:
+	cmp [rsi].TreeMap.log, nullptr
+	je functionReturn
+
+	mov rcx, rsi
+	mov edx, logClearRecord
+	mov r8, nullptr
+	mov r9, nullptr
+	call recordLogChange
+
 functionReturn:
+	add rsp, shadowStorage
 	pop rsi
 	ret
 
@@ -220,13 +468,21 @@ clearTreeMap endp
 ; @RSI qword[in] - Pointer to the current treemap used.
 freeTreeNodes proc
 
-	; sub 16 bytes from the stack to keep beeing missaligned all
-	; the time and align on a 16 byte boundary before a free call.
-	sub rsp, 2 * qwordSize
+	; sub 24 bytes from the stack so that every recursive call
+	; starts with the same alignment and the calls below are aligned.
+	sub rsp, 3 * qwordSize
 
 	cmp rcx, nullptr
 	je functionReturn
 
+	; A spilled subtree is freed out of its records.
+	test cl, spilledLinkFlag
+	jz saveTreeNode
+
+	add rsp, 3 * qwordSize
+	jmp freeSpilledTreeNodes
+
+saveTreeNode:
 	; Save the current treenode on the stack.
 	mov [rsp], rcx
 	add rcx, [rsi].TreeMap.keySize
@@ -247,26 +503,33 @@ freeTreeNodes proc
 	mov rcx, [rcx]
 	call freeTreeNodes
 
-	; Align the stack and take memory away for the shadow space.
+	; Take memory away for the shadow space.
 	mov rcx, [rsp]
-	sub rsp, shadowStorage + qwordSize
+	sub rsp, shadowStorage
 
 	; If we have a free pair function call it for the node.
 	cmp [rsi].TreeMap.freePairFunc, nullptr
 	je freeNode
 
-	call [rsi].TreeMap.freePairFunc
+	callUserFunc [rsi].TreeMap.freePairFunc
 
 freeNode:
+	countTreeMapEvent rsi, frees
+
+	; Treenodes of a node arena are released with its chunks.
+	cmp [rsi].TreeMap.nodeArena, nullptr
+	jne treeNodeFreed
+
 	; Free the current tree nodes heap memory.
-	mov rcx, [rsp + shadowStorage + qwordSize]
+	mov rcx, [rsp + shadowStorage]
 	call free
 
-	add rsp, shadowStorage + qwordSize
+treeNodeFreed:
+	add rsp, shadowStorage
 	dec [rsi].TreeMap.nodeAmount
 
 functionReturn:
-	add rsp, 2 * qwordSize
+	add rsp, 3 * qwordSize
 	ret
 
 freeTreeNodes endp
@@ -285,6 +548,8 @@ putPair proc
 
 	push rsi
 	push rdi
+	push r12
+	push r13
 	sub rsp, shadowStorage + qwordSize
 
 	; Check if the given treemap is not a nullptr.
@@ -295,9 +560,27 @@ putPair proc
 	cmp rdx, nullptr
 	je treeNodePairInvalid
 
-	; Save the treemap and set the success status value.
+	; A running checkpoint copies the pair before it's replaced or remembers the new key.
+	cmp [rcx].TreeMap.checkpoint, nullptr
+	je insertPairOfTreeMap
+
+	mov r8, rdx
+	call preserveCheckpointPair
+
+insertPairOfTreeMap:
+	; Save the treemap, the pair and set the success status value.
+	; New treenodes get a deep copy of the pair.
 	mov rsi, rcx
+	mov r13, rdx
 	mov edi, success
+	lea r12, copyTreeNode
+
+	test [rsi].TreeMap.flags, inlinePairsFlag
+	jz insertTreeNode
+
+	lea r12, copyInlineTreeNode
+
+insertTreeNode:
 
 	; Add the current treemap on the stack and call insertPair.
 	; Also store the address to the status flag as a parameter.
@@ -305,15 +588,57 @@ putPair proc
 	call insertPair
 
 	; Update the root and turn is back to black.
+	; An empty treemap stays empty if the first insertion failed.
 	mov [rsi], rax
+	cmp rax, nullptr
+	je returnStatus
 
 	add rax, [rsi].TreeMap.keySize
 	add rax, [rsi].TreeMap.valueSize
 	add rax, 2 * qwordSize
 	mov byte ptr [rax], false
 
+	; Cold treenodes are spilled once the resident ones exceed the budget. The pair is inserted either way,
+	; a spill that fails only leaves more treenodes in memory. A running checkpoint doesn't fault treenodes in.
+	cmp [rsi].TreeMap.spill, nullptr
+	je returnStatus
+
+	cmp [rsi].TreeMap.checkpoint, nullptr
+	jne returnStatus
+
+	call spillColdTreeNodes
+
+returnStatus:
 	mov eax, edi
 
+	; The change stream and the log record the inserted pair, whose value follows the key.
+	cmp [rsi].TreeMap.changeStream, nullptr
+	je logInsertion
+
+	cmp eax, success
+	jne functionReturn
+
+	mov rcx, rsi
+	mov edx, changePutRecord
+	mov r8, r13
+	mov r9, r13
+	add r9, [rsi].TreeMap.keySize
+	call recordChange
+
+logInsertion:
+	cmp [rsi].TreeMap.log, nullptr
+	je functionReturn
+
+	cmp eax, success
+	jne functionReturn
+
+	mov rcx, rsi
+	mov edx, logPutRecord
+	mov r8, r13
+	mov r9, r13
+	add r9, [rsi].TreeMap.keySize
+	call recordLogChange
+
 	jmp functionReturn
 
 treeMapInvalid:
@@ -326,6 +651,8 @@ treeNodePairInvalid:
 
 functionReturn:
 	add rsp, shadowStorage + qwordSize
+	pop r13
+	pop r12
 	pop rdi
 	pop rsi
 	ret
@@ -340,6 +667,7 @@ putPair endp
 ; @RSI qword[in,out] - A pointer to the current treemap.
 ; @RDI dword[out] - The function gets the code with a success value and will
 ;				   on failure turn it into a alreadyContains, errHeapAllocation or copy function value.
+; @R12 qword[in] - Pointer to the function that creates the treenode holding the inserted pair.
 ;
 ; @return The currently modified treenode.
 insertPair proc
@@ -353,13 +681,28 @@ insertPair proc
 	mov [rbp + currentTreeNode], rcx
 	mov [rbp + toInsertValuePair], rdx
 
+	; A spilled treenode is faulted back in before its key is compared.
+	cmp [rsi].TreeMap.spill, nullptr
+	je compareTreeNode
+
+	lea rcx, [rbp + currentTreeNode]
+	call faultSpilledLink
+
+	cmp eax, success
+	jne keepSpilledTreeNode
+
+	mov rcx, [rbp + currentTreeNode]
+	mov rdx, [rbp + toInsertValuePair]
+
+compareTreeNode:
 	; Check if the current treenode is a nullptr.
 	cmp rcx, nullptr
 	je createTreeNode
 
 	; Compare the given key with the treenode currently selected.
 	; rcx holds the current treenode and rdx the pointer to the key to insert.
-	call [rsi].TreeMap.compareKeyFunc
+	countTreeMapEvent rsi, comparisons
+	callUserFunc [rsi].TreeMap.compareKeyFunc
 
 	; Preload the current treemap and the node before checking
 	; the comparison result.
@@ -370,14 +713,23 @@ insertPair proc
 	; Compare the result of the compare key function
 	; If both keys are equal return immediately.
 	cmp al, 0
-	je containsTreeNode
+	jne continueSearch
+
+	; A multimap inserts equal keys to the right
+	; so that they keep their insertion order.
+	test [rsi].TreeMap.flags, multiMapFlag
+	jz containsTreeNode
 
+	mov al, 1
+
+continueSearch:
 	mov rdx, [rbp + toInsertValuePair]
 
 	; Save the address of the current tree node that points to the left
 	; child node.
 	mov [rbp + leftTreeNode], rcx
 	
+	cmp al, 0
 	jg continueRight
 
 continueLeft:
@@ -411,47 +763,27 @@ changeTreeChildAndFixTree:
 containsTreeNode:
 	mov edi, dword ptr alreadyContains
 
+	jmp returnRax
+
+keepSpilledTreeNode:
+	; The pair isn't inserted and the link stays spilled.
+	mov edi, eax
+
 returnRax:
 	mov rax, [rbp + currentTreeNode]
 
 	jmp functionReturn
 
 createTreeNode:
-	 ; Adding sizes together for malloc.
-	 xor rcx, rcx
-	 add rcx, [rsi].TreeMap.keySize
-	 add rcx, [rsi].TreeMap.valueSize
-	 add rcx, sizeof TreeNode
-
-	 ; Reserve heap memory for a new TreeNode.
-	 call malloc
+	 ; Let the function in r12 create the treenode with the pair.
+	 ; On failure it already changed the status.
+	 call r12
 	 cmp rax, nullptr
-	 je handleAllocationError
+	 je functionReturn
 
 	 ; Replace nullptr with new treenode.
 	 mov [rbp + currentTreeNode], rax
 
-	 ; Initialise the key of the node 
-	 mov rcx, rax
-	 mov rdx, [rbp + toInsertValuePair]
-	 call [rsi].TreeMap.copyKeyFunc
-
-	 ; Compare copy key function result for success.
-	 cmp eax, success
-	 jne handleCopyKeyError
-
-	 ; Initialise the value of the node.
-	 mov rcx, [rbp + currentTreeNode]
-	 mov rdx, [rbp + toInsertValuePair]
-	 add rcx, [rsi].TreeMap.keySize
-	 add rdx, [rsi].TreeMap.keySize
-	 mov r8B, false
-	 call [rsi].TreeMap.copyValueFunc
-
-	 ; Compare copy value function result for success.
-	 cmp eax, success
-	 jne handleCopyValueError
-
 	 ; Mov the address of the treenode to the child pointers.
 	 mov rcx, [rbp + currentTreeNode]
 	 add rcx, [rsi].TreeMap.keySize
@@ -468,11 +800,91 @@ createTreeNode:
 	 ; Set node color to red
 	 mov byte ptr [rcx], true
 
+	 ; Without children the hash of the subtree is the one of the pair.
+	 cmp [rsi].TreeMap.hashPairFunc, nullptr
+	 je countTreeNode
+
+	 mov rcx, [rbp + currentTreeNode]
+	 call hashTreeNodes
+
+countTreeNode:
 	 ; Increase nodeAmount and return the created node.
 	 inc [rsi].TreeMap.nodeAmount
 	 mov rax, [rbp + currentTreeNode]
 
-	 jmp functionReturn
+functionReturn:
+	 mov rsp, rbp
+	 pop rbp
+	 ret
+
+insertPair endp
+
+
+; Creates a treenode for insertPair that holds a deep copy of the given pair.
+;
+; @RDX qword[in] - Pointer to the key value pair that is copied into the treenode.
+; @RSI qword[in,out] - Pointer to the current treemap.
+; @RDI dword[out] - Status value that is changed to errHeapAllocation or a copy function error on failure.
+;
+; @return The created treenode or a nullptr on failure.
+copyTreeNode proc
+
+	push rbp
+	mov rbp, rsp
+	sub rsp, shadowStorage
+
+	mov [rbp + toInsertValuePair], rdx
+
+	; Get the memory for the new treenode.
+	call acquireTreeNode
+	cmp rax, nullptr
+	je handleAllocationError
+
+	mov [rbp + currentTreeNode], rax
+
+	; Initialise the key of the node, the copy functions
+	; get the treemap because the copies are stored inside of it.
+	mov rcx, rax
+	mov rdx, [rbp + toInsertValuePair]
+	mov r8, rsi
+	callUserFunc [rsi].TreeMap.copyKeyFunc
+
+	; Compare copy key function result for success.
+	cmp eax, success
+	jne handleCopyKeyError
+
+	; Initialise the value of the node.
+	mov rcx, [rbp + currentTreeNode]
+	mov rdx, [rbp + toInsertValuePair]
+	add rcx, [rsi].TreeMap.keySize
+	add rdx, [rsi].TreeMap.keySize
+
+	; With a value dictionary the node only holds the ID of the interned value.
+	cmp [rsi].TreeMap.valueDictionary, nullptr
+	jne internNodeValue
+
+	mov r8B, false
+	mov r9, rsi
+	callUserFunc [rsi].TreeMap.copyValueFunc
+
+	; Compare copy value function result for success.
+	cmp eax, success
+	jne handleCopyValueError
+
+	mov rax, [rbp + currentTreeNode]
+
+	jmp functionReturn
+
+internNodeValue:
+	call internValue
+
+	mov edi, eax
+	cmp eax, success
+	jne releaseNode
+
+	mov rax, [rbp + currentTreeNode]
+
+	jmp functionReturn
 
 handleAllocationError:
 	mov edi, errHeapAllocation
@@ -482,42 +894,383 @@ handleAllocationError:
 handleCopyKeyError:
 	mov edi, errCopyKeyFunc
 
-	jmp freeTreeNode
+	jmp releaseNode
 
 handleCopyValueError:
 	mov edi, errCopyValueFunc
 
-	jmp freeTreeNode
-
-freeTreeNode:
-	mov rax, [rbp + currentTreeNode]
-	call free
+releaseNode:
+	mov rcx, [rbp + currentTreeNode]
+	call releaseTreeNode
 	mov rax, nullptr
 
 functionReturn:
-	 mov rsp, rbp
-	 pop rbp
-	 ret
+	mov rsp, rbp
+	pop rbp
+	ret
 
-insertPair endp
+copyTreeNode endp
 
 
-; Balances a redblack tree after an insertion/deletion has been done.
-; The function does the following tests/fixes in order:
-; 1. Left rotation.
-; 2. Right rotation.
-; 3. Flipping of the calling treenodes color and it's children with the flag set to true for insertion.
+; Creates a treenode for insertPair that takes over the bytes of the given pair.
+; No copy functions are called, the pair is moved into the treenode as it is.
 ;
-; The function assumes a previous shadowstorage from another function call
-; and a rbp register that is used to index this storage with a base offset of 16 bytes.
-; 
-; @RSI qword[in] - Pointer to the treemap whose tree is balanced.
-; @Stack qword[in,out] - Pointer to the currently evaluated treenode.
-; @Stack qword[in,out] - Pointer to the left child of the treenode.
-; @Stack qword[in,out] - Pointer to the right child of the treenode.
-; 
-; @returns Nothing, but holds the treenode in @RCX, the treemap in @RDX, the left child node in @R8
-;		   and the right child node in @R9 when this function call is finished.
+; @RDX qword[in] - Pointer to the key value pair that is moved into the treenode.
+; @RSI qword[in,out] - Pointer to the current treemap.
+; @RDI dword[out] - Status value that is changed to errHeapAllocation on failure.
+;
+; @return The created treenode or a nullptr on failure.
+moveTreeNode proc
+
+	push rbp
+	mov rbp, rsp
+	sub rsp, shadowStorage
+
+	mov [rbp + toInsertValuePair], rdx
+
+	; Get the memory for the new treenode.
+	call acquireTreeNode
+	cmp rax, nullptr
+	je handleAllocationError
+
+	; Move the pair into the treenode.
+	mov [rbp + currentTreeNode], rax
+	mov rcx, rax
+	mov rdx, [rbp + toInsertValuePair]
+	mov r8, [rsi].TreeMap.keySize
+	add r8, [rsi].TreeMap.valueSize
+	call memcpy
+
+	mov rax, [rbp + currentTreeNode]
+
+	jmp functionReturn
+
+handleAllocationError:
+	mov edi, errHeapAllocation
+
+functionReturn:
+	mov rsp, rbp
+	pop rbp
+	ret
+
+moveTreeNode endp
+
+
+; Creates a treenode for insertPair that stores the bytes of the given inline pair
+; behind its links. Key, value and treenode share a single allocation
+; and no copy functions are called.
+;
+; @RDX qword[in] - Pointer to the InlineData of the key followed by the one of the value.
+; @RSI qword[in,out] - Pointer to the current treemap.
+; @RDI dword[out] - Status value that is changed to errHeapAllocation on failure.
+;
+; @return The created treenode or a nullptr on failure.
+copyInlineTreeNode proc
+
+	push rbp
+	mov rbp, rsp
+	sub rsp, shadowStorage
+
+	mov [rbp + toInsertValuePair], rdx
+
+	; The treenode needs room for the bytes of the key and the value.
+	mov rcx, [rdx].InlineData.byteAmount
+	add rdx, [rsi].TreeMap.keySize
+	add rcx, [rdx].InlineData.byteAmount
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	add rcx, sizeof TreeNode
+	countTreeMapEvent rsi, allocations
+	call malloc
+
+	cmp rax, nullptr
+	je handleAllocationError
+
+	mov [rbp + currentTreeNode], rax
+
+	; Point the key at the bytes behind the links and copy them.
+	mov rcx, rax
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	add rcx, sizeof TreeNode
+	mov rdx, [rbp + toInsertValuePair]
+	mov r8, [rdx].InlineData.byteAmount
+	mov [rax].InlineData.bytes, rcx
+	mov [rax].InlineData.byteAmount, r8
+	mov rdx, [rdx].InlineData.bytes
+	call memcpy
+
+	; The bytes of the value follow the ones of the key.
+	mov r9, [rbp + currentTreeNode]
+	mov rcx, [r9].InlineData.bytes
+	add rcx, [r9].InlineData.byteAmount
+	add r9, [rsi].TreeMap.keySize
+	mov rdx, [rbp + toInsertValuePair]
+	add rdx, [rsi].TreeMap.keySize
+	mov r8, [rdx].InlineData.byteAmount
+	mov [r9].InlineData.bytes, rcx
+	mov [r9].InlineData.byteAmount, r8
+	mov rdx, [rdx].InlineData.bytes
+	call memcpy
+
+	mov rax, [rbp + currentTreeNode]
+
+	jmp functionReturn
+
+handleAllocationError:
+	mov edi, errHeapAllocation
+
+functionReturn:
+	mov rsp, rbp
+	pop rbp
+	ret
+
+copyInlineTreeNode endp
+
+
+; Hands an already created treenode to insertPair.
+;
+; @RDX qword[in] - Pointer to the treenode that is linked into the tree.
+;
+; @return The given treenode.
+adoptTreeNode proc
+
+	mov rax, rdx
+	ret
+
+adoptTreeNode endp
+
+
+; Gets the memory for a treenode. The most recently released spare treenode of the treemap
+; is taken if one exists, otherwise a new treenode is taken from the node arena or allocated.
+;
+; @RSI qword[in,out] - Pointer to the current treemap.
+;
+; @return The treenode or a nullptr if the allocation failed.
+acquireTreeNode proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	; A treenode is linked into the tree.
+	inc [rsi].TreeMap.modificationCount
+
+	; Take the first spare treenode if there is one, it links the next one.
+	mov rax, [rsi].TreeMap.spareTreeNode
+	cmp rax, nullptr
+	je allocateTreeNode
+
+	mov rcx, [rax]
+	mov [rsi].TreeMap.spareTreeNode, rcx
+	dec [rsi].TreeMap.spareAmount
+
+	jmp functionReturn
+
+allocateTreeNode:
+	countTreeMapEvent rsi, allocations
+
+	cmp [rsi].TreeMap.nodeArena, nullptr
+	je mallocTreeNode
+
+	call takeArenaTreeNode
+
+	jmp functionReturn
+
+mallocTreeNode:
+	; Adding sizes together for malloc.
+	mov rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	add rcx, sizeof TreeNode
+
+	; The hashes follow the links.
+	cmp [rsi].TreeMap.hashPairFunc, nullptr
+	je allocateMemory
+
+	add rcx, sizeof NodeHash
+
+allocateMemory:
+	; Reserve heap memory for a new TreeNode.
+	call malloc
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	ret
+
+acquireTreeNode endp
+
+
+; Gives back the memory of a treenode that is no longer part of the tree.
+; The treenode is linked in front of the spare treenodes of the treemap while their limit
+; isn't reached, so that the next insertion reuses it while it's still cached. Otherwise it is freed.
+; Treenodes of a node arena are put on its free list instead, unless the arena is compacted.
+; Treenodes with inline pairs differ in size and are always freed.
+;
+; @RCX qword[in,out] - Pointer to the treenode that is released.
+; @RSI qword[in,out] - Pointer to the current treemap.
+releaseTreeNode proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	; A treenode was unlinked from the tree.
+	inc [rsi].TreeMap.modificationCount
+
+	test [rsi].TreeMap.flags, inlinePairsFlag
+	jnz freeTreeNode
+
+	; Link the treenode in front of the free list of the node arena.
+	mov rax, [rsi].TreeMap.nodeArena
+	cmp rax, nullptr
+	je keepSpareTreeNode
+
+	countTreeMapEvent rsi, frees
+
+	; Treenodes released during a compaction are left inside their chunk.
+	cmp [rax].NodeArena.compaction, nullptr
+	jne dropTreeNode
+
+	mov rdx, [rax].NodeArena.freeNodes
+	mov [rcx], rdx
+	mov [rax].NodeArena.freeNodes, rcx
+	inc [rax].NodeArena.freeNodeAmount
+
+	jmp functionReturn
+
+keepSpareTreeNode:
+	; Keep the treenode if the limit of spare treenodes isn't reached.
+	mov rax, [rsi].TreeMap.spareAmount
+	cmp rax, [rsi].TreeMap.spareLimit
+	jae freeTreeNode
+
+	mov rdx, [rsi].TreeMap.spareTreeNode
+	mov [rcx], rdx
+	mov [rsi].TreeMap.spareTreeNode, rcx
+	inc [rsi].TreeMap.spareAmount
+
+	jmp functionReturn
+
+dropTreeNode:
+	mov rdx, rax
+	call dropCompactedTreeNode
+
+	jmp functionReturn
+
+freeTreeNode:
+	countTreeMapEvent rsi, frees
+	call free
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	ret
+
+releaseTreeNode endp
+
+
+; Hands over the pair of a treenode that is unlinked by a delete function and releases the treenode.
+; Without a buffer nested heap memory of the pair is freed, otherwise the pair is shallow copied into it.
+; Inline pairs can't be shallow copied because their bytes belong to the treenode, so the treenode itself
+; is stored inside the buffer and executeDelete copies the pair out of it before it's released.
+; With a value dictionary the buffer receives the ID of the value, which the public delete functions resolve.
+;
+; @RCX qword[in,out] - Pointer to the treenode that is unlinked.
+; @RDX qword[out] - Pointer to the buffer that receives the pair or a nullptr.
+; @RSI qword[in,out] - Pointer to the current treemap.
+handOverTreeNode proc
+
+	push rbx
+	sub rsp, shadowStorage
+
+	mov rbx, rcx
+
+	; Check if a buffer was provided.
+	cmp rdx, nullptr
+	jne copyIntoBuffer
+
+	; If not free nested heap memory.
+	call disposeTreeNodePair
+
+	jmp releaseNode
+
+copyIntoBuffer:
+	test [rsi].TreeMap.flags, inlinePairsFlag
+	jz shallowCopy
+
+	; Keep the inline treenode for executeDelete.
+	mov [rdx], rbx
+
+	jmp functionReturn
+
+shallowCopy:
+	; Shallow copy the treenode that will be deleted.
+	; Heap memory doesn't need to be freed this way.
+	mov rcx, rdx
+	mov rdx, rbx
+	mov r8, [rsi].TreeMap.keySize
+	add r8, [rsi].TreeMap.valueSize
+	call memcpy
+
+releaseNode:
+	; Release the treenode so its memory can be reused.
+	mov rcx, rbx
+	call releaseTreeNode
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rbx
+	ret
+
+handOverTreeNode endp
+
+
+; Frees the nested heap memory of a treenodes pair with the free pair function
+; and drops the reference to its value if the treemap has a value dictionary.
+;
+; @RCX qword[in,out] - Pointer to the treenode whose pair is disposed.
+; @RSI qword[in,out] - Pointer to the current treemap.
+disposeTreeNodePair proc
+
+	push rbx
+	sub rsp, shadowStorage
+
+	mov rbx, rcx
+
+	; Check if we have nested heap memory.
+	cmp [rsi].TreeMap.freePairFunc, nullptr
+	je releaseValue
+
+	callUserFunc [rsi].TreeMap.freePairFunc
+
+releaseValue:
+	cmp [rsi].TreeMap.valueDictionary, nullptr
+	je functionReturn
+
+	mov rcx, rbx
+	add rcx, [rsi].TreeMap.keySize
+	mov rcx, [rcx]
+	call releaseDictionaryValue
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rbx
+	ret
+
+disposeTreeNodePair endp
+
+
+; Balances a redblack tree after an insertion/deletion has been done.
+; The function does the following tests/fixes in order:
+; 1. Left rotation.
+; 2. Right rotation.
+; 3. Flipping of the calling treenodes color and it's children with the flag set to true for insertion.
+;
+; The function assumes a previous shadowstorage from another function call
+; and a rbp register that is used to index this storage with a base offset of 16 bytes.
+; 
+; @RSI qword[in] - Pointer to the treemap whose tree is balanced.
+; @Stack qword[in,out] - Pointer to the currently evaluated treenode.
+; @Stack qword[in,out] - Pointer to the left child of the treenode.
+; @Stack qword[in,out] - Pointer to the right child of the treenode.
+; 
+; @returns Nothing, but holds the treenode in @RCX, the treemap in @RDX, the left child node in @R8
+;		   and the right child node in @R9 when this function call is finished.
 balance proc
 
 	; In case we went left, restore rcx
@@ -531,6 +1284,16 @@ balance proc
 	mov rcx, [rcx]
 	mov [rbp + rightTreeNode], rcx
 
+	; The children are final, so the hash of the subtree is summed up again.
+	cmp [rsi].TreeMap.hashPairFunc, nullptr
+	je testLeftRotation
+
+	mov rcx, [rbp + currentTreeNode]
+	call rehashTreeNode
+
+	mov rcx, [rbp + rightTreeNode]
+
+testLeftRotation:
 	; Fetch the right child node and
 	; check if it is red.
 	call isRed
@@ -642,6 +1405,9 @@ balance endp
 ; @return The rotated tree node, meaning the right nodes address of rdx.
 rotateLeft proc
 
+	inc [rsi].TreeMap.modificationCount
+	countTreeMapEvent rsi, rotations
+
 	; Save the right child of the current tree node into rax as ret.
 	; Save the current tree node evaluated into r10.
 	mov rax, rcx
@@ -679,6 +1445,17 @@ rotateLeft proc
 	; Set the currently evaluated tree nodes color to red.
 	mov byte ptr [r10], true
 
+	; The rotated treenode takes over the hash of the subtree
+	; and the current one sums up its new children.
+	cmp [rsi].TreeMap.hashPairFunc, nullptr
+	je functionReturn
+
+	mov rdx, [r10 + qwordSize].NodeHash.subtreeHash
+	mov [rcx + qwordSize].NodeHash.subtreeHash, rdx
+	mov rcx, r8
+	call rehashTreeNode
+
+functionReturn:
 	ret
 
 rotateLeft endp
@@ -695,6 +1472,9 @@ rotateLeft endp
 ; @return The rotated tree node, meaning the left nodes address of rdx.
 rotateRight proc
 
+	inc [rsi].TreeMap.modificationCount
+	countTreeMapEvent rsi, rotations
+
 	; Save the left child of the currently evaluated tree node
 	; as the return value + store the current tree node.
 	mov rax, rcx
@@ -732,6 +1512,17 @@ rotateRight proc
 	; Set the color of the tree node evaluated to red.
 	mov byte ptr [r10], true
 
+	; The rotated treenode takes over the hash of the subtree
+	; and the current one sums up its new children.
+	cmp [rsi].TreeMap.hashPairFunc, nullptr
+	je functionReturn
+
+	mov rdx, [r10 + qwordSize].NodeHash.subtreeHash
+	mov [rcx + qwordSize].NodeHash.subtreeHash, rdx
+	mov rcx, r8
+	call rehashTreeNode
+
+functionReturn:
 	ret
 
 rotateRight endp
@@ -749,7 +1540,9 @@ rotateRight endp
 ;				  True changes the children to black and the calling node to red (insertion).
 ;				  False changes the children to red and the calling node to black (deletion).
 flip proc
-	
+
+	countTreeMapEvent rsi, flips
+
 	; Offset the current tree node address to access its red flag.
 	add rcx, [rsi].TreeMap.keySize
 	add rcx, [rsi].TreeMap.valueSize
@@ -789,13 +1582,19 @@ isRed proc
 	; Check if the treenode is a nullptr.
 	cmp rcx, nullptr
 	je functionReturn
+
+	; A spilled link always leads to a black treenode, red ones are faulted in with their parent.
+	test cl, spilledLinkFlag
+	jnz functionReturn
 	
 	; Move to the red flag and test if it is red.
+	; The access bit of a budget shares the byte with it.
 	add rcx, [rsi].TreeMap.keySize
 	add rcx, [rsi].TreeMap.valueSize
 	add rcx, 2 * qwordSize
 
 	mov al, byte ptr [rcx]
+	and al, true
 	jmp functionReturn
 
 functionReturn:
@@ -807,6 +1606,7 @@ isRed endp
 	public deletePair
 
 ; Removes the key value pair inside the specified treemap that matches the given key.
+; Inside a multimap the oldest pair with the key is removed.
 ;
 ; @RCX qword[in,out] - Pointer to the treemap that gets a specific pair deleted.
 ; @RDX qword[in] - Pointer to the key that is used to identify the pair to delete.
@@ -818,99 +1618,771 @@ deletePair proc
 
 	push rbp
 	mov rbp, rsp
+	push r14
+	sub rsp, shadowStorage + qwordSize
 	
 	; Check if the treemap is not a nullptr.
 	cmp rcx, nullptr
 	je treeMapInvalid
 
+	; Keep the treemap and the buffer to resolve an interned value and the key for the change stream.
+	mov [rbp + deletionTreeMap], rcx
+	mov [rbp + deletionKey], rdx
+	mov [rbp + deletionPairBuffer], r8
+
+	; A running checkpoint copies the pair before it's deleted.
+	cmp [rcx].TreeMap.checkpoint, nullptr
+	je checkMultiMap
+
+	mov r8, nullptr
+	call preserveCheckpointPair
+
+	mov rcx, [rbp + deletionTreeMap]
+	mov rdx, [rbp + deletionKey]
+	mov r8, [rbp + deletionPairBuffer]
+
+checkMultiMap:
+	; Only a multimap needs to know the treenode to delete.
+	xor r14, r14
+	test [rcx].TreeMap.flags, multiMapFlag
+	jz allocateCopySpace
+
+	; Search the treenode of the oldest pair with the key.
+	; The treemap and the key are preserved by findAddressOfKey.
+	mov [rsp + shadowStorage], r8
+	mov r8, rcx
+	mov rcx, [r8].TreeMap.root
+	call findAddressOfKey
+
+	cmp rax, nullptr
+	je deleteContainsFailure
+
+	mov r14, rax
+	mov rcx, r8
+	mov r8, [rsp + shadowStorage]
+
+allocateCopySpace:
 	; Allocate stack memory as a temporary copy space
 	; for the deletion later on.
 	sub rsp, [rcx].TreeMap.keySize
 	sub rsp, [rcx].TreeMap.valueSize
 	and rsp, -16
 
-	lea r9, delete
-	call executeDelete
+	lea r9, delete
+	call executeDelete
+
+	mov r8d, eax
+	mov rcx, [rbp + deletionTreeMap]
+	mov rdx, [rbp + deletionPairBuffer]
+	call takeDeletedValue
+
+	; The change stream and the log record the key of the deleted pair.
+	mov rcx, [rbp + deletionTreeMap]
+	cmp [rcx].TreeMap.changeStream, nullptr
+	je logDeletion
+
+	cmp eax, success
+	jne functionReturn
+
+	mov edx, changeDeleteRecord
+	mov r8, [rbp + deletionKey]
+	mov r9, nullptr
+	call recordChange
+
+logDeletion:
+	mov rcx, [rbp + deletionTreeMap]
+	cmp [rcx].TreeMap.log, nullptr
+	je functionReturn
+
+	cmp eax, success
+	jne functionReturn
+
+	mov edx, logDeleteRecord
+	mov r8, [rbp + deletionKey]
+	mov r9, nullptr
+	call recordLogChange
+
+	jmp functionReturn
+
+deleteContainsFailure:
+	mov eax, doesNotContain
+
+	jmp functionReturn
+
+treeMapInvalid:
+	mov eax, treeMapNullptr
+
+functionReturn:
+	lea rsp, [rbp - qwordSize]
+	pop r14
+	pop rbp
+	ret
+
+deletePair endp
+
+
+	public pollFirstPair
+
+; Deletes the minimum key value pair of the given treemap.
+;
+; @RCX qword[in,out] - Pointer to the treemap whose min pair will be deleted.
+; @RDX qword[out] - Pointer to a buffer of a treenode thats used to copy the deleted min pair.
+;
+; @returns A status flag of success, doesNotContain if no min key value pair exists or
+; a treeMapNullptr error if the given treemap is a nullptr.
+pollFirstPair proc
+
+	push rbp
+	mov rbp, rsp
+	sub rsp, shadowStorage
+
+	; Check if the treemap is not a nullptr.
+	cmp rcx, nullptr
+	je treeMapInvalid
+
+	mov [rbp + deletionTreeMap], rcx
+	mov [rbp + pollPairBuffer], rdx
+
+	; A running checkpoint copies the pair before it's deleted. The key is a nullptr,
+	; so that the minimum key is searched instead of the content of the buffer.
+	cmp [rcx].TreeMap.checkpoint, nullptr
+	je deleteTreeNode
+
+	mov rdx, nullptr
+	mov r8, nullptr
+	mov r9b, searchAsLower
+	call preserveCheckpointPair
+
+	mov rcx, [rbp + deletionTreeMap]
+	mov rdx, [rbp + pollPairBuffer]
+
+deleteTreeNode:
+	mov r8, rdx
+	lea r9, deleteMin
+	call executeDelete
+
+	; Resolve an interned value inside the buffer.
+	mov r8d, eax
+	mov rcx, [rbp + deletionTreeMap]
+	mov rdx, [rbp + pollPairBuffer]
+	call takeDeletedValue
+
+	; The change stream and the log record the kind only, because replaying it deletes the same pair.
+	mov rcx, [rbp + deletionTreeMap]
+	cmp [rcx].TreeMap.changeStream, nullptr
+	je logPoll
+
+	cmp eax, success
+	jne functionReturn
+
+	mov edx, changePollFirstRecord
+	mov r8, nullptr
+	mov r9, nullptr
+	call recordChange
+
+logPoll:
+	mov rcx, [rbp + deletionTreeMap]
+	cmp [rcx].TreeMap.log, nullptr
+	je functionReturn
+
+	cmp eax, success
+	jne functionReturn
+
+	mov edx, logPollFirstRecord
+	mov r8, nullptr
+	mov r9, nullptr
+	call recordLogChange
+
+	jmp functionReturn
+
+treeMapInvalid:
+	mov eax, treeMapNullptr
+
+functionReturn:
+	mov rsp, rbp
+	pop rbp
+	ret
+
+pollFirstPair endp
+
+
+	public pollLastPair
+
+; Deletes the maximum key value pair of the given treemap.
+;
+; @RCX qword[in,out] - Pointer to the treemap whose max pair will be deleted.
+; @RDX qword[out] - Pointer to a buffer of a treenode thats used to copy the deleted max pair.
+;
+; @returns A status flag of success, doesNotContain if no max key value pair exists or
+; a treeMapNullptr error if the given treemap is a nullptr.
+pollLastPair proc
+
+	push rbp
+	mov rbp, rsp
+	sub rsp, shadowStorage
+
+	; Check if the treemap is not a nullptr.
+	cmp rcx, nullptr
+	je treeMapInvalid
+
+	mov [rbp + deletionTreeMap], rcx
+	mov [rbp + pollPairBuffer], rdx
+
+	; A running checkpoint copies the pair before it's deleted. The key is a nullptr,
+	; so that the maximum key is searched instead of the content of the buffer.
+	cmp [rcx].TreeMap.checkpoint, nullptr
+	je deleteTreeNode
+
+	mov rdx, nullptr
+	mov r8, nullptr
+	mov r9b, searchAsHigher
+	call preserveCheckpointPair
+
+	mov rcx, [rbp + deletionTreeMap]
+	mov rdx, [rbp + pollPairBuffer]
+
+deleteTreeNode:
+	mov r8, rdx
+	lea r9, deleteMax
+	call executeDelete
+
+	; Resolve an interned value inside the buffer.
+	mov r8d, eax
+	mov rcx, [rbp + deletionTreeMap]
+	mov rdx, [rbp + pollPairBuffer]
+	call takeDeletedValue
+
+	; The change stream and the log record the kind only, because replaying it deletes the same pair.
+	mov rcx, [rbp + deletionTreeMap]
+	cmp [rcx].TreeMap.changeStream, nullptr
+	je logPoll
+
+	cmp eax, success
+	jne functionReturn
+
+	mov edx, changePollLastRecord
+	mov r8, nullptr
+	mov r9, nullptr
+	call recordChange
+
+logPoll:
+	mov rcx, [rbp + deletionTreeMap]
+	cmp [rcx].TreeMap.log, nullptr
+	je functionReturn
+
+	cmp eax, success
+	jne functionReturn
+
+	mov edx, logPollLastRecord
+	mov r8, nullptr
+	mov r9, nullptr
+	call recordLogChange
+
+	jmp functionReturn
+
+treeMapInvalid:
+	mov eax, treeMapNullptr
+
+functionReturn:
+	mov rsp, rbp
+	pop rbp
+	ret
+
+pollLastPair endp
+
+
+	public rekeyPair
+
+; Changes the key of a key value pair without allocating a new treenode.
+; If the new key keeps the order to the lower and higher pair of the old key
+; the key is replaced inside the treenode. Otherwise the pair is unlinked and
+; relinked at the position of the new key, reusing the released treenode.
+;
+; @RCX qword[in,out] - Pointer to the treemap that holds the pair.
+; @RDX qword[in] - Pointer to the key that identifies the pair.
+; @R8 qword[in] - Pointer to the new key that is deep copied into the pair.
+; @R9 qword[out] - Pointer to a buffer that receives a shallow copy of the old key.
+;
+; Inside a multimap the oldest pair with the old key is always relinked, its new position is
+; after the pairs that already have the new key.
+;
+; Inline pairs are always relinked inside a new treenode because the length of the key can change.
+; The buffer receives a deep copy of the old key made by the key copy function.
+;
+; @returns A status flag of success, doesNotContain if the old key is not found, alreadyContains
+;		   if the new key belongs to another pair, errCopyKeyFunc if the key copy function fails
+;		   or an error if the treemap or key buffer is a nullptr.
+rekeyPair proc
+
+	push rbp
+	mov rbp, rsp
+	push rsi
+	push rdi
+	push r12
+	push r14
+	sub rsp, shadowStorage + 2 * qwordSize
+
+	; Check if the treemap is not a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the key buffer is not a nullptr.
+	mov eax, keyBufferNullptr
+	cmp r9, nullptr
+	je functionReturn
+
+	; A running checkpoint copies the pairs of both keys before they change.
+	cmp [rcx].TreeMap.checkpoint, nullptr
+	je saveParameters
+
+	call preserveCheckpointRekey
+
+saveParameters:
+	; Save the treemap and the parameters.
+	mov rsi, rcx
+	mov [rbp + oldKey], rdx
+	mov [rbp + newKey], r8
+	mov [rbp + rekeyBuffer], r9
+
+	; Spilled treenodes around both keys are faulted back in before they are searched.
+	mov rcx, rsi
+	call faultSpilledPath
+
+	cmp eax, success
+	jne functionReturn
+
+	mov rdx, r8
+	call faultSpilledPath
+
+	cmp eax, success
+	jne functionReturn
+
+	; Search the treenode of the old key.
+	mov rcx, [rsi].TreeMap.root
+	mov rdx, [rbp + oldKey]
+	mov r8, rsi
+	call findAddressOfKey
+
+	cmp rax, nullptr
+	je rekeyContainsFailure
+
+	mov [rbp + rekeyNode], rax
+
+	; A multimap always relinks the pair, otherwise the pair
+	; could end up in front of older pairs with the same key.
+	test [rsi].TreeMap.flags, multiMapFlag
+	jnz allocateRelinkSpace
+
+	; Inline pairs can't store a new key in place.
+	test [rsi].TreeMap.flags, inlinePairsFlag
+	jnz relinkTreeNode
+
+	; The new key has to be bigger than the lower key
+	; so that the treenode can keep its position.
+	mov rcx, rsi
+	mov rdx, [rbp + oldKey]
+	mov r9B, searchAsLower
+	call findLowerHigherNode
+
+	cmp rax, nullptr
+	je testHigherNode
+
+	mov rcx, rax
+	mov rdx, [rbp + newKey]
+	countTreeMapEvent rsi, comparisons
+	callUserFunc [rsi].TreeMap.compareKeyFunc
+
+	cmp eax, 0
+	jle relinkTreeNode
+
+testHigherNode:
+	; The same applies for the higher key that
+	; has to be bigger than the new key.
+	mov rcx, rsi
+	mov rdx, [rbp + oldKey]
+	mov r9B, searchAsHigher
+	call findLowerHigherNode
+
+	cmp rax, nullptr
+	je replaceKeyInPlace
+
+	mov rcx, rax
+	mov rdx, [rbp + newKey]
+	countTreeMapEvent rsi, comparisons
+	callUserFunc [rsi].TreeMap.compareKeyFunc
+
+	cmp eax, 0
+	jge relinkTreeNode
+
+replaceKeyInPlace:
+	; Shallow copy the old key into the buffer.
+	mov rcx, [rbp + rekeyBuffer]
+	mov rdx, [rbp + rekeyNode]
+	mov r8, [rsi].TreeMap.keySize
+	call memcpy
+
+	; Deep copy the new key into the treenode.
+	mov rcx, [rbp + rekeyNode]
+	mov rdx, [rbp + newKey]
+	mov r8, rsi
+	callUserFunc [rsi].TreeMap.copyKeyFunc
+
+	cmp eax, success
+	jne restoreOldKey
+
+	; The subtrees above the treenode change with the hash of its pair.
+	cmp [rsi].TreeMap.hashPairFunc, nullptr
+	je recordRekey
+
+	mov rcx, rsi
+	mov rdx, [rbp + rekeyNode]
+	call updateTreeNodeHash
+
+	mov eax, success
+
+	jmp recordRekey
+
+restoreOldKey:
+	; Put the old key back if the copy failed.
+	mov rcx, [rbp + rekeyNode]
+	mov rdx, [rbp + rekeyBuffer]
+	mov r8, [rsi].TreeMap.keySize
+	call memcpy
+
+	jmp copyKeyFailure
+
+relinkTreeNode:
+	; The new key must not belong to another pair.
+	mov rcx, [rsi].TreeMap.root
+	mov rdx, [rbp + newKey]
+	mov r8, rsi
+	call findAddressOfKey
+
+	cmp rax, nullptr
+	jne rekeyAlreadyContains
+
+allocateRelinkSpace:
+	test [rsi].TreeMap.flags, inlinePairsFlag
+	jnz relinkInlinePair
+
+	; Allocate stack memory for the unlinked pair followed by the new key.
+	; Below it the deletion gets its temporary copy space.
+	sub rsp, [rsi].TreeMap.keySize
+	sub rsp, [rsi].TreeMap.keySize
+	sub rsp, [rsi].TreeMap.valueSize
+	and rsp, -16
+	mov r12, rsp
+
+	sub rsp, [rsi].TreeMap.keySize
+	sub rsp, [rsi].TreeMap.valueSize
+	sub rsp, shadowStorage
+	and rsp, -16
+
+	; Deep copy the new key before the pair gets unlinked
+	; so that a failing copy leaves the treemap untouched.
+	mov rcx, r12
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rdx, [rbp + newKey]
+	mov r8, rsi
+	callUserFunc [rsi].TreeMap.copyKeyFunc
+
+	cmp eax, success
+	jne copyKeyFailure
+
+	; Unlink the pair into the stack memory. The released treenode
+	; becomes the spare treenode that is used for the relinking.
+	mov r14, [rbp + rekeyNode]
+	mov rcx, rsi
+	mov rdx, [rbp + oldKey]
+	mov r8, r12
+	lea r9, delete
+	call executeDelete
+
+	; Hand the old key over to the buffer.
+	mov rcx, [rbp + rekeyBuffer]
+	mov rdx, r12
+	mov r8, [rsi].TreeMap.keySize
+	call memcpy
+
+	; Replace it with the new key.
+	mov rcx, r12
+	mov rdx, r12
+	add rdx, [rsi].TreeMap.keySize
+	add rdx, [rsi].TreeMap.valueSize
+	mov r8, [rsi].TreeMap.keySize
+	call memcpy
+
+	; Relink the pair by moving it into a treenode.
+	mov rdx, r12
+	lea r12, moveTreeNode
+	mov edi, success
+	mov rcx, [rsi].TreeMap.root
+	call insertPair
+
+	; Update the root and turn is back to black.
+	mov [rsi], rax
+
+	add rax, [rsi].TreeMap.keySize
+	add rax, [rsi].TreeMap.valueSize
+	add rax, 2 * qwordSize
+	mov byte ptr [rax], false
+
+	mov eax, edi
+
+	jmp recordRekey
+
+relinkInlinePair:
+	; Allocate stack memory for the new key followed by the old value.
+	; The shadow storage below it is the temporary space of the deletion.
+	sub rsp, [rsi].TreeMap.keySize
+	sub rsp, [rsi].TreeMap.valueSize
+	and rsp, -16
+	mov r12, rsp
+	sub rsp, shadowStorage
+
+	mov rcx, r12
+	mov rdx, [rbp + newKey]
+	mov r8, [rsi].TreeMap.keySize
+	call memcpy
+
+	mov rcx, r12
+	add rcx, [rsi].TreeMap.keySize
+	mov rdx, [rbp + rekeyNode]
+	add rdx, [rsi].TreeMap.keySize
+	mov r8, [rsi].TreeMap.valueSize
+	call memcpy
+
+	; Create the new treenode while the old one still holds the value.
+	mov edi, success
+	mov rdx, r12
+	call copyInlineTreeNode
+
+	cmp rax, nullptr
+	je relinkFailure
+
+	mov r12, rax
+
+	; Deep copy the old key into the buffer before it is freed.
+	; The copy leaves the treemap, so the copy function gets no treemap.
+	mov rcx, [rbp + rekeyBuffer]
+	mov rdx, [rbp + rekeyNode]
+	mov r8, nullptr
+	callUserFunc [rsi].TreeMap.copyKeyFunc
+
+	cmp eax, success
+	je unlinkInlinePair
+
+	mov rcx, r12
+	call releaseTreeNode
+
+	jmp copyKeyFailure
+
+unlinkInlinePair:
+	; Delete the old treenode and link the new one.
+	mov r14, [rbp + rekeyNode]
+	mov rcx, rsi
+	mov rdx, [rbp + oldKey]
+	mov r8, nullptr
+	lea r9, delete
+	call executeDelete
+
+	mov rdx, r12
+	lea r12, adoptTreeNode
+	mov edi, success
+	mov rcx, [rsi].TreeMap.root
+	call insertPair
+
+	; Update the root and turn is back to black.
+	mov [rsi], rax
+
+	add rax, [rsi].TreeMap.keySize
+	add rax, [rsi].TreeMap.valueSize
+	add rax, 2 * qwordSize
+	mov byte ptr [rax], false
+
+relinkFailure:
+	mov eax, edi
+
+recordRekey:
+	; The change stream and the log record both keys of the moved pair.
+	cmp [rsi].TreeMap.changeStream, nullptr
+	je logRekey
+
+	cmp eax, success
+	jne functionReturn
+
+	mov rcx, rsi
+	mov edx, changeRekeyRecord
+	mov r8, [rbp + oldKey]
+	mov r9, [rbp + newKey]
+	call recordChange
+
+logRekey:
+	cmp [rsi].TreeMap.log, nullptr
+	je functionReturn
+
+	cmp eax, success
+	jne functionReturn
+
+	mov rcx, rsi
+	mov edx, logRekeyRecord
+	mov r8, [rbp + oldKey]
+	mov r9, [rbp + newKey]
+	call recordLogChange
+
+	jmp functionReturn
+
+rekeyContainsFailure:
+	mov eax, doesNotContain
+
+	jmp functionReturn
+
+rekeyAlreadyContains:
+	mov eax, alreadyContains
 
 	jmp functionReturn
 
-treeMapInvalid:
-	mov eax, treeMapNullptr
+copyKeyFailure:
+	mov eax, errCopyKeyFunc
 
 functionReturn:
-	mov rsp, rbp
+	lea rsp, [rbp - 4 * qwordSize]
+	pop r14
+	pop r12
+	pop rdi
+	pop rsi
 	pop rbp
 	ret
 
-deletePair endp
-
+rekeyPair endp
 
-	public pollFirstPair
 
-; Deletes the minimum key value pair of the given treemap.
+; Replaces the value of a treenode with inline pairs. A value that isn't longer
+; than the current one is copied in place, otherwise a new treenode is created
+; that takes the place of the current one inside the tree.
 ;
-; @RCX qword[in,out] - Pointer to the treemap whose min pair will be deleted.
-; @RDX qword[out] - Pointer to a buffer of a treenode thats used to copy the deleted min pair.
+; @RCX qword[in,out] - Pointer to the treemap that holds the treenode.
+; @RDX qword[in,out] - Pointer to the treenode whose value is replaced.
+; @R8 qword[in] - Pointer to the InlineData of the new value.
 ;
-; @returns A status flag of success, doesNotContain if no min key value pair exists or
-; a treeMapNullptr error if the given treemap is a nullptr.
-pollFirstPair proc
+; @returns A status flag of success or errHeapAllocation if the new treenode can't be allocated.
+replaceInlineValue proc
 
 	push rbp
 	mov rbp, rsp
+	push rsi
+	push rdi
+	push r12
+	push r14
+	sub rsp, shadowStorage + 2 * qwordSize
 
-	; Check if the treemap is not a nullptr.
-	cmp rcx, nullptr
-	je treeMapInvalid
+	mov rsi, rcx
+	mov r14, rdx
 
-	mov r8, rdx
-	lea r9, deleteMin
-	call executeDelete
+	; Check if the new value fits into the bytes of the current one.
+	mov rcx, r14
+	add rcx, [rsi].TreeMap.keySize
+	mov rax, [r8].InlineData.byteAmount
+	cmp rax, [rcx].InlineData.byteAmount
+	ja rebuildTreeNode
+
+	mov [rcx].InlineData.byteAmount, rax
+	mov rcx, [rcx].InlineData.bytes
+	mov rdx, [r8].InlineData.bytes
+	mov r8, rax
+	call memcpy
+
+	mov eax, success
 
 	jmp functionReturn
 
-treeMapInvalid:
-	mov eax, treeMapNullptr
+rebuildTreeNode:
+	; Allocate stack memory for the key followed by the new value.
+	sub rsp, [rsi].TreeMap.keySize
+	sub rsp, [rsi].TreeMap.valueSize
+	and rsp, -16
+	mov r12, rsp
+	sub rsp, shadowStorage
 
-functionReturn:
-	pop rbp
-	ret
+	mov [rbp + inlineTreeNode], r8
 
-pollFirstPair endp
+	mov rcx, r12
+	mov rdx, r14
+	mov r8, [rsi].TreeMap.keySize
+	call memcpy
 
+	mov rcx, r12
+	add rcx, [rsi].TreeMap.keySize
+	mov rdx, [rbp + inlineTreeNode]
+	mov r8, [rsi].TreeMap.valueSize
+	call memcpy
 
-	public pollLastPair
+	; Create the new treenode and give it the children and the color of the current one.
+	mov edi, success
+	mov rdx, r12
+	call copyInlineTreeNode
 
-; Deletes the maximum key value pair of the given treemap.
-;
-; @RCX qword[in,out] - Pointer to the treemap whose max pair will be deleted.
-; @RDX qword[out] - Pointer to a buffer of a treenode thats used to copy the deleted max pair.
-;
-; @returns A status flag of success, doesNotContain if no max key value pair exists or
-; a treeMapNullptr error if the given treemap is a nullptr.
-pollLastPair proc
+	cmp rax, nullptr
+	je replaceFailure
 
-	push rbp
-	mov rbp, rsp
+	mov [rbp + inlineTreeNode], rax
+	mov rcx, rax
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rdx, r14
+	add rdx, [rsi].TreeMap.keySize
+	add rdx, [rsi].TreeMap.valueSize
+	mov r8, treeNodeBaseSize
+	call memcpy
 
-	; Check if the treemap is not a nullptr.
-	cmp rcx, nullptr
-	je treeMapInvalid
+	; Search the link that points to the current treenode. Its key is used to
+	; go down the tree, equal keys of a multimap are told apart by the treenode.
+	mov r12, r14
+	mov rdi, rsi
 
-	mov r8, rdx
-	lea r9, deleteMax
-	call executeDelete
-	
-	jmp functionReturn
+searchLink:
+	mov rcx, [rdi]
+	cmp rcx, r14
+	je replaceLink
 
-treeMapInvalid:
-	mov eax, treeMapNullptr
+	call compareDeleteKey
+
+	mov rdi, [rdi]
+	add rdi, [rsi].TreeMap.keySize
+	add rdi, [rsi].TreeMap.valueSize
+
+	cmp eax, 0
+	jl searchLink
+
+	add rdi, qwordSize
+
+	jmp searchLink
+
+replaceLink:
+	; Link the new treenode and free the current one.
+	mov rax, [rbp + inlineTreeNode]
+	mov [rdi], rax
+
+	mov rcx, r14
+	call releaseTreeNode
+
+	mov edi, success
+
+replaceFailure:
+	mov eax, edi
 
 functionReturn:
+	lea rsp, [rbp - 4 * qwordSize]
+	pop r14
+	pop r12
+	pop rdi
+	pop rsi
 	pop rbp
 	ret
 
-pollLastPair endp
+replaceInlineValue endp
 
 
 ; Executes the given delete method and it's pre and endphase.
@@ -919,9 +2391,12 @@ pollLastPair endp
 ; @RDX qword[in] - Pointer to the key that is used for deletion if its used.
 ; @R8 qword[out] - Pointer to a buffer that is used to store a deleted min/max pair.
 ; @R9 qword[in] - Pointer to the deletion function that is used.
+; @R14 qword[in] - Pointer to the treenode that is deleted by delete inside a multimap or a nullptr.
+;
+; Inline pairs are deep copied into the buffer because their bytes are freed with the treenode.
 ;
 ; @returns A status flag of success or doesNotContain if the given function in R9 couldn't find
-; a matching key value pair.
+; a matching key value pair. Inline pairs can also return the errors of the copy functions.
 executeDelete proc
 
 	push r13
@@ -936,6 +2411,7 @@ executeDelete proc
 	push rsi
 	push rdi
 	push r12
+	sub rsp, 2 * qwordSize
 
 	; Store the buffer, the treemap and the error
 	; inside non volatile registers.
@@ -944,6 +2420,20 @@ executeDelete proc
 	mov edi, doesNotContain
 	mov r12, rdx
 
+	; An unlinked inline treenode is handed over through the stack
+	; instead of the buffer, its pair is copied after the deletion.
+	mov qword ptr [rsp + detachedTreeNode], nullptr
+	mov [rsp + deletionBuffer], r8
+
+	cmp rbx, nullptr
+	je checkRootChildren
+
+	test [rsi].TreeMap.flags, inlinePairsFlag
+	jz checkRootChildren
+
+	lea rbx, [rsp + detachedTreeNode]
+
+checkRootChildren:
 	; Get the left child of the root node
 	; and test if it is black.
 	mov r11, [rsi].TreeMap.root
@@ -971,9 +2461,19 @@ executeDelete proc
 	mov byte ptr [r11], true
 
 deletion:
-	; Set rcx to the root.
+	; A running compaction continues behind the predecessor of its cursor if the cursor is deleted.
+	push r9
+	sub rsp, shadowStorage + qwordSize
+	call findCursorPredecessor
+	add rsp, shadowStorage + qwordSize
+	pop r9
+
+	; Set rcx to the root. The deletion function stores its
+	; parameters in the shadow storage, so it has to be provided.
 	mov rcx, [rsi].TreeMap.root
+	sub rsp, shadowStorage
 	call r9
+	add rsp, shadowStorage
 
 	; Change the root to the returned one.
 	; Also test if we need to mark the root node black.
@@ -981,15 +2481,47 @@ deletion:
 	mov rdx, [rsi].TreeMap.nodeAmount
 
 	cmp rdx, 0
-	je functionReturn
+	je copyInlinePair
 
 	add rax, [rsi].TreeMap.keySize
 	add rax, [rsi].TreeMap.valueSize
 	add rax, 2 * qwordSize
 	mov byte ptr [rax], false
 
+copyInlinePair:
+	; Deep copy the pair of an unlinked inline treenode
+	; into the buffer and release the treenode afterwards.
+	mov rdx, [rsp + detachedTreeNode]
+	cmp rdx, nullptr
+	je functionReturn
+
+	mov rcx, [rsp + deletionBuffer]
+	mov r8, rsi
+	sub rsp, shadowStorage
+	call copyPair
+	add rsp, shadowStorage
+
+	mov edi, eax
+	mov rcx, [rsp + detachedTreeNode]
+	sub rsp, shadowStorage
+	call releaseTreeNode
+	add rsp, shadowStorage
+
 functionReturn:
+	; The predecessor of the cursor is only valid during the deletion.
+	mov rax, [rsi].TreeMap.nodeArena
+	cmp rax, nullptr
+	je returnStatus
+
+	mov rax, [rax].NodeArena.compaction
+	cmp rax, nullptr
+	je returnStatus
+
+	mov [rax].NodeCompaction.predecessor, nullptr
+
+returnStatus:
 	mov eax, edi
+	add rsp, 2 * qwordSize
 	pop r12
 	pop rdi
 	pop rsi
@@ -1016,6 +2548,12 @@ deleteMax proc
 	; Store the current tree node.
 	mov [rbp + currentTreeNode], rcx
 
+	; Spilled children are faulted back in before the rebalancing looks at them.
+	call faultSpilledChildren
+
+	cmp eax, success
+	jne keepSpilledChildren
+
 	; Move the current treenode to the left and
 	; test if it is red.
 	add rcx, [rsi].TreeMap.keySize
@@ -1051,36 +2589,11 @@ maxFoundCheck:
 	cmp rdx, nullptr
 	jne executeMoveRedRight
 
-	; Check if a buffer to copy was given.
-	cmp rbx, nullptr
-	jne shallowCopy
-
-	; If no buffer is given test if
-	; a freePair function is defined to clear
-	; nested heap memory.
-	cmp [rsi].TreeMap.freePairFunc, nullptr
-	je freeNode
-
-	; Clear nested heap memory.
-	mov rcx, [rbp + currentTreeNode]
-	call [rsi].TreeMap.freePairFunc
-
-	jmp freeNode
-
-shallowCopy:
-	; If the right child is a nullptr, shallow
-	; copy the node that will be deleted.
-	mov rcx, rbx
-	mov rdx, [rbp + currentTreeNode]
-	xor r8, r8
-	add r8, [rsi].TreeMap.keySize
-	add r8, [rsi].TreeMap.valueSize
-	call memcpy
-
-freeNode:
-	; Free the treenode.
+	; If the right child is a nullptr, hand over the pair
+	; of the node that will be deleted to the buffer.
 	mov rcx, [rbp + currentTreeNode]
-	call free
+	mov rdx, rbx
+	call handOverTreeNode
 	 
 	; Return nullptr and a success.
 	mov rax, nullptr
@@ -1122,6 +2635,13 @@ deleteRightBranch:
 returnRax:
 	mov rax, [rbp + currentTreeNode]
 
+	jmp functionReturn
+
+keepSpilledChildren:
+	; The pair isn't deleted and the links stay spilled.
+	mov edi, eax
+	mov rax, [rbp + currentTreeNode]
+
 functionReturn:
 	mov rsp, rbp
 	pop rbp
@@ -1147,6 +2667,8 @@ deleteMax endp
 ;		   currently evaluated tree node.
 moveRedRight proc
 
+	countTreeMapEvent rsi, moveRedRights
+
 	; Get the left and the right child
 	; and save them in their stack memory.
 	; Test if the right child is black.
@@ -1161,6 +2683,10 @@ moveRedRight proc
 	cmp al, false
 	jne functionReturn
 
+	; A missing right child means the key to delete doesn't exist.
+	cmp qword ptr [rbp + rightTreeNode], nullptr
+	je functionReturn
+
 	; Get the left child of the already tested right treenode.
 	; Test if it is also black.
 	mov rcx, [rbp + rightTreeNode]
@@ -1183,14 +2709,14 @@ moveRedRight proc
 	mov r10B, false
 	call flip
 
-	; Test if the left child of the left node is black.
+	; Test if the left child of the left node is red.
 	mov rcx, [rbp + leftTreeNode]
 	add rcx, [rsi].TreeMap.keySize
 	add rcx, [rsi].TreeMap.valueSize
 	mov rcx, [rcx]
 	call isRed
 
-	cmp al, false
+	cmp al, true
 	jne functionReturn
 
 	; Do a right rotation.
@@ -1200,6 +2726,10 @@ moveRedRight proc
 
 	mov [rbp + currentTreeNode], rax
 
+	; The rotation leaves the new treenode with two red children,
+	; flip them back to black before the deletion descends further.
+	call flipRotatedTreeNode
+
 functionReturn:
 	ret
 
@@ -1221,6 +2751,13 @@ deleteMin proc
 	; Store the currentTreeNode
 	; and move the pointer of the treenode to the left child.
 	mov [rbp + currentTreeNode], rcx
+
+	; Spilled children are faulted back in before the rebalancing looks at them.
+	call faultSpilledChildren
+
+	cmp eax, success
+	jne keepSpilledChildren
+
 	add rcx, [rsi].TreeMap.keySize
 	add rcx, [rsi].TreeMap.valueSize
 
@@ -1229,34 +2766,10 @@ deleteMin proc
 	cmp qword ptr [rcx], nullptr
 	jne executeMoveRedLeft
 
-	; Check if a buffer was provided.
-	cmp rbx, nullptr
-	jne shallowCopy
-
-	; If not check if we have nested heap memory.
-	cmp [rsi].TreeMap.freePairFunc, nullptr
-	je freeNode
-
-	; Free nested heap memory.
-	mov rcx, [rbp + currentTreeNode]
-	call [rsi].TreeMap.freePairFunc
-
-	jmp freeNode
-
-shallowCopy:
-	; Shallow copy the tree node that will be deleted.
-	; Heap memory doesn't need to be freed this way.
-	mov rcx, rbx
-	mov rdx, [rbp + currentTreeNode]
-	xor r8, r8
-	add r8, [rsi].TreeMap.keySize
-	add r8, [rsi].TreeMap.valueSize
-	call memcpy
-
-freeNode:
-	; Free the treenode.
+	; Hand over the pair of the tree node that will be deleted.
 	mov rcx, [rbp + currentTreeNode]
-	call free
+	mov rdx, rbx
+	call handOverTreeNode
 	
 	; Return a nullptr, decrease the nodeAmount and signal a success.
 	mov rax, nullptr
@@ -1293,6 +2806,13 @@ executeMoveRedLeft:
 returnRax:
 	mov rax, [rbp + currentTreeNode]
 
+	jmp functionReturn
+
+keepSpilledChildren:
+	; The pair isn't deleted and the links stay spilled.
+	mov edi, eax
+	mov rax, [rbp + currentTreeNode]
+
 functionReturn:
 	mov rsp, rbp
 	pop rbp
@@ -1316,6 +2836,8 @@ deleteMin endp
 ;		   currently evaluated tree node.
 moveRedLeft proc
 
+	countTreeMapEvent rsi, moveRedLefts
+
 	; Test if the left child is red.
 	add rcx, [rsi].TreeMap.keySize
 	add rcx, [rsi].TreeMap.valueSize
@@ -1326,9 +2848,13 @@ moveRedLeft proc
 	cmp al, false
 	jne functionReturn
 
-	; Test if the right child is red.
+	; A missing left child means the key to delete doesn't exist.
 	mov rcx, [rbp + leftTreeNode]
 	mov rcx, [rcx]
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Test if the left child of the left node is red.
 	add rcx, [rsi].TreeMap.keySize
 	add rcx, [rsi].TreeMap.valueSize
 	mov rcx, [rcx]
@@ -1384,11 +2910,37 @@ moveRedLeft proc
 
 	mov [rbp + currentTreeNode], rax
 
+	; The rotation leaves the new treenode with two red children,
+	; flip them back to black before the deletion descends further.
+	call flipRotatedTreeNode
+
 functionReturn:
 	ret
 
 moveRedLeft endp
 
+
+; Flips the colors of the treenode that moveRedLeft or moveRedRight rotated
+; and its children back while a deletion descends the tree.
+;
+; @RAX qword[in] - Pointer to the rotated treenode.
+; @RSI qword[in] - Pointer to the current treemap used.
+flipRotatedTreeNode proc
+
+	mov rcx, rax
+	mov r8, rax
+	add r8, [rsi].TreeMap.keySize
+	add r8, [rsi].TreeMap.valueSize
+	mov r9, [r8 + qwordSize]
+	mov r8, [r8]
+	mov r10B, true
+	call flip
+
+	ret
+
+flipRotatedTreeNode endp
+
+
 ; Deletes the pair specified by the given key if such a pair with the key exists.
 ;
 ; @RBX qword[out] - Pointer to the buffer that stores the deleted min pair.
@@ -1399,6 +2951,7 @@ moveRedLeft endp
 ; @R12 qword[in] - Pointer to the key that is used to identify the pair that should be deleted.
 ; @R13 qword[in] - Reserved memory that will be used to save the address where stack memory is allocated
 ;				   for the minimum deletion.
+; @R14 qword[in] - Pointer to the treenode that is deleted inside a multimap or a nullptr.
 delete proc
 
 	push rbp
@@ -1412,10 +2965,14 @@ delete proc
 	
 	mov [rbp + currentTreeNode], rcx
 
-	; Save the key in the unused space and compare
-	; the keys.
-	mov rdx, r12
-	call [rsi].TreeMap.compareKeyFunc
+	; Spilled children are faulted back in before the rebalancing looks at them.
+	call faultSpilledChildren
+
+	cmp eax, success
+	jne keepSpilledChildren
+
+	; Compare the keys.
+	call compareDeleteKey
 	
 	; Check if we go left or right.
 	mov rcx, [rbp + currentTreeNode]
@@ -1464,9 +3021,8 @@ continueRight:
 
 deleteCurrentNode:
 	; Retest if the current node matches.
-	mov rdx, r12
 	mov rcx, [rbp + currentTreeNode]
-	call [rsi].TreeMap.compareKeyFunc
+	call compareDeleteKey
 
 	cmp al, 0
 	jne executeMoveRedRight
@@ -1484,36 +3040,13 @@ deleteCurrentNode:
 	cmp rcx, nullptr
 	jne executeMoveRedRight
 
-	; Check if a buffer was provided.
-	cmp rbx, nullptr
-	jne shallowCopyLeaf
-
-	; Check if we need to free nested heap memory.
-	cmp [rsi].TreeMap.freePairFunc, nullptr
-	je freeTreeNode
-
-	; Free nested heap memory.
-	mov rcx, [rbp + currentTreeNode]
-	call [rsi].TreeMap.freePairFunc
-
-	jmp freeTreeNode
-
-shallowCopyLeaf:
-	; Shallow copy the treenode to be deleted into
-	; the provided buffer.
-	mov rcx, rbx
-	mov rdx, [rbp + currentTreeNode]
-	xor r8, r8
-	add r8, [rsi].TreeMap.keySize
-	add r8, [rsi].TreeMap.valueSize
-	call memcpy
-
-freeTreeNode:
-	; Free the treenode and decrease the nodeAmount.
-	; Set the status to success.
+	; Hand over the pair of the treenode to be deleted
+	; to the provided buffer and release the treenode.
 	mov rcx, [rbp + currentTreeNode]
-	call free
+	mov rdx, rbx
+	call handOverTreeNode
 
+	; Decrease the nodeAmount and set the status to success.
 	mov rax, nullptr
 	mov edi, success
 	dec [rsi].TreeMap.nodeAmount
@@ -1527,8 +3060,7 @@ executeMoveRedRight:
 	; Check if the node still matches e.g. moveRedRight only called
 	; flip.
 	mov rcx, [rbp + currentTreeNode]
-	mov rdx, r12
-	call [rsi].TreeMap.compareKeyFunc
+	call compareDeleteKey
 
 	mov rcx, [rbp + currentTreeNode]
 
@@ -1555,17 +3087,23 @@ executeMoveRedRight:
 	mov rcx, [rbp + rightTreeNode]
 	mov [rcx], rax
 
+	; The minimum only takes the place of the treenode if deleteMin unlinked it.
+	; A spilled treenode that can't be faulted back in stops it before.
+	cmp edi, success
+	jne balanceTree
+
+	; Inline pairs belong to their treenode, so the unlinked minimum
+	; takes the place of the current treenode instead of copying its pair.
+	test [rsi].TreeMap.flags, inlinePairsFlag
+	jnz replaceByMinimum
+
 	; Check if the buffer provided is not a nullptr.
 	cmp r13, nullptr
 	jne shallowCopyNodePair
 
-	; If it is check if nested heap memory has to be cleared.
-	cmp [rsi].TreeMap.freePairFunc, nullptr
-	je overwriteDeletedNode
-
-	; Clear nested heap memory.
+	; If it is clear nested heap memory.
 	mov rcx, [rbp + currentTreeNode]
-	call [rsi].TreeMap.freePairFunc
+	call disposeTreeNodePair
 
 	jmp overwriteDeletedNode
 
@@ -1588,6 +3126,33 @@ overwriteDeletedNode:
 	add r8, [rsi].TreeMap.valueSize
 	call memcpy
 
+	; The balancing sums up the subtree with the hash of the new pair.
+	cmp [rsi].TreeMap.hashPairFunc, nullptr
+	je balanceTree
+
+	mov rcx, [rbp + currentTreeNode]
+	call hashTreeNodePair
+
+	jmp balanceTree
+
+replaceByMinimum:
+	; Give the minimum the children and the color of the current treenode.
+	mov rcx, [rbx]
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rdx, [rbp + currentTreeNode]
+	add rdx, [rsi].TreeMap.keySize
+	add rdx, [rsi].TreeMap.valueSize
+	mov r8, treeNodeBaseSize
+	call memcpy
+
+	; Hand over the current treenode and continue with the minimum.
+	mov rcx, [rbp + currentTreeNode]
+	mov rdx, r13
+	mov rax, [rbx]
+	mov [rbp + currentTreeNode], rax
+	call handOverTreeNode
+
 	jmp balanceTree
 
 deleteRightBranch:
@@ -1625,6 +3190,13 @@ balanceTree:
 deleteFailure:
 	mov rax, nullptr
 
+	jmp functionReturn
+
+keepSpilledChildren:
+	; The pair isn't deleted and the links stay spilled.
+	mov edi, eax
+	mov rax, [rbp + currentTreeNode]
+
 functionReturn:
 	mov rsp, rbp
 	pop rbp
@@ -1632,4 +3204,42 @@ functionReturn:
 
 delete endp
 
+; Compares the key of the given treenode with the key of the pair that is deleted.
+; Inside a multimap equal keys are told apart by the treenode that is deleted,
+; every other treenode with the same key is treated as bigger because it is newer.
+;
+; @RCX qword[in] - Pointer to the treenode whose key is compared.
+; @RSI qword[in] - Pointer to the current treemap used.
+; @R12 qword[in] - Pointer to the key that identifies the pair that should be deleted.
+; @R14 qword[in] - Pointer to the treenode that is deleted inside a multimap or a nullptr.
+;
+; @returns The comparison result in the same way as the compare key function.
+compareDeleteKey proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	; Save the treenode and compare the keys.
+	mov [rsp + shadowStorage], rcx
+	mov rdx, r12
+	countTreeMapEvent rsi, comparisons
+	callUserFunc [rsi].TreeMap.compareKeyFunc
+
+	cmp eax, 0
+	jne functionReturn
+
+	; Equal keys only match for the treenode that is deleted.
+	cmp r14, nullptr
+	je functionReturn
+
+	cmp [rsp + shadowStorage], r14
+	je functionReturn
+
+	mov eax, -1
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	ret
+
+compareDeleteKey endp
+
 end
\ No newline at end of file
@@ -709,6 +709,44 @@ TEST(TreeMap, deletePairShouldSucceedToClearTestTree) {
 		providedKey, false);
 }
 
+TEST(TreeMap, deletePairShouldKeepTreeBalancedAfterMovingRedRight) {
+	TreeMap* tm{ createTestNumberTree(8, 1) };
+	size_t key{ 3 }, missingKey{ 8 };
+
+	/*
+	* Test Tree Visualisation before deletePair:
+	*								    3
+	*								    B
+	*				    1								5
+	*				    B								B
+	*		    0			    2				4				7
+	*		    B			    B				B				B
+	*												    6
+	*												    R
+	*/
+	ASSERT_EQ(Status::SUCCESS, deletePair(tm, &key, nullptr));
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, deletePair(tm, &missingKey, nullptr));
+
+	/*
+	* Test Tree Visualisation after deletePair, every treenode is black:
+	*								    4
+	*				    1								6
+	*		    0			    2				5				7
+	*/
+	NumberTreeNode* root{ reinterpret_cast<NumberTreeNode*>(tm->root) };
+	NumberTreeNode* expectedNodes[]{ root->left->left, root->left, root->left->right,
+		root, root->right->left, root->right, root->right->right };
+
+	for (size_t index{ 0 }; index < 7; index++) {
+		ASSERT_EQ(index < 3 ? index : index + 1, expectedNodes[index]->key);
+		ASSERT_FALSE(expectedNodes[index]->isRed);
+	}
+
+	ASSERT_EQ(7, tm->nodeAmount);
+
+	deleteTreeMap(tm);
+}
+
 TEST(TreeMap, pollFirstPairShouldFailForTreeMapNullptr) {
 	Status s;
 	TreeMap* tm{ nullptr };
@@ -997,4 +1035,373 @@ TEST(TreeMap, pollLastPairShouldSucceedToClearTestTree) {
 	assertDeletionEquals(&expectedLeftLeftNode->pair, &result, tm, nullptr,
 		{ expectedRoot, expectedLeftNode, expectedRightNode, expectedLeftRightNode, expectedLeftLeftNode },
 		nullptr, false);
-}
\ No newline at end of file
+}
+
+TEST(TreeMap, rekeyPairShouldFailForTreeMapNullptr) {
+	Status s;
+	TreeNodeKey keyBuffer;
+
+	s = rekeyPair(nullptr, nullptr, nullptr, &keyBuffer);
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, s);
+}
+
+TEST(TreeMap, rekeyPairShouldFailForKeyBufferNullptr) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+	TreeNodeKey* oldKey{ createTreeNodeKey("Kansas") }, * newKey{ createTreeNodeKey("Iowa") };
+
+	s = rekeyPair(tm, oldKey, newKey, nullptr);
+
+	ASSERT_EQ(Status::KEY_BUFFER_NULLPTR, s);
+
+	freeTreeNodeKeys({ oldKey, newKey });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, rekeyPairShouldFailForMissingKey) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+	TreeNodeKey* oldKey{ createTreeNodeKey("Texas") }, * newKey{ createTreeNodeKey("Iowa") };
+	TreeNodeKey keyBuffer;
+
+	s = rekeyPair(tm, oldKey, newKey, &keyBuffer);
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+	ASSERT_EQ(5, tm->nodeAmount);
+
+	freeTreeNodeKeys({ oldKey, newKey });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, rekeyPairShouldFailForAlreadyContainedNewKey) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+	TreeNodeKey* oldKey{ createTreeNodeKey("Kansas") }, * newKey{ createTreeNodeKey("Oregon") };
+	TreeNodeKey keyBuffer;
+
+	TreeNode* expectedRoot{ createTreeNode("Oregon", "Salem", 1859, 4237256, false) },
+		* expectedRightNode{ createTreeNode("Washington", "Olympia", 1889, 7705281, false) },
+		* expectedLeftNode{ createTreeNode("Minnesota", "Saint Paul", 1858, 5706494, true) },
+		* expectedLeftLeftNode{ createTreeNode("Kansas", "Topeka", 1861, 2937880, false) },
+		* expectedLeftRightNode{ createTreeNode("New York", "Albany", 1788, 20201249, false) };
+
+	expectedRoot->left = expectedLeftNode;
+	expectedRoot->right = expectedRightNode;
+	expectedLeftNode->left = expectedLeftLeftNode;
+	expectedLeftNode->right = expectedLeftRightNode;
+
+	s = rekeyPair(tm, oldKey, newKey, &keyBuffer);
+
+	ASSERT_EQ(Status::ALREADY_CONTAINS, s);
+	assertTreeNodeEquals(expectedRoot, reinterpret_cast<TreeNode*>(tm->root));
+
+	freeTreeNodes({ expectedRoot, expectedRightNode, expectedLeftNode, expectedLeftLeftNode, expectedLeftRightNode });
+	freeTreeNodeKeys({ oldKey, newKey });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, rekeyPairShouldReplaceKeyInPlace) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+	TreeNodeKey* oldKey{ createTreeNodeKey("Kansas") }, * newKey{ createTreeNodeKey("Iowa") };
+	TreeNodeKey keyBuffer;
+
+	TreeNode* expectedRoot{ createTreeNode("Oregon", "Salem", 1859, 4237256, false) },
+		* expectedRightNode{ createTreeNode("Washington", "Olympia", 1889, 7705281, false) },
+		* expectedLeftNode{ createTreeNode("Minnesota", "Saint Paul", 1858, 5706494, true) },
+		* expectedLeftLeftNode{ createTreeNode("Iowa", "Topeka", 1861, 2937880, false) },
+		* expectedLeftRightNode{ createTreeNode("New York", "Albany", 1788, 20201249, false) };
+
+	expectedRoot->left = expectedLeftNode;
+	expectedRoot->right = expectedRightNode;
+	expectedLeftNode->left = expectedLeftLeftNode;
+	expectedLeftNode->right = expectedLeftRightNode;
+
+	TreeNode* rekeyedNode{ reinterpret_cast<TreeNode*>(tm->root)->left->left };
+
+	/*
+	* Test Tree Visualisation after rekeyPair:
+	*									   "Oregon"
+	*										  B
+	*				  "Minnesota"						   "Washington"
+	*					  R										B
+	*		"Iowa"				"New York"
+	*		  B						B
+	*/
+	s = rekeyPair(tm, oldKey, newKey, &keyBuffer);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(rekeyedNode, reinterpret_cast<TreeNode*>(tm->root)->left->left);
+	assertTreeNodeKeyEquals(oldKey, &keyBuffer);
+	assertTreeNodeEquals(expectedRoot, reinterpret_cast<TreeNode*>(tm->root));
+
+	free(keyBuffer.stateName);
+	freeTreeNodes({ expectedRoot, expectedRightNode, expectedLeftNode, expectedLeftLeftNode, expectedLeftRightNode });
+	freeTreeNodeKeys({ oldKey, newKey });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, rekeyPairShouldRelinkPairReusingItsTreeNode) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+	TreeNodeKey* oldKey{ createTreeNodeKey("Kansas") }, * newKey{ createTreeNodeKey("Texas") };
+	TreeNodeKey keyBuffer;
+
+	TreeNode* expectedRoot{ createTreeNode("Oregon", "Salem", 1859, 4237256, false) },
+		* expectedRightNode{ createTreeNode("Washington", "Olympia", 1889, 7705281, false) },
+		* expectedRightLeftNode{ createTreeNode("Texas", "Topeka", 1861, 2937880, true) },
+		* expectedLeftNode{ createTreeNode("New York", "Albany", 1788, 20201249, false) },
+		* expectedLeftLeftNode{ createTreeNode("Minnesota", "Saint Paul", 1858, 5706494, true) };
+
+	expectedRoot->left = expectedLeftNode;
+	expectedRoot->right = expectedRightNode;
+	expectedLeftNode->left = expectedLeftLeftNode;
+	expectedRightNode->left = expectedRightLeftNode;
+
+	TreeNode* rekeyedNode{ reinterpret_cast<TreeNode*>(tm->root)->left->left };
+
+	/*
+	* Test Tree Visualisation after rekeyPair:
+	*									   "Oregon"
+	*										  B
+	*				  "New York"						   "Washington"
+	*					  B										B
+	*		"Minnesota"							"Texas"
+	*			R									R
+	*/
+	s = rekeyPair(tm, oldKey, newKey, &keyBuffer);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(5, tm->nodeAmount);
+	ASSERT_EQ(nullptr, tm->spareTreeNode);
+	ASSERT_EQ(rekeyedNode, reinterpret_cast<TreeNode*>(tm->root)->right->left);
+	assertTreeNodeKeyEquals(oldKey, &keyBuffer);
+	assertTreeNodeEquals(expectedRoot, reinterpret_cast<TreeNode*>(tm->root));
+
+	free(keyBuffer.stateName);
+	freeTreeNodes({ expectedRoot, expectedRightNode, expectedRightLeftNode, expectedLeftNode, expectedLeftLeftNode });
+	freeTreeNodeKeys({ oldKey, newKey });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, setTreeMapFlagsShouldFailForInlinePairsWithOtherSizes) {
+	Status s;
+	TreeMap* tm{ createTreeMap(sizeof(InlineData), sizeof(TreeNodePair), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeTreeNodePair, &s) };
+
+	s = setTreeMapFlags(tm, TreeMapFlags::INLINE_PAIRS);
+
+	ASSERT_EQ(Status::INLINE_SIZE_MISMATCH, s);
+	ASSERT_EQ(0, tm->flags);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, putPairShouldStoreInlinePairInsideTreeNode) {
+	TreeMap* tm{ createTestInlineTree() };
+
+	const InlinePair* root{ reinterpret_cast<const InlinePair*>(tm->root) };
+
+	// The bytes follow the left and right child and the padded color.
+	const char* expectedBytes{ reinterpret_cast<const char*>(root + 1) + 3 * sizeof(void*) };
+
+	ASSERT_EQ(5, tm->nodeAmount);
+	ASSERT_EQ(expectedBytes, root->key.bytes);
+	ASSERT_EQ(expectedBytes + root->key.byteAmount, root->value.bytes);
+	assertInlineDataEquals("Oregon", &root->key);
+	assertInlineDataEquals("Salem", &root->value);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, deletePairShouldDeepCopyInlinePairWithTwoChildren) {
+	Status s;
+	TreeMap* tm{ createTestInlineTree() };
+	InlineData key{ "Oregon", 6 };
+	InlinePair deleted;
+
+	s = deletePair(tm, &key, &deleted);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(4, tm->nodeAmount);
+	assertInlineDataEquals("Oregon", &deleted.key);
+	assertInlineDataEquals("Salem", &deleted.value);
+
+	assertInlineValueEquals(tm, "Washington", "Olympia");
+	assertInlineValueEquals(tm, "New York", "Albany");
+	assertInlineValueEquals(tm, "Minnesota", "Saint Paul");
+	assertInlineValueEquals(tm, "Kansas", "Topeka");
+
+	free(const_cast<void*>(deleted.key.bytes));
+	free(const_cast<void*>(deleted.value.bytes));
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, pollPairsShouldEmptyTreeMapWithInlinePairs) {
+	Status s;
+	TreeMap* tm{ createTestInlineTree() };
+	InlineData key{ "Minnesota", 9 };
+	InlinePair first, last;
+
+	s = deletePair(tm, &key, nullptr);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	s = pollFirstPair(tm, &first);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertInlineDataEquals("Kansas", &first.key);
+	assertInlineDataEquals("Topeka", &first.value);
+
+	s = pollLastPair(tm, &last);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertInlineDataEquals("Washington", &last.key);
+	assertInlineDataEquals("Olympia", &last.value);
+
+	s = pollFirstPair(tm, nullptr);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	s = pollLastPair(tm, nullptr);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(0, tm->nodeAmount);
+	ASSERT_EQ(nullptr, tm->root);
+
+	free(const_cast<void*>(first.key.bytes));
+	free(const_cast<void*>(first.value.bytes));
+	free(const_cast<void*>(last.key.bytes));
+	free(const_cast<void*>(last.value.bytes));
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, replaceValueShouldReplaceInlineValueOfAnyLength) {
+	Status s;
+	TreeMap* tm{ createTestInlineTree() };
+	InlineData key{ "Kansas", 6 }, shorter{ "Ottawa", 6 }, longer{ "Kansas City", 11 };
+
+	const void* treeNode{ reinterpret_cast<TreeNode*>(tm->root)->left->left };
+
+	s = replaceValue(tm, &key, &shorter);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(treeNode, reinterpret_cast<TreeNode*>(tm->root)->left->left);
+	assertInlineValueEquals(tm, "Kansas", "Ottawa");
+
+	s = replaceValue(tm, &key, &longer);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(5, tm->nodeAmount);
+	assertInlineValueEquals(tm, "Kansas", "Kansas City");
+	assertInlineValueEquals(tm, "Minnesota", "Saint Paul");
+	assertInlineValueEquals(tm, "New York", "Albany");
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, rekeyPairShouldRelinkInlinePairWithLongerKey) {
+	Status s;
+	TreeMap* tm{ createTestInlineTree() };
+	InlineData oldKey{ "Kansas", 6 }, newKey{ "North Carolina", 14 }, keyBuffer;
+
+	s = rekeyPair(tm, &oldKey, &newKey, &keyBuffer);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(5, tm->nodeAmount);
+	assertInlineDataEquals("Kansas", &keyBuffer);
+	assertInlineValueEquals(tm, "North Carolina", "Topeka");
+	assertInlineValueEquals(tm, "Oregon", "Salem");
+
+	s = containsKey(tm, &oldKey);
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+
+	free(const_cast<void*>(keyBuffer.bytes));
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, deletePairShouldKeepSpareTreeNodesUpToLimit) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+	TreeNodeKey* washington{ createTreeNodeKey("Washington") }, * oregon{ createTreeNodeKey("Oregon") },
+		* newYork{ createTreeNodeKey("New York") }, * minnesota{ createTreeNodeKey("Minnesota") };
+	TreeNode* node{ createTreeNode("Texas", "Austin", 1845, 29145505, false) };
+
+	ASSERT_EQ(1, tm->spareLimit);
+
+	s = setSpareTreeNodeLimit(tm, 3);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(3, tm->spareLimit);
+
+	for (TreeNodeKey* key : { washington, oregon, newYork, minnesota }) {
+		deletePair(tm, key, nullptr);
+	}
+
+	ASSERT_EQ(3, tm->spareAmount);
+
+	// The treenode that was released last is reused first.
+	void* nextSpareTreeNode{ *reinterpret_cast<void**>(tm->spareTreeNode) };
+
+	s = putPair(tm, &node->pair);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(2, tm->spareAmount);
+	ASSERT_EQ(nextSpareTreeNode, tm->spareTreeNode);
+
+	freeTreeNodes({ node });
+	freeTreeNodeKeys({ washington, oregon, newYork, minnesota });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, setSpareTreeNodeLimitShouldFreeSpareTreeNodesAboveLimit) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+	TreeNodeKey* washington{ createTreeNodeKey("Washington") }, * oregon{ createTreeNodeKey("Oregon") },
+		* newYork{ createTreeNodeKey("New York") };
+
+	setSpareTreeNodeLimit(tm, 8);
+
+	for (TreeNodeKey* key : { washington, oregon, newYork }) {
+		deletePair(tm, key, nullptr);
+	}
+
+	s = setSpareTreeNodeLimit(tm, 1);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(1, tm->spareAmount);
+	ASSERT_EQ(nullptr, *reinterpret_cast<void**>(tm->spareTreeNode));
+
+	s = setSpareTreeNodeLimit(nullptr, 1);
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, s);
+
+	freeTreeNodeKeys({ washington, oregon, newYork });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, trimSpareTreeNodesShouldKeepGivenAmount) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+	TreeNodeKey* washington{ createTreeNodeKey("Washington") }, * oregon{ createTreeNodeKey("Oregon") };
+
+	setSpareTreeNodeLimit(tm, 8);
+	deletePair(tm, washington, nullptr);
+	deletePair(tm, oregon, nullptr);
+
+	s = trimSpareTreeNodes(tm, 0);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(0, tm->spareAmount);
+	ASSERT_EQ(nullptr, tm->spareTreeNode);
+	ASSERT_EQ(8, tm->spareLimit);
+
+	s = trimSpareTreeNodes(nullptr, 0);
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, s);
+
+	freeTreeNodeKeys({ washington, oregon });
+	deleteTreeMap(tm);
+}
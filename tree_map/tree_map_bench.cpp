@@ -0,0 +1,305 @@
+/*
+* @file tree_map_bench.cpp
+*
+* Defines the benchmarks of the basic treemap operations for integer
+* and string keys and runs them together with the comparison, the
+* callback, the node arena, the snapshot and the log benchmarks.
+* The results are written as json to tree_map_bench.json unless
+* --benchmark_out is given. --tree_map_max_size limits the biggest
+* benchmarked treemap.
+*
+* @author Collector
+* @data 10/17/2026
+*/
+
+#include <cstring>
+#include <string>
+
+#include "bench_utils.h"
+
+namespace {
+	/*
+	* Amount of keys that are converted at once while the timing is paused.
+	*/
+	constexpr size_t keyChunkSize{ 4096 };
+
+	/*
+	* Treemap that the lookup benchmarks share. Only one is kept at a time,
+	* because the benchmarks are registered grouped by key type and size.
+	*/
+	TreeMap* lookupMap{ nullptr };
+	const char* lookupMapKeys{ nullptr };
+	size_t lookupMapSize{ 0 };
+
+	void releaseLookupMap() {
+		if (lookupMap != nullptr) {
+			deleteTreeMap(lookupMap);
+		}
+
+		lookupMap = nullptr;
+		lookupMapKeys = nullptr;
+		lookupMapSize = 0;
+	}
+
+	template <typename Keys>
+	TreeMap* getLookupMap(size_t amount) {
+		if (lookupMapKeys != Keys::name || lookupMapSize != amount) {
+			releaseLookupMap();
+
+			lookupMap = createBenchmarkMap<Keys>(amount);
+			lookupMapKeys = Keys::name;
+			lookupMapSize = amount;
+		}
+
+		return lookupMap;
+	}
+
+	/*
+	* Calls the operation for the pairs of all indices in the order. The pairs are created
+	* chunk wise while the timing is paused.
+	*/
+	template <typename Keys, typename Operation>
+	void runKeyOrder(benchmark::State& state, const std::vector<uint32_t>& order, Operation operation) {
+		static std::vector<typename Keys::Pair> chunk(keyChunkSize);
+
+		for (size_t start{ 0 }; start < order.size(); start += keyChunkSize) {
+			size_t count{ std::min(keyChunkSize, order.size() - start) };
+
+			state.PauseTiming();
+
+			for (size_t i{ 0 }; i < count; i++) {
+				makeBenchmarkPair<Keys>(order[start + i], &chunk[i]);
+			}
+
+			state.ResumeTiming();
+
+			for (size_t i{ 0 }; i < count; i++) {
+				operation(chunk[i]);
+			}
+		}
+	}
+
+	template <typename Keys>
+	void benchmarkPutPair(benchmark::State& state, size_t amount, KeyDistribution distribution) {
+		releaseLookupMap();
+
+		std::vector<uint32_t> order{ createKeyOrder(distribution, amount) };
+		TreeMap* tm{ Keys::createMap() };
+
+		for (auto _ : state) {
+			runKeyOrder<Keys>(state, order, [tm](const typename Keys::Pair& pair) {
+				benchmark::DoNotOptimize(putPair(tm, &pair));
+			});
+
+			state.PauseTiming();
+			clearTreeMap(tm);
+			state.ResumeTiming();
+		}
+
+		state.SetItemsProcessed(state.iterations() * order.size());
+		deleteTreeMap(tm);
+	}
+
+	template <typename Keys>
+	void benchmarkDeletePair(benchmark::State& state, size_t amount, KeyDistribution distribution) {
+		releaseLookupMap();
+
+		std::vector<uint32_t> order{ createKeyOrder(distribution, amount) };
+
+		for (auto _ : state) {
+			state.PauseTiming();
+			TreeMap* tm{ createBenchmarkMap<Keys>(amount) };
+			state.ResumeTiming();
+
+			runKeyOrder<Keys>(state, order, [tm](const typename Keys::Pair& pair) {
+				benchmark::DoNotOptimize(deletePair(tm, &pair.key, nullptr));
+			});
+
+			state.PauseTiming();
+			deleteTreeMap(tm);
+			state.ResumeTiming();
+		}
+
+		state.SetItemsProcessed(state.iterations() * order.size());
+	}
+
+	template <typename Keys>
+	void benchmarkPollFirstPair(benchmark::State& state, size_t amount) {
+		releaseLookupMap();
+
+		typename Keys::Pair pair{};
+
+		for (auto _ : state) {
+			state.PauseTiming();
+			TreeMap* tm{ createBenchmarkMap<Keys>(amount) };
+			state.ResumeTiming();
+
+			for (size_t i{ 0 }; i < amount; i++) {
+				benchmark::DoNotOptimize(pollFirstPair(tm, &pair));
+			}
+
+			state.PauseTiming();
+			deleteTreeMap(tm);
+			state.ResumeTiming();
+		}
+
+		state.SetItemsProcessed(state.iterations() * amount);
+	}
+
+	template <typename Keys>
+	void benchmarkClearTreeMap(benchmark::State& state, size_t amount) {
+		releaseLookupMap();
+
+		TreeMap* tm{ Keys::createMap() };
+
+		for (auto _ : state) {
+			state.PauseTiming();
+			deleteTreeMap(tm);
+			tm = createBenchmarkMap<Keys>(amount);
+			state.ResumeTiming();
+
+			benchmark::DoNotOptimize(clearTreeMap(tm));
+		}
+
+		state.SetItemsProcessed(state.iterations() * amount);
+		deleteTreeMap(tm);
+	}
+
+	/*
+	* Benchmarks one lookup per iteration on a treemap with the given amount of keys.
+	* The keyOffset is added to the number of every queried key, an offset of one
+	* queries the numbers between the keys.
+	*/
+	template <typename Keys, typename Lookup>
+	void benchmarkLookup(benchmark::State& state, size_t amount, KeyDistribution distribution,
+		size_t keyOffset, Lookup lookup) {
+		TreeMap* tm{ getLookupMap<Keys>(amount) };
+		std::vector<uint32_t> queries{ createKeyQueries(distribution, amount, benchmarkQueryAmount) };
+		std::vector<typename Keys::Key> keys(queries.size());
+		typename Keys::Pair pair{};
+		size_t i{ 0 };
+
+		for (size_t j{ 0 }; j < queries.size(); j++) {
+			Keys::makeKey(2 * size_t{ queries[j] } + keyOffset, &keys[j]);
+		}
+
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(lookup(tm, &keys[i++ & (benchmarkQueryAmount - 1)], &pair));
+		}
+
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	/*
+	* Registers the benchmarks of a key type for a single treemap size.
+	*/
+	template <typename Keys>
+	void registerSizeBenchmarks(size_t amount) {
+		const KeyDistribution distributions[]{ KeyDistribution::SEQUENTIAL,
+			KeyDistribution::UNIFORM, KeyDistribution::ZIPFIAN };
+
+		struct {
+			const char* name;
+			size_t keyOffset;
+			Status(*lookup)(TreeMap* tm, const void* key, void* buffer);
+		} lookups[]{
+			{ "getValue", 0, [](TreeMap* tm, const void* key, void* pair) {
+				return getValue(tm, key, &reinterpret_cast<typename Keys::Pair*>(pair)->value);
+			} },
+			{ "containsKey", 0, [](TreeMap* tm, const void* key, void*) { return containsKey(tm, key); } },
+			{ "floorPair", 1, floorPair },
+			{ "ceilingPair", 1, ceilingPair },
+			{ "lowerPair", 1, lowerPair },
+			{ "higherPair", 1, higherPair }
+		};
+
+		auto name{ [amount](const char* operation, const char* distribution) {
+			std::string result{ std::string{ operation } + "/" + Keys::name + "/" };
+
+			if (distribution != nullptr) {
+				result += std::string{ distribution } + "/";
+			}
+
+			return result + std::to_string(amount);
+		} };
+
+		for (const auto& lookup : lookups) {
+			for (KeyDistribution distribution : distributions) {
+				benchmark::RegisterBenchmark(name(lookup.name, getDistributionName(distribution)).c_str(),
+					benchmarkLookup<Keys, decltype(lookup.lookup)>, amount, distribution, lookup.keyOffset, lookup.lookup);
+			}
+		}
+
+		for (KeyDistribution distribution : distributions) {
+			benchmark::RegisterBenchmark(name("putPair", getDistributionName(distribution)).c_str(),
+				benchmarkPutPair<Keys>, amount, distribution)->Unit(benchmark::kMillisecond);
+		}
+
+		for (KeyDistribution distribution : distributions) {
+			benchmark::RegisterBenchmark(name("deletePair", getDistributionName(distribution)).c_str(),
+				benchmarkDeletePair<Keys>, amount, distribution)->Unit(benchmark::kMillisecond);
+		}
+
+		benchmark::RegisterBenchmark(name("pollFirstPair", nullptr).c_str(),
+			benchmarkPollFirstPair<Keys>, amount)->Unit(benchmark::kMillisecond);
+		benchmark::RegisterBenchmark(name("clearTreeMap", nullptr).c_str(),
+			benchmarkClearTreeMap<Keys>, amount)->Unit(benchmark::kMillisecond);
+	}
+}
+
+void registerTreeMapBenchmarks(size_t maxSize) {
+	for (size_t amount : getBenchmarkSizes(maxSize)) {
+		registerSizeBenchmarks<IntegerKeys>(amount);
+	}
+
+	for (size_t amount : getBenchmarkSizes(maxSize)) {
+		registerSizeBenchmarks<StringKeys>(amount);
+	}
+}
+
+int main(int argc, char** argv) {
+	const char maxSizeFlag[]{ "--tree_map_max_size=" };
+	const char outFlag[]{ "--benchmark_out=" };
+	char defaultOut[]{ "--benchmark_out=tree_map_bench.json" };
+	char defaultOutFormat[]{ "--benchmark_out_format=json" };
+
+	std::vector<char*> args;
+	size_t maxSize{ 100'000'000 };
+	bool hasOut{ false };
+
+	for (int i{ 0 }; i < argc; i++) {
+		if (std::strncmp(argv[i], maxSizeFlag, sizeof(maxSizeFlag) - 1) == 0) {
+			maxSize = std::stoull(argv[i] + sizeof(maxSizeFlag) - 1);
+			continue;
+		}
+
+		hasOut |= std::strncmp(argv[i], outFlag, sizeof(outFlag) - 1) == 0;
+		args.push_back(argv[i]);
+	}
+
+	if (!hasOut) {
+		args.push_back(defaultOut);
+		args.push_back(defaultOutFormat);
+	}
+
+	registerTreeMapBenchmarks(maxSize);
+	registerCompareBenchmarks(maxSize);
+	registerCallbackBenchmarks(maxSize);
+	registerArenaBenchmarks(maxSize);
+	registerSnapshotBenchmarks(maxSize);
+	registerLogBenchmarks();
+
+	int argCount{ static_cast<int>(args.size()) };
+
+	benchmark::Initialize(&argCount, args.data());
+
+	if (benchmark::ReportUnrecognizedArguments(argCount, args.data())) {
+		return 1;
+	}
+
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	releaseLookupMap();
+
+	return 0;
+}
@@ -0,0 +1,458 @@
+/*
+* @file tree_map_callback_bench.cpp
+*
+* Defines the benchmarks that measure the overhead of the user callbacks. Every
+* public function runs once with trivial number callbacks and once with the string
+* callbacks of the tests. The profiled runs count the callbacks of each kind per
+* operation and split the cycles between the library and the callbacks.
+*
+* @author Collector
+* @data 10/17/2026
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+#include "utils.h"
+#include "bench_utils.h"
+
+namespace {
+	/*
+	* Biggest treemap of the callback benchmarks. The share of the callbacks barely
+	* changes with the size, but the prepared pairs of the string callbacks take memory.
+	*/
+	constexpr size_t callbackMaxSize{ 1'000'000 };
+
+	/*
+	* Kinds of the callbacks that a treemap calls.
+	*/
+	enum CallbackKind : size_t {
+		COMPARE_KEY,
+		EQUALS_VALUE,
+		COPY_KEY,
+		COPY_VALUE,
+		FREE_PAIR,
+		CALLBACK_KINDS
+	};
+
+	const char* const callbackNames[CALLBACK_KINDS]{
+		"compare_key", "equals_value", "copy_key", "copy_value", "free_pair"
+	};
+
+	/*
+	* Calls and cycles of the profiled callbacks since the last reset.
+	*/
+	struct CallbackProfile {
+		size_t calls[CALLBACK_KINDS];
+		uint64_t cycles[CALLBACK_KINDS];
+	};
+
+	CallbackProfile profile{};
+
+	uint64_t readCycles() {
+		return __rdtsc();
+	}
+
+	/*
+	* Callbacks of a treemap with number keys and values that do as little as possible.
+	*/
+	struct TrivialCallbacks {
+		using Pair = IntegerPair;
+
+		static constexpr const char* name{ "trivial" };
+		static constexpr size_t keySize{ sizeof(size_t) };
+		static constexpr size_t valueSize{ sizeof(size_t) };
+		static constexpr size_t textSize{ 0 };
+
+		static long compareKey(const void* tKey, const void* insertedKey) {
+			size_t x{ *reinterpret_cast<const size_t*>(tKey) }, y{ *reinterpret_cast<const size_t*>(insertedKey) };
+
+			return y < x ? -1 : (y > x ? 1 : 0);
+		}
+
+		static bool equalsValue(const void* tValue, const void* tValueSearched) {
+			return *reinterpret_cast<const size_t*>(tValue) == *reinterpret_cast<const size_t*>(tValueSearched);
+		}
+
+		static Status copyKey(void* dstKey, const void* srcKey, TreeMap* tm) {
+			*reinterpret_cast<size_t*>(dstKey) = *reinterpret_cast<const size_t*>(srcKey);
+
+			return Status::SUCCESS;
+		}
+
+		static Status copyValue(void* dstValue, const void* srcValue, bool replaceValue, TreeMap* tm) {
+			*reinterpret_cast<size_t*>(dstValue) = *reinterpret_cast<const size_t*>(srcValue);
+
+			return Status::SUCCESS;
+		}
+
+		static constexpr FreePair freePair{ nullptr };
+
+		static void makePair(size_t index, Pair* pair, char* text) {
+			pair->key = 2 * index;
+			pair->value = index;
+		}
+
+		static void releasePair(Pair* pair) {
+		}
+	};
+
+	/*
+	* Callbacks of the tests that compare strings and copy them to the heap.
+	*/
+	struct RealisticCallbacks {
+		using Pair = TreeNodePair;
+
+		static constexpr const char* name{ "realistic" };
+		static constexpr size_t keySize{ sizeof(TreeNodeKey) };
+		static constexpr size_t valueSize{ sizeof(TreeNodeValue) };
+		static constexpr size_t textSize{ 48 };
+
+		static long compareKey(const void* tKey, const void* insertedKey) {
+			return compareTreeNodeKey(tKey, insertedKey);
+		}
+
+		static bool equalsValue(const void* tValue, const void* tValueSearched) {
+			return equalsTreeNodeValue(tValue, tValueSearched);
+		}
+
+		static Status copyKey(void* dstKey, const void* srcKey, TreeMap* tm) {
+			return copyTreeNodeKey(dstKey, srcKey, tm);
+		}
+
+		static Status copyValue(void* dstValue, const void* srcValue, bool replaceValue, TreeMap* tm) {
+			return copyTreeNodeValue(dstValue, srcValue, replaceValue, tm);
+		}
+
+		static constexpr FreePair freePair{ freeTreeNodePair };
+
+		static void makePair(size_t index, Pair* pair, char* text) {
+			char* capitalCity{ text + textSize / 2 };
+			int nameLength{ std::snprintf(text, textSize / 2, "state%015zu", 2 * index) };
+
+			std::snprintf(capitalCity, textSize / 2, "capital%zu", index);
+
+			pair->key = { text, static_cast<size_t>(nameLength) };
+			pair->value = { capitalCity, static_cast<unsigned short>(1800 + index % 200), static_cast<unsigned int>(index) };
+		}
+
+		static void releasePair(Pair* pair) {
+			freeTreeNodePair(pair);
+			*pair = {};
+		}
+	};
+
+	/*
+	* Wraps the callbacks so that every call is counted and timed. The cycles of the
+	* timestamps are measured once and removed from the reported split.
+	*/
+	template <typename Callbacks>
+	struct ProfiledCallbacks : Callbacks {
+		static constexpr bool profiled{ true };
+
+		static void record(CallbackKind kind, uint64_t start) {
+			profile.cycles[kind] += readCycles() - start;
+			profile.calls[kind]++;
+		}
+
+		static long compareKey(const void* tKey, const void* insertedKey) {
+			uint64_t start{ readCycles() };
+			long result{ Callbacks::compareKey(tKey, insertedKey) };
+
+			record(COMPARE_KEY, start);
+
+			return result;
+		}
+
+		static bool equalsValue(const void* tValue, const void* tValueSearched) {
+			uint64_t start{ readCycles() };
+			bool result{ Callbacks::equalsValue(tValue, tValueSearched) };
+
+			record(EQUALS_VALUE, start);
+
+			return result;
+		}
+
+		static Status copyKey(void* dstKey, const void* srcKey, TreeMap* tm) {
+			uint64_t start{ readCycles() };
+			Status result{ Callbacks::copyKey(dstKey, srcKey, tm) };
+
+			record(COPY_KEY, start);
+
+			return result;
+		}
+
+		static Status copyValue(void* dstValue, const void* srcValue, bool replaceValue, TreeMap* tm) {
+			uint64_t start{ readCycles() };
+			Status result{ Callbacks::copyValue(dstValue, srcValue, replaceValue, tm) };
+
+			record(COPY_VALUE, start);
+
+			return result;
+		}
+
+		static void profiledFreePair(void* treeNodePair) {
+			uint64_t start{ readCycles() };
+
+			Callbacks::freePair(treeNodePair);
+			record(FREE_PAIR, start);
+		}
+
+		static constexpr FreePair freePair{ Callbacks::freePair == nullptr ? nullptr : profiledFreePair };
+	};
+
+	/*
+	* Indicator if the callbacks are wrapped by ProfiledCallbacks.
+	*/
+	template <typename Callbacks, typename = void>
+	struct IsProfiled : std::false_type {};
+
+	template <typename Callbacks>
+	struct IsProfiled<Callbacks, std::void_t<decltype(Callbacks::profiled)>> : std::true_type {};
+
+	/*
+	* Cycles that the profiling adds to a callback. The inner part is counted as callback
+	* time, the whole overhead inflates the measured time of the operation.
+	*/
+	struct ProfilingOverhead {
+		double inner;
+		double whole;
+	};
+
+	/*
+	* Measures the profiling overhead once with the trivial number comparison.
+	*/
+	const ProfilingOverhead& getProfilingOverhead() {
+		static const ProfilingOverhead overhead{ [] {
+			constexpr size_t calls{ 1 << 20 };
+
+			CallbackProfile saved{ profile };
+			KeyComparison plain{ TrivialCallbacks::compareKey }, profiled{ ProfiledCallbacks<TrivialCallbacks>::compareKey };
+			size_t key{ 0 };
+
+			benchmark::DoNotOptimize(plain);
+			benchmark::DoNotOptimize(profiled);
+
+			uint64_t start{ readCycles() };
+
+			for (size_t i{ 0 }; i < calls; i++) {
+				benchmark::DoNotOptimize(plain(&key, &key));
+			}
+
+			uint64_t plainCycles{ readCycles() - start };
+
+			profile = {};
+			start = readCycles();
+
+			for (size_t i{ 0 }; i < calls; i++) {
+				benchmark::DoNotOptimize(profiled(&key, &key));
+			}
+
+			uint64_t profiledCycles{ readCycles() - start };
+
+			// The comparison itself takes a cycle or two, the rest are the timestamps.
+			ProfilingOverhead result{ static_cast<double>(profile.cycles[COMPARE_KEY]) / calls,
+				(static_cast<double>(profiledCycles) - plainCycles) / calls };
+
+			profile = saved;
+
+			return result;
+		}() };
+
+		return overhead;
+	}
+
+	/*
+	* Pairs of the indices 0 to N - 1 in a uniform random order together with the
+	* strings they point to, so creating them isn't part of the measurement.
+	*/
+	template <typename Callbacks>
+	class PairSource {
+	public:
+		explicit PairSource(size_t amount) : pairs(amount), texts(amount * Callbacks::textSize) {
+			std::vector<uint32_t> order{ createKeyOrder(KeyDistribution::UNIFORM, amount) };
+
+			for (size_t i{ 0 }; i < amount; i++) {
+				Callbacks::makePair(order[i], &pairs[i], texts.data() + i * Callbacks::textSize);
+			}
+		}
+
+		std::vector<typename Callbacks::Pair> pairs;
+
+	private:
+		std::vector<char> texts;
+	};
+
+	template <typename Callbacks>
+	TreeMap* createCallbackMap() {
+		Status s;
+
+		return createTreeMap(Callbacks::keySize, Callbacks::valueSize, Callbacks::compareKey,
+			Callbacks::equalsValue, Callbacks::copyKey, Callbacks::copyValue, Callbacks::freePair, &s);
+	}
+
+	template <typename Callbacks>
+	void fillCallbackMap(TreeMap* tm, const PairSource<Callbacks>& source) {
+		for (const auto& pair : source.pairs) {
+			putPair(tm, &pair);
+		}
+	}
+
+	/*
+	* Operation of the benchmark. The prepare function runs while the timing is paused,
+	* the run function executes the operations that are measured.
+	*/
+	template <typename Callbacks>
+	struct CallbackOperation {
+		const char* name;
+		void (*prepare)(TreeMap* tm, const PairSource<Callbacks>& source, std::vector<typename Callbacks::Pair>& results);
+		void (*run)(TreeMap* tm, const PairSource<Callbacks>& source, std::vector<typename Callbacks::Pair>& results);
+		size_t (*getOperations)(size_t amount);
+	};
+
+	template <typename Callbacks>
+	void releaseResults(std::vector<typename Callbacks::Pair>& results) {
+		for (auto& pair : results) {
+			Callbacks::releasePair(&pair);
+		}
+	}
+
+	template <typename Callbacks>
+	std::vector<CallbackOperation<Callbacks>> getCallbackOperations() {
+		using Pair = typename Callbacks::Pair;
+		using Source = PairSource<Callbacks>;
+
+		auto amountOperations{ [](size_t amount) { return amount; } };
+		auto keepMap{ [](TreeMap*, const Source&, std::vector<Pair>& results) { releaseResults<Callbacks>(results); } };
+		auto fillMap{ [](TreeMap* tm, const Source& source, std::vector<Pair>& results) {
+			releaseResults<Callbacks>(results);
+			clearTreeMap(tm);
+			fillCallbackMap(tm, source);
+		} };
+
+		return {
+			{ "putPair", [](TreeMap* tm, const Source&, std::vector<Pair>&) { clearTreeMap(tm); },
+				[](TreeMap* tm, const Source& source, std::vector<Pair>&) {
+					for (const Pair& pair : source.pairs) {
+						putPair(tm, &pair);
+					}
+				}, amountOperations },
+			{ "getValue", keepMap, [](TreeMap* tm, const Source& source, std::vector<Pair>& results) {
+					for (size_t i{ 0 }; i < source.pairs.size(); i++) {
+						getValue(tm, &source.pairs[i].key, &results[i].value);
+					}
+				}, amountOperations },
+			{ "containsKey", keepMap, [](TreeMap* tm, const Source& source, std::vector<Pair>&) {
+					for (const Pair& pair : source.pairs) {
+						benchmark::DoNotOptimize(containsKey(tm, &pair.key));
+					}
+				}, amountOperations },
+			{ "floorPair", keepMap, [](TreeMap* tm, const Source& source, std::vector<Pair>& results) {
+					for (size_t i{ 0 }; i < source.pairs.size(); i++) {
+						floorPair(tm, &source.pairs[i].key, &results[i]);
+					}
+				}, amountOperations },
+			{ "ceilingPair", keepMap, [](TreeMap* tm, const Source& source, std::vector<Pair>& results) {
+					for (size_t i{ 0 }; i < source.pairs.size(); i++) {
+						ceilingPair(tm, &source.pairs[i].key, &results[i]);
+					}
+				}, amountOperations },
+			{ "deletePair", fillMap, [](TreeMap* tm, const Source& source, std::vector<Pair>&) {
+					for (const Pair& pair : source.pairs) {
+						deletePair(tm, &pair.key, nullptr);
+					}
+				}, amountOperations },
+			{ "pollFirstPair", fillMap, [](TreeMap* tm, const Source& source, std::vector<Pair>& results) {
+					for (Pair& pair : results) {
+						pollFirstPair(tm, &pair);
+					}
+				}, amountOperations },
+			{ "clearTreeMap", fillMap, [](TreeMap* tm, const Source&, std::vector<Pair>&) { clearTreeMap(tm); },
+				[](size_t) { return size_t{ 1 }; } }
+		};
+	}
+
+	/*
+	* Runs an operation on a treemap with the given amount of pairs. The profiled callbacks
+	* add the callbacks per operation and the cycles of the library and the callbacks.
+	*/
+	template <typename Callbacks, typename OperationCallbacks>
+	void benchmarkCallbacks(benchmark::State& state, size_t amount, CallbackOperation<OperationCallbacks> operation) {
+		PairSource<OperationCallbacks> source{ amount };
+		std::vector<typename Callbacks::Pair> results(amount);
+		TreeMap* tm{ createCallbackMap<Callbacks>() };
+		uint64_t cycles{ 0 };
+
+		fillCallbackMap(tm, source);
+		profile = {};
+
+		for (auto _ : state) {
+			// The callbacks of the preparation don't belong to the operation.
+			CallbackProfile measured{ profile };
+
+			state.PauseTiming();
+			operation.prepare(tm, source, results);
+			state.ResumeTiming();
+
+			profile = measured;
+
+			uint64_t start{ readCycles() };
+
+			operation.run(tm, source, results);
+			cycles += readCycles() - start;
+		}
+
+		size_t operations{ state.iterations() * operation.getOperations(amount) };
+
+		reportTimePerOperation(state, operations);
+
+		if constexpr (IsProfiled<Callbacks>::value) {
+			const ProfilingOverhead& overhead{ getProfilingOverhead() };
+			double callbackCycles{ 0.0 }, totalCycles{ static_cast<double>(cycles) };
+
+			for (size_t kind{ 0 }; kind < CALLBACK_KINDS; kind++) {
+				state.counters[std::string{ callbackNames[kind] } + "_per_op"] = static_cast<double>(profile.calls[kind]) / operations;
+
+				// Removes the cycles of the timestamps from the callbacks and the operation.
+				callbackCycles += std::max(0.0, profile.cycles[kind] - overhead.inner * profile.calls[kind]);
+				totalCycles -= overhead.whole * profile.calls[kind];
+			}
+
+			totalCycles = std::max(totalCycles, callbackCycles);
+
+			state.counters["library_cycles_per_op"] = (totalCycles - callbackCycles) / operations;
+			state.counters["callback_cycles_per_op"] = callbackCycles / operations;
+			state.counters["callback_share"] = totalCycles == 0.0 ? 0.0 : callbackCycles / totalCycles;
+		}
+
+		releaseResults<OperationCallbacks>(results);
+		deleteTreeMap(tm);
+	}
+
+	template <typename Callbacks>
+	void registerCallbackSetBenchmarks(size_t amount) {
+		for (const auto& operation : getCallbackOperations<Callbacks>()) {
+			std::string name{ std::string{ "callbacks/" } + operation.name + "/" + Callbacks::name + "/" };
+
+			benchmark::RegisterBenchmark((name + "plain/" + std::to_string(amount)).c_str(),
+				benchmarkCallbacks<Callbacks, Callbacks>, amount, operation)->Unit(benchmark::kMillisecond);
+			benchmark::RegisterBenchmark((name + "profiled/" + std::to_string(amount)).c_str(),
+				benchmarkCallbacks<ProfiledCallbacks<Callbacks>, Callbacks>, amount, operation)->Unit(benchmark::kMillisecond);
+		}
+	}
+}
+
+void registerCallbackBenchmarks(size_t maxSize) {
+	for (size_t amount : getBenchmarkSizes(std::min(maxSize, callbackMaxSize))) {
+		registerCallbackSetBenchmarks<TrivialCallbacks>(amount);
+		registerCallbackSetBenchmarks<RealisticCallbacks>(amount);
+	}
+}
@@ -0,0 +1,714 @@
+; @file tree_map_checkpoint.asm
+;
+; Defines the checkpoints of treemaps. A checkpoint writes a snapshot of the pairs as they were when
+; it began, while the treemap keeps being modified. The records are written in slices of a given size,
+; so a background thread that holds the lock of the treemap only for one slice at a time never stalls
+; the writers for the whole traversal.
+;
+; The checkpoint copies a pair right before it changes for the first time, as long as its key wasn't
+; written yet. Keys that are inserted after the start are remembered, so that they are skipped. The
+; records are merged in key order out of the unchanged treenodes and the copies, which makes the file
+; a snapshot that loadTreeMap reads like any other. A mutation pays O(log N) for the copy, never more.
+;
+; @author Collector
+; @date 03/09/2023
+
+	include tree_map.inc
+
+	.code
+
+
+	public beginCheckpoint
+
+; Starts a checkpoint of the treemap and writes the header of the snapshot. The pairs are written
+; by continueCheckpoint. Without a serialize function the bytes of the pairs are written as they are,
+; otherwise the function turns every pair into a record of at most the given size.
+;
+; @RCX qword[in,out] - Pointer to the treemap whose pairs are written.
+; @RDX qword[in,out] - FILE pointer the snapshot is written to.
+; @R8 qword[in] - SerializePair function or a nullptr for the raw bytes of the pairs.
+; @R9 qword[in] - Maximum size of a record in bytes. It is ignored without a serialize function.
+;
+; @return A status value for success, fileNullptr, inlineSizeMismatch for inline pairs, valueDictionaryExists,
+;		  checkpointMultiMap, checkpointRunning, errSerializePair, errHeapAllocation or treeMapNullptr.
+beginCheckpoint proc
+
+	push rsi
+	push rdi
+	push r12
+	sub rsp, shadowStorage
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the file is a nullptr.
+	mov eax, fileNullptr
+	cmp rdx, nullptr
+	je functionReturn
+
+	; The pairs of inline treenodes and interned values point outside of the treenodes.
+	mov eax, inlineSizeMismatch
+	test [rcx].TreeMap.flags, inlinePairsFlag
+	jnz functionReturn
+
+	mov eax, valueDictionaryExists
+	cmp [rcx].TreeMap.valueDictionary, nullptr
+	jne functionReturn
+
+	; The pairs of a multimap can't be told apart by their key.
+	mov eax, checkpointMultiMap
+	test [rcx].TreeMap.flags, multiMapFlag
+	jnz functionReturn
+
+	mov eax, checkpointRunning
+	cmp [rcx].TreeMap.checkpoint, nullptr
+	jne functionReturn
+
+	; The checkpoint walks the tree in slices without faulting treenodes in,
+	; so they are faulted in now and nothing is spilled until it ends.
+	call restoreSpilledTreeMap
+
+	cmp eax, success
+	jne functionReturn
+
+	; Save the treemap and open the stream.
+	mov rsi, rcx
+	mov rcx, rdx
+	mov rdx, r8
+	mov r8, r9
+	call openSnapshotStream
+
+	cmp eax, success
+	jne functionReturn
+
+	; The copy of the cursor key follows the checkpoint.
+	mov rcx, [rsi].TreeMap.keySize
+	add rcx, sizeof Checkpoint
+	call malloc
+
+	cmp rax, nullptr
+	je heapAllocationError
+
+	mov rdi, rax
+	mov [rdi].Checkpoint.stream, r12
+	mov [rdi].Checkpoint.savedPairs, nullptr
+	mov [rdi].Checkpoint.addedPairs, nullptr
+	mov [rdi].Checkpoint.cursor, nullptr
+	mov rax, [rsi].TreeMap.nodeAmount
+	mov [rdi].Checkpoint.pairAmount, rax
+	mov [rdi].Checkpoint.writtenAmount, 0
+	mov [rdi].Checkpoint.status, success
+	mov [rsi].TreeMap.checkpoint, rdi
+
+	; Both treemaps copy the pairs like the treemap does.
+	call createSiblingTreeMap
+
+	mov [rdi].Checkpoint.savedPairs, rax
+	cmp rax, nullptr
+	je cancelError
+
+	call createSiblingTreeMap
+
+	mov [rdi].Checkpoint.addedPairs, rax
+	cmp rax, nullptr
+	je cancelError
+
+	call writeSnapshotHeader
+
+	mov eax, success
+
+	jmp functionReturn
+
+cancelError:
+	; Releases the stream and whatever was created.
+	mov rcx, rsi
+	call cancelCheckpoint
+
+	mov eax, errHeapAllocation
+
+	jmp functionReturn
+
+heapAllocationError:
+	call closeSnapshotStream
+
+	mov eax, errHeapAllocation
+
+functionReturn:
+	add rsp, shadowStorage
+	pop r12
+	pop rdi
+	pop rsi
+	ret
+
+beginCheckpoint endp
+
+
+; Creates an empty treemap with the pair sizes and the functions of the treemap.
+;
+; @RSI qword[in] - Pointer to the treemap whose sizes and functions are taken.
+;
+; @return The new treemap or a nullptr.
+createSiblingTreeMap proc
+
+	sub rsp, shadowStorage + 5 * qwordSize
+
+	mov rax, [rsi].TreeMap.copyKeyFunc
+	mov [rsp + shadowStorage], rax
+	mov rax, [rsi].TreeMap.copyValueFunc
+	mov [rsp + shadowStorage + qwordSize], rax
+	mov rax, [rsi].TreeMap.freePairFunc
+	mov [rsp + shadowStorage + 2 * qwordSize], rax
+	lea rax, [rsp + shadowStorage + 4 * qwordSize]
+	mov [rsp + shadowStorage + 3 * qwordSize], rax
+
+	mov rcx, [rsi].TreeMap.keySize
+	mov rdx, [rsi].TreeMap.valueSize
+	mov r8, [rsi].TreeMap.compareKeyFunc
+	mov r9, [rsi].TreeMap.equalsValueFunc
+	call createTreeMap
+
+	add rsp, shadowStorage + 5 * qwordSize
+	ret
+
+createSiblingTreeMap endp
+
+
+	public continueCheckpoint
+
+; Writes the next records of the running checkpoint in key order. A record is the pair that was
+; copied before it changed or the unchanged pair inside the treemap. The treemap can be modified
+; between the calls. After the last record the trailer is written and the checkpoint is finished.
+;
+; @RCX qword[in,out] - Pointer to the treemap whose checkpoint is continued.
+; @RDX qword[in] - Maximum amount of records written by this call, zero finishes the checkpoint.
+;
+; @return A status value for success if the checkpoint is finished, checkpointPending if another call is needed,
+;		  checkpointNullptr, errSerializePair, errFileIo, errHeapAllocation or treeMapNullptr. The checkpoint is
+;		  cancelled after an error.
+continueCheckpoint proc
+
+	push rbx
+	push rsi
+	push rdi
+	push r12
+	push r13
+	push r14
+	push r15
+	sub rsp, shadowStorage
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if a checkpoint is running.
+	mov eax, checkpointNullptr
+	mov rdi, [rcx].TreeMap.checkpoint
+	cmp rdi, nullptr
+	je functionReturn
+
+	; Save the treemap and the budget, r14 counts the written records.
+	mov rsi, rcx
+	mov r12, [rdi].Checkpoint.stream
+	mov r13, rdx
+	mov r14, 0
+
+	; A failed copy inside a mutation makes the snapshot incomplete.
+	mov eax, dword ptr [rdi].Checkpoint.status
+	cmp eax, success
+	jne cancelStatus
+
+nextRecord:
+	cmp r13, 0
+	je searchTreeNode
+
+	mov eax, checkpointPending
+	cmp r14, r13
+	jae functionReturn
+
+searchTreeNode:
+	; Search the next unchanged pair after the cursor. Copied and
+	; added keys are skipped, they don't belong to the treemap as it was.
+	mov rcx, rsi
+	mov rdx, [rdi].Checkpoint.cursor
+	mov r8b, false
+	call findHigherTreeNode
+
+	mov rbx, rax
+
+skipChangedPairs:
+	cmp rbx, nullptr
+	je searchSavedPair
+
+	mov rcx, [rdi].Checkpoint.savedPairs
+	mov rdx, rbx
+	call containsKey
+
+	cmp eax, success
+	je skipTreeNode
+
+	mov rcx, [rdi].Checkpoint.addedPairs
+	mov rdx, rbx
+	call containsKey
+
+	cmp eax, success
+	jne searchSavedPair
+
+skipTreeNode:
+	mov rcx, rsi
+	mov rdx, rbx
+	mov r8b, false
+	call findHigherTreeNode
+
+	mov rbx, rax
+
+	jmp skipChangedPairs
+
+searchSavedPair:
+	; Search the next copied pair after the cursor.
+	mov rcx, [rdi].Checkpoint.savedPairs
+	mov rdx, [rdi].Checkpoint.cursor
+	mov r8b, false
+	call findHigherTreeNode
+
+	mov r15, rax
+
+	; The smaller key of both is written next.
+	cmp rbx, nullptr
+	je takeSavedPair
+
+	cmp r15, nullptr
+	je writeRecord
+
+	mov rcx, rbx
+	mov rdx, r15
+	countTreeMapEvent rsi, comparisons
+	callUserFunc [rsi].TreeMap.compareKeyFunc
+
+	cmp eax, 0
+	jg writeRecord
+
+takeSavedPair:
+	mov rbx, r15
+
+	cmp rbx, nullptr
+	je finishCheckpoint
+
+writeRecord:
+	mov rcx, rbx
+	call writeSnapshotRecord
+
+	cmp eax, success
+	jne cancelStatus
+
+	; The cursor copies the written key, because its treenode can be moved or deleted.
+	mov rcx, [rsi].TreeMap.keySize
+	lea rdx, [rdi + sizeof Checkpoint]
+
+copyCursorKey:
+	mov al, [rbx + rcx - 1]
+	mov [rdx + rcx - 1], al
+	dec rcx
+	jnz copyCursorKey
+
+	mov [rdi].Checkpoint.cursor, rdx
+	inc [rdi].Checkpoint.writtenAmount
+	inc r14
+
+	jmp nextRecord
+
+finishCheckpoint:
+	; Every pair of the header has to be written.
+	mov eax, snapshotInvalid
+	mov rcx, [rdi].Checkpoint.writtenAmount
+	cmp rcx, [rdi].Checkpoint.pairAmount
+	jne cancelStatus
+
+	call writeSnapshotTrailer
+
+cancelStatus:
+	; The checkpoint is released after its last record or an error.
+	mov r14d, eax
+	mov rcx, rsi
+	call cancelCheckpoint
+
+	mov eax, r14d
+
+functionReturn:
+	add rsp, shadowStorage
+	pop r15
+	pop r14
+	pop r13
+	pop r12
+	pop rdi
+	pop rsi
+	pop rbx
+	ret
+
+continueCheckpoint endp
+
+
+	public cancelCheckpoint
+
+; Stops the running checkpoint and frees the copied pairs. The file stays open
+; and holds an incomplete snapshot, unless the checkpoint was finished.
+;
+; @RCX qword[in,out] - Pointer to the treemap whose checkpoint is cancelled.
+;
+; @return A status value for success, checkpointNullptr or treeMapNullptr.
+cancelCheckpoint proc
+
+	push rsi
+	push r12
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if a checkpoint is running.
+	mov eax, checkpointNullptr
+	mov rsi, [rcx].TreeMap.checkpoint
+	cmp rsi, nullptr
+	je functionReturn
+
+	; The mutations stop copying pairs before they are freed.
+	mov [rcx].TreeMap.checkpoint, nullptr
+
+	; deleteTreeMap ignores a nullptr.
+	mov rcx, [rsi].Checkpoint.savedPairs
+	call deleteTreeMap
+
+	mov rcx, [rsi].Checkpoint.addedPairs
+	call deleteTreeMap
+
+	mov r12, [rsi].Checkpoint.stream
+	call closeSnapshotStream
+
+	mov rcx, rsi
+	call free
+
+	mov eax, success
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop r12
+	pop rsi
+	ret
+
+cancelCheckpoint endp
+
+
+; Copies the pair of the key before a mutation changes it, if the running checkpoint still has to write it.
+; A key that doesn't exist yet is remembered as added when the inserted pair is given. A pair that
+; can't be copied fails the checkpoint, the mutation itself goes on. All parameter registers are preserved.
+;
+; @RCX qword[in] - Pointer to the treemap that is modified.
+; @RDX qword[in] - Pointer to the key that changes or a nullptr for the minimum or maximum key.
+; @R8 qword[in] - Pointer to the pair that is inserted if the key doesn't exist or a nullptr.
+; @R9B byte[in] - searchAsHigher for the maximum and searchAsLower for the minimum key.
+preserveCheckpointPair proc
+
+	push rcx
+	push rdx
+	push r8
+	push r9
+	push rbx
+	push rsi
+	push rdi
+	push r12
+	sub rsp, shadowStorage + qwordSize
+
+	; Save the treemap, the key and the inserted pair.
+	mov rsi, rcx
+	mov rbx, rdx
+	mov r12, r8
+
+	; Nothing is copied without a running checkpoint or after it failed.
+	mov rdi, [rsi].TreeMap.checkpoint
+	cmp rdi, nullptr
+	je functionReturn
+
+	cmp dword ptr [rdi].Checkpoint.status, success
+	jne functionReturn
+
+	cmp rbx, nullptr
+	jne compareCursor
+
+	; Search the minimum or maximum key.
+	mov rax, [rsi].TreeMap.root
+	cmp rax, nullptr
+	je functionReturn
+
+searchOuterTreeNode:
+	mov rbx, rax
+	mov rcx, rbx
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rax, [rcx].TreeNode.left
+
+	cmp r9b, searchAsHigher
+	jne testOuterTreeNode
+
+	mov rax, [rcx].TreeNode.right
+
+testOuterTreeNode:
+	cmp rax, nullptr
+	jne searchOuterTreeNode
+
+compareCursor:
+	; Keys up to the cursor were written already. The cursor key itself is
+	; copied too, so that the cursor doesn't point at a changed key.
+	mov dword ptr [rsp + cursorOrder], 1
+	mov rcx, [rdi].Checkpoint.cursor
+	cmp rcx, nullptr
+	je searchCopiedKey
+
+	mov rdx, rbx
+	countTreeMapEvent rsi, comparisons
+	callUserFunc [rsi].TreeMap.compareKeyFunc
+
+	mov [rsp + cursorOrder], eax
+	cmp eax, 0
+	jl functionReturn
+
+searchCopiedKey:
+	; Only the first change of a key is copied.
+	mov rcx, [rdi].Checkpoint.savedPairs
+	mov rdx, rbx
+	call containsKey
+
+	cmp eax, success
+	je functionReturn
+
+	mov rcx, [rdi].Checkpoint.addedPairs
+	mov rdx, rbx
+	call containsKey
+
+	cmp eax, success
+	je functionReturn
+
+	mov rcx, [rsi].TreeMap.root
+	mov rdx, rbx
+	mov r8, rsi
+	call findAddressOfKey
+
+	cmp rax, nullptr
+	jne copyPairOfKey
+
+	; A new key is only remembered if it's inserted.
+	cmp r12, nullptr
+	je functionReturn
+
+	mov rcx, [rdi].Checkpoint.addedPairs
+	mov rdx, r12
+	call putPair
+
+	cmp eax, success
+	jne checkpointError
+
+	jmp functionReturn
+
+copyPairOfKey:
+	mov rcx, [rdi].Checkpoint.savedPairs
+	mov rdx, rax
+	call putPair
+
+	cmp eax, success
+	jne checkpointError
+
+	; The cursor moves over to the copy of its key.
+	cmp dword ptr [rsp + cursorOrder], 0
+	jne functionReturn
+
+	mov r8, [rdi].Checkpoint.savedPairs
+	mov rcx, [r8].TreeMap.root
+	mov rdx, rbx
+	call findAddressOfKey
+
+	mov rcx, [rsi].TreeMap.keySize
+	mov rdx, [rdi].Checkpoint.cursor
+
+copyCursorKey:
+	mov r8b, [rax + rcx - 1]
+	mov [rdx + rcx - 1], r8b
+	dec rcx
+	jnz copyCursorKey
+
+	jmp functionReturn
+
+checkpointError:
+	mov dword ptr [rdi].Checkpoint.status, eax
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop r12
+	pop rdi
+	pop rsi
+	pop rbx
+	pop r9
+	pop r8
+	pop rdx
+	pop rcx
+	ret
+
+preserveCheckpointPair endp
+
+
+; Copies the pairs of the old and the new key before rekeyPair changes them. If the new key doesn't
+; exist yet, the pair that rekeyPair creates has the new key and the value of the old pair.
+; All parameter registers are preserved.
+;
+; @RCX qword[in] - Pointer to the treemap that is modified.
+; @RDX qword[in] - Pointer to the old key.
+; @R8 qword[in] - Pointer to the new key.
+preserveCheckpointRekey proc
+
+	push rcx
+	push rdx
+	push r8
+	push r9
+	push rsi
+	push rdi
+	push r12
+	sub rsp, shadowStorage
+
+	; Save the treemap and the new key.
+	mov rsi, rcx
+	mov r12, r8
+
+	mov r8, nullptr
+	call preserveCheckpointPair
+
+	; Without the old pair rekeyPair fails and nothing is inserted.
+	mov rcx, [rsi].TreeMap.root
+	mov r8, rsi
+	call findAddressOfKey
+
+	cmp rax, nullptr
+	je functionReturn
+
+	mov rdi, rax
+
+	; Build the pair that rekeyPair inserts.
+	mov rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	call malloc
+
+	cmp rax, nullptr
+	je heapAllocationError
+
+	mov rcx, rax
+	mov rdx, r12
+	mov r8, [rsi].TreeMap.keySize
+	mov r12, rax
+	call memcpy
+
+	mov rcx, r12
+	add rcx, [rsi].TreeMap.keySize
+	mov rdx, rdi
+	add rdx, [rsi].TreeMap.keySize
+	mov r8, [rsi].TreeMap.valueSize
+	call memcpy
+
+	mov rcx, rsi
+	mov rdx, r12
+	mov r8, r12
+	call preserveCheckpointPair
+
+	mov rcx, r12
+	call free
+
+	jmp functionReturn
+
+heapAllocationError:
+	; The checkpoint can't tell if the new key was added.
+	mov rax, [rsi].TreeMap.checkpoint
+	mov dword ptr [rax].Checkpoint.status, errHeapAllocation
+
+functionReturn:
+	add rsp, shadowStorage
+	pop r12
+	pop rdi
+	pop rsi
+	pop r9
+	pop r8
+	pop rdx
+	pop rcx
+	ret
+
+preserveCheckpointRekey endp
+
+
+; Searches the treenode with the smallest key bigger than the given one, or equal to it if the search is inclusive.
+;
+; @RCX qword[in] - Pointer to the treemap that is searched.
+; @RDX qword[in] - Pointer to the key or a nullptr for the minimum key.
+; @R8B byte[in] - True if an equal key is accepted.
+;
+; @return The treenode or a nullptr.
+findHigherTreeNode proc
+
+	push rbx
+	push rsi
+	push rdi
+	push r12
+	push r13
+	sub rsp, shadowStorage
+
+	mov rsi, rcx
+	mov rdi, rdx
+	movzx r13d, r8b
+	mov rbx, [rsi].TreeMap.root
+	mov r12, nullptr
+
+searchTreeNode:
+	cmp rbx, nullptr
+	je functionReturn
+
+	; Without a key every treenode is bigger.
+	cmp rdi, nullptr
+	je searchLeft
+
+	; The compare function returns the sign of the key minus the treenode key,
+	; which has to be below one for an inclusive and below zero for any other search.
+	mov rcx, rbx
+	mov rdx, rdi
+	countTreeMapEvent rsi, comparisons
+	callUserFunc [rsi].TreeMap.compareKeyFunc
+
+	cmp eax, r13d
+	jge searchRight
+
+searchLeft:
+	; The treenode is a candidate, a smaller one can only be on the left.
+	mov r12, rbx
+	add rbx, [rsi].TreeMap.keySize
+	add rbx, [rsi].TreeMap.valueSize
+	mov rbx, [rbx].TreeNode.left
+
+	jmp searchTreeNode
+
+searchRight:
+	add rbx, [rsi].TreeMap.keySize
+	add rbx, [rsi].TreeMap.valueSize
+	mov rbx, [rbx].TreeNode.right
+
+	jmp searchTreeNode
+
+functionReturn:
+	mov rax, r12
+	add rsp, shadowStorage
+	pop r13
+	pop r12
+	pop rdi
+	pop rsi
+	pop rbx
+	ret
+
+findHigherTreeNode endp
+
+end
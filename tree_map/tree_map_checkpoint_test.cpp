@@ -0,0 +1,325 @@
+/*
+* @file tree_map_checkpoint_test.h
+*
+* Defines unit tests for the checkpoints of the tree map
+* implementation.
+*
+* @author Collector
+* @data 03/09/2023
+*/
+
+
+#include <thread>
+#include <mutex>
+
+#include "utils.h"
+
+namespace {
+	/*
+	* Amount of pairs of the treemaps that are checkpointed while they change.
+	*/
+	constexpr size_t PAIR_AMOUNT{ 1000 };
+
+	/*
+	* Loads the finished checkpoint of a treemap of numbers and asserts that it holds the
+	* pairs of createTestNumberTree with the given amount and a step of 1.
+	*
+	* @param[in, out] file - File of the checkpoint.
+	* @param[in] amount - Amount of pairs the treemap had when the checkpoint began.
+	*/
+	void assertCheckpointOfNumbers(FILE* file, size_t amount) {
+		Status s;
+		TreeMap* loaded{ createTreeMap(sizeof(size_t), sizeof(size_t), compareNumberKey,
+			equalsNumberValue, copyNumberKey, copyNumberValue, nullptr, &s) };
+
+		rewind(file);
+
+		s = loadTreeMap(loaded, file, nullptr);
+
+		EXPECT_EQ(Status::SUCCESS, s);
+		EXPECT_EQ(amount, loaded->nodeAmount);
+
+		for (size_t key{ 0 }; key < amount; key++) {
+			size_t value{ 0 };
+
+			EXPECT_EQ(Status::SUCCESS, getValue(loaded, &key, &value));
+			EXPECT_EQ(key * key, value);
+		}
+
+		deleteTreeMap(loaded);
+	}
+
+	/*
+	* Continues the checkpoint in small slices until it is finished. Each slice holds
+	* the lock, so the writer of the treemap waits for one slice at most.
+	*
+	* @param[in, out] tm - Treemap whose checkpoint is continued.
+	* @param[in, out] lock - Lock that guards the treemap.
+	* @param[out] status - Status of the last slice.
+	*/
+	void continueInSlices(TreeMap* tm, std::mutex* lock, Status* status) {
+		do {
+			std::lock_guard<std::mutex> guard{ *lock };
+
+			*status = continueCheckpoint(tm, 16);
+		} while (*status == Status::CHECKPOINT_PENDING);
+	}
+}
+
+TEST(TreeMap, beginCheckpointShouldFailForInvalidParameters) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(10, 1) };
+	TreeMap* multiMap{ createTestMultiMap() };
+	FILE* file{ createTemporaryFile() };
+
+	s = beginCheckpoint(nullptr, file, nullptr, 0);
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, s);
+
+	s = beginCheckpoint(tm, nullptr, nullptr, 0);
+
+	ASSERT_EQ(Status::FILE_NULLPTR, s);
+
+	s = beginCheckpoint(multiMap, file, nullptr, 0);
+
+	ASSERT_EQ(Status::CHECKPOINT_MULTI_MAP, s);
+
+	s = continueCheckpoint(tm, 0);
+
+	ASSERT_EQ(Status::CHECKPOINT_NULLPTR, s);
+
+	s = beginCheckpoint(tm, file, nullptr, 0);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	s = beginCheckpoint(tm, file, nullptr, 0);
+
+	ASSERT_EQ(Status::CHECKPOINT_RUNNING, s);
+
+	s = cancelCheckpoint(tm);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	s = cancelCheckpoint(tm);
+
+	ASSERT_EQ(Status::CHECKPOINT_NULLPTR, s);
+
+	fclose(file);
+	deleteTreeMap(multiMap);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, checkpointShouldWriteTheTreeMapAsItBegan) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(PAIR_AMOUNT, 1) };
+	FILE* file{ createTemporaryFile() };
+
+	s = beginCheckpoint(tm, file, nullptr, 0);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	// Every slice is followed by mutations in front of, at and behind the cursor.
+	size_t slice{ 0 };
+
+	do {
+		s = continueCheckpoint(tm, 50);
+
+		size_t pair[2]{ PAIR_AMOUNT + slice, 1 };
+		size_t deletedKey{ slice * 37 % PAIR_AMOUNT };
+		size_t replacedKey{ PAIR_AMOUNT - 1 - slice * 13 % PAIR_AMOUNT };
+		size_t value{ 7 };
+		size_t oldKey{ slice * 53 % PAIR_AMOUNT }, newKey{ 2 * PAIR_AMOUNT + slice }, keyBuffer{ 0 };
+
+		putPair(tm, pair);
+		deletePair(tm, &deletedKey, nullptr);
+		replaceValue(tm, &replacedKey, &value);
+		rekeyPair(tm, &oldKey, &newKey, &keyBuffer);
+		pollFirstPair(tm, nullptr);
+		pollLastPair(tm, nullptr);
+
+		slice++;
+	} while (s == Status::CHECKPOINT_PENDING);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(nullptr, tm->checkpoint);
+
+	assertCheckpointOfNumbers(file, PAIR_AMOUNT);
+
+	fclose(file);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, checkpointShouldCopyPolledPairs) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(PAIR_AMOUNT, 1) };
+	FILE* file{ createTemporaryFile() };
+
+	s = beginCheckpoint(tm, file, nullptr, 0);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	// The buffers keep the last polled pairs, which mustn't be mistaken for the keys to copy.
+	size_t firstPair[2]{ PAIR_AMOUNT / 2, 0 };
+	size_t lastPair[2]{ PAIR_AMOUNT / 2, 0 };
+
+	do {
+		s = continueCheckpoint(tm, 16);
+
+		if (tm->nodeAmount > 0) {
+			ASSERT_EQ(Status::SUCCESS, pollFirstPair(tm, firstPair));
+		}
+
+		if (tm->nodeAmount > 0) {
+			ASSERT_EQ(Status::SUCCESS, pollLastPair(tm, lastPair));
+		}
+	} while (s == Status::CHECKPOINT_PENDING);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	assertCheckpointOfNumbers(file, PAIR_AMOUNT);
+
+	fclose(file);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, checkpointShouldCopySerializedPairs) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+	FILE* file{ createTemporaryFile() };
+
+	s = beginCheckpoint(tm, file, serializeTreeNodePair, SNAPSHOT_RECORD_SIZE);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	s = continueCheckpoint(tm, 2);
+
+	ASSERT_EQ(Status::CHECKPOINT_PENDING, s);
+
+	// The copies of the deleted pairs own their nested memory.
+	while (tm->nodeAmount > 0) {
+		pollLastPair(tm, nullptr);
+	}
+
+	s = continueCheckpoint(tm, 0);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	TreeMap* loaded{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeTreeNodePair, &s) };
+
+	rewind(file);
+
+	s = loadTreeMap(loaded, file, deserializeTreeNodePair);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(5, loaded->nodeAmount);
+
+	TreeNode* node{ createTreeNode("Oregon", "Salem", 1859, 4237256, false) };
+	TreeNodeValue result;
+
+	s = getValue(loaded, &node->pair.key, &result);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertTreeNodeValueEquals(&node->pair.value, &result);
+
+	free(result.capitalCity);
+	freeTreeNodes({ node });
+	fclose(file);
+	deleteTreeMap(loaded);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, checkpointShouldFollowCompactedTreeNodes) {
+	Status s;
+	TreeMap* tm{ createTestNodeArenaTree(1024, 0) };
+	FILE* file{ createTemporaryFile() };
+
+	s = beginCheckpoint(tm, file, serializeTreeNodePair, SNAPSHOT_RECORD_SIZE);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	continueCheckpoint(tm, 3);
+
+	// The cursor doesn't point into the relocated treenodes.
+	s = compactTreeMap(tm, 0);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	s = continueCheckpoint(tm, 0);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	TreeMap* loaded{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeTreeNodePair, &s) };
+
+	rewind(file);
+
+	s = loadTreeMap(loaded, file, deserializeTreeNodePair);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(5, loaded->nodeAmount);
+
+	fclose(file);
+	deleteTreeMap(loaded);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, checkpointShouldBeCancelledByClearTreeMap) {
+	Status s;
+	TreeMap* tm{ createTestPayloadTree(256) };
+	FILE* file{ createTemporaryFile() };
+
+	beginCheckpoint(tm, file, serializeTreeNodePair, SNAPSHOT_RECORD_SIZE);
+
+	// The copies could point at the blocks the compaction frees.
+	s = compactPayloadArena(tm, relocateTreeNodePair);
+
+	ASSERT_EQ(Status::CHECKPOINT_RUNNING, s);
+
+	clearTreeMap(tm);
+
+	ASSERT_EQ(nullptr, tm->checkpoint);
+
+	s = continueCheckpoint(tm, 0);
+
+	ASSERT_EQ(Status::CHECKPOINT_NULLPTR, s);
+
+	fclose(file);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, checkpointShouldRunBesideWriters) {
+	Status s;
+	Status checkpointStatus{ Status::SUCCESS };
+	TreeMap* tm{ createTestNumberTree(PAIR_AMOUNT, 1) };
+	FILE* file{ createTemporaryFile() };
+	std::mutex lock;
+
+	s = beginCheckpoint(tm, file, nullptr, 0);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	std::thread checkpointThread{ continueInSlices, tm, &lock, &checkpointStatus };
+
+	// The writer keeps replacing and moving pairs while the checkpoint is written.
+	for (size_t round{ 0 }; round < 5; round++) {
+		for (size_t key{ 0 }; key < PAIR_AMOUNT; key++) {
+			std::lock_guard<std::mutex> guard{ lock };
+			size_t value{ round };
+			size_t pair[2]{ PAIR_AMOUNT + key, key };
+
+			replaceValue(tm, &key, &value);
+			putPair(tm, pair);
+			deletePair(tm, &pair[0], nullptr);
+		}
+	}
+
+	checkpointThread.join();
+
+	ASSERT_EQ(Status::SUCCESS, checkpointStatus);
+
+	assertCheckpointOfNumbers(file, PAIR_AMOUNT);
+
+	fclose(file);
+	deleteTreeMap(tm);
+}
@@ -0,0 +1,490 @@
+/*
+* @file tree_map_compare_bench.cpp
+*
+* Defines the benchmarks that compare the treemap with std::map, absl::btree_map
+* and a sorted vector. Every container stores the TreeNodePair of the tests and
+* owns copies of its strings like the treemap does with its copy functions.
+*
+* @author Collector
+* @data 10/17/2026
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <type_traits>
+
+#ifdef TREE_MAP_BENCH_BTREE
+#include <absl/container/btree_map.h>
+#endif
+
+#include "utils.h"
+#include "bench_utils.h"
+
+namespace {
+	/*
+	* Biggest size for the sorted vector workloads that move half of the vector per operation.
+	* Bigger sizes take hours without showing anything new.
+	*/
+	constexpr size_t sortedVectorMutationLimit{ 100'000 };
+
+	/*
+	* Amount of pairs that are created at once while the timing is paused.
+	*/
+	constexpr size_t pairChunkSize{ 4096 };
+
+	/*
+	* Pair with its own string buffers, the benchmarks create them chunk wise.
+	* The buffers fit the prefixes with the 20 digits of the biggest index.
+	*/
+	struct SourcePair {
+		char stateName[32];
+		char capitalCity[32];
+
+		TreeNodePair pair;
+	};
+
+	/*
+	* Pairs of the current chunk. They are allocated up front, so the heap
+	* measurement of the insert workload only sees the container.
+	*/
+	std::vector<SourcePair> chunk(pairChunkSize);
+
+	void makeSourcePair(size_t index, SourcePair* source) {
+		int nameLength{ std::snprintf(source->stateName, sizeof(source->stateName), "state%015zu", index) };
+
+		std::snprintf(source->capitalCity, sizeof(source->capitalCity), "capital%zu", index);
+
+		source->pair.key = { source->stateName, static_cast<size_t>(nameLength) };
+		source->pair.value = { source->capitalCity, static_cast<unsigned short>(1800 + index % 200),
+			static_cast<unsigned int>(index) };
+	}
+
+	TreeNodePair copyPair(const TreeNodePair& pair) {
+		TreeNodePair result{ pair };
+
+		result.key.stateName = _strdup(pair.key.stateName);
+		result.value.capitalCity = _strdup(pair.value.capitalCity);
+
+		return result;
+	}
+
+	void freePair(const TreeNodeKey& key, const TreeNodeValue& value) {
+		free(key.stateName);
+		free(value.capitalCity);
+	}
+
+	struct KeyLess {
+		bool operator()(const TreeNodeKey& x, const TreeNodeKey& y) const {
+			return std::strcmp(x.stateName, y.stateName) < 0;
+		}
+	};
+
+	/*
+	* Treemap with the test callbacks. The ordered scan walks the treenodes
+	* because the treemap has no iterator.
+	*/
+	class TreeMapContainer {
+	public:
+		static constexpr const char* name{ "treemap" };
+
+		TreeMapContainer() {
+			Status s;
+
+			tm = createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+				equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeTreeNodePair, &s);
+		}
+
+		~TreeMapContainer() {
+			deleteTreeMap(tm);
+		}
+
+		void insert(const TreeNodePair& pair) {
+			putPair(tm, &pair);
+		}
+
+		bool contains(const TreeNodeKey& key) const {
+			return containsKey(tm, &key) == Status::SUCCESS;
+		}
+
+		void erase(const TreeNodeKey& key) {
+			deletePair(tm, &key, nullptr);
+		}
+
+		size_t scan() const {
+			std::vector<const TreeNode*> path;
+			const TreeNode* node{ reinterpret_cast<const TreeNode*>(tm->root) };
+			size_t sum{ 0 };
+
+			while (node != nullptr || !path.empty()) {
+				for (; node != nullptr; node = node->left) {
+					path.push_back(node);
+				}
+
+				node = path.back();
+				path.pop_back();
+
+				sum += node->pair.value.population;
+				node = node->right;
+			}
+
+			return sum;
+		}
+
+		void pollMin() {
+			TreeNodePair pair;
+
+			if (pollFirstPair(tm, &pair) == Status::SUCCESS) {
+				freeTreeNodePair(&pair);
+			}
+		}
+
+	private:
+		TreeMap* tm;
+	};
+
+	/*
+	* Ordered map with the interface of std::map.
+	*/
+	template <typename Map>
+	class OrderedMapContainer {
+	public:
+		~OrderedMapContainer() {
+			for (const auto& entry : map) {
+				freePair(entry.first, entry.second);
+			}
+		}
+
+		void insert(const TreeNodePair& pair) {
+			TreeNodePair copy{ copyPair(pair) };
+
+			if (!map.emplace(copy.key, copy.value).second) {
+				freePair(copy.key, copy.value);
+			}
+		}
+
+		bool contains(const TreeNodeKey& key) const {
+			return map.find(key) != map.end();
+		}
+
+		void erase(const TreeNodeKey& key) {
+			auto found{ map.find(key) };
+
+			if (found != map.end()) {
+				freePair(found->first, found->second);
+				map.erase(found);
+			}
+		}
+
+		size_t scan() const {
+			size_t sum{ 0 };
+
+			for (const auto& entry : map) {
+				sum += entry.second.population;
+			}
+
+			return sum;
+		}
+
+		void pollMin() {
+			if (!map.empty()) {
+				freePair(map.begin()->first, map.begin()->second);
+				map.erase(map.begin());
+			}
+		}
+
+	private:
+		Map map;
+	};
+
+	class StdMapContainer : public OrderedMapContainer<std::map<TreeNodeKey, TreeNodeValue, KeyLess>> {
+	public:
+		static constexpr const char* name{ "std_map" };
+	};
+
+#ifdef TREE_MAP_BENCH_BTREE
+	class BtreeMapContainer : public OrderedMapContainer<absl::btree_map<TreeNodeKey, TreeNodeValue, KeyLess>> {
+	public:
+		static constexpr const char* name{ "btree_map" };
+	};
+#endif
+
+	/*
+	* Vector of pairs that is kept sorted by key.
+	*/
+	class SortedVectorContainer {
+	public:
+		static constexpr const char* name{ "sorted_vector" };
+
+		~SortedVectorContainer() {
+			for (const TreeNodePair& pair : pairs) {
+				freePair(pair.key, pair.value);
+			}
+		}
+
+		void insert(const TreeNodePair& pair) {
+			auto position{ find(pair.key) };
+
+			if (position == pairs.end() || KeyLess{}(pair.key, position->key)) {
+				pairs.insert(position, copyPair(pair));
+			}
+		}
+
+		bool contains(const TreeNodeKey& key) const {
+			auto position{ find(key) };
+
+			return position != pairs.end() && !KeyLess{}(key, position->key);
+		}
+
+		void erase(const TreeNodeKey& key) {
+			auto position{ find(key) };
+
+			if (position != pairs.end() && !KeyLess{}(key, position->key)) {
+				freePair(position->key, position->value);
+				pairs.erase(position);
+			}
+		}
+
+		size_t scan() const {
+			size_t sum{ 0 };
+
+			for (const TreeNodePair& pair : pairs) {
+				sum += pair.value.population;
+			}
+
+			return sum;
+		}
+
+		void pollMin() {
+			if (!pairs.empty()) {
+				freePair(pairs.front().key, pairs.front().value);
+				pairs.erase(pairs.begin());
+			}
+		}
+
+	private:
+		std::vector<TreeNodePair>::const_iterator find(const TreeNodeKey& key) const {
+			return std::lower_bound(pairs.begin(), pairs.end(), key, [](const TreeNodePair& pair, const TreeNodeKey& key) {
+				return KeyLess{}(pair.key, key);
+			});
+		}
+
+		std::vector<TreeNodePair> pairs;
+	};
+
+	/*
+	* Calls the operation for the pairs of all indices in the order. The pairs are created
+	* chunk wise while the timing and the counters are paused.
+	*/
+	template <typename Operation>
+	void runPairOrder(benchmark::State& state, PerfCounters& counters, const std::vector<uint32_t>& order, Operation operation) {
+		for (size_t start{ 0 }; start < order.size(); start += pairChunkSize) {
+			size_t count{ std::min(pairChunkSize, order.size() - start) };
+
+			{
+				BenchmarkPause pause{ state, counters };
+
+				for (size_t i{ 0 }; i < count; i++) {
+					makeSourcePair(order[start + i], &chunk[i]);
+				}
+			}
+
+			for (size_t i{ 0 }; i < count; i++) {
+				operation(chunk[i].pair);
+			}
+		}
+	}
+
+	template <typename Container>
+	void fillContainer(Container& container, size_t amount) {
+		SourcePair source;
+
+		for (size_t i{ 0 }; i < amount; i++) {
+			makeSourcePair(i, &source);
+			container.insert(source.pair);
+		}
+	}
+
+	template <typename Container>
+	void benchmarkInsert(benchmark::State& state, size_t amount) {
+		std::vector<uint32_t> order{ createKeyOrder(KeyDistribution::UNIFORM, amount) };
+		PerfCounters counters;
+		size_t entryBytes{ 0 };
+
+		counters.start();
+
+		for (auto _ : state) {
+			Container* container;
+
+			{
+				BenchmarkPause pause{ state, counters };
+
+				container = new Container{};
+				entryBytes = getHeapBytes();
+			}
+
+			runPairOrder(state, counters, order, [container](const TreeNodePair& pair) {
+				container->insert(pair);
+			});
+
+			BenchmarkPause pause{ state, counters };
+
+			entryBytes = getHeapBytes() - entryBytes;
+			delete container;
+		}
+
+		counters.stop();
+
+		state.counters["bytes_per_entry"] = static_cast<double>(entryBytes) / amount;
+		reportTimePerOperation(state, state.iterations() * amount);
+		counters.report(state, state.iterations() * amount);
+	}
+
+	template <typename Container>
+	void benchmarkLookup(benchmark::State& state, size_t amount) {
+		Container container;
+		std::vector<uint32_t> queries{ createKeyQueries(KeyDistribution::UNIFORM, amount, benchmarkQueryAmount) };
+		std::vector<SourcePair> sources(queries.size());
+		PerfCounters counters;
+		size_t i{ 0 };
+
+		fillContainer(container, amount);
+
+		for (size_t j{ 0 }; j < queries.size(); j++) {
+			makeSourcePair(queries[j], &sources[j]);
+		}
+
+		counters.start();
+
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(container.contains(sources[i++ & (benchmarkQueryAmount - 1)].pair.key));
+		}
+
+		counters.stop();
+
+		reportTimePerOperation(state, state.iterations());
+		counters.report(state, state.iterations());
+	}
+
+	template <typename Container>
+	void benchmarkErase(benchmark::State& state, size_t amount) {
+		std::vector<uint32_t> order{ createKeyOrder(KeyDistribution::UNIFORM, amount) };
+		PerfCounters counters;
+
+		counters.start();
+
+		for (auto _ : state) {
+			Container* container;
+
+			{
+				BenchmarkPause pause{ state, counters };
+
+				container = new Container{};
+				fillContainer(*container, amount);
+			}
+
+			runPairOrder(state, counters, order, [container](const TreeNodePair& pair) {
+				container->erase(pair.key);
+			});
+
+			BenchmarkPause pause{ state, counters };
+
+			delete container;
+		}
+
+		counters.stop();
+
+		reportTimePerOperation(state, state.iterations() * amount);
+		counters.report(state, state.iterations() * amount);
+	}
+
+	template <typename Container>
+	void benchmarkScan(benchmark::State& state, size_t amount) {
+		Container container;
+		PerfCounters counters;
+
+		fillContainer(container, amount);
+		counters.start();
+
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(container.scan());
+		}
+
+		counters.stop();
+
+		reportTimePerOperation(state, state.iterations() * amount);
+		counters.report(state, state.iterations() * amount);
+	}
+
+	template <typename Container>
+	void benchmarkPollMin(benchmark::State& state, size_t amount) {
+		PerfCounters counters;
+
+		counters.start();
+
+		for (auto _ : state) {
+			Container* container;
+
+			{
+				BenchmarkPause pause{ state, counters };
+
+				container = new Container{};
+				fillContainer(*container, amount);
+			}
+
+			for (size_t i{ 0 }; i < amount; i++) {
+				container->pollMin();
+			}
+
+			BenchmarkPause pause{ state, counters };
+
+			delete container;
+		}
+
+		counters.stop();
+
+		reportTimePerOperation(state, state.iterations() * amount);
+		counters.report(state, state.iterations() * amount);
+	}
+
+	/*
+	* Registers the workloads of a container for a single size. The mutating workloads
+	* of the sorted vector are skipped above sortedVectorMutationLimit.
+	*/
+	template <typename Container>
+	void registerContainerBenchmarks(size_t amount) {
+		bool mutations{ !std::is_same_v<Container, SortedVectorContainer> || amount <= sortedVectorMutationLimit };
+
+		auto name{ [amount](const char* workload) {
+			return std::string{ "compare/" } + workload + "/" + Container::name + "/" + std::to_string(amount);
+		} };
+
+		if (mutations) {
+			benchmark::RegisterBenchmark(name("insert").c_str(), benchmarkInsert<Container>, amount)->Unit(benchmark::kMillisecond);
+		}
+
+		benchmark::RegisterBenchmark(name("lookup").c_str(), benchmarkLookup<Container>, amount);
+
+		if (mutations) {
+			benchmark::RegisterBenchmark(name("erase").c_str(), benchmarkErase<Container>, amount)->Unit(benchmark::kMillisecond);
+		}
+
+		benchmark::RegisterBenchmark(name("scan").c_str(), benchmarkScan<Container>, amount)->Unit(benchmark::kMillisecond);
+
+		if (mutations) {
+			benchmark::RegisterBenchmark(name("pollMin").c_str(), benchmarkPollMin<Container>, amount)->Unit(benchmark::kMillisecond);
+		}
+	}
+}
+
+void registerCompareBenchmarks(size_t maxSize) {
+	for (size_t amount : getBenchmarkSizes(maxSize)) {
+		registerContainerBenchmarks<TreeMapContainer>(amount);
+		registerContainerBenchmarks<StdMapContainer>(amount);
+#ifdef TREE_MAP_BENCH_BTREE
+		registerContainerBenchmarks<BtreeMapContainer>(amount);
+#endif
+		registerContainerBenchmarks<SortedVectorContainer>(amount);
+	}
+}
@@ -0,0 +1,783 @@
+; @file tree_map_dictionary.asm
+;
+; Defines the value dictionary of a treemap. Equal values are interned
+; once and reference counted, the treenodes only hold the ID of their value.
+;
+; @author Collector
+; @date 03/09/2023
+
+	include tree_map.inc
+
+	.code
+
+
+	public createValueDictionary
+
+; Attaches an empty value dictionary to the treemap. The value size of the treemap
+; becomes the size of a value ID, the dictionary keeps the size of the values.
+;
+; @RCX qword[in,out] - Pointer to the empty treemap that gets the value dictionary.
+; @RDX qword[in] - Pointer to the function that frees nested heap memory of a value or a nullptr.
+;
+; @return A status value for success, valueDictionaryExists, treeMapNotEmpty, inlineSizeMismatch
+;		  for treemaps with inline pairs, hashUnsupported for treemaps with subtree hashes, errHeapAllocation or treeMapNullptr.
+createValueDictionary proc
+
+	push rsi
+	push rdi
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the treemap already has a dictionary.
+	mov eax, valueDictionaryExists
+	cmp [rcx].TreeMap.valueDictionary, nullptr
+	jne functionReturn
+
+	; The layout of the treenodes can only change while there are none.
+	mov eax, treeMapNotEmpty
+	cmp [rcx].TreeMap.nodeAmount, 0
+	jne functionReturn
+
+	; Inline values need their InlineData inside the treenode.
+	mov eax, inlineSizeMismatch
+	test [rcx].TreeMap.flags, inlinePairsFlag
+	jnz functionReturn
+
+	; Pairs with value IDs hash differently in every treemap.
+	mov eax, hashUnsupported
+	cmp [rcx].TreeMap.hashPairFunc, nullptr
+	jne functionReturn
+
+	; Save the treemap and the free function.
+	mov rsi, rcx
+	mov rdi, rdx
+
+	mov rcx, sizeof ValueDictionary
+	call malloc
+
+	cmp rax, nullptr
+	je heapAllocationError
+
+	; The dictionary starts without entries.
+	mov [rax].ValueDictionary.entries, nullptr
+	mov rcx, [rsi].TreeMap.valueSize
+	mov [rax].ValueDictionary.valueSize, rcx
+	mov [rax].ValueDictionary.entryAmount, 0
+	mov [rax].ValueDictionary.freeValueFunc, rdi
+	mov [rax].ValueDictionary.hashValueFunc, nullptr
+	mov [rax].ValueDictionary.buckets, nullptr
+	mov [rax].ValueDictionary.bucketAmount, 0
+	mov [rax].ValueDictionary.interned, true
+	mov [rsi].TreeMap.valueDictionary, rax
+
+	; Treenodes only hold the ID of their value.
+	mov [rsi].TreeMap.valueSize, qwordSize
+
+	mov eax, success
+
+	jmp functionReturn
+
+heapAllocationError:
+	mov eax, errHeapAllocation
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rdi
+	pop rsi
+	ret
+
+createValueDictionary endp
+
+
+	public separateLargeValues
+
+; Moves the values of the treemap out of its treenodes if they are bigger than the threshold.
+; Every value is stored in its own entry of a value dictionary without interning, so that
+; the treenodes only hold the key, the address of the value and the links.
+;
+; @RCX qword[in,out] - Pointer to the empty treemap whose values are separated.
+; @RDX qword[in] - Value size in bytes up to which values stay inside the treenodes.
+; @R8 qword[in] - Pointer to the function that frees nested heap memory of a value or a nullptr.
+;
+; @return A status value for success if the values are separated or stay inside the treenodes or the
+;		  errors of createValueDictionary.
+separateLargeValues proc
+
+	push rsi
+	sub rsp, shadowStorage
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Small values stay inside the treenodes.
+	mov eax, success
+	cmp [rcx].TreeMap.valueSize, rdx
+	jbe functionReturn
+
+	mov rsi, rcx
+	mov rdx, r8
+	call createValueDictionary
+
+	cmp eax, success
+	jne functionReturn
+
+	; Equal values are stored separately.
+	mov rcx, [rsi].TreeMap.valueDictionary
+	mov [rcx].ValueDictionary.interned, false
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rsi
+	ret
+
+separateLargeValues endp
+
+
+	public setValueDictionaryHash
+
+; Sets the function that hashes the values of the value dictionary. The entries are then
+; chained into the buckets of a hash index, so that searching a value only compares
+; the values with the same hash. The interned values are hashed again.
+;
+; @RCX qword[in,out] - Pointer to the treemap with the value dictionary.
+; @RDX qword[in] - Pointer to the function that hashes a value or a nullptr to remove the hash index.
+;
+; @return A status value for success, valueDictionaryNullptr if the treemap doesn't intern its values,
+;		  errHeapAllocation or treeMapNullptr. The dictionary has no hash index after a failed allocation.
+setValueDictionaryHash proc
+
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Only interned values are searched.
+	mov eax, valueDictionaryNullptr
+	mov rdi, [rcx].TreeMap.valueDictionary
+	cmp rdi, nullptr
+	je functionReturn
+
+	cmp [rdi].ValueDictionary.interned, false
+	je functionReturn
+
+	; Save the treemap and the hash function.
+	mov rsi, rcx
+	mov r12, rdx
+
+	; Remove the old hash index, free ignores a nullptr.
+	mov rcx, [rdi].ValueDictionary.buckets
+	call free
+
+	mov [rdi].ValueDictionary.hashValueFunc, nullptr
+	mov [rdi].ValueDictionary.buckets, nullptr
+	mov [rdi].ValueDictionary.bucketAmount, 0
+
+	mov eax, success
+	cmp r12, nullptr
+	je functionReturn
+
+	; Store the hash of every interned value inside its entry.
+	mov rbx, [rdi].ValueDictionary.entries
+
+hashEntry:
+	cmp rbx, nullptr
+	je countBuckets
+
+	lea rcx, [rbx + sizeof DictionaryEntry]
+	callUserFunc r12
+
+	mov [rbx].DictionaryEntry.hash, rax
+	mov rbx, [rbx].DictionaryEntry.next
+
+	jmp hashEntry
+
+countBuckets:
+	; Start with 16 buckets and at least one bucket per entry.
+	mov rcx, 16
+
+doubleBuckets:
+	cmp rcx, [rdi].ValueDictionary.entryAmount
+	jae buildIndex
+
+	shl rcx, 1
+
+	jmp doubleBuckets
+
+buildIndex:
+	call rebuildDictionaryIndex
+
+	cmp eax, success
+	jne functionReturn
+
+	mov [rdi].ValueDictionary.hashValueFunc, r12
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+setValueDictionaryHash endp
+
+
+; Replaces the buckets of the hash index with the given amount of buckets
+; and chains every entry into them again by the hash it stores.
+;
+; @RCX qword[in] - Count of the buckets, a power of two.
+; @RSI qword[in] - Pointer to the treemap with the value dictionary.
+;
+; @return A status value for success or errHeapAllocation. The old buckets are kept on failure.
+rebuildDictionaryIndex proc
+
+	push rbx
+	push rdi
+	push r12
+	sub rsp, shadowStorage
+
+	mov r12, rcx
+	mov rdx, qwordSize
+	call calloc
+
+	cmp rax, nullptr
+	je heapAllocationError
+
+	mov rbx, rax
+	mov rdi, [rsi].TreeMap.valueDictionary
+
+	; Free the old buckets, free ignores a nullptr.
+	mov rcx, [rdi].ValueDictionary.buckets
+	call free
+
+	mov [rdi].ValueDictionary.buckets, rbx
+	mov [rdi].ValueDictionary.bucketAmount, r12
+
+	; The low bits of the hash select the bucket.
+	dec r12
+	mov rax, [rdi].ValueDictionary.entries
+
+chainEntry:
+	cmp rax, nullptr
+	je indexBuilt
+
+	mov rcx, [rax].DictionaryEntry.hash
+	and rcx, r12
+	mov rdx, [rbx + rcx * qwordSize]
+	mov [rax].DictionaryEntry.bucketNext, rdx
+	mov [rbx + rcx * qwordSize], rax
+
+	mov rax, [rax].DictionaryEntry.next
+
+	jmp chainEntry
+
+indexBuilt:
+	mov eax, success
+
+	jmp functionReturn
+
+heapAllocationError:
+	mov eax, errHeapAllocation
+
+functionReturn:
+	add rsp, shadowStorage
+	pop r12
+	pop rdi
+	pop rbx
+	ret
+
+rebuildDictionaryIndex endp
+
+
+; Interns the given value and stores its ID inside the given slot. An equal value that
+; is already interned gets another reference, otherwise a new entry with a deep copy is created.
+; Without interning a new entry is always created.
+;
+; @RCX qword[out] - Pointer to the slot that receives the ID of the value.
+; @RDX qword[in] - Pointer to the value that is interned.
+; @RSI qword[in,out] - Pointer to the treemap with the value dictionary.
+;
+; @return A status value for success, errHeapAllocation or errCopyValueFunc.
+;		  The slot is unchanged on failure.
+internValue proc
+
+	push rbx
+	push rdi
+	push r12
+	push r13
+	sub rsp, shadowStorage + qwordSize
+
+	; Save the slot and the value.
+	mov rbx, rcx
+	mov r12, rdx
+
+	; Reuse the entry of an equal value.
+	mov rdi, [rsi].TreeMap.valueDictionary
+	cmp [rdi].ValueDictionary.interned, false
+	je createEntry
+
+	mov rcx, rdx
+	call findDictionaryEntry
+
+	; Keep the hash for the hash index.
+	mov [rsp + shadowStorage], rdx
+
+	cmp rax, nullptr
+	je createEntry
+
+	inc [rax].DictionaryEntry.refCount
+
+	jmp storeId
+
+createEntry:
+	; The value follows the header of the entry.
+	mov rcx, [rdi].ValueDictionary.valueSize
+	add rcx, sizeof DictionaryEntry
+	call malloc
+
+	cmp rax, nullptr
+	je heapAllocationError
+
+	mov r13, rax
+	lea rcx, [rax + sizeof DictionaryEntry]
+	mov rdx, r12
+	mov r8B, false
+	mov r9, rsi
+	callUserFunc [rsi].TreeMap.copyValueFunc
+
+	cmp eax, success
+	jne copyValueError
+
+	; Link the entry in front of the others.
+	mov rax, r13
+	mov [rax].DictionaryEntry.refCount, 1
+	mov [rax].DictionaryEntry.previous, nullptr
+	mov rcx, [rdi].ValueDictionary.entries
+	mov [rax].DictionaryEntry.next, rcx
+	mov [rdi].ValueDictionary.entries, rax
+	inc [rdi].ValueDictionary.entryAmount
+
+	cmp rcx, nullptr
+	je indexEntry
+
+	mov [rcx].DictionaryEntry.previous, rax
+
+indexEntry:
+	; Chain the entry into its bucket of the hash index.
+	mov rcx, [rdi].ValueDictionary.buckets
+	cmp rcx, nullptr
+	je storeId
+
+	mov rdx, [rsp + shadowStorage]
+	mov [rax].DictionaryEntry.hash, rdx
+	mov r8, [rdi].ValueDictionary.bucketAmount
+	dec r8
+	and rdx, r8
+	mov r8, [rcx + rdx * qwordSize]
+	mov [rax].DictionaryEntry.bucketNext, r8
+	mov [rcx + rdx * qwordSize], rax
+
+	; Double the buckets once there are more entries than buckets.
+	; The old buckets still work if the allocation fails.
+	mov rcx, [rdi].ValueDictionary.bucketAmount
+	cmp [rdi].ValueDictionary.entryAmount, rcx
+	jbe storeId
+
+	shl rcx, 1
+	call rebuildDictionaryIndex
+
+	mov rax, r13
+
+storeId:
+	mov [rbx], rax
+	mov eax, success
+
+	jmp functionReturn
+
+copyValueError:
+	mov rcx, r13
+	call free
+
+	mov eax, errCopyValueFunc
+
+	jmp functionReturn
+
+heapAllocationError:
+	mov eax, errHeapAllocation
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop r13
+	pop r12
+	pop rdi
+	pop rbx
+	ret
+
+internValue endp
+
+
+; Searches the entry of a value that is equal to the given one. With a hash index
+; only the entries inside the bucket of the value with the same hash are compared.
+;
+; @RCX qword[in] - Pointer to the value that is searched.
+; @RSI qword[in] - Pointer to the treemap with the value dictionary.
+;
+; @return Pointer to the entry or a nullptr if the value isn't interned.
+;		  RDX holds the hash of the value if the dictionary has a hash index.
+findDictionaryEntry proc
+
+	push rbx
+	push rdi
+	push r12
+	sub rsp, shadowStorage
+
+	mov rdi, rcx
+	mov rax, [rsi].TreeMap.valueDictionary
+	mov rbx, [rax].ValueDictionary.entries
+
+	; Without a hash index every entry is compared.
+	cmp [rax].ValueDictionary.hashValueFunc, nullptr
+	je compareEntry
+
+	callUserFunc [rax].ValueDictionary.hashValueFunc
+
+	; Load the first entry of the bucket.
+	mov r12, rax
+	mov rcx, [rsi].TreeMap.valueDictionary
+	mov rdx, [rcx].ValueDictionary.bucketAmount
+	dec rdx
+	and rdx, rax
+	mov rcx, [rcx].ValueDictionary.buckets
+	mov rbx, [rcx + rdx * qwordSize]
+
+compareHashedEntry:
+	cmp rbx, nullptr
+	je functionReturn
+
+	; Only values with the same hash can be equal.
+	cmp [rbx].DictionaryEntry.hash, r12
+	jne nextHashedEntry
+
+	lea rcx, [rbx + sizeof DictionaryEntry]
+	mov rdx, rdi
+	callUserFunc [rsi].TreeMap.equalsValueFunc
+
+	cmp al, true
+	je functionReturn
+
+nextHashedEntry:
+	mov rbx, [rbx].DictionaryEntry.bucketNext
+
+	jmp compareHashedEntry
+
+compareEntry:
+	cmp rbx, nullptr
+	je functionReturn
+
+	lea rcx, [rbx + sizeof DictionaryEntry]
+	mov rdx, rdi
+	callUserFunc [rsi].TreeMap.equalsValueFunc
+
+	cmp al, true
+	je functionReturn
+
+	mov rbx, [rbx].DictionaryEntry.next
+
+	jmp compareEntry
+
+functionReturn:
+	mov rax, rbx
+	mov rdx, r12
+	add rsp, shadowStorage
+	pop r12
+	pop rdi
+	pop rbx
+	ret
+
+findDictionaryEntry endp
+
+
+; Drops a reference to an interned value. The value is freed
+; together with its entry once no treenode refers to it anymore.
+;
+; @RCX qword[in,out] - Pointer to the entry of the value.
+; @RSI qword[in,out] - Pointer to the treemap with the value dictionary.
+releaseDictionaryValue proc
+
+	push rbx
+	sub rsp, shadowStorage
+
+	mov rbx, rcx
+	dec [rbx].DictionaryEntry.refCount
+	jnz functionReturn
+
+	; Free nested heap memory of the value.
+	mov rax, [rsi].TreeMap.valueDictionary
+	mov rax, [rax].ValueDictionary.freeValueFunc
+	cmp rax, nullptr
+	je removeEntry
+
+	lea rcx, [rbx + sizeof DictionaryEntry]
+	callUserFunc rax
+
+removeEntry:
+	mov rcx, rbx
+	call removeDictionaryEntry
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rbx
+	ret
+
+releaseDictionaryValue endp
+
+
+; Unlinks an entry from the value dictionary and frees it.
+; Nested heap memory of its value is left untouched.
+;
+; @RCX qword[in,out] - Pointer to the entry that is removed.
+; @RSI qword[in,out] - Pointer to the treemap with the value dictionary.
+removeDictionaryEntry proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov rax, [rsi].TreeMap.valueDictionary
+	dec [rax].ValueDictionary.entryAmount
+
+	; Unchain the entry from its bucket of the hash index.
+	mov rdx, [rax].ValueDictionary.buckets
+	cmp rdx, nullptr
+	je unlinkEntry
+
+	mov r8, [rax].ValueDictionary.bucketAmount
+	dec r8
+	and r8, [rcx].DictionaryEntry.hash
+	lea rdx, [rdx + r8 * qwordSize]
+
+findBucketLink:
+	cmp [rdx], rcx
+	je unchainEntry
+
+	mov rdx, [rdx]
+	lea rdx, [rdx].DictionaryEntry.bucketNext
+
+	jmp findBucketLink
+
+unchainEntry:
+	mov r8, [rcx].DictionaryEntry.bucketNext
+	mov [rdx], r8
+
+unlinkEntry:
+	mov rdx, [rcx].DictionaryEntry.next
+	mov r8, [rcx].DictionaryEntry.previous
+
+	cmp rdx, nullptr
+	je unlinkPrevious
+
+	mov [rdx].DictionaryEntry.previous, r8
+
+unlinkPrevious:
+	cmp r8, nullptr
+	je unlinkFirst
+
+	mov [r8].DictionaryEntry.next, rdx
+
+	jmp freeEntry
+
+unlinkFirst:
+	mov [rax].ValueDictionary.entries, rdx
+
+freeEntry:
+	call free
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+removeDictionaryEntry endp
+
+
+; Resolves the value ID of a pair that a delete function shallow copied into the buffer.
+; The value of the last reference is moved out of the dictionary, a shared value is deep copied.
+;
+; @RCX qword[in,out] - Pointer to the treemap that deleted the pair.
+; @RDX qword[in,out] - Pointer to the buffer with the deleted pair or a nullptr.
+; @R8 dword[in] - Status value of the deletion.
+;
+; @return The status of the deletion or errCopyValueFunc if the deep copy fails.
+takeDeletedValue proc
+
+	push rsi
+	push rbx
+	push rdi
+	sub rsp, shadowStorage
+
+	; Only a successful deletion into a buffer has to be resolved.
+	mov eax, r8d
+	cmp eax, success
+	jne functionReturn
+
+	cmp rdx, nullptr
+	je functionReturn
+
+	cmp [rcx].TreeMap.valueDictionary, nullptr
+	je functionReturn
+
+	; Load the ID of the value.
+	mov rsi, rcx
+	mov rbx, rdx
+	add rbx, [rsi].TreeMap.keySize
+	mov rdi, [rbx]
+
+	cmp [rdi].DictionaryEntry.refCount, 1
+	jne copyValue
+
+	; The value is moved out of the dictionary.
+	mov rcx, rbx
+	lea rdx, [rdi + sizeof DictionaryEntry]
+	mov r8, [rsi].TreeMap.valueDictionary
+	mov r8, [r8].ValueDictionary.valueSize
+	call memcpy
+
+	mov rcx, rdi
+	call removeDictionaryEntry
+
+	mov eax, success
+
+	jmp functionReturn
+
+copyValue:
+	; Other pairs still share the value.
+	dec [rdi].DictionaryEntry.refCount
+
+	mov rcx, rbx
+	lea rdx, [rdi + sizeof DictionaryEntry]
+	mov r8B, false
+	mov r9, nullptr
+	callUserFunc [rsi].TreeMap.copyValueFunc
+
+	cmp eax, success
+	je functionReturn
+
+	mov eax, errCopyValueFunc
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rdi
+	pop rbx
+	pop rsi
+	ret
+
+takeDeletedValue endp
+
+
+; Replaces the value ID of a treenode with the one of the new value.
+;
+; @RCX qword[in,out] - Pointer to the treemap with the value dictionary.
+; @RDX qword[in,out] - Pointer to the treenode whose value is replaced.
+; @R8 qword[in] - Pointer to the new value.
+;
+; @return A status value for success, errHeapAllocation or errCopyValueFunc.
+replaceDictionaryValue proc
+
+	push rsi
+	push rdi
+	push rbx
+	sub rsp, shadowStorage
+
+	; Save the treemap, the slot of the ID and the old ID.
+	mov rsi, rcx
+	mov rbx, rdx
+	add rbx, [rsi].TreeMap.keySize
+	mov rdi, [rbx]
+
+	; Intern the new value before the old one can be freed.
+	mov rcx, rbx
+	mov rdx, r8
+	call internValue
+
+	cmp eax, success
+	jne functionReturn
+
+	mov rcx, rdi
+	call releaseDictionaryValue
+
+	mov eax, success
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+replaceDictionaryValue endp
+
+
+; Frees all entries of the value dictionary and
+; the nested heap memory of their values.
+;
+; @RCX qword[in,out] - Pointer to the value dictionary or a nullptr if the treemap has none.
+clearValueDictionary proc
+
+	push rbx
+	push rdi
+	sub rsp, shadowStorage + qwordSize
+
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rdi, rcx
+	mov rbx, [rdi].ValueDictionary.entries
+
+freeEntry:
+	cmp rbx, nullptr
+	je resetDictionary
+
+	cmp [rdi].ValueDictionary.freeValueFunc, nullptr
+	je freeMemory
+
+	lea rcx, [rbx + sizeof DictionaryEntry]
+	callUserFunc [rdi].ValueDictionary.freeValueFunc
+
+freeMemory:
+	mov rcx, rbx
+	mov rbx, [rbx].DictionaryEntry.next
+	call free
+
+	jmp freeEntry
+
+resetDictionary:
+	mov [rdi].ValueDictionary.entries, nullptr
+	mov [rdi].ValueDictionary.entryAmount, 0
+
+	; Empty the buckets of the hash index.
+	mov rcx, [rdi].ValueDictionary.buckets
+	cmp rcx, nullptr
+	je functionReturn
+
+	xor edx, edx
+	mov r8, [rdi].ValueDictionary.bucketAmount
+	shl r8, 3
+	call memset
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rdi
+	pop rbx
+	ret
+
+clearValueDictionary endp
+
+end
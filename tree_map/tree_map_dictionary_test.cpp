@@ -0,0 +1,576 @@
+/*
+* @file tree_map_dictionary_test.h
+*
+* Defines unit tests for the value dictionary of the tree map
+* implementation.
+*
+* @author Collector
+* @data 03/09/2023
+*/
+
+
+#include "utils.h"
+
+namespace {
+	/*
+	* Hashes a tree node value by the content of its capital city, its founding year and its population.
+	*
+	* @param[in] treeNodeValue - Value that is hashed.
+	*
+	* @return The hash of the value.
+	*/
+	size_t hashTreeNodeValue(const void* treeNodeValue) {
+		const TreeNodeValue* v{ reinterpret_cast<const TreeNodeValue*>(treeNodeValue) };
+		size_t hash{ 14695981039346656037ull };
+
+		for (const char* c{ v->capitalCity }; *c != '\0'; c++) {
+			hash = (hash ^ static_cast<unsigned char>(*c)) * 1099511628211ull;
+		}
+
+		return (hash ^ v->existsSince) * 1099511628211ull + v->population;
+	}
+
+	/*
+	* Hashes every tree node value to the same hash, so all entries share a bucket.
+	*
+	* @param[in] treeNodeValue - Value that is hashed.
+	*
+	* @return Always 7.
+	*/
+	size_t collideTreeNodeValue(const void* treeNodeValue) {
+		return 7;
+	}
+
+	/*
+	* Puts pairs whose keys and values are numbered into the treemap.
+	*
+	* @param[in, out] tm - Treemap that receives the pairs.
+	* @param[in] first - Number of the first pair.
+	* @param[in] amount - Count of the pairs.
+	*/
+	void putNumberedPairs(TreeMap* tm, size_t first, size_t amount) {
+		char stateName[32], capitalCity[32];
+
+		for (size_t i{ first }; i < first + amount; i++) {
+			std::snprintf(stateName, sizeof(stateName), "State%zu", i);
+			std::snprintf(capitalCity, sizeof(capitalCity), "Region%zu", i);
+
+			TreeNode* node{ createTreeNode(stateName, capitalCity, 0, 0, false) };
+
+			ASSERT_EQ(Status::SUCCESS, putPair(tm, &node->pair));
+
+			freeTreeNodes({ node });
+		}
+	}
+}
+
+
+TEST(TreeMap, createValueDictionaryShouldFailForTreeMapNullptr) {
+	Status s;
+
+	s = createValueDictionary(nullptr, freeTreeNodeValue);
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, s);
+}
+
+TEST(TreeMap, createValueDictionaryShouldFailForNotEmptyTreeMap) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+
+	s = createValueDictionary(tm, freeTreeNodeValue);
+
+	ASSERT_EQ(Status::TREE_MAP_NOT_EMPTY, s);
+	ASSERT_EQ(nullptr, tm->valueDictionary);
+	ASSERT_EQ(sizeof(TreeNodeValue), tm->valueSize);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, createValueDictionaryShouldFailIfDictionaryExists) {
+	Status s;
+	TreeMap* tm{ createTestDictionaryTree() };
+	ValueDictionary* dictionary{ tm->valueDictionary };
+
+	clearTreeMap(tm);
+	s = createValueDictionary(tm, freeTreeNodeValue);
+
+	ASSERT_EQ(Status::VALUE_DICTIONARY_EXISTS, s);
+	ASSERT_EQ(dictionary, tm->valueDictionary);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, createValueDictionaryShouldFailForInlinePairs) {
+	Status s;
+	TreeMap* tm{ createTreeMap(sizeof(InlineData), sizeof(InlineData), compareInlineData,
+		equalsInlineData, copyInlineKey, copyInlineValue, nullptr, &s) };
+
+	setTreeMapFlags(tm, TreeMapFlags::INLINE_PAIRS);
+	s = createValueDictionary(tm, nullptr);
+
+	ASSERT_EQ(Status::INLINE_SIZE_MISMATCH, s);
+	ASSERT_EQ(nullptr, tm->valueDictionary);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, putPairShouldInternEqualValues) {
+	TreeMap* tm{ createTestDictionaryTree() };
+
+	ASSERT_EQ(5, tm->nodeAmount);
+	ASSERT_EQ(sizeof(void*), tm->valueSize);
+	ASSERT_EQ(sizeof(TreeNodeValue), tm->valueDictionary->valueSize);
+	ASSERT_EQ(3, tm->valueDictionary->entryAmount);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, getValueShouldResolveInternedValue) {
+	Status s;
+	TreeMap* tm{ createTestDictionaryTree() };
+	TreeNodeKey* k{ createTreeNodeKey("Oregon") };
+	TreeNodeValue* v{ createTreeNodeValue("Pacific", 0, 0) };
+	TreeNodeValue result;
+
+	s = getValue(tm, k, &result);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertTreeNodeValueEquals(v, &result);
+
+	freeTreeNodeKeys({ k });
+	free(result.capitalCity);
+	freeTreeNodeValues({ v });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, replaceValueShouldReinternValue) {
+	Status s;
+	TreeMap* tm{ createTestDictionaryTree() };
+	TreeNodeKey* newYork{ createTreeNodeKey("New York") };
+	TreeNodeKey* washington{ createTreeNodeKey("Washington") };
+	TreeNodeValue* midwest{ createTreeNodeValue("Midwest", 0, 0) };
+	TreeNodeValue* west{ createTreeNodeValue("West", 0, 0) };
+	TreeNodeValue result;
+
+	// The last reference to "Northeast" is gone.
+	s = replaceValue(tm, newYork, midwest);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(2, tm->valueDictionary->entryAmount);
+
+	// "Pacific" is still used by Oregon.
+	s = replaceValue(tm, washington, west);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(3, tm->valueDictionary->entryAmount);
+
+	s = getValue(tm, washington, &result);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertTreeNodeValueEquals(west, &result);
+
+	freeTreeNodeKeys({ newYork, washington });
+	free(result.capitalCity);
+	freeTreeNodeValues({ midwest, west });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, containsValueShouldSearchByDictionary) {
+	Status s;
+	TreeMap* tm{ createTestDictionaryTree() };
+	TreeNodeValue* midwest{ createTreeNodeValue("Midwest", 0, 0) };
+	TreeNodeValue* south{ createTreeNodeValue("South", 0, 0) };
+
+	s = containsValue(tm, midwest);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	s = containsValue(tm, south);
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+
+	freeTreeNodeValues({ midwest, south });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, getKeyShouldSearchByDictionary) {
+	Status s;
+	TreeMap* tm{ createTestDictionaryTree() };
+	TreeNodeKey* k{ createTreeNodeKey("New York") };
+	TreeNodeValue* northeast{ createTreeNodeValue("Northeast", 0, 0) };
+	TreeNodeValue* south{ createTreeNodeValue("South", 0, 0) };
+	TreeNodeKey result;
+
+	s = getKey(tm, northeast, &result);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertTreeNodeKeyEquals(k, &result);
+
+	s = getKey(tm, south, &result);
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+
+	free(result.stateName);
+	freeTreeNodeKeys({ k });
+	freeTreeNodeValues({ northeast, south });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, deletePairShouldResolveInternedValue) {
+	Status s;
+	TreeMap* tm{ createTestDictionaryTree() };
+	TreeNodeKey* newYork{ createTreeNodeKey("New York") };
+	TreeNodeKey* oregon{ createTreeNodeKey("Oregon") };
+	TreeNodeValue* northeast{ createTreeNodeValue("Northeast", 0, 0) };
+	TreeNodeValue* pacific{ createTreeNodeValue("Pacific", 0, 0) };
+	TreeNodePair deletedNewYork, deletedOregon;
+
+	// The last reference moves the value out of the dictionary.
+	s = deletePair(tm, newYork, &deletedNewYork);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertTreeNodeKeyEquals(newYork, &deletedNewYork.key);
+	assertTreeNodeValueEquals(northeast, &deletedNewYork.value);
+	ASSERT_EQ(2, tm->valueDictionary->entryAmount);
+
+	// A shared value is deep copied.
+	s = deletePair(tm, oregon, &deletedOregon);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertTreeNodeKeyEquals(oregon, &deletedOregon.key);
+	assertTreeNodeValueEquals(pacific, &deletedOregon.value);
+	ASSERT_EQ(2, tm->valueDictionary->entryAmount);
+
+	freeTreeNodePair(&deletedNewYork);
+	freeTreeNodePair(&deletedOregon);
+	freeTreeNodeKeys({ newYork, oregon });
+	freeTreeNodeValues({ northeast, pacific });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, deletePairShouldReleaseInternedValue) {
+	Status s;
+	TreeMap* tm{ createTestDictionaryTree() };
+	TreeNodeKey* minnesota{ createTreeNodeKey("Minnesota") };
+	TreeNodeKey* kansas{ createTreeNodeKey("Kansas") };
+
+	s = deletePair(tm, minnesota, nullptr);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(3, tm->valueDictionary->entryAmount);
+
+	s = deletePair(tm, kansas, nullptr);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(2, tm->valueDictionary->entryAmount);
+
+	freeTreeNodeKeys({ minnesota, kansas });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, pollFirstPairShouldResolveInternedValue) {
+	Status s;
+	TreeMap* tm{ createTestDictionaryTree() };
+	TreeNodeKey* k{ createTreeNodeKey("Kansas") };
+	TreeNodeValue* v{ createTreeNodeValue("Midwest", 0, 0) };
+	TreeNodePair result;
+
+	s = pollFirstPair(tm, &result);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertTreeNodeKeyEquals(k, &result.key);
+	assertTreeNodeValueEquals(v, &result.value);
+
+	freeTreeNodePair(&result);
+	freeTreeNodeKeys({ k });
+	freeTreeNodeValues({ v });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, minPairShouldResolveInternedValue) {
+	Status s;
+	TreeMap* tm{ createTestDictionaryTree() };
+	TreeNodeKey* k{ createTreeNodeKey("Kansas") };
+	TreeNodeValue* v{ createTreeNodeValue("Midwest", 0, 0) };
+	TreeNodePair result;
+
+	s = minPair(tm, &result);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertTreeNodeKeyEquals(k, &result.key);
+	assertTreeNodeValueEquals(v, &result.value);
+
+	freeTreeNodePair(&result);
+	freeTreeNodeKeys({ k });
+	freeTreeNodeValues({ v });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, rekeyPairShouldKeepInternedValue) {
+	Status s;
+	TreeMap* tm{ createTestDictionaryTree() };
+	TreeNodeKey* oldKey{ createTreeNodeKey("Kansas") };
+	TreeNodeKey* newKey{ createTreeNodeKey("Texas") };
+	TreeNodeValue* v{ createTreeNodeValue("Midwest", 0, 0) };
+	TreeNodeKey oldKeyBuffer;
+	TreeNodeValue result;
+
+	s = rekeyPair(tm, oldKey, newKey, &oldKeyBuffer);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(3, tm->valueDictionary->entryAmount);
+
+	s = getValue(tm, newKey, &result);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertTreeNodeValueEquals(v, &result);
+
+	free(oldKeyBuffer.stateName);
+	freeTreeNodeKeys({ oldKey, newKey });
+	free(result.capitalCity);
+	freeTreeNodeValues({ v });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, clearTreeMapShouldFreeInternedValues) {
+	Status s;
+	TreeMap* tm{ createTestDictionaryTree() };
+
+	s = clearTreeMap(tm);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(0, tm->valueDictionary->entryAmount);
+	ASSERT_EQ(nullptr, tm->valueDictionary->entries);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, separateLargeValuesShouldKeepSmallValuesInside) {
+	Status s;
+	TreeMap* tm{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeTreeNodePair, &s) };
+
+	s = separateLargeValues(tm, sizeof(TreeNodeValue), freeTreeNodeValue);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(nullptr, tm->valueDictionary);
+	ASSERT_EQ(sizeof(TreeNodeValue), tm->valueSize);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, separateLargeValuesShouldFailForTreeMapNullptr) {
+	Status s;
+
+	s = separateLargeValues(nullptr, 0, freeTreeNodeValue);
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, s);
+}
+
+TEST(TreeMap, separateLargeValuesShouldStoreEveryValueOnItsOwn) {
+	TreeMap* tm{ createTestSeparatedTree() };
+
+	ASSERT_EQ(5, tm->nodeAmount);
+	ASSERT_EQ(sizeof(void*), tm->valueSize);
+	ASSERT_EQ(false, tm->valueDictionary->interned);
+	ASSERT_EQ(5, tm->valueDictionary->entryAmount);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, separatedValuesShouldBeResolved) {
+	Status s;
+	TreeMap* tm{ createTestSeparatedTree() };
+	TreeNodeKey* minnesota{ createTreeNodeKey("Minnesota") };
+	TreeNodeKey* newYork{ createTreeNodeKey("New York") };
+	TreeNodeValue* midwest{ createTreeNodeValue("Midwest", 0, 0) };
+	TreeNodeValue* northeast{ createTreeNodeValue("Northeast", 0, 0) };
+	TreeNodeValue* south{ createTreeNodeValue("South", 0, 0) };
+	TreeNodeValue valueResult;
+	TreeNodeKey keyResult;
+
+	s = getValue(tm, minnesota, &valueResult);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertTreeNodeValueEquals(midwest, &valueResult);
+
+	s = getKey(tm, northeast, &keyResult);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertTreeNodeKeyEquals(newYork, &keyResult);
+
+	s = containsValue(tm, south);
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+
+	free(valueResult.capitalCity);
+	free(keyResult.stateName);
+	freeTreeNodeKeys({ minnesota, newYork });
+	freeTreeNodeValues({ midwest, northeast, south });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, separatedValuesShouldBeMovedOutOnDeletion) {
+	Status s;
+	TreeMap* tm{ createTestSeparatedTree() };
+	TreeNodeKey* k{ createTreeNodeKey("Washington") };
+	TreeNodeValue* v{ createTreeNodeValue("Pacific", 0, 0) };
+	TreeNodePair result;
+
+	s = deletePair(tm, k, &result);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertTreeNodeKeyEquals(k, &result.key);
+	assertTreeNodeValueEquals(v, &result.value);
+	ASSERT_EQ(4, tm->valueDictionary->entryAmount);
+
+	s = replaceValue(tm, k, v);
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+
+	freeTreeNodePair(&result);
+	freeTreeNodeKeys({ k });
+	freeTreeNodeValues({ v });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, setValueDictionaryHashShouldFailWithoutInternedValues) {
+	Status s;
+	TreeMap* plain{ createTestTree() };
+	TreeMap* separated{ createTestSeparatedTree() };
+
+	s = setValueDictionaryHash(nullptr, ::hashTreeNodeValue);
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, s);
+
+	s = setValueDictionaryHash(plain, ::hashTreeNodeValue);
+
+	ASSERT_EQ(Status::VALUE_DICTIONARY_NULLPTR, s);
+
+	s = setValueDictionaryHash(separated, ::hashTreeNodeValue);
+
+	ASSERT_EQ(Status::VALUE_DICTIONARY_NULLPTR, s);
+	ASSERT_EQ(nullptr, separated->valueDictionary->buckets);
+
+	deleteTreeMap(separated);
+	deleteTreeMap(plain);
+}
+
+TEST(TreeMap, setValueDictionaryHashShouldIndexInternedValues) {
+	Status s;
+	TreeMap* tm{ createTestDictionaryTree() };
+	TreeNodeKey* newYork{ createTreeNodeKey("New York") };
+	TreeNodeValue* northeast{ createTreeNodeValue("Northeast", 0, 0) };
+	TreeNodeValue* midwest{ createTreeNodeValue("Midwest", 0, 0) };
+	TreeNodeValue* south{ createTreeNodeValue("South", 0, 0) };
+	TreeNodeKey result;
+
+	s = setValueDictionaryHash(tm, ::hashTreeNodeValue);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_NE(nullptr, tm->valueDictionary->buckets);
+	ASSERT_EQ(16, tm->valueDictionary->bucketAmount);
+
+	s = containsValue(tm, midwest);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	s = containsValue(tm, south);
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+
+	s = getKey(tm, northeast, &result);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertTreeNodeKeyEquals(newYork, &result);
+
+	// The buckets double once there are more entries than buckets.
+	::putNumberedPairs(tm, 0, 40);
+
+	ASSERT_EQ(43, tm->valueDictionary->entryAmount);
+	ASSERT_EQ(64, tm->valueDictionary->bucketAmount);
+
+	// Equal values still share their entry.
+	TreeNode* texas{ createTreeNode("Texas", "Region0", 0, 0, false) };
+
+	::putNumberedPairs(tm, 40, 1);
+
+	s = putPair(tm, &texas->pair);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(44, tm->valueDictionary->entryAmount);
+
+	s = deletePair(tm, newYork, nullptr);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(43, tm->valueDictionary->entryAmount);
+
+	s = containsValue(tm, northeast);
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+
+	// Cleared treemaps keep their empty buckets.
+	s = clearTreeMap(tm);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(64, tm->valueDictionary->bucketAmount);
+
+	s = containsValue(tm, midwest);
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+
+	::putNumberedPairs(tm, 0, 3);
+
+	ASSERT_EQ(3, tm->valueDictionary->entryAmount);
+
+	s = setValueDictionaryHash(tm, nullptr);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(nullptr, tm->valueDictionary->buckets);
+	ASSERT_EQ(0, tm->valueDictionary->bucketAmount);
+
+	free(result.stateName);
+	freeTreeNodes({ texas });
+	freeTreeNodeKeys({ newYork });
+	freeTreeNodeValues({ northeast, midwest, south });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, setValueDictionaryHashShouldCompareCollidingValues) {
+	Status s;
+	TreeMap* tm{ createTestDictionaryTree() };
+	TreeNodeKey* kansas{ createTreeNodeKey("Kansas") };
+	TreeNodeKey* minnesota{ createTreeNodeKey("Minnesota") };
+	TreeNodeValue* midwest{ createTreeNodeValue("Midwest", 0, 0) };
+	TreeNodeValue* pacific{ createTreeNodeValue("Pacific", 0, 0) };
+
+	s = setValueDictionaryHash(tm, ::collideTreeNodeValue);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	::putNumberedPairs(tm, 0, 20);
+
+	ASSERT_EQ(23, tm->valueDictionary->entryAmount);
+
+	// An entry inside the chain of the bucket is removed.
+	s = deletePair(tm, kansas, nullptr);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	s = deletePair(tm, minnesota, nullptr);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(22, tm->valueDictionary->entryAmount);
+
+	s = containsValue(tm, midwest);
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+
+	s = containsValue(tm, pacific);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	freeTreeNodeKeys({ kansas, minnesota });
+	freeTreeNodeValues({ midwest, pacific });
+	deleteTreeMap(tm);
+}
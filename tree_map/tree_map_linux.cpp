@@ -0,0 +1,599 @@
+/*
+* @file tree_map_linux.cpp
+*
+* Implements the functions that the assembly code needs on linux.
+* The assembly code follows the microsoft x64 calling convention everywhere, so the c functions
+* and the windows functions it calls are provided with that convention and the functions of
+* tree_map.h get system v entry points that call the renamed assembly functions.
+*
+* @author Collector
+* @data 03/09/2023
+*/
+
+#include "tree_map.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MS_ABI __attribute__((ms_abi))
+
+namespace {
+	// Constants of the windows functions that are used by the assembly code.
+	constexpr unsigned memLargePages{ 0x20000000 };
+	constexpr unsigned pageReadWrite{ 4 };
+	constexpr unsigned fileMapWrite{ 2 };
+	constexpr unsigned genericWrite{ 0x40000000 };
+	constexpr unsigned createAlways{ 2 };
+	constexpr unsigned errorAlreadyExists{ 183 };
+	void* const invalidHandleValue{ reinterpret_cast<void*>(-1) };
+
+	/*
+	* Handle of a file or a file mapping. A file mapping without a file is a named shared memory.
+	*
+	* @var descriptor - File descriptor of the file or the shared memory.
+	* @var size - Size of the file mapping.
+	* @var writable - Indicator if the views of the file mapping can be written.
+	* @var name - Name of the shared memory that is removed with the handle or an empty string.
+	*			  The handle holds an exclusive lock on the shared memory it created until it is closed.
+	*/
+	struct Handle {
+		int descriptor;
+		size_t size;
+		bool writable;
+		std::string name;
+	};
+
+	/*
+	* Error code of the last windows function of the thread that failed.
+	*/
+	thread_local unsigned lastError{ 0 };
+
+	/*
+	* Sizes of the mapped views and virtual allocations, which are released without their size.
+	*/
+	std::unordered_map<void*, size_t> mappingSizes;
+	std::mutex mappingSizesLock;
+
+	/*
+	* Maps memory and remembers its size for the release.
+	*
+	* @param[in] size - Size of the memory.
+	* @param[in] protection - Protection of the memory pages.
+	* @param[in] flags - Flags of the mapping.
+	* @param[in] descriptor - File descriptor of the mapped file or -1.
+	*
+	* @return The mapped memory or a nullptr.
+	*/
+	void* mapMemory(size_t size, int protection, int flags, int descriptor) {
+		void* memory{ mmap(nullptr, size, protection, flags, descriptor, 0) };
+
+		if (memory == MAP_FAILED) {
+			lastError = errno;
+
+			return nullptr;
+		}
+
+		std::lock_guard<std::mutex> guard{ mappingSizesLock };
+		mappingSizes[memory] = size;
+
+		return memory;
+	}
+
+	/*
+	* Unmaps memory that was mapped by mapMemory.
+	*
+	* @param[in] memory - Start of the mapped memory.
+	*
+	* @return Indicator if the memory was unmapped.
+	*/
+	bool unmapMemory(void* memory) {
+		size_t size;
+
+		{
+			std::lock_guard<std::mutex> guard{ mappingSizesLock };
+			auto mapping{ mappingSizes.find(memory) };
+
+			if (mapping == mappingSizes.end()) {
+				return false;
+			}
+
+			size = mapping->second;
+			mappingSizes.erase(mapping);
+		}
+
+		return munmap(memory, size) == 0;
+	}
+
+	/*
+	* Reads the size of the large pages from the memory information of the kernel.
+	*
+	* @return The size of a large page or zero without huge page support like on windows without large pages.
+	*/
+	size_t readLargePageSize() {
+		std::ifstream memoryInfo{ "/proc/meminfo" };
+		std::string field;
+		size_t kiloBytes;
+
+		while (memoryInfo >> field) {
+			if (field == "Hugepagesize:" && memoryInfo >> kiloBytes) {
+				return kiloBytes * 1024;
+			}
+		}
+
+		return 0;
+	}
+
+	/*
+	* Checks if large pages are taken from the reserved huge pages of hugetlbfs. They have to be reserved
+	* by the administrator, so they are only used if TREE_MAP_HUGETLB is set to 1.
+	*
+	* @return Indicator if large pages are mapped with MAP_HUGETLB.
+	*/
+	bool useHugeTlbPages() {
+		static const bool hugeTlbPages{ [] {
+			const char* setting{ std::getenv("TREE_MAP_HUGETLB") };
+
+			return setting != nullptr && std::strcmp(setting, "1") == 0;
+		}() };
+
+		return hugeTlbPages;
+	}
+
+	/*
+	* Maps memory that starts on a large page and asks the kernel to back it with transparent huge pages.
+	* The mapping is larger by a large page, the unaligned head and the tail are unmapped again.
+	*
+	* @param[in] size - Size of the memory, a multiple of the large page size.
+	*
+	* @return The mapped memory or a nullptr if the size of large pages is unknown or the kernel
+	*		  doesn't use transparent huge pages for the memory.
+	*/
+	void* mapTransparentHugePages(size_t size) {
+		size_t largePageSize{ readLargePageSize() };
+
+		if (largePageSize == 0) {
+			lastError = EINVAL;
+
+			return nullptr;
+		}
+
+		void* mapping{ mmap(nullptr, size + largePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) };
+
+		if (mapping == MAP_FAILED) {
+			lastError = errno;
+
+			return nullptr;
+		}
+
+		char* start{ static_cast<char*>(mapping) };
+		char* memory{ reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(start) + largePageSize - 1) & ~(largePageSize - 1)) };
+		size_t tail{ static_cast<size_t>(start + size + largePageSize - (memory + size)) };
+
+		if (memory != start) {
+			munmap(start, memory - start);
+		}
+
+		if (tail != 0) {
+			munmap(memory + size, tail);
+		}
+
+		if (madvise(memory, size, MADV_HUGEPAGE) != 0) {
+			lastError = errno;
+			munmap(memory, size);
+
+			return nullptr;
+		}
+
+		std::lock_guard<std::mutex> guard{ mappingSizesLock };
+		mappingSizes[memory] = size;
+
+		return memory;
+	}
+
+	/*
+	* Removes named shared memory whose creator doesn't hold its lock anymore, because the process
+	* ended without closing it. Windows removes such memory together with the last handle.
+	*
+	* @param[in] sharedName - Name of the shared memory.
+	*
+	* @return True if the memory was stale and is removed or is gone already, otherwise false.
+	*/
+	bool unlinkStaleMemory(const std::string& sharedName) {
+		int descriptor{ shm_open(sharedName.c_str(), O_RDWR, 0600) };
+
+		if (descriptor < 0) {
+			return errno == ENOENT;
+		}
+
+		bool stale{ flock(descriptor, LOCK_EX | LOCK_NB) == 0 };
+
+		if (stale) {
+			shm_unlink(sharedName.c_str());
+		}
+
+		close(descriptor);
+
+		return stale;
+	}
+}
+
+extern "C" {
+	// C functions with the microsoft x64 calling convention.
+	MS_ABI void* ms_malloc(size_t size) { return std::malloc(size); }
+	MS_ABI void* ms_calloc(size_t amount, size_t size) { return std::calloc(amount, size); }
+	MS_ABI void ms_free(void* memory) { std::free(memory); }
+	MS_ABI void* ms_memcpy(void* dst, const void* src, size_t size) { return std::memcpy(dst, src, size); }
+	MS_ABI void* ms_memset(void* dst, int value, size_t size) { return std::memset(dst, value, size); }
+	MS_ABI size_t ms_strlen(const char* string) { return std::strlen(string); }
+	MS_ABI size_t ms_fwrite(const void* data, size_t size, size_t amount, FILE* file) { return std::fwrite(data, size, amount, file); }
+	MS_ABI size_t ms_fread(void* data, size_t size, size_t amount, FILE* file) { return std::fread(data, size, amount, file); }
+	MS_ABI int ms_fflush(FILE* file) { return std::fflush(file); }
+	MS_ABI int ms__fseeki64(FILE* file, long long offset, int origin) { return fseeko(file, offset, origin); }
+	MS_ABI int ms__fileno(FILE* file) { return fileno(file); }
+	MS_ABI int ms__commit(int descriptor) { return fsync(descriptor); }
+
+	// Windows functions that are implemented with the posix functions.
+	MS_ABI void* ms_VirtualAlloc([[maybe_unused]] void* address, size_t size, unsigned allocationType, [[maybe_unused]] unsigned protection) {
+		if (allocationType & memLargePages) {
+			return useHugeTlbPages() ? mapMemory(size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1)
+				: mapTransparentHugePages(size);
+		}
+
+		return mapMemory(size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1);
+	}
+
+	MS_ABI int ms_VirtualFree(void* address, [[maybe_unused]] size_t size, [[maybe_unused]] unsigned freeType) {
+		return unmapMemory(address);
+	}
+
+	MS_ABI size_t ms_GetLargePageMinimum() {
+		return readLargePageSize();
+	}
+
+	MS_ABI void* ms_CreateFileA(const char* path, unsigned access, [[maybe_unused]] unsigned shareMode, [[maybe_unused]] void* security,
+		unsigned disposition, [[maybe_unused]] unsigned attributes, [[maybe_unused]] void* templateFile) {
+		int flags{ access & genericWrite ? O_RDWR : O_RDONLY };
+
+		if (disposition == createAlways) {
+			flags |= O_CREAT | O_TRUNC;
+		}
+
+		int descriptor{ open(path, flags, 0644) };
+
+		if (descriptor < 0) {
+			lastError = errno;
+
+			return invalidHandleValue;
+		}
+
+		return new Handle{ descriptor, 0, false, "" };
+	}
+
+	MS_ABI int ms_GetFileSizeEx(void* file, long long* size) {
+		struct stat fileStatus;
+
+		if (fstat(static_cast<Handle*>(file)->descriptor, &fileStatus) != 0) {
+			lastError = errno;
+
+			return false;
+		}
+
+		*size = fileStatus.st_size;
+
+		return true;
+	}
+
+	MS_ABI void* ms_CreateFileMappingA(void* file, [[maybe_unused]] void* security, unsigned protection,
+		unsigned maximumSizeHigh, unsigned maximumSizeLow, const char* name) {
+		size_t size{ static_cast<size_t>(maximumSizeHigh) << 32 | maximumSizeLow };
+		Handle* mapping{ new Handle{ -1, size, protection == pageReadWrite, "" } };
+
+		lastError = 0;
+
+		if (file == invalidHandleValue) {
+			// The named memory is removed by the handle that created it. Memory that a crashed
+			// process left behind has no creator anymore and is created again.
+			std::string sharedName{ "/" + std::string{ name } };
+			mapping->descriptor = shm_open(sharedName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+
+			if (mapping->descriptor < 0 && errno == EEXIST && unlinkStaleMemory(sharedName)) {
+				mapping->descriptor = shm_open(sharedName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+			}
+
+			if (mapping->descriptor >= 0) {
+				mapping->name = sharedName;
+
+				if (flock(mapping->descriptor, LOCK_EX | LOCK_NB) == 0 && ftruncate(mapping->descriptor, size) == 0) {
+					return mapping;
+				}
+			}
+			else if (errno == EEXIST) {
+				struct stat memoryStatus;
+
+				// Like on windows the handle of existing memory has its size instead of the requested one.
+				mapping->descriptor = shm_open(sharedName.c_str(), O_RDWR, 0600);
+				lastError = errorAlreadyExists;
+
+				if (mapping->descriptor >= 0 && fstat(mapping->descriptor, &memoryStatus) == 0) {
+					mapping->size = static_cast<size_t>(memoryStatus.st_size);
+
+					return mapping;
+				}
+			}
+		}
+		else {
+			struct stat fileStatus;
+			mapping->descriptor = dup(static_cast<Handle*>(file)->descriptor);
+
+			// A size of zero maps the whole file, a bigger size extends it.
+			if (mapping->descriptor >= 0 && fstat(mapping->descriptor, &fileStatus) == 0) {
+				if (size == 0) {
+					mapping->size = fileStatus.st_size;
+
+					return mapping;
+				}
+
+				if (size <= static_cast<size_t>(fileStatus.st_size) || ftruncate(mapping->descriptor, size) == 0) {
+					return mapping;
+				}
+			}
+		}
+
+		if (lastError == 0) {
+			lastError = errno;
+		}
+
+		if (mapping->descriptor >= 0) {
+			close(mapping->descriptor);
+		}
+
+		if (!mapping->name.empty()) {
+			shm_unlink(mapping->name.c_str());
+		}
+
+		delete mapping;
+
+		return nullptr;
+	}
+
+	MS_ABI void* ms_OpenFileMappingA(unsigned access, [[maybe_unused]] int inheritHandle, const char* name) {
+		std::string sharedName{ "/" + std::string{ name } };
+		bool writable{ (access & fileMapWrite) != 0 };
+		int descriptor{ shm_open(sharedName.c_str(), writable ? O_RDWR : O_RDONLY, 0600) };
+		struct stat memoryStatus;
+
+		if (descriptor < 0 || fstat(descriptor, &memoryStatus) != 0) {
+			lastError = errno;
+
+			if (descriptor >= 0) {
+				close(descriptor);
+			}
+
+			return nullptr;
+		}
+
+		return new Handle{ descriptor, static_cast<size_t>(memoryStatus.st_size), writable, "" };
+	}
+
+	MS_ABI void* ms_MapViewOfFile(void* fileMapping, unsigned access, [[maybe_unused]] unsigned offsetHigh, [[maybe_unused]] unsigned offsetLow,
+		size_t size) {
+		Handle* mapping{ static_cast<Handle*>(fileMapping) };
+		int protection{ access & fileMapWrite ? PROT_READ | PROT_WRITE : PROT_READ };
+
+		return mapMemory(size == 0 ? mapping->size : size, protection, MAP_SHARED, mapping->descriptor);
+	}
+
+	MS_ABI int ms_UnmapViewOfFile(void* base) {
+		return unmapMemory(base);
+	}
+
+	MS_ABI int ms_FlushViewOfFile(void* base, size_t size) {
+		if (size == 0) {
+			std::lock_guard<std::mutex> guard{ mappingSizesLock };
+			auto mapping{ mappingSizes.find(base) };
+
+			if (mapping == mappingSizes.end()) {
+				return false;
+			}
+
+			size = mapping->second;
+		}
+
+		return msync(base, size, MS_SYNC) == 0;
+	}
+
+	MS_ABI int ms_FlushFileBuffers(void* file) {
+		return fsync(static_cast<Handle*>(file)->descriptor) == 0;
+	}
+
+	MS_ABI int ms_CloseHandle(void* object) {
+		Handle* handle{ static_cast<Handle*>(object) };
+
+		// The name is removed while the lock is still held, so that no other process takes the memory for stale.
+		if (!handle->name.empty()) {
+			shm_unlink(handle->name.c_str());
+		}
+
+		bool closed{ close(handle->descriptor) == 0 };
+
+		delete handle;
+
+		return closed;
+	}
+
+	MS_ABI unsigned ms_GetLastError() {
+		return lastError;
+	}
+
+	MS_ABI int ms_DeleteFileA(const char* path) {
+		return unlink(path) == 0;
+	}
+}
+
+/*
+* Declares the renamed assembly function and defines a system v entry point with the name of tree_map.h that calls it.
+*/
+#define TREE_MAP_ENTRY(Result, name, parameters, arguments) \
+	extern "C" MS_ABI Result ms_##name parameters; \
+	Result name parameters { return ms_##name arguments; }
+
+TREE_MAP_ENTRY(TreeMap*, createTreeMap,
+	(size_t keySize, size_t valueSize, KeyComparison kComp, ValueEquality vEqual, KeyCopy kCopy, ValueCopy vCopy, FreePair fPair, Status* s),
+	(keySize, valueSize, kComp, vEqual, kCopy, vCopy, fPair, s))
+TREE_MAP_ENTRY(Status, setTreeMapFlags, (TreeMap* tm, size_t flags), (tm, flags))
+TREE_MAP_ENTRY(Status, setSpareTreeNodeLimit, (TreeMap* tm, size_t limit), (tm, limit))
+TREE_MAP_ENTRY(Status, trimSpareTreeNodes, (TreeMap* tm, size_t keep), (tm, keep))
+TREE_MAP_ENTRY(Status, clearTreeMap, (TreeMap* tm), (tm))
+TREE_MAP_ENTRY(Status, deleteTreeMap, (TreeMap* tm), (tm))
+TREE_MAP_ENTRY(Status, putPair, (TreeMap* tm, const void* pair), (tm, pair))
+TREE_MAP_ENTRY(Status, deletePair, (TreeMap* tm, const void* key, void* pairBuffer), (tm, key, pairBuffer))
+TREE_MAP_ENTRY(Status, pollFirstPair, (TreeMap* tm, const void* pairBuffer), (tm, pairBuffer))
+TREE_MAP_ENTRY(Status, pollLastPair, (TreeMap* tm, const void* pairBuffer), (tm, pairBuffer))
+TREE_MAP_ENTRY(Status, rekeyPair,
+	(TreeMap* tm, const void* oldKey, const void* newKey, void* keyBuffer),
+	(tm, oldKey, newKey, keyBuffer))
+TREE_MAP_ENTRY(Status, getValue, (TreeMap* tm, const void* key, void* valueBuffer), (tm, key, valueBuffer))
+TREE_MAP_ENTRY(Status, getKey, (TreeMap* tm, const void* value, void* keyBuffer), (tm, value, keyBuffer))
+TREE_MAP_ENTRY(Status, containsValue, (TreeMap* tm, const void* value), (tm, value))
+TREE_MAP_ENTRY(Status, containsKey, (TreeMap* tm, const void* key), (tm, key))
+TREE_MAP_ENTRY(Status, replaceValue,
+	(TreeMap* tm, const void* key, const void* replacementValue),
+	(tm, key, replacementValue))
+TREE_MAP_ENTRY(Status, ceilingPair, (TreeMap* tm, const void* key, void* pairBuffer), (tm, key, pairBuffer))
+TREE_MAP_ENTRY(Status, floorPair, (TreeMap* tm, const void* key, void* pairBuffer), (tm, key, pairBuffer))
+TREE_MAP_ENTRY(Status, lowerPair, (TreeMap* tm, const void* key, void* pairBuffer), (tm, key, pairBuffer))
+TREE_MAP_ENTRY(Status, higherPair, (TreeMap* tm, const void* key, void* pairBuffer), (tm, key, pairBuffer))
+TREE_MAP_ENTRY(Status, minPair, (TreeMap* tm, void* pairBuffer), (tm, pairBuffer))
+TREE_MAP_ENTRY(Status, maxPair, (TreeMap* tm, void* pairBuffer), (tm, pairBuffer))
+TREE_MAP_ENTRY(Status, equalRange,
+	(TreeMap* tm, const void* key, void* pairBuffer, size_t bufferLength, size_t* pairAmount),
+	(tm, key, pairBuffer, bufferLength, pairAmount))
+TREE_MAP_ENTRY(Status, countKey, (TreeMap* tm, const void* key, size_t* pairAmount), (tm, key, pairAmount))
+TREE_MAP_ENTRY(Status, deleteAllForKey, (TreeMap* tm, const void* key), (tm, key))
+TREE_MAP_ENTRY(Status, createPayloadArena, (TreeMap* tm, size_t blockSize), (tm, blockSize))
+TREE_MAP_ENTRY(void*, allocatePayload, (TreeMap* tm, size_t size), (tm, size))
+TREE_MAP_ENTRY(Status, compactPayloadArena, (TreeMap* tm, RelocatePair relocate), (tm, relocate))
+TREE_MAP_ENTRY(Status, createValueDictionary, (TreeMap* tm, FreeValue freeValueFunc), (tm, freeValueFunc))
+TREE_MAP_ENTRY(Status, separateLargeValues,
+	(TreeMap* tm, size_t threshold, FreeValue freeValueFunc),
+	(tm, threshold, freeValueFunc))
+TREE_MAP_ENTRY(Status, setValueDictionaryHash, (TreeMap* tm, HashValue hashValueFunc), (tm, hashValueFunc))
+TREE_MAP_ENTRY(Status, createNodeArena, (TreeMap* tm, size_t chunkSize, size_t flags), (tm, chunkSize, flags))
+TREE_MAP_ENTRY(Status, reserveTreeMap, (TreeMap* tm, size_t amount), (tm, amount))
+TREE_MAP_ENTRY(Status, compactTreeMap, (TreeMap* tm, size_t budget), (tm, budget))
+TREE_MAP_ENTRY(Status, saveTreeMap,
+	(TreeMap* tm, FILE* file, SerializePair serialize, size_t maxRecordSize),
+	(tm, file, serialize, maxRecordSize))
+TREE_MAP_ENTRY(Status, loadTreeMap, (TreeMap* tm, FILE* file, DeserializePair deserialize), (tm, file, deserialize))
+TREE_MAP_ENTRY(Status, saveMappedTreeMap, (TreeMap* tm, FILE* file), (tm, file))
+TREE_MAP_ENTRY(MappedTreeMap*, openMappedTreeMap,
+	(const char* path, KeyComparison compareKeyFunc, bool writable, Status* status),
+	(path, compareKeyFunc, writable, status))
+TREE_MAP_ENTRY(Status, closeMappedTreeMap, (MappedTreeMap* mtm), (mtm))
+TREE_MAP_ENTRY(Status, flushMappedTreeMap, (const MappedTreeMap* mtm), (mtm))
+TREE_MAP_ENTRY(Status, getMappedValue,
+	(const MappedTreeMap* mtm, const void* key, void* valueBuffer),
+	(mtm, key, valueBuffer))
+TREE_MAP_ENTRY(Status, replaceMappedValue, (MappedTreeMap* mtm, const void* key, const void* value), (mtm, key, value))
+TREE_MAP_ENTRY(const void*, ceilingMappedPair, (const MappedTreeMap* mtm, const void* key), (mtm, key))
+TREE_MAP_ENTRY(const void*, floorMappedPair, (const MappedTreeMap* mtm, const void* key), (mtm, key))
+TREE_MAP_ENTRY(const void*, higherMappedPair, (const MappedTreeMap* mtm, const void* key), (mtm, key))
+TREE_MAP_ENTRY(const void*, lowerMappedPair, (const MappedTreeMap* mtm, const void* key), (mtm, key))
+TREE_MAP_ENTRY(const void*, nextMappedPair, (const MappedTreeMap* mtm, const void* pair), (mtm, pair))
+TREE_MAP_ENTRY(SharedTreeMap*, createSharedTreeMap,
+	(const char* name, size_t keySize, size_t valueSize, size_t nodeCapacity, KeyComparison compareKeyFunc, Status* status),
+	(name, keySize, valueSize, nodeCapacity, compareKeyFunc, status))
+TREE_MAP_ENTRY(SharedTreeMap*, openSharedTreeMap,
+	(const char* name, KeyComparison compareKeyFunc, Status* status),
+	(name, compareKeyFunc, status))
+TREE_MAP_ENTRY(Status, closeSharedTreeMap, (SharedTreeMap* stm), (stm))
+TREE_MAP_ENTRY(Status, publishSharedTreeMap, (SharedTreeMap* stm, TreeMap* tm), (stm, tm))
+TREE_MAP_ENTRY(Status, getSharedValue,
+	(const SharedTreeMap* stm, const void* key, void* valueBuffer),
+	(stm, key, valueBuffer))
+TREE_MAP_ENTRY(Status, ceilingSharedPair,
+	(const SharedTreeMap* stm, const void* key, void* pairBuffer),
+	(stm, key, pairBuffer))
+TREE_MAP_ENTRY(Status, floorSharedPair,
+	(const SharedTreeMap* stm, const void* key, void* pairBuffer),
+	(stm, key, pairBuffer))
+TREE_MAP_ENTRY(Status, higherSharedPair,
+	(const SharedTreeMap* stm, const void* key, void* pairBuffer),
+	(stm, key, pairBuffer))
+TREE_MAP_ENTRY(Status, lowerSharedPair,
+	(const SharedTreeMap* stm, const void* key, void* pairBuffer),
+	(stm, key, pairBuffer))
+TREE_MAP_ENTRY(TreeMapLog*, createTreeMapLog,
+	(TreeMap* tm, FILE* file, size_t batchSize, Status* status),
+	(tm, file, batchSize, status))
+TREE_MAP_ENTRY(Status, closeTreeMapLog, (TreeMapLog* log), (log))
+TREE_MAP_ENTRY(Status, commitTreeMapLog, (TreeMapLog* log), (log))
+TREE_MAP_ENTRY(Status, logPutPair, (TreeMapLog* log, const void* pair), (log, pair))
+TREE_MAP_ENTRY(Status, logDeletePair, (TreeMapLog* log, const void* key, void* pairBuffer), (log, key, pairBuffer))
+TREE_MAP_ENTRY(Status, logReplaceValue,
+	(TreeMapLog* log, const void* key, const void* replacementValue),
+	(log, key, replacementValue))
+TREE_MAP_ENTRY(Status, logPollFirstPair, (TreeMapLog* log, void* pairBuffer), (log, pairBuffer))
+TREE_MAP_ENTRY(Status, logPollLastPair, (TreeMapLog* log, void* pairBuffer), (log, pairBuffer))
+TREE_MAP_ENTRY(Status, replayTreeMapLog, (TreeMap* tm, FILE* file), (tm, file))
+TREE_MAP_ENTRY(Status, beginCheckpoint,
+	(TreeMap* tm, FILE* file, SerializePair serialize, size_t maxRecordSize),
+	(tm, file, serialize, maxRecordSize))
+TREE_MAP_ENTRY(Status, continueCheckpoint, (TreeMap* tm, size_t budget), (tm, budget))
+TREE_MAP_ENTRY(Status, cancelCheckpoint, (TreeMap* tm), (tm))
+TREE_MAP_ENTRY(LsmTree*, createLsmTree,
+	(TreeMap* memtable, const char* pathPrefix, size_t memtableLimit, Status* status),
+	(memtable, pathPrefix, memtableLimit, status))
+TREE_MAP_ENTRY(Status, closeLsmTree, (LsmTree* lsm), (lsm))
+TREE_MAP_ENTRY(Status, putLsmPair, (LsmTree* lsm, const void* pair), (lsm, pair))
+TREE_MAP_ENTRY(Status, deleteLsmPair, (LsmTree* lsm, const void* key), (lsm, key))
+TREE_MAP_ENTRY(Status, flushLsmTree, (LsmTree* lsm), (lsm))
+TREE_MAP_ENTRY(Status, compactLsmTree, (LsmTree* lsm), (lsm))
+TREE_MAP_ENTRY(Status, getLsmValue, (const LsmTree* lsm, const void* key, void* valueBuffer), (lsm, key, valueBuffer))
+TREE_MAP_ENTRY(Status, ceilingLsmPair, (const LsmTree* lsm, const void* key, void* pairBuffer), (lsm, key, pairBuffer))
+TREE_MAP_ENTRY(Status, higherLsmPair, (const LsmTree* lsm, const void* key, void* pairBuffer), (lsm, key, pairBuffer))
+TREE_MAP_ENTRY(Status, setTreeMapBudget, (TreeMap* tm, FILE* file, size_t budget), (tm, file, budget))
+TREE_MAP_ENTRY(Status, spillTreeMap, (TreeMap* tm), (tm))
+TREE_MAP_ENTRY(Status, restoreTreeMap, (TreeMap* tm), (tm))
+TREE_MAP_ENTRY(Status, savePagedTreeMap, (TreeMap* tm, FILE* file, size_t pageSize), (tm, file, pageSize))
+TREE_MAP_ENTRY(PagedTreeMap*, openPagedTreeMap,
+	(FILE* file, KeyComparison compareKeyFunc, size_t poolPages, size_t readAhead, Status* status),
+	(file, compareKeyFunc, poolPages, readAhead, status))
+TREE_MAP_ENTRY(Status, closePagedTreeMap, (PagedTreeMap* ptm), (ptm))
+TREE_MAP_ENTRY(Status, flushPagedTreeMap, (PagedTreeMap* ptm), (ptm))
+TREE_MAP_ENTRY(Status, getPagedValue, (PagedTreeMap* ptm, const void* key, void* valueBuffer), (ptm, key, valueBuffer))
+TREE_MAP_ENTRY(Status, replacePagedValue, (PagedTreeMap* ptm, const void* key, const void* value), (ptm, key, value))
+TREE_MAP_ENTRY(Status, ceilingPagedPair, (PagedTreeMap* ptm, const void* key, void* pairBuffer), (ptm, key, pairBuffer))
+TREE_MAP_ENTRY(Status, floorPagedPair, (PagedTreeMap* ptm, const void* key, void* pairBuffer), (ptm, key, pairBuffer))
+TREE_MAP_ENTRY(Status, higherPagedPair, (PagedTreeMap* ptm, const void* key, void* pairBuffer), (ptm, key, pairBuffer))
+TREE_MAP_ENTRY(Status, lowerPagedPair, (PagedTreeMap* ptm, const void* key, void* pairBuffer), (ptm, key, pairBuffer))
+TREE_MAP_ENTRY(ChangeStream*, createChangeStream,
+	(TreeMap* tm, size_t capacity, Status* status),
+	(tm, capacity, status))
+TREE_MAP_ENTRY(Status, closeChangeStream, (ChangeStream* cs), (cs))
+TREE_MAP_ENTRY(Status, resetChangeStream, (ChangeStream* cs), (cs))
+TREE_MAP_ENTRY(Status, drainChangeStream,
+	(ChangeStream* cs, void* records, size_t maxAmount, size_t* recordAmount),
+	(cs, records, maxAmount, recordAmount))
+TREE_MAP_ENTRY(Status, applyChangeBatch,
+	(TreeMap* replica, const void* records, size_t recordAmount),
+	(replica, records, recordAmount))
+TREE_MAP_ENTRY(Status, setTreeMapHash, (TreeMap* tm, HashPair hashPairFunc), (tm, hashPairFunc))
+TREE_MAP_ENTRY(Status, treeMapsEqual, (const TreeMap* tm1, const TreeMap* tm2), (tm1, tm2))
+TREE_MAP_ENTRY(Status, diffTreeMaps,
+	(const TreeMap* tm1, const TreeMap* tm2, VisitDifference visitFunc),
+	(tm1, tm2, visitFunc))
+TREE_MAP_ENTRY(Status, setTreeMapCounters, (TreeMap* tm, TreeMapCounters* counters), (tm, counters))
+TREE_MAP_ENTRY(Status, getTreeMapStats, (TreeMap* tm, TreeMapStats* stats), (tm, stats))
@@ -0,0 +1,814 @@
+; @file tree_map_log.asm
+;
+; Defines the write ahead logs of treemaps. Once a log is attached, putPair, deletePair, replaceValue,
+; the polls, rekeyPair and clearTreeMap record every successful mutation as a compact record,
+; so a treemap is durable without saving a whole snapshot after each change.
+; The records are collected in a buffer and a batch is written with a single flush to the storage,
+; which spreads the cost of the flush over many mutations. replayTreeMapLog applies the records of a
+; log onto the snapshot that was saved before the log was created.
+;
+; The log starts with a LogHeader. Every batch follows as a LogFrame with a checksum and its records.
+; A record is the byte of its kind followed by the key and the value it needs.
+;
+; @author Collector
+; @date 03/09/2023
+
+	include tree_map.inc
+
+	.code
+
+
+	public createTreeMapLog
+
+; Creates a write ahead log for the mutations of the treemap, attaches it and writes the header into the file.
+; The pairs are recorded byte by byte, so they must not hold pointers.
+;
+; @RCX qword[in] - Pointer to the treemap whose mutations are logged.
+; @RDX qword[in,out] - FILE pointer of a new file that was opened in binary mode for writing.
+; @R8 qword[in] - Amount of records that are committed together.
+; @R9 qword[out] - Pointer to a status code which is set to success if the log is created.
+;
+; @return The log or a nullptr. The status is set to treeMapNullptr, fileNullptr, batchSizeZero,
+;		  inlineSizeMismatch for inline pairs, valueDictionaryExists, logExists, errFileIo or errHeapAllocation.
+;		  Without a status pointer the function fails silently.
+createTreeMapLog proc
+
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	push r13
+	sub rsp, shadowStorage + 4 * qwordSize
+
+	mov rax, nullptr
+
+	; Check if a status pointer was given, otherwise fail silently.
+	cmp r9, nullptr
+	je functionReturn
+
+	mov rdi, r9
+
+	; Check if the treemap is a nullptr.
+	mov dword ptr [rdi], treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the file is a nullptr.
+	mov dword ptr [rdi], fileNullptr
+	cmp rdx, nullptr
+	je functionReturn
+
+	; Check if the batch size is not zero.
+	mov dword ptr [rdi], batchSizeZero
+	cmp r8, 0
+	je functionReturn
+
+	; The pairs of inline treenodes and interned values point outside of the treenodes.
+	mov dword ptr [rdi], inlineSizeMismatch
+	test [rcx].TreeMap.flags, inlinePairsFlag
+	jnz functionReturn
+
+	mov dword ptr [rdi], valueDictionaryExists
+	cmp [rcx].TreeMap.valueDictionary, nullptr
+	jne functionReturn
+
+	mov dword ptr [rdi], logExists
+	cmp [rcx].TreeMap.log, nullptr
+	jne functionReturn
+
+	; Save the treemap, the file and the batch size.
+	mov rbx, rcx
+	mov r12, rdx
+	mov r13, r8
+
+	; The buffer holds the frame and the biggest records of a whole batch.
+	; A key is followed by a value or, inside a rekey record, by the new key.
+	mov dword ptr [rdi], errHeapAllocation
+	mov rax, [rbx].TreeMap.keySize
+	mov rcx, [rbx].TreeMap.valueSize
+	cmp rcx, rax
+	jae addRecordSize
+
+	mov rcx, rax
+
+addRecordSize:
+	add rax, rcx
+	add rax, logRecordKindSize
+	mul r13
+	jc functionReturnNullptr
+
+	add rax, sizeof TreeMapLog + sizeof LogFrame
+	jc functionReturnNullptr
+
+	mov rcx, rax
+	call malloc
+
+	cmp rax, nullptr
+	je functionReturn
+
+	mov rsi, rax
+	mov [rsi].TreeMapLog.treeMap, rbx
+	mov [rsi].TreeMapLog.file, r12
+	lea rax, [rsi + sizeof TreeMapLog]
+	mov [rsi].TreeMapLog.buffer, rax
+	mov [rsi].TreeMapLog.used, sizeof LogFrame
+	mov [rsi].TreeMapLog.pendingAmount, 0
+	mov [rsi].TreeMapLog.batchSize, r13
+	mov [rsi].TreeMapLog.commitAmount, 0
+
+	; The header is committed together with the first batch.
+	mov rax, logMagic
+	mov [rsp + shadowStorage].LogHeader.magic, rax
+	mov [rsp + shadowStorage].LogHeader.version, logVersion
+	mov rax, [rbx].TreeMap.keySize
+	mov [rsp + shadowStorage].LogHeader.keySize, rax
+	mov rax, [rbx].TreeMap.valueSize
+	mov [rsp + shadowStorage].LogHeader.valueSize, rax
+
+	lea rcx, [rsp + shadowStorage]
+	mov edx, sizeof LogHeader
+	mov r8d, 1
+	mov r9, r12
+	call fwrite
+
+	cmp rax, 1
+	jne fileError
+
+	mov [rbx].TreeMap.log, rsi
+	mov dword ptr [rdi], success
+	mov rax, rsi
+
+	jmp functionReturn
+
+fileError:
+	mov rcx, rsi
+	call free
+
+	mov dword ptr [rdi], errFileIo
+
+functionReturnNullptr:
+	mov rax, nullptr
+
+functionReturn:
+	add rsp, shadowStorage + 4 * qwordSize
+	pop r13
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+createTreeMapLog endp
+
+
+	public closeTreeMapLog
+
+; Commits the pending records, detaches the log from its treemap and frees it. The file stays open.
+;
+; @RCX qword[in,out] - Pointer to the log.
+;
+; @return A status value for success, errFileIo or treeMapNullptr.
+closeTreeMapLog proc
+
+	push rsi
+	push rdi
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the log is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+
+	call commitTreeMapLog
+
+	; The log is freed even if the commit failed.
+	mov edi, eax
+	mov rax, [rsi].TreeMapLog.treeMap
+	mov [rax].TreeMap.log, nullptr
+	mov rcx, rsi
+	call free
+
+	mov eax, edi
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rdi
+	pop rsi
+	ret
+
+closeTreeMapLog endp
+
+
+	public commitTreeMapLog
+
+; Writes the pending records as one batch and waits until the file is stored.
+; Without pending records nothing is written.
+;
+; @RCX qword[in,out] - Pointer to the log.
+;
+; @return A status value for success, errFileIo or treeMapNullptr.
+commitTreeMapLog proc
+
+	push rsi
+	push rbx
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the log is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+
+	mov eax, success
+	cmp [rsi].TreeMapLog.pendingAmount, 0
+	je functionReturn
+
+	; Complete the frame in front of the records.
+	mov rbx, [rsi].TreeMapLog.buffer
+	mov rax, [rsi].TreeMapLog.used
+	sub rax, sizeof LogFrame
+	mov [rbx].LogFrame.byteAmount, rax
+	mov rax, [rsi].TreeMapLog.pendingAmount
+	mov [rbx].LogFrame.recordAmount, rax
+
+	; The checksum covers the fields before it and the records.
+	mov rcx, rbx
+	mov edx, sizeof LogFrame - qwordSize
+	mov r8, fnvOffsetBasis
+	call hashSnapshotBytes
+
+	lea rcx, [rbx + sizeof LogFrame]
+	mov rdx, [rbx].LogFrame.byteAmount
+	mov r8, rax
+	call hashSnapshotBytes
+
+	mov [rbx].LogFrame.checksum, rax
+
+	mov rcx, rbx
+	mov edx, 1
+	mov r8, [rsi].TreeMapLog.used
+	mov r9, [rsi].TreeMapLog.file
+	call fwrite
+
+	cmp rax, [rsi].TreeMapLog.used
+	jne fileError
+
+	; Hand the batch to the system and wait until it is stored.
+	mov rcx, [rsi].TreeMapLog.file
+	call fflush
+
+	cmp eax, 0
+	jne fileError
+
+	mov rcx, [rsi].TreeMapLog.file
+	call _fileno
+
+	mov ecx, eax
+	call _commit
+
+	cmp eax, 0
+	jne fileError
+
+	; Start the next batch.
+	mov [rsi].TreeMapLog.used, sizeof LogFrame
+	mov [rsi].TreeMapLog.pendingAmount, 0
+	inc [rsi].TreeMapLog.commitAmount
+
+	mov eax, success
+
+	jmp functionReturn
+
+fileError:
+	mov eax, errFileIo
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rbx
+	pop rsi
+	ret
+
+commitTreeMapLog endp
+
+
+	public logPutPair
+
+; Inserts the pair into the treemap of the log with putPair, which records the insertion.
+;
+; @RCX qword[in,out] - Pointer to the log.
+; @RDX qword[in] - Pointer to the pair.
+;
+; @return The status of putPair or treeMapNullptr.
+logPutPair proc
+
+	; Check if the log is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rcx, [rcx].TreeMapLog.treeMap
+	jmp putPair
+
+functionReturn:
+	ret
+
+logPutPair endp
+
+
+	public logDeletePair
+
+; Deletes the pair of the key from the treemap of the log with deletePair, which records the deletion.
+;
+; @RCX qword[in,out] - Pointer to the log.
+; @RDX qword[in] - Pointer to the key.
+; @R8 qword[out] - Pointer to a buffer that receives the deleted pair or a nullptr.
+;
+; @return The status of deletePair or treeMapNullptr.
+logDeletePair proc
+
+	; Check if the log is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rcx, [rcx].TreeMapLog.treeMap
+	jmp deletePair
+
+functionReturn:
+	ret
+
+logDeletePair endp
+
+
+	public logReplaceValue
+
+; Replaces the value of the key inside the treemap of the log with replaceValue, which records the replacement.
+;
+; @RCX qword[in,out] - Pointer to the log.
+; @RDX qword[in] - Pointer to the key.
+; @R8 qword[in] - Pointer to the new value.
+;
+; @return The status of replaceValue or treeMapNullptr.
+logReplaceValue proc
+
+	; Check if the log is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rcx, [rcx].TreeMapLog.treeMap
+	jmp replaceValue
+
+functionReturn:
+	ret
+
+logReplaceValue endp
+
+
+	public logPollFirstPair
+
+; Deletes the minimum pair of the treemap of the log with pollFirstPair, which records the deletion.
+;
+; @RCX qword[in,out] - Pointer to the log.
+; @RDX qword[out] - Pointer to a buffer that receives the deleted pair or a nullptr.
+;
+; @return The status of pollFirstPair or treeMapNullptr.
+logPollFirstPair proc
+
+	; Check if the log is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rcx, [rcx].TreeMapLog.treeMap
+	jmp pollFirstPair
+
+functionReturn:
+	ret
+
+logPollFirstPair endp
+
+
+	public logPollLastPair
+
+; Deletes the maximum pair of the treemap of the log with pollLastPair, which records the deletion.
+;
+; @RCX qword[in,out] - Pointer to the log.
+; @RDX qword[out] - Pointer to a buffer that receives the deleted pair or a nullptr.
+;
+; @return The status of pollLastPair or treeMapNullptr.
+logPollLastPair proc
+
+	; Check if the log is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rcx, [rcx].TreeMapLog.treeMap
+	jmp pollLastPair
+
+functionReturn:
+	ret
+
+logPollLastPair endp
+
+
+; Appends a record of a successful mutation to the log of the treemap. putPair, deletePair, replaceValue,
+; the polls, rekeyPair and clearTreeMap call it once the treemap has changed.
+;
+; @RCX qword[in] - Pointer to the treemap with a log.
+; @RDX byte[in] - Kind of the record, e.g. logPutRecord.
+; @R8 qword[in] - Pointer to the key of the record or a nullptr.
+; @R9 qword[in] - Pointer to the value or to the new key of a rekey record or a nullptr.
+;
+; @return The status inside EAX is kept, so the caller returns the status of its mutation,
+;		  unless a full batch can't be committed, then it is errFileIo.
+recordLogChange proc
+
+	push rdi
+	sub rsp, shadowStorage
+
+	mov edi, eax
+	mov rcx, [rcx].TreeMap.log
+	call appendLogRecord
+
+	cmp eax, success
+	jne functionReturn
+
+	mov eax, edi
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rdi
+	ret
+
+recordLogChange endp
+
+
+; Appends a record to the pending batch of the log and commits the batch once it is full.
+;
+; @RCX qword[in,out] - Pointer to the log.
+; @RDX byte[in] - Kind of the record, e.g. logPutRecord.
+; @R8 qword[in] - Pointer to the key of the record or a nullptr.
+; @R9 qword[in] - Pointer to the value or to the new key of a rekey record or a nullptr.
+;
+; @return A status value for success or errFileIo.
+appendLogRecord proc
+
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	push r13
+	sub rsp, shadowStorage
+
+	; Save the log, the key, the value and the size of the value.
+	mov rsi, rcx
+	mov rbx, r8
+	mov r12, r9
+	mov rdi, [rsi].TreeMapLog.treeMap
+	mov r13, [rdi].TreeMap.valueSize
+
+	; A rekey record holds the new key behind the old one.
+	cmp dl, logRekeyRecord
+	jne appendKind
+
+	mov r13, [rdi].TreeMap.keySize
+
+appendKind:
+
+	mov rax, [rsi].TreeMapLog.buffer
+	add rax, [rsi].TreeMapLog.used
+	mov [rax], dl
+	add [rsi].TreeMapLog.used, logRecordKindSize
+
+	cmp rbx, nullptr
+	je appendValue
+
+	mov rcx, [rsi].TreeMapLog.buffer
+	add rcx, [rsi].TreeMapLog.used
+	mov rdx, rbx
+	mov r8, [rdi].TreeMap.keySize
+	call memcpy
+
+	mov rax, [rdi].TreeMap.keySize
+	add [rsi].TreeMapLog.used, rax
+
+appendValue:
+	cmp r12, nullptr
+	je countRecord
+
+	mov rcx, [rsi].TreeMapLog.buffer
+	add rcx, [rsi].TreeMapLog.used
+	mov rdx, r12
+	mov r8, r13
+	call memcpy
+
+	add [rsi].TreeMapLog.used, r13
+
+countRecord:
+	; A full batch is committed right away.
+	inc [rsi].TreeMapLog.pendingAmount
+
+	mov eax, success
+	mov rcx, [rsi].TreeMapLog.pendingAmount
+	cmp rcx, [rsi].TreeMapLog.batchSize
+	jb functionReturn
+
+	mov rcx, rsi
+	call commitTreeMapLog
+
+functionReturn:
+	add rsp, shadowStorage
+	pop r13
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+appendLogRecord endp
+
+
+	public replayTreeMapLog
+
+; Applies the records of a log onto the treemap, which has to hold the snapshot that was saved
+; before the log was created. Replaying stops at the first batch that is incomplete or whose
+; checksum doesn't match, because a crash can only tear the batch that was committed last.
+;
+; @RCX qword[in,out] - Pointer to the treemap.
+; @RDX qword[in,out] - FILE pointer of the log that was opened in binary mode for reading.
+;
+; @return A status value for success, fileNullptr, inlineSizeMismatch for inline pairs,
+;		  valueDictionaryExists, snapshotInvalid if the log belongs to other pair sizes or holds
+;		  an unknown record, the status of a mutation that fails, errHeapAllocation or treeMapNullptr.
+replayTreeMapLog proc
+
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	push r13
+	push r14
+	push r15
+	sub rsp, shadowStorage + 4 * qwordSize
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the file is a nullptr.
+	mov eax, fileNullptr
+	cmp rdx, nullptr
+	je functionReturn
+
+	; The pairs of inline treenodes and interned values point outside of the treenodes.
+	mov eax, inlineSizeMismatch
+	test [rcx].TreeMap.flags, inlinePairsFlag
+	jnz functionReturn
+
+	mov eax, valueDictionaryExists
+	cmp [rcx].TreeMap.valueDictionary, nullptr
+	jne functionReturn
+
+	; Save the treemap and the file. The buffer for the records grows with the batches.
+	mov rsi, rcx
+	mov r12, rdx
+	mov rdi, nullptr
+	mov r13, 0
+
+	; A log without a complete header has no committed batch.
+	lea rcx, [rsp + shadowStorage]
+	mov edx, 1
+	mov r8d, sizeof LogHeader
+	mov r9, r12
+	call fread
+
+	mov r15d, success
+	cmp rax, sizeof LogHeader
+	jne freeBuffer
+
+	mov r15d, snapshotInvalid
+	mov rax, logMagic
+	cmp [rsp + shadowStorage].LogHeader.magic, rax
+	jne freeBuffer
+
+	cmp [rsp + shadowStorage].LogHeader.version, logVersion
+	jne freeBuffer
+
+	mov rax, [rsi].TreeMap.keySize
+	cmp [rsp + shadowStorage].LogHeader.keySize, rax
+	jne freeBuffer
+
+	mov rax, [rsi].TreeMap.valueSize
+	cmp [rsp + shadowStorage].LogHeader.valueSize, rax
+	jne freeBuffer
+
+readFrame:
+	; A torn batch ends the log.
+	mov r15d, success
+	lea rcx, [rsp + shadowStorage]
+	mov edx, 1
+	mov r8d, sizeof LogFrame
+	mov r9, r12
+	call fread
+
+	cmp rax, sizeof LogFrame
+	jne freeBuffer
+
+	; Grow the buffer if the records of the batch don't fit.
+	; A key behind the records receives the old key of a rekey record.
+	mov rax, [rsp + shadowStorage].LogFrame.byteAmount
+	cmp rax, r13
+	jbe readRecords
+
+	mov rcx, rdi
+	call free
+
+	mov r13, [rsp + shadowStorage].LogFrame.byteAmount
+	mov rcx, r13
+	add rcx, [rsi].TreeMap.keySize
+	call malloc
+
+	mov rdi, rax
+	mov r15d, errHeapAllocation
+	cmp rdi, nullptr
+	je freeBuffer
+
+readRecords:
+	mov r15d, success
+	mov rcx, rdi
+	mov edx, 1
+	mov r8, [rsp + shadowStorage].LogFrame.byteAmount
+	mov r9, r12
+	call fread
+
+	cmp rax, [rsp + shadowStorage].LogFrame.byteAmount
+	jne freeBuffer
+
+	lea rcx, [rsp + shadowStorage]
+	mov edx, sizeof LogFrame - qwordSize
+	mov r8, fnvOffsetBasis
+	call hashSnapshotBytes
+
+	mov rcx, rdi
+	mov rdx, [rsp + shadowStorage].LogFrame.byteAmount
+	mov r8, rax
+	call hashSnapshotBytes
+
+	cmp [rsp + shadowStorage].LogFrame.checksum, rax
+	jne freeBuffer
+
+	; Apply the records of the batch in order.
+	mov rbx, rdi
+	mov r14, rdi
+	add r14, [rsp + shadowStorage].LogFrame.byteAmount
+
+applyRecord:
+	cmp rbx, r14
+	jae readFrame
+
+	; Calculate the size of the record behind its kind.
+	movzx eax, byte ptr [rbx]
+	inc rbx
+	mov r15, 0
+
+	cmp eax, logPollFirstRecord
+	je checkRecordSize
+
+	cmp eax, logPollLastRecord
+	je checkRecordSize
+
+	cmp eax, logClearRecord
+	je checkRecordSize
+
+	mov r15, [rsi].TreeMap.keySize
+
+	cmp eax, logDeleteRecord
+	je checkRecordSize
+
+	; A rekey record holds the old and the new key.
+	cmp eax, logRekeyRecord
+	jne addValueSize
+
+	add r15, [rsi].TreeMap.keySize
+
+	jmp checkRecordSize
+
+addValueSize:
+	add r15, [rsi].TreeMap.valueSize
+
+	cmp eax, logPutRecord
+	je checkRecordSize
+
+	cmp eax, logReplaceRecord
+	jne invalidRecord
+
+checkRecordSize:
+	mov rcx, r14
+	sub rcx, rbx
+	cmp r15, rcx
+	ja invalidRecord
+
+	mov rcx, rsi
+	mov rdx, rbx
+
+	cmp eax, logPutRecord
+	je replayPut
+
+	cmp eax, logDeleteRecord
+	je replayDelete
+
+	cmp eax, logReplaceRecord
+	je replayReplace
+
+	cmp eax, logPollFirstRecord
+	je replayPollFirst
+
+	cmp eax, logRekeyRecord
+	je replayRekey
+
+	cmp eax, logClearRecord
+	je replayClear
+
+	mov rdx, nullptr
+	call pollLastPair
+
+	jmp checkReplayStatus
+
+replayPut:
+	call putPair
+
+	jmp checkReplayStatus
+
+replayDelete:
+	mov r8, nullptr
+	call deletePair
+
+	jmp checkReplayStatus
+
+replayReplace:
+	mov r8, rbx
+	add r8, [rsi].TreeMap.keySize
+	call replaceValue
+
+	jmp checkReplayStatus
+
+replayPollFirst:
+	mov rdx, nullptr
+	call pollFirstPair
+
+	jmp checkReplayStatus
+
+replayRekey:
+	; The old key is copied behind the records of the batch.
+	mov r8, rbx
+	add r8, [rsi].TreeMap.keySize
+	lea r9, [rdi + r13]
+	call rekeyPair
+
+	jmp checkReplayStatus
+
+replayClear:
+	call clearTreeMap
+
+checkReplayStatus:
+	; Every record was logged after its mutation succeeded, so it has to succeed again.
+	cmp eax, success
+	jne replayFailed
+
+	add rbx, r15
+
+	jmp applyRecord
+
+replayFailed:
+	mov r15d, eax
+
+	jmp freeBuffer
+
+invalidRecord:
+	mov r15d, snapshotInvalid
+
+freeBuffer:
+	mov rcx, rdi
+	call free
+
+	mov eax, r15d
+
+functionReturn:
+	add rsp, shadowStorage + 4 * qwordSize
+	pop r15
+	pop r14
+	pop r13
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+replayTreeMapLog endp
+
+end
@@ -0,0 +1,88 @@
+/*
+* @file tree_map_log_bench.cpp
+*
+* Defines the benchmarks of the durable write throughput of logPutPair for
+* several batch sizes of the write ahead log. The log is written next to the
+* results in the working directory, so it is flushed to the same storage.
+*
+* @author Collector
+* @data 10/17/2026
+*/
+
+#include <cstdio>
+#include <string>
+
+#include "bench_utils.h"
+
+namespace {
+	/*
+	* Amount of pairs that an iteration inserts. Small batches flush once per pair,
+	* so the amount stays independent of the treemap sizes of the other benchmarks.
+	*/
+	constexpr size_t logPairAmount{ 16'384 };
+
+	/*
+	* File of the log inside the working directory, it is removed after every benchmark.
+	*/
+	constexpr const char* logFileName{ "tree_map_bench.log" };
+
+	void benchmarkLogPutPair(benchmark::State& state, size_t batchSize) {
+		std::vector<uint32_t> order{ createKeyOrder(KeyDistribution::UNIFORM, logPairAmount) };
+		std::vector<IntegerPair> pairs(order.size());
+		size_t commitAmount{ 0 };
+
+		for (size_t i{ 0 }; i < order.size(); i++) {
+			makeBenchmarkPair<IntegerKeys>(order[i], &pairs[i]);
+		}
+
+		for (auto _ : state) {
+			state.PauseTiming();
+
+			TreeMap* tm{ IntegerKeys::createMap() };
+			FILE* file{ std::fopen(logFileName, "wb") };
+			Status s;
+			TreeMapLog* log{ createTreeMapLog(tm, file, batchSize, &s) };
+
+			if (log == nullptr) {
+				state.SkipWithError("The log can't be created.");
+				deleteTreeMap(tm);
+
+				if (file != nullptr) {
+					std::fclose(file);
+				}
+
+				break;
+			}
+
+			state.ResumeTiming();
+
+			for (const IntegerPair& pair : pairs) {
+				benchmark::DoNotOptimize(logPutPair(log, &pair));
+			}
+
+			// The last partial batch is committed as well, so every pair is durable.
+			commitTreeMapLog(log);
+			commitAmount += log->commitAmount;
+			closeTreeMapLog(log);
+
+			state.PauseTiming();
+			deleteTreeMap(tm);
+			std::fclose(file);
+			state.ResumeTiming();
+		}
+
+		std::remove(logFileName);
+
+		state.SetItemsProcessed(state.iterations() * logPairAmount);
+		state.counters["commits_per_iteration"] = benchmark::Counter(static_cast<double>(commitAmount),
+			benchmark::Counter::kAvgIterations);
+	}
+}
+
+void registerLogBenchmarks() {
+	// The real time is measured, because the process waits for the flushes without using the processor.
+	for (size_t batchSize : { 1, 8, 64, 512, 4096 }) {
+		benchmark::RegisterBenchmark(("log/logPutPair/batch/" + std::to_string(batchSize)).c_str(),
+			benchmarkLogPutPair, batchSize)->Unit(benchmark::kMillisecond)->UseRealTime();
+	}
+}
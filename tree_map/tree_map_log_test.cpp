@@ -0,0 +1,287 @@
+/*
+* @file tree_map_log_test.h
+*
+* Defines unit tests for the write ahead logs of the tree map
+* implementation.
+*
+* @author Collector
+* @data 03/09/2023
+*/
+
+
+#include "utils.h"
+
+TEST(TreeMap, createTreeMapLogShouldFailForInvalidParameters) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(0, 1) };
+	FILE* file{ createTemporaryFile() };
+	TreeMapLog* log{ createTreeMapLog(nullptr, file, 4, &s) };
+
+	ASSERT_EQ(nullptr, log);
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, s);
+
+	log = createTreeMapLog(tm, nullptr, 4, &s);
+
+	ASSERT_EQ(nullptr, log);
+	ASSERT_EQ(Status::FILE_NULLPTR, s);
+
+	log = createTreeMapLog(tm, file, 0, &s);
+
+	ASSERT_EQ(nullptr, log);
+	ASSERT_EQ(Status::BATCH_SIZE_ZERO, s);
+
+	// A treemap has one log at a time.
+	log = createTreeMapLog(tm, file, 4, &s);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(log, tm->log);
+	ASSERT_EQ(nullptr, createTreeMapLog(tm, file, 4, &s));
+	ASSERT_EQ(Status::LOG_EXISTS, s);
+
+	closeTreeMapLog(log);
+
+	ASSERT_EQ(nullptr, tm->log);
+
+	fclose(file);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, treeMapLogShouldCommitOncePerBatch) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(0, 1) };
+	FILE* file{ createTemporaryFile() };
+	TreeMapLog* log{ createTreeMapLog(tm, file, 4, &s) };
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	for (size_t key{ 0 }; key < 10; key++) {
+		size_t pair[2]{ key, key * key };
+
+		s = logPutPair(log, pair);
+
+		ASSERT_EQ(Status::SUCCESS, s);
+	}
+
+	ASSERT_EQ(10, tm->nodeAmount);
+	ASSERT_EQ(2, log->commitAmount);
+	ASSERT_EQ(2, log->pendingAmount);
+
+	s = commitTreeMapLog(log);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(3, log->commitAmount);
+	ASSERT_EQ(0, log->pendingAmount);
+
+	// Failed mutations aren't recorded.
+	size_t pair[2]{ 3, 9 };
+
+	s = logPutPair(log, pair);
+
+	ASSERT_EQ(Status::ALREADY_CONTAINS, s);
+	ASSERT_EQ(0, log->pendingAmount);
+
+	s = closeTreeMapLog(log);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	fclose(file);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, replayTreeMapLogShouldRestoreMutations) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(100, 1) };
+	FILE* snapshot{ createTemporaryFile() };
+	FILE* file{ createTemporaryFile() };
+
+	saveTreeMap(tm, snapshot, nullptr, 0);
+
+	TreeMapLog* log{ createTreeMapLog(tm, file, 8, &s) };
+
+	for (size_t key{ 100 }; key < 150; key++) {
+		size_t pair[2]{ key, key * key };
+
+		logPutPair(log, pair);
+	}
+
+	for (size_t key{ 10 }; key < 20; key++) {
+		logDeletePair(log, &key, nullptr);
+	}
+
+	size_t key{ 50 }, value{ 7 }, pair[2]{};
+
+	logReplaceValue(log, &key, &value);
+	logPollFirstPair(log, pair);
+
+	ASSERT_EQ(0, pair[0]);
+
+	logPollLastPair(log, nullptr);
+	closeTreeMapLog(log);
+
+	// Load the snapshot and replay the log onto it.
+	TreeMap* loaded{ createTestNumberTree(0, 1) };
+
+	rewind(snapshot);
+	rewind(file);
+
+	s = loadTreeMap(loaded, snapshot, nullptr);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	s = replayTreeMapLog(loaded, file);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertNumberTreeMapsEqual(tm, loaded);
+
+	fclose(file);
+	fclose(snapshot);
+	deleteTreeMap(loaded);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, treeMapLogShouldRecordMutationsOfTheTreeMap) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(100, 1) };
+	FILE* snapshot{ createTemporaryFile() };
+	FILE* file{ createTemporaryFile() };
+
+	saveTreeMap(tm, snapshot, nullptr, 0);
+
+	TreeMapLog* log{ createTreeMapLog(tm, file, 8, &s) };
+
+	// The plain functions of the treemap are recorded like the ones of the log.
+	for (size_t key{ 100 }; key < 120; key++) {
+		size_t pair[2]{ key, key * key };
+
+		ASSERT_EQ(Status::SUCCESS, putPair(tm, pair));
+	}
+
+	size_t key{ 20 }, newKey{ 500 }, oldKey{ 0 }, value{ 7 };
+
+	ASSERT_EQ(Status::SUCCESS, deletePair(tm, &key, nullptr));
+
+	key = 30;
+
+	ASSERT_EQ(Status::SUCCESS, replaceValue(tm, &key, &value));
+	ASSERT_EQ(Status::SUCCESS, rekeyPair(tm, &key, &newKey, &oldKey));
+	ASSERT_EQ(Status::SUCCESS, pollFirstPair(tm, nullptr));
+	ASSERT_EQ(Status::SUCCESS, pollLastPair(tm, nullptr));
+	ASSERT_EQ(25, 8 * log->commitAmount + log->pendingAmount);
+
+	// Failed mutations aren't recorded.
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, deletePair(tm, &key, nullptr));
+	ASSERT_EQ(25, 8 * log->commitAmount + log->pendingAmount);
+
+	closeTreeMapLog(log);
+
+	TreeMap* loaded{ createTestNumberTree(0, 1) };
+
+	rewind(snapshot);
+	rewind(file);
+
+	ASSERT_EQ(Status::SUCCESS, loadTreeMap(loaded, snapshot, nullptr));
+	ASSERT_EQ(Status::SUCCESS, replayTreeMapLog(loaded, file));
+	assertNumberTreeMapsEqual(tm, loaded);
+
+	// A clear is replayed as well.
+	FILE* clearedFile{ createTemporaryFile() };
+
+	log = createTreeMapLog(tm, clearedFile, 8, &s);
+
+	size_t pair[2]{ 1000, 1 };
+
+	ASSERT_EQ(Status::SUCCESS, clearTreeMap(tm));
+	ASSERT_EQ(Status::SUCCESS, putPair(tm, pair));
+
+	// Deleting the treemap closes its log, which commits the pending records.
+	TreeMap* cleared{ createTestNumberTree(0, 1) };
+
+	deleteTreeMap(tm);
+	rewind(clearedFile);
+
+	ASSERT_EQ(Status::SUCCESS, replayTreeMapLog(loaded, clearedFile));
+	ASSERT_EQ(Status::SUCCESS, putPair(cleared, pair));
+	assertNumberTreeMapsEqual(cleared, loaded);
+
+	fclose(clearedFile);
+	fclose(file);
+	fclose(snapshot);
+	deleteTreeMap(cleared);
+	deleteTreeMap(loaded);
+}
+
+TEST(TreeMap, replayTreeMapLogShouldStopAtTornBatch) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(0, 1) };
+	FILE* file{ createTemporaryFile() };
+	TreeMapLog* log{ createTreeMapLog(tm, file, 5, &s) };
+
+	for (size_t key{ 0 }; key < 10; key++) {
+		size_t pair[2]{ key, key * key };
+
+		logPutPair(log, pair);
+	}
+
+	// Cut the end of the second batch off like a crash during its commit would.
+	FILE* torn{ createTemporaryFile() };
+	char bytes[1024];
+
+	rewind(file);
+
+	size_t amount{ fread(bytes, 1, sizeof(bytes), file) };
+
+	fwrite(bytes, 1, amount - 3, torn);
+	rewind(torn);
+
+	TreeMap* replayed{ createTestNumberTree(0, 1) };
+
+	s = replayTreeMapLog(replayed, torn);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(5, replayed->nodeAmount);
+
+	closeTreeMapLog(log);
+	fclose(torn);
+	fclose(file);
+	deleteTreeMap(replayed);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, replayTreeMapLogShouldRejectOtherPairSizes) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(0, 1) };
+	FILE* file{ createTemporaryFile() };
+	TreeMapLog* log{ createTreeMapLog(tm, file, 1, &s) };
+	size_t pair[2]{ 1, 1 };
+
+	logPutPair(log, pair);
+	closeTreeMapLog(log);
+	rewind(file);
+
+	TreeMap* states{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeTreeNodePair, &s) };
+
+	s = replayTreeMapLog(states, file);
+
+	ASSERT_EQ(Status::SNAPSHOT_INVALID, s);
+	ASSERT_EQ(0, states->nodeAmount);
+
+	fclose(file);
+	deleteTreeMap(states);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, replayTreeMapLogShouldAcceptEmptyLog) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(10, 1) };
+	FILE* file{ createTemporaryFile() };
+
+	// A crash before the first commit leaves an empty file.
+	s = replayTreeMapLog(tm, file);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(10, tm->nodeAmount);
+
+	fclose(file);
+	deleteTreeMap(tm);
+}
@@ -0,0 +1,1718 @@
+; @file tree_map_lsm.asm
+;
+; Defines the log structured merge trees of treemaps. A treemap acts as the memtable that takes every
+; write. Once the memtable reaches its limit it is flushed in key order into an immutable sorted run file,
+; so the data can outgrow the memory. A deleted key leaves a tombstone that hides it in the older runs.
+;
+; A run file starts with a LsmRunHeader and holds the records in key order, split into blocks of 4 KiB.
+; The first key of every block forms the block index and a Bloom filter tells most missing keys apart
+; without touching the records. The runs are mapped into the address space, so the system pages them in
+; on demand. compactLsmTree merges all runs into one and drops the tombstones and replaced pairs.
+;
+; The pairs are stored byte by byte and must not hold pointers.
+;
+; @author Collector
+; @date 03/09/2023
+
+	include tree_map.inc
+
+	.code
+
+
+	public createLsmTree
+
+; Creates a log structured merge tree that uses the treemap as its memtable.
+;
+; @RCX qword[in,out] - Pointer to the treemap that is used as the memtable.
+; @RDX qword[in] - Pointer to the path prefix of the run files, a counter and .run are appended to it.
+; @R8 qword[in] - Amount of pairs and tombstones that the memtable holds before it is flushed.
+; @R9 qword[out] - Pointer to a status code which is set to success if the tree is created.
+;
+; @return The lsm tree or a nullptr. The status is set to treeMapNullptr, fileNullptr, memtableLimitZero,
+;		  inlineSizeMismatch for inline pairs, valueDictionaryExists, memtableMultiMap or errHeapAllocation.
+;		  Without a status pointer the function fails silently.
+createLsmTree proc
+
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	push r13
+	push r14
+	sub rsp, shadowStorage + qwordSize
+
+	mov rax, nullptr
+
+	; Check if a status pointer was given, otherwise fail silently.
+	cmp r9, nullptr
+	je functionReturn
+
+	mov rdi, r9
+
+	; Check if the memtable is a nullptr.
+	mov dword ptr [rdi], treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the path prefix is a nullptr.
+	mov dword ptr [rdi], fileNullptr
+	cmp rdx, nullptr
+	je functionReturn
+
+	; Check if the limit is not zero.
+	mov dword ptr [rdi], memtableLimitZero
+	cmp r8, 0
+	je functionReturn
+
+	; The pairs of inline treenodes and interned values point outside of the treenodes.
+	mov dword ptr [rdi], inlineSizeMismatch
+	test [rcx].TreeMap.flags, inlinePairsFlag
+	jnz functionReturn
+
+	mov dword ptr [rdi], valueDictionaryExists
+	cmp [rcx].TreeMap.valueDictionary, nullptr
+	jne functionReturn
+
+	; A key can only have a single pair.
+	mov dword ptr [rdi], memtableMultiMap
+	test [rcx].TreeMap.flags, multiMapFlag
+	jnz functionReturn
+
+	; Save the memtable, the path prefix and the limit.
+	mov rbx, rcx
+	mov r12, rdx
+	mov r13, r8
+
+	; The tombstones are kept in a treemap like the memtable.
+	mov dword ptr [rdi], errHeapAllocation
+	mov rsi, rbx
+	call createSiblingTreeMap
+
+	cmp rax, nullptr
+	je functionReturn
+
+	mov [rsp + shadowStorage], rax
+
+	; The path prefix with its terminator follows the tree.
+	mov rcx, r12
+	call strlen
+
+	mov r14, rax
+	lea rcx, [rax + sizeof LsmTree + 1]
+	call malloc
+
+	cmp rax, nullptr
+	je deleteTombstones
+
+	mov rsi, rax
+	lea rcx, [rsi + sizeof LsmTree]
+	mov rdx, r12
+	lea r8, [r14 + 1]
+	call memcpy
+
+	mov [rsi].LsmTree.pathPrefix, rax
+	mov [rsi].LsmTree.memtable, rbx
+	mov rax, [rsp + shadowStorage]
+	mov [rsi].LsmTree.tombstones, rax
+	mov [rsi].LsmTree.memtableLimit, r13
+	mov [rsi].LsmTree.nextRunId, 0
+	mov [rsi].LsmTree.runAmount, 0
+
+	; A record is the pair and its kind, every record and key of the index starts at a quadword.
+	mov rax, [rbx].TreeMap.keySize
+	mov [rsi].LsmTree.keySize, rax
+	add rax, qwordSize - 1
+	and rax, -qwordSize
+	mov [rsi].LsmTree.keyStride, rax
+
+	mov rcx, [rbx].TreeMap.valueSize
+	mov [rsi].LsmTree.valueSize, rcx
+	mov rax, [rbx].TreeMap.keySize
+	lea rax, [rax + rcx + qwordSize]
+	and rax, -qwordSize
+	mov [rsi].LsmTree.recordStride, rax
+
+	mov dword ptr [rdi], success
+	mov rax, rsi
+
+	jmp functionReturn
+
+deleteTombstones:
+	mov rcx, [rsp + shadowStorage]
+	call deleteTreeMap
+
+	mov rax, nullptr
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop r14
+	pop r13
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+createLsmTree endp
+
+
+	public closeLsmTree
+
+; Deletes the run files and frees the lsm tree. The pairs of the memtable aren't flushed
+; and the memtable itself isn't deleted.
+;
+; @RCX qword[in,out] - Pointer to the lsm tree that is closed.
+;
+; @return A status value for success or treeMapNullptr.
+closeLsmTree proc
+
+	push rsi
+	push rbx
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the lsm tree is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+	mov rbx, [rsi].LsmTree.runAmount
+
+closeRuns:
+	cmp rbx, 0
+	je freeLsmTree
+
+	dec rbx
+	lea rax, [rsi].LsmTree.runs
+	mov rcx, [rax + rbx * qwordSize]
+	call closeLsmRun
+
+	jmp closeRuns
+
+freeLsmTree:
+	mov rcx, [rsi].LsmTree.tombstones
+	call deleteTreeMap
+
+	mov rcx, rsi
+	call free
+
+	mov eax, success
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rbx
+	pop rsi
+	ret
+
+closeLsmTree endp
+
+
+	public putLsmPair
+
+; Inserts the pair into the memtable or replaces the value of its key. A tombstone of the key is removed.
+; The memtable is flushed if it reaches its limit.
+;
+; @RCX qword[in,out] - Pointer to the lsm tree.
+; @RDX qword[in] - Pointer to the pair that is inserted.
+;
+; @return A status value for success, the status of putPair, replaceValue or flushLsmTree,
+;		  treeNodePairNullptr or treeMapNullptr.
+putLsmPair proc
+
+	push rsi
+	push rdi
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the lsm tree is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the pair is a nullptr.
+	mov eax, treeNodePairNullptr
+	cmp rdx, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+	mov rdi, rdx
+
+	; The newer pair replaces the tombstone.
+	mov rcx, [rsi].LsmTree.tombstones
+	mov rdx, rdi
+	call containsKey
+
+	cmp eax, success
+	jne insertPair
+
+	mov rcx, [rsi].LsmTree.tombstones
+	mov rdx, rdi
+	mov r8, nullptr
+	call deletePair
+
+insertPair:
+	mov rcx, [rsi].LsmTree.memtable
+	mov rdx, rdi
+	call putPair
+
+	cmp eax, alreadyContains
+	jne checkInsertion
+
+	mov rcx, [rsi].LsmTree.memtable
+	mov rdx, rdi
+	lea r8, [rdi]
+	add r8, [rsi].LsmTree.keySize
+	call replaceValue
+
+checkInsertion:
+	cmp eax, success
+	jne functionReturn
+
+	call flushFullMemtable
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rdi
+	pop rsi
+	ret
+
+putLsmPair endp
+
+
+	public deleteLsmPair
+
+; Deletes the key out of the memtable and leaves a tombstone that hides it inside the runs.
+; The key doesn't have to exist. The memtable is flushed if it reaches its limit.
+;
+; @RCX qword[in,out] - Pointer to the lsm tree.
+; @RDX qword[in] - Pointer to the key that is deleted.
+;
+; @return A status value for success, the status of putPair or flushLsmTree, keyBufferNullptr or treeMapNullptr.
+deleteLsmPair proc
+
+	push rbp
+	mov rbp, rsp
+	push rsi
+	push rdi
+	sub rsp, shadowStorage
+
+	; Check if the lsm tree is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the key is a nullptr.
+	mov eax, keyBufferNullptr
+	cmp rdx, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+	mov rdi, rdx
+
+	; deletePair only searches keys that exist.
+	mov rcx, [rsi].LsmTree.memtable
+	call containsKey
+
+	cmp eax, success
+	jne checkRuns
+
+	mov rcx, [rsi].LsmTree.memtable
+	mov rdx, rdi
+	mov r8, nullptr
+	call deletePair
+
+checkRuns:
+	; Without a run nothing older has to be hidden.
+	mov eax, success
+	cmp [rsi].LsmTree.runAmount, 0
+	je functionReturn
+
+	; The tombstone is a pair of the key and an empty value on the stack.
+	sub rsp, [rsi].LsmTree.keySize
+	sub rsp, [rsi].LsmTree.valueSize
+	and rsp, -16
+	sub rsp, shadowStorage
+
+	lea rcx, [rsp + shadowStorage]
+	mov edx, 0
+	mov r8, [rsi].LsmTree.keySize
+	add r8, [rsi].LsmTree.valueSize
+	call memset
+
+	lea rcx, [rsp + shadowStorage]
+	mov rdx, rdi
+	mov r8, [rsi].LsmTree.keySize
+	call memcpy
+
+	; An existing tombstone stays as it is.
+	mov rcx, [rsi].LsmTree.tombstones
+	lea rdx, [rsp + shadowStorage]
+	call putPair
+
+	cmp eax, alreadyContains
+	je flushMemtable
+
+	cmp eax, success
+	jne functionReturn
+
+flushMemtable:
+	call flushFullMemtable
+
+functionReturn:
+	lea rsp, [rbp - 2 * qwordSize]
+	pop rdi
+	pop rsi
+	pop rbp
+	ret
+
+deleteLsmPair endp
+
+
+; Flushes the memtable if it holds as many pairs and tombstones as its limit allows.
+;
+; @RSI qword[in,out] - Pointer to the lsm tree.
+;
+; @return A status value for success or the status of flushLsmTree.
+flushFullMemtable proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov rcx, [rsi].LsmTree.memtable
+	mov rax, [rcx].TreeMap.nodeAmount
+	mov rcx, [rsi].LsmTree.tombstones
+	add rax, [rcx].TreeMap.nodeAmount
+
+	cmp rax, [rsi].LsmTree.memtableLimit
+	mov eax, success
+	jb functionReturn
+
+	mov rcx, rsi
+	call flushLsmTree
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	ret
+
+flushFullMemtable endp
+
+
+	public flushLsmTree
+
+; Writes the pairs and tombstones of the memtable in key order into a new run and clears the memtable.
+; If the maximum amount of runs exists, they are compacted first.
+;
+; @RCX qword[in,out] - Pointer to the lsm tree.
+;
+; @return A status value for success, the status of compactLsmTree, errFileIo, errHeapAllocation or treeMapNullptr.
+;		  The memtable keeps its pairs if the run can't be written.
+flushLsmTree proc
+
+	push rbx
+	push rsi
+	push rdi
+	push r12
+	push r13
+	sub rsp, shadowStorage + 2 * qwordSize
+
+	; Check if the lsm tree is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+
+	; An empty memtable doesn't need a run.
+	mov rcx, [rsi].LsmTree.memtable
+	mov r12, [rcx].TreeMap.nodeAmount
+	mov rcx, [rsi].LsmTree.tombstones
+	add r12, [rcx].TreeMap.nodeAmount
+
+	mov eax, success
+	cmp r12, 0
+	je functionReturn
+
+	; The run takes every pair of the memtable, spilled ones are faulted back in.
+	mov rcx, [rsi].LsmTree.memtable
+	call restoreSpilledTreeMap
+
+	cmp eax, success
+	jne functionReturn
+
+	cmp [rsi].LsmTree.runAmount, maxLsmRuns
+	jb createRun
+
+	mov rcx, rsi
+	call compactLsmTree
+
+	cmp eax, success
+	jne functionReturn
+
+createRun:
+	mov rcx, r12
+	lea rdx, [rsp + lsmRunOut]
+	call createLsmRun
+
+	cmp eax, success
+	jne functionReturn
+
+	mov rbx, [rsp + lsmRunOut]
+
+	; Merge the pairs and the tombstones, both hold different keys.
+	mov rcx, [rsi].LsmTree.memtable
+	mov rdx, nullptr
+	mov r8b, false
+	call findHigherTreeNode
+
+	mov rdi, rax
+
+	mov rcx, [rsi].LsmTree.tombstones
+	mov rdx, nullptr
+	mov r8b, false
+	call findHigherTreeNode
+
+	mov r13, rax
+
+mergeRecords:
+	cmp rdi, nullptr
+	je appendTombstone
+
+	cmp r13, nullptr
+	je appendPair
+
+	; The compare function returns the sign of the tombstone minus the pair.
+	mov rcx, [rsi].LsmTree.memtable
+	mov rdx, rdi
+	mov r8, r13
+	call compareLsmKeys
+
+	cmp eax, 0
+	jl appendTombstone
+
+appendPair:
+	mov rcx, rbx
+	mov rdx, rdi
+	mov r8b, lsmPairRecord
+	call appendLsmRecord
+
+	mov rcx, [rsi].LsmTree.memtable
+	mov rdx, rdi
+	mov r8b, false
+	call findHigherTreeNode
+
+	mov rdi, rax
+
+	jmp mergeRecords
+
+appendTombstone:
+	cmp r13, nullptr
+	je finishRun
+
+	mov rcx, rbx
+	mov rdx, r13
+	mov r8b, lsmTombstoneRecord
+	call appendLsmRecord
+
+	mov rcx, [rsi].LsmTree.tombstones
+	mov rdx, r13
+	mov r8b, false
+	call findHigherTreeNode
+
+	mov r13, rax
+
+	jmp mergeRecords
+
+finishRun:
+	mov rcx, rbx
+	call finishLsmRun
+
+	cmp eax, success
+	jne closeRun
+
+	; The run is the newest one and the memtable starts over.
+	mov rax, [rsi].LsmTree.runAmount
+	lea rcx, [rsi].LsmTree.runs
+	mov [rcx + rax * qwordSize], rbx
+	inc [rsi].LsmTree.runAmount
+
+	mov rcx, [rsi].LsmTree.memtable
+	call clearTreeMap
+
+	mov rcx, [rsi].LsmTree.tombstones
+	call clearTreeMap
+
+	mov eax, success
+
+	jmp functionReturn
+
+closeRun:
+	mov r12d, eax
+	mov rcx, rbx
+	call closeLsmRun
+
+	mov eax, r12d
+
+functionReturn:
+	add rsp, shadowStorage + 2 * qwordSize
+	pop r13
+	pop r12
+	pop rdi
+	pop rsi
+	pop rbx
+	ret
+
+flushLsmTree endp
+
+
+	public compactLsmTree
+
+; Merges all runs into a single new run. Of every key only the newest record is kept
+; and keys whose newest record is a tombstone are dropped. The old run files are deleted.
+; A background thread can call it while it holds the lock of the lsm tree.
+;
+; @RCX qword[in,out] - Pointer to the lsm tree.
+;
+; @return A status value for success, errFileIo, errHeapAllocation or treeMapNullptr.
+;		  The runs stay as they are if the new run can't be written.
+compactLsmTree proc
+
+	push rbx
+	push rsi
+	push rdi
+	push r12
+	push r13
+	push r14
+	push r15
+	sub rsp, shadowStorage + 2 * qwordSize
+
+	; Check if the lsm tree is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+
+	mov eax, success
+	cmp [rsi].LsmTree.runAmount, 0
+	je functionReturn
+
+	; The new run can't hold more records than all runs together.
+	mov r12, 0
+	mov r14, [rsi].LsmTree.runAmount
+
+sumPairAmounts:
+	dec r14
+	lea rax, [rsi].LsmTree.runs
+	mov rax, [rax + r14 * qwordSize]
+	add r12, [rax].LsmRun.pairAmount
+
+	cmp r14, 0
+	jne sumPairAmounts
+
+	; Every run gets the position of its next record.
+	mov rcx, [rsi].LsmTree.runAmount
+	mov edx, qwordSize
+	call calloc
+
+	cmp rax, nullptr
+	je heapAllocationError
+
+	mov rdi, rax
+
+	mov rcx, r12
+	lea rdx, [rsp + lsmRunOut]
+	call createLsmRun
+
+	cmp eax, success
+	jne freePositions
+
+	mov rbx, [rsp + lsmRunOut]
+
+mergeRecords:
+	; Search the smallest key of the next records. The newest run wins a tie, because
+	; the runs are visited from the newest one and only a smaller key replaces the record.
+	mov r13, nullptr
+	mov r14, [rsi].LsmTree.runAmount
+
+searchSmallestRecord:
+	dec r14
+	call loadNextRunRecord
+
+	cmp rax, nullptr
+	je nextSearchedRun
+
+	cmp r13, nullptr
+	je takeRecord
+
+	mov rcx, [rsi].LsmTree.memtable
+	mov rdx, r13
+	mov r8, rax
+	mov r15, rax
+	call compareLsmKeys
+
+	cmp eax, 0
+	jge nextSearchedRun
+
+	mov rax, r15
+
+takeRecord:
+	mov r13, rax
+
+nextSearchedRun:
+	cmp r14, 0
+	jne searchSmallestRecord
+
+	cmp r13, nullptr
+	je finishRun
+
+	; Every run skips its record of the key.
+	mov r14, [rsi].LsmTree.runAmount
+
+skipEqualRecords:
+	dec r14
+	call loadNextRunRecord
+
+	cmp rax, nullptr
+	je nextSkippedRun
+
+	mov rcx, [rsi].LsmTree.memtable
+	mov rdx, r13
+	mov r8, rax
+	call compareLsmKeys
+
+	cmp eax, 0
+	jne nextSkippedRun
+
+	inc qword ptr [rdi + r14 * qwordSize]
+
+nextSkippedRun:
+	cmp r14, 0
+	jne skipEqualRecords
+
+	; The newest record of a deleted key is dropped.
+	mov rax, r13
+	add rax, [rsi].LsmTree.keySize
+	add rax, [rsi].LsmTree.valueSize
+	cmp byte ptr [rax], lsmTombstoneRecord
+	je mergeRecords
+
+	mov rcx, rbx
+	mov rdx, r13
+	mov r8b, lsmPairRecord
+	call appendLsmRecord
+
+	jmp mergeRecords
+
+finishRun:
+	; Without any pair left no run is needed.
+	cmp [rbx].LsmRun.pairAmount, 0
+	jne writeRun
+
+	mov rcx, rbx
+	call closeLsmRun
+
+	mov rbx, nullptr
+
+	jmp replaceRuns
+
+writeRun:
+	mov rcx, rbx
+	call finishLsmRun
+
+	cmp eax, success
+	jne closeRun
+
+replaceRuns:
+	; The old runs are deleted and the new one takes their place.
+	mov r14, [rsi].LsmTree.runAmount
+
+closeOldRuns:
+	dec r14
+	lea rax, [rsi].LsmTree.runs
+	mov rcx, [rax + r14 * qwordSize]
+	call closeLsmRun
+
+	cmp r14, 0
+	jne closeOldRuns
+
+	mov [rsi].LsmTree.runs, rbx
+	mov [rsi].LsmTree.runAmount, 0
+	cmp rbx, nullptr
+	je freeSuccess
+
+	mov [rsi].LsmTree.runAmount, 1
+
+freeSuccess:
+	mov eax, success
+
+	jmp freePositions
+
+closeRun:
+	mov r12d, eax
+	mov rcx, rbx
+	call closeLsmRun
+
+	mov eax, r12d
+
+freePositions:
+	mov r12d, eax
+	mov rcx, rdi
+	call free
+
+	mov eax, r12d
+
+	jmp functionReturn
+
+heapAllocationError:
+	mov eax, errHeapAllocation
+
+functionReturn:
+	add rsp, shadowStorage + 2 * qwordSize
+	pop r15
+	pop r14
+	pop r13
+	pop r12
+	pop rdi
+	pop rsi
+	pop rbx
+	ret
+
+compactLsmTree endp
+
+
+; Loads the next record of a run that is merged by compactLsmTree.
+;
+; @RSI qword[in] - Pointer to the lsm tree.
+; @RDI qword[in] - Pointer to the positions of the next records.
+; @R14 qword[in] - Index of the run.
+;
+; @return The record or a nullptr if the run has no record left.
+loadNextRunRecord proc
+
+	lea rax, [rsi].LsmTree.runs
+	mov rcx, [rax + r14 * qwordSize]
+	mov rax, [rdi + r14 * qwordSize]
+
+	cmp rax, [rcx].LsmRun.pairAmount
+	jae runFinished
+
+	imul rax, [rsi].LsmTree.recordStride
+	add rax, [rcx].LsmRun.pairs
+
+	ret
+
+runFinished:
+	mov rax, nullptr
+	ret
+
+loadNextRunRecord endp
+
+
+; Compares two keys with the compare function of the memtable.
+;
+; @RCX qword[in] - Pointer to the memtable.
+; @RDX qword[in] - Pointer to the first key.
+; @R8 qword[in] - Pointer to the second key.
+;
+; @return The sign of the second key minus the first key.
+compareLsmKeys proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov rax, rcx
+	mov rcx, rdx
+	mov rdx, r8
+	countTreeMapEvent rax, comparisons
+	callUserFunc [rax].TreeMap.compareKeyFunc
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+compareLsmKeys endp
+
+
+	public getLsmValue
+
+; Copies the value of the key out of the memtable or the newest run that holds the key.
+;
+; @RCX qword[in] - Pointer to the lsm tree.
+; @RDX qword[in] - Pointer to the key whose value is searched.
+; @R8 qword[out] - Pointer to the buffer that receives the value.
+;
+; @return A status value for success, doesNotContain, valueBufferNullptr or treeMapNullptr.
+getLsmValue proc
+
+	push rbx
+	push rsi
+	push rdi
+	push r12
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the lsm tree is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the value buffer is a nullptr.
+	mov eax, valueBufferNullptr
+	cmp r8, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+	mov rdi, rdx
+	mov r12, r8
+
+	; A tombstone hides the key in every run.
+	mov rcx, [rsi].LsmTree.tombstones
+	mov rdx, rdi
+	call containsKey
+
+	cmp eax, success
+	je missingKey
+
+	mov rcx, [rsi].LsmTree.memtable
+	mov rdx, rdi
+	mov r8, r12
+	call getValue
+
+	cmp eax, success
+	je functionReturn
+
+	; Search the runs from the newest to the oldest.
+	mov rbx, [rsi].LsmTree.runAmount
+
+searchRun:
+	cmp rbx, 0
+	je missingKey
+
+	dec rbx
+
+	; Most runs without the key are skipped by their Bloom filter.
+	lea rax, [rsi].LsmTree.runs
+	mov rcx, [rax + rbx * qwordSize]
+	mov rdx, rdi
+	mov r8b, false
+	call probeLsmBloomFilter
+
+	cmp al, false
+	je searchRun
+
+	lea rax, [rsi].LsmTree.runs
+	mov rcx, [rax + rbx * qwordSize]
+	mov rdx, rdi
+	mov r8b, true
+	call findLsmRecord
+
+	cmp rax, nullptr
+	je searchRun
+
+	mov [rsp + shadowStorage], rax
+	mov rcx, [rsi].LsmTree.memtable
+	mov rdx, rax
+	mov r8, rdi
+	call compareLsmKeys
+
+	cmp eax, 0
+	jne searchRun
+
+	; The newest record decides, a tombstone means the key was deleted.
+	mov rdx, [rsp + shadowStorage]
+	add rdx, [rsi].LsmTree.keySize
+	mov rax, rdx
+	add rax, [rsi].LsmTree.valueSize
+	cmp byte ptr [rax], lsmTombstoneRecord
+	je missingKey
+
+	mov rcx, r12
+	mov r8, [rsi].LsmTree.valueSize
+	call memcpy
+
+	mov eax, success
+
+	jmp functionReturn
+
+missingKey:
+	mov eax, doesNotContain
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop r12
+	pop rdi
+	pop rsi
+	pop rbx
+	ret
+
+getLsmValue endp
+
+
+	public ceilingLsmPair
+
+; Copies the pair with the smallest key that is bigger or equal to the given key.
+;
+; @RCX qword[in] - Pointer to the lsm tree.
+; @RDX qword[in] - Pointer to the key.
+; @R8 qword[out] - Pointer to the buffer that receives the pair.
+;
+; @return A status value for success, doesNotContain, pairBufferNullptr or treeMapNullptr.
+ceilingLsmPair proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov r9b, true
+	call searchLsmPair
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+ceilingLsmPair endp
+
+
+	public higherLsmPair
+
+; Copies the pair with the smallest key that is bigger than the given key.
+; Range scans call it with the key of the pair they copied last.
+;
+; @RCX qword[in] - Pointer to the lsm tree.
+; @RDX qword[in] - Pointer to the key.
+; @R8 qword[out] - Pointer to the buffer that receives the pair.
+;
+; @return A status value for success, doesNotContain, pairBufferNullptr or treeMapNullptr.
+higherLsmPair proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov r9b, false
+	call searchLsmPair
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+higherLsmPair endp
+
+
+; Merges the memtable, the tombstones and the runs to find the smallest key after the given one.
+; The newest record of the key decides. If it is a tombstone the search goes on after the key.
+;
+; @RCX qword[in] - Pointer to the lsm tree.
+; @RDX qword[in] - Pointer to the key.
+; @R8 qword[out] - Pointer to the buffer that receives the pair.
+; @R9B byte[in] - True if an equal key is accepted.
+;
+; @return A status value for success, doesNotContain, pairBufferNullptr or treeMapNullptr.
+searchLsmPair proc
+
+	push rbx
+	push rsi
+	push rdi
+	push r12
+	push r13
+	push r14
+	push r15
+	sub rsp, shadowStorage + 2 * qwordSize
+
+	; Check if the lsm tree is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the pair buffer is a nullptr.
+	mov eax, pairBufferNullptr
+	cmp r8, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+	mov rdi, rdx
+	mov r12, r8
+	movzx r13d, r9b
+
+searchNextKey:
+	; The memtable and the tombstones are the newest records.
+	; Spilled treenodes of the memtable around the key are faulted back in.
+	mov rcx, [rsi].LsmTree.memtable
+	mov rdx, rdi
+	call faultSpilledPath
+
+	cmp eax, success
+	jne functionReturn
+
+	mov r8b, r13b
+	call findHigherTreeNode
+
+	mov rbx, rax
+	mov r14d, lsmPairRecord
+
+	mov rcx, [rsi].LsmTree.tombstones
+	mov rdx, rdi
+	mov r8b, r13b
+	call findHigherTreeNode
+
+	cmp rax, nullptr
+	je searchRuns
+
+	mov r14d, lsmTombstoneRecord
+	cmp rbx, nullptr
+	je takeTombstone
+
+	mov r15, rax
+	mov rcx, [rsi].LsmTree.memtable
+	mov rdx, rbx
+	mov r8, rax
+	call compareLsmKeys
+
+	mov r14d, lsmPairRecord
+	cmp eax, 0
+	jge searchRuns
+
+	mov r14d, lsmTombstoneRecord
+	mov rax, r15
+
+takeTombstone:
+	mov rbx, rax
+
+searchRuns:
+	; An older run only wins with a smaller key.
+	mov r15, [rsi].LsmTree.runAmount
+
+searchRun:
+	cmp r15, 0
+	je checkRecord
+
+	dec r15
+	lea rax, [rsi].LsmTree.runs
+	mov rcx, [rax + r15 * qwordSize]
+	mov rdx, rdi
+	mov r8b, r13b
+	call findLsmRecord
+
+	cmp rax, nullptr
+	je searchRun
+
+	cmp rbx, nullptr
+	je takeRecord
+
+	mov [rsp + shadowStorage], rax
+	mov rcx, [rsi].LsmTree.memtable
+	mov rdx, rbx
+	mov r8, rax
+	call compareLsmKeys
+
+	cmp eax, 0
+	jge searchRun
+
+	mov rax, [rsp + shadowStorage]
+
+takeRecord:
+	mov rbx, rax
+	mov rcx, rbx
+	add rcx, [rsi].LsmTree.keySize
+	add rcx, [rsi].LsmTree.valueSize
+	movzx r14d, byte ptr [rcx]
+
+	jmp searchRun
+
+checkRecord:
+	mov eax, doesNotContain
+	cmp rbx, nullptr
+	je functionReturn
+
+	; A deleted key is skipped.
+	cmp r14d, lsmTombstoneRecord
+	jne copyPair
+
+	mov rdi, rbx
+	mov r13d, false
+
+	jmp searchNextKey
+
+copyPair:
+	mov rcx, r12
+	mov rdx, rbx
+	mov r8, [rsi].LsmTree.keySize
+	add r8, [rsi].LsmTree.valueSize
+	call memcpy
+
+	mov eax, success
+
+functionReturn:
+	add rsp, shadowStorage + 2 * qwordSize
+	pop r15
+	pop r14
+	pop r13
+	pop r12
+	pop rdi
+	pop rsi
+	pop rbx
+	ret
+
+searchLsmPair endp
+
+
+; Searches the first record of the run whose key is bigger than the given one, or equal to it
+; if the search is inclusive. The block index is searched first, so only a single block of records is read.
+;
+; @RCX qword[in] - Pointer to the run.
+; @RDX qword[in] - Pointer to the key.
+; @R8B byte[in] - True if an equal key is accepted.
+; @RSI qword[in] - Pointer to the lsm tree.
+;
+; @return The record or a nullptr.
+findLsmRecord proc
+
+	push rbx
+	push rdi
+	push r12
+	push r13
+	push r14
+	push r15
+	sub rsp, shadowStorage + qwordSize
+
+	mov rbx, rcx
+	mov rdi, rdx
+	movzx r12d, r8b
+
+	; Search the first block whose first key is a candidate.
+	mov r13, 0
+	mov r14, [rbx].LsmRun.blockAmount
+
+searchBlock:
+	cmp r13, r14
+	jae searchRecords
+
+	lea r15, [r13 + r14]
+	shr r15, 1
+
+	mov rcx, r15
+	imul rcx, [rsi].LsmTree.keyStride
+	add rcx, [rbx].LsmRun.index
+	mov rdx, rdi
+	mov rax, [rsi].LsmTree.memtable
+	countTreeMapEvent rax, comparisons
+	callUserFunc [rax].TreeMap.compareKeyFunc
+
+	; The compare function returns the sign of the key minus the block key,
+	; which has to be below one for an inclusive and below zero for any other search.
+	cmp eax, r12d
+	jl searchLowerBlocks
+
+	lea r13, [r15 + 1]
+
+	jmp searchBlock
+
+searchLowerBlocks:
+	mov r14, r15
+
+	jmp searchBlock
+
+searchRecords:
+	; The candidate is inside the block before it or it's the first record of the block.
+	mov rax, r13
+	cmp rax, 0
+	je loadRecord
+
+	dec rax
+	imul rax, [rbx].LsmRun.blockPairs
+	mov r13, rax
+	add rax, [rbx].LsmRun.blockPairs
+	cmp rax, [rbx].LsmRun.pairAmount
+	jbe setBlockEnd
+
+	mov rax, [rbx].LsmRun.pairAmount
+
+setBlockEnd:
+	mov r14, rax
+
+searchRecord:
+	cmp r13, r14
+	jae loadRecordOfBlock
+
+	lea r15, [r13 + r14]
+	shr r15, 1
+
+	mov rcx, r15
+	imul rcx, [rsi].LsmTree.recordStride
+	add rcx, [rbx].LsmRun.pairs
+	mov rdx, rdi
+	mov rax, [rsi].LsmTree.memtable
+	countTreeMapEvent rax, comparisons
+	callUserFunc [rax].TreeMap.compareKeyFunc
+
+	cmp eax, r12d
+	jl searchLowerRecords
+
+	lea r13, [r15 + 1]
+
+	jmp searchRecord
+
+searchLowerRecords:
+	mov r14, r15
+
+	jmp searchRecord
+
+loadRecordOfBlock:
+	mov rax, r13
+
+loadRecord:
+	cmp rax, [rbx].LsmRun.pairAmount
+	jae missingRecord
+
+	imul rax, [rsi].LsmTree.recordStride
+	add rax, [rbx].LsmRun.pairs
+
+	jmp functionReturn
+
+missingRecord:
+	mov rax, nullptr
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop r15
+	pop r14
+	pop r13
+	pop r12
+	pop rdi
+	pop rbx
+	ret
+
+findLsmRecord endp
+
+
+; Hashes the key and sets or tests its bits inside the Bloom filter of the run.
+; The bits are picked by double hashing the FNV-1a hash of the key.
+;
+; @RCX qword[in,out] - Pointer to the run.
+; @RDX qword[in] - Pointer to the key.
+; @R8B byte[in] - True if the bits are set, otherwise they are tested.
+; @RSI qword[in] - Pointer to the lsm tree.
+;
+; @return True if all bits of the key are set, false if the run can't hold the key.
+probeLsmBloomFilter proc
+
+	push rbx
+	push rdi
+	push r12
+	push r13
+	push r14
+	sub rsp, shadowStorage
+
+	mov rbx, rcx
+	movzx r14d, r8b
+
+	mov rcx, rdx
+	mov rdx, [rsi].LsmTree.keySize
+	mov r8, fnvOffsetBasis
+	call hashSnapshotBytes
+
+	; The second hash is odd, so it never repeats the first bit.
+	mov r12, rax
+	mov r13, rax
+	ror r13, 32
+	or r13, 1
+	mov edi, lsmBloomHashes
+	mov rcx, [rbx].LsmRun.bloom
+
+probeBit:
+	mov rax, r12
+	xor edx, edx
+	div [rbx].LsmRun.bloomBits
+
+	cmp r14d, false
+	je testBit
+
+	bts qword ptr [rcx], rdx
+
+	jmp nextBit
+
+testBit:
+	bt qword ptr [rcx], rdx
+	jnc missingBit
+
+nextBit:
+	add r12, r13
+	dec edi
+	jnz probeBit
+
+	mov al, true
+
+	jmp functionReturn
+
+missingBit:
+	mov al, false
+
+functionReturn:
+	add rsp, shadowStorage
+	pop r14
+	pop r13
+	pop r12
+	pop rdi
+	pop rbx
+	ret
+
+probeLsmBloomFilter endp
+
+
+; Creates a new run file that is big enough for the given amount of records and maps it.
+; The file is named after the path prefix and the next run counter.
+;
+; @RCX qword[in] - Maximum amount of records.
+; @RDX qword[out] - Pointer to the memory that receives the run.
+; @RSI qword[in,out] - Pointer to the lsm tree.
+;
+; @return A status value for success, errFileIo or errHeapAllocation.
+createLsmRun proc
+
+	push rbx
+	push rdi
+	push r12
+	push r13
+	push r14
+	push r15
+	sub rsp, shadowStorage + 3 * qwordSize
+
+	mov r12, rcx
+	mov r13, rdx
+
+	; The name is the prefix, the counter as hexadecimal digits and the suffix.
+	mov rcx, [rsi].LsmTree.pathPrefix
+	call strlen
+
+	mov r14, rax
+	lea rcx, [rax + sizeof LsmRun + lsmRunIdDigits + lsmRunSuffixSize]
+	call malloc
+
+	cmp rax, nullptr
+	je heapAllocationError
+
+	mov rbx, rax
+	mov [rbx].LsmRun.base, nullptr
+	mov [rbx].LsmRun.fileHandle, invalidHandleValue
+	mov [rbx].LsmRun.mappingHandle, nullptr
+	mov [rbx].LsmRun.pairAmount, 0
+	mov [rbx].LsmRun.blockAmount, 0
+	lea rdi, [rbx + sizeof LsmRun]
+	mov [rbx].LsmRun.name, rdi
+
+	mov rcx, rdi
+	mov rdx, [rsi].LsmTree.pathPrefix
+	mov r8, r14
+	call memcpy
+
+	add rdi, r14
+	mov rdx, [rsi].LsmTree.nextRunId
+	inc [rsi].LsmTree.nextRunId
+	mov ecx, lsmRunIdDigits
+
+writeDigit:
+	; The digits are written from the highest nibble.
+	rol rdx, 4
+	mov eax, edx
+	and eax, 0Fh
+	add eax, '0'
+	cmp eax, '9'
+	jbe storeDigit
+
+	add eax, 'a' - '0' - 10
+
+storeDigit:
+	mov [rdi], al
+	inc rdi
+	dec ecx
+	jnz writeDigit
+
+	mov dword ptr [rdi], lsmRunSuffix
+	mov byte ptr [rdi + sizeof dword], 0
+
+	; The records start after the header, the block index and the Bloom filter follow them.
+	mov eax, lsmBlockSize
+	xor edx, edx
+	div [rsi].LsmTree.recordStride
+
+	cmp rax, 0
+	jne setBlockPairs
+
+	mov eax, 1
+
+setBlockPairs:
+	mov [rbx].LsmRun.blockPairs, rax
+
+	mov r15, r12
+	imul r15, [rsi].LsmTree.recordStride
+	add r15, sizeof LsmRunHeader
+	mov [rbx].LsmRun.index, r15
+
+	lea rax, [r12 + rax - 1]
+	xor edx, edx
+	div [rbx].LsmRun.blockPairs
+	imul rax, [rsi].LsmTree.keyStride
+	add r15, rax
+	mov [rbx].LsmRun.bloom, r15
+
+	; Every key gets ten bits of the filter, which keeps the false positives near one percent.
+	mov rax, r12
+	imul rax, lsmBloomBitsPerKey
+	add rax, 63
+	and rax, -64
+	jnz setBloomBits
+
+	mov eax, 64
+
+setBloomBits:
+	mov [rbx].LsmRun.bloomBits, rax
+	shr rax, 3
+	add r15, rax
+
+	; Create the file and map it with its whole size.
+	mov rcx, [rbx].LsmRun.name
+	mov edx, genericRead
+	or edx, genericWrite
+	mov r8d, 0
+	mov r9, nullptr
+	mov qword ptr [rsp + shadowStorage], createAlways
+	mov qword ptr [rsp + shadowStorage + qwordSize], fileAttributeNormal
+	mov qword ptr [rsp + shadowStorage + 2 * qwordSize], nullptr
+	call CreateFileA
+
+	cmp rax, invalidHandleValue
+	je fileError
+
+	mov [rbx].LsmRun.fileHandle, rax
+
+	mov rcx, rax
+	mov rdx, nullptr
+	mov r8d, pageReadWrite
+	mov r9, r15
+	shr r9, 32
+	mov qword ptr [rsp + shadowStorage], r15
+	mov qword ptr [rsp + shadowStorage + qwordSize], nullptr
+	call CreateFileMappingA
+
+	cmp rax, nullptr
+	je fileError
+
+	mov [rbx].LsmRun.mappingHandle, rax
+
+	mov rcx, rax
+	mov edx, fileMapWrite
+	mov r8d, 0
+	mov r9d, 0
+	mov qword ptr [rsp + shadowStorage], 0
+	call MapViewOfFile
+
+	cmp rax, nullptr
+	je fileError
+
+	; The offsets become addresses inside the view, which starts out zeroed.
+	mov [rbx].LsmRun.base, rax
+	lea rcx, [rax + sizeof LsmRunHeader]
+	mov [rbx].LsmRun.pairs, rcx
+	add [rbx].LsmRun.index, rax
+	add [rbx].LsmRun.bloom, rax
+
+	mov [r13], rbx
+	mov eax, success
+
+	jmp functionReturn
+
+fileError:
+	mov rcx, rbx
+	call closeLsmRun
+
+	mov eax, errFileIo
+
+	jmp functionReturn
+
+heapAllocationError:
+	mov eax, errHeapAllocation
+
+functionReturn:
+	add rsp, shadowStorage + 3 * qwordSize
+	pop r15
+	pop r14
+	pop r13
+	pop r12
+	pop rdi
+	pop rbx
+	ret
+
+createLsmRun endp
+
+
+; Appends a record to the run. The first key of every block is added to the block index.
+;
+; @RCX qword[in,out] - Pointer to the run.
+; @RDX qword[in] - Pointer to the pair, a tombstone only uses its key.
+; @R8B byte[in] - Kind of the record.
+; @RSI qword[in] - Pointer to the lsm tree.
+appendLsmRecord proc
+
+	push rbx
+	push rdi
+	push r12
+	push r13
+	sub rsp, shadowStorage + qwordSize
+
+	mov rbx, rcx
+	mov r12, rdx
+	movzx r13d, r8b
+
+	mov rdi, [rbx].LsmRun.pairAmount
+	imul rdi, [rsi].LsmTree.recordStride
+	add rdi, [rbx].LsmRun.pairs
+
+	; The value of a tombstone stays zeroed.
+	mov rcx, rdi
+	mov rdx, r12
+	mov r8, [rsi].LsmTree.keySize
+	cmp r13d, lsmTombstoneRecord
+	je copyRecord
+
+	add r8, [rsi].LsmTree.valueSize
+
+copyRecord:
+	call memcpy
+
+	mov rax, rdi
+	add rax, [rsi].LsmTree.keySize
+	add rax, [rsi].LsmTree.valueSize
+	mov [rax], r13b
+
+	; A new block starts every block pairs records.
+	mov rax, [rbx].LsmRun.pairAmount
+	xor edx, edx
+	div [rbx].LsmRun.blockPairs
+
+	cmp rdx, 0
+	jne setBloomBits
+
+	mov rcx, [rbx].LsmRun.blockAmount
+	imul rcx, [rsi].LsmTree.keyStride
+	add rcx, [rbx].LsmRun.index
+	mov rdx, r12
+	mov r8, [rsi].LsmTree.keySize
+	call memcpy
+
+	inc [rbx].LsmRun.blockAmount
+
+setBloomBits:
+	mov rcx, rbx
+	mov rdx, r12
+	mov r8b, true
+	call probeLsmBloomFilter
+
+	inc [rbx].LsmRun.pairAmount
+
+	add rsp, shadowStorage + qwordSize
+	pop r13
+	pop r12
+	pop rdi
+	pop rbx
+	ret
+
+appendLsmRecord endp
+
+
+; Writes the header of the run and flushes the file to the storage.
+;
+; @RCX qword[in,out] - Pointer to the run.
+; @RSI qword[in] - Pointer to the lsm tree.
+;
+; @return A status value for success or errFileIo.
+finishLsmRun proc
+
+	push rbx
+	sub rsp, shadowStorage
+
+	mov rbx, rcx
+	mov rcx, [rbx].LsmRun.base
+
+	mov rax, lsmMagic
+	mov [rcx].LsmRunHeader.magic, rax
+	mov [rcx].LsmRunHeader.version, lsmVersion
+	mov rax, [rsi].LsmTree.keySize
+	mov [rcx].LsmRunHeader.keySize, rax
+	mov rax, [rsi].LsmTree.valueSize
+	mov [rcx].LsmRunHeader.valueSize, rax
+	mov rax, [rbx].LsmRun.pairAmount
+	mov [rcx].LsmRunHeader.pairAmount, rax
+	mov rax, [rbx].LsmRun.blockPairs
+	mov [rcx].LsmRunHeader.blockPairs, rax
+	mov rax, [rbx].LsmRun.blockAmount
+	mov [rcx].LsmRunHeader.blockAmount, rax
+	mov rax, [rbx].LsmRun.bloomBits
+	mov [rcx].LsmRunHeader.bloomBits, rax
+	mov rax, [rbx].LsmRun.index
+	sub rax, rcx
+	mov [rcx].LsmRunHeader.indexOffset, rax
+	mov rax, [rbx].LsmRun.bloom
+	sub rax, rcx
+	mov [rcx].LsmRunHeader.bloomOffset, rax
+
+	; The run has to be stored before the memtable forgets its pairs.
+	mov edx, 0
+	call FlushViewOfFile
+
+	cmp eax, 0
+	je fileError
+
+	mov rcx, [rbx].LsmRun.fileHandle
+	call FlushFileBuffers
+
+	cmp eax, 0
+	je fileError
+
+	mov eax, success
+
+	jmp functionReturn
+
+fileError:
+	mov eax, errFileIo
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rbx
+	ret
+
+finishLsmRun endp
+
+
+; Unmaps the run, closes and deletes its file and frees it.
+;
+; @RCX qword[in,out] - Pointer to the run.
+closeLsmRun proc
+
+	push rbx
+	sub rsp, shadowStorage
+
+	mov rbx, rcx
+
+	mov rcx, [rbx].LsmRun.base
+	cmp rcx, nullptr
+	je closeMapping
+
+	call UnmapViewOfFile
+
+closeMapping:
+	mov rcx, [rbx].LsmRun.mappingHandle
+	cmp rcx, nullptr
+	je closeFile
+
+	call CloseHandle
+
+closeFile:
+	mov rcx, [rbx].LsmRun.fileHandle
+	cmp rcx, invalidHandleValue
+	je freeRun
+
+	call CloseHandle
+
+	mov rcx, [rbx].LsmRun.name
+	call DeleteFileA
+
+freeRun:
+	mov rcx, rbx
+	call free
+
+	add rsp, shadowStorage
+	pop rbx
+	ret
+
+closeLsmRun endp
+
+end
@@ -0,0 +1,262 @@
+/*
+* @file tree_map_lsm_test.h
+*
+* Defines unit tests for the log structured merge trees of the tree map
+* implementation.
+*
+* @author Collector
+* @data 03/09/2023
+*/
+
+
+#include "utils.h"
+
+namespace {
+	/*
+	* Path prefix of the run files of the tests.
+	*/
+	const char* const runPrefix{ "tree_map_lsm_test_" };
+
+	/*
+	* Asserts that the lsm tree holds the value of the key or doesn't contain it.
+	*
+	* @param[in] lsm - Lsm tree that is checked.
+	* @param[in] key - Key whose value is checked.
+	* @param[in] contains - Indicator if the key is expected to exist.
+	* @param[in] expected - Expected value of the key.
+	*/
+	void assertLsmValue(const LsmTree* lsm, size_t key, bool contains, size_t expected) {
+		size_t value{ 0 };
+		Status s{ getLsmValue(lsm, &key, &value) };
+
+		if (contains) {
+			ASSERT_EQ(Status::SUCCESS, s);
+			ASSERT_EQ(expected, value);
+		}
+		else {
+			ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+		}
+	}
+}
+
+TEST(TreeMap, createLsmTreeShouldFailForInvalidParameters) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(0, 1) };
+	TreeMap* multiMap{ createTestMultiMap() };
+	LsmTree* lsm{ createLsmTree(nullptr, runPrefix, 4, &s) };
+
+	ASSERT_EQ(nullptr, lsm);
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, s);
+
+	lsm = createLsmTree(tm, nullptr, 4, &s);
+
+	ASSERT_EQ(nullptr, lsm);
+	ASSERT_EQ(Status::FILE_NULLPTR, s);
+
+	lsm = createLsmTree(tm, runPrefix, 0, &s);
+
+	ASSERT_EQ(nullptr, lsm);
+	ASSERT_EQ(Status::MEMTABLE_LIMIT_ZERO, s);
+
+	lsm = createLsmTree(multiMap, runPrefix, 4, &s);
+
+	ASSERT_EQ(nullptr, lsm);
+	ASSERT_EQ(Status::MEMTABLE_MULTI_MAP, s);
+
+	deleteTreeMap(multiMap);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, lsmTreeShouldFlushFullMemtable) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(0, 1) };
+	LsmTree* lsm{ createLsmTree(tm, runPrefix, 100, &s) };
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	for (size_t key{ 0 }; key < 1050; key++) {
+		size_t pair[2]{ key, key * key };
+
+		s = putLsmPair(lsm, pair);
+
+		ASSERT_EQ(Status::SUCCESS, s);
+	}
+
+	ASSERT_EQ(10, lsm->runAmount);
+	ASSERT_EQ(50, tm->nodeAmount);
+
+	for (size_t key{ 0 }; key < 1050; key++) {
+		assertLsmValue(lsm, key, true, key * key);
+	}
+
+	assertLsmValue(lsm, 1050, false, 0);
+
+	closeLsmTree(lsm);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, lsmTreeShouldPreferNewerValuesAndTombstones) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(0, 1) };
+	LsmTree* lsm{ createLsmTree(tm, runPrefix, 1000, &s) };
+
+	for (size_t key{ 0 }; key < 500; key++) {
+		size_t pair[2]{ key, key };
+
+		putLsmPair(lsm, pair);
+	}
+
+	flushLsmTree(lsm);
+
+	// The newer run replaces every third value and deletes every fifth key.
+	for (size_t key{ 0 }; key < 500; key += 3) {
+		size_t pair[2]{ key, key + 1 };
+
+		putLsmPair(lsm, pair);
+	}
+
+	for (size_t key{ 0 }; key < 500; key += 5) {
+		deleteLsmPair(lsm, &key);
+	}
+
+	flushLsmTree(lsm);
+
+	// The memtable brings some deleted keys back.
+	for (size_t key{ 0 }; key < 500; key += 10) {
+		size_t pair[2]{ key, 7 };
+
+		putLsmPair(lsm, pair);
+	}
+
+	ASSERT_EQ(2, lsm->runAmount);
+
+	for (size_t key{ 0 }; key < 500; key++) {
+		if (key % 10 == 0) {
+			assertLsmValue(lsm, key, true, 7);
+		}
+		else if (key % 5 == 0) {
+			assertLsmValue(lsm, key, false, 0);
+		}
+		else {
+			assertLsmValue(lsm, key, true, key % 3 == 0 ? key + 1 : key);
+		}
+	}
+
+	closeLsmTree(lsm);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, lsmRangeScanShouldMergeRunsInKeyOrder) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(0, 1) };
+	LsmTree* lsm{ createLsmTree(tm, runPrefix, 64, &s) };
+
+	// Every run gets keys of another residue, so the runs interleave.
+	for (size_t residue{ 0 }; residue < 4; residue++) {
+		for (size_t key{ residue }; key < 1000; key += 4) {
+			size_t pair[2]{ key, key * 2 };
+
+			putLsmPair(lsm, pair);
+		}
+
+		flushLsmTree(lsm);
+	}
+
+	for (size_t key{ 100 }; key < 200; key++) {
+		deleteLsmPair(lsm, &key);
+	}
+
+	size_t start{ 50 }, pair[2]{}, expected{ 50 }, amount{ 0 };
+
+	s = ceilingLsmPair(lsm, &start, pair);
+
+	while (s == Status::SUCCESS) {
+		ASSERT_EQ(expected, pair[0]);
+		ASSERT_EQ(expected * 2, pair[1]);
+
+		amount++;
+		expected = expected == 99 ? 200 : expected + 1;
+
+		size_t key{ pair[0] };
+
+		s = higherLsmPair(lsm, &key, pair);
+	}
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+	ASSERT_EQ(850, amount);
+
+	closeLsmTree(lsm);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, compactLsmTreeShouldDropReplacedPairsAndTombstones) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(0, 1) };
+	LsmTree* lsm{ createLsmTree(tm, runPrefix, 1000, &s) };
+
+	for (size_t round{ 0 }; round < 3; round++) {
+		for (size_t key{ 0 }; key < 300; key++) {
+			size_t pair[2]{ key, round };
+
+			putLsmPair(lsm, pair);
+		}
+
+		flushLsmTree(lsm);
+	}
+
+	for (size_t key{ 0 }; key < 300; key += 2) {
+		deleteLsmPair(lsm, &key);
+	}
+
+	flushLsmTree(lsm);
+
+	ASSERT_EQ(4, lsm->runAmount);
+
+	s = compactLsmTree(lsm);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(1, lsm->runAmount);
+
+	for (size_t key{ 0 }; key < 300; key++) {
+		assertLsmValue(lsm, key, key % 2 == 1, 2);
+	}
+
+	// Deleting every pair leaves no run behind.
+	for (size_t key{ 1 }; key < 300; key += 2) {
+		deleteLsmPair(lsm, &key);
+	}
+
+	flushLsmTree(lsm);
+	compactLsmTree(lsm);
+
+	ASSERT_EQ(0, lsm->runAmount);
+
+	size_t key{ 0 }, pair[2]{};
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, ceilingLsmPair(lsm, &key, pair));
+
+	closeLsmTree(lsm);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, lsmTreeShouldCompactAtRunLimit) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(0, 1) };
+	LsmTree* lsm{ createLsmTree(tm, runPrefix, 8, &s) };
+
+	for (size_t key{ 0 }; key < 8 * 17; key++) {
+		size_t pair[2]{ key % 40, key };
+
+		putLsmPair(lsm, pair);
+	}
+
+	// The seventeenth flush compacts the 16 runs into one first.
+	ASSERT_EQ(2, lsm->runAmount);
+
+	for (size_t key{ 0 }; key < 40; key++) {
+		assertLsmValue(lsm, key, true, key + (key < 16 ? 120 : 80));
+	}
+
+	closeLsmTree(lsm);
+	deleteTreeMap(tm);
+}
@@ -0,0 +1,866 @@
+; @file tree_map_mapped.asm
+;
+; Defines the memory mapped treemaps. A mapped treemap is an image file of a treemap whose
+; treenodes link their children through offsets from the start of the image instead of pointers.
+; The file is mapped into the address space and searched in place, so opening it takes the
+; same time for every size and no pair is deserialized.
+;
+; The image starts with a MappedHeader that takes the first cache line, so the offset zero
+; marks a missing child. The treenodes follow it in key order with a fixed stride.
+;
+; @author Collector
+; @date 03/09/2023
+
+	include tree_map.inc
+
+	.code
+
+
+	public saveMappedTreeMap
+
+; Writes the image of the treemap into the file. The pairs are copied byte by byte,
+; so they must not hold pointers.
+;
+; @RCX qword[in,out] - Pointer to the treemap that is saved.
+; @RDX qword[in,out] - FILE pointer the image is written to.
+;
+; @return A status value for success, fileNullptr, inlineSizeMismatch for inline pairs,
+;		  valueDictionaryExists, errFileIo, errHeapAllocation or treeMapNullptr.
+saveMappedTreeMap proc
+
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	push r13
+	sub rsp, shadowStorage
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the file is a nullptr.
+	mov eax, fileNullptr
+	cmp rdx, nullptr
+	je functionReturn
+
+	; The pairs of inline treenodes and interned values point outside of the treenodes.
+	mov eax, inlineSizeMismatch
+	test [rcx].TreeMap.flags, inlinePairsFlag
+	jnz functionReturn
+
+	mov eax, valueDictionaryExists
+	cmp [rcx].TreeMap.valueDictionary, nullptr
+	jne functionReturn
+
+	; Spilled treenodes are faulted back in before the tree is walked.
+	call restoreSpilledTreeMap
+
+	cmp eax, success
+	jne functionReturn
+
+	; Save the treemap and the file.
+	mov rsi, rcx
+	mov rdi, rdx
+
+	; Every treenode of the image starts on a quadword boundary.
+	mov rbx, [rsi].TreeMap.keySize
+	add rbx, [rsi].TreeMap.valueSize
+	add rbx, sizeof MappedTreeNode + qwordSize - 1
+	and rbx, -qwordSize
+
+	; The image is zeroed, so the padding of the treenodes is written deterministically.
+	mov rcx, rbx
+	imul rcx, [rsi].TreeMap.nodeAmount
+	add rcx, sizeof MappedHeader
+	mov edx, 1
+	call calloc
+
+	cmp rax, nullptr
+	je heapAllocationError
+
+	mov r12, rax
+	mov rax, mappedMagic
+	mov [r12].MappedHeader.magic, rax
+	mov [r12].MappedHeader.version, mappedVersion
+	mov rax, [rsi].TreeMap.keySize
+	mov [r12].MappedHeader.keySize, rax
+	mov rax, [rsi].TreeMap.valueSize
+	mov [r12].MappedHeader.valueSize, rax
+	mov rax, [rsi].TreeMap.nodeAmount
+	mov [r12].MappedHeader.nodeAmount, rax
+	mov [r12].MappedHeader.nodeStride, rbx
+
+	; Copy the treenodes in key order behind the header.
+	mov r13, rbx
+	mov rbx, sizeof MappedHeader
+	mov rcx, [rsi].TreeMap.root
+	call copyMappedTreeNodes
+
+	mov [r12].MappedHeader.root, rax
+
+	; The checksum of the header covers every field before it.
+	mov rcx, r12
+	mov edx, sizeof MappedHeader - qwordSize
+	mov r8, fnvOffsetBasis
+	call hashSnapshotBytes
+
+	mov [r12].MappedHeader.checksum, rax
+
+	; The offset behind the last treenode is the size of the image.
+	mov rcx, r12
+	mov edx, 1
+	mov r8, rbx
+	mov r9, rdi
+	call fwrite
+
+	mov edi, errFileIo
+	cmp rax, rbx
+	jne freeImage
+
+	mov edi, success
+
+freeImage:
+	mov rcx, r12
+	call free
+
+	mov eax, edi
+
+	jmp functionReturn
+
+heapAllocationError:
+	mov eax, errHeapAllocation
+
+functionReturn:
+	add rsp, shadowStorage
+	pop r13
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+saveMappedTreeMap endp
+
+
+; Copies the subtree in key order into the image and links the
+; copied treenodes through their offsets.
+;
+; @RCX qword[in] - Pointer to the current treenode.
+; @RSI qword[in] - Pointer to the treemap that is saved.
+; @RBX qword[in,out] - Offset of the next treenode inside the image.
+; @R12 qword[in,out] - Pointer to the image.
+; @R13 qword[in] - Distance between two treenodes of the image.
+;
+; @return The offset of the copied subtree or zero for an empty one.
+copyMappedTreeNodes proc
+
+	push rbp
+	mov rbp, rsp
+	sub rsp, shadowStorage + 2 * qwordSize
+
+	mov eax, 0
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Save the current treenode.
+	mov [rbp + currentTreeNode], rcx
+
+	; The left subtree comes first.
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rcx, [rcx].TreeNode.left
+	call copyMappedTreeNodes
+
+	; Take the next offset for the treenode.
+	mov [rbp + leftOffset], rax
+	mov [rbp + treeNodeOffset], rbx
+	add rbx, r13
+
+	mov rcx, r12
+	add rcx, [rbp + treeNodeOffset]
+	mov rdx, [rbp + currentTreeNode]
+	mov r8, [rsi].TreeMap.keySize
+	add r8, [rsi].TreeMap.valueSize
+	call memcpy
+
+	mov rcx, [rbp + currentTreeNode]
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rcx, [rcx].TreeNode.right
+	call copyMappedTreeNodes
+
+	; Link the children of the copy.
+	mov rcx, r12
+	add rcx, [rbp + treeNodeOffset]
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rdx, [rbp + leftOffset]
+	mov [rcx].MappedTreeNode.left, rdx
+	mov [rcx].MappedTreeNode.right, rax
+
+	mov rax, [rbp + treeNodeOffset]
+
+functionReturn:
+	mov rsp, rbp
+	pop rbp
+	ret
+
+copyMappedTreeNodes endp
+
+
+	public openMappedTreeMap
+
+; Maps the image file of a treemap into the address space. Only the header is checked,
+; so the time to open the image doesn't depend on the amount of pairs.
+;
+; @RCX qword[in] - Path of the image file.
+; @RDX qword[in] - Pointer to the function that compares treenodes by their keys.
+; @R8 byte[in] - Indicator if the image is mapped writable for replaceMappedValue.
+; @R9 qword[out] - Pointer to a status code which is set to success if the image is mapped.
+;
+; @return The mapped treemap or a nullptr. The status is set to fileNullptr, keyCompFuncNullptr,
+;		  errFileIo if the file can't be opened or mapped, snapshotInvalid if it isn't an image
+;		  of a treemap or errHeapAllocation. Without a status pointer the function fails silently.
+openMappedTreeMap proc
+
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	push r13
+	sub rsp, shadowStorage + 4 * qwordSize
+
+	mov rax, nullptr
+
+	; Check if a status pointer was given, otherwise fail silently.
+	cmp r9, nullptr
+	je functionReturn
+
+	mov rdi, r9
+
+	; Check if the path is a nullptr.
+	mov dword ptr [rdi], fileNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the key comparing function is a nullptr.
+	mov dword ptr [rdi], keyCompFuncNullptr
+	cmp rdx, nullptr
+	je functionReturn
+
+	; Save the path, the comparison function and the writable flag.
+	mov rbx, rcx
+	mov r12, rdx
+	movzx r13d, r8b
+
+	mov rcx, sizeof MappedTreeMap
+	call malloc
+
+	mov dword ptr [rdi], errHeapAllocation
+	cmp rax, nullptr
+	je functionReturn
+
+	; Nothing is opened yet.
+	mov rsi, rax
+	mov [rsi].MappedTreeMap.base, nullptr
+	mov [rsi].MappedTreeMap.compareKeyFunc, r12
+	mov [rsi].MappedTreeMap.fileHandle, invalidHandleValue
+	mov [rsi].MappedTreeMap.mappingHandle, nullptr
+	mov [rsi].MappedTreeMap.writable, r13b
+
+	; Open the existing file for reading and optionally writing.
+	mov edx, genericRead
+	cmp r13d, false
+	je openFile
+
+	or edx, genericWrite
+
+openFile:
+	mov rcx, rbx
+	mov r8d, fileShareRead
+	mov r9, nullptr
+	mov qword ptr [rsp + shadowStorage], openExisting
+	mov qword ptr [rsp + shadowStorage + qwordSize], fileAttributeNormal
+	mov qword ptr [rsp + shadowStorage + 2 * qwordSize], nullptr
+	call CreateFileA
+
+	mov r12d, errFileIo
+	cmp rax, invalidHandleValue
+	je releaseMappedTreeMap
+
+	mov [rsi].MappedTreeMap.fileHandle, rax
+
+	; The image has to hold at least the header.
+	mov rcx, rax
+	lea rdx, [rsp + shadowStorage + 3 * qwordSize]
+	call GetFileSizeEx
+
+	cmp eax, false
+	je releaseMappedTreeMap
+
+	mov r12d, snapshotInvalid
+	cmp qword ptr [rsp + shadowStorage + 3 * qwordSize], sizeof MappedHeader
+	jb releaseMappedTreeMap
+
+	; Map the whole file.
+	mov r8d, pageReadOnly
+	cmp r13d, false
+	je createMapping
+
+	mov r8d, pageReadWrite
+
+createMapping:
+	mov rcx, [rsi].MappedTreeMap.fileHandle
+	mov rdx, nullptr
+	mov r9d, 0
+	mov qword ptr [rsp + shadowStorage], 0
+	mov qword ptr [rsp + shadowStorage + qwordSize], nullptr
+	call CreateFileMappingA
+
+	mov r12d, errFileIo
+	cmp rax, nullptr
+	je releaseMappedTreeMap
+
+	mov [rsi].MappedTreeMap.mappingHandle, rax
+
+	mov edx, fileMapRead
+	cmp r13d, false
+	je mapView
+
+	mov edx, fileMapWrite
+
+mapView:
+	mov rcx, rax
+	mov r8d, 0
+	mov r9d, 0
+	mov qword ptr [rsp + shadowStorage], 0
+	call MapViewOfFile
+
+	cmp rax, nullptr
+	je releaseMappedTreeMap
+
+	mov [rsi].MappedTreeMap.base, rax
+
+	; Check the header of the image.
+	mov rbx, rax
+	mov r12d, snapshotInvalid
+	mov rax, mappedMagic
+	cmp [rbx].MappedHeader.magic, rax
+	jne releaseMappedTreeMap
+
+	cmp [rbx].MappedHeader.version, mappedVersion
+	jne releaseMappedTreeMap
+
+	mov rcx, rbx
+	mov edx, sizeof MappedHeader - qwordSize
+	mov r8, fnvOffsetBasis
+	call hashSnapshotBytes
+
+	cmp [rbx].MappedHeader.checksum, rax
+	jne releaseMappedTreeMap
+
+	; A treenode holds the pair and its links.
+	mov rax, [rbx].MappedHeader.keySize
+	add rax, [rbx].MappedHeader.valueSize
+	add rax, sizeof MappedTreeNode
+	cmp [rbx].MappedHeader.nodeStride, rax
+	jb releaseMappedTreeMap
+
+	; The file has to hold every treenode.
+	mov rax, [rbx].MappedHeader.nodeStride
+	mul [rbx].MappedHeader.nodeAmount
+	jc releaseMappedTreeMap
+
+	add rax, sizeof MappedHeader
+	jc releaseMappedTreeMap
+
+	cmp rax, [rsp + shadowStorage + 3 * qwordSize]
+	ja releaseMappedTreeMap
+
+	mov rax, [rbx].MappedHeader.keySize
+	mov [rsi].MappedTreeMap.keySize, rax
+	mov rax, [rbx].MappedHeader.valueSize
+	mov [rsi].MappedTreeMap.valueSize, rax
+	mov rax, [rbx].MappedHeader.nodeAmount
+	mov [rsi].MappedTreeMap.nodeAmount, rax
+	mov rax, [rbx].MappedHeader.nodeStride
+	mov [rsi].MappedTreeMap.nodeStride, rax
+	mov rax, [rbx].MappedHeader.root
+	mov [rsi].MappedTreeMap.root, rax
+
+	mov dword ptr [rdi], success
+	mov rax, rsi
+
+	jmp functionReturn
+
+releaseMappedTreeMap:
+	; Close everything that was opened.
+	mov rcx, rsi
+	call closeMappedTreeMap
+
+	mov dword ptr [rdi], r12d
+	mov rax, nullptr
+
+functionReturn:
+	add rsp, shadowStorage + 4 * qwordSize
+	pop r13
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+openMappedTreeMap endp
+
+
+	public closeMappedTreeMap
+
+; Unmaps the image of the mapped treemap and frees it. Changes are written back
+; by the system, flushMappedTreeMap waits for them.
+;
+; @RCX qword[in,out] - Pointer to the mapped treemap.
+;
+; @return A status value for success or treeMapNullptr.
+closeMappedTreeMap proc
+
+	push rsi
+	sub rsp, shadowStorage
+
+	; Check if the mapped treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+
+	mov rcx, [rsi].MappedTreeMap.base
+	cmp rcx, nullptr
+	je closeMapping
+
+	call UnmapViewOfFile
+
+closeMapping:
+	mov rcx, [rsi].MappedTreeMap.mappingHandle
+	cmp rcx, nullptr
+	je closeFile
+
+	call CloseHandle
+
+closeFile:
+	mov rcx, [rsi].MappedTreeMap.fileHandle
+	cmp rcx, invalidHandleValue
+	je freeMappedTreeMap
+
+	call CloseHandle
+
+freeMappedTreeMap:
+	mov rcx, rsi
+	call free
+
+	mov eax, success
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rsi
+	ret
+
+closeMappedTreeMap endp
+
+
+	public flushMappedTreeMap
+
+; Writes the changed pages of a mapped treemap back to its file and waits until
+; the file is stored, like msync followed by fsync.
+;
+; @RCX qword[in] - Pointer to the mapped treemap.
+;
+; @return A status value for success, errFileIo or treeMapNullptr.
+flushMappedTreeMap proc
+
+	push rsi
+	sub rsp, shadowStorage
+
+	; Check if the mapped treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+
+	mov rcx, [rsi].MappedTreeMap.base
+	mov edx, 0
+	call FlushViewOfFile
+
+	cmp eax, false
+	je fileError
+
+	; A read only file has nothing to store.
+	mov eax, success
+	cmp [rsi].MappedTreeMap.writable, false
+	je functionReturn
+
+	mov rcx, [rsi].MappedTreeMap.fileHandle
+	call FlushFileBuffers
+
+	cmp eax, false
+	je fileError
+
+	mov eax, success
+
+	jmp functionReturn
+
+fileError:
+	mov eax, errFileIo
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rsi
+	ret
+
+flushMappedTreeMap endp
+
+
+	public getMappedValue
+
+; Copies the value of the key out of the mapped treemap.
+;
+; @RCX qword[in] - Pointer to the mapped treemap.
+; @RDX qword[in] - Pointer to the key whose value is searched.
+; @R8 qword[out] - Pointer to the buffer that receives the value.
+;
+; @return A status value for success, doesNotContain, valueBufferNullptr or treeMapNullptr.
+getMappedValue proc
+
+	push rsi
+	push rbx
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the mapped treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the value buffer is a nullptr.
+	mov eax, valueBufferNullptr
+	cmp r8, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+	mov rbx, r8
+
+	mov r8d, mappedSearchExact
+	call findMappedTreeNode
+
+	mov rdx, rax
+	mov eax, doesNotContain
+	cmp rdx, nullptr
+	je functionReturn
+
+	; The value follows the key.
+	mov rcx, rbx
+	add rdx, [rsi].MappedTreeMap.keySize
+	mov r8, [rsi].MappedTreeMap.valueSize
+	call memcpy
+
+	mov eax, success
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rbx
+	pop rsi
+	ret
+
+getMappedValue endp
+
+
+	public replaceMappedValue
+
+; Overwrites the value of the key inside the image of a writable mapped treemap.
+;
+; @RCX qword[in,out] - Pointer to the mapped treemap.
+; @RDX qword[in] - Pointer to the key whose value is replaced.
+; @R8 qword[in] - Pointer to the new value.
+;
+; @return A status value for success, doesNotContain, mappedReadOnly, valueBufferNullptr or treeMapNullptr.
+replaceMappedValue proc
+
+	push rsi
+	push rbx
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the mapped treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the value is a nullptr.
+	mov eax, valueBufferNullptr
+	cmp r8, nullptr
+	je functionReturn
+
+	; Check if the image is writable.
+	mov eax, mappedReadOnly
+	cmp [rcx].MappedTreeMap.writable, false
+	je functionReturn
+
+	mov rsi, rcx
+	mov rbx, r8
+
+	mov r8d, mappedSearchExact
+	call findMappedTreeNode
+
+	mov rcx, rax
+	mov eax, doesNotContain
+	cmp rcx, nullptr
+	je functionReturn
+
+	; The value follows the key.
+	add rcx, [rsi].MappedTreeMap.keySize
+	mov rdx, rbx
+	mov r8, [rsi].MappedTreeMap.valueSize
+	call memcpy
+
+	mov eax, success
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rbx
+	pop rsi
+	ret
+
+replaceMappedValue endp
+
+
+	public ceilingMappedPair
+
+; Searches the pair with the smallest key that is bigger or equal to the given key.
+;
+; @RCX qword[in] - Pointer to the mapped treemap.
+; @RDX qword[in] - Pointer to the key.
+;
+; @return A pointer to the pair inside the image or a nullptr if it does not exist.
+ceilingMappedPair proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov r8d, mappedSearchCeiling
+	call findMappedTreeNode
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+ceilingMappedPair endp
+
+
+	public floorMappedPair
+
+; Searches the pair with the biggest key that is smaller or equal to the given key.
+;
+; @RCX qword[in] - Pointer to the mapped treemap.
+; @RDX qword[in] - Pointer to the key.
+;
+; @return A pointer to the pair inside the image or a nullptr if it does not exist.
+floorMappedPair proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov r8d, mappedSearchFloor
+	call findMappedTreeNode
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+floorMappedPair endp
+
+
+	public higherMappedPair
+
+; Searches the pair with the smallest key that is bigger than the given key.
+;
+; @RCX qword[in] - Pointer to the mapped treemap.
+; @RDX qword[in] - Pointer to the key.
+;
+; @return A pointer to the pair inside the image or a nullptr if it does not exist.
+higherMappedPair proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov r8d, mappedSearchHigher
+	call findMappedTreeNode
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+higherMappedPair endp
+
+
+	public lowerMappedPair
+
+; Searches the pair with the biggest key that is smaller than the given key.
+;
+; @RCX qword[in] - Pointer to the mapped treemap.
+; @RDX qword[in] - Pointer to the key.
+;
+; @return A pointer to the pair inside the image or a nullptr if it does not exist.
+lowerMappedPair proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov r8d, mappedSearchLower
+	call findMappedTreeNode
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+lowerMappedPair endp
+
+
+	public nextMappedPair
+
+; Steps to the pair that follows the given one in key order. The treenodes
+; of the image lie in key order, so a scan walks through the file linearly.
+;
+; @RCX qword[in] - Pointer to the mapped treemap.
+; @RDX qword[in] - Pointer to a pair inside the image or a nullptr for the first pair.
+;
+; @return A pointer to the next pair or a nullptr behind the last one.
+nextMappedPair proc
+
+	mov eax, nullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Calculate the end of the treenodes.
+	mov r8, [rcx].MappedTreeMap.nodeAmount
+	imul r8, [rcx].MappedTreeMap.nodeStride
+	add r8, [rcx].MappedTreeMap.base
+	add r8, sizeof MappedHeader
+
+	mov rax, [rcx].MappedTreeMap.base
+	add rax, sizeof MappedHeader
+	cmp rdx, nullptr
+	je checkEnd
+
+	mov rax, rdx
+	add rax, [rcx].MappedTreeMap.nodeStride
+
+checkEnd:
+	cmp rax, r8
+	jb functionReturn
+
+	mov eax, nullptr
+
+functionReturn:
+	ret
+
+nextMappedPair endp
+
+
+; Searches a treenode of the mapped treemap. The exact search returns the treenode of the key.
+; The other searches keep the last treenode whose key lies on the searched side of the key and
+; return it once the search leaves the tree. With searchInclusiveBit an equal key is returned at once.
+;
+; @RCX qword[in] - Pointer to the mapped treemap.
+; @RDX qword[in] - Pointer to the searched key.
+; @R8 qword[in] - Mode of the search, e.g. mappedSearchCeiling.
+;
+; @return A pointer to the treenode or a nullptr if it does not exist.
+findMappedTreeNode proc
+
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	push r13
+	sub rsp, shadowStorage
+
+	mov eax, nullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Save the mapped treemap, the key and the mode and start at the root.
+	mov rsi, rcx
+	mov rdi, rdx
+	mov r12, r8
+	mov rbx, [rsi].MappedTreeMap.root
+	mov r13, nullptr
+
+searchLoop:
+	; The offset zero marks a missing child.
+	cmp rbx, 0
+	je searchFinished
+
+	add rbx, [rsi].MappedTreeMap.base
+	mov rcx, rbx
+	mov rdx, rdi
+	callUserFunc [rsi].MappedTreeMap.compareKeyFunc
+
+	; An equal key is the result of every inclusive search.
+	cmp eax, 0
+	jne chooseChild
+
+	test r12, searchInclusiveBit
+	jz chooseChild
+
+	mov r13, rbx
+
+	jmp searchFinished
+
+chooseChild:
+	; Move to the links of the treenode.
+	mov rcx, rbx
+	add rcx, [rsi].MappedTreeMap.keySize
+	add rcx, [rsi].MappedTreeMap.valueSize
+
+	test r12, searchHigherBit
+	jz searchLower
+
+	; A bigger key is a candidate for a higher key, a smaller or equal one isn't.
+	cmp eax, 0
+	jge takeRightChild
+
+	jmp takeCandidate
+
+searchLower:
+	; A smaller key is a candidate for a lower key, a bigger or equal one isn't.
+	cmp eax, 0
+	jle takeLeftChild
+
+takeCandidate:
+	test r12, searchExactBit
+	jnz chooseCandidateChild
+
+	mov r13, rbx
+
+chooseCandidateChild:
+	; Search closer to the key behind the candidate.
+	test r12, searchHigherBit
+	jz takeRightChild
+
+takeLeftChild:
+	mov rbx, [rcx].MappedTreeNode.left
+
+	jmp searchLoop
+
+takeRightChild:
+	mov rbx, [rcx].MappedTreeNode.right
+
+	jmp searchLoop
+
+searchFinished:
+	mov rax, r13
+
+functionReturn:
+	add rsp, shadowStorage
+	pop r13
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+findMappedTreeNode endp
+
+end
@@ -0,0 +1,215 @@
+/*
+* @file tree_map_mapped_test.h
+*
+* Defines unit tests for the memory mapped treemaps of the tree map
+* implementation.
+*
+* @author Collector
+* @data 03/09/2023
+*/
+
+
+#include "utils.h"
+
+namespace {
+	/*
+	* Path of the image file that the tests write.
+	*/
+	const char* const imagePath{ "tree_map_mapped_test.image" };
+
+	/*
+	* Saves the treemap as an image and maps it.
+	*
+	* @param[in] tm - Treemap that is saved.
+	* @param[in] writable - Indicator if the image is mapped writable.
+	*
+	* @return The mapped treemap.
+	*/
+	MappedTreeMap* saveAndOpenImage(TreeMap* tm, bool writable) {
+		Status s;
+		FILE* file{ nullptr };
+
+		EXPECT_EQ(0, fopen_s(&file, imagePath, "wb"));
+		EXPECT_EQ(Status::SUCCESS, saveMappedTreeMap(tm, file));
+
+		fclose(file);
+
+		MappedTreeMap* mtm{ openMappedTreeMap(imagePath, compareNumberKey, writable, &s) };
+
+		EXPECT_EQ(Status::SUCCESS, s);
+
+		return mtm;
+	}
+
+	/*
+	* Asserts that a pair of the image holds the key and its square.
+	*
+	* @param[in] expectedKey - Key that the pair has to hold.
+	* @param[in] pair - Pair inside the image.
+	*/
+	void assertMappedPairEquals(size_t expectedKey, const void* pair) {
+		ASSERT_NE(nullptr, pair);
+
+		const size_t* numbers{ reinterpret_cast<const size_t*>(pair) };
+
+		ASSERT_EQ(expectedKey, numbers[0]);
+		ASSERT_EQ(expectedKey * expectedKey, numbers[1]);
+	}
+}
+
+TEST(TreeMap, openMappedTreeMapShouldFailForMissingFile) {
+	Status s;
+	MappedTreeMap* mtm{ openMappedTreeMap("tree_map_missing.image", compareNumberKey, false, &s) };
+
+	ASSERT_EQ(nullptr, mtm);
+	ASSERT_EQ(Status::ERR_FILE_IO, s);
+
+	mtm = openMappedTreeMap(nullptr, compareNumberKey, false, &s);
+
+	ASSERT_EQ(nullptr, mtm);
+	ASSERT_EQ(Status::FILE_NULLPTR, s);
+}
+
+TEST(TreeMap, openMappedTreeMapShouldRejectOtherFiles) {
+	Status s;
+	FILE* file{ nullptr };
+	TreeMap* tm{ createTestNumberTree(10, 1) };
+
+	// A snapshot isn't an image.
+	fopen_s(&file, imagePath, "wb");
+	saveTreeMap(tm, file, nullptr, 0);
+	fclose(file);
+
+	MappedTreeMap* mtm{ openMappedTreeMap(imagePath, compareNumberKey, false, &s) };
+
+	ASSERT_EQ(nullptr, mtm);
+	ASSERT_EQ(Status::SNAPSHOT_INVALID, s);
+
+	deleteTreeMap(tm);
+	std::remove(imagePath);
+}
+
+TEST(TreeMap, getMappedValueShouldFindEveryKey) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(1000, 1) };
+	MappedTreeMap* mtm{ saveAndOpenImage(tm, false) };
+
+	ASSERT_EQ(1000, mtm->nodeAmount);
+
+	for (size_t key{ 0 }; key < 1000; key++) {
+		size_t value{ 0 };
+
+		s = getMappedValue(mtm, &key, &value);
+
+		ASSERT_EQ(Status::SUCCESS, s);
+		ASSERT_EQ(key * key, value);
+	}
+
+	size_t missingKey{ 1000 }, value{ 0 };
+
+	s = getMappedValue(mtm, &missingKey, &value);
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+
+	closeMappedTreeMap(mtm);
+	deleteTreeMap(tm);
+	std::remove(imagePath);
+}
+
+TEST(TreeMap, mappedPairSearchesShouldFindNeighbours) {
+	TreeMap* tm{ createTestNumberTree(100, 2) };
+	MappedTreeMap* mtm{ saveAndOpenImage(tm, false) };
+	size_t evenKey{ 40 }, oddKey{ 41 }, tooBigKey{ 199 };
+
+	assertMappedPairEquals(40, ceilingMappedPair(mtm, &evenKey));
+	assertMappedPairEquals(42, ceilingMappedPair(mtm, &oddKey));
+	assertMappedPairEquals(40, floorMappedPair(mtm, &evenKey));
+	assertMappedPairEquals(40, floorMappedPair(mtm, &oddKey));
+	assertMappedPairEquals(42, higherMappedPair(mtm, &evenKey));
+	assertMappedPairEquals(38, lowerMappedPair(mtm, &evenKey));
+	assertMappedPairEquals(198, floorMappedPair(mtm, &tooBigKey));
+
+	ASSERT_EQ(nullptr, ceilingMappedPair(mtm, &tooBigKey));
+	ASSERT_EQ(nullptr, higherMappedPair(mtm, &tooBigKey));
+
+	size_t zeroKey{ 0 };
+
+	ASSERT_EQ(nullptr, lowerMappedPair(mtm, &zeroKey));
+
+	closeMappedTreeMap(mtm);
+	deleteTreeMap(tm);
+	std::remove(imagePath);
+}
+
+TEST(TreeMap, nextMappedPairShouldScanInKeyOrder) {
+	TreeMap* tm{ createTestNumberTree(500, 1) };
+	MappedTreeMap* mtm{ saveAndOpenImage(tm, false) };
+	size_t startKey{ 250 }, expectedKey{ 250 };
+
+	for (const void* pair{ ceilingMappedPair(mtm, &startKey) }; pair != nullptr; pair = nextMappedPair(mtm, pair)) {
+		assertMappedPairEquals(expectedKey, pair);
+
+		expectedKey++;
+	}
+
+	ASSERT_EQ(500, expectedKey);
+
+	// The first pair starts the scan.
+	assertMappedPairEquals(0, nextMappedPair(mtm, nullptr));
+
+	closeMappedTreeMap(mtm);
+	deleteTreeMap(tm);
+	std::remove(imagePath);
+}
+
+TEST(TreeMap, mappedTreeMapShouldHandleEmptyImage) {
+	TreeMap* tm{ createTestNumberTree(0, 1) };
+	MappedTreeMap* mtm{ saveAndOpenImage(tm, false) };
+	size_t key{ 0 };
+
+	ASSERT_EQ(0, mtm->nodeAmount);
+	ASSERT_EQ(nullptr, nextMappedPair(mtm, nullptr));
+	ASSERT_EQ(nullptr, ceilingMappedPair(mtm, &key));
+
+	closeMappedTreeMap(mtm);
+	deleteTreeMap(tm);
+	std::remove(imagePath);
+}
+
+TEST(TreeMap, replaceMappedValueShouldPersistInImage) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(100, 1) };
+	MappedTreeMap* mtm{ saveAndOpenImage(tm, false) };
+	size_t key{ 7 }, value{ 1234 };
+
+	s = replaceMappedValue(mtm, &key, &value);
+
+	ASSERT_EQ(Status::MAPPED_READ_ONLY, s);
+
+	closeMappedTreeMap(mtm);
+
+	mtm = openMappedTreeMap(imagePath, compareNumberKey, true, &s);
+
+	s = replaceMappedValue(mtm, &key, &value);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	s = flushMappedTreeMap(mtm);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	closeMappedTreeMap(mtm);
+
+	// The value is read from the file again.
+	mtm = openMappedTreeMap(imagePath, compareNumberKey, false, &s);
+	value = 0;
+
+	s = getMappedValue(mtm, &key, &value);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(1234, value);
+
+	closeMappedTreeMap(mtm);
+	deleteTreeMap(tm);
+	std::remove(imagePath);
+}
@@ -0,0 +1,829 @@
+; @file tree_map_merkle.asm
+;
+; Defines the subtree hashes of treemaps. Once a pair hash function is set, every treenode keeps
+; the hash of its pair and the hash of its subtree behind its links. The hash of a subtree is the sum
+; of the hashes of its pairs, so equal contents hash equally no matter how the tree is shaped and
+; a rotation only moves the hash of the subtree to the new top treenode. The insertions, deletions
+; and rotations keep the hashes up to date on the path they already walk.
+;
+; Two treemaps with the same pair hash function are compared through the hashes of their roots and
+; diffTreeMaps skips every subtree whose hash matches the hash of the pairs of the other treemap
+; between the same keys, so only the paths to the differences are visited.
+;
+; @author Collector
+; @date 03/09/2023
+
+	include tree_map.inc
+
+	.code
+
+
+	public setTreeMapHash
+
+; Sets the function that hashes the pairs of the treemap. The treenodes get room for their hashes,
+; so the hashes can only be switched on or off while the treemap is empty and has no node arena.
+; Pairs with inline data, interned values or a memory budget can't be hashed and the keys have to be unique.
+;
+; @RCX qword[in,out] - Pointer to the treemap whose pairs are hashed.
+; @RDX qword[in] - Pointer to the function that hashes a pair or a nullptr to remove the hashes.
+;
+; @return A status value for success, treeMapNotEmpty, nodeArenaExists, hashUnsupported for a multimap,
+;		  inline pairs, a value dictionary or a memory budget or treeMapNullptr.
+setTreeMapHash proc
+
+	push rsi
+	sub rsp, shadowStorage
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; The layout of the treenodes can only change while there are none.
+	mov eax, treeMapNotEmpty
+	cmp [rcx].TreeMap.nodeAmount, 0
+	jne functionReturn
+
+	; The node arena already carves treenodes of its stride.
+	mov eax, nodeArenaExists
+	cmp [rcx].TreeMap.nodeArena, nullptr
+	jne functionReturn
+
+	; Equal keys, pairs outside of the treenodes and spilled treenodes can't be hashed.
+	mov eax, hashUnsupported
+	test [rcx].TreeMap.flags, multiMapFlag + inlinePairsFlag
+	jnz functionReturn
+
+	cmp [rcx].TreeMap.valueDictionary, nullptr
+	jne functionReturn
+
+	cmp [rcx].TreeMap.spill, nullptr
+	jne functionReturn
+
+	mov rsi, rcx
+	mov [rsi].TreeMap.hashPairFunc, rdx
+
+	; The spare treenodes have the old size.
+	mov rcx, rsi
+	mov edx, 0
+	call trimSpareTreeNodes
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rsi
+	ret
+
+setTreeMapHash endp
+
+
+	public treeMapsEqual
+
+; Checks if two treemaps hold the same pairs. Treemaps with the same pair hash function are compared
+; in constant time through the hashes of their roots, which match for equal pairs and differ with a
+; probability of 1 - 2^-64 otherwise. Without hashes every pair of the first treemap is searched in the second one.
+;
+; @RCX qword[in] - Pointer to the first treemap.
+; @RDX qword[in] - Pointer to the second treemap.
+;
+; @return A status value for success if the pairs are equal, treeMapsDiffer if they aren't, hashUnsupported
+;		  if a treemap without hashes is a multimap or has a memory budget or treeMapNullptr.
+treeMapsEqual proc
+
+	push rsi
+	push rdi
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the treemaps are nullptrs.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	cmp rdx, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+	mov rdi, rdx
+
+	; Treemaps of a different size can't be equal.
+	mov eax, treeMapsDiffer
+	mov rcx, [rsi].TreeMap.nodeAmount
+	cmp rcx, [rdi].TreeMap.nodeAmount
+	jne functionReturn
+
+	; Empty treemaps are equal.
+	mov eax, success
+	cmp rcx, 0
+	je functionReturn
+
+	; The hashes can only be compared if they come from the same function.
+	mov rcx, [rsi].TreeMap.hashPairFunc
+	cmp rcx, nullptr
+	je comparePairs
+
+	cmp rcx, [rdi].TreeMap.hashPairFunc
+	jne comparePairs
+
+	mov rcx, [rsi].TreeMap.root
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rcx, [rcx + sizeof TreeNode].NodeHash.subtreeHash
+
+	mov rdx, [rdi].TreeMap.root
+	add rdx, [rdi].TreeMap.keySize
+	add rdx, [rdi].TreeMap.valueSize
+
+	mov eax, success
+	cmp rcx, [rdx + sizeof TreeNode].NodeHash.subtreeHash
+	je functionReturn
+
+	mov eax, treeMapsDiffer
+
+	jmp functionReturn
+
+comparePairs:
+	; A pair of a multimap can't be told apart from the other pairs with its key
+	; and the search doesn't fault spilled treenodes in.
+	mov eax, hashUnsupported
+	mov rcx, [rsi].TreeMap.flags
+	or rcx, [rdi].TreeMap.flags
+	test rcx, multiMapFlag
+	jnz functionReturn
+
+	cmp [rsi].TreeMap.spill, nullptr
+	jne functionReturn
+
+	cmp [rdi].TreeMap.spill, nullptr
+	jne functionReturn
+
+	; Both treemaps have the same size, so they are equal if the second one holds every pair of the first one.
+	mov rcx, [rsi].TreeMap.root
+	call containsTreeNodes
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rdi
+	pop rsi
+	ret
+
+treeMapsEqual endp
+
+
+; Recursively checks if every pair of the subtree is held by the other treemap.
+;
+; @RCX qword[in] - Pointer to the root of the subtree.
+; @RSI qword[in] - Pointer to the treemap of the subtree.
+; @RDI qword[in] - Pointer to the treemap that is searched.
+;
+; @return A status value for success or treeMapsDiffer.
+containsTreeNodes proc
+
+	push rbp
+	mov rbp, rsp
+	sub rsp, shadowStorage
+
+	mov eax, success
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov [rbp + hashedTreeNode], rcx
+
+	; Check the smaller pairs first.
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rcx, [rcx].TreeNode.left
+	call containsTreeNodes
+
+	cmp eax, success
+	jne functionReturn
+
+	; Search the key of the treenode.
+	mov rcx, [rdi].TreeMap.root
+	mov rdx, [rbp + hashedTreeNode]
+	mov r8, rdi
+	call findAddressOfKey
+
+	mov edx, treeMapsDiffer
+	cmp rax, nullptr
+	je pairsDiffer
+
+	; Interned values are compared inside their dictionary entries.
+	mov rcx, [rbp + hashedTreeNode]
+	add rcx, [rsi].TreeMap.keySize
+	cmp [rsi].TreeMap.valueDictionary, nullptr
+	je loadSearchedValue
+
+	mov rcx, [rcx]
+	add rcx, sizeof DictionaryEntry
+
+loadSearchedValue:
+	mov rdx, rax
+	add rdx, [rdi].TreeMap.keySize
+	cmp [rdi].TreeMap.valueDictionary, nullptr
+	je compareValues
+
+	mov rdx, [rdx]
+	add rdx, sizeof DictionaryEntry
+
+compareValues:
+	callUserFunc [rsi].TreeMap.equalsValueFunc
+
+	mov edx, treeMapsDiffer
+	cmp al, false
+	je pairsDiffer
+
+	; Continue with the bigger pairs.
+	mov rcx, [rbp + hashedTreeNode]
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rcx, [rcx].TreeNode.right
+	call containsTreeNodes
+
+	jmp functionReturn
+
+pairsDiffer:
+	mov eax, edx
+
+functionReturn:
+	mov rsp, rbp
+	pop rbp
+	ret
+
+containsTreeNodes endp
+
+
+	public diffTreeMaps
+
+; Visits every key whose pair differs between two treemaps with the same pair hash function, in key order.
+; A subtree of the first treemap is skipped if its hash matches the hash of the pairs of the second treemap
+; between the keys that bound the subtree, which is summed up along a single path. The work grows with the
+; amount of differences and the height of the trees instead of the amount of pairs.
+;
+; @RCX qword[in] - Pointer to the first treemap.
+; @RDX qword[in] - Pointer to the second treemap.
+; @R8 qword[in] - Pointer to the function that visits a difference. It gets the pair of the first and the
+;				  pair of the second treemap, the pair of a treemap that misses the key is a nullptr.
+;
+; @return A status value for success, the status of the visit function if it isn't success, visitFuncNullptr,
+;		  hashUnsupported if the treemaps don't have the same pair hash function or treeMapNullptr.
+diffTreeMaps proc
+
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the treemaps are nullptrs.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	cmp rdx, nullptr
+	je functionReturn
+
+	; Check if the visit function is a nullptr.
+	mov eax, visitFuncNullptr
+	cmp r8, nullptr
+	je functionReturn
+
+	; Both treemaps need the hashes of the same function.
+	mov eax, hashUnsupported
+	mov r9, [rcx].TreeMap.hashPairFunc
+	cmp r9, nullptr
+	je functionReturn
+
+	cmp r9, [rdx].TreeMap.hashPairFunc
+	jne functionReturn
+
+	; Save the treemaps and the visit function.
+	mov rsi, rcx
+	mov rdi, rdx
+	mov r12, r8
+
+	; The hash of the pairs between two keys is the hash of the second treemap
+	; minus the hashes of the pairs outside of the keys.
+	mov ebx, 0
+	mov rcx, [rdi].TreeMap.root
+	cmp rcx, nullptr
+	je diffTrees
+
+	add rcx, [rdi].TreeMap.keySize
+	add rcx, [rdi].TreeMap.valueSize
+	mov rbx, [rcx + sizeof TreeNode].NodeHash.subtreeHash
+
+diffTrees:
+	mov rcx, [rsi].TreeMap.root
+	mov rdx, nullptr
+	mov r8, nullptr
+	call diffTreeNodes
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+diffTreeMaps endp
+
+
+; Recursively visits the differences between a subtree of the first treemap and the pairs of the second
+; treemap between the same keys. The keys that bound the subtree aren't part of it.
+;
+; @RBX qword[in] - Hash of the second treemap.
+; @RCX qword[in] - Pointer to the root of the subtree of the first treemap.
+; @RDX qword[in] - Pointer to the key below the subtree or a nullptr.
+; @R8 qword[in] - Pointer to the key above the subtree or a nullptr.
+; @RSI qword[in] - Pointer to the first treemap.
+; @RDI qword[in] - Pointer to the second treemap.
+; @R12 qword[in] - Pointer to the visit function.
+;
+; @return A status value for success or the status of the visit function.
+diffTreeNodes proc
+
+	push rbp
+	mov rbp, rsp
+	sub rsp, shadowStorage
+
+	mov [rbp + hashedTreeNode], rcx
+	mov [rbp + lowerBound], rdx
+	mov [rbp + higherBound], r8
+	mov [rbp + rangeHash], rbx
+
+	; Remove the hashes of the pairs up to the lower key.
+	cmp rdx, nullptr
+	je subtractHigherHashes
+
+	mov rcx, rdx
+	mov dl, searchAsLower
+	call sumHashesBeyond
+
+	sub [rbp + rangeHash], rax
+
+subtractHigherHashes:
+	; Remove the hashes of the pairs from the higher key on.
+	mov rcx, [rbp + higherBound]
+	cmp rcx, nullptr
+	je compareSubtreeHashes
+
+	mov dl, searchAsHigher
+	call sumHashesBeyond
+
+	sub [rbp + rangeHash], rax
+
+compareSubtreeHashes:
+	; An empty subtree has the hash zero.
+	mov eax, 0
+	mov rcx, [rbp + hashedTreeNode]
+	cmp rcx, nullptr
+	je compareRangeHash
+
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rax, [rcx + sizeof TreeNode].NodeHash.subtreeHash
+
+compareRangeHash:
+	; Equal hashes mean equal pairs, so the subtree is skipped.
+	cmp rax, [rbp + rangeHash]
+	mov eax, success
+	je functionReturn
+
+	cmp [rbp + hashedTreeNode], nullptr
+	jne diffLeftSubtree
+
+	; Every pair of the second treemap between the keys is missing in the first one.
+	mov rcx, [rdi].TreeMap.root
+	mov rdx, [rbp + lowerBound]
+	mov r8, [rbp + higherBound]
+	call visitMissingTreeNodes
+
+	jmp functionReturn
+
+diffLeftSubtree:
+	mov rcx, [rbp + hashedTreeNode]
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rcx, [rcx].TreeNode.left
+	mov rdx, [rbp + lowerBound]
+	mov r8, [rbp + hashedTreeNode]
+	call diffTreeNodes
+
+	cmp eax, success
+	jne functionReturn
+
+	; Search the pair of the treenode inside the second treemap.
+	mov rcx, [rdi].TreeMap.root
+	mov rdx, [rbp + hashedTreeNode]
+	mov r8, rdi
+	call findAddressOfKey
+
+	mov rdx, rax
+	cmp rax, nullptr
+	je visitDifference
+
+	; The pair differs if the values aren't equal.
+	mov [rbp + rangeHash], rax
+	mov rcx, [rbp + hashedTreeNode]
+	add rcx, [rsi].TreeMap.keySize
+	add rdx, [rdi].TreeMap.keySize
+	callUserFunc [rsi].TreeMap.equalsValueFunc
+
+	mov rdx, [rbp + rangeHash]
+	cmp al, false
+	jne diffRightSubtree
+
+visitDifference:
+	mov rcx, [rbp + hashedTreeNode]
+	callUserFunc r12
+
+	cmp eax, success
+	jne functionReturn
+
+diffRightSubtree:
+	mov rcx, [rbp + hashedTreeNode]
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rcx, [rcx].TreeNode.right
+	mov rdx, [rbp + hashedTreeNode]
+	mov r8, [rbp + higherBound]
+	call diffTreeNodes
+
+functionReturn:
+	mov rsp, rbp
+	pop rbp
+	ret
+
+diffTreeNodes endp
+
+
+; Sums up the hashes of the pairs of the second treemap on one side of a key, including the pair of the key.
+; The search path adds a treenode with the subtree next to it whenever the treenode is on the searched side.
+;
+; @RCX qword[in] - Pointer to the key.
+; @DL byte[in] - searchAsLower for the smaller keys or searchAsHigher for the bigger keys.
+; @RDI qword[in] - Pointer to the second treemap.
+;
+; @return The sum of the hashes.
+sumHashesBeyond proc
+
+	push rbp
+	mov rbp, rsp
+	sub rsp, shadowStorage
+
+	mov [rbp + summedKey], rcx
+	mov [rbp + summedDirection], dl
+	mov qword ptr [rbp + hashSum], 0
+	mov rcx, [rdi].TreeMap.root
+
+sumTreeNode:
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov [rbp + hashedTreeNode], rcx
+	mov rdx, [rbp + summedKey]
+	countTreeMapEvent rdi, comparisons
+	callUserFunc [rdi].TreeMap.compareKeyFunc
+
+	; R8 selects the child on the searched side. The bigger keys mirror the smaller ones.
+	mov r8, 0
+	cmp byte ptr [rbp + summedDirection], searchAsLower
+	je testTreeNode
+
+	neg eax
+	mov r8, qwordSize
+
+testTreeNode:
+	mov rcx, [rbp + hashedTreeNode]
+	add rcx, [rdi].TreeMap.keySize
+	add rcx, [rdi].TreeMap.valueSize
+
+	; A treenode beyond the key continues the search on the searched side.
+	cmp eax, 0
+	jl followChild
+
+	; Otherwise the treenode and the subtree on the searched side are added.
+	mov rdx, [rcx + sizeof TreeNode].NodeHash.pairHash
+	add [rbp + hashSum], rdx
+
+	mov rdx, [rcx + r8]
+	cmp rdx, nullptr
+	je testEqualKey
+
+	add rdx, [rdi].TreeMap.keySize
+	add rdx, [rdi].TreeMap.valueSize
+	mov rdx, [rdx + sizeof TreeNode].NodeHash.subtreeHash
+	add [rbp + hashSum], rdx
+
+testEqualKey:
+	; The treenode of the key ends the search.
+	cmp eax, 0
+	je functionReturn
+
+	xor r8, qwordSize
+
+followChild:
+	mov rcx, [rcx + r8]
+
+	jmp sumTreeNode
+
+functionReturn:
+	mov rax, [rbp + hashSum]
+	mov rsp, rbp
+	pop rbp
+	ret
+
+sumHashesBeyond endp
+
+
+; Recursively visits the pairs of a subtree of the second treemap that are between two keys
+; as differences without a pair of the first treemap.
+;
+; @RCX qword[in] - Pointer to the root of the subtree of the second treemap.
+; @RDX qword[in] - Pointer to the key below the visited pairs or a nullptr.
+; @R8 qword[in] - Pointer to the key above the visited pairs or a nullptr.
+; @RDI qword[in] - Pointer to the second treemap.
+; @R12 qword[in] - Pointer to the visit function.
+;
+; @return A status value for success or the status of the visit function.
+visitMissingTreeNodes proc
+
+	push rbp
+	mov rbp, rsp
+	sub rsp, shadowStorage
+
+	mov eax, success
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov [rbp + hashedTreeNode], rcx
+	mov [rbp + lowerBound], rdx
+	mov [rbp + higherBound], r8
+	mov byte ptr [rbp + aboveLowerBound], true
+
+	; Smaller keys only exist if the treenode is above the lower key.
+	cmp rdx, nullptr
+	je visitLeftSubtree
+
+	countTreeMapEvent rdi, comparisons
+	callUserFunc [rdi].TreeMap.compareKeyFunc
+
+	cmp eax, 0
+	jl visitLeftSubtree
+
+	mov byte ptr [rbp + aboveLowerBound], false
+
+	jmp testHigherBound
+
+visitLeftSubtree:
+	mov rcx, [rbp + hashedTreeNode]
+	add rcx, [rdi].TreeMap.keySize
+	add rcx, [rdi].TreeMap.valueSize
+	mov rcx, [rcx].TreeNode.left
+	mov rdx, [rbp + lowerBound]
+	mov r8, [rbp + higherBound]
+	call visitMissingTreeNodes
+
+	cmp eax, success
+	jne functionReturn
+
+testHigherBound:
+	; Bigger keys only exist if the treenode is below the higher key.
+	mov eax, success
+	mov rdx, [rbp + higherBound]
+	cmp rdx, nullptr
+	je visitTreeNode
+
+	mov rcx, [rbp + hashedTreeNode]
+	countTreeMapEvent rdi, comparisons
+	callUserFunc [rdi].TreeMap.compareKeyFunc
+
+	cmp eax, 0
+	mov eax, success
+	jle functionReturn
+
+visitTreeNode:
+	cmp byte ptr [rbp + aboveLowerBound], false
+	je visitRightSubtree
+
+	mov rcx, nullptr
+	mov rdx, [rbp + hashedTreeNode]
+	callUserFunc r12
+
+	cmp eax, success
+	jne functionReturn
+
+visitRightSubtree:
+	mov rcx, [rbp + hashedTreeNode]
+	add rcx, [rdi].TreeMap.keySize
+	add rcx, [rdi].TreeMap.valueSize
+	mov rcx, [rcx].TreeNode.right
+	mov rdx, [rbp + lowerBound]
+	mov r8, [rbp + higherBound]
+	call visitMissingTreeNodes
+
+functionReturn:
+	mov rsp, rbp
+	pop rbp
+	ret
+
+visitMissingTreeNodes endp
+
+
+; Hashes the pair of the treenode and stores the hash behind its links. The hash of the function is mixed
+; with the finalizer of splitmix64 first, otherwise the sums of simple hashes like the keys themselves
+; would be equal for many different sets of pairs.
+;
+; @RCX qword[in,out] - Pointer to the treenode.
+; @RSI qword[in] - Pointer to the treemap.
+;
+; @return The hash of the pair.
+hashTreeNodePair proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov [rsp + shadowStorage], rcx
+	callUserFunc [rsi].TreeMap.hashPairFunc
+
+	mov rdx, rax
+	shr rdx, 30
+	xor rax, rdx
+	mov rdx, mixMultiplier1
+	imul rax, rdx
+	mov rdx, rax
+	shr rdx, 27
+	xor rax, rdx
+	mov rdx, mixMultiplier2
+	imul rax, rdx
+	mov rdx, rax
+	shr rdx, 31
+	xor rax, rdx
+
+	mov rcx, [rsp + shadowStorage]
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov [rcx + sizeof TreeNode].NodeHash.pairHash, rax
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+hashTreeNodePair endp
+
+
+; Recursively hashes the pairs of a subtree and sums up the hashes of its subtrees.
+;
+; @RCX qword[in,out] - Pointer to the root of the subtree.
+; @RSI qword[in] - Pointer to the treemap.
+;
+; @return The hash of the subtree.
+hashTreeNodes proc
+
+	push rbp
+	mov rbp, rsp
+	sub rsp, shadowStorage
+
+	mov eax, 0
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov [rbp + hashedTreeNode], rcx
+	call hashTreeNodePair
+
+	mov [rbp + hashSum], rax
+
+	mov rcx, [rbp + hashedTreeNode]
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rcx, [rcx].TreeNode.left
+	call hashTreeNodes
+
+	add [rbp + hashSum], rax
+
+	mov rcx, [rbp + hashedTreeNode]
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rcx, [rcx].TreeNode.right
+	call hashTreeNodes
+
+	add rax, [rbp + hashSum]
+
+	mov rcx, [rbp + hashedTreeNode]
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov [rcx + sizeof TreeNode].NodeHash.subtreeHash, rax
+
+functionReturn:
+	mov rsp, rbp
+	pop rbp
+	ret
+
+hashTreeNodes endp
+
+
+; Sums up the hash of the subtree of a treenode out of the hash of its pair and the ones of its children.
+; Only RDX, R10 and R11 are changed, so the rotations and the balancing can call it between their steps.
+;
+; @RCX qword[in,out] - Pointer to the treenode.
+; @RSI qword[in] - Pointer to the treemap.
+rehashTreeNode proc
+
+	mov r11, rcx
+	add r11, [rsi].TreeMap.keySize
+	add r11, [rsi].TreeMap.valueSize
+	mov rdx, [r11 + sizeof TreeNode].NodeHash.pairHash
+
+	mov r10, [r11].TreeNode.left
+	cmp r10, nullptr
+	je addRightHash
+
+	add r10, [rsi].TreeMap.keySize
+	add r10, [rsi].TreeMap.valueSize
+	add rdx, [r10 + sizeof TreeNode].NodeHash.subtreeHash
+
+addRightHash:
+	mov r10, [r11].TreeNode.right
+	cmp r10, nullptr
+	je storeSubtreeHash
+
+	add r10, [rsi].TreeMap.keySize
+	add r10, [rsi].TreeMap.valueSize
+	add rdx, [r10 + sizeof TreeNode].NodeHash.subtreeHash
+
+storeSubtreeHash:
+	mov [r11 + sizeof TreeNode].NodeHash.subtreeHash, rdx
+	ret
+
+rehashTreeNode endp
+
+
+; Hashes the pair of a treenode again after it changed in place. The subtrees on the path from the root
+; to the treenode change by the difference of the hashes, so no other pair is hashed again.
+;
+; @RCX qword[in,out] - Pointer to the treemap.
+; @RDX qword[in,out] - Pointer to the changed treenode.
+updateTreeNodeHash proc
+
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	sub rsp, shadowStorage + qwordSize
+
+	mov rsi, rcx
+	mov rbx, rdx
+
+	; Take the difference between the new and the old hash.
+	mov rcx, rbx
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rdi, [rcx + sizeof TreeNode].NodeHash.pairHash
+
+	mov rcx, rbx
+	call hashTreeNodePair
+
+	sub rax, rdi
+	mov rdi, rax
+	mov rcx, [rsi].TreeMap.root
+
+addDifference:
+	mov r12, rcx
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	add [rcx + sizeof TreeNode].NodeHash.subtreeHash, rdi
+
+	cmp r12, rbx
+	je functionReturn
+
+	; Follow the key of the treenode.
+	mov rcx, r12
+	mov rdx, rbx
+	countTreeMapEvent rsi, comparisons
+	callUserFunc [rsi].TreeMap.compareKeyFunc
+
+	mov rcx, r12
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+
+	cmp eax, 0
+	jl followLeftChild
+
+	mov rcx, [rcx].TreeNode.right
+
+	jmp addDifference
+
+followLeftChild:
+	mov rcx, [rcx].TreeNode.left
+
+	jmp addDifference
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+updateTreeNodeHash endp
+
+end
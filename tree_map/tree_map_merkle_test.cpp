@@ -0,0 +1,427 @@
+/*
+* @file tree_map_merkle_test.h
+*
+* Defines unit tests for the subtree hashes of the tree map
+* implementation.
+*
+* @author Collector
+* @data 03/09/2023
+*/
+
+
+#include "utils.h"
+
+namespace {
+	/*
+	* Treenode of a treemap of numbers followed by its subtree hashes.
+	*/
+	struct HashedTreeNode {
+		NumberTreeNode node;
+
+		size_t pairHash;
+		size_t subtreeHash;
+	};
+
+	/*
+	* Difference that was visited by diffTreeMaps.
+	*
+	* @var key - Key of the differing pairs.
+	* @var inFirst - Indicator if the first treemap holds the key.
+	* @var inSecond - Indicator if the second treemap holds the key.
+	*/
+	struct Difference {
+		size_t key;
+		bool inFirst;
+		bool inSecond;
+	};
+
+	/*
+	* Differences of the last diff.
+	*/
+	std::vector<Difference> differences;
+
+	/*
+	* Count of the key comparisons since it was reset.
+	*/
+	size_t comparisonAmount{ 0 };
+
+	/*
+	* Hashes a pair of numbers. The treemap mixes the hash, so it can be simple.
+	*
+	* @param[in] pair - Pair that is hashed.
+	*
+	* @return The hash of the pair.
+	*/
+	size_t hashNumberPair(const void* pair) {
+		const size_t* numbers{ reinterpret_cast<const size_t*>(pair) };
+
+		return numbers[0] * 31 + numbers[1];
+	}
+
+	/*
+	* Hashes a pair of numbers with another function than hashNumberPair.
+	*
+	* @param[in] pair - Pair that is hashed.
+	*
+	* @return The hash of the pair.
+	*/
+	size_t hashNumberKey(const void* pair) {
+		return *reinterpret_cast<const size_t*>(pair);
+	}
+
+	/*
+	* Compares two numbers and counts the comparison.
+	*
+	* @param[in] tKey - Key of the treenode.
+	* @param[in] insertedKey - Key that is searched.
+	*
+	* @return The result of compareNumberKey.
+	*/
+	long countNumberKey(const void* tKey, const void* insertedKey) {
+		comparisonAmount++;
+
+		return compareNumberKey(tKey, insertedKey);
+	}
+
+	/*
+	* Collects a difference of diffTreeMaps.
+	*
+	* @param[in] pairA - Pair of the first treemap or a nullptr.
+	* @param[in] pairB - Pair of the second treemap or a nullptr.
+	*
+	* @return A status of success.
+	*/
+	Status collectDifference(const void* pairA, const void* pairB) {
+		const size_t* pair{ reinterpret_cast<const size_t*>(pairA != nullptr ? pairA : pairB) };
+
+		differences.push_back({ pair[0], pairA != nullptr, pairB != nullptr });
+
+		return Status::SUCCESS;
+	}
+
+	/*
+	* Stops diffTreeMaps at the first difference.
+	*
+	* @param[in] pairA - Pair of the first treemap or a nullptr.
+	* @param[in] pairB - Pair of the second treemap or a nullptr.
+	*
+	* @return A status of already contains.
+	*/
+	Status stopDiff(const void* pairA, const void* pairB) {
+		return Status::ALREADY_CONTAINS;
+	}
+
+	/*
+	* Creates a treemap of numbers with subtree hashes. The keys are the numbers up to
+	* the amount times the step and the values their squares.
+	*
+	* @param[in] amount - Amount of pairs.
+	* @param[in] step - Distance between two keys.
+	* @param[in] descending - Indicator if the pairs are inserted from the biggest key on,
+	*						  which gives the tree another shape.
+	*
+	* @return The treemap.
+	*/
+	TreeMap* createHashedNumberTree(size_t amount, size_t step, bool descending) {
+		Status s;
+		TreeMap* tm{ createTreeMap(sizeof(size_t), sizeof(size_t), countNumberKey,
+			equalsNumberValue, copyNumberKey, copyNumberValue, nullptr, &s) };
+
+		EXPECT_EQ(Status::SUCCESS, setTreeMapHash(tm, hashNumberPair));
+
+		for (size_t i{ 0 }; i < amount; i++) {
+			size_t key{ (descending ? amount - 1 - i : i) * step };
+			size_t pair[2]{ key, key * key };
+
+			EXPECT_EQ(Status::SUCCESS, putPair(tm, pair));
+		}
+
+		return tm;
+	}
+
+	/*
+	* Checks that every treenode holds the hash of its subtree.
+	*
+	* @param[in] node - Root of the subtree.
+	*
+	* @return The hash of the subtree.
+	*/
+	size_t assertSubtreeHashes(const NumberTreeNode* node) {
+		if (node == nullptr) {
+			return 0;
+		}
+
+		const HashedTreeNode* hashedNode{ reinterpret_cast<const HashedTreeNode*>(node) };
+		size_t subtreeHash{ hashedNode->pairHash + assertSubtreeHashes(node->left) + assertSubtreeHashes(node->right) };
+
+		EXPECT_EQ(subtreeHash, hashedNode->subtreeHash);
+
+		return subtreeHash;
+	}
+}
+
+TEST(TreeMap, setTreeMapHashShouldFailForUnsupportedTreeMaps) {
+	TreeMap* tm{ createTestNumberTree(10, 1) };
+	TreeMap* emptyTree{ createTestNumberTree(0, 1) };
+	TreeMap* multiMap{ createTestNumberTree(0, 1) };
+	TreeMap* inlineTree{ createTestInlineTree() };
+
+	ASSERT_EQ(Status::SUCCESS, setTreeMapFlags(multiMap, TreeMapFlags::MULTI_MAP));
+	ASSERT_EQ(Status::SUCCESS, clearTreeMap(inlineTree));
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, setTreeMapHash(nullptr, hashNumberPair));
+	ASSERT_EQ(Status::TREE_MAP_NOT_EMPTY, setTreeMapHash(tm, hashNumberPair));
+	ASSERT_EQ(Status::HASH_UNSUPPORTED, setTreeMapHash(multiMap, hashNumberPair));
+	ASSERT_EQ(Status::HASH_UNSUPPORTED, setTreeMapHash(inlineTree, hashNumberPair));
+
+	// Once the pairs are hashed the treemap can't get features that don't keep the hashes.
+	ASSERT_EQ(Status::SUCCESS, setTreeMapHash(emptyTree, hashNumberPair));
+	ASSERT_EQ(Status::HASH_UNSUPPORTED, setTreeMapFlags(emptyTree, TreeMapFlags::MULTI_MAP));
+	ASSERT_EQ(Status::HASH_UNSUPPORTED, createValueDictionary(emptyTree, nullptr));
+	ASSERT_EQ(Status::SUCCESS, createNodeArena(emptyTree, 4096, 0));
+	ASSERT_EQ(Status::NODE_ARENA_EXISTS, setTreeMapHash(emptyTree, nullptr));
+
+	deleteTreeMap(inlineTree);
+	deleteTreeMap(multiMap);
+	deleteTreeMap(emptyTree);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, subtreeHashesShouldFollowEveryChange) {
+	TreeMap* tm{ createHashedNumberTree(2000, 2, false) };
+	size_t pair[2]{};
+
+	assertSubtreeHashes(reinterpret_cast<NumberTreeNode*>(tm->root));
+
+	for (size_t key{ 0 }; key < 4000; key += 6) {
+		ASSERT_EQ(Status::SUCCESS, deletePair(tm, &key, nullptr));
+	}
+
+	ASSERT_EQ(Status::SUCCESS, pollFirstPair(tm, pair));
+	ASSERT_EQ(Status::SUCCESS, pollLastPair(tm, pair));
+
+	for (size_t key{ 4 }; key < 4000; key += 30) {
+		size_t value{ key + 1 };
+
+		ASSERT_EQ(Status::SUCCESS, replaceValue(tm, &key, &value));
+	}
+
+	// The first key keeps its position, the second one is relinked.
+	size_t oldKey{ 100 }, newKey{ 101 }, keyBuffer{ 0 };
+
+	ASSERT_EQ(Status::SUCCESS, rekeyPair(tm, &oldKey, &newKey, &keyBuffer));
+
+	oldKey = 200;
+	newKey = 5001;
+
+	ASSERT_EQ(Status::SUCCESS, rekeyPair(tm, &oldKey, &newKey, &keyBuffer));
+
+	assertSubtreeHashes(reinterpret_cast<NumberTreeNode*>(tm->root));
+
+	// The same pairs inserted in another order give another tree with the same hash.
+	TreeMap* replica{ createHashedNumberTree(0, 1, false) };
+
+	for (size_t key{ 5001 }; key != SIZE_MAX; key--) {
+		size_t value{ 0 };
+
+		if (getValue(tm, &key, &value) == Status::SUCCESS) {
+			size_t replicaPair[2]{ key, value };
+
+			ASSERT_EQ(Status::SUCCESS, putPair(replica, replicaPair));
+		}
+	}
+
+	ASSERT_EQ(tm->nodeAmount, replica->nodeAmount);
+	ASSERT_EQ(Status::SUCCESS, treeMapsEqual(tm, replica));
+
+	size_t key{ 4 }, value{ 0 };
+
+	ASSERT_EQ(Status::SUCCESS, replaceValue(replica, &key, &value));
+	ASSERT_EQ(Status::TREE_MAPS_DIFFER, treeMapsEqual(tm, replica));
+
+	clearTreeMap(tm);
+
+	ASSERT_EQ(nullptr, tm->root);
+
+	deleteTreeMap(replica);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, treeMapsEqualShouldOnlyCompareRootsWithHashes) {
+	TreeMap* tm1{ createHashedNumberTree(10000, 1, false) };
+	TreeMap* tm2{ createHashedNumberTree(10000, 1, true) };
+	TreeMap* plainTree1{ createTestNumberTree(10000, 1) };
+	TreeMap* plainTree2{ createTestNumberTree(10000, 1) };
+
+	comparisonAmount = 0;
+
+	ASSERT_EQ(Status::SUCCESS, treeMapsEqual(tm1, tm2));
+	ASSERT_EQ(0, comparisonAmount);
+
+	size_t pair[2]{};
+
+	ASSERT_EQ(Status::SUCCESS, pollLastPair(tm2, pair));
+	ASSERT_EQ(Status::TREE_MAPS_DIFFER, treeMapsEqual(tm1, tm2));
+
+	// Without the same hash function every pair is searched.
+	ASSERT_EQ(Status::SUCCESS, treeMapsEqual(plainTree1, plainTree2));
+	ASSERT_EQ(Status::SUCCESS, treeMapsEqual(tm1, plainTree1));
+
+	size_t key{ 5000 }, value{ 1 };
+
+	ASSERT_EQ(Status::SUCCESS, replaceValue(plainTree2, &key, &value));
+	ASSERT_EQ(Status::TREE_MAPS_DIFFER, treeMapsEqual(plainTree1, plainTree2));
+	ASSERT_EQ(Status::TREE_MAPS_DIFFER, treeMapsEqual(plainTree1, tm2));
+
+	TreeMap* multiMap{ createTestMultiMap() };
+
+	ASSERT_EQ(Status::HASH_UNSUPPORTED, treeMapsEqual(multiMap, multiMap));
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, treeMapsEqual(nullptr, tm1));
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, treeMapsEqual(tm1, nullptr));
+
+	deleteTreeMap(multiMap);
+	deleteTreeMap(plainTree2);
+	deleteTreeMap(plainTree1);
+	deleteTreeMap(tm2);
+	deleteTreeMap(tm1);
+}
+
+TEST(TreeMap, diffTreeMapsShouldOnlyWalkToTheDifferences) {
+	constexpr size_t amount{ 1 << 16 };
+	TreeMap* tm1{ createHashedNumberTree(amount, 1, false) };
+	TreeMap* tm2{ createHashedNumberTree(amount, 1, true) };
+
+	// Identical treemaps only compare the roots.
+	differences.clear();
+	comparisonAmount = 0;
+
+	ASSERT_EQ(Status::SUCCESS, diffTreeMaps(tm1, tm2, collectDifference));
+	ASSERT_EQ(0, differences.size());
+	ASSERT_EQ(0, comparisonAmount);
+
+	size_t key{ 10 };
+
+	ASSERT_EQ(Status::SUCCESS, deletePair(tm2, &key, nullptr));
+
+	key = 50000;
+
+	ASSERT_EQ(Status::SUCCESS, deletePair(tm2, &key, nullptr));
+
+	size_t value{ 1 };
+
+	key = 77;
+
+	ASSERT_EQ(Status::SUCCESS, replaceValue(tm2, &key, &value));
+
+	key = 30000;
+
+	ASSERT_EQ(Status::SUCCESS, replaceValue(tm2, &key, &value));
+
+	size_t pair[2]{ amount + 5, 0 };
+
+	ASSERT_EQ(Status::SUCCESS, putPair(tm2, pair));
+
+	pair[0] = amount + 9;
+
+	ASSERT_EQ(Status::SUCCESS, putPair(tm1, pair));
+
+	differences.clear();
+	comparisonAmount = 0;
+
+	ASSERT_EQ(Status::SUCCESS, diffTreeMaps(tm1, tm2, collectDifference));
+
+	const Difference expected[]{ { 10, true, false }, { 77, true, true }, { 30000, true, true },
+		{ 50000, true, false }, { amount + 5, false, true }, { amount + 9, true, false } };
+
+	ASSERT_EQ(std::size(expected), differences.size());
+
+	for (size_t i{ 0 }; i < differences.size(); i++) {
+		ASSERT_EQ(expected[i].key, differences[i].key);
+		ASSERT_EQ(expected[i].inFirst, differences[i].inFirst);
+		ASSERT_EQ(expected[i].inSecond, differences[i].inSecond);
+	}
+
+	// A full scan would compare every key at least once.
+	ASSERT_GT(amount / 8, comparisonAmount);
+
+	// The differences are mirrored if the treemaps are swapped.
+	differences.clear();
+
+	ASSERT_EQ(Status::SUCCESS, diffTreeMaps(tm2, tm1, collectDifference));
+	ASSERT_EQ(std::size(expected), differences.size());
+	ASSERT_EQ(10, differences[0].key);
+	ASSERT_FALSE(differences[0].inFirst);
+	ASSERT_TRUE(differences[0].inSecond);
+
+	ASSERT_EQ(Status::ALREADY_CONTAINS, diffTreeMaps(tm1, tm2, stopDiff));
+
+	deleteTreeMap(tm2);
+	deleteTreeMap(tm1);
+}
+
+TEST(TreeMap, diffTreeMapsShouldFailWithoutTheSameHashFunction) {
+	TreeMap* tm1{ createHashedNumberTree(10, 1, false) };
+	TreeMap* tm2{ createTestNumberTree(10, 1) };
+	TreeMap* tm3{ createTestNumberTree(0, 1) };
+
+	ASSERT_EQ(Status::SUCCESS, setTreeMapHash(tm3, hashNumberKey));
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, diffTreeMaps(nullptr, tm1, collectDifference));
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, diffTreeMaps(tm1, nullptr, collectDifference));
+	ASSERT_EQ(Status::VISIT_FUNC_NULLPTR, diffTreeMaps(tm1, tm1, nullptr));
+	ASSERT_EQ(Status::HASH_UNSUPPORTED, diffTreeMaps(tm1, tm2, collectDifference));
+	ASSERT_EQ(Status::HASH_UNSUPPORTED, diffTreeMaps(tm2, tm1, collectDifference));
+	ASSERT_EQ(Status::HASH_UNSUPPORTED, diffTreeMaps(tm1, tm3, collectDifference));
+
+	// An empty treemap differs by every pair of the other one.
+	differences.clear();
+
+	ASSERT_EQ(Status::SUCCESS, setTreeMapHash(tm3, hashNumberPair));
+	ASSERT_EQ(Status::SUCCESS, diffTreeMaps(tm3, tm1, collectDifference));
+	ASSERT_EQ(10, differences.size());
+	ASSERT_EQ(9, differences[9].key);
+
+	deleteTreeMap(tm3);
+	deleteTreeMap(tm2);
+	deleteTreeMap(tm1);
+}
+
+TEST(TreeMap, subtreeHashesShouldSurviveSnapshotsAndCompactions) {
+	FILE* file{ createTemporaryFile() };
+	TreeMap* tm{ createHashedNumberTree(5000, 1, false) };
+	TreeMap* loadedTree{ createHashedNumberTree(0, 1, false) };
+
+	ASSERT_EQ(Status::SUCCESS, saveTreeMap(tm, file, nullptr, 0));
+
+	rewind(file);
+
+	ASSERT_EQ(Status::SUCCESS, loadTreeMap(loadedTree, file, nullptr));
+	assertSubtreeHashes(reinterpret_cast<NumberTreeNode*>(loadedTree->root));
+	ASSERT_EQ(Status::SUCCESS, treeMapsEqual(tm, loadedTree));
+
+	// The treenodes of the arena have room for the hashes, which move with them.
+	Status s;
+	TreeMap* arenaTree{ createTreeMap(sizeof(size_t), sizeof(size_t), compareNumberKey,
+		equalsNumberValue, copyNumberKey, copyNumberValue, nullptr, &s) };
+
+	ASSERT_EQ(Status::SUCCESS, setTreeMapHash(arenaTree, hashNumberPair));
+	ASSERT_EQ(Status::SUCCESS, createNodeArena(arenaTree, 4096, 0));
+
+	for (size_t key{ 0 }; key < 10000; key++) {
+		size_t pair[2]{ key, key * key };
+
+		ASSERT_EQ(Status::SUCCESS, putPair(arenaTree, pair));
+	}
+
+	for (size_t key{ 5000 }; key < 10000; key++) {
+		ASSERT_EQ(Status::SUCCESS, deletePair(arenaTree, &key, nullptr));
+	}
+
+	ASSERT_EQ(Status::SUCCESS, compactTreeMap(arenaTree, 0));
+	assertSubtreeHashes(reinterpret_cast<NumberTreeNode*>(arenaTree->root));
+	ASSERT_EQ(Status::SUCCESS, treeMapsEqual(tm, arenaTree));
+
+	deleteTreeMap(arenaTree);
+	deleteTreeMap(loadedTree);
+	deleteTreeMap(tm);
+	fclose(file);
+}
@@ -0,0 +1,313 @@
+; @file tree_map_multi.asm
+;
+; Defines the functions of a treemap that only make sense if
+; the treemap is a multimap and stores equal keys in insertion order.
+;
+; @author Collector
+; @date 03/09/2023
+
+	include tree_map.inc
+
+	.code
+
+
+	public equalRange
+
+; Deep copies all key value pairs with the given key in insertion order into the buffer.
+; If the buffer is too small only the oldest pairs that fit into it are copied.
+;
+; @RCX qword[in,out] - Pointer to the treemap that is searched for the key.
+; @RDX qword[in] - Pointer to the key of the pairs.
+; @R8 qword[out] - Pointer to a buffer of consecutive pairs that receives the copies.
+; @R9 qword[in] - Amount of pairs the buffer can hold.
+; @Stack qword[out] - Pointer to a qword that receives the amount of pairs with the key.
+;
+; @return A status value for success, doesNotContain if no pair has the key, an error if the
+;		  copy functions fail or the treemap, the pair buffer or the amount buffer is a nullptr.
+equalRange proc
+
+	push rbp
+	mov rbp, rsp
+	sub rsp, shadowStorage
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the pair buffer is a nullptr.
+	mov eax, pairBufferNullptr
+	cmp r8, nullptr
+	je functionReturn
+
+	; Check if the amount buffer is a nullptr.
+	mov eax, amountBufferNullptr
+	mov r10, [rbp + pairAmount]
+	cmp r10, nullptr
+	je functionReturn
+
+	call executeEqualRange
+
+functionReturn:
+	mov rsp, rbp
+	pop rbp
+	ret
+
+equalRange endp
+
+
+	public countKey
+
+; Counts the key value pairs that have the given key.
+;
+; @RCX qword[in,out] - Pointer to the treemap that is searched for the key.
+; @RDX qword[in] - Pointer to the key of the pairs.
+; @R8 qword[out] - Pointer to a qword that receives the amount of pairs with the key.
+;
+; @return A status value for success, doesNotContain if no pair has the key or
+;		  an error if the treemap or the amount buffer is a nullptr.
+countKey proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the amount buffer is a nullptr.
+	mov eax, amountBufferNullptr
+	cmp r8, nullptr
+	je functionReturn
+
+	; Count the pairs without a buffer to copy them into.
+	mov r10, r8
+	mov r8, nullptr
+	xor r9, r9
+	call executeEqualRange
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	ret
+
+countKey endp
+
+
+	public deleteAllForKey
+
+; Deletes all key value pairs that have the given key.
+; Nested heap memory of the pairs is freed by the free pair function.
+;
+; @RCX qword[in,out] - Pointer to the treemap that gets the pairs deleted.
+; @RDX qword[in] - Pointer to the key of the pairs.
+;
+; @return A status value for success, doesNotContain if no pair has the key
+;		  or an error if the treemap is a nullptr.
+deleteAllForKey proc
+
+	push rsi
+	push rdi
+	push r12
+	sub rsp, shadowStorage
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Save the treemap and the key.
+	mov rsi, rcx
+	mov r12, rdx
+	mov edi, doesNotContain
+
+deleteLoop:
+	; Delete the oldest pair with the key
+	; until no pair is left.
+	mov rcx, rsi
+	mov rdx, r12
+	mov r8, nullptr
+	call deletePair
+
+	cmp eax, success
+	jne deletionFinished
+
+	mov edi, success
+
+	jmp deleteLoop
+
+deletionFinished:
+	mov eax, edi
+
+functionReturn:
+	add rsp, shadowStorage
+	pop r12
+	pop rdi
+	pop rsi
+	ret
+
+deleteAllForKey endp
+
+
+; Collects the key value pairs with the given key for equalRange and countKey.
+;
+; @RCX qword[in,out] - Pointer to the treemap that is searched for the key.
+; @RDX qword[in] - Pointer to the key of the pairs.
+; @R8 qword[out] - Pointer to a buffer of consecutive pairs that receives the copies.
+; @R9 qword[in] - Amount of pairs the buffer can hold.
+; @R10 qword[out] - Pointer to a qword that receives the amount of pairs with the key.
+;
+; @return A status value for success, doesNotContain if no pair has the key
+;		  or an error if the copy functions fail.
+executeEqualRange proc
+
+	push rbp
+	mov rbp, rsp
+	push rbx
+	push rsi
+	push rdi
+	push r12
+	push r13
+	push r14
+	sub rsp, shadowStorage
+
+	; Store the treemap, the key, the buffer and its length
+	; inside non volatile registers. The amount starts at zero.
+	mov rsi, rcx
+	mov r12, rdx
+	mov rbx, r8
+	mov r13, r9
+	xor rdi, rdi
+	mov r14d, success
+	mov [rbp + amountBuffer], r10
+
+	; Spilled treenodes around the key are faulted back in.
+	call faultSpilledPath
+
+	cmp eax, success
+	jne functionReturn
+
+	mov rcx, [rsi].TreeMap.root
+	call visitEqualPairs
+
+	; Hand out the amount of pairs.
+	mov r10, [rbp + amountBuffer]
+	mov [r10], rdi
+
+	; Return a copy error or if no pair was found.
+	mov eax, r14d
+	cmp eax, success
+	jne functionReturn
+
+	cmp rdi, 0
+	jne functionReturn
+
+	mov eax, doesNotContain
+
+functionReturn:
+	lea rsp, [rbp - 6 * qwordSize]
+	pop r14
+	pop r13
+	pop r12
+	pop rdi
+	pop rsi
+	pop rbx
+	pop rbp
+	ret
+
+executeEqualRange endp
+
+
+; Visits the treenodes with the given key in order and copies their pairs
+; as long as the buffer has space left. Subtrees that can't hold the key are skipped.
+;
+; @RBX qword[in,out] - Pointer to the next free pair inside the buffer.
+; @RCX qword[in] - Pointer to the current tree node evaluated.
+; @RDI qword[in,out] - Amount of pairs that have the key.
+; @RSI qword[in] - Pointer to the current treemap used.
+; @R12 qword[in] - Pointer to the key of the pairs.
+; @R13 qword[in,out] - Amount of pairs that still fit into the buffer.
+; @R14 dword[out] - Status value that changes if the copy functions fail.
+visitEqualPairs proc
+
+	push rbp
+	mov rbp, rsp
+	sub rsp, shadowStorage
+
+	; Test if a nullptr branch was reached.
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Save the current treenode and compare the keys.
+	mov [rbp + currentTreeNode], rcx
+	mov rdx, r12
+	countTreeMapEvent rsi, comparisons
+	callUserFunc [rsi].TreeMap.compareKeyFunc
+
+	mov dword ptr [rbp + compareResult], eax
+
+	; Pairs with the key can only be on the left side
+	; if the key is not bigger than the current one.
+	cmp eax, 0
+	jg visitRightBranch
+
+	mov rcx, [rbp + currentTreeNode]
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rcx, [rcx]
+	call visitEqualPairs
+
+	; If the key is smaller both the current node
+	; and the right side are bigger.
+	cmp dword ptr [rbp + compareResult], 0
+	jne functionReturn
+
+	; Stop if a copy already failed.
+	cmp r14d, success
+	jne functionReturn
+
+	; Count the pair and copy it if the buffer has space left.
+	inc rdi
+	cmp r13, 0
+	je visitRightBranch
+
+	mov rcx, rbx
+	mov rdx, [rbp + currentTreeNode]
+	mov r8, rsi
+	call copyPair
+
+	mov r14d, eax
+	cmp eax, success
+	jne functionReturn
+
+	; Move to the next pair inside the buffer. With a value dictionary
+	; the buffer holds values of the dictionaries value size.
+	mov rax, [rsi].TreeMap.valueSize
+	mov rcx, [rsi].TreeMap.valueDictionary
+	cmp rcx, nullptr
+	je advanceBuffer
+
+	mov rax, [rcx].ValueDictionary.valueSize
+
+advanceBuffer:
+	add rbx, [rsi].TreeMap.keySize
+	add rbx, rax
+	dec r13
+
+visitRightBranch:
+	; Pairs with the key can only be on the right side
+	; if the key is not smaller than the current one.
+	mov rcx, [rbp + currentTreeNode]
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	add rcx, qwordSize
+	mov rcx, [rcx]
+	call visitEqualPairs
+
+functionReturn:
+	mov rsp, rbp
+	pop rbp
+	ret
+
+visitEqualPairs endp
+
+end
@@ -0,0 +1,367 @@
+/*
+* @file tree_map_multi_test.h
+*
+* Defines unit tests for the multimap functionality of the tree map
+* implementation.
+*
+* @author Collector
+* @data 03/09/2023
+*/
+
+
+#include "utils.h"
+
+
+TEST(TreeMap, setTreeMapFlagsShouldFailForTreeMapNullptr) {
+	Status s;
+
+	s = setTreeMapFlags(nullptr, TreeMapFlags::MULTI_MAP);
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, s);
+}
+
+TEST(TreeMap, setTreeMapFlagsShouldFailForNotEmptyTreeMap) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+
+	s = setTreeMapFlags(tm, TreeMapFlags::MULTI_MAP);
+
+	ASSERT_EQ(Status::TREE_MAP_NOT_EMPTY, s);
+	ASSERT_EQ(0, tm->flags);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, putPairShouldRejectEqualKeyWithoutMultiMapFlag) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+	TreeNodePair* p{ createTreeNodePair("Kansas", "Wichita", 1870, 397532) };
+
+	s = putPair(tm, p);
+
+	ASSERT_EQ(Status::ALREADY_CONTAINS, s);
+	ASSERT_EQ(5, tm->nodeAmount);
+
+	freeTreeNodePairs({ p });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, putPairShouldStoreEqualKeysInMultiMap) {
+	TreeMap* tm{ createTestMultiMap() };
+
+	ASSERT_EQ(TreeMapFlags::MULTI_MAP, tm->flags);
+	ASSERT_EQ(5, tm->nodeAmount);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, getValueShouldReturnOldestValueInMultiMap) {
+	Status s;
+	TreeMap* tm{ createTestMultiMap() };
+	TreeNodeKey* k{ createTreeNodeKey("Kansas") };
+	TreeNodeValue* expected{ createTreeNodeValue("Topeka", 1861, 2937880) };
+	TreeNodeValue result;
+
+	s = getValue(tm, k, &result);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertTreeNodeValueEquals(expected, &result);
+
+	free(result.capitalCity);
+	freeTreeNodeValues({ expected });
+	freeTreeNodeKeys({ k });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, deletePairShouldDeleteOldestPairInMultiMap) {
+	Status s;
+	TreeMap* tm{ createTestMultiMap() };
+	TreeNodeKey* k{ createTreeNodeKey("Kansas") };
+	TreeNodePair* expectedDeleted{ createTreeNodePair("Kansas", "Topeka", 1861, 2937880) },
+		* expectedRemaining{ createTreeNodePair("Kansas", "Wichita", 1870, 397532) };
+	TreeNodePair deleted, remaining;
+
+	s = deletePair(tm, k, &deleted);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(4, tm->nodeAmount);
+	assertTreeNodePairEquals(expectedDeleted, &deleted);
+
+	s = ceilingPair(tm, k, &remaining);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertTreeNodePairEquals(expectedRemaining, &remaining);
+
+	freeTreeNodePair(&deleted);
+	freeTreeNodePair(&remaining);
+	freeTreeNodePairs({ expectedDeleted, expectedRemaining });
+	freeTreeNodeKeys({ k });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, pollFirstPairShouldDeleteOldestMinimumInMultiMap) {
+	Status s;
+	TreeMap* tm{ createTestMultiMap() };
+	TreeNodePair* expected{ createTreeNodePair("Kansas", "Topeka", 1861, 2937880) };
+	TreeNodePair result;
+
+	s = pollFirstPair(tm, &result);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(4, tm->nodeAmount);
+	assertTreeNodePairEquals(expected, &result);
+
+	freeTreeNodePair(&result);
+	freeTreeNodePairs({ expected });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, pollLastPairShouldDeleteNewestMaximumInMultiMap) {
+	Status s;
+	TreeMap* tm{ createTestMultiMap() };
+	TreeNodePair* p{ createTreeNodePair("Oregon", "Portland", 1859, 652503) },
+		* expected{ createTreeNodePair("Oregon", "Portland", 1859, 652503) };
+	TreeNodePair result;
+
+	s = putPair(tm, p);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	s = pollLastPair(tm, &result);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(5, tm->nodeAmount);
+	assertTreeNodePairEquals(expected, &result);
+
+	freeTreeNodePair(&result);
+	freeTreeNodePairs({ p, expected });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, ceilingAndFloorPairShouldReturnOldestAndNewestInMultiMap) {
+	Status s;
+	TreeMap* tm{ createTestMultiMap() };
+	TreeNodeKey* k{ createTreeNodeKey("Kansas") };
+	TreeNodePair* expectedCeiling{ createTreeNodePair("Kansas", "Topeka", 1861, 2937880) },
+		* expectedFloor{ createTreeNodePair("Kansas", "Lawrence", 1854, 94934) };
+	TreeNodePair ceiling, floor;
+
+	s = ceilingPair(tm, k, &ceiling);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertTreeNodePairEquals(expectedCeiling, &ceiling);
+
+	s = floorPair(tm, k, &floor);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertTreeNodePairEquals(expectedFloor, &floor);
+
+	freeTreeNodePair(&ceiling);
+	freeTreeNodePair(&floor);
+	freeTreeNodePairs({ expectedCeiling, expectedFloor });
+	freeTreeNodeKeys({ k });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, equalRangeShouldFailForTreeMapNullptr) {
+	Status s;
+	TreeNodePair buffer[1];
+	size_t amount;
+
+	s = equalRange(nullptr, nullptr, buffer, 1, &amount);
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, s);
+}
+
+TEST(TreeMap, equalRangeShouldFailForPairBufferNullptr) {
+	Status s;
+	TreeMap* tm{ createTestMultiMap() };
+	TreeNodeKey* k{ createTreeNodeKey("Kansas") };
+	size_t amount;
+
+	s = equalRange(tm, k, nullptr, 1, &amount);
+
+	ASSERT_EQ(Status::PAIR_BUFFER_NULLPTR, s);
+
+	freeTreeNodeKeys({ k });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, equalRangeShouldFailForAmountBufferNullptr) {
+	Status s;
+	TreeMap* tm{ createTestMultiMap() };
+	TreeNodeKey* k{ createTreeNodeKey("Kansas") };
+	TreeNodePair buffer[1];
+
+	s = equalRange(tm, k, buffer, 1, nullptr);
+
+	ASSERT_EQ(Status::AMOUNT_BUFFER_NULLPTR, s);
+
+	freeTreeNodeKeys({ k });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, equalRangeShouldFailForMissingKey) {
+	Status s;
+	TreeMap* tm{ createTestMultiMap() };
+	TreeNodeKey* k{ createTreeNodeKey("Texas") };
+	TreeNodePair buffer[1];
+	size_t amount;
+
+	s = equalRange(tm, k, buffer, 1, &amount);
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+	ASSERT_EQ(0, amount);
+
+	freeTreeNodeKeys({ k });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, equalRangeShouldReturnPairsInInsertionOrder) {
+	Status s;
+	TreeMap* tm{ createTestMultiMap() };
+	TreeNodeKey* k{ createTreeNodeKey("Kansas") };
+	std::vector<TreeNodePair*> expected{
+		createTreeNodePair("Kansas", "Topeka", 1861, 2937880),
+		createTreeNodePair("Kansas", "Wichita", 1870, 397532),
+		createTreeNodePair("Kansas", "Lawrence", 1854, 94934)
+	};
+	TreeNodePair buffer[4];
+	size_t amount;
+
+	s = equalRange(tm, k, buffer, 4, &amount);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(3, amount);
+
+	for (size_t i{ 0 }; i < amount; i++) {
+		assertTreeNodePairEquals(expected[i], &buffer[i]);
+		freeTreeNodePair(&buffer[i]);
+	}
+
+	freeTreeNodePairs(expected);
+	freeTreeNodeKeys({ k });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, equalRangeShouldOnlyCopyOldestPairsForSmallBuffer) {
+	Status s;
+	TreeMap* tm{ createTestMultiMap() };
+	TreeNodeKey* k{ createTreeNodeKey("Kansas") };
+	std::vector<TreeNodePair*> expected{
+		createTreeNodePair("Kansas", "Topeka", 1861, 2937880),
+		createTreeNodePair("Kansas", "Wichita", 1870, 397532)
+	};
+	TreeNodePair buffer[2];
+	size_t amount;
+
+	s = equalRange(tm, k, buffer, 2, &amount);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(3, amount);
+
+	for (size_t i{ 0 }; i < expected.size(); i++) {
+		assertTreeNodePairEquals(expected[i], &buffer[i]);
+		freeTreeNodePair(&buffer[i]);
+	}
+
+	freeTreeNodePairs(expected);
+	freeTreeNodeKeys({ k });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, countKeyShouldFailForAmountBufferNullptr) {
+	Status s;
+	TreeMap* tm{ createTestMultiMap() };
+	TreeNodeKey* k{ createTreeNodeKey("Kansas") };
+
+	s = countKey(tm, k, nullptr);
+
+	ASSERT_EQ(Status::AMOUNT_BUFFER_NULLPTR, s);
+
+	freeTreeNodeKeys({ k });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, countKeyShouldCountPairsWithKey) {
+	Status s;
+	TreeMap* tm{ createTestMultiMap() };
+	TreeNodeKey* kansas{ createTreeNodeKey("Kansas") }, * oregon{ createTreeNodeKey("Oregon") };
+	size_t amount;
+
+	s = countKey(tm, kansas, &amount);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(3, amount);
+
+	s = countKey(tm, oregon, &amount);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(1, amount);
+
+	freeTreeNodeKeys({ kansas, oregon });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, deleteAllForKeyShouldFailForMissingKey) {
+	Status s;
+	TreeMap* tm{ createTestMultiMap() };
+	TreeNodeKey* k{ createTreeNodeKey("Texas") };
+
+	s = deleteAllForKey(tm, k);
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+	ASSERT_EQ(5, tm->nodeAmount);
+
+	freeTreeNodeKeys({ k });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, deleteAllForKeyShouldDeleteEveryPairWithKey) {
+	Status s;
+	TreeMap* tm{ createTestMultiMap() };
+	TreeNodeKey* k{ createTreeNodeKey("Kansas") };
+
+	s = deleteAllForKey(tm, k);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(2, tm->nodeAmount);
+
+	s = containsKey(tm, k);
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+
+	freeTreeNodeKeys({ k });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, rekeyPairShouldAppendOldestPairBehindNewKeyInMultiMap) {
+	Status s;
+	TreeMap* tm{ createTestMultiMap() };
+	TreeNodeKey* oldKey{ createTreeNodeKey("Kansas") }, * newKey{ createTreeNodeKey("Oregon") };
+	TreeNodeKey keyBuffer;
+	TreeNodePair* expectedFloor{ createTreeNodePair("Oregon", "Topeka", 1861, 2937880) };
+	TreeNodePair floor;
+	size_t amount;
+
+	s = rekeyPair(tm, oldKey, newKey, &keyBuffer);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(5, tm->nodeAmount);
+
+	s = countKey(tm, newKey, &amount);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(2, amount);
+
+	s = floorPair(tm, newKey, &floor);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertTreeNodePairEquals(expectedFloor, &floor);
+
+	free(keyBuffer.stateName);
+	freeTreeNodePair(&floor);
+	freeTreeNodePairs({ expectedFloor });
+	freeTreeNodeKeys({ oldKey, newKey });
+	deleteTreeMap(tm);
+}
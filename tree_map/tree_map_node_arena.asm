@@ -0,0 +1,965 @@
+; @file tree_map_node_arena.asm
+;
+; Defines the node arena of a treemap. Treenodes are carved out of large chunks
+; instead of being allocated one by one, so that neighbouring treenodes share pages
+; and the tree touches fewer TLB entries. The chunks can be backed by large pages and
+; the treenodes can be aligned on cache lines.
+;
+; @author Collector
+; @date 03/09/2023
+
+	include tree_map.inc
+
+	.code
+
+
+	public createNodeArena
+
+; Attaches an empty node arena to the treemap. Its chunks are allocated on demand.
+; The spare treenodes of the treemap are freed, because they weren't allocated from the arena.
+;
+; @RCX qword[in,out] - Pointer to the empty treemap that gets the node arena.
+; @RDX qword[in] - Size of a chunk in bytes. It is rounded up to the large page size if large pages are used.
+; @R8 qword[in] - NodeArenaFlags that select large pages and cache line aligned treenodes.
+;
+; @return A status value for success, nodeArenaExists if the treemap already has one, treeMapNotEmpty,
+;		  inlineSizeMismatch for inline pairs, chunkSizeTooSmall, errHeapAllocation or treeMapNullptr.
+createNodeArena proc
+
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the treemap already has an arena.
+	mov eax, nodeArenaExists
+	cmp [rcx].TreeMap.nodeArena, nullptr
+	jne functionReturn
+
+	; Check if the treemap is empty.
+	mov eax, treeMapNotEmpty
+	cmp [rcx].TreeMap.nodeAmount, 0
+	jne functionReturn
+
+	; Treenodes with inline pairs differ in size and can't share a stride.
+	mov eax, inlineSizeMismatch
+	test [rcx].TreeMap.flags, inlinePairsFlag
+	jnz functionReturn
+
+	; Save the treemap, the chunk size and the flags.
+	mov rsi, rcx
+	mov rdi, rdx
+	mov rbx, r8
+
+	; Every treenode starts on a quadword boundary.
+	mov r12, [rsi].TreeMap.keySize
+	add r12, [rsi].TreeMap.valueSize
+	add r12, sizeof TreeNode + qwordSize - 1
+	and r12, -qwordSize
+
+	; The hashes follow the links.
+	cmp [rsi].TreeMap.hashPairFunc, nullptr
+	je alignTreeNodes
+
+	add r12, sizeof NodeHash
+
+alignTreeNodes:
+	test rbx, cacheLineAlignedFlag
+	jz roundChunkSize
+
+	; Aligned treenodes start on a cache line boundary.
+	add r12, cacheLineSize - 1
+	and r12, -cacheLineSize
+
+roundChunkSize:
+	test rbx, largePagesFlag
+	jz checkChunkSize
+
+	; A large page chunk has to be a multiple of the large page size, which is a power of two.
+	; Without large page support the size is zero and the chunk size is kept.
+	call GetLargePageMinimum
+
+	cmp rax, 0
+	je checkChunkSize
+
+	lea rcx, [rax - 1]
+	add rdi, rcx
+	not rcx
+	and rdi, rcx
+
+checkChunkSize:
+	; The header of a chunk takes the first cache line and at least one treenode has to follow it.
+	lea rcx, [r12 + cacheLineSize]
+	mov eax, chunkSizeTooSmall
+	cmp rdi, rcx
+	jb functionReturn
+
+	mov rcx, sizeof NodeArena
+	call malloc
+
+	cmp rax, nullptr
+	je heapAllocationError
+
+	; The arena starts without chunks.
+	mov [rax].NodeArena.chunks, nullptr
+	mov [rax].NodeArena.freeNodes, nullptr
+	mov [rax].NodeArena.freeNodeAmount, 0
+	mov [rax].NodeArena.nodeStride, r12
+	mov [rax].NodeArena.chunkSize, rdi
+	mov [rax].NodeArena.chunkUsed, 0
+	mov [rax].NodeArena.flags, rbx
+	mov [rax].NodeArena.largePageChunks, 0
+	mov [rax].NodeArena.compaction, nullptr
+	mov [rsi].TreeMap.nodeArena, rax
+
+	; Free the spare treenodes.
+	mov rcx, rsi
+	mov rdx, 0
+	call trimSpareTreeNodes
+
+	mov eax, success
+
+	jmp functionReturn
+
+heapAllocationError:
+	mov eax, errHeapAllocation
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+createNodeArena endp
+
+
+	public reserveTreeMap
+
+; Reserves treenodes for the given amount of insertions so that they don't allocate.
+; The reservation counts the released treenodes and the rest of the newest chunk of the node arena.
+; If they don't suffice the rest is put on the free list and a single chunk for the missing
+; treenodes is allocated. An empty treemap without a node arena gets one with the default chunk size.
+;
+; @RCX qword[in,out] - Pointer to the treemap whose treenodes are reserved.
+; @RDX qword[in] - Amount of treenodes that are reserved.
+;
+; @return A status value for success, treeMapNotEmpty if the treemap holds treenodes that weren't
+;		  taken from a node arena, inlineSizeMismatch for inline pairs, errHeapAllocation or treeMapNullptr.
+reserveTreeMap proc
+
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Treenodes with inline pairs differ in size and can't be reserved.
+	mov eax, inlineSizeMismatch
+	test [rcx].TreeMap.flags, inlinePairsFlag
+	jnz functionReturn
+
+	; Save the treemap and the amount.
+	mov rsi, rcx
+	mov rdi, rdx
+
+	cmp [rsi].TreeMap.nodeArena, nullptr
+	jne countReservedTreeNodes
+
+	; createNodeArena rejects a treemap that isn't empty.
+	mov rcx, rsi
+	mov edx, defaultChunkSize
+	mov r8d, 0
+	call createNodeArena
+
+	cmp eax, success
+	jne functionReturn
+
+countReservedTreeNodes:
+	mov rbx, [rsi].TreeMap.nodeArena
+
+	; Released treenodes are reused first.
+	mov eax, success
+	sub rdi, [rbx].NodeArena.freeNodeAmount
+	jbe functionReturn
+
+	mov rcx, [rbx].NodeArena.chunks
+	cmp rcx, nullptr
+	je allocateReservation
+
+	; Count the treenodes that still fit into the newest chunk.
+	mov rax, [rcx].NodeChunk.capacity
+	sub rax, [rbx].NodeArena.chunkUsed
+	mov edx, 0
+	div [rbx].NodeArena.nodeStride
+	mov r12, rax
+
+	mov eax, success
+	cmp rdi, r12
+	jbe functionReturn
+
+	sub rdi, r12
+
+releaseRestOfChunk:
+	; The reservation chunk becomes the newest one, so the
+	; rest of the current one is put on the free list.
+	cmp r12, 0
+	je allocateReservation
+
+	mov rax, [rbx].NodeArena.chunks
+	add rax, [rbx].NodeArena.chunkUsed
+	mov rcx, [rbx].NodeArena.freeNodes
+	mov [rax], rcx
+	mov [rbx].NodeArena.freeNodes, rax
+	inc [rbx].NodeArena.freeNodeAmount
+	mov rcx, [rbx].NodeArena.nodeStride
+	add [rbx].NodeArena.chunkUsed, rcx
+	dec r12
+
+	jmp releaseRestOfChunk
+
+allocateReservation:
+	call allocateReservedChunk
+
+	cmp rax, nullptr
+	je heapAllocationError
+
+	mov eax, success
+
+	jmp functionReturn
+
+heapAllocationError:
+	mov eax, errHeapAllocation
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+reserveTreeMap endp
+
+
+; Allocates a chunk that holds the given amount of treenodes. Its size is
+; rounded up to a multiple of the chunk size of the arena.
+;
+; @RDI qword[in] - Amount of treenodes the chunk holds at least.
+; @RBX qword[in,out] - Pointer to the node arena.
+;
+; @return The chunk or a nullptr if the allocation failed.
+allocateReservedChunk proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	; The chunk holds the header and the treenodes.
+	mov rax, rdi
+	mul [rbx].NodeArena.nodeStride
+	add rax, cacheLineSize
+	mov rcx, [rbx].NodeArena.chunkSize
+	lea rax, [rax + rcx - 1]
+	mov edx, 0
+	div rcx
+	mul rcx
+
+	mov rcx, rax
+	call allocateNodeChunk
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+allocateReservedChunk endp
+
+
+; Takes the memory for a treenode from the node arena. A treenode of a deleted pair
+; is reused first, otherwise the next treenode of the newest chunk is handed out.
+; A new chunk is allocated if the newest one is full.
+;
+; @RSI qword[in,out] - Pointer to the current treemap that has a node arena.
+;
+; @return The treenode or a nullptr if a new chunk can't be allocated.
+takeArenaTreeNode proc
+
+	push rbx
+	sub rsp, shadowStorage
+
+	mov rbx, [rsi].TreeMap.nodeArena
+
+	; Reuse a released treenode, its first quadword links the next one.
+	mov rax, [rbx].NodeArena.freeNodes
+	cmp rax, nullptr
+	je bumpTreeNode
+
+	mov rcx, [rax]
+	mov [rbx].NodeArena.freeNodes, rcx
+	dec [rbx].NodeArena.freeNodeAmount
+
+	jmp functionReturn
+
+bumpTreeNode:
+	; Take the treenode from the newest chunk if it fits.
+	mov rcx, [rbx].NodeArena.chunks
+	cmp rcx, nullptr
+	je allocateChunk
+
+	mov rdx, [rbx].NodeArena.chunkUsed
+	add rdx, [rbx].NodeArena.nodeStride
+	cmp rdx, [rcx].NodeChunk.capacity
+	jbe handOutTreeNode
+
+allocateChunk:
+	mov rcx, [rbx].NodeArena.chunkSize
+	call allocateNodeChunk
+
+	cmp rax, nullptr
+	je functionReturn
+
+	mov rcx, rax
+
+handOutTreeNode:
+	; Hand out the memory behind the used part of the chunk.
+	mov rax, rcx
+	add rax, [rbx].NodeArena.chunkUsed
+	mov rdx, [rbx].NodeArena.nodeStride
+	add [rbx].NodeArena.chunkUsed, rdx
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rbx
+	ret
+
+takeArenaTreeNode endp
+
+
+; Allocates a new chunk for the node arena and links it in front of the older ones.
+; Large pages are tried first if the arena asks for them, normal pages are the fallback
+; because large pages need a privilege that processes usually don't hold.
+;
+; @RCX qword[in] - Size of the chunk in bytes, a multiple of the chunk size of the arena.
+; @RBX qword[in,out] - Pointer to the node arena.
+;
+; @return The chunk or a nullptr if the allocation failed.
+allocateNodeChunk proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov [rsp + shadowStorage], rcx
+
+	test [rbx].NodeArena.flags, largePagesFlag
+	jz allocateNormalPages
+
+	mov rcx, nullptr
+	mov rdx, [rsp + shadowStorage]
+	mov r8d, memCommit or memReserve or memLargePages
+	mov r9d, pageReadWrite
+	call VirtualAlloc
+
+	cmp rax, nullptr
+	je allocateNormalPages
+
+	inc [rbx].NodeArena.largePageChunks
+	mov [rax].NodeChunk.largePages, true
+
+	jmp linkChunk
+
+allocateNormalPages:
+	mov rcx, nullptr
+	mov rdx, [rsp + shadowStorage]
+	mov r8d, memCommit or memReserve
+	mov r9d, pageReadWrite
+	call VirtualAlloc
+
+	cmp rax, nullptr
+	je functionReturn
+
+	mov [rax].NodeChunk.largePages, false
+
+linkChunk:
+	; The treenodes follow the cache line of the chunk header.
+	mov rcx, [rbx].NodeArena.chunks
+	mov [rax].NodeChunk.next, rcx
+	mov rcx, [rsp + shadowStorage]
+	mov [rax].NodeChunk.capacity, rcx
+	mov [rbx].NodeArena.chunks, rax
+	mov [rbx].NodeArena.chunkUsed, cacheLineSize
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	ret
+
+allocateNodeChunk endp
+
+
+; Releases all chunks of the node arena and resets it so that it can be used again.
+; A running compaction is cancelled. The treenodes inside the chunks must not be part of the tree anymore.
+;
+; @RCX qword[in,out] - Pointer to the node arena or a nullptr if the treemap has none.
+clearNodeArena proc
+
+	push rbx
+	push rdi
+	sub rsp, shadowStorage + qwordSize
+
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rbx, rcx
+
+	; Free the state of a running compaction, free ignores a nullptr.
+	mov rcx, [rbx].NodeArena.compaction
+	mov [rbx].NodeArena.compaction, nullptr
+	call free
+
+	mov rdi, [rbx].NodeArena.chunks
+
+releaseChunk:
+	cmp rdi, nullptr
+	je resetArena
+
+	mov rcx, rdi
+	mov rdi, [rdi].NodeChunk.next
+	mov rdx, 0
+	mov r8d, memRelease
+	call VirtualFree
+
+	jmp releaseChunk
+
+resetArena:
+	mov [rbx].NodeArena.chunks, nullptr
+	mov [rbx].NodeArena.freeNodes, nullptr
+	mov [rbx].NodeArena.freeNodeAmount, 0
+	mov [rbx].NodeArena.chunkUsed, 0
+	mov [rbx].NodeArena.largePageChunks, 0
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rdi
+	pop rbx
+	ret
+
+clearNodeArena endp
+
+
+	public compactTreeMap
+
+; Relocates the treenodes of the treemap in order into new chunks of its node arena,
+; so that range scans walk through memory linearly. The old chunks are released once
+; all treenodes have left them. The compaction is incremental, every call visits at most
+; the given amount of treenodes and the treemap can be modified between the calls.
+; Treenodes released during the compaction aren't reused until it is finished.
+;
+; @RCX qword[in,out] - Pointer to the treemap whose treenodes are compacted.
+; @RDX qword[in] - Maximum amount of treenodes visited by this call, zero finishes the compaction.
+;
+; @return A status value for success if the compaction is finished, compactionPending if another call is needed,
+;		  nodeArenaNullptr, errHeapAllocation or treeMapNullptr. The compaction can be continued after an error.
+compactTreeMap proc
+
+	push rbp
+	mov rbp, rsp
+	push rbx
+	push rsi
+	push rdi
+	push r12
+	push r13
+	push r14
+	sub rsp, shadowStorage
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the treemap has a node arena.
+	mov eax, nodeArenaNullptr
+	mov rbx, [rcx].TreeMap.nodeArena
+	cmp rbx, nullptr
+	je functionReturn
+
+	; Spilled treenodes are faulted back in before the tree is walked.
+	call restoreSpilledTreeMap
+
+	cmp eax, success
+	jne functionReturn
+
+	; Save the treemap and the budget, r14 counts the visited treenodes.
+	mov rsi, rcx
+	mov r13, rdx
+	mov r14, 0
+
+	mov r12, [rbx].NodeArena.compaction
+	cmp r12, nullptr
+	jne checkModification
+
+	call startCompaction
+
+	cmp rax, nullptr
+	je heapAllocationError
+
+	mov r12, rax
+
+	jmp rebuildPath
+
+checkModification:
+	; The links on the stack are only valid if the tree wasn't changed since the last call.
+	mov rax, [rsi].TreeMap.modificationCount
+	cmp rax, [r12].NodeCompaction.version
+	je visitTreeNodes
+
+rebuildPath:
+	call rebuildCompactionPath
+
+visitTreeNodes:
+	; Stop if the budget is used up.
+	cmp r13, 0
+	je nextTreeNode
+
+	cmp r14, r13
+	jae suspendCompaction
+
+nextTreeNode:
+	mov rcx, [r12].NodeCompaction.depth
+	cmp rcx, 0
+	jne popLink
+
+	; The walk ended. Treenodes whose key changed in place can be missed,
+	; so another walk from the smallest key is started for them.
+	cmp [r12].NodeCompaction.pendingAmount, 0
+	je compactionFinished
+
+	mov [r12].NodeCompaction.cursor, nullptr
+
+	jmp rebuildPath
+
+popLink:
+	dec rcx
+	mov [r12].NodeCompaction.depth, rcx
+	mov rdi, [r12 + rcx * qwordSize].NodeCompaction.links
+
+	; Treenodes inside the new chunks were relocated or inserted during the compaction.
+	mov rcx, [rdi]
+	mov rdx, rbx
+	call isRelocatedTreeNode
+
+	cmp al, true
+	je visitTreeNode
+
+	call takeArenaTreeNode
+
+	cmp rax, nullptr
+	je restoreLink
+
+	; Copy the treenode and link the copy.
+	mov rcx, rax
+	mov rdx, [rdi]
+	mov r8, [rsi].TreeMap.keySize
+	add r8, [rsi].TreeMap.valueSize
+	add r8, sizeof TreeNode
+
+	cmp [rsi].TreeMap.hashPairFunc, nullptr
+	je copyRelocatedTreeNode
+
+	add r8, sizeof NodeHash
+
+copyRelocatedTreeNode:
+	call memcpy
+
+	mov [rdi], rax
+	dec [r12].NodeCompaction.pendingAmount
+
+visitTreeNode:
+	mov rax, [rdi]
+	mov [r12].NodeCompaction.cursor, rax
+	inc r14
+
+	; Continue with the smallest treenode of the right subtree.
+	mov rdi, rax
+	add rdi, [rsi].TreeMap.keySize
+	add rdi, [rsi].TreeMap.valueSize
+	add rdi, qwordSize
+
+pushLeftLinks:
+	mov rax, [rdi]
+	cmp rax, nullptr
+	je visitTreeNodes
+
+	mov rcx, [r12].NodeCompaction.depth
+	mov [r12 + rcx * qwordSize].NodeCompaction.links, rdi
+	inc [r12].NodeCompaction.depth
+
+	mov rdi, rax
+	add rdi, [rsi].TreeMap.keySize
+	add rdi, [rsi].TreeMap.valueSize
+
+	jmp pushLeftLinks
+
+compactionFinished:
+	call finishCompaction
+
+	mov eax, success
+
+	jmp functionReturn
+
+restoreLink:
+	; Keep the treenode on the stack so that the next call relocates it.
+	inc [r12].NodeCompaction.depth
+
+heapAllocationError:
+	mov r14d, errHeapAllocation
+
+	jmp saveVersion
+
+suspendCompaction:
+	mov r14d, compactionPending
+
+saveVersion:
+	; Relocations don't change the tree, the next call can continue with the stack.
+	cmp r12, nullptr
+	je returnStatus
+
+	mov rax, [rsi].TreeMap.modificationCount
+	mov [r12].NodeCompaction.version, rax
+
+returnStatus:
+	mov eax, r14d
+
+functionReturn:
+	lea rsp, [rbp - 6 * qwordSize]
+	pop r14
+	pop r13
+	pop r12
+	pop rdi
+	pop rsi
+	pop rbx
+	pop rbp
+	ret
+
+compactTreeMap endp
+
+
+; Starts the compaction of the node arena. A chunk for all treenodes is allocated in front of the
+; old chunks and the free list is dropped, because its treenodes lie inside the old chunks.
+;
+; @RBX qword[in,out] - Pointer to the node arena.
+; @RSI qword[in] - Pointer to the current treemap.
+;
+; @return The state of the compaction or a nullptr if an allocation failed.
+startCompaction proc
+
+	push rdi
+	push r12
+	sub rsp, shadowStorage + qwordSize
+
+	mov rcx, sizeof NodeCompaction
+	call malloc
+
+	cmp rax, nullptr
+	je functionReturn
+
+	mov r12, rax
+	mov rax, [rbx].NodeArena.chunks
+	mov [r12].NodeCompaction.oldChunks, rax
+	mov rdi, [rsi].TreeMap.nodeAmount
+	mov [r12].NodeCompaction.pendingAmount, rdi
+	mov [r12].NodeCompaction.cursor, nullptr
+	mov [r12].NodeCompaction.predecessor, nullptr
+	mov [r12].NodeCompaction.depth, 0
+
+	; The chunk is allocated even for an empty tree, so that
+	; insertions never take treenodes from the old chunks.
+	call allocateReservedChunk
+
+	cmp rax, nullptr
+	jne dropFreeNodes
+
+	mov rcx, r12
+	call free
+
+	mov rax, nullptr
+
+	jmp functionReturn
+
+dropFreeNodes:
+	mov [rbx].NodeArena.freeNodes, nullptr
+	mov [rbx].NodeArena.freeNodeAmount, 0
+	mov [rbx].NodeArena.compaction, r12
+	mov rax, r12
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop r12
+	pop rdi
+	ret
+
+startCompaction endp
+
+
+; Rebuilds the stack of links that the compaction visits next. It starts at the smallest
+; treenode whose key isn't smaller than the key of the last visited treenode, or at the smallest
+; treenode of the tree if there is none. Treenodes with an equal key are visited again and skipped.
+;
+; @RSI qword[in] - Pointer to the current treemap.
+; @R12 qword[in,out] - Pointer to the state of the compaction.
+rebuildCompactionPath proc
+
+	push rbx
+	push rdi
+	sub rsp, shadowStorage + qwordSize
+
+	mov [r12].NodeCompaction.depth, 0
+	lea rdi, [rsi].TreeMap.root
+
+descend:
+	mov rbx, [rdi]
+	cmp rbx, nullptr
+	je functionReturn
+
+	mov rdx, [r12].NodeCompaction.cursor
+	cmp rdx, nullptr
+	je pushLink
+
+	; Go right if the key of the last visited treenode is bigger.
+	mov rcx, rbx
+	countTreeMapEvent rsi, comparisons
+	callUserFunc [rsi].TreeMap.compareKeyFunc
+
+	cmp eax, 0
+	jg descendRight
+
+pushLink:
+	mov rcx, [r12].NodeCompaction.depth
+	mov [r12 + rcx * qwordSize].NodeCompaction.links, rdi
+	inc [r12].NodeCompaction.depth
+
+	mov rdi, rbx
+	add rdi, [rsi].TreeMap.keySize
+	add rdi, [rsi].TreeMap.valueSize
+
+	jmp descend
+
+descendRight:
+	mov rdi, rbx
+	add rdi, [rsi].TreeMap.keySize
+	add rdi, [rsi].TreeMap.valueSize
+	add rdi, qwordSize
+
+	jmp descend
+
+functionReturn:
+	mov rax, [rsi].TreeMap.modificationCount
+	mov [r12].NodeCompaction.version, rax
+
+	add rsp, shadowStorage + qwordSize
+	pop rdi
+	pop rbx
+	ret
+
+rebuildCompactionPath endp
+
+
+; Finishes the compaction of the node arena by releasing the old chunks and the state.
+;
+; @RBX qword[in,out] - Pointer to the node arena.
+finishCompaction proc
+
+	push rdi
+	push r12
+	sub rsp, shadowStorage + qwordSize
+
+	mov r12, [rbx].NodeArena.compaction
+	mov rdi, [r12].NodeCompaction.oldChunks
+
+	; Search the link to the newest old chunk and cut the old chunks off.
+	lea rax, [rbx].NodeArena.chunks
+
+searchOldChunks:
+	cmp [rax], rdi
+	je cutOldChunks
+
+	mov rax, [rax]
+	lea rax, [rax].NodeChunk.next
+
+	jmp searchOldChunks
+
+cutOldChunks:
+	mov qword ptr [rax], nullptr
+
+releaseOldChunk:
+	cmp rdi, nullptr
+	je freeState
+
+	mov rcx, rdi
+	mov rdi, [rdi].NodeChunk.next
+
+	cmp [rcx].NodeChunk.largePages, false
+	je releaseChunk
+
+	dec [rbx].NodeArena.largePageChunks
+
+releaseChunk:
+	mov rdx, 0
+	mov r8d, memRelease
+	call VirtualFree
+
+	jmp releaseOldChunk
+
+freeState:
+	mov rcx, r12
+	call free
+
+	mov [rbx].NodeArena.compaction, nullptr
+
+	add rsp, shadowStorage + qwordSize
+	pop r12
+	pop rdi
+	ret
+
+finishCompaction endp
+
+
+; Drops a treenode that is released during a compaction. It stays inside its chunk
+; until the compaction is finished, so that the links on the stack never point at reused memory.
+;
+; @RCX qword[in] - Pointer to the released treenode.
+; @RDX qword[in,out] - Pointer to the node arena.
+dropCompactedTreeNode proc
+
+	mov r10, [rdx].NodeArena.compaction
+
+	; The key of a released treenode can't be compared anymore, so the compaction continues
+	; behind the predecessor that the deletion found. Other releases start over from the smallest key.
+	cmp [r10].NodeCompaction.cursor, rcx
+	jne countTreeNode
+
+	mov rax, [r10].NodeCompaction.predecessor
+	mov [r10].NodeCompaction.cursor, rax
+
+countTreeNode:
+	call isRelocatedTreeNode
+
+	cmp al, true
+	je functionReturn
+
+	dec [r10].NodeCompaction.pendingAmount
+
+functionReturn:
+	ret
+
+dropCompactedTreeNode endp
+
+
+; Searches the in-order predecessor of the cursor of a running compaction before a deletion,
+; while the key of the cursor can still be compared. If the deletion releases the cursor,
+; dropCompactedTreeNode moves the cursor to the predecessor instead of restarting the walk.
+;
+; @RSI qword[in] - Pointer to the current treemap.
+findCursorPredecessor proc
+
+	push rbx
+	push rdi
+	push r12
+	sub rsp, shadowStorage
+
+	mov rax, [rsi].TreeMap.nodeArena
+	cmp rax, nullptr
+	je functionReturn
+
+	mov r12, [rax].NodeArena.compaction
+	cmp r12, nullptr
+	je functionReturn
+
+	mov [r12].NodeCompaction.predecessor, nullptr
+	mov rdi, [r12].NodeCompaction.cursor
+	cmp rdi, nullptr
+	je functionReturn
+
+	; Search the treenode with the biggest key below the key of the cursor.
+	mov rbx, [rsi].TreeMap.root
+
+compareKey:
+	cmp rbx, nullptr
+	je functionReturn
+
+	mov rcx, rbx
+	mov rdx, rdi
+	countTreeMapEvent rsi, comparisons
+	callUserFunc [rsi].TreeMap.compareKeyFunc
+
+	mov rcx, rbx
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+
+	; Treenodes with a smaller key are candidates, the right subtree can hold bigger ones.
+	cmp eax, 0
+	jle descendLeft
+
+	mov [r12].NodeCompaction.predecessor, rbx
+	mov rbx, [rcx].TreeNode.right
+
+	jmp compareKey
+
+descendLeft:
+	mov rbx, [rcx].TreeNode.left
+
+	jmp compareKey
+
+functionReturn:
+	add rsp, shadowStorage
+	pop r12
+	pop rdi
+	pop rbx
+	ret
+
+findCursorPredecessor endp
+
+
+; Tests if a treenode lies inside one of the chunks that were allocated during the compaction.
+;
+; @RCX qword[in] - Pointer to the treenode.
+; @RDX qword[in] - Pointer to the node arena.
+;
+; @return True if the treenode lies inside a new chunk, otherwise false.
+isRelocatedTreeNode proc
+
+	mov r8, [rdx].NodeArena.compaction
+	mov r8, [r8].NodeCompaction.oldChunks
+	mov r9, [rdx].NodeArena.chunks
+
+testChunk:
+	mov eax, false
+	cmp r9, r8
+	je functionReturn
+
+	cmp rcx, r9
+	jb nextChunk
+
+	mov rax, r9
+	add rax, [r9].NodeChunk.capacity
+	cmp rcx, rax
+	mov eax, true
+	jb functionReturn
+
+nextChunk:
+	mov r9, [r9].NodeChunk.next
+
+	jmp testChunk
+
+functionReturn:
+	ret
+
+isRelocatedTreeNode endp
+
+end
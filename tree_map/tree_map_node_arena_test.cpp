@@ -0,0 +1,508 @@
+/*
+* @file tree_map_node_arena_test.h
+*
+* Defines unit tests for the node arena of the tree map
+* implementation.
+*
+* @author Collector
+* @data 03/09/2023
+*/
+
+
+#include "utils.h"
+
+namespace {
+	/*
+	* Counts the chunks of a node arena.
+	*
+	* @param[in] arena - Node arena whose chunks are counted.
+	*
+	* @return The count of chunks.
+	*/
+	size_t countChunks(const NodeArena* arena) {
+		size_t amount{ 0 };
+
+		for (void* chunk{ arena->chunks }; chunk != nullptr; chunk = *reinterpret_cast<void**>(chunk)) {
+			amount++;
+		}
+
+		return amount;
+	}
+
+	/*
+	* Collects the treenodes of a tree in order.
+	*
+	* @param[in] node - Root of the subtree that is collected.
+	* @param[out] nodes - Vector that receives the treenodes.
+	*/
+	void collectTreeNodes(TreeNode* node, std::vector<TreeNode*>& nodes) {
+		if (node == nullptr) {
+			return;
+		}
+
+		collectTreeNodes(node->left, nodes);
+		nodes.push_back(node);
+		collectTreeNodes(node->right, nodes);
+	}
+
+	/*
+	* Creates a treemap with a node arena whose chunks hold two treenodes each and
+	* scatters its treenodes by deleting and inserting pairs.
+	*
+	* @return The treemap with scattered treenodes.
+	*/
+	TreeMap* createScatteredTree() {
+		size_t stride{ (sizeof(TreeNodeKey) + sizeof(TreeNodeValue) + 3 * sizeof(void*) + 7) & ~size_t{ 7 } };
+		TreeMap* tm{ createTestNodeArenaTree(64 + 2 * stride, 0) };
+		TreeNode* node{ createTreeNode("Washington", "Olympia", 1889, 7705281, false) };
+		std::vector<TreeNode*> nodes{
+			createTreeNode("Texas", "Austin", 1845, 29145505, false),
+			createTreeNode("Alaska", "Juneau", 1959, 733391, false),
+			createTreeNode("Ohio", "Columbus", 1803, 11799448, false),
+		};
+
+		deletePair(tm, &node->pair.key, nullptr);
+
+		for (TreeNode* n : nodes) {
+			putPair(tm, &n->pair);
+		}
+
+		putPair(tm, &node->pair);
+
+		nodes.push_back(node);
+		freeTreeNodes(nodes);
+
+		return tm;
+	}
+
+	/*
+	* Asserts that the treenodes of a compacted treemap lie inside a single chunk
+	* and that all pairs can be found.
+	*
+	* @param[in] tm - Compacted treemap.
+	* @param[in] states - Names of the states that the treemap holds.
+	* @param[in] inOrder - Indicator if the treenodes have to lie in order. Treenodes inserted
+	*					   during the compaction are placed between the relocated ones.
+	*/
+	void assertCompactedTree(TreeMap* tm, const std::vector<const char*>& states, bool inOrder) {
+		std::vector<TreeNode*> nodes;
+
+		collectTreeNodes(reinterpret_cast<TreeNode*>(tm->root), nodes);
+
+		ASSERT_EQ(nullptr, tm->nodeArena->compaction);
+		ASSERT_EQ(1, countChunks(tm->nodeArena));
+		ASSERT_EQ(states.size(), nodes.size());
+
+		for (size_t i{ 1 }; inOrder && i < nodes.size(); i++) {
+			ASSERT_LT(reinterpret_cast<char*>(nodes[i - 1]), reinterpret_cast<char*>(nodes[i]));
+		}
+
+		for (const char* state : states) {
+			TreeNodeKey* key{ createTreeNodeKey(state) };
+
+			ASSERT_EQ(Status::SUCCESS, containsKey(tm, key));
+
+			freeTreeNodeKeys({ key });
+		}
+	}
+}
+
+TEST(TreeMap, createNodeArenaShouldFailForTreeMapNullptr) {
+	Status s;
+
+	s = createNodeArena(nullptr, 4096, 0);
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, s);
+}
+
+TEST(TreeMap, createNodeArenaShouldFailForNonEmptyTreeMap) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+
+	s = createNodeArena(tm, 4096, 0);
+
+	ASSERT_EQ(Status::TREE_MAP_NOT_EMPTY, s);
+	ASSERT_EQ(nullptr, tm->nodeArena);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, createNodeArenaShouldFailIfArenaExists) {
+	Status s;
+	TreeMap* tm{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeTreeNodePair, &s) };
+
+	s = createNodeArena(tm, 4096, 0);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	NodeArena* arena{ tm->nodeArena };
+
+	s = createNodeArena(tm, 4096, 0);
+
+	ASSERT_EQ(Status::NODE_ARENA_EXISTS, s);
+	ASSERT_EQ(arena, tm->nodeArena);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, createNodeArenaShouldFailForTooSmallChunks) {
+	Status s;
+	TreeMap* tm{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeTreeNodePair, &s) };
+
+	// The header of a chunk takes the first 64 bytes.
+	s = createNodeArena(tm, 64, 0);
+
+	ASSERT_EQ(Status::CHUNK_SIZE_TOO_SMALL, s);
+	ASSERT_EQ(nullptr, tm->nodeArena);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, createNodeArenaShouldRejectInlinePairs) {
+	Status s;
+	TreeMap* tm{ createTreeMap(sizeof(InlineData), sizeof(InlineData), compareInlineData,
+		equalsInlineData, copyInlineKey, copyInlineValue, nullptr, &s) };
+
+	setTreeMapFlags(tm, TreeMapFlags::INLINE_PAIRS);
+
+	s = createNodeArena(tm, 4096, 0);
+
+	ASSERT_EQ(Status::INLINE_SIZE_MISMATCH, s);
+
+	setTreeMapFlags(tm, 0);
+	createNodeArena(tm, 4096, 0);
+
+	s = setTreeMapFlags(tm, TreeMapFlags::INLINE_PAIRS);
+
+	ASSERT_EQ(Status::INLINE_SIZE_MISMATCH, s);
+	ASSERT_EQ(0, tm->flags);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, putPairShouldTakeTreeNodesFromChunk) {
+	Status s;
+	TreeMap* tm{ createTestNodeArenaTree(4096, 0) };
+	NodeArena* arena{ tm->nodeArena };
+	char* chunk{ reinterpret_cast<char*>(arena->chunks) };
+	char* root{ reinterpret_cast<char*>(tm->root) };
+	size_t stride{ (sizeof(TreeNodeKey) + sizeof(TreeNodeValue) + 3 * sizeof(void*) + 7) & ~size_t{ 7 } };
+
+	ASSERT_EQ(stride, arena->nodeStride);
+	ASSERT_EQ(1, countChunks(arena));
+	ASSERT_EQ(64 + 5 * stride, arena->chunkUsed);
+	ASSERT_LE(chunk + 64, root);
+	ASSERT_GT(chunk + arena->chunkUsed, root);
+	ASSERT_EQ(0, (root - chunk - 64) % stride);
+
+	TreeNode* expectedRoot{ createTreeNode("Oregon", "Salem", 1859, 4237256, false) };
+	TreeNodeValue result;
+
+	s = getValue(tm, &expectedRoot->pair.key, &result);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertTreeNodeValueEquals(&expectedRoot->pair.value, &result);
+
+	free(result.capitalCity);
+
+	freeTreeNodes({ expectedRoot });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, putPairShouldAlignTreeNodesOnCacheLines) {
+	TreeMap* tm{ createTestNodeArenaTree(4096, NodeArenaFlags::CACHE_LINE_ALIGNED) };
+	NodeArena* arena{ tm->nodeArena };
+
+	ASSERT_EQ(0, arena->nodeStride % 64);
+	ASSERT_EQ(64 + 5 * arena->nodeStride, arena->chunkUsed);
+	ASSERT_EQ(0, reinterpret_cast<size_t>(tm->root) % 64);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, putPairShouldAllocateNewChunks) {
+	Status s;
+	TreeMap* tm{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeTreeNodePair, &s) };
+	size_t stride{ (sizeof(TreeNodeKey) + sizeof(TreeNodeValue) + 3 * sizeof(void*) + 7) & ~size_t{ 7 } };
+
+	// Every chunk holds two treenodes.
+	createNodeArena(tm, 64 + 2 * stride, 0);
+
+	std::vector<TreeNode*> nodes{
+		createTreeNode("Washington", "Olympia", 1889, 7705281, false),
+		createTreeNode("Oregon", "Salem", 1859, 4237256, false),
+		createTreeNode("New York", "Albany", 1788, 20201249, false),
+		createTreeNode("Minnesota", "Saint Paul", 1858, 5706494, false),
+		createTreeNode("Kansas", "Topeka", 1861, 2937880, false),
+	};
+
+	for (TreeNode* node : nodes) {
+		s = putPair(tm, &node->pair);
+
+		ASSERT_EQ(Status::SUCCESS, s);
+	}
+
+	ASSERT_EQ(3, countChunks(tm->nodeArena));
+	ASSERT_EQ(64 + stride, tm->nodeArena->chunkUsed);
+
+	for (TreeNode* node : nodes) {
+		TreeNodeValue result;
+
+		s = getValue(tm, &node->pair.key, &result);
+
+		ASSERT_EQ(Status::SUCCESS, s);
+		assertTreeNodeValueEquals(&node->pair.value, &result);
+
+		free(result.capitalCity);
+	}
+
+	freeTreeNodes(nodes);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, deletePairShouldReuseTreeNodesOfArena) {
+	Status s;
+	TreeMap* tm{ createTestNodeArenaTree(4096, 0) };
+	NodeArena* arena{ tm->nodeArena };
+	size_t chunkUsed{ arena->chunkUsed };
+	TreeNode* node{ createTreeNode("Kansas", "Topeka", 1861, 2937880, false) };
+
+	s = deletePair(tm, &node->pair.key, nullptr);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_NE(nullptr, arena->freeNodes);
+	ASSERT_EQ(nullptr, tm->spareTreeNode);
+
+	s = putPair(tm, &node->pair);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(nullptr, arena->freeNodes);
+	ASSERT_EQ(chunkUsed, arena->chunkUsed);
+	ASSERT_EQ(5, tm->nodeAmount);
+
+	freeTreeNodes({ node });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, clearTreeMapShouldReleaseChunksOfArena) {
+	Status s;
+	TreeMap* tm{ createTestNodeArenaTree(4096, 0) };
+	NodeArena* arena{ tm->nodeArena };
+
+	s = clearTreeMap(tm);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(arena, tm->nodeArena);
+	ASSERT_EQ(nullptr, arena->chunks);
+	ASSERT_EQ(nullptr, arena->freeNodes);
+	ASSERT_EQ(0, arena->chunkUsed);
+	ASSERT_EQ(0, tm->nodeAmount);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, createNodeArenaShouldFallBackToNormalPages) {
+	TreeMap* tm{ createTestNodeArenaTree(4096, NodeArenaFlags::LARGE_PAGES | NodeArenaFlags::CACHE_LINE_ALIGNED) };
+	NodeArena* arena{ tm->nodeArena };
+
+	// The chunk size is a multiple of the large page size, whether the chunk
+	// is backed by large pages depends on the privileges of the process.
+	ASSERT_LE(4096, arena->chunkSize);
+	ASSERT_LE(arena->largePageChunks, countChunks(arena));
+	ASSERT_EQ(5, tm->nodeAmount);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, reserveTreeMapShouldFailForTreeMapNullptr) {
+	Status s;
+
+	s = reserveTreeMap(nullptr, 16);
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, s);
+}
+
+TEST(TreeMap, reserveTreeMapShouldFailForTreeNodesWithoutArena) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+
+	s = reserveTreeMap(tm, 16);
+
+	ASSERT_EQ(Status::TREE_MAP_NOT_EMPTY, s);
+	ASSERT_EQ(nullptr, tm->nodeArena);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, reserveTreeMapShouldCreateArenaForEmptyTreeMap) {
+	Status s;
+	TreeMap* tm{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeTreeNodePair, &s) };
+
+	s = reserveTreeMap(tm, 5000);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_NE(nullptr, tm->nodeArena);
+	ASSERT_EQ(1, countChunks(tm->nodeArena));
+
+	NodeArena* arena{ tm->nodeArena };
+	size_t capacity{ reinterpret_cast<size_t*>(arena->chunks)[1] };
+
+	ASSERT_LE(64 + 5000 * arena->nodeStride, capacity);
+	ASSERT_EQ(0, capacity % arena->chunkSize);
+
+	std::vector<TreeNode*> nodes{
+		createTreeNode("Washington", "Olympia", 1889, 7705281, false),
+		createTreeNode("Oregon", "Salem", 1859, 4237256, false),
+		createTreeNode("New York", "Albany", 1788, 20201249, false),
+		createTreeNode("Minnesota", "Saint Paul", 1858, 5706494, false),
+		createTreeNode("Kansas", "Topeka", 1861, 2937880, false),
+	};
+
+	for (TreeNode* node : nodes) {
+		putPair(tm, &node->pair);
+	}
+
+	ASSERT_EQ(1, countChunks(arena));
+	ASSERT_EQ(5, tm->nodeAmount);
+
+	freeTreeNodes(nodes);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, reserveTreeMapShouldCountFreeAndRemainingTreeNodes) {
+	Status s;
+	size_t stride{ (sizeof(TreeNodeKey) + sizeof(TreeNodeValue) + 3 * sizeof(void*) + 7) & ~size_t{ 7 } };
+
+	// The chunk has room for three more treenodes.
+	TreeMap* tm{ createTestNodeArenaTree(64 + 8 * stride, 0) };
+	NodeArena* arena{ tm->nodeArena };
+	TreeNode* node{ createTreeNode("Kansas", "Topeka", 1861, 2937880, false) };
+
+	deletePair(tm, &node->pair.key, nullptr);
+
+	s = reserveTreeMap(tm, 4);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(1, countChunks(arena));
+	ASSERT_EQ(1, arena->freeNodeAmount);
+
+	// The rest of the chunk is put on the free list for a bigger reservation.
+	s = reserveTreeMap(tm, 10);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(2, countChunks(arena));
+	ASSERT_EQ(4, arena->freeNodeAmount);
+	ASSERT_EQ(64, arena->chunkUsed);
+	ASSERT_LE(64 + 6 * stride, reinterpret_cast<size_t*>(arena->chunks)[1]);
+
+	s = putPair(tm, &node->pair);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(3, arena->freeNodeAmount);
+	ASSERT_EQ(64, arena->chunkUsed);
+
+	freeTreeNodes({ node });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, compactTreeMapShouldFailForNullptrs) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+
+	s = compactTreeMap(nullptr, 0);
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, s);
+
+	s = compactTreeMap(tm, 0);
+
+	ASSERT_EQ(Status::NODE_ARENA_NULLPTR, s);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, compactTreeMapShouldRelocateTreeNodesInOrder) {
+	Status s;
+	TreeMap* tm{ createScatteredTree() };
+
+	ASSERT_LT(1, countChunks(tm->nodeArena));
+
+	s = compactTreeMap(tm, 0);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertCompactedTree(tm, { "Alaska", "Kansas", "Minnesota", "New York", "Ohio", "Oregon", "Texas", "Washington" }, true);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, compactTreeMapShouldRunInSlices) {
+	Status s;
+	TreeMap* tm{ createScatteredTree() };
+	size_t calls{ 0 };
+
+	do {
+		s = compactTreeMap(tm, 3);
+		calls++;
+	} while (s == Status::COMPACTION_PENDING);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(3, calls);
+	assertCompactedTree(tm, { "Alaska", "Kansas", "Minnesota", "New York", "Ohio", "Oregon", "Texas", "Washington" }, true);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, compactTreeMapShouldContinueBehindDeletedCursor) {
+	Status s;
+	TreeMap* tm{ createScatteredTree() };
+	TreeNodeKey* newYork{ createTreeNodeKey("New York") };
+
+	// The cursor stops at New York, the fourth key.
+	s = compactTreeMap(tm, 4);
+
+	ASSERT_EQ(Status::COMPACTION_PENDING, s);
+
+	s = deletePair(tm, newYork, nullptr);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	// Minnesota and the four keys behind it fit into the budget, a walk from Alaska wouldn't.
+	s = compactTreeMap(tm, 6);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertCompactedTree(tm, { "Alaska", "Kansas", "Minnesota", "Ohio", "Oregon", "Texas", "Washington" }, true);
+
+	freeTreeNodeKeys({ newYork });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, compactTreeMapShouldContinueAfterModifications) {
+	Status s;
+	TreeMap* tm{ createScatteredTree() };
+	TreeNode* node{ createTreeNode("Utah", "Salt Lake City", 1896, 3271616, false) };
+	TreeNodeKey* alaska{ createTreeNodeKey("Alaska") }, * texas{ createTreeNodeKey("Texas") };
+
+	s = compactTreeMap(tm, 2);
+
+	ASSERT_EQ(Status::COMPACTION_PENDING, s);
+	ASSERT_NE(nullptr, tm->nodeArena->compaction);
+
+	// Delete a relocated and a pending treenode and insert a new one.
+	deletePair(tm, alaska, nullptr);
+	deletePair(tm, texas, nullptr);
+	putPair(tm, &node->pair);
+
+	do {
+		s = compactTreeMap(tm, 2);
+	} while (s == Status::COMPACTION_PENDING);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertCompactedTree(tm, { "Kansas", "Minnesota", "New York", "Ohio", "Oregon", "Utah", "Washington" }, false);
+
+	freeTreeNodes({ node });
+	freeTreeNodeKeys({ alaska, texas });
+	deleteTreeMap(tm);
+}
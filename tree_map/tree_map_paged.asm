@@ -0,0 +1,1710 @@
+; @file tree_map_paged.asm
+;
+; Defines the paged treemaps. A paged treemap is a file whose treenodes are packed into pages
+; of 4 to 16 KB and that is searched through a buffer pool of a fixed amount of pages, so the map
+; can be far bigger than the memory. A page holds the top levels of a subtree, which makes a search
+; read a page for every few levels of the tree instead of one for every treenode. The subtrees below
+; these levels that fit into a page are packed together into shared pages, so the pages stay full.
+;
+; The first page holds a PagedHeader. The other pages follow it in pre-order with the subtrees
+; of smaller keys first, so a scan in key order reads the pages in the order of the file.
+; The pool replaces its pages with the clock algorithm and skips the pinned pages that a search
+; still uses. A miss right behind the previous miss reads the following pages with a single request.
+;
+; @author Collector
+; @date 03/09/2023
+
+	include tree_map.inc
+
+	.code
+
+
+	public savePagedTreeMap
+
+; Writes the treenodes of the treemap into the pages of the file. The pairs are copied byte by byte,
+; so they must not hold pointers.
+;
+; @RCX qword[in,out] - Pointer to the treemap that is saved.
+; @RDX qword[in,out] - FILE pointer the pages are written to.
+; @R8 qword[in] - Size of a page, a power of two from 4 KB to 16 KB.
+;
+; @return A status value for success, fileNullptr, pageSizeInvalid, inlineSizeMismatch for inline pairs,
+;		  valueDictionaryExists, errFileIo, errHeapAllocation or treeMapNullptr.
+savePagedTreeMap proc
+
+	push rsi
+	push rdi
+	push r12
+	sub rsp, shadowStorage + sizeof PagedWriter
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the file is a nullptr.
+	mov eax, fileNullptr
+	cmp rdx, nullptr
+	je functionReturn
+
+	; The page size has to be a power of two inside the supported range.
+	mov eax, pageSizeInvalid
+	cmp r8, minPageSize
+	jb functionReturn
+
+	cmp r8, maxPageSize
+	ja functionReturn
+
+	lea r9, [r8 - 1]
+	test r9, r8
+	jnz functionReturn
+
+	; The pairs of inline treenodes and interned values point outside of the treenodes.
+	mov eax, inlineSizeMismatch
+	test [rcx].TreeMap.flags, inlinePairsFlag
+	jnz functionReturn
+
+	mov eax, valueDictionaryExists
+	cmp [rcx].TreeMap.valueDictionary, nullptr
+	jne functionReturn
+
+	; Save the treemap and prepare the writer.
+	mov rsi, rcx
+	lea r12, [rsp + shadowStorage]
+	mov [r12].PagedWriter.file, rdx
+	mov [r12].PagedWriter.pageSize, r8
+
+	; Every treenode of a page starts on a quadword boundary.
+	mov rax, [rsi].TreeMap.keySize
+	add rax, [rsi].TreeMap.valueSize
+	mov [r12].PagedWriter.pairSize, rax
+	add rax, sizeof PagedTreeNode + qwordSize - 1
+	and rax, -qwordSize
+	mov [r12].PagedWriter.nodeStride, rax
+
+	mov rcx, rax
+	mov rax, r8
+	xor edx, edx
+	div rcx
+
+	; A page has to hold at least one treenode.
+	cmp rax, 0
+	je pageSizeError
+
+	; A page takes as many full levels of a subtree as fit into its slots.
+	mov [r12].PagedWriter.slotAmount, rax
+	inc rax
+	bsr rax, rax
+	mov [r12].PagedWriter.pageLevels, rax
+	mov [r12].PagedWriter.pageAmount, 0
+	mov [r12].PagedWriter.status, success
+
+	; Spilled treenodes are faulted back in before the tree is walked.
+	mov rcx, rsi
+	call restoreSpilledTreeMap
+
+	cmp eax, success
+	jne functionReturn
+
+	; The pages of the subtrees are written first, the header knows their amount afterwards.
+	mov edi, 0
+	mov rcx, [rsi].TreeMap.root
+	cmp rcx, nullptr
+	je writeHeader
+
+	call writePagedSubtree
+
+	mov rdi, rax
+
+	cmp [r12].PagedWriter.status, success
+	jne returnStatus
+
+writeHeader:
+	; The header page is zeroed behind the header.
+	mov ecx, 1
+	mov rdx, [r12].PagedWriter.pageSize
+	call calloc
+
+	cmp rax, nullptr
+	je heapAllocationError
+
+	mov rcx, rax
+	mov rax, pagedMagic
+	mov [rcx].PagedHeader.magic, rax
+	mov [rcx].PagedHeader.version, pagedVersion
+	mov rax, [rsi].TreeMap.keySize
+	mov [rcx].PagedHeader.keySize, rax
+	mov rax, [rsi].TreeMap.valueSize
+	mov [rcx].PagedHeader.valueSize, rax
+	mov rax, [rsi].TreeMap.nodeAmount
+	mov [rcx].PagedHeader.nodeAmount, rax
+	mov rax, [r12].PagedWriter.nodeStride
+	mov [rcx].PagedHeader.nodeStride, rax
+	mov rax, [r12].PagedWriter.pageSize
+	mov [rcx].PagedHeader.pageSize, rax
+	mov rax, [r12].PagedWriter.pageAmount
+	mov [rcx].PagedHeader.pageAmount, rax
+	mov [rcx].PagedHeader.root, rdi
+
+	; RSI holds the header page from now on.
+	mov rsi, rcx
+
+	; The checksum of the header covers every field before it.
+	mov edx, sizeof PagedHeader - qwordSize
+	mov r8, fnvOffsetBasis
+	call hashSnapshotBytes
+
+	mov [rsi].PagedHeader.checksum, rax
+
+	mov rcx, [r12].PagedWriter.file
+	mov edx, 0
+	mov r8d, seekSet
+	call _fseeki64
+
+	mov [r12].PagedWriter.status, errFileIo
+	cmp eax, 0
+	jne freeHeader
+
+	mov rcx, rsi
+	mov edx, 1
+	mov r8, [r12].PagedWriter.pageSize
+	mov r9, [r12].PagedWriter.file
+	call fwrite
+
+	cmp rax, [r12].PagedWriter.pageSize
+	jne freeHeader
+
+	mov [r12].PagedWriter.status, success
+
+freeHeader:
+	mov rcx, rsi
+	call free
+
+returnStatus:
+	mov rax, [r12].PagedWriter.status
+
+	jmp functionReturn
+
+pageSizeError:
+	mov eax, pageSizeInvalid
+
+	jmp functionReturn
+
+heapAllocationError:
+	mov eax, errHeapAllocation
+
+functionReturn:
+	add rsp, shadowStorage + sizeof PagedWriter
+	pop r12
+	pop rdi
+	pop rsi
+	ret
+
+savePagedTreeMap endp
+
+
+; Writes the subtree into a new page and the pages behind it. The page takes the next index,
+; so the pages of a subtree follow its first page in pre-order.
+;
+; @RCX qword[in] - Pointer to the root treenode of the subtree.
+; @RSI qword[in] - Pointer to the treemap that is saved.
+; @R12 qword[in,out] - Pointer to the writer whose status is set if a page can't be written.
+;
+; @return The link of the root treenode of the subtree.
+writePagedSubtree proc
+
+	push rbx
+	push r13
+	push r14
+	sub rsp, shadowStorage + 2 * sizeof PagedBuild
+
+	; Nothing is written anymore after a failure.
+	mov eax, 0
+	cmp [r12].PagedWriter.status, success
+	jne functionReturn
+
+	mov rbx, rcx
+	lea r13, [rsp + shadowStorage]
+	lea r14, [rsp + shadowStorage + sizeof PagedBuild]
+
+	; The shared page takes the small subtrees below the page and is opened when the first one arrives.
+	mov [r14].PagedBuild.buffer, nullptr
+	mov [r14].PagedBuild.pageLevels, -1
+	mov [r14].PagedBuild.shared, nullptr
+
+	mov rcx, r13
+	call openPagedPage
+
+	mov eax, 0
+	cmp [r13].PagedBuild.buffer, nullptr
+	je functionReturn
+
+	mov rax, [r12].PagedWriter.pageLevels
+	mov [r13].PagedBuild.pageLevels, rax
+	mov [r13].PagedBuild.shared, r14
+
+	mov rcx, rbx
+	mov edx, 0
+	mov r8, r13
+	call fillPagedSlots
+
+	mov rbx, rax
+
+	mov rcx, r14
+	call closePagedPage
+
+	mov rcx, r13
+	call closePagedPage
+
+	mov rax, rbx
+
+functionReturn:
+	add rsp, shadowStorage + 2 * sizeof PagedBuild
+	pop r14
+	pop r13
+	pop rbx
+	ret
+
+writePagedSubtree endp
+
+
+; Starts a page with the next index. The page is zeroed, so its free slots are written deterministically.
+;
+; @RCX qword[out] - Pointer to the page whose buffer is allocated.
+; @R12 qword[in,out] - Pointer to the writer whose status is set if the allocation fails.
+openPagedPage proc
+
+	push rbx
+	sub rsp, shadowStorage
+
+	mov rbx, rcx
+
+	mov ecx, 1
+	mov rdx, [r12].PagedWriter.pageSize
+	call calloc
+
+	mov [rbx].PagedBuild.buffer, rax
+	cmp rax, nullptr
+	je heapAllocationError
+
+	mov rax, [r12].PagedWriter.pageAmount
+	mov [rbx].PagedBuild.pageIndex, rax
+	mov [rbx].PagedBuild.usedSlots, 0
+	inc [r12].PagedWriter.pageAmount
+
+	jmp functionReturn
+
+heapAllocationError:
+	mov [r12].PagedWriter.status, errHeapAllocation
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rbx
+	ret
+
+openPagedPage endp
+
+
+; Writes the page into the file behind the header page and frees its buffer.
+; A page that isn't open is skipped and nothing is written after a failure.
+;
+; @RCX qword[in,out] - Pointer to the page.
+; @R12 qword[in,out] - Pointer to the writer whose status is set if the page can't be written.
+closePagedPage proc
+
+	push rbx
+	sub rsp, shadowStorage
+
+	mov rbx, rcx
+	cmp [rbx].PagedBuild.buffer, nullptr
+	je functionReturn
+
+	cmp [r12].PagedWriter.status, success
+	jne freePage
+
+	mov rdx, [rbx].PagedBuild.pageIndex
+	inc rdx
+	imul rdx, [r12].PagedWriter.pageSize
+	mov rcx, [r12].PagedWriter.file
+	mov r8d, seekSet
+	call _fseeki64
+
+	cmp eax, 0
+	jne fileError
+
+	mov rcx, [rbx].PagedBuild.buffer
+	mov edx, 1
+	mov r8, [r12].PagedWriter.pageSize
+	mov r9, [r12].PagedWriter.file
+	call fwrite
+
+	cmp rax, [r12].PagedWriter.pageSize
+	je freePage
+
+fileError:
+	mov [r12].PagedWriter.status, errFileIo
+
+freePage:
+	mov rcx, [rbx].PagedBuild.buffer
+	call free
+
+	mov [rbx].PagedBuild.buffer, nullptr
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rbx
+	ret
+
+closePagedPage endp
+
+
+; Copies the treenode into the next slot of the page and links its children. Children above
+; the levels of the page are copied into the page as well, deeper ones start new subtrees.
+;
+; @RCX qword[in] - Pointer to the treenode.
+; @RDX qword[in] - Level of the treenode inside the page.
+; @R8 qword[in,out] - Pointer to the page that is filled.
+; @RSI qword[in] - Pointer to the treemap that is saved.
+; @R12 qword[in,out] - Pointer to the writer.
+;
+; @return The link of the treenode.
+fillPagedSlots proc
+
+	push rbx
+	push rdi
+	push r13
+	push r14
+	push r15
+	sub rsp, shadowStorage
+
+	; Save the treenode, the page and the level of the children.
+	mov rbx, rcx
+	mov r13, r8
+	lea r14, [rdx + 1]
+
+	; Take the next slot of the page.
+	mov rax, [r13].PagedBuild.usedSlots
+	inc [r13].PagedBuild.usedSlots
+
+	mov rdi, rax
+	imul rdi, [r12].PagedWriter.nodeStride
+	add rdi, [r13].PagedBuild.buffer
+
+	mov r15, [r13].PagedBuild.pageIndex
+	imul r15, [r12].PagedWriter.slotAmount
+	lea r15, [r15 + rax + 1]
+
+	mov rcx, rdi
+	mov rdx, rbx
+	mov r8, [r12].PagedWriter.pairSize
+	call memcpy
+
+	; Link the left child before the right one, so the smaller keys get the smaller pages.
+	add rbx, [r12].PagedWriter.pairSize
+	add rdi, [r12].PagedWriter.pairSize
+
+	mov rcx, [rbx].TreeNode.left
+	mov rdx, r14
+	mov r8, r13
+	call linkPagedChild
+
+	mov [rdi].PagedTreeNode.left, rax
+
+	mov rcx, [rbx].TreeNode.right
+	mov rdx, r14
+	mov r8, r13
+	call linkPagedChild
+
+	mov [rdi].PagedTreeNode.right, rax
+
+	mov rax, r15
+
+	add rsp, shadowStorage
+	pop r15
+	pop r14
+	pop r13
+	pop rdi
+	pop rbx
+	ret
+
+fillPagedSlots endp
+
+
+; Copies the child into the page if it lies inside its levels. Below them a subtree that fits into a page
+; is copied as a whole into the shared page of the page, a bigger one gets pages of its own. The shared page
+; is closed in front of a bigger subtree, so the pages keep the order of their keys.
+;
+; @RCX qword[in] - Pointer to the child or a nullptr.
+; @RDX qword[in] - Level of the child inside the page.
+; @R8 qword[in,out] - Pointer to the page of the parent.
+; @RSI qword[in] - Pointer to the treemap that is saved.
+; @R12 qword[in,out] - Pointer to the writer.
+;
+; @return The link of the child or zero for a missing child.
+linkPagedChild proc
+
+	push rbx
+	push rdi
+	push r13
+	sub rsp, shadowStorage
+
+	mov eax, 0
+	cmp rcx, nullptr
+	je functionReturn
+
+	cmp [r12].PagedWriter.status, success
+	jne functionReturn
+
+	; Save the child, its level and the page.
+	mov rbx, rcx
+	mov rdi, rdx
+	mov r13, r8
+
+	cmp rdi, [r13].PagedBuild.pageLevels
+	jb fillPage
+
+	; The child starts a subtree below the page.
+	call countPagedSubtree
+
+	mov r13, [r13].PagedBuild.shared
+	cmp rax, [r12].PagedWriter.slotAmount
+	ja startPages
+
+	add rax, [r13].PagedBuild.usedSlots
+	cmp [r13].PagedBuild.buffer, nullptr
+	je openSharedPage
+
+	cmp rax, [r12].PagedWriter.slotAmount
+	jbe fillSharedPage
+
+	mov rcx, r13
+	call closePagedPage
+
+openSharedPage:
+	mov rcx, r13
+	call openPagedPage
+
+	mov eax, 0
+	cmp [r13].PagedBuild.buffer, nullptr
+	je functionReturn
+
+fillSharedPage:
+	mov rcx, rbx
+	mov edx, 0
+	mov r8, r13
+	call fillPagedSlots
+
+	jmp functionReturn
+
+startPages:
+	mov rcx, r13
+	call closePagedPage
+
+	mov rcx, rbx
+	call writePagedSubtree
+
+	jmp functionReturn
+
+fillPage:
+	mov rcx, rbx
+	mov rdx, rdi
+	mov r8, r13
+	call fillPagedSlots
+
+functionReturn:
+	add rsp, shadowStorage
+	pop r13
+	pop rdi
+	pop rbx
+	ret
+
+linkPagedChild endp
+
+
+; Counts the treenodes of the subtree.
+;
+; @RCX qword[in] - Pointer to the root treenode of the subtree or a nullptr.
+; @RSI qword[in] - Pointer to the treemap that is saved.
+;
+; @return The amount of treenodes.
+countPagedSubtree proc
+
+	push rbx
+	push rdi
+	sub rsp, shadowStorage + qwordSize
+
+	mov eax, 0
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rbx, rcx
+	add rbx, [rsi].TreeMap.keySize
+	add rbx, [rsi].TreeMap.valueSize
+
+	mov rcx, [rbx].TreeNode.left
+	call countPagedSubtree
+
+	mov rdi, rax
+
+	mov rcx, [rbx].TreeNode.right
+	call countPagedSubtree
+
+	lea rax, [rax + rdi + 1]
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rdi
+	pop rbx
+	ret
+
+countPagedSubtree endp
+
+
+	public openPagedTreeMap
+
+; Opens the paged treemap inside the file with an empty buffer pool. Only the header is read,
+; the pages are read when a search reaches them.
+;
+; @RCX qword[in,out] - FILE pointer that was opened in binary mode for reading and optionally writing.
+; @RDX qword[in] - Pointer to the function that compares treenodes by their keys.
+; @R8 qword[in] - Amount of pages the buffer pool holds, at least minPoolPages.
+; @R9 qword[in] - Amount of pages that are read ahead during a scan, at most half of the pool.
+; @STACK qword[out] - Pointer to a status code which is set to success if the treemap is opened.
+;
+; @return The paged treemap or a nullptr. The status is set to fileNullptr, keyCompFuncNullptr,
+;		  poolSizeInvalid, errFileIo, snapshotInvalid if the file isn't a paged treemap or
+;		  errHeapAllocation. Without a status pointer the function fails silently.
+openPagedTreeMap proc
+
+	push rbp
+	mov rbp, rsp
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	push r13
+	push r14
+	sub rsp, shadowStorage + sizeof PagedHeader
+
+	mov rax, nullptr
+
+	; Check if a status pointer was given, otherwise fail silently.
+	mov rdi, [rbp + pagedStatusPtr]
+	cmp rdi, nullptr
+	je functionReturn
+
+	; Check if the file is a nullptr.
+	mov dword ptr [rdi], fileNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the key comparing function is a nullptr.
+	mov dword ptr [rdi], keyCompFuncNullptr
+	cmp rdx, nullptr
+	je functionReturn
+
+	; The pool has to keep the pinned treenodes of a search next to the pages that are read ahead.
+	mov dword ptr [rdi], poolSizeInvalid
+	cmp r8, minPoolPages
+	jb functionReturn
+
+	mov r10, r8
+	shr r10, 1
+	cmp r9, r10
+	ja functionReturn
+
+	; Save the file, the comparison function, the pool size and the read ahead.
+	mov rbx, rcx
+	mov r12, rdx
+	mov r13, r8
+	mov [rbp + pagedReadAhead], r9
+
+	mov rcx, rbx
+	mov edx, 0
+	mov r8d, seekSet
+	call _fseeki64
+
+	mov dword ptr [rdi], errFileIo
+	cmp eax, 0
+	jne returnNullptr
+
+	lea r14, [rsp + shadowStorage]
+	mov rcx, r14
+	mov edx, 1
+	mov r8d, sizeof PagedHeader
+	mov r9, rbx
+	call fread
+
+	; Check the header.
+	mov dword ptr [rdi], snapshotInvalid
+	cmp rax, sizeof PagedHeader
+	jne returnNullptr
+
+	mov rax, pagedMagic
+	cmp [r14].PagedHeader.magic, rax
+	jne returnNullptr
+
+	cmp [r14].PagedHeader.version, pagedVersion
+	jne returnNullptr
+
+	mov rcx, r14
+	mov edx, sizeof PagedHeader - qwordSize
+	mov r8, fnvOffsetBasis
+	call hashSnapshotBytes
+
+	cmp [r14].PagedHeader.checksum, rax
+	jne returnNullptr
+
+	mov rcx, [r14].PagedHeader.pageSize
+	cmp rcx, minPageSize
+	jb returnNullptr
+
+	cmp rcx, maxPageSize
+	ja returnNullptr
+
+	lea rax, [rcx - 1]
+	test rax, rcx
+	jnz returnNullptr
+
+	; A treenode holds the pair and its links and fits into a page.
+	mov rax, [r14].PagedHeader.keySize
+	add rax, [r14].PagedHeader.valueSize
+	jc returnNullptr
+
+	add rax, sizeof PagedTreeNode
+	jc returnNullptr
+
+	cmp [r14].PagedHeader.nodeStride, rax
+	jb returnNullptr
+
+	cmp [r14].PagedHeader.nodeStride, rcx
+	ja returnNullptr
+
+	mov rcx, sizeof PagedTreeMap
+	call malloc
+
+	mov dword ptr [rdi], errHeapAllocation
+	cmp rax, nullptr
+	je returnNullptr
+
+	; Nothing is allocated yet.
+	mov rsi, rax
+	mov [rsi].PagedTreeMap.file, rbx
+	mov [rsi].PagedTreeMap.compareKeyFunc, r12
+	mov [rsi].PagedTreeMap.frames, nullptr
+	mov [rsi].PagedTreeMap.frameMemory, nullptr
+	mov [rsi].PagedTreeMap.frameAmount, 0
+	mov [rsi].PagedTreeMap.clockHand, 0
+	mov [rsi].PagedTreeMap.pageTable, nullptr
+	mov [rsi].PagedTreeMap.readBuffer, nullptr
+	mov [rsi].PagedTreeMap.lastMiss, noPagedMiss
+	mov [rsi].PagedTreeMap.readAmount, 0
+	mov [rsi].PagedTreeMap.readRequestAmount, 0
+	mov [rsi].PagedTreeMap.writeAmount, 0
+	mov [rsi].PagedTreeMap.hitAmount, 0
+	mov rax, [rbp + pagedReadAhead]
+	mov [rsi].PagedTreeMap.readAhead, rax
+
+	mov rax, [r14].PagedHeader.keySize
+	mov [rsi].PagedTreeMap.keySize, rax
+	mov rax, [r14].PagedHeader.valueSize
+	mov [rsi].PagedTreeMap.valueSize, rax
+	mov rax, [r14].PagedHeader.nodeAmount
+	mov [rsi].PagedTreeMap.nodeAmount, rax
+	mov rax, [r14].PagedHeader.pageSize
+	mov [rsi].PagedTreeMap.pageSize, rax
+	mov rax, [r14].PagedHeader.pageAmount
+	mov [rsi].PagedTreeMap.pageAmount, rax
+	mov rax, [r14].PagedHeader.root
+	mov [rsi].PagedTreeMap.root, rax
+	mov rcx, [r14].PagedHeader.nodeStride
+	mov [rsi].PagedTreeMap.nodeStride, rcx
+	mov rax, [r14].PagedHeader.pageSize
+	xor edx, edx
+	div rcx
+	mov [rsi].PagedTreeMap.slotAmount, rax
+
+	; Every frame of the pool starts out free.
+	mov rcx, r13
+	mov edx, sizeof PagedFrame
+	call calloc
+
+	cmp rax, nullptr
+	je releasePagedTreeMap
+
+	mov [rsi].PagedTreeMap.frames, rax
+	mov [rsi].PagedTreeMap.frameAmount, r13
+
+	mov rcx, r13
+	imul rcx, [rsi].PagedTreeMap.pageSize
+	call malloc
+
+	cmp rax, nullptr
+	je releasePagedTreeMap
+
+	mov [rsi].PagedTreeMap.frameMemory, rax
+
+	; The page table holds the frame of every resident page plus one.
+	mov rcx, [rsi].PagedTreeMap.pageAmount
+	inc rcx
+	mov edx, qwordSize
+	call calloc
+
+	cmp rax, nullptr
+	je releasePagedTreeMap
+
+	mov [rsi].PagedTreeMap.pageTable, rax
+
+	; A read takes the missed page and the pages read ahead.
+	mov rcx, [rsi].PagedTreeMap.readAhead
+	inc rcx
+	imul rcx, [rsi].PagedTreeMap.pageSize
+	call malloc
+
+	cmp rax, nullptr
+	je releasePagedTreeMap
+
+	mov [rsi].PagedTreeMap.readBuffer, rax
+
+	mov dword ptr [rdi], success
+	mov rax, rsi
+
+	jmp functionReturn
+
+releasePagedTreeMap:
+	; Free everything that was allocated, the pool has no dirty pages yet.
+	mov rcx, rsi
+	call closePagedTreeMap
+
+returnNullptr:
+	mov rax, nullptr
+
+functionReturn:
+	add rsp, shadowStorage + sizeof PagedHeader
+	pop r14
+	pop r13
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	pop rbp
+	ret
+
+openPagedTreeMap endp
+
+
+	public closePagedTreeMap
+
+; Writes the dirty pages back and frees the paged treemap with its buffer pool.
+; The file stays open.
+;
+; @RCX qword[in,out] - Pointer to the paged treemap.
+;
+; @return A status value for success, errFileIo or treeMapNullptr. The paged treemap is freed either way.
+closePagedTreeMap proc
+
+	push rsi
+	push rdi
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the paged treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+
+	call flushPagedTreeMap
+
+	mov edi, eax
+
+	; free ignores a nullptr.
+	mov rcx, [rsi].PagedTreeMap.readBuffer
+	call free
+
+	mov rcx, [rsi].PagedTreeMap.pageTable
+	call free
+
+	mov rcx, [rsi].PagedTreeMap.frameMemory
+	call free
+
+	mov rcx, [rsi].PagedTreeMap.frames
+	call free
+
+	mov rcx, rsi
+	call free
+
+	mov eax, edi
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rdi
+	pop rsi
+	ret
+
+closePagedTreeMap endp
+
+
+	public flushPagedTreeMap
+
+; Writes the dirty pages of the buffer pool back to the file and waits until it is stored.
+;
+; @RCX qword[in,out] - Pointer to the paged treemap.
+;
+; @return A status value for success, errFileIo or treeMapNullptr.
+flushPagedTreeMap proc
+
+	push rsi
+	push rdi
+	push rbx
+	sub rsp, shadowStorage
+
+	; Check if the paged treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+	mov rbx, [rsi].PagedTreeMap.writeAmount
+	xor edi, edi
+
+flushFrame:
+	cmp rdi, [rsi].PagedTreeMap.frameAmount
+	jae commitFile
+
+	mov rcx, rdi
+	imul rcx, sizeof PagedFrame
+	add rcx, [rsi].PagedTreeMap.frames
+	test [rcx].PagedFrame.flags, pagedDirtyFlag
+	jz nextFrame
+
+	mov rcx, rdi
+	call writePagedFrame
+
+	cmp eax, success
+	jne functionReturn
+
+nextFrame:
+	inc rdi
+
+	jmp flushFrame
+
+commitFile:
+	; A pool without written pages has nothing to store, which keeps read only files working.
+	mov eax, success
+	cmp rbx, [rsi].PagedTreeMap.writeAmount
+	je functionReturn
+
+	; Hand the pages to the system and wait until they are stored.
+	mov rcx, [rsi].PagedTreeMap.file
+	call fflush
+
+	cmp eax, 0
+	jne fileError
+
+	mov rcx, [rsi].PagedTreeMap.file
+	call _fileno
+
+	mov ecx, eax
+	call _commit
+
+	cmp eax, 0
+	jne fileError
+
+	mov eax, success
+
+	jmp functionReturn
+
+fileError:
+	mov eax, errFileIo
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+flushPagedTreeMap endp
+
+
+	public getPagedValue
+
+; Copies the value of the key out of the paged treemap.
+;
+; @RCX qword[in,out] - Pointer to the paged treemap.
+; @RDX qword[in] - Pointer to the key whose value is searched.
+; @R8 qword[out] - Pointer to the buffer that receives the value.
+;
+; @return A status value for success, doesNotContain, valueBufferNullptr, errFileIo or treeMapNullptr.
+getPagedValue proc
+
+	push rsi
+	push rdi
+	push rbx
+	sub rsp, shadowStorage
+
+	; Check if the paged treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the value buffer is a nullptr.
+	mov eax, valueBufferNullptr
+	cmp r8, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+	mov rbx, r8
+
+	mov r8d, mappedSearchExact
+	call findPagedTreeNode
+
+	cmp rax, nullptr
+	jne copyValue
+
+	mov eax, edx
+
+	jmp functionReturn
+
+copyValue:
+	; The value follows the key.
+	mov rdi, rax
+	mov rcx, rbx
+	mov rdx, rax
+	add rdx, [rsi].PagedTreeMap.keySize
+	mov r8, [rsi].PagedTreeMap.valueSize
+	call memcpy
+
+	mov rcx, rdi
+	mov edx, 0
+	call unpinPagedNode
+
+	mov eax, success
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+getPagedValue endp
+
+
+	public replacePagedValue
+
+; Overwrites the value of the key inside its page. The page is written back when it leaves
+; the buffer pool or the paged treemap is flushed.
+;
+; @RCX qword[in,out] - Pointer to the paged treemap.
+; @RDX qword[in] - Pointer to the key whose value is replaced.
+; @R8 qword[in] - Pointer to the new value.
+;
+; @return A status value for success, doesNotContain, valueBufferNullptr, errFileIo or treeMapNullptr.
+replacePagedValue proc
+
+	push rsi
+	push rdi
+	push rbx
+	sub rsp, shadowStorage
+
+	; Check if the paged treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the value is a nullptr.
+	mov eax, valueBufferNullptr
+	cmp r8, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+	mov rbx, r8
+
+	mov r8d, mappedSearchExact
+	call findPagedTreeNode
+
+	cmp rax, nullptr
+	jne storeValue
+
+	mov eax, edx
+
+	jmp functionReturn
+
+storeValue:
+	; The value follows the key.
+	mov rdi, rax
+	mov rcx, rax
+	add rcx, [rsi].PagedTreeMap.keySize
+	mov rdx, rbx
+	mov r8, [rsi].PagedTreeMap.valueSize
+	call memcpy
+
+	mov rcx, rdi
+	mov edx, pagedDirtyFlag
+	call unpinPagedNode
+
+	mov eax, success
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+replacePagedValue endp
+
+
+	public ceilingPagedPair
+
+; Copies the pair with the smallest key that is bigger or equal to the given key.
+;
+; @RCX qword[in,out] - Pointer to the paged treemap.
+; @RDX qword[in] - Pointer to the key.
+; @R8 qword[out] - Pointer to the buffer that receives the pair.
+;
+; @return A status value for success, doesNotContain, pairBufferNullptr, errFileIo or treeMapNullptr.
+ceilingPagedPair proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov r9d, mappedSearchCeiling
+	call copyPagedPair
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+ceilingPagedPair endp
+
+
+	public floorPagedPair
+
+; Copies the pair with the biggest key that is smaller or equal to the given key.
+;
+; @RCX qword[in,out] - Pointer to the paged treemap.
+; @RDX qword[in] - Pointer to the key.
+; @R8 qword[out] - Pointer to the buffer that receives the pair.
+;
+; @return A status value for success, doesNotContain, pairBufferNullptr, errFileIo or treeMapNullptr.
+floorPagedPair proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov r9d, mappedSearchFloor
+	call copyPagedPair
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+floorPagedPair endp
+
+
+	public higherPagedPair
+
+; Copies the pair with the smallest key that is bigger than the given key. Scans step from pair
+; to pair with it and read the following pages ahead once they leave the pages of the pool.
+;
+; @RCX qword[in,out] - Pointer to the paged treemap.
+; @RDX qword[in] - Pointer to the key.
+; @R8 qword[out] - Pointer to the buffer that receives the pair.
+;
+; @return A status value for success, doesNotContain, pairBufferNullptr, errFileIo or treeMapNullptr.
+higherPagedPair proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov r9d, mappedSearchHigher
+	call copyPagedPair
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+higherPagedPair endp
+
+
+	public lowerPagedPair
+
+; Copies the pair with the biggest key that is smaller than the given key.
+;
+; @RCX qword[in,out] - Pointer to the paged treemap.
+; @RDX qword[in] - Pointer to the key.
+; @R8 qword[out] - Pointer to the buffer that receives the pair.
+;
+; @return A status value for success, doesNotContain, pairBufferNullptr, errFileIo or treeMapNullptr.
+lowerPagedPair proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov r9d, mappedSearchLower
+	call copyPagedPair
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+lowerPagedPair endp
+
+
+; Searches a treenode of the paged treemap and copies its pair into the buffer.
+;
+; @RCX qword[in,out] - Pointer to the paged treemap.
+; @RDX qword[in] - Pointer to the searched key.
+; @R8 qword[out] - Pointer to the buffer that receives the pair.
+; @R9 qword[in] - Mode of the search, e.g. mappedSearchCeiling.
+;
+; @return A status value for success, doesNotContain, pairBufferNullptr, errFileIo or treeMapNullptr.
+copyPagedPair proc
+
+	push rsi
+	push rdi
+	push rbx
+	sub rsp, shadowStorage
+
+	; Check if the paged treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the pair buffer is a nullptr.
+	mov eax, pairBufferNullptr
+	cmp r8, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+	mov rbx, r8
+
+	mov r8, r9
+	call findPagedTreeNode
+
+	cmp rax, nullptr
+	jne copyFoundPair
+
+	mov eax, edx
+
+	jmp functionReturn
+
+copyFoundPair:
+	mov rdi, rax
+	mov rcx, rbx
+	mov rdx, rax
+	mov r8, [rsi].PagedTreeMap.keySize
+	add r8, [rsi].PagedTreeMap.valueSize
+	call memcpy
+
+	mov rcx, rdi
+	mov edx, 0
+	call unpinPagedNode
+
+	mov eax, success
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+copyPagedPair endp
+
+
+; Searches a treenode of the paged treemap like findMappedTreeNode. The visited treenode stays pinned
+; while its links are read and the candidate until the search ends, so no other page can evict them.
+;
+; @RCX qword[in,out] - Pointer to the paged treemap.
+; @RDX qword[in] - Pointer to the searched key.
+; @R8 qword[in] - Mode of the search, e.g. mappedSearchCeiling.
+;
+; @return The pinned treenode or a nullptr and inside EDX the status value success,
+;		  doesNotContain or errFileIo.
+findPagedTreeNode proc
+
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	push r13
+	sub rsp, shadowStorage
+
+	; Save the paged treemap, the key and the mode and start at the root.
+	mov rsi, rcx
+	mov rdi, rdx
+	mov r12, r8
+	mov rbx, [rsi].PagedTreeMap.root
+	mov r13, nullptr
+
+searchLoop:
+	; The link zero marks a missing child.
+	cmp rbx, 0
+	je searchFinished
+
+	mov rcx, rbx
+	call pinPagedNode
+
+	cmp rax, nullptr
+	je fileError
+
+	mov rbx, rax
+	mov rcx, rbx
+	mov rdx, rdi
+	callUserFunc [rsi].PagedTreeMap.compareKeyFunc
+
+	; An equal key is the result of every inclusive search.
+	cmp eax, 0
+	jne chooseChild
+
+	test r12, searchInclusiveBit
+	jz chooseChild
+
+	mov rcx, r13
+	mov r13, rbx
+	mov edx, 0
+	call unpinPagedNode
+
+	jmp searchFinished
+
+chooseChild:
+	; Move to the links of the treenode.
+	mov rcx, rbx
+	add rcx, [rsi].PagedTreeMap.keySize
+	add rcx, [rsi].PagedTreeMap.valueSize
+
+	test r12, searchHigherBit
+	jz searchLower
+
+	; A bigger key is a candidate for a higher key, a smaller or equal one isn't.
+	cmp eax, 0
+	jge takeRightChild
+
+	jmp takeCandidate
+
+searchLower:
+	; A smaller key is a candidate for a lower key, a bigger or equal one isn't.
+	cmp eax, 0
+	jle takeLeftChild
+
+takeCandidate:
+	test r12, searchExactBit
+	jnz chooseCandidateChild
+
+	; The candidate keeps the pin of the treenode and the previous candidate is released instead.
+	xchg rbx, r13
+
+chooseCandidateChild:
+	; Search closer to the key behind the candidate.
+	test r12, searchHigherBit
+	jz takeRightChild
+
+takeLeftChild:
+	mov rax, [rcx].PagedTreeNode.left
+
+	jmp releaseTreeNode
+
+takeRightChild:
+	mov rax, [rcx].PagedTreeNode.right
+
+releaseTreeNode:
+	mov rcx, rbx
+	mov rbx, rax
+	mov edx, 0
+	call unpinPagedNode
+
+	jmp searchLoop
+
+searchFinished:
+	mov rax, r13
+	mov edx, success
+	cmp rax, nullptr
+	jne functionReturn
+
+	mov edx, doesNotContain
+
+	jmp functionReturn
+
+fileError:
+	mov rcx, r13
+	mov edx, 0
+	call unpinPagedNode
+
+	mov rax, nullptr
+	mov edx, errFileIo
+
+functionReturn:
+	add rsp, shadowStorage
+	pop r13
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+findPagedTreeNode endp
+
+
+; Pins the page of the link inside the buffer pool and returns its treenode. The page is read
+; if it isn't resident, pages that are resident count as a hit.
+;
+; @RCX qword[in] - Link of the treenode.
+; @RSI qword[in,out] - Pointer to the paged treemap.
+;
+; @return A pointer to the treenode or a nullptr if the page can't be read.
+pinPagedNode proc
+
+	push rbx
+	push rdi
+	sub rsp, shadowStorage + qwordSize
+
+	; Split the link into its page and slot.
+	lea rax, [rcx - 1]
+	xor edx, edx
+	div [rsi].PagedTreeMap.slotAmount
+
+	mov rbx, rax
+	mov rdi, rdx
+
+	; A link outside of the file can't be read.
+	mov eax, nullptr
+	cmp rbx, [rsi].PagedTreeMap.pageAmount
+	jae functionReturn
+
+	mov rcx, [rsi].PagedTreeMap.pageTable
+	mov rax, [rcx + rbx * qwordSize]
+	cmp rax, 0
+	je loadPage
+
+	inc [rsi].PagedTreeMap.hitAmount
+
+	jmp pinFrame
+
+loadPage:
+	mov rcx, rbx
+	call loadPagedPages
+
+	cmp rax, 0
+	je functionReturn
+
+pinFrame:
+	; The page table holds the frame plus one.
+	dec rax
+	mov rcx, rax
+	imul rcx, sizeof PagedFrame
+	add rcx, [rsi].PagedTreeMap.frames
+	inc [rcx].PagedFrame.pinAmount
+	or [rcx].PagedFrame.flags, pagedReferencedFlag
+
+	imul rax, [rsi].PagedTreeMap.pageSize
+	add rax, [rsi].PagedTreeMap.frameMemory
+	imul rdi, [rsi].PagedTreeMap.nodeStride
+	add rax, rdi
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rdi
+	pop rbx
+	ret
+
+pinPagedNode endp
+
+
+; Releases the pin of the page that holds the treenode.
+;
+; @RCX qword[in] - Pointer to a pinned treenode or a nullptr.
+; @RDX qword[in] - Flags that are added to the frame, e.g. pagedDirtyFlag for a changed treenode.
+; @RSI qword[in,out] - Pointer to the paged treemap.
+unpinPagedNode proc
+
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov r8, rdx
+
+	mov rax, rcx
+	sub rax, [rsi].PagedTreeMap.frameMemory
+	xor edx, edx
+	div [rsi].PagedTreeMap.pageSize
+
+	imul rax, sizeof PagedFrame
+	add rax, [rsi].PagedTreeMap.frames
+	dec [rax].PagedFrame.pinAmount
+	or [rax].PagedFrame.flags, r8
+
+functionReturn:
+	ret
+
+unpinPagedNode endp
+
+
+; Reads the missed page into a frame of the buffer pool. If the previous miss was the page in front of it,
+; a scan runs through the file and the following pages that aren't resident are read with the same request.
+; The pages that are read ahead aren't referenced yet, so the clock evicts them first if the scan stops.
+;
+; @RCX qword[in] - Index of the missed page.
+; @RSI qword[in,out] - Pointer to the paged treemap.
+;
+; @return The frame of the page plus one or zero if it can't be read.
+loadPagedPages proc
+
+	push rbx
+	push rdi
+	push r12
+	push r13
+	push r14
+	sub rsp, shadowStorage
+
+	mov rbx, rcx
+	mov edi, 1
+
+	mov rax, [rsi].PagedTreeMap.lastMiss
+	inc rax
+	cmp rax, rbx
+	jne readPages
+
+	; Read ahead up to the end of the file.
+	mov rdx, [rsi].PagedTreeMap.readAhead
+	inc rdx
+	mov rcx, [rsi].PagedTreeMap.pageAmount
+	sub rcx, rbx
+	cmp rcx, rdx
+	cmovb rdx, rcx
+
+	; Stop in front of the first page that is resident already.
+	mov r8, [rsi].PagedTreeMap.pageTable
+
+extendRead:
+	cmp rdi, rdx
+	jae readPages
+
+	lea rax, [rbx + rdi]
+	cmp qword ptr [r8 + rax * qwordSize], 0
+	jne readPages
+
+	inc rdi
+
+	jmp extendRead
+
+readPages:
+	; The header page comes before the first page of the subtrees.
+	lea rdx, [rbx + 1]
+	imul rdx, [rsi].PagedTreeMap.pageSize
+	mov rcx, [rsi].PagedTreeMap.file
+	mov r8d, seekSet
+	call _fseeki64
+
+	cmp eax, 0
+	jne fileError
+
+	mov rcx, [rsi].PagedTreeMap.readBuffer
+	mov rdx, [rsi].PagedTreeMap.pageSize
+	mov r8, rdi
+	mov r9, [rsi].PagedTreeMap.file
+	call fread
+
+	cmp rax, 0
+	je fileError
+
+	mov rdi, rax
+	inc [rsi].PagedTreeMap.readRequestAmount
+	add [rsi].PagedTreeMap.readAmount, rdi
+	lea rax, [rbx + rdi - 1]
+	mov [rsi].PagedTreeMap.lastMiss, rax
+
+	; Copy every page that was read into a frame of the pool. The missed page comes last,
+	; so taking the frames of the pages read ahead can't evict it again.
+	mov r12, rdi
+
+copyPage:
+	cmp r12, 0
+	je pagesLoaded
+
+	dec r12
+	call acquirePagedFrame
+
+	cmp rax, 0
+	je fileError
+
+	mov r13, rax
+	lea rcx, [rax - 1]
+	imul rcx, [rsi].PagedTreeMap.pageSize
+	add rcx, [rsi].PagedTreeMap.frameMemory
+	mov rdx, r12
+	imul rdx, [rsi].PagedTreeMap.pageSize
+	add rdx, [rsi].PagedTreeMap.readBuffer
+	mov r8, [rsi].PagedTreeMap.pageSize
+	call memcpy
+
+	lea rcx, [r13 - 1]
+	imul rcx, sizeof PagedFrame
+	add rcx, [rsi].PagedTreeMap.frames
+	lea r14, [rbx + r12]
+	lea rax, [r14 + 1]
+	mov [rcx].PagedFrame.page, rax
+	mov [rcx].PagedFrame.flags, 0
+
+	mov rcx, [rsi].PagedTreeMap.pageTable
+	mov [rcx + r14 * qwordSize], r13
+
+	jmp copyPage
+
+pagesLoaded:
+	mov rcx, [rsi].PagedTreeMap.pageTable
+	mov rax, [rcx + rbx * qwordSize]
+
+	jmp functionReturn
+
+fileError:
+	mov eax, 0
+
+functionReturn:
+	add rsp, shadowStorage
+	pop r14
+	pop r13
+	pop r12
+	pop rdi
+	pop rbx
+	ret
+
+loadPagedPages endp
+
+
+; Takes a frame of the buffer pool with the clock algorithm. The hand skips pinned frames
+; and clears the reference of the others, the first frame without a reference is evicted.
+; A dirty page is written back before its frame is reused.
+;
+; @RSI qword[in,out] - Pointer to the paged treemap.
+;
+; @return The free frame plus one or zero if every frame is pinned or a page can't be written.
+acquirePagedFrame proc
+
+	push rbx
+	push rdi
+	sub rsp, shadowStorage + qwordSize
+
+	; Two rounds clear every reference and reach every frame without a pin.
+	mov rdi, [rsi].PagedTreeMap.frameAmount
+	shl rdi, 1
+
+sweepFrame:
+	cmp rdi, 0
+	je frameError
+
+	dec rdi
+
+	; Move the hand to the next frame.
+	mov rbx, [rsi].PagedTreeMap.clockHand
+	lea rax, [rbx + 1]
+	xor edx, edx
+	cmp rax, [rsi].PagedTreeMap.frameAmount
+	cmovae rax, rdx
+	mov [rsi].PagedTreeMap.clockHand, rax
+
+	mov rcx, rbx
+	imul rcx, sizeof PagedFrame
+	add rcx, [rsi].PagedTreeMap.frames
+
+	cmp [rcx].PagedFrame.page, 0
+	je takeFrame
+
+	cmp [rcx].PagedFrame.pinAmount, 0
+	jne sweepFrame
+
+	test [rcx].PagedFrame.flags, pagedReferencedFlag
+	jz evictPage
+
+	; Only the dirty flag stays.
+	and [rcx].PagedFrame.flags, pagedDirtyFlag
+
+	jmp sweepFrame
+
+evictPage:
+	test [rcx].PagedFrame.flags, pagedDirtyFlag
+	jz dropPage
+
+	mov rcx, rbx
+	call writePagedFrame
+
+	cmp eax, success
+	jne frameError
+
+	mov rcx, rbx
+	imul rcx, sizeof PagedFrame
+	add rcx, [rsi].PagedTreeMap.frames
+
+dropPage:
+	mov rax, [rcx].PagedFrame.page
+	mov rdx, [rsi].PagedTreeMap.pageTable
+	mov qword ptr [rdx + rax * qwordSize - qwordSize], 0
+	mov [rcx].PagedFrame.page, 0
+
+takeFrame:
+	lea rax, [rbx + 1]
+
+	jmp functionReturn
+
+frameError:
+	mov eax, 0
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rdi
+	pop rbx
+	ret
+
+acquirePagedFrame endp
+
+
+; Writes the page of the frame back to the file.
+;
+; @RCX qword[in] - Index of the frame with a dirty page.
+; @RSI qword[in,out] - Pointer to the paged treemap.
+;
+; @return A status value for success or errFileIo.
+writePagedFrame proc
+
+	push rbx
+	push rdi
+	sub rsp, shadowStorage + qwordSize
+
+	mov rdi, rcx
+	mov rbx, rcx
+	imul rbx, sizeof PagedFrame
+	add rbx, [rsi].PagedTreeMap.frames
+
+	; The page plus one is the page of the file behind the header page.
+	mov rdx, [rbx].PagedFrame.page
+	imul rdx, [rsi].PagedTreeMap.pageSize
+	mov rcx, [rsi].PagedTreeMap.file
+	mov r8d, seekSet
+	call _fseeki64
+
+	cmp eax, 0
+	jne fileError
+
+	mov rcx, rdi
+	imul rcx, [rsi].PagedTreeMap.pageSize
+	add rcx, [rsi].PagedTreeMap.frameMemory
+	mov edx, 1
+	mov r8, [rsi].PagedTreeMap.pageSize
+	mov r9, [rsi].PagedTreeMap.file
+	call fwrite
+
+	cmp rax, [rsi].PagedTreeMap.pageSize
+	jne fileError
+
+	inc [rsi].PagedTreeMap.writeAmount
+	and [rbx].PagedFrame.flags, pagedReferencedFlag
+	mov eax, success
+
+	jmp functionReturn
+
+fileError:
+	mov eax, errFileIo
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rdi
+	pop rbx
+	ret
+
+writePagedFrame endp
+
+end
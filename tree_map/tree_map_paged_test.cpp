@@ -0,0 +1,258 @@
+/*
+* @file tree_map_paged_test.h
+*
+* Defines unit tests for the paged treemaps of the tree map
+* implementation.
+*
+* @author Collector
+* @data 03/09/2023
+*/
+
+
+#include "utils.h"
+
+namespace {
+	/*
+	* Size of the pages of the tests.
+	*/
+	constexpr size_t pageSize{ 4096 };
+
+	/*
+	* Saves the treemap into the file and opens it as a paged treemap.
+	*
+	* @param[in] tm - Treemap that is saved.
+	* @param[in, out] file - File that receives the pages.
+	* @param[in] poolPages - Amount of pages of the buffer pool.
+	* @param[in] readAhead - Amount of pages that are read ahead.
+	*
+	* @return The paged treemap.
+	*/
+	PagedTreeMap* saveAndOpenPages(TreeMap* tm, FILE* file, size_t poolPages, size_t readAhead) {
+		Status s;
+
+		EXPECT_EQ(Status::SUCCESS, savePagedTreeMap(tm, file, pageSize));
+
+		PagedTreeMap* ptm{ openPagedTreeMap(file, compareNumberKey, poolPages, readAhead, &s) };
+
+		EXPECT_EQ(Status::SUCCESS, s);
+
+		return ptm;
+	}
+
+	/*
+	* Scans every pair of the paged treemap of numbers in key order.
+	*
+	* @param[in, out] ptm - Paged treemap that is scanned.
+	* @param[in] amount - Expected amount of consecutive keys starting at zero.
+	*/
+	void assertPagedScan(PagedTreeMap* ptm, size_t amount) {
+		size_t key{ 0 }, pair[2]{};
+		Status s{ ceilingPagedPair(ptm, &key, pair) };
+
+		for (size_t expected{ 0 }; expected < amount; expected++) {
+			ASSERT_EQ(Status::SUCCESS, s);
+			ASSERT_EQ(expected, pair[0]);
+			ASSERT_EQ(expected * expected, pair[1]);
+
+			key = pair[0];
+			s = higherPagedPair(ptm, &key, pair);
+		}
+
+		ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+	}
+}
+
+TEST(TreeMap, pagedTreeMapShouldFailForInvalidParameters) {
+	Status s;
+	FILE* file{ createTemporaryFile() };
+	TreeMap* tm{ createTestNumberTree(10, 1) };
+	TreeMap* inlineTree{ createTestInlineTree() };
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, savePagedTreeMap(nullptr, file, pageSize));
+	ASSERT_EQ(Status::FILE_NULLPTR, savePagedTreeMap(tm, nullptr, pageSize));
+	ASSERT_EQ(Status::PAGE_SIZE_INVALID, savePagedTreeMap(tm, file, 2048));
+	ASSERT_EQ(Status::PAGE_SIZE_INVALID, savePagedTreeMap(tm, file, 6000));
+	ASSERT_EQ(Status::PAGE_SIZE_INVALID, savePagedTreeMap(tm, file, 32768));
+	ASSERT_EQ(Status::INLINE_SIZE_MISMATCH, savePagedTreeMap(inlineTree, file, pageSize));
+
+	ASSERT_EQ(nullptr, openPagedTreeMap(file, compareNumberKey, 8, 0, nullptr));
+	ASSERT_EQ(nullptr, openPagedTreeMap(nullptr, compareNumberKey, 8, 0, &s));
+	ASSERT_EQ(Status::FILE_NULLPTR, s);
+	ASSERT_EQ(nullptr, openPagedTreeMap(file, nullptr, 8, 0, &s));
+	ASSERT_EQ(Status::KEY_COMP_FUNC_NULLPTR, s);
+	ASSERT_EQ(nullptr, openPagedTreeMap(file, compareNumberKey, 3, 0, &s));
+	ASSERT_EQ(Status::POOL_SIZE_INVALID, s);
+	ASSERT_EQ(nullptr, openPagedTreeMap(file, compareNumberKey, 8, 5, &s));
+	ASSERT_EQ(Status::POOL_SIZE_INVALID, s);
+
+	// A file without pages isn't a paged treemap.
+	ASSERT_EQ(nullptr, openPagedTreeMap(file, compareNumberKey, 8, 0, &s));
+	ASSERT_EQ(Status::SNAPSHOT_INVALID, s);
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, closePagedTreeMap(nullptr));
+
+	deleteTreeMap(inlineTree);
+	deleteTreeMap(tm);
+	fclose(file);
+}
+
+TEST(TreeMap, getPagedValueShouldFindEveryKeyThroughASmallPool) {
+	FILE* file{ createTemporaryFile() };
+	TreeMap* tm{ createTestNumberTree(20000, 2) };
+	PagedTreeMap* ptm{ saveAndOpenPages(tm, file, 8, 0) };
+
+	ASSERT_EQ(20000, ptm->nodeAmount);
+	ASSERT_LT(8, ptm->pageAmount);
+
+	for (size_t key{ 0 }; key < 40000; key++) {
+		size_t value{ 0 };
+		Status s{ getPagedValue(ptm, &key, &value) };
+
+		if (key % 2 == 0) {
+			ASSERT_EQ(Status::SUCCESS, s);
+			ASSERT_EQ(key * key, value);
+		}
+		else {
+			ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+		}
+	}
+
+	ASSERT_LE(ptm->pageAmount, ptm->readAmount);
+	ASSERT_LT(0, ptm->hitAmount);
+	ASSERT_EQ(Status::SUCCESS, closePagedTreeMap(ptm));
+
+	deleteTreeMap(tm);
+	fclose(file);
+}
+
+TEST(TreeMap, pagedLookupsShouldReadAPageForSeveralLevels) {
+	FILE* file{ createTemporaryFile() };
+	TreeMap* tm{ createTestNumberTree(1 << 16, 1) };
+	PagedTreeMap* ptm{ saveAndOpenPages(tm, file, 4, 0) };
+
+	// A 4 KB page holds 7 levels of 32 byte treenodes, the tree is at most 33 levels deep.
+	// The in-memory tree touches a treenode for every level of the same search.
+	// The odd step scatters the keys over the whole tree.
+	for (size_t i{ 0 }; i < 2000; i++) {
+		size_t key{ i * 7919 % (1 << 16) }, value{ 0 };
+		size_t readAmount{ ptm->readAmount };
+
+		ASSERT_EQ(Status::SUCCESS, getPagedValue(ptm, &key, &value));
+		ASSERT_EQ(key * key, value);
+		ASSERT_GE(5, ptm->readAmount - readAmount);
+	}
+
+	closePagedTreeMap(ptm);
+	deleteTreeMap(tm);
+	fclose(file);
+}
+
+TEST(TreeMap, pagedScanShouldReadPagesAhead) {
+	FILE* file{ createTemporaryFile() };
+	TreeMap* tm{ createTestNumberTree(20000, 1) };
+	PagedTreeMap* ptm{ saveAndOpenPages(tm, file, 16, 0) };
+
+	assertPagedScan(ptm, 20000);
+
+	size_t singleRequests{ ptm->readRequestAmount };
+
+	ASSERT_EQ(ptm->readAmount, singleRequests);
+	ASSERT_LE(ptm->pageAmount, singleRequests);
+
+	closePagedTreeMap(ptm);
+
+	// The pages of a scan follow each other, so every request reads the next pages with the missed one.
+	Status s;
+
+	ptm = openPagedTreeMap(file, compareNumberKey, 16, 8, &s);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	assertPagedScan(ptm, 20000);
+
+	ASSERT_LE(ptm->pageAmount, ptm->readAmount);
+	ASSERT_GT(singleRequests, 4 * ptm->readRequestAmount);
+
+	closePagedTreeMap(ptm);
+	deleteTreeMap(tm);
+	fclose(file);
+}
+
+TEST(TreeMap, pagedPairSearchesShouldFindNeighbours) {
+	FILE* file{ createTemporaryFile() };
+	TreeMap* tm{ createTestNumberTree(5000, 2) };
+	PagedTreeMap* ptm{ saveAndOpenPages(tm, file, 4, 2) };
+	size_t evenKey{ 4000 }, oddKey{ 4001 }, tooBigKey{ 10000 }, pair[2]{};
+
+	ASSERT_EQ(Status::SUCCESS, ceilingPagedPair(ptm, &evenKey, pair));
+	ASSERT_EQ(4000, pair[0]);
+	ASSERT_EQ(Status::SUCCESS, ceilingPagedPair(ptm, &oddKey, pair));
+	ASSERT_EQ(4002, pair[0]);
+	ASSERT_EQ(Status::SUCCESS, floorPagedPair(ptm, &oddKey, pair));
+	ASSERT_EQ(4000, pair[0]);
+	ASSERT_EQ(Status::SUCCESS, higherPagedPair(ptm, &evenKey, pair));
+	ASSERT_EQ(4002, pair[0]);
+	ASSERT_EQ(Status::SUCCESS, lowerPagedPair(ptm, &evenKey, pair));
+	ASSERT_EQ(3998, pair[0]);
+	ASSERT_EQ(3998 * 3998, pair[1]);
+	ASSERT_EQ(Status::SUCCESS, floorPagedPair(ptm, &tooBigKey, pair));
+	ASSERT_EQ(9998, pair[0]);
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, ceilingPagedPair(ptm, &tooBigKey, pair));
+	ASSERT_EQ(Status::PAIR_BUFFER_NULLPTR, ceilingPagedPair(ptm, &evenKey, nullptr));
+
+	size_t zero{ 0 };
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, lowerPagedPair(ptm, &zero, pair));
+
+	closePagedTreeMap(ptm);
+
+	// An empty treemap has no pages behind the header.
+	TreeMap* emptyTree{ createTestNumberTree(0, 1) };
+
+	ptm = saveAndOpenPages(emptyTree, file, 4, 0);
+
+	ASSERT_EQ(0, ptm->pageAmount);
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, ceilingPagedPair(ptm, &zero, pair));
+
+	closePagedTreeMap(ptm);
+	deleteTreeMap(emptyTree);
+	deleteTreeMap(tm);
+	fclose(file);
+}
+
+TEST(TreeMap, replacePagedValueShouldWriteDirtyPagesBack) {
+	Status s;
+	FILE* file{ createTemporaryFile() };
+	TreeMap* tm{ createTestNumberTree(10000, 1) };
+	PagedTreeMap* ptm{ saveAndOpenPages(tm, file, 4, 0) };
+
+	for (size_t key{ 0 }; key < 10000; key += 3) {
+		size_t value{ key + 1 };
+
+		ASSERT_EQ(Status::SUCCESS, replacePagedValue(ptm, &key, &value));
+	}
+
+	size_t missingKey{ 10000 }, value{ 0 };
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, replacePagedValue(ptm, &missingKey, &value));
+	ASSERT_EQ(Status::VALUE_BUFFER_NULLPTR, replacePagedValue(ptm, &missingKey, nullptr));
+
+	// The small pool evicted most of the dirty pages already.
+	ASSERT_LT(0, ptm->writeAmount);
+	ASSERT_EQ(Status::SUCCESS, closePagedTreeMap(ptm));
+
+	ptm = openPagedTreeMap(file, compareNumberKey, 4, 0, &s);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	for (size_t key{ 0 }; key < 10000; key++) {
+		ASSERT_EQ(Status::SUCCESS, getPagedValue(ptm, &key, &value));
+		ASSERT_EQ(key % 3 == 0 ? key + 1 : key * key, value);
+	}
+
+	ASSERT_EQ(0, ptm->writeAmount);
+
+	closePagedTreeMap(ptm);
+	deleteTreeMap(tm);
+	fclose(file);
+}
@@ -0,0 +1,384 @@
+; @file tree_map_payload.asm
+;
+; Defines the payload arena of a treemap. Copy functions can allocate the nested
+; data of keys and values from it instead of allocating every part on the heap.
+; Clearing or deleting the treemap releases all of it at once.
+;
+; @author Collector
+; @date 03/09/2023
+
+	include tree_map.inc
+
+	.code
+
+
+	public createPayloadArena
+
+; Attaches an empty payload arena to the treemap. Its blocks are allocated on demand.
+;
+; @RCX qword[in,out] - Pointer to the treemap that gets the payload arena.
+; @RDX qword[in] - Minimum capacity of a block of the arena in bytes.
+;
+; @return A status value for success, payloadArenaExists if the treemap already has one,
+;		  blockSizeZero, errHeapAllocation or treeMapNullptr.
+createPayloadArena proc
+
+	push rsi
+	push rdi
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the block size is zero.
+	mov eax, blockSizeZero
+	cmp rdx, 0
+	je functionReturn
+
+	; Check if the treemap already has an arena.
+	mov eax, payloadArenaExists
+	cmp [rcx].TreeMap.payloadArena, nullptr
+	jne functionReturn
+
+	; Save the treemap and the block size.
+	mov rsi, rcx
+	mov rdi, rdx
+
+	mov rcx, sizeof PayloadArena
+	call malloc
+
+	cmp rax, nullptr
+	je heapAllocationError
+
+	; The arena starts without blocks.
+	mov [rax].PayloadArena.blocks, nullptr
+	mov [rax].PayloadArena.blockSize, rdi
+	mov [rax].PayloadArena.blockUsed, 0
+	mov [rax].PayloadArena.usedBytes, 0
+	mov [rsi].TreeMap.payloadArena, rax
+
+	mov eax, success
+
+	jmp functionReturn
+
+heapAllocationError:
+	mov eax, errHeapAllocation
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rdi
+	pop rsi
+	ret
+
+createPayloadArena endp
+
+
+	public allocatePayload
+
+; Bump allocates memory from the payload arena of the treemap. The memory is aligned on a
+; quadword boundary and stays valid until the treemap is cleared, deleted or compacted.
+; A new block is allocated if the newest one can't hold the requested size.
+;
+; @RCX qword[in,out] - Pointer to the treemap whose payload arena is used.
+; @RDX qword[in] - Size of the requested memory in bytes.
+;
+; @return Pointer to the memory or a nullptr if the treemap has no payload arena
+;		  or a new block can't be allocated.
+allocatePayload proc
+
+	push rsi
+	push rdi
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the treemap and its arena exist.
+	mov rax, nullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rsi, [rcx].TreeMap.payloadArena
+	cmp rsi, nullptr
+	je functionReturn
+
+	; Round the size up to the next quadword.
+	lea rdi, [rdx + qwordSize - 1]
+	and rdi, -qwordSize
+
+	; Take the memory from the newest block if it fits.
+	mov rcx, [rsi].PayloadArena.blocks
+	cmp rcx, nullptr
+	je allocateBlock
+
+	mov rax, [rsi].PayloadArena.blockUsed
+	add rax, rdi
+	cmp rax, [rcx].PayloadBlock.capacity
+	jbe bumpPayload
+
+allocateBlock:
+	; A new block has at least the block size of the arena.
+	mov rcx, [rsi].PayloadArena.blockSize
+	cmp rcx, rdi
+	cmovb rcx, rdi
+	mov [rsp + blockCapacity], rcx
+	add rcx, sizeof PayloadBlock
+	call malloc
+
+	cmp rax, nullptr
+	je functionReturn
+
+	; Link the block in front of the older ones.
+	mov rcx, [rsp + blockCapacity]
+	mov [rax].PayloadBlock.capacity, rcx
+	mov rcx, [rsi].PayloadArena.blocks
+	mov [rax].PayloadBlock.next, rcx
+	mov [rsi].PayloadArena.blocks, rax
+	mov [rsi].PayloadArena.blockUsed, 0
+	mov rcx, rax
+
+bumpPayload:
+	; Hand out the memory behind the used part of the block.
+	lea rax, [rcx + sizeof PayloadBlock]
+	add rax, [rsi].PayloadArena.blockUsed
+	add [rsi].PayloadArena.blockUsed, rdi
+	add [rsi].PayloadArena.usedBytes, rdi
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rdi
+	pop rsi
+	ret
+
+allocatePayload endp
+
+
+	public compactPayloadArena
+
+; Moves the payload of all pairs into a single new block and frees the old blocks.
+; Payload of deleted pairs is left behind, which reclaims the holes they leave in the arena.
+; The relocate function is called for every pair with the treemap and has to allocate its payload
+; again with allocatePayload, copy it and update the pair.
+;
+; @RCX qword[in,out] - Pointer to the treemap whose payload arena is compacted.
+; @RDX qword[in] - Pointer to the function that relocates the payload of a pair.
+;
+; @return A status value for success, errHeapAllocation, the status of a failed relocation or an error
+;		  if the treemap, its payload arena or the relocate function is a nullptr. If a relocation
+;		  fails the old blocks stay part of the arena, because not every pair has been moved.
+compactPayloadArena proc
+
+	push rbp
+	mov rbp, rsp
+	push rbx
+	push rsi
+	push rdi
+	push r12
+	push r13
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the treemap has an arena.
+	mov eax, payloadArenaNullptr
+	cmp [rcx].TreeMap.payloadArena, nullptr
+	je functionReturn
+
+	; Check if the relocate function is a nullptr.
+	mov eax, relocateFuncNullptr
+	cmp rdx, nullptr
+	je functionReturn
+
+	; The copies of a running checkpoint could point at the old blocks.
+	mov eax, checkpointRunning
+	cmp [rcx].TreeMap.checkpoint, nullptr
+	jne functionReturn
+
+	; Spilled treenodes are faulted back in before their pairs are relocated.
+	call restoreSpilledTreeMap
+
+	cmp eax, success
+	jne functionReturn
+
+	mov rsi, rcx
+	mov r12, rdx
+	mov r13, [rsi].TreeMap.payloadArena
+
+	; The live payload can't be bigger than the used bytes, so a single
+	; block of that size lets the relocation succeed without allocating.
+	mov rdi, [r13].PayloadArena.usedBytes
+	mov [rbp + oldUsedBytes], rdi
+	mov rcx, rdi
+	add rcx, sizeof PayloadBlock
+	call malloc
+
+	cmp rax, nullptr
+	je heapAllocationError
+
+	mov [rax].PayloadBlock.capacity, rdi
+	mov [rax].PayloadBlock.next, nullptr
+
+	; Swap the old blocks with the new one.
+	mov rbx, [r13].PayloadArena.blocks
+	mov [r13].PayloadArena.blocks, rax
+	mov [r13].PayloadArena.blockUsed, 0
+	mov [r13].PayloadArena.usedBytes, 0
+
+	; Relocate the payload of every pair.
+	mov edi, success
+	mov rcx, [rsi].TreeMap.root
+	call relocateTreeNodePairs
+
+	cmp edi, success
+	jne keepOldBlocks
+
+	mov rcx, rbx
+	call freePayloadBlocks
+
+	mov eax, success
+
+	jmp functionReturn
+
+keepOldBlocks:
+	; Append the old blocks behind the new ones.
+	mov rax, [r13].PayloadArena.blocks
+
+searchLastBlock:
+	cmp [rax].PayloadBlock.next, nullptr
+	je appendOldBlocks
+
+	mov rax, [rax].PayloadBlock.next
+
+	jmp searchLastBlock
+
+appendOldBlocks:
+	mov [rax].PayloadBlock.next, rbx
+	mov rax, [rbp + oldUsedBytes]
+	add [r13].PayloadArena.usedBytes, rax
+
+	mov eax, edi
+
+	jmp functionReturn
+
+heapAllocationError:
+	mov eax, errHeapAllocation
+
+functionReturn:
+	lea rsp, [rbp - 5 * qwordSize]
+	pop r13
+	pop r12
+	pop rdi
+	pop rsi
+	pop rbx
+	pop rbp
+	ret
+
+compactPayloadArena endp
+
+
+; Frees all blocks of the payload arena and resets it so that it can be used again.
+;
+; @RCX qword[in,out] - Pointer to the payload arena or a nullptr if the treemap has none.
+clearPayloadArena proc
+
+	push rbx
+	sub rsp, shadowStorage
+
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rbx, rcx
+	mov rcx, [rbx].PayloadArena.blocks
+	call freePayloadBlocks
+
+	mov [rbx].PayloadArena.blocks, nullptr
+	mov [rbx].PayloadArena.blockUsed, 0
+	mov [rbx].PayloadArena.usedBytes, 0
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rbx
+	ret
+
+clearPayloadArena endp
+
+
+; Frees the given block and all blocks linked behind it.
+;
+; @RCX qword[in,out] - Pointer to the first block or a nullptr.
+freePayloadBlocks proc
+
+	push rbx
+	sub rsp, shadowStorage
+
+	mov rbx, rcx
+
+freeBlock:
+	cmp rbx, nullptr
+	je functionReturn
+
+	mov rcx, rbx
+	mov rbx, [rbx].PayloadBlock.next
+	call free
+
+	jmp freeBlock
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rbx
+	ret
+
+freePayloadBlocks endp
+
+
+; Calls the relocate function for the pairs of the given treenode and its children
+; until a relocation fails.
+;
+; @RCX qword[in,out] - Pointer to the current tree node evaluated.
+; @RDI dword[in,out] - Status value that is changed by a failing relocation.
+; @RSI qword[in] - Pointer to the current treemap used.
+; @R12 qword[in] - Pointer to the relocate function.
+relocateTreeNodePairs proc
+
+	push rbp
+	mov rbp, rsp
+	sub rsp, shadowStorage
+
+	; Test if a nullptr branch was reached or a relocation failed.
+	cmp rcx, nullptr
+	je functionReturn
+
+	cmp edi, success
+	jne functionReturn
+
+	; Relocate the pair of the treenode.
+	mov [rbp + currentTreeNode], rcx
+	mov rdx, rsi
+	callUserFunc r12
+
+	mov edi, eax
+
+	; Continue with the left and the right child.
+	mov rcx, [rbp + currentTreeNode]
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rcx, [rcx]
+	call relocateTreeNodePairs
+
+	mov rcx, [rbp + currentTreeNode]
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	add rcx, qwordSize
+	mov rcx, [rcx]
+	call relocateTreeNodePairs
+
+functionReturn:
+	mov rsp, rbp
+	pop rbp
+	ret
+
+relocateTreeNodePairs endp
+
+end
@@ -0,0 +1,243 @@
+/*
+* @file tree_map_payload_test.h
+*
+* Defines unit tests for the payload arena of the tree map
+* implementation.
+*
+* @author Collector
+* @data 03/09/2023
+*/
+
+
+#include "utils.h"
+
+namespace {
+	/*
+	* Relocate function that always fails to test compactPayloadArena.
+	* 
+	* @param[in, out] treeNodePair - Pair that isn't relocated.
+	* @param[in] tm - Treemap whose payload arena is compacted.
+	* 
+	* @return A status value of err copy value.
+	*/
+	Status failRelocation(void* treeNodePair, TreeMap* tm) {
+		return Status::ERR_COPY_VALUE;
+	}
+}
+
+TEST(TreeMap, createPayloadArenaShouldFailForTreeMapNullptr) {
+	Status s;
+
+	s = createPayloadArena(nullptr, 64);
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, s);
+}
+
+TEST(TreeMap, createPayloadArenaShouldFailForZeroBlockSize) {
+	Status s;
+	TreeMap* tm{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeTreeNodePair, &s) };
+
+	s = createPayloadArena(tm, 0);
+
+	ASSERT_EQ(Status::BLOCK_SIZE_ZERO, s);
+	ASSERT_EQ(nullptr, tm->payloadArena);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, createPayloadArenaShouldFailIfArenaExists) {
+	Status s;
+	TreeMap* tm{ createTestPayloadTree(64) };
+	PayloadArena* arena{ tm->payloadArena };
+
+	s = createPayloadArena(tm, 64);
+
+	ASSERT_EQ(Status::PAYLOAD_ARENA_EXISTS, s);
+	ASSERT_EQ(arena, tm->payloadArena);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, allocatePayloadShouldReturnNullptrWithoutArena) {
+	TreeMap* tm{ createTestTree() };
+
+	ASSERT_EQ(nullptr, allocatePayload(nullptr, 8));
+	ASSERT_EQ(nullptr, allocatePayload(tm, 8));
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, allocatePayloadShouldBumpAllocateAlignedMemory) {
+	Status s;
+	TreeMap* tm{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeTreeNodePair, &s) };
+
+	s = createPayloadArena(tm, 32);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	char* first{ reinterpret_cast<char*>(allocatePayload(tm, 1)) };
+	char* second{ reinterpret_cast<char*>(allocatePayload(tm, 13)) };
+
+	ASSERT_NE(nullptr, first);
+	ASSERT_EQ(0, reinterpret_cast<size_t>(first) % 8);
+	ASSERT_EQ(first + 8, second);
+	ASSERT_EQ(24, tm->payloadArena->blockUsed);
+	ASSERT_EQ(24, tm->payloadArena->usedBytes);
+
+	std::memset(second, 0, 13);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, allocatePayloadShouldAllocateNewBlocks) {
+	Status s;
+	TreeMap* tm{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeTreeNodePair, &s) };
+
+	createPayloadArena(tm, 32);
+
+	allocatePayload(tm, 24);
+	void* firstBlock{ tm->payloadArena->blocks };
+
+	// Doesn't fit into the rest of the first block.
+	char* small{ reinterpret_cast<char*>(allocatePayload(tm, 16)) };
+
+	ASSERT_NE(nullptr, small);
+	ASSERT_NE(firstBlock, tm->payloadArena->blocks);
+	ASSERT_EQ(16, tm->payloadArena->blockUsed);
+
+	// Bigger than the block size of the arena.
+	char* big{ reinterpret_cast<char*>(allocatePayload(tm, 100)) };
+
+	ASSERT_NE(nullptr, big);
+	ASSERT_EQ(104, tm->payloadArena->blockUsed);
+	ASSERT_EQ(144, tm->payloadArena->usedBytes);
+
+	std::memset(big, 0, 100);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, putPairShouldCopyPayloadIntoArena) {
+	Status s;
+	TreeMap* tm{ createTestPayloadTree(64) };
+	TreeNodeKey* k{ createTreeNodeKey("Oregon") };
+	TreeNodeValue* v{ createTreeNodeValue("Salem", 1859, 4237256) };
+	TreeNodeValue result;
+
+	// Each state name and capital city is rounded up to a quadword.
+	ASSERT_EQ(112, tm->payloadArena->usedBytes);
+
+	s = getValue(tm, k, &result);
+
+	// The copy out of the treemap lies on the heap, not inside the arena.
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(112, tm->payloadArena->usedBytes);
+	assertTreeNodeValueEquals(v, &result);
+
+	free(result.capitalCity);
+	freeTreeNodeKeys({ k });
+	freeTreeNodeValues({ v });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, clearTreeMapShouldResetPayloadArena) {
+	Status s;
+	TreeMap* tm{ createTestPayloadTree(64) };
+	PayloadArena* arena{ tm->payloadArena };
+
+	s = clearTreeMap(tm);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(arena, tm->payloadArena);
+	ASSERT_EQ(nullptr, arena->blocks);
+	ASSERT_EQ(0, arena->blockUsed);
+	ASSERT_EQ(0, arena->usedBytes);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, compactPayloadArenaShouldReclaimDeletedPayload) {
+	Status s;
+	TreeMap* tm{ createTestPayloadTree(64) };
+	TreeNodeKey* washington{ createTreeNodeKey("Washington") };
+	TreeNodeKey* oregon{ createTreeNodeKey("Oregon") };
+	TreeNodeKey* kansas{ createTreeNodeKey("Kansas") };
+	TreeNodeValue* topeka{ createTreeNodeValue("Topeka", 1861, 2937880) };
+
+	deletePair(tm, washington, nullptr);
+	deletePair(tm, oregon, nullptr);
+
+	ASSERT_EQ(112, tm->payloadArena->usedBytes);
+
+	s = compactPayloadArena(tm, relocateTreeNodePair);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(72, tm->payloadArena->usedBytes);
+	ASSERT_EQ(72, tm->payloadArena->blockUsed);
+	ASSERT_EQ(nullptr, *reinterpret_cast<void**>(tm->payloadArena->blocks));
+	ASSERT_EQ(3, tm->nodeAmount);
+
+	TreeNodeValue result;
+
+	s = getValue(tm, kansas, &result);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(72, tm->payloadArena->usedBytes);
+	assertTreeNodeValueEquals(topeka, &result);
+
+	free(result.capitalCity);
+
+	freeTreeNodeKeys({ washington, oregon, kansas });
+	freeTreeNodeValues({ topeka });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, compactPayloadArenaShouldKeepOldBlocksIfRelocationFails) {
+	Status s;
+	TreeMap* tm{ createTestPayloadTree(64) };
+	TreeNodeKey* k{ createTreeNodeKey("Oregon") };
+	TreeNodeValue* v{ createTreeNodeValue("Salem", 1859, 4237256) };
+	TreeNodeValue result;
+
+	s = compactPayloadArena(tm, ::failRelocation);
+
+	ASSERT_EQ(Status::ERR_COPY_VALUE, s);
+	ASSERT_EQ(112, tm->payloadArena->usedBytes);
+
+	s = getValue(tm, k, &result);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(112, tm->payloadArena->usedBytes);
+	assertTreeNodeValueEquals(v, &result);
+
+	free(result.capitalCity);
+	freeTreeNodeKeys({ k });
+	freeTreeNodeValues({ v });
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, compactPayloadArenaShouldFailForNullptrs) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+
+	s = compactPayloadArena(nullptr, relocateTreeNodePair);
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, s);
+
+	s = compactPayloadArena(tm, relocateTreeNodePair);
+
+	ASSERT_EQ(Status::PAYLOAD_ARENA_NULLPTR, s);
+
+	deleteTreeMap(tm);
+
+	tm = createTestPayloadTree(64);
+
+	s = compactPayloadArena(tm, nullptr);
+
+	ASSERT_EQ(Status::RELOCATE_FUNC_NULLPTR, s);
+
+	deleteTreeMap(tm);
+}
@@ -0,0 +1,813 @@
+; @file tree_map_shared.asm
+;
+; Defines the shared treemaps. A shared treemap lives inside named shared memory that many
+; processes map, so a large treemap is held once per host instead of once per process.
+; One writer process publishes versions of a treemap and every other process reads them.
+;
+; The shared memory starts with a SharedHeader followed by two areas of the same size. Every area
+; holds the treenodes of one version in key order, linked through offsets from the start of the area
+; like the image of a mapped treemap. The sequence of the header works as a seqlock: the writer makes
+; it odd, fills the area that isn't active and makes it even again, which activates that area.
+; Readers never wait for the writer. They search the active area and only retry if the sequence
+; shows that the writer began to overwrite the area while they read it.
+;
+; @author Collector
+; @date 03/09/2023
+
+	include tree_map.inc
+
+	.code
+
+
+	public createSharedTreeMap
+
+; Creates the named shared memory of a shared treemap and maps it writable. The process
+; that creates it is the only writer, a second one can't create the same name.
+;
+; @RCX qword[in] - Name of the shared memory.
+; @RDX qword[in] - Size of a key.
+; @R8 qword[in] - Size of a value.
+; @R9 qword[in] - Maximum amount of pairs a published treemap can hold.
+; @STACK qword[in] - Pointer to the function that compares treenodes by their keys.
+; @STACK qword[out] - Pointer to a status code which is set to success if the shared treemap is created.
+;
+; @return The shared treemap or a nullptr. The status is set to fileNullptr, keySizeZero, valueSizeZero,
+;		  keyCompFuncNullptr, sharedCapacityExceeded if the memory would be too big, errFileIo if the name
+;		  is taken or the memory can't be mapped or errHeapAllocation. Without a status pointer the
+;		  function fails silently.
+createSharedTreeMap proc
+
+	push rbp
+	mov rbp, rsp
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	push r13
+	sub rsp, shadowStorage + 3 * qwordSize
+
+	mov rax, nullptr
+
+	; Check if a status pointer was given, otherwise fail silently.
+	mov rdi, [rbp + sharedStatusPtr]
+	cmp rdi, nullptr
+	je functionReturn
+
+	; Check if the name is a nullptr.
+	mov dword ptr [rdi], fileNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the key size is not zero.
+	mov dword ptr [rdi], keySizeZero
+	cmp rdx, 0
+	je functionReturn
+
+	; Check if the value size is not zero.
+	mov dword ptr [rdi], valueSizeZero
+	cmp r8, 0
+	je functionReturn
+
+	; Check if the key comparing function is a nullptr.
+	mov dword ptr [rdi], keyCompFuncNullptr
+	cmp qword ptr [rbp + sharedCompareFunc], nullptr
+	je functionReturn
+
+	; Save the name, the pair sizes and the capacity.
+	mov rbx, rcx
+	mov r12, rdx
+	mov r13, r8
+	mov [rbp + sharedNodeCapacity], r9
+
+	mov rcx, sizeof SharedTreeMap
+	call malloc
+
+	mov dword ptr [rdi], errHeapAllocation
+	cmp rax, nullptr
+	je functionReturn
+
+	; Nothing is mapped yet.
+	mov rsi, rax
+	mov [rsi].SharedTreeMap.base, nullptr
+	mov [rsi].SharedTreeMap.mappingHandle, nullptr
+	mov [rsi].SharedTreeMap.keySize, r12
+	mov [rsi].SharedTreeMap.valueSize, r13
+	mov rax, [rbp + sharedNodeCapacity]
+	mov [rsi].SharedTreeMap.nodeCapacity, rax
+	mov rax, [rbp + sharedCompareFunc]
+	mov [rsi].SharedTreeMap.compareKeyFunc, rax
+	mov [rsi].SharedTreeMap.writable, true
+
+	; Every treenode starts on a quadword boundary like inside a mapped image.
+	lea rax, [r12 + r13 + sizeof MappedTreeNode + qwordSize - 1]
+	and rax, -qwordSize
+	mov [rsi].SharedTreeMap.nodeStride, rax
+
+	; Both areas start on a cache line.
+	mov r12d, sharedCapacityExceeded
+	mul [rsi].SharedTreeMap.nodeCapacity
+	jc releaseSharedTreeMap
+
+	add rax, sizeof SharedArea + cacheLineSize - 1
+	jc releaseSharedTreeMap
+
+	and rax, -cacheLineSize
+	mov [rsi].SharedTreeMap.areaSize, rax
+
+	; The shared memory holds the header and both areas.
+	add rax, rax
+	jc releaseSharedTreeMap
+
+	add rax, sizeof SharedHeader
+	jc releaseSharedTreeMap
+
+	; The memory is backed by the paging file and split into a high and a low size.
+	mov r9, rax
+	shr r9, 32
+	mov eax, eax
+	mov rcx, invalidHandleValue
+	mov rdx, nullptr
+	mov r8d, pageReadWrite
+	mov [rsp + shadowStorage], rax
+	mov [rsp + shadowStorage + qwordSize], rbx
+	call CreateFileMappingA
+
+	mov r12d, errFileIo
+	cmp rax, nullptr
+	je releaseSharedTreeMap
+
+	mov [rsi].SharedTreeMap.mappingHandle, rax
+
+	; An existing memory of the name belongs to another writer.
+	call GetLastError
+
+	cmp eax, errorAlreadyExists
+	je releaseSharedTreeMap
+
+	mov rcx, [rsi].SharedTreeMap.mappingHandle
+	mov edx, fileMapWrite
+	mov r8d, 0
+	mov r9d, 0
+	mov qword ptr [rsp + shadowStorage], 0
+	call MapViewOfFile
+
+	cmp rax, nullptr
+	je releaseSharedTreeMap
+
+	mov [rsi].SharedTreeMap.base, rax
+
+	; New memory is zeroed, so both areas are empty and the sequence starts at zero.
+	mov rbx, rax
+	mov rax, sharedMagic
+	mov [rbx].SharedHeader.magic, rax
+	mov [rbx].SharedHeader.version, sharedVersion
+	mov rax, [rsi].SharedTreeMap.keySize
+	mov [rbx].SharedHeader.keySize, rax
+	mov rax, [rsi].SharedTreeMap.valueSize
+	mov [rbx].SharedHeader.valueSize, rax
+	mov rax, [rsi].SharedTreeMap.nodeStride
+	mov [rbx].SharedHeader.nodeStride, rax
+	mov rax, [rsi].SharedTreeMap.nodeCapacity
+	mov [rbx].SharedHeader.nodeCapacity, rax
+
+	; The checksum covers every field before it.
+	mov rcx, rbx
+	mov edx, sizeof SharedHeader - 2 * qwordSize
+	mov r8, fnvOffsetBasis
+	call hashSnapshotBytes
+
+	mov [rbx].SharedHeader.checksum, rax
+
+	mov dword ptr [rdi], success
+	mov rax, rsi
+
+	jmp functionReturn
+
+releaseSharedTreeMap:
+	; Close everything that was opened.
+	mov rcx, rsi
+	call closeSharedTreeMap
+
+	mov dword ptr [rdi], r12d
+	mov rax, nullptr
+
+functionReturn:
+	add rsp, shadowStorage + 3 * qwordSize
+	pop r13
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	pop rbp
+	ret
+
+createSharedTreeMap endp
+
+
+	public openSharedTreeMap
+
+; Maps the named shared memory of a shared treemap for reading.
+;
+; @RCX qword[in] - Name of the shared memory.
+; @RDX qword[in] - Pointer to the function that compares treenodes by their keys.
+; @R8 qword[out] - Pointer to a status code which is set to success if the shared treemap is mapped.
+;
+; @return The shared treemap or a nullptr. The status is set to fileNullptr, keyCompFuncNullptr,
+;		  errFileIo if the memory doesn't exist or can't be mapped, snapshotInvalid if it doesn't
+;		  belong to a shared treemap or errHeapAllocation. Without a status pointer the function fails silently.
+openSharedTreeMap proc
+
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	sub rsp, shadowStorage + qwordSize
+
+	mov rax, nullptr
+
+	; Check if a status pointer was given, otherwise fail silently.
+	cmp r8, nullptr
+	je functionReturn
+
+	mov rdi, r8
+
+	; Check if the name is a nullptr.
+	mov dword ptr [rdi], fileNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the key comparing function is a nullptr.
+	mov dword ptr [rdi], keyCompFuncNullptr
+	cmp rdx, nullptr
+	je functionReturn
+
+	; Save the name and the comparison function.
+	mov rbx, rcx
+	mov r12, rdx
+
+	mov rcx, sizeof SharedTreeMap
+	call malloc
+
+	mov dword ptr [rdi], errHeapAllocation
+	cmp rax, nullptr
+	je functionReturn
+
+	; Nothing is mapped yet.
+	mov rsi, rax
+	mov [rsi].SharedTreeMap.base, nullptr
+	mov [rsi].SharedTreeMap.mappingHandle, nullptr
+	mov [rsi].SharedTreeMap.compareKeyFunc, r12
+	mov [rsi].SharedTreeMap.writable, false
+
+	mov ecx, fileMapRead
+	mov edx, false
+	mov r8, rbx
+	call OpenFileMappingA
+
+	mov r12d, errFileIo
+	cmp rax, nullptr
+	je releaseSharedTreeMap
+
+	mov [rsi].SharedTreeMap.mappingHandle, rax
+
+	mov rcx, rax
+	mov edx, fileMapRead
+	mov r8d, 0
+	mov r9d, 0
+	mov qword ptr [rsp + shadowStorage], 0
+	call MapViewOfFile
+
+	cmp rax, nullptr
+	je releaseSharedTreeMap
+
+	mov [rsi].SharedTreeMap.base, rax
+
+	; Check the header of the shared memory.
+	mov rbx, rax
+	mov r12d, snapshotInvalid
+	mov rax, sharedMagic
+	cmp [rbx].SharedHeader.magic, rax
+	jne releaseSharedTreeMap
+
+	cmp [rbx].SharedHeader.version, sharedVersion
+	jne releaseSharedTreeMap
+
+	mov rcx, rbx
+	mov edx, sizeof SharedHeader - 2 * qwordSize
+	mov r8, fnvOffsetBasis
+	call hashSnapshotBytes
+
+	cmp [rbx].SharedHeader.checksum, rax
+	jne releaseSharedTreeMap
+
+	; A treenode holds the pair and its links.
+	mov rax, [rbx].SharedHeader.keySize
+	add rax, [rbx].SharedHeader.valueSize
+	add rax, sizeof MappedTreeNode
+	cmp [rbx].SharedHeader.nodeStride, rax
+	jb releaseSharedTreeMap
+
+	mov rax, [rbx].SharedHeader.keySize
+	mov [rsi].SharedTreeMap.keySize, rax
+	mov rax, [rbx].SharedHeader.valueSize
+	mov [rsi].SharedTreeMap.valueSize, rax
+	mov rax, [rbx].SharedHeader.nodeCapacity
+	mov [rsi].SharedTreeMap.nodeCapacity, rax
+	mov rax, [rbx].SharedHeader.nodeStride
+	mov [rsi].SharedTreeMap.nodeStride, rax
+
+	; Calculate the size of an area like the writer did.
+	mul [rsi].SharedTreeMap.nodeCapacity
+	jc releaseSharedTreeMap
+
+	add rax, sizeof SharedArea + cacheLineSize - 1
+	jc releaseSharedTreeMap
+
+	and rax, -cacheLineSize
+	mov [rsi].SharedTreeMap.areaSize, rax
+
+	mov dword ptr [rdi], success
+	mov rax, rsi
+
+	jmp functionReturn
+
+releaseSharedTreeMap:
+	; Close everything that was opened.
+	mov rcx, rsi
+	call closeSharedTreeMap
+
+	mov dword ptr [rdi], r12d
+	mov rax, nullptr
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+openSharedTreeMap endp
+
+
+	public closeSharedTreeMap
+
+; Unmaps the shared memory and frees the shared treemap. The memory
+; is released by the system once no process maps it anymore.
+;
+; @RCX qword[in,out] - Pointer to the shared treemap.
+;
+; @return A status value for success or treeMapNullptr.
+closeSharedTreeMap proc
+
+	push rsi
+	sub rsp, shadowStorage
+
+	; Check if the shared treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+
+	mov rcx, [rsi].SharedTreeMap.base
+	cmp rcx, nullptr
+	je closeMapping
+
+	call UnmapViewOfFile
+
+closeMapping:
+	mov rcx, [rsi].SharedTreeMap.mappingHandle
+	cmp rcx, nullptr
+	je freeSharedTreeMap
+
+	call CloseHandle
+
+freeSharedTreeMap:
+	mov rcx, rsi
+	call free
+
+	mov eax, success
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rsi
+	ret
+
+closeSharedTreeMap endp
+
+
+	public publishSharedTreeMap
+
+; Copies the treemap into the inactive area of the shared treemap and activates it.
+; Readers keep searching the previous version until the new one is complete.
+;
+; @RCX qword[in,out] - Pointer to the shared treemap that was created by this process.
+; @RDX qword[in,out] - Pointer to the treemap that is published.
+;
+; @return A status value for success, mappedReadOnly, inlineSizeMismatch for inline pairs,
+;		  valueDictionaryExists, snapshotInvalid if the pair sizes differ,
+;		  sharedCapacityExceeded or treeMapNullptr.
+publishSharedTreeMap proc
+
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	push r13
+	sub rsp, shadowStorage
+
+	; Check if the shared treemap or the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	cmp rdx, nullptr
+	je functionReturn
+
+	; Only the process that created the shared treemap writes it.
+	mov eax, mappedReadOnly
+	cmp [rcx].SharedTreeMap.writable, false
+	je functionReturn
+
+	; The pairs of inline treenodes and interned values point outside of the treenodes.
+	mov eax, inlineSizeMismatch
+	test [rdx].TreeMap.flags, inlinePairsFlag
+	jnz functionReturn
+
+	mov eax, valueDictionaryExists
+	cmp [rdx].TreeMap.valueDictionary, nullptr
+	jne functionReturn
+
+	; The pairs are copied byte by byte, so their sizes have to match.
+	mov eax, snapshotInvalid
+	mov r8, [rdx].TreeMap.keySize
+	cmp r8, [rcx].SharedTreeMap.keySize
+	jne functionReturn
+
+	mov r8, [rdx].TreeMap.valueSize
+	cmp r8, [rcx].SharedTreeMap.valueSize
+	jne functionReturn
+
+	mov eax, sharedCapacityExceeded
+	mov r8, [rdx].TreeMap.nodeAmount
+	cmp r8, [rcx].SharedTreeMap.nodeCapacity
+	ja functionReturn
+
+	; Save the shared treemap and the treemap.
+	mov rdi, rcx
+	mov rsi, rdx
+
+	; Spilled treenodes are faulted back in before the tree is copied.
+	mov rcx, rsi
+	call restoreSpilledTreeMap
+
+	cmp eax, success
+	jne functionReturn
+
+	; An odd sequence marks the area behind the active one as being filled.
+	mov rax, [rdi].SharedTreeMap.base
+	mov rbx, [rax].SharedHeader.sequence
+	inc rbx
+	mov [rax].SharedHeader.sequence, rbx
+
+	mov r12, rbx
+	shr r12, 1
+	inc r12
+	and r12, 1
+	imul r12, [rdi].SharedTreeMap.areaSize
+	add r12, rax
+	add r12, sizeof SharedHeader
+
+	; Copy the treenodes in key order behind the start of the area.
+	mov r13, [rdi].SharedTreeMap.nodeStride
+	mov rbx, sizeof SharedArea
+	mov rcx, [rsi].TreeMap.root
+	call copyMappedTreeNodes
+
+	mov [r12].SharedArea.root, rax
+	mov rax, [rsi].TreeMap.nodeAmount
+	mov [r12].SharedArea.nodeAmount, rax
+
+	; The even sequence activates the area. Stores aren't reordered on x64,
+	; so a reader that sees the sequence also sees the treenodes.
+	mov rax, [rdi].SharedTreeMap.base
+	inc [rax].SharedHeader.sequence
+
+	mov eax, success
+
+functionReturn:
+	add rsp, shadowStorage
+	pop r13
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+publishSharedTreeMap endp
+
+
+	public getSharedValue
+
+; Copies the value of the key out of the shared treemap.
+;
+; @RCX qword[in] - Pointer to the shared treemap.
+; @RDX qword[in] - Pointer to the key whose value is searched.
+; @R8 qword[out] - Pointer to the buffer that receives the value.
+;
+; @return A status value for success, doesNotContain, valueBufferNullptr or treeMapNullptr.
+getSharedValue proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov r9d, mappedSearchExact
+	call readSharedTreeNode
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+getSharedValue endp
+
+
+	public ceilingSharedPair
+
+; Copies the pair with the smallest key that is bigger or equal to the given key.
+;
+; @RCX qword[in] - Pointer to the shared treemap.
+; @RDX qword[in] - Pointer to the key.
+; @R8 qword[out] - Pointer to the buffer that receives the pair.
+;
+; @return A status value for success, doesNotContain, pairBufferNullptr or treeMapNullptr.
+ceilingSharedPair proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov r9d, mappedSearchCeiling
+	call readSharedTreeNode
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+ceilingSharedPair endp
+
+
+	public floorSharedPair
+
+; Copies the pair with the biggest key that is smaller or equal to the given key.
+;
+; @RCX qword[in] - Pointer to the shared treemap.
+; @RDX qword[in] - Pointer to the key.
+; @R8 qword[out] - Pointer to the buffer that receives the pair.
+;
+; @return A status value for success, doesNotContain, pairBufferNullptr or treeMapNullptr.
+floorSharedPair proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov r9d, mappedSearchFloor
+	call readSharedTreeNode
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+floorSharedPair endp
+
+
+	public higherSharedPair
+
+; Copies the pair with the smallest key that is bigger than the given key.
+;
+; @RCX qword[in] - Pointer to the shared treemap.
+; @RDX qword[in] - Pointer to the key.
+; @R8 qword[out] - Pointer to the buffer that receives the pair.
+;
+; @return A status value for success, doesNotContain, pairBufferNullptr or treeMapNullptr.
+higherSharedPair proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov r9d, mappedSearchHigher
+	call readSharedTreeNode
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+higherSharedPair endp
+
+
+	public lowerSharedPair
+
+; Copies the pair with the biggest key that is smaller than the given key.
+;
+; @RCX qword[in] - Pointer to the shared treemap.
+; @RDX qword[in] - Pointer to the key.
+; @R8 qword[out] - Pointer to the buffer that receives the pair.
+;
+; @return A status value for success, doesNotContain, pairBufferNullptr or treeMapNullptr.
+lowerSharedPair proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov r9d, mappedSearchLower
+	call readSharedTreeNode
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+lowerSharedPair endp
+
+
+; Searches the active area of the shared treemap like findMappedTreeNode and copies the result.
+; The area can be overwritten while it is read, so every offset is checked against the area and
+; the search stops after more steps than a valid tree has levels. The copy is only returned if
+; the sequence shows that the writer didn't start to fill the area meanwhile, otherwise the search
+; is repeated on the version that is active now.
+;
+; @RCX qword[in] - Pointer to the shared treemap.
+; @RDX qword[in] - Pointer to the searched key.
+; @R8 qword[out] - Pointer to the buffer that receives the value of an exact search or the pair.
+; @R9 qword[in] - Mode of the search, e.g. mappedSearchCeiling.
+;
+; @return A status value for success, doesNotContain, valueBufferNullptr, pairBufferNullptr,
+;		  snapshotInvalid if the shared memory is broken or treeMapNullptr.
+readSharedTreeNode proc
+
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	push r13
+	push r14
+	push r15
+	sub rsp, shadowStorage + 2 * qwordSize
+
+	; Check if the shared treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the buffer is a nullptr.
+	mov eax, valueBufferNullptr
+	test r9, searchExactBit
+	jnz checkBuffer
+
+	mov eax, pairBufferNullptr
+
+checkBuffer:
+	cmp r8, nullptr
+	je functionReturn
+
+	; Save the shared treemap, the key, the buffer and the mode.
+	mov rsi, rcx
+	mov rdi, rdx
+	mov r12, r8
+	mov r13, r9
+
+readVersion:
+	; The active area belongs to the last published version, also while the writer fills the other one.
+	mov rax, [rsi].SharedTreeMap.base
+	mov r14, [rax].SharedHeader.sequence
+	mov r15, r14
+	shr r15, 1
+	and r15, 1
+	imul r15, [rsi].SharedTreeMap.areaSize
+	add r15, rax
+	add r15, sizeof SharedHeader
+
+	; Start at the root without a candidate.
+	mov rbx, [r15].SharedArea.root
+	mov qword ptr [rsp + shadowStorage], nullptr
+	mov qword ptr [rsp + shadowStorage + qwordSize], 0
+
+searchLoop:
+	; The offset zero marks a missing child.
+	cmp rbx, 0
+	je searchFinished
+
+	; Every treenode has to lie inside the area.
+	cmp rbx, sizeof SharedArea
+	jb tornArea
+
+	mov rax, [rsi].SharedTreeMap.areaSize
+	sub rax, [rsi].SharedTreeMap.nodeStride
+	cmp rbx, rax
+	ja tornArea
+
+	inc qword ptr [rsp + shadowStorage + qwordSize]
+	cmp qword ptr [rsp + shadowStorage + qwordSize], maxSharedDepth
+	ja tornArea
+
+	add rbx, r15
+	mov rcx, rbx
+	mov rdx, rdi
+	callUserFunc [rsi].SharedTreeMap.compareKeyFunc
+
+	; An equal key is the result of every inclusive search.
+	cmp eax, 0
+	jne chooseChild
+
+	test r13, searchInclusiveBit
+	jz chooseChild
+
+	mov [rsp + shadowStorage], rbx
+
+	jmp searchFinished
+
+chooseChild:
+	; Move to the links of the treenode.
+	mov rcx, rbx
+	add rcx, [rsi].SharedTreeMap.keySize
+	add rcx, [rsi].SharedTreeMap.valueSize
+
+	test r13, searchHigherBit
+	jz searchLower
+
+	; A bigger key is a candidate for a higher key, a smaller or equal one isn't.
+	cmp eax, 0
+	jge takeRightChild
+
+	jmp takeCandidate
+
+searchLower:
+	; A smaller key is a candidate for a lower key, a bigger or equal one isn't.
+	cmp eax, 0
+	jle takeLeftChild
+
+takeCandidate:
+	test r13, searchExactBit
+	jnz chooseCandidateChild
+
+	mov [rsp + shadowStorage], rbx
+
+chooseCandidateChild:
+	; Search closer to the key behind the candidate.
+	test r13, searchHigherBit
+	jz takeRightChild
+
+takeLeftChild:
+	mov rbx, [rcx].MappedTreeNode.left
+
+	jmp searchLoop
+
+takeRightChild:
+	mov rbx, [rcx].MappedTreeNode.right
+
+	jmp searchLoop
+
+searchFinished:
+	mov rdx, [rsp + shadowStorage]
+	mov ebx, doesNotContain
+	cmp rdx, nullptr
+	je checkVersion
+
+	; The exact search copies the value, the others copy the whole pair.
+	mov rcx, r12
+	mov r8, [rsi].SharedTreeMap.valueSize
+	test r13, searchExactBit
+	jz copyWholePair
+
+	add rdx, [rsi].SharedTreeMap.keySize
+
+	jmp copyTreeNode
+
+copyWholePair:
+	add r8, [rsi].SharedTreeMap.keySize
+
+copyTreeNode:
+	call memcpy
+
+	mov ebx, success
+
+	jmp checkVersion
+
+tornArea:
+	; Only an area that was overwritten while it was read is retried.
+	mov ebx, snapshotInvalid
+
+checkVersion:
+	; Loads aren't reordered on x64, so the sequence is read after the treenodes. The area
+	; was read completely if the writer didn't make the sequence odd for the version after the next.
+	mov rax, [rsi].SharedTreeMap.base
+	mov rax, [rax].SharedHeader.sequence
+	and r14, -2
+	sub rax, r14
+	cmp rax, sharedSequenceDistance
+	jae readVersion
+
+	mov eax, ebx
+
+functionReturn:
+	add rsp, shadowStorage + 2 * qwordSize
+	pop r15
+	pop r14
+	pop r13
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+readSharedTreeNode endp
+
+end
@@ -0,0 +1,315 @@
+/*
+* @file tree_map_shared_test.h
+*
+* Defines unit tests for the shared treemaps of the tree map
+* implementation.
+*
+* @author Collector
+* @data 03/09/2023
+*/
+
+
+#include <thread>
+#include <atomic>
+
+#include "utils.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	/*
+	* Name of the shared memory that the tests create.
+	*/
+	const char* const sharedName{ "tree_map_shared_test" };
+
+	/*
+	* Amount of versions the writer publishes while the reader searches.
+	*/
+	constexpr size_t VERSION_AMOUNT{ 200 };
+
+	/*
+	* Creates the shared treemap and opens it a second time like a reading process.
+	*
+	* @param[in] nodeCapacity - Maximum amount of pairs of a version.
+	* @param[out] reader - Shared treemap that is opened for reading.
+	*
+	* @return The shared treemap of the writer.
+	*/
+	SharedTreeMap* createWriterAndReader(size_t nodeCapacity, SharedTreeMap** reader) {
+		Status s;
+		SharedTreeMap* writer{ createSharedTreeMap(sharedName, sizeof(size_t), sizeof(size_t), nodeCapacity,
+			compareNumberKey, &s) };
+
+		EXPECT_EQ(Status::SUCCESS, s);
+
+		*reader = openSharedTreeMap(sharedName, compareNumberKey, &s);
+
+		EXPECT_EQ(Status::SUCCESS, s);
+
+		return writer;
+	}
+
+	/*
+	* Searches every key of the versions the writer publishes until it is done. Every version
+	* holds the keys below 1000 whose values carry the key in their last three digits.
+	*
+	* @param[in] reader - Shared treemap that is searched.
+	* @param[in] done - Indicator that the writer published its last version.
+	* @param[out] mismatches - Count of the searches that failed or returned a value of another key.
+	*/
+	void readPublishedVersions(const SharedTreeMap* reader, const std::atomic<bool>* done, size_t* mismatches) {
+		while (!done->load()) {
+			for (size_t key{ 0 }; key < 1000; key++) {
+				size_t value{ 0 };
+
+				if (getSharedValue(reader, &key, &value) != Status::SUCCESS || value % 1000 != key) {
+					(*mismatches)++;
+				}
+			}
+		}
+	}
+}
+
+TEST(TreeMap, createSharedTreeMapShouldFailForInvalidParameters) {
+	Status s;
+	SharedTreeMap* stm{ createSharedTreeMap(nullptr, sizeof(size_t), sizeof(size_t), 10, compareNumberKey, &s) };
+
+	ASSERT_EQ(nullptr, stm);
+	ASSERT_EQ(Status::FILE_NULLPTR, s);
+
+	stm = createSharedTreeMap(sharedName, 0, sizeof(size_t), 10, compareNumberKey, &s);
+
+	ASSERT_EQ(nullptr, stm);
+	ASSERT_EQ(Status::KEY_SIZE_ZERO, s);
+
+	stm = createSharedTreeMap(sharedName, sizeof(size_t), sizeof(size_t), 10, nullptr, &s);
+
+	ASSERT_EQ(nullptr, stm);
+	ASSERT_EQ(Status::KEY_COMP_FUNC_NULLPTR, s);
+
+	// Both areas together wouldn't fit into the address space.
+	stm = createSharedTreeMap(sharedName, sizeof(size_t), sizeof(size_t), SIZE_MAX / 8, compareNumberKey, &s);
+
+	ASSERT_EQ(nullptr, stm);
+	ASSERT_EQ(Status::SHARED_CAPACITY_EXCEEDED, s);
+}
+
+TEST(TreeMap, createSharedTreeMapShouldRejectTakenName) {
+	Status s;
+	SharedTreeMap* reader{ nullptr };
+	SharedTreeMap* writer{ createWriterAndReader(10, &reader) };
+	SharedTreeMap* secondWriter{ createSharedTreeMap(sharedName, sizeof(size_t), sizeof(size_t), 10,
+		compareNumberKey, &s) };
+
+	ASSERT_EQ(nullptr, secondWriter);
+	ASSERT_EQ(Status::ERR_FILE_IO, s);
+
+	closeSharedTreeMap(reader);
+	closeSharedTreeMap(writer);
+}
+
+#ifndef _WIN32
+TEST(TreeMap, createSharedTreeMapShouldReplaceStaleMemory) {
+	Status s;
+
+	// Memory of a writer that crashed stays behind on linux, but no handle holds its lock.
+	int descriptor{ shm_open("/tree_map_shared_test", O_RDWR | O_CREAT | O_EXCL, 0600) };
+
+	ASSERT_LE(0, descriptor);
+	ASSERT_EQ(0, ftruncate(descriptor, 4096));
+
+	close(descriptor);
+
+	SharedTreeMap* writer{ createSharedTreeMap(sharedName, sizeof(size_t), sizeof(size_t), 10,
+		compareNumberKey, &s) };
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_NE(nullptr, writer);
+
+	closeSharedTreeMap(writer);
+
+	descriptor = shm_open("/tree_map_shared_test", O_RDONLY, 0600);
+
+	ASSERT_GT(0, descriptor);
+	ASSERT_EQ(ENOENT, errno);
+}
+#endif
+
+TEST(TreeMap, openSharedTreeMapShouldFailForMissingMemory) {
+	Status s;
+	SharedTreeMap* stm{ openSharedTreeMap("tree_map_missing_shared", compareNumberKey, &s) };
+
+	ASSERT_EQ(nullptr, stm);
+	ASSERT_EQ(Status::ERR_FILE_IO, s);
+}
+
+TEST(TreeMap, getSharedValueShouldFindPublishedPairs) {
+	Status s;
+	SharedTreeMap* reader{ nullptr };
+	SharedTreeMap* writer{ createWriterAndReader(1000, &reader) };
+	TreeMap* tm{ createTestNumberTree(1000, 1) };
+	size_t key{ 7 }, value{ 0 };
+
+	// Nothing is published yet.
+	s = getSharedValue(reader, &key, &value);
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+
+	s = publishSharedTreeMap(writer, tm);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	for (key = 0; key < 1000; key++) {
+		s = getSharedValue(reader, &key, &value);
+
+		ASSERT_EQ(Status::SUCCESS, s);
+		ASSERT_EQ(key * key, value);
+	}
+
+	// The next version replaces the previous one.
+	key = 500;
+	deletePair(tm, &key, nullptr);
+
+	s = publishSharedTreeMap(writer, tm);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	s = getSharedValue(reader, &key, &value);
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+
+	key = 501;
+	s = getSharedValue(reader, &key, &value);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(501 * 501, value);
+
+	closeSharedTreeMap(reader);
+	closeSharedTreeMap(writer);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, sharedPairSearchesShouldFindNeighbours) {
+	Status s;
+	SharedTreeMap* reader{ nullptr };
+	SharedTreeMap* writer{ createWriterAndReader(100, &reader) };
+	TreeMap* tm{ createTestNumberTree(100, 2) };
+	size_t evenKey{ 40 }, oddKey{ 41 }, tooBigKey{ 199 };
+	size_t pair[2]{};
+
+	publishSharedTreeMap(writer, tm);
+
+	s = ceilingSharedPair(reader, &oddKey, pair);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(42, pair[0]);
+	ASSERT_EQ(42 * 42, pair[1]);
+
+	floorSharedPair(reader, &oddKey, pair);
+
+	ASSERT_EQ(40, pair[0]);
+
+	higherSharedPair(reader, &evenKey, pair);
+
+	ASSERT_EQ(42, pair[0]);
+
+	lowerSharedPair(reader, &evenKey, pair);
+
+	ASSERT_EQ(38, pair[0]);
+
+	s = ceilingSharedPair(reader, &tooBigKey, pair);
+
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+
+	s = ceilingSharedPair(reader, &evenKey, nullptr);
+
+	ASSERT_EQ(Status::PAIR_BUFFER_NULLPTR, s);
+
+	closeSharedTreeMap(reader);
+	closeSharedTreeMap(writer);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, publishSharedTreeMapShouldCheckTheTreeMap) {
+	Status s;
+	SharedTreeMap* reader{ nullptr };
+	SharedTreeMap* writer{ createWriterAndReader(10, &reader) };
+	TreeMap* tm{ createTestNumberTree(10, 1) };
+	TreeMap* tooBig{ createTestNumberTree(11, 1) };
+	TreeMap* states{ createTestTree() };
+
+	// Only the writer publishes versions.
+	s = publishSharedTreeMap(reader, tm);
+
+	ASSERT_EQ(Status::MAPPED_READ_ONLY, s);
+
+	s = publishSharedTreeMap(writer, tooBig);
+
+	ASSERT_EQ(Status::SHARED_CAPACITY_EXCEEDED, s);
+
+	s = publishSharedTreeMap(writer, states);
+
+	ASSERT_EQ(Status::SNAPSHOT_INVALID, s);
+
+	s = publishSharedTreeMap(writer, tm);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	closeSharedTreeMap(reader);
+	closeSharedTreeMap(writer);
+	deleteTreeMap(states);
+	deleteTreeMap(tooBig);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, sharedTreeMapReadersShouldSeeCompleteVersions) {
+	Status s;
+	SharedTreeMap* reader{ nullptr };
+	SharedTreeMap* writer{ createWriterAndReader(1000, &reader) };
+	TreeMap* tm{ createTestNumberTree(1000, 1) };
+	std::atomic<bool> done{ false };
+	size_t mismatches{ 0 };
+
+	// Every version carries its number above the key.
+	for (size_t key{ 0 }; key < 1000; key++) {
+		size_t value{ key };
+
+		replaceValue(tm, &key, &value);
+	}
+
+	publishSharedTreeMap(writer, tm);
+
+	std::thread readerThread{ readPublishedVersions, reader, &done, &mismatches };
+
+	for (size_t version{ 1 }; version <= VERSION_AMOUNT; version++) {
+		for (size_t key{ 0 }; key < 1000; key++) {
+			size_t value{ version * 1000 + key };
+
+			replaceValue(tm, &key, &value);
+		}
+
+		// The reader thread has to be joined, so the loop doesn't return early.
+		s = publishSharedTreeMap(writer, tm);
+
+		EXPECT_EQ(Status::SUCCESS, s);
+	}
+
+	done.store(true);
+	readerThread.join();
+
+	ASSERT_EQ(0, mismatches);
+
+	size_t key{ 999 }, value{ 0 };
+
+	getSharedValue(reader, &key, &value);
+
+	ASSERT_EQ(VERSION_AMOUNT * 1000 + 999, value);
+
+	closeSharedTreeMap(reader);
+	closeSharedTreeMap(writer);
+	deleteTreeMap(tm);
+}
@@ -0,0 +1,1100 @@
+; @file tree_map_snapshot.asm
+;
+; Defines the snapshot functions of a treemap. A snapshot stores the pairs in key order
+; inside a versioned binary format, so that a treemap can be saved and loaded again without
+; inserting every pair. The file is written and read through a large buffer and the loaded
+; tree is built bottom up in linear time without any rotation.
+;
+; A snapshot starts with a SnapshotHeader, followed by the records of the pairs in key order
+; and a trailer. Every record is its size as a quadword followed by its bytes. The header and the
+; records are protected by FNV-1a checksums, the one of the records is the trailer.
+;
+; @author Collector
+; @date 03/09/2023
+
+	include tree_map.inc
+
+	.code
+
+
+	public saveTreeMap
+
+; Writes the pairs of the treemap in key order into the file. Without a serialize function
+; the bytes of the pairs are written as they are, otherwise the function turns every pair
+; into a record of at most the given size.
+;
+; @RCX qword[in,out] - Pointer to the treemap that is saved.
+; @RDX qword[in,out] - FILE pointer the snapshot is written to.
+; @R8 qword[in] - SerializePair function or a nullptr for the raw bytes of the pairs.
+; @R9 qword[in] - Maximum size of a record in bytes. It is ignored without a serialize function.
+;
+; @return A status value for success, fileNullptr, inlineSizeMismatch for inline pairs,
+;		  valueDictionaryExists, errSerializePair, errFileIo, errHeapAllocation or treeMapNullptr.
+saveTreeMap proc
+
+	push rsi
+	push rdi
+	push r12
+	sub rsp, shadowStorage
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the file is a nullptr.
+	mov eax, fileNullptr
+	cmp rdx, nullptr
+	je functionReturn
+
+	; The pairs of inline treenodes and interned values point outside of the treenodes.
+	mov eax, inlineSizeMismatch
+	test [rcx].TreeMap.flags, inlinePairsFlag
+	jnz functionReturn
+
+	mov eax, valueDictionaryExists
+	cmp [rcx].TreeMap.valueDictionary, nullptr
+	jne functionReturn
+
+	; Spilled treenodes are faulted back in before the tree is walked.
+	call restoreSpilledTreeMap
+
+	cmp eax, success
+	jne functionReturn
+
+	; Save the treemap and open the stream.
+	mov rsi, rcx
+	mov rcx, rdx
+	mov rdx, r8
+	mov r8, r9
+	call openSnapshotStream
+
+	cmp eax, success
+	jne functionReturn
+
+	call writeSnapshotHeader
+
+	; Write the records in key order.
+	mov edi, success
+	mov rcx, [rsi].TreeMap.root
+	call saveTreeNodes
+
+	cmp edi, success
+	jne closeStream
+
+	call writeSnapshotTrailer
+
+	mov edi, eax
+
+closeStream:
+	call closeSnapshotStream
+
+	mov eax, edi
+
+functionReturn:
+	add rsp, shadowStorage
+	pop r12
+	pop rdi
+	pop rsi
+	ret
+
+saveTreeMap endp
+
+
+; Writes the records of the subtree in key order.
+; Stops as soon as the status isn't a success anymore.
+;
+; @RCX qword[in] - Pointer to the current treenode.
+; @RSI qword[in] - Pointer to the treemap that is saved.
+; @RDI dword[in,out] - Status of the save.
+; @R12 qword[in,out] - Pointer to the snapshot stream.
+saveTreeNodes proc
+
+	push rbp
+	mov rbp, rsp
+	sub rsp, shadowStorage
+
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Save the current treenode.
+	mov [rbp + currentTreeNode], rcx
+
+	; Write the left subtree.
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rcx, [rcx].TreeNode.left
+	call saveTreeNodes
+
+	cmp edi, success
+	jne functionReturn
+
+	mov rcx, [rbp + currentTreeNode]
+	call writeSnapshotRecord
+
+	mov edi, eax
+	cmp edi, success
+	jne functionReturn
+
+	; Write the right subtree.
+	mov rcx, [rbp + currentTreeNode]
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rcx, [rcx].TreeNode.right
+	call saveTreeNodes
+
+functionReturn:
+	mov rsp, rbp
+	pop rbp
+	ret
+
+saveTreeNodes endp
+
+
+; Writes the header of the snapshot into the empty buffer of the stream.
+; The amount of pairs is the current one of the treemap.
+;
+; @RSI qword[in] - Pointer to the treemap that is saved.
+; @R12 qword[in,out] - Pointer to the snapshot stream.
+writeSnapshotHeader proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	; The header is the first part of the empty buffer.
+	mov rcx, [r12].SnapshotStream.buffer
+	mov rax, snapshotMagic
+	mov [rcx].SnapshotHeader.magic, rax
+	mov [rcx].SnapshotHeader.version, snapshotVersion
+	mov rax, [rsi].TreeMap.keySize
+	mov [rcx].SnapshotHeader.keySize, rax
+	mov rax, [rsi].TreeMap.valueSize
+	mov [rcx].SnapshotHeader.valueSize, rax
+	mov rax, [rsi].TreeMap.nodeAmount
+	mov [rcx].SnapshotHeader.pairAmount, rax
+	mov rax, [r12].SnapshotStream.maxRecordSize
+	mov [rcx].SnapshotHeader.maxRecordSize, rax
+
+	; The checksum of the header covers every field before it.
+	mov edx, sizeof SnapshotHeader - qwordSize
+	mov r8, fnvOffsetBasis
+	call hashSnapshotBytes
+
+	mov rcx, [r12].SnapshotStream.buffer
+	mov [rcx].SnapshotHeader.checksum, rax
+	mov [r12].SnapshotStream.position, sizeof SnapshotHeader
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+writeSnapshotHeader endp
+
+
+; Writes the pair as the next record. Without a serialize function the record is the pair itself.
+;
+; @RCX qword[in] - Pointer to the pair that is written.
+; @RSI qword[in] - Pointer to the treemap that is saved.
+; @R12 qword[in,out] - Pointer to the snapshot stream.
+;
+; @return A status value for success, errSerializePair or errFileIo.
+writeSnapshotRecord proc
+
+	push rbp
+	mov rbp, rsp
+	sub rsp, shadowStorage + 2 * qwordSize
+
+	cmp [r12].SnapshotStream.pairFunc, nullptr
+	jne serializePair
+
+	; The record is the pair itself.
+	mov rax, [rsi].TreeMap.keySize
+	add rax, [rsi].TreeMap.valueSize
+	mov [rbp + recordSize], rax
+	mov [rbp + recordBytes], rcx
+
+	jmp writeRecord
+
+serializePair:
+	mov rdx, rcx
+	mov rcx, [r12].SnapshotStream.record
+	callUserFunc [r12].SnapshotStream.pairFunc
+
+	; An empty or too big record is an error of the serialize function.
+	cmp rax, 0
+	je serializeError
+
+	cmp rax, [r12].SnapshotStream.maxRecordSize
+	ja serializeError
+
+	mov [rbp + recordSize], rax
+	mov rax, [r12].SnapshotStream.record
+	mov [rbp + recordBytes], rax
+
+writeRecord:
+	; Write the size of the record and its bytes.
+	lea rcx, [rbp + recordSize]
+	mov edx, qwordSize
+	call writeSnapshotBytes
+
+	cmp eax, success
+	jne functionReturn
+
+	mov rcx, [rbp + recordBytes]
+	mov rdx, [rbp + recordSize]
+	call writeSnapshotBytes
+
+	jmp functionReturn
+
+serializeError:
+	mov eax, errSerializePair
+
+functionReturn:
+	mov rsp, rbp
+	pop rbp
+	ret
+
+writeSnapshotRecord endp
+
+
+; Writes the checksum of the records as the trailer and flushes the rest of the buffer.
+;
+; @R12 qword[in,out] - Pointer to the snapshot stream.
+;
+; @return A status value for success or errFileIo.
+writeSnapshotTrailer proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	; The checksum of the records is the trailer.
+	mov rax, [r12].SnapshotStream.checksum
+	mov [r12].SnapshotStream.trailer, rax
+	lea rcx, [r12].SnapshotStream.trailer
+	mov edx, qwordSize
+	call writeSnapshotBytes
+
+	cmp eax, success
+	jne functionReturn
+
+	; Write the rest of the buffer.
+	call flushSnapshotStream
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	ret
+
+writeSnapshotTrailer endp
+
+
+	public loadTreeMap
+
+; Reads a snapshot into the empty treemap. The records are read sequentially and
+; the tree is built bottom up as a valid left leaning red black tree in linear time.
+; Without a deserialize function the records are copied into the treenodes as they are,
+; otherwise the function turns every record into the pair of a treenode.
+; If loading fails every loaded pair is freed again and the treemap is cleared.
+;
+; @RCX qword[in,out] - Pointer to the empty treemap that is loaded.
+; @RDX qword[in,out] - FILE pointer the snapshot is read from.
+; @R8 qword[in] - DeserializePair function or a nullptr for the raw bytes of the pairs.
+;
+; @return A status value for success, fileNullptr, treeMapNotEmpty, inlineSizeMismatch for inline pairs,
+;		  valueDictionaryExists, snapshotInvalid if the file isn't a snapshot of a treemap with the same
+;		  key and value sizes or its checksums don't match, the errors of the deserialize function,
+;		  errHeapAllocation or treeMapNullptr.
+loadTreeMap proc
+
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the file is a nullptr.
+	mov eax, fileNullptr
+	cmp rdx, nullptr
+	je functionReturn
+
+	; Check if the treemap is empty.
+	mov eax, treeMapNotEmpty
+	cmp [rcx].TreeMap.nodeAmount, 0
+	jne functionReturn
+
+	; The pairs of inline treenodes and interned values point outside of the treenodes.
+	mov eax, inlineSizeMismatch
+	test [rcx].TreeMap.flags, inlinePairsFlag
+	jnz functionReturn
+
+	mov eax, valueDictionaryExists
+	cmp [rcx].TreeMap.valueDictionary, nullptr
+	jne functionReturn
+
+	; Save the treemap and open the stream, the record buffer is allocated with the header.
+	mov rsi, rcx
+	mov rcx, rdx
+	mov rdx, r8
+	mov r8, 0
+	call openSnapshotStream
+
+	cmp eax, success
+	jne functionReturn
+
+	; The header has to be complete.
+	mov edi, snapshotInvalid
+	call fillSnapshotStream
+
+	cmp [r12].SnapshotStream.filled, sizeof SnapshotHeader
+	jb closeStream
+
+	mov rbx, [r12].SnapshotStream.buffer
+	mov rax, snapshotMagic
+	cmp [rbx].SnapshotHeader.magic, rax
+	jne closeStream
+
+	cmp [rbx].SnapshotHeader.version, snapshotVersion
+	jne closeStream
+
+	mov rcx, rbx
+	mov edx, sizeof SnapshotHeader - qwordSize
+	mov r8, fnvOffsetBasis
+	call hashSnapshotBytes
+
+	cmp [rbx].SnapshotHeader.checksum, rax
+	jne closeStream
+
+	; The treemap has to store pairs of the same size.
+	mov rax, [rsi].TreeMap.keySize
+	cmp [rbx].SnapshotHeader.keySize, rax
+	jne closeStream
+
+	mov rax, [rsi].TreeMap.valueSize
+	cmp [rbx].SnapshotHeader.valueSize, rax
+	jne closeStream
+
+	mov rcx, [rbx].SnapshotHeader.maxRecordSize
+	cmp rcx, 0
+	je closeStream
+
+	mov [r12].SnapshotStream.maxRecordSize, rcx
+	mov [r12].SnapshotStream.position, sizeof SnapshotHeader
+
+	; The buffer is refilled while reading the records, so the amount is saved.
+	mov rbx, [rbx].SnapshotHeader.pairAmount
+
+	cmp [r12].SnapshotStream.pairFunc, nullptr
+	je buildTree
+
+	mov edi, errHeapAllocation
+	call malloc
+
+	cmp rax, nullptr
+	je closeStream
+
+	mov [r12].SnapshotStream.record, rax
+
+buildTree:
+	; A tree of height h has at least 2^h - 1 pairs in its 2-nodes, so the
+	; height is the floor of log2(n + 1). The children of the root are one level lower.
+	lea rcx, [rbx + 1]
+	bsr rcx, rcx
+	mov edx, 1
+	shl rdx, cl
+	shr rdx, 1
+	dec rdx
+
+	mov edi, success
+	mov rcx, rbx
+	call buildSnapshotTree
+
+	cmp edi, success
+	jne clearTree
+
+	mov [rsi].TreeMap.root, rax
+
+	; The subtree hashes are summed up once the tree is complete.
+	cmp [rsi].TreeMap.hashPairFunc, nullptr
+	je readTrailer
+
+	mov rcx, rax
+	call hashTreeNodes
+
+readTrailer:
+	; The trailer has to match the checksum of the records.
+	mov rbx, [r12].SnapshotStream.checksum
+	lea rcx, [r12].SnapshotStream.trailer
+	mov edx, qwordSize
+	call readSnapshotBytes
+
+	mov edi, eax
+	cmp edi, success
+	jne clearTree
+
+	cmp [r12].SnapshotStream.trailer, rbx
+	je closeStream
+
+	mov edi, snapshotInvalid
+
+clearTree:
+	; Release everything the loaded pairs allocated.
+	mov rcx, rsi
+	call clearTreeMap
+
+closeStream:
+	call closeSnapshotStream
+
+	mov eax, edi
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+loadTreeMap endp
+
+
+; Builds a subtree out of the next records. The subtree is built like a 2-3 tree of the given
+; height with all leaves on the same level, so every 2-node is a black treenode and every 3-node
+; is a black treenode with a red left child. A 3-node is used as long as the children can still
+; be filled, so the pairs are spread evenly and the treenodes are read strictly in key order.
+; On an error the treenodes of the subtree are freed.
+;
+; @RCX qword[in] - Amount of pairs inside the subtree.
+; @RDX qword[in] - Minimum amount of pairs inside a child subtree.
+; @RSI qword[in,out] - Pointer to the treemap that is loaded.
+; @RDI dword[in,out] - Status of the load.
+; @R12 qword[in,out] - Pointer to the snapshot stream.
+;
+; @return The root of the subtree or a nullptr.
+buildSnapshotTree proc
+
+	push rbp
+	mov rbp, rsp
+	sub rsp, shadowStorage + 2 * qwordSize
+
+	mov eax, nullptr
+	cmp rcx, 0
+	je functionReturn
+
+	; Save the amounts, the subtrees are linked as soon as their parent exists.
+	mov [rbp + subtreeAmount], rcx
+	mov [rbp + childAmount], rdx
+	mov qword ptr [rbp + leftSubtree], nullptr
+	mov qword ptr [rbp + redTreeNode], nullptr
+	mov qword ptr [rbp + blackTreeNode], nullptr
+
+	; A 3-node needs three children with at least the minimum amount.
+	cmp rcx, 2
+	jb buildTwoNode
+
+	lea rax, [rdx + rdx * 2]
+	sub rcx, 2
+	cmp rcx, rax
+	jb buildTwoNode
+
+	; The left child gets the biggest third of the pairs.
+	mov rax, [rbp + subtreeAmount]
+	mov edx, 0
+	mov ecx, 3
+	div rcx
+
+	mov rcx, rax
+	mov rdx, [rbp + childAmount]
+	shr rdx, 1
+	call buildSnapshotTree
+
+	mov [rbp + leftSubtree], rax
+	cmp edi, success
+	jne buildError
+
+	; The red treenode holds the left child.
+	call readSnapshotTreeNode
+
+	cmp edi, success
+	jne buildError
+
+	mov [rbp + redTreeNode], rax
+	add rax, [rsi].TreeMap.keySize
+	add rax, [rsi].TreeMap.valueSize
+	mov rcx, [rbp + leftSubtree]
+	mov [rax].TreeNode.left, rcx
+	mov [rax].TreeNode.isRed, true
+	mov qword ptr [rbp + leftSubtree], nullptr
+
+	; The middle child is the right child of the red treenode.
+	mov rax, [rbp + subtreeAmount]
+	dec rax
+	mov edx, 0
+	mov ecx, 3
+	div rcx
+
+	mov rcx, rax
+	mov rdx, [rbp + childAmount]
+	shr rdx, 1
+	call buildSnapshotTree
+
+	mov rcx, [rbp + redTreeNode]
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov [rcx].TreeNode.right, rax
+	cmp edi, success
+	jne buildError
+
+	; The black treenode holds the red one.
+	call readSnapshotTreeNode
+
+	cmp edi, success
+	jne buildError
+
+	mov [rbp + blackTreeNode], rax
+	add rax, [rsi].TreeMap.keySize
+	add rax, [rsi].TreeMap.valueSize
+	mov rcx, [rbp + redTreeNode]
+	mov [rax].TreeNode.left, rcx
+	mov qword ptr [rbp + redTreeNode], nullptr
+
+	; The right child gets the smallest third of the pairs.
+	mov rax, [rbp + subtreeAmount]
+	sub rax, 2
+	mov edx, 0
+	mov ecx, 3
+	div rcx
+
+	jmp buildRightChild
+
+buildTwoNode:
+	; The left child gets the bigger half of the pairs.
+	mov rcx, [rbp + subtreeAmount]
+	dec rcx
+	mov rax, rcx
+	shr rax, 1
+	sub rcx, rax
+	mov rdx, [rbp + childAmount]
+	shr rdx, 1
+	call buildSnapshotTree
+
+	mov [rbp + leftSubtree], rax
+	cmp edi, success
+	jne buildError
+
+	call readSnapshotTreeNode
+
+	cmp edi, success
+	jne buildError
+
+	mov [rbp + blackTreeNode], rax
+	add rax, [rsi].TreeMap.keySize
+	add rax, [rsi].TreeMap.valueSize
+	mov rcx, [rbp + leftSubtree]
+	mov [rax].TreeNode.left, rcx
+	mov qword ptr [rbp + leftSubtree], nullptr
+
+	mov rax, [rbp + subtreeAmount]
+	dec rax
+	shr rax, 1
+
+buildRightChild:
+	mov rcx, rax
+	mov rdx, [rbp + childAmount]
+	shr rdx, 1
+	call buildSnapshotTree
+
+	mov rcx, [rbp + blackTreeNode]
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov [rcx].TreeNode.right, rax
+	cmp edi, success
+	jne buildError
+
+	mov rax, [rbp + blackTreeNode]
+
+	jmp functionReturn
+
+buildError:
+	; Free the parts of the subtree that were built, the failed child freed its own.
+	mov rcx, [rbp + leftSubtree]
+	call freeTreeNodes
+
+	mov rcx, [rbp + redTreeNode]
+	call freeTreeNodes
+
+	mov rcx, [rbp + blackTreeNode]
+	call freeTreeNodes
+
+	mov eax, nullptr
+
+functionReturn:
+	mov rsp, rbp
+	pop rbp
+	ret
+
+buildSnapshotTree endp
+
+
+; Reads the next record into a new black treenode without children.
+;
+; @RSI qword[in,out] - Pointer to the treemap that is loaded.
+; @RDI dword[out] - Status of the load if the record can't be read.
+; @R12 qword[in,out] - Pointer to the snapshot stream.
+;
+; @return The treenode or a nullptr.
+readSnapshotTreeNode proc
+
+	push rbp
+	mov rbp, rsp
+	sub rsp, shadowStorage + 2 * qwordSize
+
+	; Read the size of the record.
+	lea rcx, [rbp + recordSize]
+	mov edx, qwordSize
+	call readSnapshotBytes
+
+	mov edi, eax
+	cmp edi, success
+	jne readError
+
+	; A raw record is the pair, otherwise it has to fit into the record buffer.
+	mov edi, snapshotInvalid
+	mov rax, [rbp + recordSize]
+	cmp [r12].SnapshotStream.pairFunc, nullptr
+	jne checkRecordSize
+
+	mov rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	cmp rax, rcx
+	jne readError
+
+	jmp acquireNode
+
+checkRecordSize:
+	cmp rax, [r12].SnapshotStream.maxRecordSize
+	ja readError
+
+acquireNode:
+	mov edi, errHeapAllocation
+	call acquireTreeNode
+
+	cmp rax, nullptr
+	je readError
+
+	mov [rbp + recordBytes], rax
+
+	cmp [r12].SnapshotStream.pairFunc, nullptr
+	jne deserializePair
+
+	; Read the pair straight into the treenode.
+	mov rcx, rax
+	mov rdx, [rbp + recordSize]
+	call readSnapshotBytes
+
+	mov edi, eax
+	cmp edi, success
+	jne releaseNode
+
+	jmp initialiseTreeNode
+
+deserializePair:
+	mov rcx, [r12].SnapshotStream.record
+	mov rdx, [rbp + recordSize]
+	call readSnapshotBytes
+
+	mov edi, eax
+	cmp edi, success
+	jne releaseNode
+
+	mov rcx, [rbp + recordBytes]
+	mov rdx, [r12].SnapshotStream.record
+	mov r8, [rbp + recordSize]
+	callUserFunc [r12].SnapshotStream.pairFunc
+
+	mov edi, eax
+	cmp edi, success
+	jne releaseNode
+
+initialiseTreeNode:
+	; The parent links the children and colors the treenode.
+	mov rax, [rbp + recordBytes]
+	mov rcx, rax
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov [rcx].TreeNode.left, nullptr
+	mov [rcx].TreeNode.right, nullptr
+	mov [rcx].TreeNode.isRed, false
+	inc [rsi].TreeMap.nodeAmount
+
+	jmp functionReturn
+
+releaseNode:
+	mov rcx, [rbp + recordBytes]
+	call releaseTreeNode
+
+readError:
+	mov eax, nullptr
+
+functionReturn:
+	mov rsp, rbp
+	pop rbp
+	ret
+
+readSnapshotTreeNode endp
+
+
+; Allocates the snapshot stream with its buffer. A record buffer is allocated
+; if a pair function and a maximum record size are given.
+;
+; @RCX qword[in] - FILE pointer of the snapshot.
+; @RDX qword[in] - Serialize or deserialize function or a nullptr.
+; @R8 qword[in] - Maximum size of a record or zero if it's unknown yet.
+; @RSI qword[in] - Pointer to the treemap.
+; @R12 qword[out] - Pointer to the snapshot stream.
+;
+; @return A status value for success, errSerializePair if a serialize function
+;		  has no record size or errHeapAllocation.
+openSnapshotStream proc
+
+	push rbx
+	push rdi
+	push r13
+	sub rsp, shadowStorage
+
+	mov rbx, rcx
+	mov rdi, rdx
+	mov r13, r8
+
+	; Raw records always have the size of a pair.
+	cmp rdi, nullptr
+	jne allocateStream
+
+	mov r13, [rsi].TreeMap.keySize
+	add r13, [rsi].TreeMap.valueSize
+
+allocateStream:
+	mov rcx, sizeof SnapshotStream + snapshotBufferSize
+	call malloc
+
+	cmp rax, nullptr
+	je heapAllocationError
+
+	; The buffer follows the stream.
+	mov r12, rax
+	mov [r12].SnapshotStream.file, rbx
+	lea rcx, [r12 + sizeof SnapshotStream]
+	mov [r12].SnapshotStream.buffer, rcx
+	mov [r12].SnapshotStream.position, 0
+	mov [r12].SnapshotStream.filled, 0
+	mov rcx, fnvOffsetBasis
+	mov [r12].SnapshotStream.checksum, rcx
+	mov [r12].SnapshotStream.pairFunc, rdi
+	mov [r12].SnapshotStream.record, nullptr
+	mov [r12].SnapshotStream.maxRecordSize, r13
+
+	; The records are read into a buffer after the header is known.
+	mov eax, success
+	cmp rdi, nullptr
+	je functionReturn
+
+	cmp [rsi].TreeMap.nodeAmount, 0
+	je functionReturn
+
+	cmp r13, 0
+	je recordSizeError
+
+	mov rcx, r13
+	call malloc
+
+	cmp rax, nullptr
+	je streamError
+
+	mov [r12].SnapshotStream.record, rax
+	mov eax, success
+
+	jmp functionReturn
+
+recordSizeError:
+	mov ebx, errSerializePair
+
+	jmp freeStream
+
+streamError:
+	mov ebx, errHeapAllocation
+
+freeStream:
+	mov rcx, r12
+	call free
+
+	mov eax, ebx
+
+	jmp functionReturn
+
+heapAllocationError:
+	mov eax, errHeapAllocation
+
+functionReturn:
+	add rsp, shadowStorage
+	pop r13
+	pop rdi
+	pop rbx
+	ret
+
+openSnapshotStream endp
+
+
+; Frees the snapshot stream with its buffers.
+;
+; @R12 qword[in,out] - Pointer to the snapshot stream.
+closeSnapshotStream proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	; Free ignores a nullptr.
+	mov rcx, [r12].SnapshotStream.record
+	call free
+
+	mov rcx, r12
+	call free
+
+	add rsp, shadowStorage + qwordSize
+	ret
+
+closeSnapshotStream endp
+
+
+; Copies the bytes into the buffer of the stream and adds them to its checksum.
+; A full buffer is written to the file.
+;
+; @RCX qword[in] - Pointer to the bytes that are written.
+; @RDX qword[in] - Amount of bytes.
+; @R12 qword[in,out] - Pointer to the snapshot stream.
+;
+; @return A status value for success or errFileIo.
+writeSnapshotBytes proc
+
+	push rbx
+	push r13
+	push r14
+	sub rsp, shadowStorage
+
+	mov rbx, rcx
+	mov r13, rdx
+
+copyBytes:
+	mov eax, success
+	cmp r13, 0
+	je functionReturn
+
+	; Write the buffer once it's full.
+	mov r14, snapshotBufferSize
+	sub r14, [r12].SnapshotStream.position
+	jnz copyIntoBuffer
+
+	call flushSnapshotStream
+
+	cmp eax, success
+	jne functionReturn
+
+	jmp copyBytes
+
+copyIntoBuffer:
+	cmp r14, r13
+	jbe copyPart
+
+	mov r14, r13
+
+copyPart:
+	mov rcx, [r12].SnapshotStream.buffer
+	add rcx, [r12].SnapshotStream.position
+	mov rdx, rbx
+	mov r8, r14
+	call memcpy
+
+	mov rcx, [r12].SnapshotStream.buffer
+	add rcx, [r12].SnapshotStream.position
+	mov rdx, r14
+	mov r8, [r12].SnapshotStream.checksum
+	call hashSnapshotBytes
+
+	mov [r12].SnapshotStream.checksum, rax
+	add [r12].SnapshotStream.position, r14
+	add rbx, r14
+	sub r13, r14
+
+	jmp copyBytes
+
+functionReturn:
+	add rsp, shadowStorage
+	pop r14
+	pop r13
+	pop rbx
+	ret
+
+writeSnapshotBytes endp
+
+
+; Writes the used part of the buffer to the file and empties it.
+;
+; @R12 qword[in,out] - Pointer to the snapshot stream.
+;
+; @return A status value for success or errFileIo.
+flushSnapshotStream proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov rcx, [r12].SnapshotStream.buffer
+	mov edx, 1
+	mov r8, [r12].SnapshotStream.position
+	mov r9, [r12].SnapshotStream.file
+	call fwrite
+
+	; Every byte has to be written.
+	mov ecx, errFileIo
+	cmp rax, [r12].SnapshotStream.position
+	jne functionReturn
+
+	mov [r12].SnapshotStream.position, 0
+	mov ecx, success
+
+functionReturn:
+	mov eax, ecx
+	add rsp, shadowStorage + qwordSize
+	ret
+
+flushSnapshotStream endp
+
+
+; Copies bytes out of the buffer of the stream and adds them to its checksum.
+; An empty buffer is filled from the file.
+;
+; @RCX qword[out] - Pointer to the memory the bytes are read into.
+; @RDX qword[in] - Amount of bytes.
+; @R12 qword[in,out] - Pointer to the snapshot stream.
+;
+; @return A status value for success or snapshotInvalid if the file ends too early.
+readSnapshotBytes proc
+
+	push rbx
+	push r13
+	push r14
+	sub rsp, shadowStorage
+
+	mov rbx, rcx
+	mov r13, rdx
+
+copyBytes:
+	mov eax, success
+	cmp r13, 0
+	je functionReturn
+
+	; Fill the buffer once it's empty.
+	mov r14, [r12].SnapshotStream.filled
+	sub r14, [r12].SnapshotStream.position
+	jnz copyFromBuffer
+
+	call fillSnapshotStream
+
+	cmp eax, success
+	jne functionReturn
+
+	jmp copyBytes
+
+copyFromBuffer:
+	cmp r14, r13
+	jbe copyPart
+
+	mov r14, r13
+
+copyPart:
+	mov rcx, rbx
+	mov rdx, [r12].SnapshotStream.buffer
+	add rdx, [r12].SnapshotStream.position
+	mov r8, r14
+	call memcpy
+
+	mov rcx, rbx
+	mov rdx, r14
+	mov r8, [r12].SnapshotStream.checksum
+	call hashSnapshotBytes
+
+	mov [r12].SnapshotStream.checksum, rax
+	add [r12].SnapshotStream.position, r14
+	add rbx, r14
+	sub r13, r14
+
+	jmp copyBytes
+
+functionReturn:
+	add rsp, shadowStorage
+	pop r14
+	pop r13
+	pop rbx
+	ret
+
+readSnapshotBytes endp
+
+
+; Reads the next part of the file into the buffer of the stream.
+;
+; @R12 qword[in,out] - Pointer to the snapshot stream.
+;
+; @return A status value for success or snapshotInvalid if the file has no bytes left.
+fillSnapshotStream proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	mov rcx, [r12].SnapshotStream.buffer
+	mov edx, 1
+	mov r8, snapshotBufferSize
+	mov r9, [r12].SnapshotStream.file
+	call fread
+
+	mov [r12].SnapshotStream.filled, rax
+	mov [r12].SnapshotStream.position, 0
+
+	mov ecx, snapshotInvalid
+	cmp rax, 0
+	je functionReturn
+
+	mov ecx, success
+
+functionReturn:
+	mov eax, ecx
+	add rsp, shadowStorage + qwordSize
+	ret
+
+fillSnapshotStream endp
+
+
+; Adds the bytes to an FNV-1a checksum.
+;
+; @RCX qword[in] - Pointer to the bytes.
+; @RDX qword[in] - Amount of bytes.
+; @R8 qword[in] - Checksum of the previous bytes or the offset basis.
+;
+; @return The new checksum.
+hashSnapshotBytes proc
+
+	mov rax, r8
+	mov r9, fnvPrime
+
+hashByte:
+	cmp rdx, 0
+	je functionReturn
+
+	movzx r10d, byte ptr [rcx]
+	xor rax, r10
+	imul rax, r9
+	inc rcx
+	dec rdx
+
+	jmp hashByte
+
+functionReturn:
+	ret
+
+hashSnapshotBytes endp
+
+end
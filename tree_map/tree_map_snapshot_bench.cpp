@@ -0,0 +1,121 @@
+/*
+* @file tree_map_snapshot_bench.cpp
+*
+* Defines the benchmarks that compare loading a snapshot with loadTreeMap against
+* inserting the same pairs again with putPair, for integer and string keys at the
+* sizes of the basic benchmarks.
+*
+* @author Collector
+* @data 10/17/2026
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include "bench_utils.h"
+
+namespace {
+	/*
+	* Amount of pairs that are created at once while the timing is paused.
+	*/
+	constexpr size_t pairChunkSize{ 4096 };
+
+	/*
+	* Writes the snapshot of a treemap with the keys of the indices 0 to amount - 1 into a temporary file.
+	*
+	* @return The file positioned behind the snapshot or a nullptr if it can't be written.
+	*/
+	template <typename Keys>
+	FILE* createSnapshotFile(size_t amount) {
+		TreeMap* tm{ createBenchmarkMap<Keys>(amount) };
+		FILE* file{ std::tmpfile() };
+
+		if (file != nullptr && saveTreeMap(tm, file, nullptr, 0) != Status::SUCCESS) {
+			std::fclose(file);
+			file = nullptr;
+		}
+
+		deleteTreeMap(tm);
+
+		return file;
+	}
+
+	template <typename Keys>
+	void benchmarkLoadTreeMap(benchmark::State& state, size_t amount) {
+		FILE* file{ createSnapshotFile<Keys>(amount) };
+
+		if (file == nullptr) {
+			state.SkipWithError("The snapshot can't be written.");
+
+			return;
+		}
+
+		TreeMap* tm{ Keys::createMap() };
+
+		for (auto _ : state) {
+			state.PauseTiming();
+			clearTreeMap(tm);
+			std::rewind(file);
+			state.ResumeTiming();
+
+			benchmark::DoNotOptimize(loadTreeMap(tm, file, nullptr));
+		}
+
+		state.SetItemsProcessed(state.iterations() * amount);
+		deleteTreeMap(tm);
+		std::fclose(file);
+	}
+
+	/*
+	* Inserts the pairs in the key order of a snapshot, which is what loading a snapshot
+	* without loadTreeMap costs. The pairs are created chunk wise while the timing is paused.
+	*/
+	template <typename Keys>
+	void benchmarkReinsertPairs(benchmark::State& state, size_t amount) {
+		std::vector<typename Keys::Pair> chunk(pairChunkSize);
+		TreeMap* tm{ Keys::createMap() };
+
+		for (auto _ : state) {
+			state.PauseTiming();
+			clearTreeMap(tm);
+			state.ResumeTiming();
+
+			for (size_t start{ 0 }; start < amount; start += pairChunkSize) {
+				size_t count{ std::min(pairChunkSize, amount - start) };
+
+				state.PauseTiming();
+
+				for (size_t i{ 0 }; i < count; i++) {
+					makeBenchmarkPair<Keys>(start + i, &chunk[i]);
+				}
+
+				state.ResumeTiming();
+
+				for (size_t i{ 0 }; i < count; i++) {
+					benchmark::DoNotOptimize(putPair(tm, &chunk[i]));
+				}
+			}
+		}
+
+		state.SetItemsProcessed(state.iterations() * amount);
+		deleteTreeMap(tm);
+	}
+
+	template <typename Keys>
+	void registerKeySnapshotBenchmarks(size_t maxSize) {
+		for (size_t amount : getBenchmarkSizes(maxSize)) {
+			std::string suffix{ std::string{ "/" } + Keys::name + "/" + std::to_string(amount) };
+
+			benchmark::RegisterBenchmark(("snapshot/loadTreeMap" + suffix).c_str(),
+				benchmarkLoadTreeMap<Keys>, amount)->Unit(benchmark::kMillisecond);
+			benchmark::RegisterBenchmark(("snapshot/putPair" + suffix).c_str(),
+				benchmarkReinsertPairs<Keys>, amount)->Unit(benchmark::kMillisecond);
+		}
+	}
+}
+
+void registerSnapshotBenchmarks(size_t maxSize) {
+	registerKeySnapshotBenchmarks<IntegerKeys>(maxSize);
+	registerKeySnapshotBenchmarks<StringKeys>(maxSize);
+}
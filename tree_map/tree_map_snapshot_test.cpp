@@ -0,0 +1,272 @@
+/*
+* @file tree_map_snapshot_test.h
+*
+* Defines unit tests for the snapshots of the tree map
+* implementation.
+*
+* @author Collector
+* @data 03/09/2023
+*/
+
+
+#include "utils.h"
+
+namespace {
+	/*
+	* Asserts that the subtree is a left leaning red black tree whose keys are numbers in order.
+	*
+	* @param[in] node - Root of the subtree.
+	* @param[in, out] nextKey - Key that the next treenode in order has to hold.
+	*
+	* @return The black height of the subtree.
+	*/
+	size_t assertNumberTree(const size_t* node, size_t& nextKey) {
+		if (node == nullptr) {
+			return 0;
+		}
+
+		const size_t* left{ reinterpret_cast<const size_t*>(node[2]) };
+		const size_t* right{ reinterpret_cast<const size_t*>(node[3]) };
+		bool isRed{ *reinterpret_cast<const bool*>(node + 4) };
+
+		EXPECT_TRUE(right == nullptr || !*reinterpret_cast<const bool*>(right + 4));
+		EXPECT_TRUE(!isRed || left == nullptr || !*reinterpret_cast<const bool*>(left + 4));
+
+		size_t leftHeight{ assertNumberTree(left, nextKey) };
+
+		EXPECT_EQ(nextKey, node[0]);
+		EXPECT_EQ(nextKey * nextKey, node[1]);
+		nextKey++;
+
+		size_t rightHeight{ assertNumberTree(right, nextKey) };
+
+		EXPECT_EQ(leftHeight, rightHeight);
+
+		return leftHeight + (isRed ? 0 : 1);
+	}
+
+	/*
+	* Saves the treemap into a temporary file and rewinds it.
+	*
+	* @param[in] tm - Treemap that is saved.
+	* @param[in] serialize - Serialize function or a nullptr.
+	*
+	* @return The temporary file.
+	*/
+	FILE* saveIntoTemporaryFile(TreeMap* tm, SerializePair serialize) {
+		FILE* file{ createTemporaryFile() };
+
+		EXPECT_EQ(Status::SUCCESS, saveTreeMap(tm, file, serialize, SNAPSHOT_RECORD_SIZE));
+
+		rewind(file);
+
+		return file;
+	}
+}
+
+TEST(TreeMap, saveTreeMapShouldFailForTreeMapNullptr) {
+	Status s;
+
+	s = saveTreeMap(nullptr, stdout, nullptr, 0);
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, s);
+}
+
+TEST(TreeMap, saveTreeMapShouldFailForFileNullptr) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+
+	s = saveTreeMap(tm, nullptr, serializeTreeNodePair, SNAPSHOT_RECORD_SIZE);
+
+	ASSERT_EQ(Status::FILE_NULLPTR, s);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, saveTreeMapShouldFailForTooSmallRecords) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+	FILE* file{ createTemporaryFile() };
+
+	// The records are written into a buffer of the given size.
+	s = saveTreeMap(tm, file, serializeTreeNodePair, 0);
+
+	ASSERT_EQ(Status::ERR_SERIALIZE_PAIR, s);
+
+	fclose(file);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, loadTreeMapShouldRestoreSerializedPairs) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+	FILE* file{ saveIntoTemporaryFile(tm, serializeTreeNodePair) };
+	TreeMap* loaded{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeTreeNodePair, &s) };
+
+	s = loadTreeMap(loaded, file, deserializeTreeNodePair);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(5, loaded->nodeAmount);
+
+	std::vector<TreeNode*> nodes{
+		createTreeNode("Washington", "Olympia", 1889, 7705281, false),
+		createTreeNode("Oregon", "Salem", 1859, 4237256, false),
+		createTreeNode("New York", "Albany", 1788, 20201249, false),
+		createTreeNode("Minnesota", "Saint Paul", 1858, 5706494, false),
+		createTreeNode("Kansas", "Topeka", 1861, 2937880, false),
+	};
+
+	for (TreeNode* node : nodes) {
+		TreeNodeValue result;
+
+		s = getValue(loaded, &node->pair.key, &result);
+
+		ASSERT_EQ(Status::SUCCESS, s);
+		assertTreeNodeValueEquals(&node->pair.value, &result);
+
+		free(result.capitalCity);
+	}
+
+	// The loaded treemap can be modified like any other.
+	s = deletePair(loaded, &nodes[2]->pair.key, nullptr);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(4, loaded->nodeAmount);
+
+	fclose(file);
+	freeTreeNodes(nodes);
+	deleteTreeMap(loaded);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, loadTreeMapShouldBuildValidTreeForEveryAmount) {
+	Status s;
+
+	for (size_t amount{ 0 }; amount < 70; amount++) {
+		TreeMap* tm{ createTestNumberTree(amount, 1) };
+		FILE* file{ saveIntoTemporaryFile(tm, nullptr) };
+		TreeMap* loaded{ createTreeMap(sizeof(size_t), sizeof(size_t), compareNumberKey,
+			equalsNumberValue, copyNumberKey, copyNumberValue, nullptr, &s) };
+
+		s = loadTreeMap(loaded, file, nullptr);
+
+		ASSERT_EQ(Status::SUCCESS, s);
+		ASSERT_EQ(amount, loaded->nodeAmount);
+		ASSERT_TRUE(loaded->root == nullptr || !reinterpret_cast<const bool*>(loaded->root)[4 * sizeof(size_t)]);
+
+		size_t nextKey{ 0 };
+
+		assertNumberTree(reinterpret_cast<const size_t*>(loaded->root), nextKey);
+
+		ASSERT_EQ(amount, nextKey);
+
+		fclose(file);
+		deleteTreeMap(loaded);
+		deleteTreeMap(tm);
+	}
+}
+
+TEST(TreeMap, loadTreeMapShouldStreamThroughSeveralBuffers) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(10000, 1) };
+	FILE* file{ saveIntoTemporaryFile(tm, nullptr) };
+	TreeMap* loaded{ createTreeMap(sizeof(size_t), sizeof(size_t), compareNumberKey,
+		equalsNumberValue, copyNumberKey, copyNumberValue, nullptr, &s) };
+
+	s = loadTreeMap(loaded, file, nullptr);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(10000, loaded->nodeAmount);
+
+	size_t nextKey{ 0 };
+
+	assertNumberTree(reinterpret_cast<const size_t*>(loaded->root), nextKey);
+
+	ASSERT_EQ(10000, nextKey);
+
+	fclose(file);
+	deleteTreeMap(loaded);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, loadTreeMapShouldFailForNonEmptyTreeMap) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+	FILE* file{ saveIntoTemporaryFile(tm, serializeTreeNodePair) };
+
+	s = loadTreeMap(tm, file, deserializeTreeNodePair);
+
+	ASSERT_EQ(Status::TREE_MAP_NOT_EMPTY, s);
+	ASSERT_EQ(5, tm->nodeAmount);
+
+	fclose(file);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, loadTreeMapShouldRejectOtherPairSizes) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(10, 1) };
+	FILE* file{ saveIntoTemporaryFile(tm, nullptr) };
+	TreeMap* loaded{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeTreeNodePair, &s) };
+
+	s = loadTreeMap(loaded, file, deserializeTreeNodePair);
+
+	ASSERT_EQ(Status::SNAPSHOT_INVALID, s);
+	ASSERT_EQ(0, loaded->nodeAmount);
+
+	fclose(file);
+	deleteTreeMap(loaded);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, loadTreeMapShouldRejectCorruptedRecords) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+	FILE* file{ saveIntoTemporaryFile(tm, serializeTreeNodePair) };
+	TreeMap* loaded{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeTreeNodePair, &s) };
+
+	// Change a letter of the first state behind the header and the record size.
+	fseek(file, 8 * sizeof(size_t), SEEK_SET);
+	fputc('k', file);
+	rewind(file);
+
+	s = loadTreeMap(loaded, file, deserializeTreeNodePair);
+
+	ASSERT_EQ(Status::SNAPSHOT_INVALID, s);
+	ASSERT_EQ(0, loaded->nodeAmount);
+	ASSERT_EQ(nullptr, loaded->root);
+
+	fclose(file);
+	deleteTreeMap(loaded);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, loadTreeMapShouldFreePairsOfTruncatedSnapshot) {
+	Status s;
+	TreeMap* tm{ createTestTree() };
+	FILE* file{ saveIntoTemporaryFile(tm, serializeTreeNodePair) };
+	FILE* truncated{ createTemporaryFile() };
+	char bytes[1024];
+	size_t amount{ fread(bytes, 1, sizeof(bytes), file) };
+
+	// Drop the trailer and the last record.
+	fwrite(bytes, 1, amount - 3 * sizeof(size_t), truncated);
+	rewind(truncated);
+
+	TreeMap* loaded{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeTreeNodePair, &s) };
+
+	s = loadTreeMap(loaded, truncated, deserializeTreeNodePair);
+
+	ASSERT_EQ(Status::SNAPSHOT_INVALID, s);
+	ASSERT_EQ(0, loaded->nodeAmount);
+	ASSERT_EQ(nullptr, loaded->root);
+
+	fclose(truncated);
+	fclose(file);
+	deleteTreeMap(loaded);
+	deleteTreeMap(tm);
+}
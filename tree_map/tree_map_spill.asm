@@ -0,0 +1,999 @@
+; @file tree_map_spill.asm
+;
+; Defines the memory budgets of treemaps. Once the resident treenodes take more memory than the budget,
+; the subtrees that weren't visited since the last sweep are written into a file and freed. Their links
+; keep the offset of the record with the lowest bit set, which no treenode address has. The sweep works
+; like the clock algorithm of a page cache: every visit sets the access bit inside the color byte of a
+; treenode and the sweep clears it, so that only subtrees without a visit between two sweeps are spilled.
+;
+; Only black subtrees are spilled, but their red treenodes are written behind spilled links as well. The links
+; remember the color of their treenode and a treenode is always faulted in together with its red children,
+; so resident links never lead to spilled red treenodes. The rebalancing then treats spilled links like any
+; other black link and they are only faulted back in when an operation reaches them. Searches fault the treenodes on the
+; path of their key in, insertions and deletions the treenodes they descend to and their children.
+; Functions that visit every treenode fault the whole tree back in first.
+;
+; @author Collector
+; @date 03/09/2023
+
+	include tree_map.inc
+
+	.code
+
+
+	public setTreeMapBudget
+
+; Gives the treemap a budget for the memory of its treenodes and spills its cold treenodes if they exceed it.
+; A budget of 0 faults every spilled treenode back in and removes the budget. Before the budget or the file
+; changes every spilled treenode is faulted back in as well.
+;
+; @RCX qword[in,out] - Pointer to the treemap that gets the budget.
+; @RDX qword[in,out] - FILE pointer opened for reading and writing that receives the spilled treenodes.
+; @R8 qword[in] - Budget in bytes or 0 to remove it.
+;
+; @return A status value for success, fileNullptr, inlineSizeMismatch for inline pairs, spillMultiMap,
+;		  hashUnsupported, checkpointRunning, errFileIo, errHeapAllocation or treeMapNullptr.
+setTreeMapBudget proc
+
+	push rsi
+	push rdi
+	push r12
+	sub rsp, shadowStorage
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; A running checkpoint walks the tree without faulting treenodes in.
+	mov eax, checkpointRunning
+	cmp [rcx].TreeMap.checkpoint, nullptr
+	jne functionReturn
+
+	; Save the treemap, the file and the budget.
+	mov rsi, rcx
+	mov rdi, rdx
+	mov r12, r8
+
+	cmp r12, 0
+	je removeBudget
+
+	; Check if the file is a nullptr.
+	mov eax, fileNullptr
+	cmp rdi, nullptr
+	je functionReturn
+
+	; Inline treenodes differ in size, so a record can't be read back into any treenode.
+	mov eax, inlineSizeMismatch
+	test [rsi].TreeMap.flags, inlinePairsFlag
+	jnz functionReturn
+
+	; Deleting a pair of a multimap searches its treenode without faulting treenodes in.
+	mov eax, spillMultiMap
+	test [rsi].TreeMap.flags, multiMapFlag
+	jnz functionReturn
+
+	; The records of the spilled treenodes don't hold the subtree hashes.
+	mov eax, hashUnsupported
+	cmp [rsi].TreeMap.hashPairFunc, nullptr
+	jne functionReturn
+
+	mov rcx, rsi
+	call restoreSpilledTreeMap
+
+	cmp eax, success
+	jne functionReturn
+
+	mov rax, [rsi].TreeMap.spill
+	cmp rax, nullptr
+	jne setBudget
+
+	mov rcx, sizeof Spill
+	call malloc
+
+	cmp rax, nullptr
+	je heapAllocationError
+
+	mov [rsi].TreeMap.spill, rax
+	mov [rax].Spill.spilledAmount, 0
+	mov [rax].Spill.faultAmount, 0
+
+setBudget:
+	mov [rax].Spill.file, rdi
+	mov [rax].Spill.budget, r12
+	mov [rax].Spill.fileEnd, 0
+
+	; A record is the pair followed by the links and the color.
+	mov rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	lea rdx, [rcx + treeNodeBaseSize]
+	mov [rax].Spill.recordSize, rdx
+
+	; The limit counts the treenodes that fit into the budget, the target leaves an eighth of them free.
+	mov r8, rax
+	add rcx, sizeof TreeNode
+	mov rax, r12
+	xor edx, edx
+	div rcx
+
+	mov [r8].Spill.residentLimit, rax
+	mov rcx, rax
+	shr rcx, spillSlackShift
+	sub rax, rcx
+	mov [r8].Spill.residentTarget, rax
+
+	call spillColdTreeNodes
+
+	jmp functionReturn
+
+removeBudget:
+	mov rcx, rsi
+	call restoreSpilledTreeMap
+
+	cmp eax, success
+	jne functionReturn
+
+	; free ignores a nullptr.
+	mov rcx, [rsi].TreeMap.spill
+	call free
+
+	mov [rsi].TreeMap.spill, nullptr
+	mov eax, success
+
+	jmp functionReturn
+
+heapAllocationError:
+	mov eax, errHeapAllocation
+
+functionReturn:
+	add rsp, shadowStorage
+	pop r12
+	pop rdi
+	pop rsi
+	ret
+
+setTreeMapBudget endp
+
+
+	public spillTreeMap
+
+; Spills the cold treenodes of the treemap if its resident treenodes exceed the budget.
+; putPair does the same after every insertion, a background thread can call it before.
+;
+; @RCX qword[in,out] - Pointer to the treemap whose treenodes are spilled.
+;
+; @return A status value for success, spillNullptr, checkpointRunning, errFileIo or treeMapNullptr.
+;		  The treenodes that were spilled before a failure stay spilled.
+spillTreeMap proc
+
+	push rsi
+	sub rsp, shadowStorage
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the treemap has a budget.
+	mov eax, spillNullptr
+	cmp [rcx].TreeMap.spill, nullptr
+	je functionReturn
+
+	mov eax, checkpointRunning
+	cmp [rcx].TreeMap.checkpoint, nullptr
+	jne functionReturn
+
+	mov rsi, rcx
+	call spillColdTreeNodes
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rsi
+	ret
+
+spillTreeMap endp
+
+
+	public restoreTreeMap
+
+; Faults every spilled treenode of the treemap back in. The budget stays, so the next
+; insertion that exceeds it spills the treenodes again.
+;
+; @RCX qword[in,out] - Pointer to the treemap whose treenodes are faulted in.
+;
+; @return A status value for success, spillNullptr, errFileIo, errHeapAllocation or treeMapNullptr.
+restoreTreeMap proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the treemap has a budget.
+	mov eax, spillNullptr
+	cmp [rcx].TreeMap.spill, nullptr
+	je functionReturn
+
+	call restoreSpilledTreeMap
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	ret
+
+restoreTreeMap endp
+
+
+; Spills cold subtrees until the resident treenodes are down to the target, if they exceed the limit.
+; The first sweep clears the access bits, so a second one spills the subtrees that were only hot before.
+;
+; @RSI qword[in,out] - Pointer to the treemap with a budget.
+;
+; @return A status value for success or errFileIo.
+spillColdTreeNodes proc
+
+	push rdi
+	push r12
+	sub rsp, shadowStorage + qwordSize
+
+	mov r12, [rsi].TreeMap.spill
+
+	; Nothing is spilled while the resident treenodes fit into the budget.
+	mov eax, success
+	mov rcx, [rsi].TreeMap.nodeAmount
+	sub rcx, [r12].Spill.spilledAmount
+	cmp rcx, [r12].Spill.residentLimit
+	jbe functionReturn
+
+	; The records are appended at the end of the file.
+	mov rcx, [r12].Spill.file
+	mov rdx, [r12].Spill.fileEnd
+	mov r8d, seekSet
+	call _fseeki64
+
+	cmp eax, 0
+	mov eax, errFileIo
+	jne functionReturn
+
+	mov edi, success
+	mov qword ptr [rsp + shadowStorage], spillPasses
+
+sweepTree:
+	; The link of the root lies at the start of the treemap.
+	mov rcx, rsi
+	call sweepTreeLink
+
+	cmp edi, success
+	jne returnStatus
+
+	dec qword ptr [rsp + shadowStorage]
+	jz returnStatus
+
+	mov rcx, [rsi].TreeMap.nodeAmount
+	sub rcx, [r12].Spill.spilledAmount
+	cmp rcx, [r12].Spill.residentTarget
+	ja sweepTree
+
+returnStatus:
+	mov eax, edi
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop r12
+	pop rdi
+	ret
+
+spillColdTreeNodes endp
+
+
+; Sweeps the subtree behind the given link in post order. The access bits are cleared on the way and every
+; maximal black subtree without a visited treenode is spilled while the resident treenodes exceed the target.
+; The root always stays resident.
+;
+; @RCX qword[in,out] - Pointer to the link of the subtree.
+; @RSI qword[in,out] - Pointer to the current treemap.
+; @RDI dword[out] - Status value that is set to errFileIo if a record can't be written.
+; @R12 qword[in,out] - Pointer to the budget of the treemap.
+;
+; @return The amount of resident treenodes left in the subtree and inside DL true if one of them was visited.
+sweepTreeLink proc
+
+	push rbx
+	push r13
+	push r14
+	sub rsp, shadowStorage
+
+	; R13 counts the resident treenodes and R14B tells if one was visited.
+	xor r13, r13
+	xor r14d, r14d
+
+	; Empty and spilled links hold no resident treenodes.
+	mov rbx, rcx
+	mov rcx, [rbx]
+	cmp rcx, nullptr
+	je functionReturn
+
+	test cl, spilledLinkFlag
+	jnz functionReturn
+
+	; Take the access bit of the treenode and clear it for the next sweep.
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	test byte ptr [rcx].TreeNode.isRed, accessedFlag
+	setnz r14b
+	and byte ptr [rcx].TreeNode.isRed, true
+	mov r13, 1
+
+	; Sweep the left and the right subtree.
+	call sweepTreeLink
+
+	add r13, rax
+	or r14b, dl
+
+	cmp edi, success
+	jne functionReturn
+
+	mov rcx, [rbx]
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	add rcx, qwordSize
+	call sweepTreeLink
+
+	add r13, rax
+	or r14b, dl
+
+	cmp edi, success
+	jne functionReturn
+
+	; A visited subtree is hot and the root stays.
+	cmp r14b, false
+	jne functionReturn
+
+	cmp rbx, rsi
+	je functionReturn
+
+	; A spilled link is treated as black, so red treenodes stay with their parent.
+	mov rcx, [rbx]
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	test byte ptr [rcx].TreeNode.isRed, true
+	jnz functionReturn
+
+	mov rax, [rsi].TreeMap.nodeAmount
+	sub rax, [r12].Spill.spilledAmount
+	cmp rax, [r12].Spill.residentTarget
+	jbe functionReturn
+
+	mov rcx, [rbx]
+	call writeSpilledTreeNodes
+
+	mov [rbx], rax
+	xor r13, r13
+
+functionReturn:
+	mov rax, r13
+	mov dl, r14b
+	add rsp, shadowStorage
+	pop r14
+	pop r13
+	pop rbx
+	ret
+
+sweepTreeLink endp
+
+
+; Writes the resident treenodes of a subtree in post order into the file and releases them.
+; A record is the treenode itself whose links already hold the offsets of the records of its children.
+;
+; @RCX qword[in,out] - Pointer to the treenode at the top of the subtree.
+; @RSI qword[in,out] - Pointer to the current treemap.
+; @RDI dword[out] - Status value that is set to errFileIo if a record can't be written.
+; @R12 qword[in,out] - Pointer to the budget of the treemap.
+;
+; @return The spilled link of the subtree or the treenode if its record couldn't be written.
+;		  The children written before a failure stay spilled.
+writeSpilledTreeNodes proc
+
+	push rbx
+	push r13
+	sub rsp, shadowStorage + qwordSize
+
+	; RBX holds the treenode and R13 its links.
+	mov rbx, rcx
+	mov r13, rcx
+	add r13, [rsi].TreeMap.keySize
+	add r13, [rsi].TreeMap.valueSize
+
+	; Resident children are written first.
+	mov rcx, [r13].TreeNode.left
+	cmp rcx, nullptr
+	je writeRightChild
+
+	test cl, spilledLinkFlag
+	jnz writeRightChild
+
+	call writeSpilledTreeNodes
+
+	mov [r13].TreeNode.left, rax
+	cmp edi, success
+	jne keepTreeNode
+
+writeRightChild:
+	mov rcx, [r13].TreeNode.right
+	cmp rcx, nullptr
+	je writeRecord
+
+	test cl, spilledLinkFlag
+	jnz writeRecord
+
+	call writeSpilledTreeNodes
+
+	mov [r13].TreeNode.right, rax
+	cmp edi, success
+	jne keepTreeNode
+
+writeRecord:
+	; The record doesn't keep the access bit.
+	and byte ptr [r13].TreeNode.isRed, true
+
+	mov rcx, rbx
+	mov rdx, [r12].Spill.recordSize
+	mov r8, 1
+	mov r9, [r12].Spill.file
+	call fwrite
+
+	cmp rax, 1
+	jne fileIoError
+
+	; The spilled link is the offset of the record shifted left by two with the flag set,
+	; a red treenode also sets the red flag so that it is faulted in with its parent.
+	mov rax, [r12].Spill.fileEnd
+	lea rax, [rax * 4 + spilledLinkFlag]
+
+	test byte ptr [r13].TreeNode.isRed, true
+	jz saveSpilledLink
+
+	or rax, spilledRedFlag
+
+saveSpilledLink:
+	mov [rsp + shadowStorage], rax
+
+	mov rax, [r12].Spill.recordSize
+	add [r12].Spill.fileEnd, rax
+	inc [r12].Spill.spilledAmount
+
+	mov rcx, rbx
+	call releaseTreeNode
+
+	mov rax, [rsp + shadowStorage]
+
+	jmp functionReturn
+
+fileIoError:
+	mov edi, errFileIo
+
+keepTreeNode:
+	mov rax, rbx
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop r13
+	pop rbx
+	ret
+
+writeSpilledTreeNodes endp
+
+
+; Reads the record behind a spilled link into a new treenode. The spill counters aren't changed.
+;
+; @RCX qword[in] - Spilled link of the record.
+; @RSI qword[in,out] - Pointer to the current treemap with a budget.
+; @R12 qword[in] - Pointer to the budget of the treemap.
+;
+; @return A status value for success, errFileIo or errHeapAllocation and inside RDX the treenode on success.
+readSpilledRecord proc
+
+	push rbx
+	sub rsp, shadowStorage
+
+	; Seek the record, the link holds its offset shifted left by two.
+	mov rdx, rcx
+	shr rdx, spilledOffsetShift
+	mov rcx, [r12].Spill.file
+	mov r8d, seekSet
+	call _fseeki64
+
+	cmp eax, 0
+	jne fileIoError
+
+	call acquireTreeNode
+
+	cmp rax, nullptr
+	je heapAllocationError
+
+	; The record is read into the treenode as it is.
+	mov rbx, rax
+	mov rcx, rax
+	mov rdx, [r12].Spill.recordSize
+	mov r8, 1
+	mov r9, [r12].Spill.file
+	call fread
+
+	cmp rax, 1
+	jne readError
+
+	mov eax, success
+	mov rdx, rbx
+
+	jmp functionReturn
+
+readError:
+	mov rcx, rbx
+	call releaseTreeNode
+
+fileIoError:
+	mov eax, errFileIo
+
+	jmp functionReturn
+
+heapAllocationError:
+	mov eax, errHeapAllocation
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rbx
+	ret
+
+readSpilledRecord endp
+
+
+; Faults the treenode behind a spilled link back in together with its red children and sets its access bit.
+; The links of the other children stay spilled. A resident treenode only gets its access bit set.
+;
+; @RCX qword[in,out] - Pointer to the link that is faulted in.
+; @RSI qword[in,out] - Pointer to the current treemap with a budget.
+;
+; @return A status value for success, errFileIo or errHeapAllocation. The link stays spilled on failure.
+faultSpilledLink proc
+
+	push rbx
+	push r12
+	push r13
+	push r14
+	sub rsp, shadowStorage + 3 * qwordSize
+
+	mov rbx, rcx
+	mov r12, [rsi].TreeMap.spill
+
+	mov rcx, [rbx]
+	test cl, spilledLinkFlag
+	jz markTreeNode
+
+	call readSpilledRecord
+
+	cmp eax, success
+	jne functionReturn
+
+	; R13 holds the treenode and R14 its links, the slot the faulted left child.
+	mov r13, rdx
+	mov r14, rdx
+	add r14, [rsi].TreeMap.keySize
+	add r14, [rsi].TreeMap.valueSize
+	mov qword ptr [rsp + shadowStorage], nullptr
+
+	; Red children are faulted in with the treenode, the red flag is only set on spilled links.
+	mov rcx, [r14].TreeNode.left
+	test cl, spilledRedFlag
+	jz faultRightChild
+
+	call readSpilledRecord
+
+	cmp eax, success
+	jne releaseTreeNodes
+
+	mov [r14].TreeNode.left, rdx
+	mov [rsp + shadowStorage], rdx
+
+faultRightChild:
+	mov rcx, [r14].TreeNode.right
+	test cl, spilledRedFlag
+	jz linkTreeNode
+
+	call readSpilledRecord
+
+	cmp eax, success
+	jne releaseTreeNodes
+
+	mov [r14].TreeNode.right, rdx
+	inc [r12].Spill.faultAmount
+	dec [r12].Spill.spilledAmount
+
+linkTreeNode:
+	cmp qword ptr [rsp + shadowStorage], nullptr
+	je countTreeNode
+
+	inc [r12].Spill.faultAmount
+	dec [r12].Spill.spilledAmount
+
+countTreeNode:
+	mov [rbx], r13
+	inc [r12].Spill.faultAmount
+
+	; The file is reused from its start once nothing is spilled anymore.
+	dec [r12].Spill.spilledAmount
+	jnz markTreeNode
+
+	mov [r12].Spill.fileEnd, 0
+
+markTreeNode:
+	mov rax, [rbx]
+	cmp rax, nullptr
+	je returnSuccess
+
+	add rax, [rsi].TreeMap.keySize
+	add rax, [rsi].TreeMap.valueSize
+	or byte ptr [rax].TreeNode.isRed, accessedFlag
+
+returnSuccess:
+	mov eax, success
+
+	jmp functionReturn
+
+releaseTreeNodes:
+	; The records stay in the file, so the link keeps leading to them.
+	mov [rsp + shadowStorage + qwordSize], eax
+
+	mov rcx, [rsp + shadowStorage]
+	cmp rcx, nullptr
+	je releaseParent
+
+	call releaseTreeNode
+
+releaseParent:
+	mov rcx, r13
+	call releaseTreeNode
+
+	mov eax, [rsp + shadowStorage + qwordSize]
+
+functionReturn:
+	add rsp, shadowStorage + 3 * qwordSize
+	pop r14
+	pop r13
+	pop r12
+	pop rbx
+	ret
+
+faultSpilledLink endp
+
+
+; Faults the children of a treenode back in before a deletion function descends and rebalances.
+; The treenode gets its access bit set. Without a budget nothing happens.
+;
+; @RCX qword[in] - Pointer to the treenode, it is preserved.
+; @RSI qword[in,out] - Pointer to the current treemap.
+;
+; @return A status value for success, errFileIo or errHeapAllocation.
+faultSpilledChildren proc
+
+	push rcx
+	push rbx
+	sub rsp, shadowStorage + qwordSize
+
+	mov eax, success
+	cmp [rsi].TreeMap.spill, nullptr
+	je functionReturn
+
+	mov rbx, rcx
+	add rbx, [rsi].TreeMap.keySize
+	add rbx, [rsi].TreeMap.valueSize
+	or byte ptr [rbx].TreeNode.isRed, accessedFlag
+
+	lea rcx, [rbx].TreeNode.left
+	call faultSpilledLink
+
+	cmp eax, success
+	jne functionReturn
+
+	lea rcx, [rbx].TreeNode.right
+	call faultSpilledLink
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rbx
+	pop rcx
+	ret
+
+faultSpilledChildren endp
+
+
+; Faults the treenodes on the search path of a key back in. If the key is found, the paths to the biggest
+; key of its left and the smallest key of its right subtree are faulted in as well, so that the neighbours
+; of the key are resident for lower, higher and equal range searches. Without a budget nothing happens.
+;
+; @RCX qword[in] - Pointer to the treemap, it is preserved like RDX and R8 to R11.
+; @RDX qword[in] - Pointer to the key.
+;
+; @return A status value for success, errFileIo or errHeapAllocation.
+faultSpilledPath proc
+
+	push rcx
+	push rdx
+	push r8
+	push r9
+	push r10
+	push r11
+	push rbx
+	push rsi
+	push rdi
+	sub rsp, shadowStorage
+
+	mov eax, success
+	cmp [rcx].TreeMap.spill, nullptr
+	je functionReturn
+
+	; RBX holds the link that is followed, the link of the root lies at the start of the treemap.
+	mov rsi, rcx
+	mov rdi, rdx
+	mov rbx, rcx
+
+searchTreeNode:
+	mov rcx, rbx
+	call faultSpilledLink
+
+	cmp eax, success
+	jne functionReturn
+
+	mov rcx, [rbx]
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rdx, rdi
+	countTreeMapEvent rsi, comparisons
+	callUserFunc [rsi].TreeMap.compareKeyFunc
+
+	mov rbx, [rbx]
+	add rbx, [rsi].TreeMap.keySize
+	add rbx, [rsi].TreeMap.valueSize
+
+	cmp eax, 0
+	jl searchTreeNode
+	je faultNeighbours
+
+	add rbx, qwordSize
+
+	jmp searchTreeNode
+
+faultNeighbours:
+	mov rcx, rbx
+	mov edx, qwordSize
+	call faultSpilledEdge
+
+	cmp eax, success
+	jne functionReturn
+
+	lea rcx, [rbx + qwordSize]
+	xor edx, edx
+	call faultSpilledEdge
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rdi
+	pop rsi
+	pop rbx
+	pop r11
+	pop r10
+	pop r9
+	pop r8
+	pop rdx
+	pop rcx
+	ret
+
+faultSpilledPath endp
+
+
+; Faults the treenodes on the path to the smallest or biggest key of the treemap back in.
+; Without a budget nothing happens.
+;
+; @RCX qword[in] - Pointer to the treemap, it is preserved like RDX and R8 to R11.
+; @R11 qword[in] - Offset of the followed link, 0 for the left and 8 for the right one.
+;
+; @return A status value for success, errFileIo or errHeapAllocation.
+faultSpilledBranch proc
+
+	push rcx
+	push rdx
+	push r8
+	push r9
+	push r10
+	push r11
+	push rsi
+	sub rsp, shadowStorage
+
+	mov eax, success
+	cmp [rcx].TreeMap.spill, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+	mov rdx, r11
+	call faultSpilledEdge
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rsi
+	pop r11
+	pop r10
+	pop r9
+	pop r8
+	pop rdx
+	pop rcx
+	ret
+
+faultSpilledBranch endp
+
+
+; Faults the treenodes back in that lie on the path which always follows the same link.
+;
+; @RCX qword[in,out] - Pointer to the link the path starts at.
+; @RDX qword[in] - Offset of the followed link, 0 for the left and 8 for the right one.
+; @RSI qword[in,out] - Pointer to the current treemap with a budget.
+;
+; @return A status value for success, errFileIo or errHeapAllocation.
+faultSpilledEdge proc
+
+	push rbx
+	push rdi
+	sub rsp, shadowStorage + qwordSize
+
+	mov rbx, rcx
+	mov rdi, rdx
+
+faultTreeNode:
+	mov rcx, rbx
+	call faultSpilledLink
+
+	cmp eax, success
+	jne functionReturn
+
+	mov rbx, [rbx]
+	cmp rbx, nullptr
+	je functionReturn
+
+	add rbx, [rsi].TreeMap.keySize
+	add rbx, [rsi].TreeMap.valueSize
+	add rbx, rdi
+
+	jmp faultTreeNode
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rdi
+	pop rbx
+	ret
+
+faultSpilledEdge endp
+
+
+; Faults every spilled treenode of the treemap back in before a function visits all treenodes.
+; Without a budget or spilled treenodes nothing happens.
+;
+; @RCX qword[in] - Pointer to the treemap, it is preserved like RDX, R8 and R9.
+;
+; @return A status value for success, errFileIo or errHeapAllocation.
+restoreSpilledTreeMap proc
+
+	push rcx
+	push rdx
+	push r8
+	push r9
+	push rsi
+	sub rsp, shadowStorage
+
+	mov eax, success
+	mov rsi, rcx
+	mov rcx, [rsi].TreeMap.spill
+	cmp rcx, nullptr
+	je functionReturn
+
+	cmp [rcx].Spill.spilledAmount, 0
+	je functionReturn
+
+	; The link of the root lies at the start of the treemap.
+	mov rcx, rsi
+	call restoreSpilledLink
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rsi
+	pop r9
+	pop r8
+	pop rdx
+	pop rcx
+	ret
+
+restoreSpilledTreeMap endp
+
+
+; Faults the spilled treenodes of the subtree behind the given link back in.
+; The walk stops as soon as no treenode is spilled anymore.
+;
+; @RCX qword[in,out] - Pointer to the link of the subtree.
+; @RSI qword[in,out] - Pointer to the current treemap with a budget.
+;
+; @return A status value for success, errFileIo or errHeapAllocation.
+restoreSpilledLink proc
+
+	push rbx
+	sub rsp, shadowStorage
+
+	mov eax, success
+	mov rdx, [rsi].TreeMap.spill
+	cmp [rdx].Spill.spilledAmount, 0
+	je functionReturn
+
+	mov rbx, rcx
+	call faultSpilledLink
+
+	cmp eax, success
+	jne functionReturn
+
+	mov rbx, [rbx]
+	cmp rbx, nullptr
+	je functionReturn
+
+	add rbx, [rsi].TreeMap.keySize
+	add rbx, [rsi].TreeMap.valueSize
+
+	lea rcx, [rbx].TreeNode.left
+	call restoreSpilledLink
+
+	cmp eax, success
+	jne functionReturn
+
+	lea rcx, [rbx].TreeNode.right
+	call restoreSpilledLink
+
+functionReturn:
+	add rsp, shadowStorage
+	pop rbx
+	ret
+
+restoreSpilledLink endp
+
+
+; Frees the treenodes of a spilled subtree for freeTreeNodes. Their records are only read back if the
+; pairs have nested memory for the free pair function, otherwise they are dropped with the file.
+; Records that can't be read back are skipped.
+;
+; @RCX qword[in] - Spilled link of the subtree.
+; @RSI qword[in,out] - Pointer to the current treemap with a budget.
+freeSpilledTreeNodes proc
+
+	; freeTreeNodes doesn't keep the stack aligned.
+	push rbp
+	mov rbp, rsp
+	and rsp, -16
+	sub rsp, shadowStorage + 2 * qwordSize
+
+	cmp [rsi].TreeMap.freePairFunc, nullptr
+	je functionReturn
+
+	; The treenode is faulted in through a link on the stack.
+	mov [rsp + shadowStorage], rcx
+	lea rcx, [rsp + shadowStorage]
+	call faultSpilledLink
+
+	cmp eax, success
+	jne functionReturn
+
+	mov rcx, [rsp + shadowStorage]
+	call freeTreeNodes
+
+functionReturn:
+	mov rsp, rbp
+	pop rbp
+	ret
+
+freeSpilledTreeNodes endp
+
+end
@@ -0,0 +1,407 @@
+/*
+* @file tree_map_spill_test.h
+*
+* Defines unit tests for the memory budgets of the tree map
+* implementation.
+*
+* @author Collector
+* @data 03/09/2023
+*/
+
+
+#include <map>
+#include <random>
+
+#include "utils.h"
+
+namespace {
+	/*
+	* Memory of a resident treenode of the number treemaps.
+	*/
+	constexpr size_t numberTreeNodeSize{ 2 * sizeof(size_t) + 3 * sizeof(size_t) };
+
+	/*
+	* Asserts that the resident treenodes of the treemap fit into its budget.
+	*
+	* @param[in] tm - Treemap with a budget.
+	*/
+	void assertResidentWithinBudget(const TreeMap* tm) {
+		ASSERT_NE(nullptr, tm->spill);
+		ASSERT_LE(tm->nodeAmount - tm->spill->spilledAmount, tm->spill->residentLimit);
+	}
+
+	/*
+	* Asserts that a scan over the treemap visits the given keys in order with their squared values.
+	*
+	* @param[in] tm - Treemap of numbers that is scanned.
+	* @param[in] keys - Expected keys in ascending order.
+	*/
+	void assertNumberScan(TreeMap* tm, const std::vector<size_t>& keys) {
+		size_t pair[2]{};
+		Status s{ minPair(tm, pair) };
+
+		for (size_t key : keys) {
+			ASSERT_EQ(Status::SUCCESS, s);
+			ASSERT_EQ(key, pair[0]);
+			ASSERT_EQ(key * key, pair[1]);
+
+			size_t last{ pair[0] };
+
+			s = higherPair(tm, &last, pair);
+		}
+
+		ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+	}
+
+	/*
+	* Measures the black height of a resident subtree and checks that no red treenode has a red child.
+	* The color byte also holds the access bit of the budget, so only its lowest bit is the color.
+	*
+	* @param[in] node - Root of the subtree.
+	*
+	* @return The black height of the subtree or -1 if the subtree is no valid red black tree.
+	*/
+	long measureBlackHeight(const NumberTreeNode* node) {
+		if (node == nullptr) {
+			return 0;
+		}
+
+		bool isRed{ (reinterpret_cast<const unsigned char*>(&node->isRed)[0] & 1) != 0 };
+
+		for (const NumberTreeNode* child : { node->left, node->right }) {
+			if (isRed && child != nullptr && (reinterpret_cast<const unsigned char*>(&child->isRed)[0] & 1) != 0) {
+				return -1;
+			}
+		}
+
+		long leftHeight{ measureBlackHeight(node->left) };
+		long rightHeight{ measureBlackHeight(node->right) };
+
+		if (leftHeight < 0 || leftHeight != rightHeight) {
+			return -1;
+		}
+
+		return leftHeight + (isRed ? 0 : 1);
+	}
+
+	/*
+	* Asserts that the treemap is a valid red black tree that holds the same pairs as the model.
+	* Every treenode is faulted in for the check and the cold ones are spilled again afterwards.
+	*
+	* @param[in, out] tm - Treemap of numbers with a budget.
+	* @param[in] model - Expected keys with their squared values.
+	*/
+	void assertSpilledTreeMapEquals(TreeMap* tm, const std::map<size_t, size_t>& model) {
+		std::vector<size_t> keys{};
+
+		for (const auto& entry : model) {
+			keys.push_back(entry.first);
+		}
+
+		ASSERT_EQ(Status::SUCCESS, restoreTreeMap(tm));
+		ASSERT_LE(0, measureBlackHeight(reinterpret_cast<NumberTreeNode*>(tm->root)));
+		ASSERT_EQ(model.size(), tm->nodeAmount);
+		assertNumberScan(tm, keys);
+		ASSERT_EQ(Status::SUCCESS, spillTreeMap(tm));
+	}
+}
+
+TEST(TreeMap, setTreeMapBudgetShouldFailForInvalidParameters) {
+	FILE* file{ createTemporaryFile() };
+	TreeMap* tm{ createTestNumberTree(10, 1) };
+	TreeMap* inlineTree{ createTestInlineTree() };
+	TreeMap* multiMap{ createTestMultiMap() };
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, setTreeMapBudget(nullptr, file, 4096));
+	ASSERT_EQ(Status::FILE_NULLPTR, setTreeMapBudget(tm, nullptr, 4096));
+	ASSERT_EQ(Status::INLINE_SIZE_MISMATCH, setTreeMapBudget(inlineTree, file, 4096));
+	ASSERT_EQ(Status::SPILL_MULTI_MAP, setTreeMapBudget(multiMap, file, 4096));
+	ASSERT_EQ(Status::SPILL_NULLPTR, spillTreeMap(tm));
+	ASSERT_EQ(Status::SPILL_NULLPTR, restoreTreeMap(tm));
+
+	// Removing a budget that doesn't exist does nothing.
+	ASSERT_EQ(Status::SUCCESS, setTreeMapBudget(tm, nullptr, 0));
+	ASSERT_EQ(nullptr, tm->spill);
+
+	deleteTreeMap(multiMap);
+	deleteTreeMap(inlineTree);
+	deleteTreeMap(tm);
+	fclose(file);
+}
+
+TEST(TreeMap, spilledTreeMapShouldKeepItsPairsWithinTheBudget) {
+	FILE* file{ createTemporaryFile() };
+	TreeMap* tm{ createTestNumberTree(0, 1) };
+
+	ASSERT_EQ(Status::SUCCESS, setTreeMapBudget(tm, file, 500 * numberTreeNodeSize));
+	ASSERT_EQ(500, tm->spill->residentLimit);
+
+	std::vector<size_t> keys{};
+
+	for (size_t key{ 0 }; key < 5000; key++) {
+		size_t pair[2]{ key * 3, key * 3 * key * 3 };
+
+		ASSERT_EQ(Status::SUCCESS, putPair(tm, pair));
+
+		keys.push_back(key * 3);
+	}
+
+	ASSERT_EQ(5000, tm->nodeAmount);
+	ASSERT_LT(4000, tm->spill->spilledAmount);
+	assertResidentWithinBudget(tm);
+
+	for (size_t key{ 0 }; key < 15000; key++) {
+		size_t value{ 0 };
+		Status s{ getValue(tm, &key, &value) };
+
+		if (key % 3 == 0) {
+			ASSERT_EQ(Status::SUCCESS, s);
+			ASSERT_EQ(key * key, value);
+		}
+		else {
+			ASSERT_EQ(Status::DOES_NOT_CONTAIN, s);
+		}
+	}
+
+	ASSERT_LT(0, tm->spill->faultAmount);
+	assertNumberScan(tm, keys);
+
+	// A replaced value is written with its treenode when it is spilled again.
+	for (size_t key{ 0 }; key < 15000; key += 30) {
+		size_t value{ 1 };
+
+		ASSERT_EQ(Status::SUCCESS, replaceValue(tm, &key, &value));
+	}
+
+	ASSERT_EQ(Status::SUCCESS, spillTreeMap(tm));
+
+	for (size_t key{ 0 }; key < 15000; key += 3) {
+		size_t value{ 0 };
+
+		ASSERT_EQ(Status::SUCCESS, getValue(tm, &key, &value));
+		ASSERT_EQ(key % 30 == 0 ? 1 : key * key, value);
+	}
+
+	deleteTreeMap(tm);
+	fclose(file);
+}
+
+TEST(TreeMap, spilledTreeMapShouldDeleteAndPollPairs) {
+	FILE* file{ createTemporaryFile() };
+	TreeMap* tm{ createTestNumberTree(4000, 1) };
+
+	ASSERT_EQ(Status::SUCCESS, setTreeMapBudget(tm, file, 300 * numberTreeNodeSize));
+	assertResidentWithinBudget(tm);
+
+	std::vector<size_t> keys{};
+
+	// Delete every key that isn't a multiple of four, then poll both ends.
+	for (size_t key{ 0 }; key < 4000; key++) {
+		if (key % 4 == 0) {
+			keys.push_back(key);
+
+			continue;
+		}
+
+		size_t pair[2]{};
+
+		ASSERT_EQ(Status::SUCCESS, deletePair(tm, &key, pair));
+		ASSERT_EQ(key, pair[0]);
+		ASSERT_EQ(key * key, pair[1]);
+	}
+
+	size_t pair[2]{};
+
+	ASSERT_EQ(Status::SUCCESS, pollFirstPair(tm, pair));
+	ASSERT_EQ(0, pair[0]);
+	ASSERT_EQ(Status::SUCCESS, pollLastPair(tm, pair));
+	ASSERT_EQ(3996, pair[0]);
+
+	keys.erase(keys.begin());
+	keys.pop_back();
+
+	ASSERT_EQ(keys.size(), tm->nodeAmount);
+	assertNumberScan(tm, keys);
+
+	// A moved key takes its spilled neighbours along.
+	size_t oldKey{ 400 }, newKey{ 401 }, keyBuffer{ 0 };
+
+	ASSERT_EQ(Status::SUCCESS, rekeyPair(tm, &oldKey, &newKey, &keyBuffer));
+	ASSERT_EQ(Status::SUCCESS, containsKey(tm, &newKey));
+	ASSERT_EQ(Status::DOES_NOT_CONTAIN, containsKey(tm, &oldKey));
+
+	deleteTreeMap(tm);
+	fclose(file);
+}
+
+TEST(TreeMap, spillShouldKeepVisitedTreeNodesResident) {
+	FILE* file{ createTemporaryFile() };
+	TreeMap* tm{ createTestNumberTree(4000, 1) };
+
+	ASSERT_EQ(Status::SUCCESS, setTreeMapBudget(tm, file, 1000 * numberTreeNodeSize));
+	ASSERT_EQ(Status::SUCCESS, restoreTreeMap(tm));
+	ASSERT_EQ(0, tm->spill->spilledAmount);
+
+	// The restore visited everything, so the first sweep only clears the access bits.
+	ASSERT_EQ(Status::SUCCESS, spillTreeMap(tm));
+
+	for (size_t key{ 1000 }; key < 1100; key++) {
+		ASSERT_EQ(Status::SUCCESS, containsKey(tm, &key));
+	}
+
+	size_t pair[2]{ 4000, 16000000 };
+
+	ASSERT_EQ(Status::SUCCESS, putPair(tm, pair));
+	assertResidentWithinBudget(tm);
+
+	size_t faultAmount{ tm->spill->faultAmount };
+
+	for (size_t key{ 1000 }; key < 1100; key++) {
+		ASSERT_EQ(Status::SUCCESS, containsKey(tm, &key));
+	}
+
+	ASSERT_EQ(faultAmount, tm->spill->faultAmount);
+
+	deleteTreeMap(tm);
+	fclose(file);
+}
+
+TEST(TreeMap, removedBudgetShouldFaultEveryTreeNodeIn) {
+	FILE* file{ createTemporaryFile() };
+	TreeMap* tm{ createTestNumberTree(2000, 2) };
+	size_t value{ 20 * 20 };
+
+	ASSERT_EQ(Status::SUCCESS, setTreeMapBudget(tm, file, 100 * numberTreeNodeSize));
+	ASSERT_LT(0, tm->spill->spilledAmount);
+
+	// Functions that visit every treenode fault them back in.
+	ASSERT_EQ(Status::SUCCESS, containsValue(tm, &value));
+	ASSERT_EQ(0, tm->spill->spilledAmount);
+	ASSERT_EQ(0, tm->spill->fileEnd);
+
+	ASSERT_EQ(Status::SUCCESS, spillTreeMap(tm));
+	ASSERT_LT(0, tm->spill->spilledAmount);
+
+	ASSERT_EQ(Status::SUCCESS, setTreeMapBudget(tm, nullptr, 0));
+	ASSERT_EQ(nullptr, tm->spill);
+
+	std::vector<size_t> keys{};
+
+	for (size_t key{ 0 }; key < 4000; key += 2) {
+		keys.push_back(key);
+	}
+
+	assertNumberScan(tm, keys);
+
+	deleteTreeMap(tm);
+	fclose(file);
+}
+
+TEST(TreeMap, clearTreeMapShouldFreeSpilledPairs) {
+	FILE* file{ createTemporaryFile() };
+	Status s;
+	TreeMap* tm{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeTreeNodePair, &s) };
+
+	ASSERT_EQ(Status::SUCCESS, setTreeMapBudget(tm, file, 64 * (sizeof(TreeNodePair) + 3 * sizeof(size_t))));
+
+	for (size_t i{ 0 }; i < 1000; i++) {
+		char name[16]{};
+
+		std::snprintf(name, sizeof(name), "State %zu", i);
+
+		TreeNodePair* pair{ createTreeNodePair(name, "Capital", 1900, static_cast<unsigned int>(i)) };
+
+		ASSERT_EQ(Status::SUCCESS, putPair(tm, pair));
+
+		freeTreeNodePairs({ pair });
+	}
+
+	ASSERT_LT(0, tm->spill->spilledAmount);
+
+	TreeNodeKey* key{ createTreeNodeKey("State 777") };
+	TreeNodeValue value{};
+
+	ASSERT_EQ(Status::SUCCESS, getValue(tm, key, &value));
+	ASSERT_EQ(777, value.population);
+
+	// The nested data of the spilled pairs is freed with them.
+	ASSERT_EQ(Status::SUCCESS, clearTreeMap(tm));
+	ASSERT_EQ(0, tm->nodeAmount);
+	ASSERT_EQ(0, tm->spill->spilledAmount);
+
+	freeTreeNodeValue(&value);
+	freeTreeNodeKeys({ key });
+	deleteTreeMap(tm);
+	fclose(file);
+}
+
+TEST(TreeMap, spilledTreeMapShouldStayBalancedUnderRandomMutations) {
+	for (unsigned seed{ 1 }; seed <= 4; seed++) {
+		FILE* file{ createTemporaryFile() };
+		TreeMap* tm{ createTestNumberTree(0, 1) };
+		std::map<size_t, size_t> model{};
+		std::mt19937 engine{ seed };
+		std::uniform_int_distribution<size_t> keys{ 0, 4095 };
+
+		ASSERT_EQ(Status::SUCCESS, setTreeMapBudget(tm, file, 64 * numberTreeNodeSize));
+
+		for (size_t i{ 0 }; i < 20000; i++) {
+			size_t pair[2]{ keys(engine), 0 };
+			Status expected{ model.count(pair[0]) != 0 ? Status::ALREADY_CONTAINS : Status::SUCCESS };
+
+			pair[1] = pair[0] * pair[0];
+
+			ASSERT_EQ(expected, putPair(tm, pair));
+			model.emplace(pair[0], pair[1]);
+		}
+
+		assertSpilledTreeMapEquals(tm, model);
+
+		for (size_t i{ 0 }; i < 20000; i++) {
+			size_t operation{ keys(engine) % 4 };
+			size_t pair[2]{ keys(engine), 0 };
+
+			if (operation == 0) {
+				Status expected{ model.count(pair[0]) != 0 ? Status::ALREADY_CONTAINS : Status::SUCCESS };
+
+				pair[1] = pair[0] * pair[0];
+
+				ASSERT_EQ(expected, putPair(tm, pair));
+				model.emplace(pair[0], pair[1]);
+
+				// Only insertions spill, deletions just fault the treenodes they reach in.
+				assertResidentWithinBudget(tm);
+			} else if (operation == 1) {
+				size_t key{ pair[0] };
+
+				ASSERT_EQ(model.erase(key) != 0 ? Status::SUCCESS : Status::DOES_NOT_CONTAIN, deletePair(tm, &key, pair));
+			} else if (model.empty()) {
+				ASSERT_EQ(Status::DOES_NOT_CONTAIN, pollFirstPair(tm, pair));
+			} else {
+				auto polled{ operation == 2 ? model.begin() : std::prev(model.end()) };
+
+				ASSERT_EQ(Status::SUCCESS, operation == 2 ? pollFirstPair(tm, pair) : pollLastPair(tm, pair));
+				ASSERT_EQ(polled->first, pair[0]);
+				ASSERT_EQ(polled->second, pair[1]);
+
+				model.erase(polled);
+			}
+		}
+
+		assertSpilledTreeMapEquals(tm, model);
+
+		// Draining the treemap reaches every spilled treenode.
+		size_t pair[2]{};
+
+		for (const auto& entry : model) {
+			ASSERT_EQ(Status::SUCCESS, pollFirstPair(tm, pair));
+			ASSERT_EQ(entry.first, pair[0]);
+		}
+
+		ASSERT_EQ(0, tm->nodeAmount);
+
+		deleteTreeMap(tm);
+		fclose(file);
+	}
+}
@@ -0,0 +1,239 @@
+; @file tree_map_stats.asm
+;
+; Defines the statistics of treemaps. Counters that are attached to a treemap count its comparisons,
+; rotations, color flips, moveRedLeft and moveRedRight calls, allocations and frees. The functions that
+; do this work count it through countTreeMapEvent, which is only assembled if TREE_MAP_COUNTERS is
+; defined, so a library without the define doesn't pay anything for the counters.
+;
+; getTreeMapStats walks the tree once and measures its height, black height, average depth and memory.
+;
+; @author Collector
+; @date 03/09/2023
+
+	include tree_map.inc
+
+	.code
+
+
+	public setTreeMapCounters
+
+; Attaches counters to the treemap that its work is counted in from now on.
+;
+; @RCX qword[in,out] - Pointer to the treemap whose work is counted.
+; @RDX qword[in] - Pointer to the counters or a nullptr to detach them.
+;
+; @return A status value for success, countersUnsupported if the library is built without
+;		  TREE_MAP_COUNTERS or treeMapNullptr.
+setTreeMapCounters proc
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+ifdef TREE_MAP_COUNTERS
+	mov [rcx].TreeMap.counters, rdx
+	mov eax, success
+else
+	; No function counts anything without the define.
+	mov eax, countersUnsupported
+endif
+
+functionReturn:
+	ret
+
+setTreeMapCounters endp
+
+
+	public getTreeMapStats
+
+; Measures the shape and the memory of the treemap. Spilled treenodes are faulted back in first.
+;
+; @RCX qword[in,out] - Pointer to the treemap that is measured.
+; @RDX qword[out] - Pointer to the TreeMapStats that receive the statistics.
+;
+; @return A status value for success, statsBufferNullptr, treeMapNullptr or the status
+;		  of faulting in the spilled treenodes.
+getTreeMapStats proc
+
+	push rbx
+	push rsi
+	push rdi
+	push r12
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the treemap is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the buffer is a nullptr.
+	mov eax, statsBufferNullptr
+	cmp rdx, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+	mov rdi, rdx
+
+	; Every treenode is visited, so the spilled ones have to be in memory.
+	call restoreSpilledTreeMap
+
+	cmp eax, success
+	jne functionReturn
+
+	mov [rdi].TreeMapStats.height, 0
+	mov [rdi].TreeMapStats.blackHeight, 0
+	mov [rdi].TreeMapStats.bytesUsed, sizeof TreeMap
+
+	; Sum up the depths of the treenodes and count them.
+	mov ebx, 0
+	mov r12d, 0
+	mov rcx, [rsi].TreeMap.root
+	mov edx, 0
+	call measureTreeNodes
+
+	; The average depth of an empty treemap is zero.
+	xorps xmm0, xmm0
+	cmp r12, 0
+	je storeAverageDepth
+
+	cvtsi2sd xmm0, rbx
+	cvtsi2sd xmm1, r12
+	divsd xmm0, xmm1
+
+storeAverageDepth:
+	movsd [rdi].TreeMapStats.averageDepth, xmm0
+
+	; Every path from the root to a leaf holds the same amount of black treenodes, so the leftmost path is counted.
+	mov rcx, [rsi].TreeMap.root
+
+countBlackTreeNode:
+	cmp rcx, nullptr
+	je measureMemory
+
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	cmp [rcx].TreeNode.isRed, true
+	je nextLeftTreeNode
+
+	inc [rdi].TreeMapStats.blackHeight
+
+nextLeftTreeNode:
+	mov rcx, [rcx].TreeNode.left
+	jmp countBlackTreeNode
+
+measureMemory:
+	mov rax, [rsi].TreeMap.nodeArena
+	cmp rax, nullptr
+	je measureTreeNodeMemory
+
+	; The treenodes of a node arena lie inside its chunks.
+	add [rdi].TreeMapStats.bytesUsed, sizeof NodeArena
+	mov rcx, [rax].NodeArena.chunks
+
+addChunkBytes:
+	cmp rcx, nullptr
+	je measured
+
+	mov rdx, [rcx].NodeChunk.capacity
+	add [rdi].TreeMapStats.bytesUsed, rdx
+	mov rcx, [rcx].NodeChunk.next
+
+	jmp addChunkBytes
+
+measureTreeNodeMemory:
+	; The treenodes and the spare treenodes are allocated with the same size.
+	mov rax, [rsi].TreeMap.keySize
+	add rax, [rsi].TreeMap.valueSize
+	add rax, sizeof TreeNode
+
+	; The hashes follow the links.
+	cmp [rsi].TreeMap.hashPairFunc, nullptr
+	je addTreeNodeBytes
+
+	add rax, sizeof NodeHash
+
+addTreeNodeBytes:
+	mov rcx, r12
+	add rcx, [rsi].TreeMap.spareAmount
+	mul rcx
+
+	add [rdi].TreeMapStats.bytesUsed, rax
+
+measured:
+	mov eax, success
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop r12
+	pop rdi
+	pop rsi
+	pop rbx
+	ret
+
+getTreeMapStats endp
+
+
+; Recursively sums up the depths of the treenodes of a subtree and counts them. The greatest depth
+; is kept as the height and the bytes of inline pairs are added to the used bytes.
+;
+; @RCX qword[in] - Pointer to the root of the subtree.
+; @RDX qword[in] - Depth of the parent of the subtree, zero for the root of the tree.
+; @RBX qword[in,out] - Sum of the depths of the visited treenodes.
+; @RSI qword[in] - Pointer to the treemap.
+; @RDI qword[in,out] - Pointer to the statistics.
+; @R12 qword[in,out] - Amount of visited treenodes.
+measureTreeNodes proc
+
+	; sub 24 bytes from the stack so that every recursive call
+	; starts with the same alignment.
+	sub rsp, 3 * qwordSize
+
+	cmp rcx, nullptr
+	je functionReturn
+
+	; The treenode lies one deeper than its parent.
+	inc rdx
+	inc r12
+	add rbx, rdx
+
+	cmp rdx, [rdi].TreeMapStats.height
+	jbe measureInlinePair
+
+	mov [rdi].TreeMapStats.height, rdx
+
+measureInlinePair:
+	; Inline pairs keep their bytes inside the allocation of the treenode.
+	test [rsi].TreeMap.flags, inlinePairsFlag
+	jz measureChildren
+
+	mov r8, rcx
+	mov rax, [r8].InlineData.byteAmount
+	add r8, [rsi].TreeMap.keySize
+	add rax, [r8].InlineData.byteAmount
+	add [rdi].TreeMapStats.bytesUsed, rax
+
+measureChildren:
+	; Save the treenode and its depth for the right child.
+	mov [rsp], rcx
+	mov [rsp + qwordSize], rdx
+
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rcx, [rcx].TreeNode.left
+	call measureTreeNodes
+
+	mov rcx, [rsp]
+	mov rdx, [rsp + qwordSize]
+	add rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov rcx, [rcx].TreeNode.right
+	call measureTreeNodes
+
+functionReturn:
+	add rsp, 3 * qwordSize
+	ret
+
+measureTreeNodes endp
+
+end
@@ -0,0 +1,219 @@
+/*
+* @file tree_map_stats_test.h
+*
+* Defines unit tests for the counters and the statistics of the tree map
+* implementation.
+*
+* @author Collector
+* @data 03/09/2023
+*/
+
+
+#include "utils.h"
+
+namespace {
+	/*
+	* Size of the links and the color that follow the pair of a treenode.
+	*/
+	constexpr size_t treeNodeLinkSize{ sizeof(NumberTreeNode) - 2 * sizeof(size_t) };
+
+	/*
+	* Count of the key comparisons since it was reset.
+	*/
+	size_t comparisonAmount{ 0 };
+
+	/*
+	* Compares two numbers and counts the comparison.
+	*
+	* @param[in] tKey - Key of the treenode.
+	* @param[in] insertedKey - Key that is searched.
+	*
+	* @return The result of compareNumberKey.
+	*/
+	long countNumberKey(const void* tKey, const void* insertedKey) {
+		comparisonAmount++;
+
+		return compareNumberKey(tKey, insertedKey);
+	}
+
+	/*
+	* Measures a subtree the way getTreeMapStats should.
+	*
+	* @param[in] node - Root of the subtree.
+	* @param[in] depth - Depth of the root of the subtree.
+	* @param[in, out] depthSum - Sum of the depths of the treenodes.
+	*
+	* @return The height of the subtree.
+	*/
+	size_t measureSubtree(const NumberTreeNode* node, size_t depth, size_t& depthSum) {
+		if (node == nullptr) {
+			return 0;
+		}
+
+		depthSum += depth;
+
+		return 1 + (std::max)(measureSubtree(node->left, depth + 1, depthSum),
+			measureSubtree(node->right, depth + 1, depthSum));
+	}
+}
+
+TEST(TreeMap, setTreeMapCountersShouldCountTheWorkOfTheTreeMap) {
+	Status s;
+	TreeMap* tm{ createTreeMap(sizeof(size_t), sizeof(size_t), countNumberKey,
+		equalsNumberValue, copyNumberKey, copyNumberValue, nullptr, &s) };
+	TreeMapCounters counters{};
+	size_t pair[2]{};
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, setTreeMapCounters(nullptr, &counters));
+
+	s = setTreeMapCounters(tm, &counters);
+
+	if (s == Status::COUNTERS_UNSUPPORTED) {
+		deleteTreeMap(tm);
+
+		GTEST_SKIP() << "The library is built without TREE_MAP_COUNTERS.";
+	}
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	comparisonAmount = 0;
+
+	for (size_t i{ 0 }; i < 1000; i++) {
+		pair[0] = i;
+		pair[1] = i * i;
+
+		ASSERT_EQ(Status::SUCCESS, putPair(tm, pair));
+	}
+
+	// Ascending keys always lean right, so the insertions rotate and flip.
+	ASSERT_EQ(comparisonAmount, counters.comparisons);
+	ASSERT_LT(0, counters.rotations);
+	ASSERT_LT(0, counters.flips);
+	ASSERT_EQ(0, counters.moveRedLefts);
+	ASSERT_EQ(0, counters.moveRedRights);
+	ASSERT_EQ(1000, counters.allocations);
+	ASSERT_EQ(0, counters.frees);
+
+	for (size_t key{ 0 }; key < 1000; key += 2) {
+		ASSERT_EQ(Status::SUCCESS, deletePair(tm, &key, nullptr));
+	}
+
+	ASSERT_EQ(comparisonAmount, counters.comparisons);
+	ASSERT_LT(0, counters.moveRedLefts);
+	ASSERT_LT(0, counters.moveRedRights);
+	ASSERT_EQ(tm->nodeAmount + tm->spareAmount, counters.allocations - counters.frees);
+
+	// A spare treenode is reused without an allocation.
+	size_t allocationAmount{ counters.allocations };
+
+	pair[0] = 0;
+
+	ASSERT_EQ(Status::SUCCESS, putPair(tm, pair));
+	ASSERT_EQ(allocationAmount, counters.allocations);
+
+	ASSERT_EQ(Status::SUCCESS, clearTreeMap(tm));
+	ASSERT_EQ(tm->spareAmount, counters.allocations - counters.frees);
+
+	// Detached counters keep their values.
+	TreeMapCounters detached{ counters };
+
+	ASSERT_EQ(Status::SUCCESS, setTreeMapCounters(tm, nullptr));
+	ASSERT_EQ(Status::SUCCESS, putPair(tm, pair));
+	ASSERT_EQ(0, std::memcmp(&detached, &counters, sizeof(TreeMapCounters)));
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, getTreeMapStatsShouldFailForNullptrs) {
+	TreeMap* tm{ createTestNumberTree(10, 1) };
+	TreeMapStats stats{};
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, getTreeMapStats(nullptr, &stats));
+	ASSERT_EQ(Status::STATS_BUFFER_NULLPTR, getTreeMapStats(tm, nullptr));
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, getTreeMapStatsShouldMeasureAnEmptyTreeMap) {
+	TreeMap* tm{ createTestNumberTree(0, 1) };
+	TreeMapStats stats{ 1, 1, 1.0, 1 };
+
+	ASSERT_EQ(Status::SUCCESS, getTreeMapStats(tm, &stats));
+	ASSERT_EQ(0, stats.height);
+	ASSERT_EQ(0, stats.blackHeight);
+	ASSERT_EQ(0.0, stats.averageDepth);
+	ASSERT_EQ(sizeof(TreeMap), stats.bytesUsed);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, getTreeMapStatsShouldMeasureTheShapeOfTheTree) {
+	TreeMap* tm{ createTestNumberTree(1000, 3) };
+	TreeMapStats stats{};
+
+	for (size_t key{ 0 }; key < 3000; key += 9) {
+		ASSERT_EQ(Status::SUCCESS, deletePair(tm, &key, nullptr));
+	}
+
+	ASSERT_EQ(Status::SUCCESS, getTreeMapStats(tm, &stats));
+
+	size_t depthSum{ 0 };
+	size_t height{ measureSubtree(reinterpret_cast<NumberTreeNode*>(tm->root), 1, depthSum) };
+	size_t blackHeight{ 0 };
+
+	for (const NumberTreeNode* node{ reinterpret_cast<NumberTreeNode*>(tm->root) }; node != nullptr; node = node->left) {
+		blackHeight += node->isRed ? 0 : 1;
+	}
+
+	ASSERT_EQ(height, stats.height);
+	ASSERT_EQ(blackHeight, stats.blackHeight);
+	ASSERT_DOUBLE_EQ(static_cast<double>(depthSum) / tm->nodeAmount, stats.averageDepth);
+	ASSERT_EQ(sizeof(TreeMap) + (tm->nodeAmount + tm->spareAmount) * sizeof(NumberTreeNode), stats.bytesUsed);
+
+	// A left leaning red black tree is at most twice as high as its black height.
+	ASSERT_LE(stats.blackHeight, stats.height);
+	ASSERT_LE(stats.height, 2 * stats.blackHeight);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, getTreeMapStatsShouldCountInlinePairsAndNodeArenas) {
+	TreeMap* inlineTree{ createTestInlineTree() };
+	TreeMap* arenaTree{ createTestNodeArenaTree(4096, 0) };
+	TreeMapStats stats{};
+	size_t inlineBytes{ 0 };
+
+	for (const char* name : { "Washington", "Olympia", "Oregon", "Salem", "New York", "Albany",
+		"Minnesota", "Saint Paul", "Kansas", "Topeka" }) {
+		inlineBytes += std::strlen(name);
+	}
+
+	ASSERT_EQ(Status::SUCCESS, getTreeMapStats(inlineTree, &stats));
+	ASSERT_EQ(sizeof(TreeMap) + 5 * (2 * sizeof(InlineData) + treeNodeLinkSize) + inlineBytes, stats.bytesUsed);
+
+	// The treenodes of the arena lie inside its only chunk.
+	ASSERT_EQ(Status::SUCCESS, getTreeMapStats(arenaTree, &stats));
+	ASSERT_EQ(sizeof(TreeMap) + sizeof(NodeArena) + 4096, stats.bytesUsed);
+
+	deleteTreeMap(arenaTree);
+	deleteTreeMap(inlineTree);
+}
+
+TEST(TreeMap, getTreeMapStatsShouldFaultSpilledTreeNodesIn) {
+	FILE* file{ createTemporaryFile() };
+	TreeMap* tm{ createTestNumberTree(2000, 1) };
+	TreeMapStats stats{};
+
+	ASSERT_EQ(Status::SUCCESS, setTreeMapBudget(tm, file, 100 * sizeof(NumberTreeNode)));
+	ASSERT_LT(0, tm->spill->spilledAmount);
+
+	ASSERT_EQ(Status::SUCCESS, getTreeMapStats(tm, &stats));
+	ASSERT_EQ(0, tm->spill->spilledAmount);
+
+	size_t depthSum{ 0 };
+
+	ASSERT_EQ(measureSubtree(reinterpret_cast<NumberTreeNode*>(tm->root), 1, depthSum), stats.height);
+
+	deleteTreeMap(tm);
+	fclose(file);
+}
@@ -0,0 +1,771 @@
+; @file tree_map_stream.asm
+;
+; Defines the change streams of treemaps. Once a stream is attached, putPair, deletePair, replaceValue,
+; the polls, rekeyPair and clearTreeMap append a compact record of every successful change to a lock free
+; ring. A consumer on another thread drains the records in batches and ships them to replicas,
+; where applyChangeBatch replays them. The replica only needs the changes instead of a whole snapshot.
+;
+; The ring has a single producer, the thread that changes the treemap, and a single consumer.
+; Both sides only advance their own counter, so no lock or atomic instruction is needed: x64 neither
+; reorders stores with other stores nor loads with other loads, so a record is complete before the
+; consumer sees the head move past it and a slot is read before the producer sees the tail move past it.
+; If the ring is full the record is lost. The producer then stops appending, so the consumer drains every
+; record that came before the loss and learns that the replica has to be synchronised from a snapshot.
+;
+; @author Collector
+; @date 03/09/2023
+
+	include tree_map.inc
+
+	.code
+
+
+	public createChangeStream
+
+; Creates a change stream and attaches it to the treemap. The pairs are recorded byte by byte,
+; so they must not hold pointers, and the treemap must not get inline pairs or a value dictionary later.
+;
+; @RCX qword[in,out] - Pointer to the treemap whose changes are recorded.
+; @RDX qword[in] - Amount of records the ring holds, a power of two.
+; @R8 qword[out] - Pointer to a status code which is set to success if the stream is created.
+;
+; @return The stream or a nullptr. The status is set to treeMapNullptr, streamCapacityInvalid,
+;		  inlineSizeMismatch for inline pairs, valueDictionaryExists, changeStreamExists or errHeapAllocation.
+;		  Without a status pointer the function fails silently.
+createChangeStream proc
+
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	sub rsp, shadowStorage + qwordSize
+
+	mov rax, nullptr
+
+	; Check if a status pointer was given, otherwise fail silently.
+	cmp r8, nullptr
+	je functionReturn
+
+	mov rdi, r8
+
+	; Check if the treemap is a nullptr.
+	mov dword ptr [rdi], treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; The position of a record is masked out of the counters, so the capacity has to be a power of two.
+	mov dword ptr [rdi], streamCapacityInvalid
+	cmp rdx, 0
+	je functionReturn
+
+	lea rax, [rdx - 1]
+	test rax, rdx
+	jnz functionReturnNullptr
+
+	; The pairs of inline treenodes and interned values point outside of the treenodes.
+	mov dword ptr [rdi], inlineSizeMismatch
+	test [rcx].TreeMap.flags, inlinePairsFlag
+	jnz functionReturnNullptr
+
+	mov dword ptr [rdi], valueDictionaryExists
+	cmp [rcx].TreeMap.valueDictionary, nullptr
+	jne functionReturnNullptr
+
+	mov dword ptr [rdi], changeStreamExists
+	cmp [rcx].TreeMap.changeStream, nullptr
+	jne functionReturnNullptr
+
+	; Save the treemap and the capacity.
+	mov rbx, rcx
+	mov r12, rdx
+
+	call getChangeRecordSize
+
+	mov rsi, rax
+
+	; The records follow the stream.
+	mov dword ptr [rdi], errHeapAllocation
+	mul r12
+	jc functionReturnNullptr
+
+	add rax, sizeof ChangeStream
+	jc functionReturnNullptr
+
+	mov rcx, rax
+	call malloc
+
+	cmp rax, nullptr
+	je functionReturn
+
+	mov [rax].ChangeStream.treeMap, rbx
+	lea rcx, [rax + sizeof ChangeStream]
+	mov [rax].ChangeStream.records, rcx
+	mov [rax].ChangeStream.recordSize, rsi
+	mov [rax].ChangeStream.capacity, r12
+	mov [rax].ChangeStream.head, 0
+	mov [rax].ChangeStream.cachedTail, 0
+	mov [rax].ChangeStream.lostAmount, 0
+	mov [rax].ChangeStream.tail, 0
+
+	mov [rbx].TreeMap.changeStream, rax
+	mov dword ptr [rdi], success
+
+	jmp functionReturn
+
+functionReturnNullptr:
+	mov rax, nullptr
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+createChangeStream endp
+
+
+	public closeChangeStream
+
+; Detaches the stream from its treemap and frees it. The records that weren't drained are lost,
+; so the consumer has to stop before.
+;
+; @RCX qword[in,out] - Pointer to the stream.
+;
+; @return A status value for success or treeMapNullptr.
+closeChangeStream proc
+
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the stream is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov rax, [rcx].ChangeStream.treeMap
+	mov [rax].TreeMap.changeStream, nullptr
+
+	call free
+
+	mov eax, success
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	ret
+
+closeChangeStream endp
+
+
+	public resetChangeStream
+
+; Empties the ring and forgets the lost records, so the producer appends again. Neither the treemap
+; nor the consumer may use the stream meanwhile, which is the case while a replica is synchronised from a snapshot.
+;
+; @RCX qword[in,out] - Pointer to the stream.
+;
+; @return A status value for success or treeMapNullptr.
+resetChangeStream proc
+
+	; Check if the stream is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	mov [rcx].ChangeStream.head, 0
+	mov [rcx].ChangeStream.cachedTail, 0
+	mov [rcx].ChangeStream.lostAmount, 0
+	mov [rcx].ChangeStream.tail, 0
+
+	mov eax, success
+
+functionReturn:
+	ret
+
+resetChangeStream endp
+
+
+	public drainChangeStream
+
+; Moves the oldest records of the ring into the buffer and hands their slots back to the producer.
+; Only the consumer calls it.
+;
+; @RCX qword[in,out] - Pointer to the stream.
+; @RDX qword[out] - Pointer to a buffer for the given amount of records of the size of the stream.
+; @R8 qword[in] - Maximum amount of records that are drained.
+; @R9 qword[out] - Pointer to the amount of records that were drained.
+;
+; @return A status value for success, changesLost once the records before a lost one are drained,
+;		  pairBufferNullptr, amountBufferNullptr or treeMapNullptr.
+drainChangeStream proc
+
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	push r13
+	push r14
+	sub rsp, shadowStorage + qwordSize
+
+	; Check if the stream is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the buffers are not a nullptr.
+	mov eax, pairBufferNullptr
+	cmp rdx, nullptr
+	je functionReturn
+
+	mov eax, amountBufferNullptr
+	cmp r9, nullptr
+	je functionReturn
+
+	mov rsi, rcx
+	mov rdi, rdx
+	mov r14, r9
+
+	; The lost records are read before the head. The producer doesn't append after a loss,
+	; so the head that follows includes every record in front of it.
+	mov rbx, [rsi].ChangeStream.lostAmount
+	mov r12, [rsi].ChangeStream.tail
+	mov r13, [rsi].ChangeStream.head
+	sub r13, r12
+
+	cmp r13, r8
+	jbe countRecords
+
+	; The loss is reported once the records in front of it are drained.
+	mov r13, r8
+	mov rbx, 0
+
+countRecords:
+	mov [r14], r13
+
+	; Copy the records up to the end of the ring.
+	mov rcx, [rsi].ChangeStream.capacity
+	lea rdx, [rcx - 1]
+	and rdx, r12
+	sub rcx, rdx
+	cmp rcx, r13
+	jbe copyFirstPart
+
+	mov rcx, r13
+
+copyFirstPart:
+	mov [rsp + shadowStorage], rcx
+
+	mov rax, rdx
+	mul [rsi].ChangeStream.recordSize
+	mov rcx, rax
+	mov rax, [rsp + shadowStorage]
+	mul [rsi].ChangeStream.recordSize
+	mov r8, rax
+	mov r14, rax
+	mov rdx, rcx
+	add rdx, [rsi].ChangeStream.records
+	mov rcx, rdi
+	call memcpy
+
+	; The rest starts at the beginning of the ring.
+	mov rax, r13
+	sub rax, [rsp + shadowStorage]
+	jz releaseSlots
+
+	mul [rsi].ChangeStream.recordSize
+	mov r8, rax
+	lea rcx, [rdi + r14]
+	mov rdx, [rsi].ChangeStream.records
+	call memcpy
+
+releaseSlots:
+	; The slots are handed back after the records are copied out of them.
+	add r12, r13
+	mov [rsi].ChangeStream.tail, r12
+
+	mov eax, success
+	cmp rbx, 0
+	je functionReturn
+
+	mov eax, changesLost
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop r14
+	pop r13
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+drainChangeStream endp
+
+
+; Appends a record to the change stream of the treemap. If the ring is full the record is lost and
+; the producer stops appending until the stream is reset. Only the thread that changes the treemap calls it.
+;
+; @RCX qword[in] - Pointer to the treemap with a change stream.
+; @RDX qword[in] - Kind of the record, e.g. changePutRecord.
+; @R8 qword[in] - Pointer to the key of the record or a nullptr.
+; @R9 qword[in] - Pointer to the value or to the new key of a rekey record or a nullptr.
+;
+; @return The status inside EAX is kept, so the caller returns the status of its change.
+recordChange proc
+
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	push r13
+	sub rsp, shadowStorage
+
+	; Save the status, the treemap, the kind and the parts of the record.
+	mov edi, eax
+	mov rsi, rcx
+	mov rbx, r8
+	mov r12, r9
+	mov r10, [rsi].TreeMap.changeStream
+
+	; A stream that lost a record stays silent until it is reset.
+	cmp [r10].ChangeStream.lostAmount, 0
+	jne loseRecord
+
+	; The tail is only read again when the one seen last leaves no slot.
+	mov rax, [r10].ChangeStream.head
+	mov rcx, rax
+	sub rcx, [r10].ChangeStream.cachedTail
+	cmp rcx, [r10].ChangeStream.capacity
+	jb writeRecord
+
+	mov rcx, [r10].ChangeStream.tail
+	mov [r10].ChangeStream.cachedTail, rcx
+	mov rcx, rax
+	sub rcx, [r10].ChangeStream.cachedTail
+	cmp rcx, [r10].ChangeStream.capacity
+	jae loseRecord
+
+writeRecord:
+	; Locate the slot of the head.
+	mov rcx, [r10].ChangeStream.capacity
+	dec rcx
+	and rax, rcx
+	mov r13, rdx
+	mul [r10].ChangeStream.recordSize
+	add rax, [r10].ChangeStream.records
+	mov [rax], r13
+	lea rcx, [rax + changeKindSize]
+	mov r13, rcx
+
+	cmp rbx, nullptr
+	je copySecondPart
+
+	mov rdx, rbx
+	mov r8, [rsi].TreeMap.keySize
+	call memcpy
+
+copySecondPart:
+	cmp r12, nullptr
+	je publishRecord
+
+	; A rekey record holds the new key behind the old one.
+	mov rcx, r13
+	add rcx, [rsi].TreeMap.keySize
+	mov rdx, r12
+	mov r8, [rsi].TreeMap.valueSize
+
+	cmp qword ptr [r13 - changeKindSize], changeRekeyRecord
+	jne copyValue
+
+	mov r8, [rsi].TreeMap.keySize
+
+copyValue:
+	call memcpy
+
+publishRecord:
+	; The record is stored before the head moves past it.
+	mov r10, [rsi].TreeMap.changeStream
+	mov rax, [r10].ChangeStream.head
+	inc rax
+	mov [r10].ChangeStream.head, rax
+
+	jmp functionReturn
+
+loseRecord:
+	inc [r10].ChangeStream.lostAmount
+
+functionReturn:
+	mov eax, edi
+	add rsp, shadowStorage
+	pop r13
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	ret
+
+recordChange endp
+
+
+	public applyChangeBatch
+
+; Replays drained records onto a replica that held the same pairs as the treemap when the first
+; of them was recorded. A run of puts with ascending keys into an empty replica, like the load of
+; a whole treemap or the pairs that follow a clear, is built bottom up like loadTreeMap does instead
+; of inserting the pairs one by one. The pairs are copied into those treenodes byte by byte.
+;
+; @RCX qword[in,out] - Pointer to the replica with the key and value sizes of the treemap.
+; @RDX qword[in] - Pointer to the records.
+; @R8 qword[in] - Amount of records.
+;
+; @return A status value for success, pairBufferNullptr, inlineSizeMismatch for inline pairs,
+;		  valueDictionaryExists, snapshotInvalid for an unknown record, the status of a change
+;		  that fails, errHeapAllocation or treeMapNullptr.
+applyChangeBatch proc
+
+	push rbp
+	mov rbp, rsp
+	push rsi
+	push rdi
+	push rbx
+	push r12
+	push r13
+	push r14
+	push r15
+	sub rsp, sizeof SnapshotStream
+
+	; Check if the replica is a nullptr.
+	mov eax, treeMapNullptr
+	cmp rcx, nullptr
+	je functionReturn
+
+	; Check if the records are not a nullptr.
+	mov eax, pairBufferNullptr
+	cmp rdx, nullptr
+	je functionReturn
+
+	; The pairs of inline treenodes and interned values point outside of the treenodes.
+	mov eax, inlineSizeMismatch
+	test [rcx].TreeMap.flags, inlinePairsFlag
+	jnz functionReturn
+
+	mov eax, valueDictionaryExists
+	cmp [rcx].TreeMap.valueDictionary, nullptr
+	jne functionReturn
+
+	; Save the replica and the records. The snapshot stream of a bulk
+	; build is followed by the buffer of the old key of a rekey.
+	mov rsi, rcx
+	mov rbx, rdx
+	mov r12, rsp
+
+	sub rsp, [rsi].TreeMap.keySize
+	and rsp, -16
+	mov r15, rsp
+	sub rsp, shadowStorage
+
+	call getChangeRecordSize
+
+	mov r14, rax
+	mul r8
+	lea r13, [rbx + rax]
+
+applyRecord:
+	mov eax, success
+	cmp rbx, r13
+	jae functionReturn
+
+	; Puts into an empty replica may start a run that is built at once.
+	mov rax, [rbx]
+	cmp rax, changePutRecord
+	jne applySingleRecord
+
+	cmp [rsi].TreeMap.nodeAmount, 0
+	jne applySingleRecord
+
+	call buildChangeRun
+
+	cmp edx, success
+	jne returnStatus
+
+	cmp rax, rbx
+	mov rbx, rax
+	jne applyRecord
+
+	mov rax, changePutRecord
+
+applySingleRecord:
+	mov rcx, rsi
+	lea rdx, [rbx + changeKindSize]
+
+	cmp rax, changePutRecord
+	je replayPut
+
+	cmp rax, changeDeleteRecord
+	je replayDelete
+
+	cmp rax, changeReplaceRecord
+	je replayReplace
+
+	cmp rax, changePollFirstRecord
+	je replayPollFirst
+
+	cmp rax, changePollLastRecord
+	je replayPollLast
+
+	cmp rax, changeRekeyRecord
+	je replayRekey
+
+	cmp rax, changeClearRecord
+	jne invalidRecord
+
+	call clearTreeMap
+
+	jmp checkReplayStatus
+
+replayPut:
+	call putPair
+
+	jmp checkReplayStatus
+
+replayDelete:
+	mov r8, nullptr
+	call deletePair
+
+	jmp checkReplayStatus
+
+replayReplace:
+	mov r8, rdx
+	add r8, [rsi].TreeMap.keySize
+	call replaceValue
+
+	jmp checkReplayStatus
+
+replayPollFirst:
+	mov rdx, nullptr
+	call pollFirstPair
+
+	jmp checkReplayStatus
+
+replayPollLast:
+	mov rdx, nullptr
+	call pollLastPair
+
+	jmp checkReplayStatus
+
+replayRekey:
+	mov r8, rdx
+	add r8, [rsi].TreeMap.keySize
+	mov r9, r15
+	call rekeyPair
+
+checkReplayStatus:
+	; Every record was appended after its change succeeded, so it has to succeed again.
+	cmp eax, success
+	jne functionReturn
+
+	add rbx, r14
+
+	jmp applyRecord
+
+returnStatus:
+	mov eax, edx
+
+	jmp functionReturn
+
+invalidRecord:
+	mov eax, snapshotInvalid
+
+functionReturn:
+	lea rsp, [rbp - 7 * qwordSize]
+	pop r15
+	pop r14
+	pop r13
+	pop r12
+	pop rbx
+	pop rdi
+	pop rsi
+	pop rbp
+	ret
+
+applyChangeBatch endp
+
+
+; Builds the empty replica out of the puts at the start of the records whose keys ascend.
+; The pairs are staged as the records of a snapshot, so buildSnapshotTree reads them from memory.
+; Replicas with their own change stream, a checkpoint or a budget insert the pairs one by one.
+;
+; @RBX qword[in] - Pointer to the first put record.
+; @RSI qword[in,out] - Pointer to the empty replica.
+; @R12 qword[in] - Pointer to the memory of a snapshot stream.
+; @R13 qword[in] - Pointer behind the last record.
+; @R14 qword[in] - Size of a record.
+;
+; @return The record behind the run or RBX if the run is too short. EDX is set to the status.
+buildChangeRun proc
+
+	push rdi
+	push r15
+	push rbx
+	push rbp
+	sub rsp, shadowStorage + qwordSize
+
+	mov edx, success
+	mov rax, rbx
+
+	cmp [rsi].TreeMap.changeStream, nullptr
+	jne functionReturn
+
+	cmp [rsi].TreeMap.checkpoint, nullptr
+	jne functionReturn
+
+	cmp [rsi].TreeMap.spill, nullptr
+	jne functionReturn
+
+	; Count the puts while every key is bigger than the one before.
+	lea r15, [rbx + r14]
+	mov ebp, 1
+
+countRun:
+	cmp r15, r13
+	jae checkRunLength
+
+	cmp qword ptr [r15], changePutRecord
+	jne checkRunLength
+
+	lea rcx, [r15 + changeKindSize]
+	sub rcx, r14
+	lea rdx, [r15 + changeKindSize]
+	countTreeMapEvent rsi, comparisons
+	callUserFunc [rsi].TreeMap.compareKeyFunc
+
+	cmp eax, 0
+	jle checkRunLength
+
+	add r15, r14
+	inc rbp
+
+	jmp countRun
+
+checkRunLength:
+	; A single put is inserted like any other record.
+	mov edx, success
+	mov rax, rbx
+	cmp rbp, 2
+	jb functionReturn
+
+	; Stage every pair behind the size of its record.
+	mov rax, [rsi].TreeMap.keySize
+	add rax, [rsi].TreeMap.valueSize
+	add rax, qwordSize
+	mul rbp
+	mov [rsp + shadowStorage], rax
+
+	mov rcx, rax
+	call malloc
+
+	mov edx, errHeapAllocation
+	cmp rax, nullptr
+	je functionReturn
+
+	mov rdi, rax
+
+stagePair:
+	mov rax, [rsi].TreeMap.keySize
+	add rax, [rsi].TreeMap.valueSize
+	mov [rdi], rax
+
+	lea rcx, [rdi + qwordSize]
+	lea rdx, [rbx + changeKindSize]
+	mov r8, rax
+	call memcpy
+
+	mov rax, [rsi].TreeMap.keySize
+	add rax, [rsi].TreeMap.valueSize
+	lea rdi, [rdi + rax + qwordSize]
+	add rbx, r14
+	cmp rbx, r15
+	jb stagePair
+
+	; The stream reads the staged pairs without a file.
+	mov rax, [rsp + shadowStorage]
+	sub rdi, rax
+	mov [r12].SnapshotStream.file, nullptr
+	mov [r12].SnapshotStream.buffer, rdi
+	mov [r12].SnapshotStream.position, 0
+	mov [r12].SnapshotStream.filled, rax
+	mov rcx, fnvOffsetBasis
+	mov [r12].SnapshotStream.checksum, rcx
+	mov [r12].SnapshotStream.pairFunc, nullptr
+	mov [r12].SnapshotStream.record, nullptr
+	mov rcx, [rsi].TreeMap.keySize
+	add rcx, [rsi].TreeMap.valueSize
+	mov [r12].SnapshotStream.maxRecordSize, rcx
+
+	; The children of the root are one level lower than the tree, see loadTreeMap.
+	mov [rsp + shadowStorage], rdi
+	lea rcx, [rbp + 1]
+	bsr rcx, rcx
+	mov edx, 1
+	shl rdx, cl
+	shr rdx, 1
+	dec rdx
+
+	mov rcx, rbp
+	mov edi, success
+	call buildSnapshotTree
+
+	cmp edi, success
+	jne freeStagedPairs
+
+	mov [rsi].TreeMap.root, rax
+
+	; The subtree hashes are summed up once the tree is complete.
+	cmp [rsi].TreeMap.hashPairFunc, nullptr
+	je freeStagedPairs
+
+	mov rcx, rax
+	call hashTreeNodes
+
+freeStagedPairs:
+	mov rcx, [rsp + shadowStorage]
+	call free
+
+	mov edx, edi
+	mov rax, r15
+
+functionReturn:
+	add rsp, shadowStorage + qwordSize
+	pop rbp
+	pop rbx
+	pop r15
+	pop rdi
+	ret
+
+buildChangeRun endp
+
+
+; Calculates the size of a change record of the treemap. A record holds its kind, the key and
+; the value or the new key of a rekey, padded to a multiple of a qword.
+;
+; @RCX qword[in] - Pointer to the treemap.
+;
+; @return The size of a record.
+getChangeRecordSize proc
+
+	mov rax, [rcx].TreeMap.valueSize
+	cmp rax, [rcx].TreeMap.keySize
+	jae addKeySize
+
+	mov rax, [rcx].TreeMap.keySize
+
+addKeySize:
+	add rax, [rcx].TreeMap.keySize
+	add rax, changeKindSize + qwordSize - 1
+	and rax, -qwordSize
+
+	ret
+
+getChangeRecordSize endp
+
+end
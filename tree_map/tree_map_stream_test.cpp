@@ -0,0 +1,336 @@
+/*
+* @file tree_map_stream_test.h
+*
+* Defines unit tests for the change streams of the tree map
+* implementation.
+*
+* @author Collector
+* @data 03/09/2023
+*/
+
+
+#include <thread>
+
+#include "utils.h"
+
+namespace {
+	/*
+	* Record of a change stream of a treemap of numbers.
+	*/
+	struct NumberChange {
+		size_t kind;
+		size_t key;
+		size_t value;
+	};
+
+	/*
+	* Count of the comparisons of countedCompareNumberKey.
+	*/
+	size_t comparisonAmount{ 0 };
+
+	/*
+	* Compares two numbers like compareNumberKey and counts the comparison.
+	*
+	* @param[in] tKey - Key of the tree node.
+	* @param[in] insertedKey - Key that is searched.
+	*
+	* @return Indicator that tells the ordering relation of the keys.
+	*/
+	long countedCompareNumberKey(const void* tKey, const void* insertedKey) {
+		comparisonAmount++;
+
+		return compareNumberKey(tKey, insertedKey);
+	}
+
+	/*
+	* Drains every record of the stream and applies it to the replica.
+	*
+	* @param[in, out] cs - Change stream that is drained.
+	* @param[in, out] replica - Treemap the records are applied to.
+	* @param[in] batchSize - Maximum amount of records of a batch.
+	*
+	* @return Status of the last drain.
+	*/
+	Status drainIntoReplica(ChangeStream* cs, TreeMap* replica, size_t batchSize) {
+		std::vector<NumberChange> batch(batchSize);
+		size_t recordAmount{ 0 };
+		Status s;
+
+		do {
+			s = drainChangeStream(cs, batch.data(), batchSize, &recordAmount);
+
+			EXPECT_EQ(Status::SUCCESS, applyChangeBatch(replica, batch.data(), recordAmount));
+		} while (recordAmount == batchSize);
+
+		return s;
+	}
+}
+
+TEST(TreeMap, createChangeStreamShouldFailForInvalidParameters) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(10, 1) };
+	TreeMap* inlineTree{ createTestInlineTree() };
+
+	ASSERT_EQ(nullptr, createChangeStream(tm, 16, nullptr));
+	ASSERT_EQ(nullptr, createChangeStream(nullptr, 16, &s));
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, s);
+	ASSERT_EQ(nullptr, createChangeStream(tm, 0, &s));
+	ASSERT_EQ(Status::STREAM_CAPACITY_INVALID, s);
+	ASSERT_EQ(nullptr, createChangeStream(tm, 24, &s));
+	ASSERT_EQ(Status::STREAM_CAPACITY_INVALID, s);
+	ASSERT_EQ(nullptr, createChangeStream(inlineTree, 16, &s));
+	ASSERT_EQ(Status::INLINE_SIZE_MISMATCH, s);
+
+	ChangeStream* cs{ createChangeStream(tm, 16, &s) };
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	ASSERT_EQ(cs, tm->changeStream);
+	ASSERT_EQ(sizeof(NumberChange), cs->recordSize);
+	ASSERT_EQ(nullptr, createChangeStream(tm, 16, &s));
+	ASSERT_EQ(Status::CHANGE_STREAM_EXISTS, s);
+
+	size_t recordAmount{ 0 };
+	NumberChange record{};
+
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, drainChangeStream(nullptr, &record, 1, &recordAmount));
+	ASSERT_EQ(Status::PAIR_BUFFER_NULLPTR, drainChangeStream(cs, nullptr, 1, &recordAmount));
+	ASSERT_EQ(Status::AMOUNT_BUFFER_NULLPTR, drainChangeStream(cs, &record, 1, nullptr));
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, applyChangeBatch(nullptr, &record, 1));
+	ASSERT_EQ(Status::PAIR_BUFFER_NULLPTR, applyChangeBatch(tm, nullptr, 1));
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, closeChangeStream(nullptr));
+	ASSERT_EQ(Status::TREE_MAP_NULLPTR, resetChangeStream(nullptr));
+
+	ASSERT_EQ(Status::SUCCESS, closeChangeStream(cs));
+	ASSERT_EQ(nullptr, tm->changeStream);
+
+	deleteTreeMap(inlineTree);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, changeStreamShouldRecordEveryChange) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(4, 1) };
+	ChangeStream* cs{ createChangeStream(tm, 16, &s) };
+	size_t pair[2]{ 10, 100 }, key{ 2 }, value{ 7 }, newKey{ 20 }, keyBuffer{ 0 };
+
+	// Changes that fail aren't recorded.
+	ASSERT_EQ(Status::SUCCESS, putPair(tm, pair));
+	ASSERT_EQ(Status::ALREADY_CONTAINS, putPair(tm, pair));
+	ASSERT_EQ(Status::SUCCESS, replaceValue(tm, &key, &value));
+	ASSERT_EQ(Status::SUCCESS, deletePair(tm, &key, pair));
+	ASSERT_EQ(Status::SUCCESS, pollFirstPair(tm, pair));
+	ASSERT_EQ(Status::SUCCESS, pollLastPair(tm, pair));
+
+	key = 1;
+
+	ASSERT_EQ(Status::SUCCESS, rekeyPair(tm, &key, &newKey, &keyBuffer));
+	ASSERT_EQ(Status::SUCCESS, clearTreeMap(tm));
+
+	NumberChange records[16]{};
+	size_t recordAmount{ 0 };
+
+	ASSERT_EQ(Status::SUCCESS, drainChangeStream(cs, records, 16, &recordAmount));
+	ASSERT_EQ(7, recordAmount);
+
+	ASSERT_EQ(ChangeKind::CHANGE_PUT, records[0].kind);
+	ASSERT_EQ(10, records[0].key);
+	ASSERT_EQ(100, records[0].value);
+	ASSERT_EQ(ChangeKind::CHANGE_REPLACE, records[1].kind);
+	ASSERT_EQ(2, records[1].key);
+	ASSERT_EQ(7, records[1].value);
+	ASSERT_EQ(ChangeKind::CHANGE_DELETE, records[2].kind);
+	ASSERT_EQ(2, records[2].key);
+	ASSERT_EQ(ChangeKind::CHANGE_POLL_FIRST, records[3].kind);
+	ASSERT_EQ(ChangeKind::CHANGE_POLL_LAST, records[4].kind);
+	ASSERT_EQ(ChangeKind::CHANGE_REKEY, records[5].kind);
+	ASSERT_EQ(1, records[5].key);
+	ASSERT_EQ(20, records[5].value);
+	ASSERT_EQ(ChangeKind::CHANGE_CLEAR, records[6].kind);
+
+	// The drained slots are free again.
+	ASSERT_EQ(Status::SUCCESS, drainChangeStream(cs, records, 16, &recordAmount));
+	ASSERT_EQ(0, recordAmount);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, applyChangeBatchShouldKeepAReplicaInSync) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(1000, 1) };
+	TreeMap* replica{ createTestNumberTree(1000, 1) };
+	ChangeStream* cs{ createChangeStream(tm, 64, &s) };
+
+	ASSERT_EQ(Status::SUCCESS, s);
+
+	// The ring is smaller than the changes, so it is drained in between and wraps around.
+	for (size_t round{ 0 }; round < 20; round++) {
+		for (size_t i{ 0 }; i < 10; i++) {
+			size_t key{ 1000 + round * 10 + i }, pair[2]{ key, key * key };
+
+			ASSERT_EQ(Status::SUCCESS, putPair(tm, pair));
+		}
+
+		size_t key{ round * 37 % 1000 }, value{ round }, pair[2]{};
+
+		if (deletePair(tm, &key, pair) == Status::SUCCESS) {
+			key = pair[0] + 1;
+			replaceValue(tm, &key, &value);
+		}
+
+		pollFirstPair(tm, pair);
+		pollLastPair(tm, pair);
+
+		ASSERT_EQ(Status::SUCCESS, drainIntoReplica(cs, replica, 16));
+	}
+
+	assertNumberTreeMapsEqual(tm, replica);
+
+	// A batch that holds an unknown record fails.
+	NumberChange record{ 99, 0, 0 };
+
+	ASSERT_EQ(Status::SNAPSHOT_INVALID, applyChangeBatch(replica, &record, 1));
+
+	deleteTreeMap(replica);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, applyChangeBatchShouldBuildAscendingPutsAtOnce) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(10, 1) };
+	TreeMap* replica{ createTreeMap(sizeof(size_t), sizeof(size_t), countedCompareNumberKey,
+		equalsNumberValue, copyNumberKey, copyNumberValue, nullptr, &s) };
+	ChangeStream* cs{ createChangeStream(tm, 1 << 14, &s) };
+
+	// The primary is cleared and loaded again in key order, the last put inserts a smaller key.
+	ASSERT_EQ(Status::SUCCESS, clearTreeMap(tm));
+
+	for (size_t key{ 0 }; key < 10000; key++) {
+		size_t pair[2]{ key * 2 + 1, key };
+
+		ASSERT_EQ(Status::SUCCESS, putPair(tm, pair));
+	}
+
+	size_t pair[2]{ 0, 0 };
+
+	ASSERT_EQ(Status::SUCCESS, putPair(tm, pair));
+
+	std::vector<NumberChange> records(1 << 14);
+	size_t recordAmount{ 0 };
+
+	ASSERT_EQ(Status::SUCCESS, drainChangeStream(cs, records.data(), records.size(), &recordAmount));
+	ASSERT_EQ(10002, recordAmount);
+
+	// The run needs a comparison per put, inserting every pair would need about log2(10000) of them.
+	comparisonAmount = 0;
+
+	ASSERT_EQ(Status::SUCCESS, applyChangeBatch(replica, records.data(), recordAmount));
+	ASSERT_GT(12000, comparisonAmount);
+
+	assertNumberTreeMapsEqual(tm, replica);
+
+	// The built tree is a valid red black tree that takes further changes.
+	for (size_t key{ 1 }; key < 20000; key += 4) {
+		ASSERT_EQ(Status::SUCCESS, deletePair(replica, &key, pair));
+		ASSERT_EQ(Status::SUCCESS, deletePair(tm, &key, pair));
+	}
+
+	assertNumberTreeMapsEqual(tm, replica);
+
+	deleteTreeMap(replica);
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, fullChangeStreamShouldReportLostChanges) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(0, 1) };
+	ChangeStream* cs{ createChangeStream(tm, 8, &s) };
+
+	for (size_t key{ 0 }; key < 20; key++) {
+		size_t pair[2]{ key, key };
+
+		ASSERT_EQ(Status::SUCCESS, putPair(tm, pair));
+	}
+
+	ASSERT_EQ(12, cs->lostAmount);
+
+	// The records in front of the loss are drained first.
+	NumberChange records[8]{};
+	size_t recordAmount{ 0 };
+
+	ASSERT_EQ(Status::SUCCESS, drainChangeStream(cs, records, 4, &recordAmount));
+	ASSERT_EQ(4, recordAmount);
+	ASSERT_EQ(Status::CHANGES_LOST, drainChangeStream(cs, records, 8, &recordAmount));
+	ASSERT_EQ(4, recordAmount);
+	ASSERT_EQ(7, records[3].key);
+
+	// Free slots don't resume the stream, the replica needs a snapshot first.
+	size_t pair[2]{ 20, 20 };
+
+	ASSERT_EQ(Status::SUCCESS, putPair(tm, pair));
+	ASSERT_EQ(Status::CHANGES_LOST, drainChangeStream(cs, records, 8, &recordAmount));
+	ASSERT_EQ(0, recordAmount);
+
+	ASSERT_EQ(Status::SUCCESS, resetChangeStream(cs));
+
+	pair[0] = 21;
+
+	ASSERT_EQ(Status::SUCCESS, putPair(tm, pair));
+	ASSERT_EQ(Status::SUCCESS, drainChangeStream(cs, records, 8, &recordAmount));
+	ASSERT_EQ(1, recordAmount);
+	ASSERT_EQ(21, records[0].key);
+
+	deleteTreeMap(tm);
+}
+
+TEST(TreeMap, changeStreamShouldBeDrainedByAnotherThread) {
+	Status s;
+	TreeMap* tm{ createTestNumberTree(0, 1) };
+	TreeMap* replica{ createTestNumberTree(0, 1) };
+	ChangeStream* cs{ createChangeStream(tm, 256, &s) };
+	bool producerDone{ false };
+
+	// The producer waits for free slots, so no record is lost.
+	std::thread producer{ [&]() {
+		for (size_t key{ 0 }; key < 50000; key++) {
+			size_t pair[2]{ key * 7919 % 50000, key }, pairBuffer[2]{};
+
+			while (cs->head - reinterpret_cast<volatile size_t&>(cs->tail) == cs->capacity) {
+				std::this_thread::yield();
+			}
+
+			putPair(tm, pair);
+
+			if (key % 3 == 0) {
+				while (cs->head - reinterpret_cast<volatile size_t&>(cs->tail) == cs->capacity) {
+					std::this_thread::yield();
+				}
+
+				pollFirstPair(tm, pairBuffer);
+			}
+		}
+
+		reinterpret_cast<volatile bool&>(producerDone) = true;
+	} };
+
+	std::vector<NumberChange> batch(64);
+	size_t recordAmount{ 0 };
+
+	for (;;) {
+		bool done{ reinterpret_cast<volatile bool&>(producerDone) };
+
+		ASSERT_EQ(Status::SUCCESS, drainChangeStream(cs, batch.data(), batch.size(), &recordAmount));
+		ASSERT_EQ(Status::SUCCESS, applyChangeBatch(replica, batch.data(), recordAmount));
+
+		if (done && recordAmount == 0) {
+			break;
+		}
+	}
+
+	producer.join();
+
+	ASSERT_EQ(0, cs->lostAmount);
+	assertNumberTreeMapsEqual(tm, replica);
+
+	deleteTreeMap(replica);
+	deleteTreeMap(tm);
+}
@@ -16,7 +16,7 @@
 
 ; Gets the given value associated by the given key if the pair exists.
 ;
-; @RCX qword[in] - Pointer to the treemap the value is looked up in.
+; @RCX qword[in,out] - Pointer to the treemap the value is looked up in.
 ; @RDX qword[in] - Pointer to the key of the value thats searched for.
 ; @R8 qword[out] - Pointer to a buffer tree node value where the found value is copied into.
 ;
@@ -24,8 +24,9 @@
 ;		  in the map or a errCopyValueFunc when the copy function of the value fails.
 getValue proc
 
-	; Allocating storage for findAddress
-	sub rsp, shadowStorage
+	; Allocating storage for findAddress and
+	; keep the stack aligned.
+	sub rsp, shadowStorage + qwordSize
 
 	; Check if the treeMap is a nullptr.
 	cmp rcx, nullptr
@@ -35,6 +36,12 @@ getValue proc
 	cmp r8, nullptr
 	je valueBufferInvalid
 
+	; Spilled treenodes on the path of the key are faulted back in.
+	call faultSpilledPath
+
+	cmp eax, success
+	jne functionReturn
+
 	; Save the buffer for the tree node value in the extra space.
 	mov [rsp + valueBuffer], r8
 
@@ -54,8 +61,19 @@ getValue proc
 	mov rcx, [rsp + valueBuffer]
 	add rax, [r10].TreeMap.keySize
 	mov rdx, rax
+
+	; An interned value is copied out of its dictionary entry.
+	cmp [r10].TreeMap.valueDictionary, nullptr
+	je copyFoundValue
+
+	mov rdx, [rdx]
+	add rdx, sizeof DictionaryEntry
+
+copyFoundValue:
+	; The copy leaves the treemap, so the copy function gets no treemap.
 	mov R8B, false
-	call [r10].TreeMap.copyValueFunc
+	mov r9, nullptr
+	callUserFunc [r10].TreeMap.copyValueFunc
 
 	jmp functionReturn
 
@@ -73,7 +91,7 @@ valueBufferInvalid:
 	mov eax, valueBufferNullptr
 
 functionReturn:
-	add rsp, shadowStorage
+	add rsp, shadowStorage + qwordSize
 	ret
 
 getValue endp
@@ -84,7 +102,7 @@ getValue endp
 ; Retrieves the key that is paired together with the provided value if such
 ; pair exists in the treemap.
 ;
-; @RCX qword[in] - Pointer to the treemap the given key is searched in.
+; @RCX qword[in,out] - Pointer to the treemap the given key is searched in.
 ; @RDX qword[in] - Pointer to the value that is paired with the searched key.
 ; @R8 qword[out] - Pointer to a buffer where the key will be copied into if it has been found.
 ;
@@ -112,6 +130,21 @@ getKey proc
 	mov rdi, rdx
 	mov rbx, r8
 
+	; Spilled treenodes are faulted back in before every value is visited.
+	mov rcx, rsi
+	sub rsp, shadowStorage + qwordSize
+	call restoreSpilledTreeMap
+	add rsp, shadowStorage + qwordSize
+
+	cmp eax, success
+	jne functionReturn
+
+	; With a value dictionary the ID of the value is searched instead.
+	call findValueId
+
+	cmp rdi, nullptr
+	je getKeyContainsFailure
+
 	; Set parameters accordingly and save the current root in our space.
 	mov rcx, [rsi].TreeMap.root
 	call findAddressOfValue
@@ -126,10 +159,11 @@ getKey proc
 	mov rdx, rax
 	sub rdx, [rsi].TreeMap.keySize
 
-	; Call copyKeyFunc. The status value will be set
-	; by the copy function.
+	; Call copyKeyFunc without the treemap, because the copy leaves it.
+	; The status value will be set by the copy function.
+	mov r8, nullptr
 	sub rsp, 3 * qwordSize
-	call [rsi].TreeMap.copyKeyFunc
+	callUserFunc [rsi].TreeMap.copyKeyFunc
 	add rsp, 3 * qwordSize
 
 	jmp functionReturn
@@ -161,8 +195,9 @@ getKey endp
 	public containsValue
 
 ; Finds out if the given value exists inside the treemap.
+; With a value dictionary a value that isn't interned is rejected without visiting the treenodes.
 ;
-; @RCX qword[in] - Pointer to the treemap where the value is searched in.
+; @RCX qword[in,out] - Pointer to the treemap where the value is searched in.
 ; @RDX qword[in] - Pointer to the value that is searched inside the treemap.
 ;
 ; @return Success, treeMapNullptr or doesNotContain status value.
@@ -182,6 +217,21 @@ containsValue proc
 	mov rsi, rcx
 	mov rdi, rdx
 
+	; Spilled treenodes are faulted back in before every value is visited.
+	mov rcx, rsi
+	sub rsp, shadowStorage + qwordSize
+	call restoreSpilledTreeMap
+	add rsp, shadowStorage + qwordSize
+
+	cmp eax, success
+	jne functionReturn
+
+	; With a value dictionary the ID of the value is searched instead.
+	call findValueId
+
+	cmp rdi, nullptr
+	je containsFailure
+
 	; Call find address and test if the returned value
 	; matches the root or not.
 	mov rcx, [rsi].TreeMap.root
@@ -216,20 +266,26 @@ containsValue endp
 
 ; Finds out if the specified key exists in the treemap.
 ; 
-; @RCX qword[in] - Pointer to the treemap where the key is searched in.
+; @RCX qword[in,out] - Pointer to the treemap where the key is searched in.
 ; @RDX qword[in] - Pointer to the key that is searched inside the treemap.
 ;
 ; @return Success, treeMapNullptr or doesNotContain status value.
 containsKey proc
 
 	; Allocate shadow storage for the findAddress function to preserve
-	; volatile registers used.
-	sub rsp, shadowStorage
+	; volatile registers used. 8 extra bytes keep the stack aligned.
+	sub rsp, shadowStorage + qwordSize
 
 	; Check if the treemap is not a nullptr.
 	cmp rcx, nullptr
 	je treeMapInvalid
 
+	; Spilled treenodes on the path of the key are faulted back in.
+	call faultSpilledPath
+
+	cmp eax, success
+	jne functionReturn
+
 	; Set r8 to the treemap and rcx to the current root.
 	mov r8, rcx
 	mov rcx, [rcx].TreeMap.root
@@ -253,7 +309,7 @@ treeMapInvalid:
 	mov eax, treeMapNullptr
 
 functionReturn:
-	add rsp, shadowStorage
+	add rsp, shadowStorage + qwordSize
 	ret	
 
 containsKey endp
@@ -263,15 +319,15 @@ containsKey endp
 ;
 ; @RCX qword[in] - Pointer to the current tree node that has a value.
 ; @RSI qword[in] - Pointer to the currently used treemap.
-; @RDI qword[in] - Pointer to the address of the value that is searched inside the treemap.
+; @RDI qword[in] - Pointer to the address of the value that is searched inside the treemap
+;				   or its ID if the treemap has a value dictionary.
 ;
 ; @return Address of the specified value inside the treemap or the address passed into rcx.
 findAddressOfValue proc
 
-	; The stack is misaligned when calling this function
-	; and needs to stay like that to be consistant with the
-	; alignment.
-	sub rsp, 2 * qwordSize
+	; The stack is misaligned when calling this function.
+	; Sub 24 bytes so that every recursive call is misaligned the same way.
+	sub rsp, 3 * qwordSize
 
 	; Test if this node is a nullptr.
 	cmp rcx, nullptr
@@ -284,12 +340,32 @@ findAddressOfValue proc
 	; Store the address to the value.
 	mov [rsp], rcx
 
-	; Add shadow storage for potential abi call.
-	sub rsp, shadowStorage
+	; Interned values are equal if they have the same ID.
+	mov rax, [rsi].TreeMap.valueDictionary
+	cmp rax, nullptr
+	je compareValues
+
+	cmp [rax].ValueDictionary.interned, false
+	je resolveValue
+
+	cmp [rcx], rdi
+	sete al
+
+	jmp checkMatch
+
+resolveValue:
+	; Separated values are compared where they are stored.
+	mov rcx, [rcx]
+	add rcx, sizeof DictionaryEntry
+
+compareValues:
+	; Add shadow storage for potential abi call and align the stack.
+	sub rsp, shadowStorage + qwordSize
 	mov rdx, rdi
-    call [rsi].TreeMap.equalsValueFunc
-	add rsp, shadowStorage
+	callUserFunc [rsi].TreeMap.equalsValueFunc
+	add rsp, shadowStorage + qwordSize
 
+checkMatch:
 	; check if the values match and restore the value pointer.
 	cmp al, true
 	mov rax, [rsp]
@@ -336,12 +412,42 @@ checkRightBranch:
 	jmp functionReturn
 
 functionReturn:
-	add rsp, 2 * qwordSize
+	add rsp, 3 * qwordSize
 	ret
 
 findAddressOfValue endp
 
+; Replaces the searched value with its ID if the treemap has a value dictionary that interns its values.
+; A value that isn't interned has no ID and is replaced by a nullptr.
+;
+; @RDI qword[in,out] - Pointer to the value that is searched inside the treemap.
+; @RSI qword[in] - Pointer to the currently used treemap.
+findValueId proc
+
+	; containsValue and getKey call this function with a misaligned
+	; stack, so only the shadow storage is needed to align it again.
+	sub rsp, shadowStorage
+
+	mov rax, [rsi].TreeMap.valueDictionary
+	cmp rax, nullptr
+	je functionReturn
+
+	cmp [rax].ValueDictionary.interned, false
+	je functionReturn
+
+	mov rcx, rdi
+	call findDictionaryEntry
+
+	mov rdi, rax
+
+functionReturn:
+	add rsp, shadowStorage
+	ret
+
+findValueId endp
+
 ; Retrieves the address of the specified key inside the treemap if it exists.
+; Inside a multimap the address of the oldest pair with the key is returned.
 ;
 ; @RCX qword[in] - Pointer to the current tree node that has a key.
 ; @RDX qword[in] - Pointer to the address of the key that is searched for inside the treemap.
@@ -350,35 +456,49 @@ findAddressOfValue endp
 ; @return Address of the specified value inside the treemap or nullptr if it does not exist.
 findAddressOfKey proc
 
+	push rbp
+	mov rbp, rsp
+	sub rsp, shadowStorage + 16
+
+	; Nothing has been found yet.
+	mov qword ptr [rsp + foundKey], nullptr
+
 compareKeyLoop:
 	; Test if the current node is a nullptr.
 	cmp rcx, nullptr
-	je doesNotContainKey
+	je functionReturn
 
 	; Safe the parameters in the shadow storage given by the caller.
-	mov [rsp + currentTreeNode3], rcx
-	mov [rsp + searchedKey], rdx
-	mov [rsp + treemap2], r8
+	mov [rbp + currentTreeNode3], rcx
+	mov [rbp + searchedKey], rdx
+	mov [rbp + treemap5], r8
 
-	; Add another shadow storage in case the user needs abi compliance.
-	sub rsp, shadowStorage
-	call [r8].TreeMap.compareKeyFunc
-	add rsp, shadowStorage
+	countTreeMapEvent r8, comparisons
+	callUserFunc [r8].TreeMap.compareKeyFunc
+
+	; Restore params, the treemap must survive the callback
+	; because callers rely on it being preserved in r8.
+	mov rcx, [rbp + currentTreeNode3]
+	mov rdx, [rbp + searchedKey]
+	mov r8, [rbp + treemap5]
 
 	; Check if we found the key.
-	cmp rax, 0
-	mov rcx, [rsp + currentTreeNode3]
-	je doesContainKey
-
-	; If keys don't match restore params and
-	; move rcx to the left child.
-	mov rdx, [rsp + searchedKey]
-	mov r8, [rsp + treemap2]
+	cmp eax, 0
+	jne loadChild
+
+	; Save the found treenode. A multimap continues with the left
+	; child because it can hold older pairs with the same key.
+	mov [rsp + foundKey], rcx
+	test [r8].TreeMap.flags, multiMapFlag
+	jz functionReturn
+
+loadChild:
+	; Move rcx to the left child.
 	add rcx, [r8].TreeMap.keySize
 	add rcx, [r8].TreeMap.valueSize
 
 	; Compare again because add 
-	cmp rax, 0
+	cmp eax, 0
 	jg loadRightBranch
 
 loadLeftBranch:
@@ -394,16 +514,11 @@ loadRightBranch:
 
 	jmp compareKeyLoop
 
-doesNotContainKey:
-	; If nothing is found return nullptr.
-	xor rax, rax
-	jmp functionReturn
-
-doesContainKey:
-	; If something was found return the address.
-	mov rax, rcx
-
 functionReturn:
+	; Return the found address or a nullptr.
+	mov rax, [rsp + foundKey]
+	mov rsp, rbp
+	pop rbp
 	ret
 
 findAddressOfKey endp
@@ -411,21 +526,40 @@ findAddressOfKey endp
 	public replaceValue
 
 ; Replaces the value of a key value pair specified by the given key inside the treemap
-; if the key value pair exists.
+; if the key value pair exists. Inline values are copied without the value copy function.
+; With a value dictionary the new value is interned and the old one loses a reference.
 ;
 ; @RCX qword[in,out] - Pointer to the treemap where the replacement will take place.
 ; @RDX qword[in] - Pointer to the key that identifies the key value pair where the value will be replaced.
 ; @R8 qword[in] - Pointer to the value that will replace the current value inside the key value pair.
 ;
-; @return A Status value of either success, doesNotContain, treeMapNullptr or errCopyValueFunc if the replacement fails.
+; @return A Status value of either success, doesNotContain, treeMapNullptr or errCopyValueFunc/errHeapAllocation
+;		  if the replacement fails.
 replaceValue proc
 
-	sub rsp, shadowStorage
+	sub rsp, shadowStorage + qwordSize
 
 	; Check if the treemap is a nullptr.
 	cmp rcx, nullptr
 	je treeMapInvalid
 
+	; A running checkpoint copies the pair before its value is replaced.
+	cmp [rcx].TreeMap.checkpoint, nullptr
+	je saveReplacementValue
+
+	mov r9, r8
+	mov r8, nullptr
+	call preserveCheckpointPair
+
+	mov r8, r9
+
+saveReplacementValue:
+	; Spilled treenodes on the path of the key are faulted back in.
+	call faultSpilledPath
+
+	cmp eax, success
+	jne functionReturn
+
 	mov [rsp + replacementValue], r8
 
 	; Set r8 to the treemap and rcx to the current root.
@@ -439,16 +573,79 @@ replaceValue proc
 	je replaceContainsFailure
 
 	; Restore the treemap and the new value source pointer.
-	; The new value is stored as the source.
+	; The new value is stored as the source, the treenode is kept for its hash.
+	mov [rsp + shadowStorage], rax
 	mov r10, [rsp + treemap3]
 	mov rdx, [rsp + replacementValue]
+
+	; Inline values are copied into the treenode by the treemap itself.
+	test [r10].TreeMap.flags, inlinePairsFlag
+	jz replaceInternedValue
+
+	mov rcx, r10
+	mov r8, rdx
+	mov rdx, rax
+	call replaceInlineValue
+
+	jmp functionReturn
+
+replaceInternedValue:
+	; With a value dictionary the treenode gets the ID of the new value.
+	cmp [r10].TreeMap.valueDictionary, nullptr
+	je copyReplacement
+
+	mov rcx, r10
+	mov r8, rdx
+	mov rdx, rax
+	call replaceDictionaryValue
+
+	jmp functionReturn
+
+copyReplacement:
 	mov rcx, rax
 	add rcx, [r10].TreeMap.keySize
 	mov r8B, true
+	mov r9, r10
+	sub rsp, shadowStorage
+	callUserFunc [r10].TreeMap.copyValueFunc
+	add rsp, shadowStorage
+
+	cmp eax, success
+	jne functionReturn
+
+	; The subtrees above the treenode change with the hash of its pair.
+	mov rcx, [rsp + treemap3]
+	cmp [rcx].TreeMap.hashPairFunc, nullptr
+	je recordReplacement
+
+	mov rdx, [rsp + shadowStorage]
 	sub rsp, shadowStorage
-	call [r10].TreeMap.copyValueFunc
+	call updateTreeNodeHash
 	add rsp, shadowStorage
 
+	mov eax, success
+
+recordReplacement:
+	; The change stream and the log record the key with the new value.
+	mov rcx, [rsp + treemap3]
+	cmp [rcx].TreeMap.changeStream, nullptr
+	je logReplacement
+
+	mov edx, changeReplaceRecord
+	mov r8, [rsp + replacementKey]
+	mov r9, [rsp + replacementValue]
+	call recordChange
+
+logReplacement:
+	mov rcx, [rsp + treemap3]
+	cmp [rcx].TreeMap.log, nullptr
+	je functionReturn
+
+	mov edx, logReplaceRecord
+	mov r8, [rsp + replacementKey]
+	mov r9, [rsp + replacementValue]
+	call recordLogChange
+
 	jmp functionReturn
 
 replaceContainsFailure:
@@ -461,13 +658,13 @@ treeMapInvalid:
 	mov eax, treeMapNullptr
 
 functionReturn:
-	add rsp, shadowStorage
+	add rsp, shadowStorage + qwordSize
 	ret
 
 replaceValue endp
 
 ; Creates a deep copy of a treenodes pair. The buffer has to be provided
-; and is not created.
+; and is not created. The copy leaves the treemap, so the copy functions get no treemap.
 ;
 ; @RCX qword[out] - Pointer to the buffer that is filled with the given treenode pair.
 ; @RDX qword[in] - Pointer to the treenode whose key value pair is deep copied.
@@ -476,7 +673,7 @@ replaceValue endp
 ; @returns A status value of success or failure in case the copy functions fail.
 copyPair proc
 
-	sub rsp, shadowStorage * 2
+	sub rsp, shadowStorage * 2 + qwordSize
 
 	; Save the treemap, the found min/max treenode and
 	; the buffer to deep copy it.
@@ -485,7 +682,9 @@ copyPair proc
 	mov [rsp + treemap4], r8
 
 	; Copy the key.
-	call [r8].TreeMap.copyKeyFunc
+	mov r8, nullptr
+	mov r10, [rsp + treemap4]
+	callUserFunc [r10].TreeMap.copyKeyFunc
 
 	; Return if any error happened.
 	cmp eax, success
@@ -501,11 +700,21 @@ copyPair proc
 	add rcx, [r8].TreeMap.keySize
 	add rdx, [r8].TreeMap.keySize
 	mov r10, r8
+
+	; An interned value is copied out of its dictionary entry.
+	cmp [r10].TreeMap.valueDictionary, nullptr
+	je copyValue
+
+	mov rdx, [rdx]
+	add rdx, sizeof DictionaryEntry
+
+copyValue:
 	mov r8B, false
-	call [r10].TreeMap.copyValueFunc
+	mov r9, nullptr
+	callUserFunc [r10].TreeMap.copyValueFunc
 
 functionReturn:
-	add rsp, shadowStorage * 2
+	add rsp, shadowStorage * 2 + qwordSize
 	ret
 
 copyPair endp
@@ -513,8 +722,9 @@ copyPair endp
 	public ceilingPair
 
 ; Retrieves the next higher or the same key value pair for a given key if it exists.
+; Inside a multimap the oldest pair with an equal key is retrieved.
 ;
-; @RCX qword[in] - Pointer to the current treemap that will be used.
+; @RCX qword[in,out] - Pointer to the current treemap that will be used.
 ; @RDX qword[in] - Pointer to the key that is used to get the ceiling key value pair.
 ; @R8 qword[out] - Pointer to a buffer that is used to copy the result key value pair into it.
 ;
@@ -538,8 +748,9 @@ ceilingPair endp
 	public floorPair
 
 ; Retrieves the next lower or the same key value pair for a given key if it exists.
+; Inside a multimap the newest pair with an equal key is retrieved.
 ;
-; @RCX qword[in] - Pointer to the current treemap that will be used.
+; @RCX qword[in,out] - Pointer to the current treemap that will be used.
 ; @RDX qword[in] - Pointer to the key that is used to get the floor key value pair.
 ; @R8 qword[out] - Pointer to a buffer that is used to copy the result key value pair into it.
 ;
@@ -587,6 +798,12 @@ getFloorCeilingPair proc
 	cmp r8, nullptr
 	je pairBufferInvalid
 
+	; Spilled treenodes on the path of the key are faulted back in.
+	call faultSpilledPath
+
+	cmp eax, success
+	jne functionReturn
+
 	; Save the comparison key, the treemap and the buffer.
 	mov [rbp + searchKey], rdx
 	mov [rbp + treemap2], rcx
@@ -609,7 +826,8 @@ ceilingFloorLoop:
 	; Save the current treenode and call the compare function.
 	mov [rsp + currentTreeNode2], r11
 	mov rcx, r11
-	call [r10].TreeMap.compareKeyFunc
+	countTreeMapEvent r10, comparisons
+	callUserFunc [r10].TreeMap.compareKeyFunc
 
 	; Restore the flag, the current tree node, the treemap and the comparison key.
 	mov r9B, byte ptr [rbp + ceilingFloorFlag]
@@ -659,6 +877,11 @@ foundPotentialPair:
 	cmp al, 0
 	jne continueWithOppositeBranch
 
+	; A multimap continues to find the oldest pair of the key
+	; for ceiling and the newest one for floor.
+	test [r10].TreeMap.flags, multiMapFlag
+	jnz continueWithOppositeBranch
+
 	jmp executeCpy
 
 continueWithOppositeBranch:
@@ -713,7 +936,7 @@ getFloorCeilingPair endp
 ; Retrieves the next key value pair of the treemap that has a key greater than
 ; the provided one.
 ;
-; @RCX qword[in] - Pointer to the current treemap that will be used.
+; @RCX qword[in,out] - Pointer to the current treemap that will be used.
 ; @RDX qword[in] - Pointer to the key that is used to get the next higher key value pair if it exists.
 ; @R8 qword[out] - Pointer to a buffer to copy the key value pair into.
 ;
@@ -738,7 +961,7 @@ higherPair endp
 ; Retrieves the next key value pair of the treemap that has a key less than
 ; the provided one.
 ;
-; @RCX qword[in] - Pointer to the current treemap that will be used.
+; @RCX qword[in,out] - Pointer to the current treemap that will be used.
 ; @RDX qword[in] - Pointer to the key that is used to get the next lower key value pair if it exists.
 ; @R8 qword[out] - Pointer to a buffer to copy the key value pair into.
 ;
@@ -759,8 +982,6 @@ lowerPair proc
 lowerPair endp
 
 ; Retrieves the higher or lower key value pair by the specified key if it exists.
-; The potential lower or higher key value pair is saved on the stack. The same
-; applies to the currently evaluated tree node.
 ;
 ; @RCX qword[in] - Pointer to the current treemap that will be used.
 ; @RDX qword[in] - Pointer to the key that is used to get the higher or lower pair if it exists.
@@ -772,10 +993,9 @@ lowerPair endp
 ;		  in case the copy functions fail.
 getLowerHigherPair proc
 
-	; Shadowstorage for the comparison function is always allocated.
-	; Additionally storage needs to exist for the current tree node
-	; and the last found pair which takes 16 bytes and 8 extra for alignment
-	; on a 16 byte boundary.
+	; Shadowstorage for the called functions is always allocated.
+	; Additionally storage needs to exist for the buffer and the treemap
+	; which takes 16 bytes and 8 extra for alignment on a 16 byte boundary.
 	sub rsp, shadowStorage + 24
 
 	; Check if the treemap is a nullptr.
@@ -786,10 +1006,72 @@ getLowerHigherPair proc
 	cmp r8, nullptr
 	je pairBufferInvalid
 
-	; Save the comparison key, the treemap and the buffer.
+	; Spilled treenodes around the key are faulted back in.
+	call faultSpilledPath
+
+	cmp eax, success
+	jne functionReturn
+
+	; Save the buffer and the treemap and search the treenode.
+	mov [rsp + pairBuffer], r8
+	mov [rsp + treemap], rcx
+	call findLowerHigherNode
+
+	; Test if a lower or higher tree node was found.
+	cmp rax, nullptr
+	je lowerHigherPairFailure
+
+	; Copy the pair into the destination buffer.
+	mov rcx, [rsp + pairBuffer]
+	mov rdx, rax
+	mov r8, [rsp + treemap]
+	call copyPair
+
+	jmp functionReturn
+
+lowerHigherPairFailure:
+	; Set the return value to a failure.
+	mov eax, doesNotContain
+
+	jmp functionReturn
+
+treeMapInvalid:
+	mov eax, treeMapNullptr
+
+	jmp functionReturn
+
+pairBufferInvalid:
+	mov eax, pairBufferNullptr
+
+functionReturn:
+	add rsp, shadowStorage + 24
+	ret
+
+getLowerHigherPair endp
+
+; Searches the treenode with the next higher or lower key of the specified key.
+; The potential lower or higher treenode is saved on the stack. The same
+; applies to the currently evaluated tree node.
+;
+; @RCX qword[in] - Pointer to the current treemap that will be used.
+; @RDX qword[in] - Pointer to the key that is used to get the higher or lower treenode.
+; @R9 byte[in] - Flag that indicates if we want to get a higher or lower treenode. False for lower,
+;				 true for higher.
+;
+; @return The higher or lower treenode or a nullptr if it does not exist.
+findLowerHigherNode proc
+
+	push rbp
+	mov rbp, rsp
+
+	; Shadowstorage for the comparison function is always allocated.
+	; Additionally storage needs to exist for the current tree node
+	; and the last found treenode which takes 16 bytes.
+	sub rsp, shadowStorage + 16
+
+	; Save the comparison key and the treemap.
 	mov [rbp + searchKey], rdx
 	mov [rbp + treemap2], rcx
-	mov [rbp + pairBuffer], r8
 
 	; Mov the treemap to an unused register
 	; and load the root.
@@ -803,12 +1085,13 @@ getLowerHigherPair proc
 lowerHigherLoop:
 	; check if our current treenode is a nullptr.
 	cmp r11, nullptr
-	je checkIfNodeWasFound
+	je functionReturn
 
 	; Save the current treenode and call the compare function.
 	mov [rsp + currentTreeNode2], r11
 	mov rcx, r11
-	call [r10].TreeMap.compareKeyFunc
+	countTreeMapEvent r10, comparisons
+	callUserFunc [r10].TreeMap.compareKeyFunc
 
 	; Restore the flag, the current tree node, the treemap and the comparison key.
 	mov r9B, byte ptr [rbp + higherLowerFlag]
@@ -825,13 +1108,13 @@ lowerHigherLoop:
 	jne fetchHigher
 
 	; Check if we go left or right.
-	cmp al, 0
+	cmp eax, 0
 	jg foundPotentialHigherLowerBranch
 	jle getNextChild
 
 fetchHigher:
 	; Check if we go left or right.
-	cmp al, 0
+	cmp eax, 0
 	jl foundPotentialHigherLowerBranch
 	jge getNextChild
 
@@ -864,44 +1147,19 @@ foundPotentialHigherLowerBranch:
 	
 	jmp lowerHigherLoop
 
-checkIfNodeWasFound:
-	; Test if a lower or higher tree node was found.
-	cmp qword ptr [rsp + foundPair], nullptr
-	je lowerHigherPairFailure
-
-	; Copy the pair into the destination buffer.
-	mov rcx, [rbp + pairBuffer]
-	mov rdx, [rsp + foundPair]
-	mov r8, r10
-	call copyPair
-
-	jmp functionReturn
-
-lowerHigherPairFailure:
-	; Set the return value to a failure.
-	mov eax, doesNotContain
-
-	jmp functionReturn
-
-treeMapInvalid:
-	mov eax, treeMapNullptr
-
-	jmp functionReturn
-
-pairBufferInvalid:
-	mov eax, pairBufferNullptr
-
 functionReturn:
-	add rsp, shadowStorage + 24
+	mov rax, [rsp + foundPair]
+	mov rsp, rbp
+	pop rbp
 	ret
 
-getLowerHigherPair endp
+findLowerHigherNode endp
 
 	public minPair
 
 ; Retrieves the smallest pair the tree holds or nothing if the tree is empty.
 ;
-; @RCX qword[in] - Pointer to the treemap the smallest pair shall be extracted.
+; @RCX qword[in,out] - Pointer to the treemap the smallest pair shall be extracted.
 ; @RDX qword[out] - Pointer to a buffer where a deep copy of the min pair is stored.
 ;
 ; @return Status value of success, failure of the copy functions or if the treemap or
@@ -919,7 +1177,7 @@ minPair endp
 
 ; Retrieves the biggest pair of the tree or nothing if the tree is empty.
 ;
-; @RCX qword[in] - Pointer to the treemap the biggest pair shall be extracted.
+; @RCX qword[in,out] - Pointer to the treemap the biggest pair shall be extracted.
 ; @RDX qword[out] - Pointer to a buffer where a deep copy of the max pair is stored.
 ;
 ; @return Status value of success, failure of the copy functions or if the treemap or
@@ -952,6 +1210,12 @@ lastPair proc
 	cmp rdx, nullptr
 	je pairBufferInvalid
 
+	; Spilled treenodes on the branch are faulted back in.
+	call faultSpilledBranch
+
+	cmp eax, success
+	jne functionReturn
+
 	; Save the treemap in an unused register.
 	; Get the rootnode and check if it not a nullptr.
 	mov r10, rcx
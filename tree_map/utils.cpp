@@ -124,12 +124,35 @@ namespace {
 
 		return true;
 	}
+
+	/*
+	* Copies a string into the payload arena of a treemap or onto the heap
+	* if the string is copied out of the treemap.
+	* 
+	* @param[in] str - The string that is copied.
+	* @param[in] tm - Treemap that stores the copy or a nullptr.
+	* 
+	* @return The copy or a nullptr if the allocation failed.
+	*/
+	char* copyPayloadString(const char* str, TreeMap* tm) {
+		size_t size{ std::strlen(str) + 1 };
+		char* cpy{ reinterpret_cast<char*>(tm != nullptr ? allocatePayload(tm, size) : malloc(size)) };
+
+		if (cpy != nullptr) {
+			std::memcpy(cpy, str, size);
+		}
+
+		return cpy;
+	}
 }
 
 long compareTreeNodeKey(const void* tKey, const void* insertedKey) {
 	const TreeNodeKey* x{ reinterpret_cast<const TreeNodeKey*>(tKey) }, * y{ reinterpret_cast<const TreeNodeKey*>(insertedKey) };
 
-	return std::strcmp(y->stateName, x->stateName);
+	int result{ std::strcmp(y->stateName, x->stateName) };
+
+	// The treemap expects -1, 0 or 1, which not every c library returns.
+	return (result > 0) - (result < 0);
 }
 
 bool equalsTreeNodeKey(const void* expectedKey, const void* resultKey) {
@@ -142,7 +165,7 @@ bool equalsTreeNodeValue(const void* tValue, const void* tValueSearched) {
 	return std::strcmp(y->capitalCity, x->capitalCity) == 0 && y->existsSince == x->existsSince && y->population == x->population;
 }
 
-Status copyTreeNodeKey(void* dstKey, const void* srcKey) {
+Status copyTreeNodeKey(void* dstKey, const void* srcKey, TreeMap* tm) {
 	TreeNodeKey* dst{ reinterpret_cast<TreeNodeKey*>(dstKey) };
 	const TreeNodeKey* src{ reinterpret_cast<const TreeNodeKey*>(srcKey) };
 
@@ -152,7 +175,7 @@ Status copyTreeNodeKey(void* dstKey, const void* srcKey) {
 	return dst->stateName == nullptr ? Status::ERR_COPY_KEY : Status::SUCCESS;
 }
 
-Status copyTreeNodeValue(void* dstValue, const void* srcValue, bool replaceValue) {
+Status copyTreeNodeValue(void* dstValue, const void* srcValue, bool replaceValue, TreeMap* tm) {
 	Status copyStat{ Status::ERR_COPY_VALUE };
 	TreeNodeValue* dst{ reinterpret_cast<TreeNodeValue*>(dstValue) };
 	const TreeNodeValue* src{ reinterpret_cast<const TreeNodeValue*>(srcValue) };
@@ -175,6 +198,180 @@ Status copyTreeNodeValue(void* dstValue, const void* srcValue, bool replaceValue
 	return copyStat;
 }
 
+long compareInlineData(const void* tKey, const void* insertedKey) {
+	const InlineData* x{ reinterpret_cast<const InlineData*>(tKey) }, * y{ reinterpret_cast<const InlineData*>(insertedKey) };
+
+	int result{ std::memcmp(y->bytes, x->bytes, std::min(x->byteAmount, y->byteAmount)) };
+
+	if (result == 0) {
+		result = (y->byteAmount > x->byteAmount) - (y->byteAmount < x->byteAmount);
+	}
+
+	return (result > 0) - (result < 0);
+}
+
+bool equalsInlineData(const void* tValue, const void* tValueSearched) {
+	return compareInlineData(tValue, tValueSearched) == 0;
+}
+
+Status copyInlineKey(void* dstKey, const void* srcKey, TreeMap* tm) {
+	InlineData* dst{ reinterpret_cast<InlineData*>(dstKey) };
+	const InlineData* src{ reinterpret_cast<const InlineData*>(srcKey) };
+
+	void* bytes{ malloc(src->byteAmount + 1) };
+
+	if (bytes == nullptr) {
+		return Status::ERR_COPY_KEY;
+	}
+
+	std::memcpy(bytes, src->bytes, src->byteAmount);
+
+	dst->bytes = bytes;
+	dst->byteAmount = src->byteAmount;
+
+	return Status::SUCCESS;
+}
+
+Status copyInlineValue(void* dstValue, const void* srcValue, bool replaceValue, TreeMap* tm) {
+	InlineData* dst{ reinterpret_cast<InlineData*>(dstValue) };
+	const InlineData* src{ reinterpret_cast<const InlineData*>(srcValue) };
+
+	void* bytes{ malloc(src->byteAmount + 1) };
+
+	if (bytes == nullptr) {
+		return Status::ERR_COPY_VALUE;
+	}
+
+	std::memcpy(bytes, src->bytes, src->byteAmount);
+
+	if (replaceValue) {
+		free(const_cast<void*>(dst->bytes));
+	}
+
+	dst->bytes = bytes;
+	dst->byteAmount = src->byteAmount;
+
+	return Status::SUCCESS;
+}
+
+long compareNumberKey(const void* tKey, const void* insertedKey) {
+	size_t x{ *reinterpret_cast<const size_t*>(tKey) }, y{ *reinterpret_cast<const size_t*>(insertedKey) };
+
+	return y < x ? -1 : (y > x ? 1 : 0);
+}
+
+bool equalsNumberValue(const void* tValue, const void* tValueSearched) {
+	return *reinterpret_cast<const size_t*>(tValue) == *reinterpret_cast<const size_t*>(tValueSearched);
+}
+
+Status copyNumberKey(void* dstKey, const void* srcKey, TreeMap* tm) {
+	*reinterpret_cast<size_t*>(dstKey) = *reinterpret_cast<const size_t*>(srcKey);
+
+	return Status::SUCCESS;
+}
+
+Status copyNumberValue(void* dstValue, const void* srcValue, bool replaceValue, TreeMap* tm) {
+	*reinterpret_cast<size_t*>(dstValue) = *reinterpret_cast<const size_t*>(srcValue);
+
+	return Status::SUCCESS;
+}
+
+Status copyPayloadTreeNodeKey(void* dstKey, const void* srcKey, TreeMap* tm) {
+	TreeNodeKey* dst{ reinterpret_cast<TreeNodeKey*>(dstKey) };
+	const TreeNodeKey* src{ reinterpret_cast<const TreeNodeKey*>(srcKey) };
+
+	dst->nameLength = src->nameLength;
+	dst->stateName = ::copyPayloadString(src->stateName, tm);
+
+	return dst->stateName == nullptr ? Status::ERR_COPY_KEY : Status::SUCCESS;
+}
+
+Status copyPayloadTreeNodeValue(void* dstValue, const void* srcValue, bool replaceValue, TreeMap* tm) {
+	TreeNodeValue* dst{ reinterpret_cast<TreeNodeValue*>(dstValue) };
+	const TreeNodeValue* src{ reinterpret_cast<const TreeNodeValue*>(srcValue) };
+
+	char* capitalCityCpy{ ::copyPayloadString(src->capitalCity, tm) };
+
+	if (capitalCityCpy == nullptr) {
+		return Status::ERR_COPY_VALUE;
+	}
+
+	dst->existsSince = src->existsSince;
+	dst->population = src->population;
+	dst->capitalCity = capitalCityCpy;
+
+	return Status::SUCCESS;
+}
+
+Status relocateTreeNodePair(void* treeNodePair, TreeMap* tm) {
+	TreeNodePair* p{ reinterpret_cast<TreeNodePair*>(treeNodePair) };
+
+	char* stateNameCpy{ ::copyPayloadString(p->key.stateName, tm) };
+	char* capitalCityCpy{ ::copyPayloadString(p->value.capitalCity, tm) };
+
+	if (stateNameCpy == nullptr || capitalCityCpy == nullptr) {
+		return Status::ERR_HEAP_ALLOCATION;
+	}
+
+	p->key.stateName = stateNameCpy;
+	p->value.capitalCity = capitalCityCpy;
+
+	return Status::SUCCESS;
+}
+
+size_t serializeTreeNodePair(void* record, const void* treeNodePair) {
+	const TreeNodePair* p{ reinterpret_cast<const TreeNodePair*>(treeNodePair) };
+	char* r{ reinterpret_cast<char*>(record) };
+
+	size_t stateNameSize{ p->key.nameLength + 1 };
+	size_t capitalCitySize{ std::strlen(p->value.capitalCity) + 1 };
+	size_t recordSize{ stateNameSize + capitalCitySize + sizeof(p->value.existsSince) + sizeof(p->value.population) };
+
+	if (recordSize > SNAPSHOT_RECORD_SIZE) {
+		return 0;
+	}
+
+	memcpy(r, p->key.stateName, stateNameSize);
+	r += stateNameSize;
+	memcpy(r, p->value.capitalCity, capitalCitySize);
+	r += capitalCitySize;
+	memcpy(r, &p->value.existsSince, sizeof(p->value.existsSince));
+	r += sizeof(p->value.existsSince);
+	memcpy(r, &p->value.population, sizeof(p->value.population));
+
+	return recordSize;
+}
+
+Status deserializeTreeNodePair(void* treeNodePair, const void* record, size_t recordSize) {
+	TreeNodePair* p{ reinterpret_cast<TreeNodePair*>(treeNodePair) };
+	const char* r{ reinterpret_cast<const char*>(record) };
+
+	size_t stateNameSize{ strnlen(r, recordSize) + 1 };
+	size_t capitalCitySize{ stateNameSize < recordSize ? strnlen(r + stateNameSize, recordSize - stateNameSize) + 1 : recordSize };
+
+	if (stateNameSize + capitalCitySize + sizeof(p->value.existsSince) + sizeof(p->value.population) != recordSize) {
+		return Status::SNAPSHOT_INVALID;
+	}
+
+	p->key.stateName = _strdup(r);
+	p->key.nameLength = stateNameSize - 1;
+	p->value.capitalCity = _strdup(r + stateNameSize);
+
+	if (p->key.stateName == nullptr || p->value.capitalCity == nullptr) {
+		free(p->key.stateName);
+		free(p->value.capitalCity);
+
+		return Status::ERR_HEAP_ALLOCATION;
+	}
+
+	r += stateNameSize + capitalCitySize;
+	memcpy(&p->value.existsSince, r, sizeof(p->value.existsSince));
+	r += sizeof(p->value.existsSince);
+	memcpy(&p->value.population, r, sizeof(p->value.population));
+
+	return Status::SUCCESS;
+}
+
 TreeNodeKey* createTreeNodeKey(const char* stateName) {
 	TreeNodeKey* k{ new TreeNodeKey };
 
@@ -266,6 +463,18 @@ void freeTreeNodePair(void* treeNodePair) {
 	free(v->value.capitalCity);
 }
 
+void freeDictionaryTreeNodePair(void* treeNodePair) {
+	TreeNodePair* p{ reinterpret_cast<TreeNodePair*>(treeNodePair) };
+
+	free(p->key.stateName);
+}
+
+void freeTreeNodeValue(void* treeNodeValue) {
+	TreeNodeValue* v{ reinterpret_cast<TreeNodeValue*>(treeNodeValue) };
+
+	free(v->capitalCity);
+}
+
 void freeTreeNodePairs(const std::vector<TreeNodePair*>& pairs) {
 	for (TreeNodePair* p : pairs) {
 		if (p != nullptr) {
@@ -313,6 +522,198 @@ TreeMap* createTestTreeByNodes(const std::vector<const TreeNode*>& nodes) {
 	return tm;
 }
 
+TreeMap* createTestMultiMap() {
+	Status s;
+
+	TreeMap* tm{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeTreeNodePair, &s) };
+
+	setTreeMapFlags(tm, TreeMapFlags::MULTI_MAP);
+
+	std::vector<TreeNode*> nodes{
+		createTreeNode("Kansas", "Topeka", 1861, 2937880, false),
+		createTreeNode("Oregon", "Salem", 1859, 4237256, false),
+		createTreeNode("Kansas", "Wichita", 1870, 397532, false),
+		createTreeNode("Minnesota", "Saint Paul", 1858, 5706494, false),
+		createTreeNode("Kansas", "Lawrence", 1854, 94934, false),
+	};
+
+	for (TreeNode* node : nodes) {
+		putPair(tm, &node->pair);
+	}
+
+	freeTreeNodes(nodes);
+
+	return tm;
+}
+
+InlinePair createInlinePair(const char* stateName, const char* capitalCity) {
+	return { { stateName, std::strlen(stateName) }, { capitalCity, std::strlen(capitalCity) } };
+}
+
+TreeMap* createTestInlineTree() {
+	Status s;
+
+	TreeMap* tm{ createTreeMap(sizeof(InlineData), sizeof(InlineData), compareInlineData,
+		equalsInlineData, copyInlineKey, copyInlineValue, nullptr, &s) };
+
+	setTreeMapFlags(tm, TreeMapFlags::INLINE_PAIRS);
+
+	std::vector<InlinePair> pairs{
+		createInlinePair("Washington", "Olympia"),
+		createInlinePair("Oregon", "Salem"),
+		createInlinePair("New York", "Albany"),
+		createInlinePair("Minnesota", "Saint Paul"),
+		createInlinePair("Kansas", "Topeka"),
+	};
+
+	for (const InlinePair& pair : pairs) {
+		putPair(tm, &pair);
+	}
+
+	return tm;
+}
+
+void assertInlineDataEquals(const char* expected, const InlineData* result) {
+	ASSERT_EQ(std::strlen(expected), result->byteAmount);
+	ASSERT_EQ(0, std::memcmp(expected, result->bytes, result->byteAmount));
+}
+
+void assertInlineValueEquals(TreeMap* tm, const char* stateName, const char* capitalCity) {
+	Status s;
+	InlineData key{ stateName, std::strlen(stateName) }, value;
+
+	s = getValue(tm, &key, &value);
+
+	ASSERT_EQ(Status::SUCCESS, s);
+	assertInlineDataEquals(capitalCity, &value);
+
+	free(const_cast<void*>(value.bytes));
+}
+
+TreeMap* createTestPayloadTree(size_t blockSize) {
+	Status s;
+
+	TreeMap* tm{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyPayloadTreeNodeKey, copyPayloadTreeNodeValue, nullptr, &s) };
+
+	createPayloadArena(tm, blockSize);
+
+	std::vector<TreeNode*> nodes{
+		createTreeNode("Washington", "Olympia", 1889, 7705281, false),
+		createTreeNode("Oregon", "Salem", 1859, 4237256, false),
+		createTreeNode("New York", "Albany", 1788, 20201249, false),
+		createTreeNode("Minnesota", "Saint Paul", 1858, 5706494, false),
+		createTreeNode("Kansas", "Topeka", 1861, 2937880, false),
+	};
+
+	for (TreeNode* node : nodes) {
+		putPair(tm, &node->pair);
+	}
+
+	freeTreeNodes(nodes);
+
+	return tm;
+}
+
+TreeMap* createTestDictionaryTree() {
+	Status s;
+
+	TreeMap* tm{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeDictionaryTreeNodePair, &s) };
+
+	createValueDictionary(tm, freeTreeNodeValue);
+
+	std::vector<TreeNode*> nodes{
+		createTreeNode("Washington", "Pacific", 0, 0, false),
+		createTreeNode("Oregon", "Pacific", 0, 0, false),
+		createTreeNode("New York", "Northeast", 0, 0, false),
+		createTreeNode("Minnesota", "Midwest", 0, 0, false),
+		createTreeNode("Kansas", "Midwest", 0, 0, false),
+	};
+
+	for (TreeNode* node : nodes) {
+		putPair(tm, &node->pair);
+	}
+
+	freeTreeNodes(nodes);
+
+	return tm;
+}
+
+TreeMap* createTestSeparatedTree() {
+	Status s;
+
+	TreeMap* tm{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeDictionaryTreeNodePair, &s) };
+
+	separateLargeValues(tm, 0, freeTreeNodeValue);
+
+	std::vector<TreeNode*> nodes{
+		createTreeNode("Washington", "Pacific", 0, 0, false),
+		createTreeNode("Oregon", "Pacific", 0, 0, false),
+		createTreeNode("New York", "Northeast", 0, 0, false),
+		createTreeNode("Minnesota", "Midwest", 0, 0, false),
+		createTreeNode("Kansas", "Midwest", 0, 0, false),
+	};
+
+	for (TreeNode* node : nodes) {
+		putPair(tm, &node->pair);
+	}
+
+	freeTreeNodes(nodes);
+
+	return tm;
+}
+
+TreeMap* createTestNodeArenaTree(size_t chunkSize, size_t flags) {
+	Status s;
+
+	TreeMap* tm{ createTreeMap(sizeof(TreeNodeKey), sizeof(TreeNodeValue), compareTreeNodeKey,
+		equalsTreeNodeValue, copyTreeNodeKey, copyTreeNodeValue, freeTreeNodePair, &s) };
+
+	createNodeArena(tm, chunkSize, flags);
+
+	std::vector<TreeNode*> nodes{
+		createTreeNode("Washington", "Olympia", 1889, 7705281, false),
+		createTreeNode("Oregon", "Salem", 1859, 4237256, false),
+		createTreeNode("New York", "Albany", 1788, 20201249, false),
+		createTreeNode("Minnesota", "Saint Paul", 1858, 5706494, false),
+		createTreeNode("Kansas", "Topeka", 1861, 2937880, false),
+	};
+
+	for (TreeNode* node : nodes) {
+		putPair(tm, &node->pair);
+	}
+
+	freeTreeNodes(nodes);
+
+	return tm;
+}
+
+TreeMap* createTestNumberTree(size_t amount, size_t step) {
+	Status s;
+
+	TreeMap* tm{ createTreeMap(sizeof(size_t), sizeof(size_t), compareNumberKey,
+		equalsNumberValue, copyNumberKey, copyNumberValue, nullptr, &s) };
+
+	for (size_t i{ 0 }; i < amount; i++) {
+		size_t pair[2]{ i * step, i * step * i * step };
+
+		putPair(tm, pair);
+	}
+
+	return tm;
+}
+
+FILE* createTemporaryFile() {
+	FILE* file{ nullptr };
+
+	EXPECT_EQ(0, tmpfile_s(&file));
+
+	return file;
+}
+
 void assertTreeNodeKeyEquals(const TreeNodeKey* expected, const TreeNodeKey* result) {
 	ASSERT_EQ(0, std::strcmp(expected->stateName, result->stateName));
 	ASSERT_EQ(expected->nameLength, result->nameLength);
@@ -342,7 +743,7 @@ void assertTreeMapMemberEqual(const TreeMap* result, size_t expectedNodeAmount)
 	ASSERT_NE(nullptr, result->root);
 }
 
-void assertContainsValueEquals(const std::vector<TreeNodeValue*>& values, const TreeMap* tm, Status expectedStat) {
+void assertContainsValueEquals(const std::vector<TreeNodeValue*>& values, TreeMap* tm, Status expectedStat) {
 	Status containsStat;
 
 	for (const TreeNodeValue* value : values) {
@@ -354,7 +755,7 @@ void assertContainsValueEquals(const std::vector<TreeNodeValue*>& values, const
 	freeTreeNodeValues(values);
 }
 
-void assertContainsKeyEquals(const std::vector<TreeNodeKey*>& keys, const TreeMap* tm, Status expectedStat) {
+void assertContainsKeyEquals(const std::vector<TreeNodeKey*>& keys, TreeMap* tm, Status expectedStat) {
 	Status containsStat;
 
 	for (TreeNodeKey* key : keys) {
@@ -387,7 +788,27 @@ void assertTreeNodePairEquals(TreeNodePair* expectedPair, TreeNodePair* resultPa
 	assertTreeNodeValueEquals(&expectedPair->value, &resultPair->value);
 }
 
-void assertMinMaxPairEquals(TreeNodePair* expectedPair, const TreeMap* tm, GetMinMaxPair getMinMaxPairFunc,
+void assertNumberTreeMapsEqual(TreeMap* expected, TreeMap* result) {
+	ASSERT_EQ(expected->nodeAmount, result->nodeAmount);
+
+	size_t expectedPair[2]{}, resultPair[2]{};
+	Status s{ minPair(expected, expectedPair) };
+
+	ASSERT_EQ(s, minPair(result, resultPair));
+
+	while (s == Status::SUCCESS) {
+		ASSERT_EQ(expectedPair[0], resultPair[0]);
+		ASSERT_EQ(expectedPair[1], resultPair[1]);
+
+		size_t key{ expectedPair[0] };
+
+		s = higherPair(expected, &key, expectedPair);
+
+		ASSERT_EQ(s, higherPair(result, &key, resultPair));
+	}
+}
+
+void assertMinMaxPairEquals(TreeNodePair* expectedPair, TreeMap* tm, GetMinMaxPair getMinMaxPairFunc,
 	Status expectedStat, bool dismissPair) {
 	Status resultStat;
 	TreeNodePair resultPair, * resultPairPtr{ dismissPair ? nullptr : &resultPair };
@@ -16,11 +16,34 @@
 
 #include <vector>
 #include <stdexcept>
+#include <algorithm>
 
 #include <gtest/gtest.h>
 
 #include "tree_map.h"
 
+// The linux build calls the treemap functions with the system v calling convention
+// and provides the microsoft functions that the tests use.
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+
+#define __fastcall
+#define _strdup strdup
+
+inline int tmpfile_s(FILE** file) {
+	*file = std::tmpfile();
+
+	return *file == nullptr ? errno : 0;
+}
+
+inline int fopen_s(FILE** file, const char* path, const char* mode) {
+	*file = std::fopen(path, mode);
+
+	return *file == nullptr ? errno : 0;
+}
+#endif
+
 /*
 * Typedef for the getKey and getValue functions.
 * 
@@ -31,7 +54,7 @@
 * @return A status value of success, does not contains or an error if the
 *		  copy functions fail or the treemap/valueBuffer is a nullptr.
 */
-using GetTreeMapPartialData = Status(__fastcall*)(const TreeMap* tm, const void* data, void* dataBuffer);
+using GetTreeMapPartialData = Status(__fastcall*)(TreeMap* tm, const void* data, void* dataBuffer);
 
 /*
 * Typedef for a function that compares two treenode keys or values.
@@ -64,7 +87,7 @@ using FreeTreeNodePartialData = void(__fastcall*)(const std::vector<T>& nodeData
 * @return A status value of success, does not contain or an error if the copy
 *		  functions fail or the treemap/pairBuffer is a nullptr.
 */
-using GetMinMaxPair = Status(__fastcall*)(const TreeMap* tm, void* pairBuffer);
+using GetMinMaxPair = Status(__fastcall*)(TreeMap* tm, void* pairBuffer);
 
 /*
 * Typedef for a function that is used to hide away ceilingPair/floorPair/higherPair/lowerPair.
@@ -77,7 +100,7 @@ using GetMinMaxPair = Status(__fastcall*)(const TreeMap* tm, void* pairBuffer);
 *		  key was found or an error if the copy functions failed or the treemap or the pairBuffer
 *		  is a nullptr.
 */
-using GetDerivedPair = Status(__fastcall*)(const TreeMap* tm, const void* key, void* pairBuffer);
+using GetDerivedPair = Status(__fastcall*)(TreeMap* tm, const void* key, void* pairBuffer);
 
 /*
 * Typedef for a function that is used to hide away pollFirstWrapper/pollLastWrapper/deletePair.
@@ -158,6 +181,34 @@ struct TreeNode {
 	bool isRed;
 };
 
+/*
+* Test struct for treemaps with inline pairs. The key is the
+* name of a state and the value the name of its capital city.
+*/
+struct InlinePair {
+	InlineData key;
+	InlineData value;
+};
+
+/*
+* Treenode of the treemaps of numbers that createTestNumberTree creates.
+* 
+* @var key - Number that is the key.
+* @var value - Number that is the value.
+* @var left - Left child of the tree node.
+* @var right - Right child of the tree node.
+* @var isRed - Flag that indicates if the tree node is red or black.
+*/
+struct NumberTreeNode {
+	size_t key;
+	size_t value;
+
+	NumberTreeNode* left;
+	NumberTreeNode* right;
+
+	bool isRed;
+};
+
 /*
 * Helper function for the treemap to compare two keys with each other.
 * The implementation is as the KeyComparison typedef specifies and serves as an example
@@ -203,10 +254,11 @@ bool equalsTreeNodeValue(const void* tValue, const void* tValueSearched);
 * 
 * @param[out] destKey - The destination key buffer that stores the source key.
 * @param[in] srcKey - The source key that will be copied into destKey.
+* @param[in] tm - Ignored.
 * 
 * @return A status value that indicates if the copying was successful or not.
 */
-Status copyTreeNodeKey(void* dstKey, const void* srcKey);
+Status copyTreeNodeKey(void* dstKey, const void* srcKey, TreeMap* tm);
 
 
 /*
@@ -218,10 +270,171 @@ Status copyTreeNodeKey(void* dstKey, const void* srcKey);
 * @param[in] srcValue - The source value that will be copied into dstValue.
 * @param[in] replaceValue - Flag that decides wether the old value in dstValue
 *							should be replaced.
+* @param[in] tm - Ignored.
+* 
+* @return A status value that indicates if the copying was successful or not.
+*/
+Status copyTreeNodeValue(void* dstValue, const void* srcValue, bool replaceValue, TreeMap* tm);
+
+/*
+* Helper function for treemaps with inline pairs that compares two inline keys
+* byte wise. A key that is a prefix of the other one is the smaller one.
+* 
+* @param[in] tKey - Inline key of the tree node that is compared to the inserted one.
+* @param[in] insertedKey - Inline key that is compared to the tree nodes key.
+* 
+* @return Value of -1, 0 or 1 to specify if the insertedKey is smaller, equal
+*		  or bigger than the tree nodes key.
+*/
+long compareInlineData(const void* tKey, const void* insertedKey);
+
+/*
+* Helper function for treemaps with inline pairs that tests two inline values for equality.
+* 
+* @param[in] tValue - Inline value of the tree node that is compared with the searched one.
+* @param[in] tValueSearched - Inline value that is searched inside the treemap.
+* 
+* @return Indicator that the two are equal.
+*/
+bool equalsInlineData(const void* tValue, const void* tValueSearched);
+
+/*
+* Helper function for treemaps with inline pairs that deep copies an inline key
+* out of the treemap into a buffer. The copied bytes are allocated on the heap.
+* 
+* @param[out] dstKey - The InlineData that receives the copy.
+* @param[in] srcKey - The InlineData inside the tree node.
+* @param[in] tm - Ignored.
+* 
+* @return A status value that indicates if the copying was successful or not.
+*/
+Status copyInlineKey(void* dstKey, const void* srcKey, TreeMap* tm);
+
+/*
+* Helper function for treemaps with inline pairs that deep copies an inline value
+* out of the treemap into a buffer. The copied bytes are allocated on the heap.
+* 
+* @param[out] dstValue - The InlineData that receives the copy.
+* @param[in] srcValue - The InlineData inside the tree node.
+* @param[in] replaceValue - Flag that decides wether the old bytes of dstValue are freed.
+* @param[in] tm - Ignored.
+* 
+* @return A status value that indicates if the copying was successful or not.
+*/
+Status copyInlineValue(void* dstValue, const void* srcValue, bool replaceValue, TreeMap* tm);
+
+/*
+* Helper function for treemaps of numbers that compares two size_t keys
+* like compareTreeNodeKey compares the state names.
+* 
+* @param[in] tKey - Key of the tree node that is compared to the inserted one.
+* @param[in] insertedKey - Key that is compared to the tree nodes key.
+* 
+* @return Value of -1, 0 or 1 to specify if the insertedKey is smaller, equal
+*		  or bigger than the tree nodes key.
+*/
+long compareNumberKey(const void* tKey, const void* insertedKey);
+
+/*
+* Helper function for treemaps of numbers that tests two size_t values for equality.
+* 
+* @param[in] tValue - Value of the tree node that is compared with the searched one.
+* @param[in] tValueSearched - Value that is searched inside the treemap.
+* 
+* @return Indicator that the two are equal.
+*/
+bool equalsNumberValue(const void* tValue, const void* tValueSearched);
+
+/*
+* Helper function for treemaps of numbers that copies a size_t key.
+* 
+* @param[out] dstKey - Key that receives the copy.
+* @param[in] srcKey - Key that is copied.
+* @param[in] tm - Ignored.
+* 
+* @return A status value of success.
+*/
+Status copyNumberKey(void* dstKey, const void* srcKey, TreeMap* tm);
+
+/*
+* Helper function for treemaps of numbers that copies a size_t value.
+* 
+* @param[out] dstValue - Value that receives the copy.
+* @param[in] srcValue - Value that is copied.
+* @param[in] replaceValue - Ignored because numbers hold no heap memory.
+* @param[in] tm - Ignored.
+* 
+* @return A status value of success.
+*/
+Status copyNumberValue(void* dstValue, const void* srcValue, bool replaceValue, TreeMap* tm);
+
+/*
+* Helper function for treemaps with a payload arena that copies a tree node key.
+* The state name is allocated inside the payload arena of tm and must not be freed.
+* A key copied out of the treemap gets a state name on the heap that the caller frees.
+* 
+* @param[out] dstKey - The key that receives the copy.
+* @param[in] srcKey - The key that is copied.
+* @param[in] tm - Treemap that stores the key or a nullptr for a copy out of it.
+* 
+* @return A status value that indicates if the copying was successful or not.
+*/
+Status copyPayloadTreeNodeKey(void* dstKey, const void* srcKey, TreeMap* tm);
+
+/*
+* Helper function for treemaps with a payload arena that copies a tree node value.
+* The capital city is allocated inside the payload arena of tm. A replaced capital city stays
+* inside the arena until it is compacted. A value copied out of the treemap gets a capital city
+* on the heap that the caller frees.
+* 
+* @param[out] dstValue - The value that receives the copy.
+* @param[in] srcValue - The value that is copied.
+* @param[in] replaceValue - Ignored because the arena frees the old capital city.
+* @param[in] tm - Treemap that stores the value or a nullptr for a copy out of it.
 * 
 * @return A status value that indicates if the copying was successful or not.
 */
-Status copyTreeNodeValue(void* dstValue, const void* srcValue, bool replaceValue);
+Status copyPayloadTreeNodeValue(void* dstValue, const void* srcValue, bool replaceValue, TreeMap* tm);
+
+/*
+* Helper function for compactPayloadArena that copies the state name and capital city
+* of a tree node pair into the payload arena again as specified in the typedef RelocatePair.
+* 
+* @param[in, out] treeNodePair - Pair whose nested data is relocated.
+* @param[in] tm - Treemap whose payload arena is compacted.
+* 
+* @return A status value that indicates if the relocation was successful or not.
+*/
+Status relocateTreeNodePair(void* treeNodePair, TreeMap* tm);
+
+/*
+* Maximum size of a record that serializeTreeNodePair writes.
+*/
+constexpr size_t SNAPSHOT_RECORD_SIZE{ 128 };
+
+/*
+* Helper function for saveTreeMap that writes a tree node pair as a record
+* as specified in the typedef SerializePair. The record holds both strings
+* with their terminators followed by the year and the population.
+* 
+* @param[out] record - Buffer of the maximum record size.
+* @param[in] treeNodePair - Pair that is serialized.
+* 
+* @return Size of the record or zero if it would exceed the maximum record size.
+*/
+size_t serializeTreeNodePair(void* record, const void* treeNodePair);
+
+/*
+* Helper function for loadTreeMap that creates a tree node pair out of a record
+* of serializeTreeNodePair as specified in the typedef DeserializePair.
+* 
+* @param[out] treeNodePair - Pair that is created.
+* @param[in] record - Record of serializeTreeNodePair.
+* @param[in] recordSize - Size of the record.
+* 
+* @return A status value that indicates if the pair was created or not.
+*/
+Status deserializeTreeNodePair(void* treeNodePair, const void* record, size_t recordSize);
 
 /*
 * Utility function that creates a tree node key on the heap.
@@ -307,6 +520,124 @@ TreeMap* createTestTree();
 */
 TreeMap* createTestTreeByNodes(const std::vector<const TreeNode*>& nodes);
 
+/*
+* Creates a multimap on the heap that holds the pairs
+* 
+*	"Kansas" "Topeka", "Oregon" "Salem", "Kansas" "Wichita",
+*	"Minnesota" "Saint Paul", "Kansas" "Lawrence"
+* 
+* inserted in this order and used for testing.
+* 
+* Failures of putPair will not be tracked because the test would fail anyways.
+* 
+* @return The multimap with the above pairs.
+*/
+TreeMap* createTestMultiMap();
+
+/*
+* Creates a view of a state name and its capital city as an inline pair.
+* The pair points at the given strings without copying them.
+* 
+* @param[in] stateName - The name of a state of america.
+* @param[in] capitalCity - The capital city of the state.
+* 
+* @return The inline pair.
+*/
+InlinePair createInlinePair(const char* stateName, const char* capitalCity);
+
+/*
+* Creates a treemap with inline pairs on the heap that holds the states and capital cities
+* of createTestTree in the same tree node structure.
+* 
+* Failures of putPair will not be tracked because the test would fail anyways.
+* 
+* @return The treemap with inline pairs.
+*/
+TreeMap* createTestInlineTree();
+
+/*
+* Asserts that the bytes of an inline key or value match the given string.
+* 
+* @param[in] expected - Expected string without its terminating zero.
+* @param[in] result - InlineData that is compared with the string.
+*/
+void assertInlineDataEquals(const char* expected, const InlineData* result);
+
+/*
+* Asserts that the given state is stored with the given capital city inside a treemap with inline pairs.
+* 
+* @param[in] tm - Treemap with inline pairs.
+* @param[in] stateName - The name of the state that is looked up.
+* @param[in] capitalCity - The capital city that is expected as the value.
+*/
+void assertInlineValueEquals(TreeMap* tm, const char* stateName, const char* capitalCity);
+
+/*
+* Creates a treemap with a payload arena on the heap that holds the same pairs as createTestTree.
+* The nested data of the pairs is allocated inside the arena, so the treemap has no free pair function.
+* The copy functions allocate from the arena of the treemap they receive, so several such treemaps can be used at once.
+* 
+* Failures of putPair will not be tracked because the test would fail anyways.
+* 
+* @param[in] blockSize - Block size of the payload arena.
+* 
+* @return The treemap with a payload arena.
+*/
+TreeMap* createTestPayloadTree(size_t blockSize);
+
+/*
+* Creates a treemap with a value dictionary on the heap. It holds the keys of createTestTree
+* in the same tree node structure, but the values are the regions of the states. Washington and Oregon
+* share the region "Pacific", Minnesota and Kansas share "Midwest" and New York is in "Northeast".
+* 
+* Failures of putPair will not be tracked because the test would fail anyways.
+* 
+* @return The treemap with a value dictionary.
+*/
+TreeMap* createTestDictionaryTree();
+
+/*
+* Creates a treemap on the heap whose values are separated from the treenodes by separateLargeValues.
+* It holds the same pairs as createTestDictionaryTree, but every value is stored on its own.
+* 
+* Failures of putPair will not be tracked because the test would fail anyways.
+* 
+* @return The treemap with separated values.
+*/
+TreeMap* createTestSeparatedTree();
+
+/*
+* Creates a treemap with a node arena on the heap that holds the same pairs as createTestTree.
+* 
+* Failures of putPair will not be tracked because the test would fail anyways.
+* 
+* @param[in] chunkSize - Chunk size of the node arena.
+* @param[in] flags - NodeArenaFlags of the node arena.
+* 
+* @return The treemap with a node arena.
+*/
+TreeMap* createTestNodeArenaTree(size_t chunkSize, size_t flags);
+
+/*
+* Creates a treemap of numbers on the heap. The keys start at zero with the given
+* distance between them and every key is mapped to its square.
+* 
+* Failures of putPair will not be tracked because the test would fail anyways.
+* 
+* @param[in] amount - Amount of pairs.
+* @param[in] step - Distance between two keys.
+* 
+* @return The treemap of numbers.
+*/
+TreeMap* createTestNumberTree(size_t amount, size_t step);
+
+/*
+* Opens a temporary file that is removed when it is closed.
+* 
+* @return The temporary file.
+*/
+FILE* createTemporaryFile();
+
 /*
 * Frees the given tree nodes.
 * All nested heap memory will be freed.
@@ -341,6 +672,21 @@ void freeTreeNodeValues(const std::vector<TreeNodeValue*>& values);
 */
 void freeTreeNodePair(void* treeNodePair);
 
+/*
+* Frees the key of a tree node pair inside a treemap with a value dictionary,
+* where the value of the pair is only its ID. Is used as the FreePair function of such treemaps.
+* 
+* @param[out] treeNodePair - Pair that gets the nested heap memory of its key freed.
+*/
+void freeDictionaryTreeNodePair(void* treeNodePair);
+
+/*
+* Frees the nested heap memory of a tree node value as specified in the typedef FreeValue.
+* 
+* @param[out] treeNodeValue - Value that gets its nested heap memory freed.
+*/
+void freeTreeNodeValue(void* treeNodeValue);
+
 /*
 * Frees all tree node pairs completely. Nested heap memory will be freed.
 * The vector is allowed to hold nullptrs, they will be ignored.
@@ -393,7 +739,7 @@ void assertTreeMapMemberEqual(const TreeMap* result, size_t nodeAmount);
 * @param[in] tm - Treemap that is expected to hold the values.
 * @param[in] expectedStat - Expected result status for all values. Decides if a value is expected or not.
 */
-void assertContainsValueEquals(const std::vector<TreeNodeValue*>& values, const TreeMap* tm, Status expectedStat);
+void assertContainsValueEquals(const std::vector<TreeNodeValue*>& values, TreeMap* tm, Status expectedStat);
 
 /*
 * Asserts that the treemap contains (or not) the given keys.
@@ -405,7 +751,7 @@ void assertContainsValueEquals(const std::vector<TreeNodeValue*>& values, const
 * @param[in] tm - Treemap that is expected to hold the keys.
 * @param[in] expectedStat - Expected result status for all keys. Decides if a key is expected or not.
 */
-void assertContainsKeyEquals(const std::vector<TreeNodeKey*>& keys, const TreeMap* tm, Status expectedStat);
+void assertContainsKeyEquals(const std::vector<TreeNodeKey*>& keys, TreeMap* tm, Status expectedStat);
 
 /*
 * Asserts that the treemaps getValue function retrieves the correct values for the given key.
@@ -461,6 +807,15 @@ void assertTreePartialDataEquals(const std::vector<T*>& provided, const std::vec
 */
 void assertTreeNodePairEquals(TreeNodePair* expectedPair, TreeNodePair* resultPair);
 
+/*
+* Asserts that two treemaps of numbers like the ones of createTestNumberTree
+* hold the same pairs.
+* 
+* @param[in] expected - Treemap with the expected pairs.
+* @param[in] result - Treemap that is checked.
+*/
+void assertNumberTreeMapsEqual(TreeMap* expected, TreeMap* result);
+
 /*
 * Asserts the min/max pair function work as expected for the given treemap.
 * 
@@ -473,7 +828,7 @@ void assertTreeNodePairEquals(TreeNodePair* expectedPair, TreeNodePair* resultPa
 * @param[in] dismissPair - Flag that makes the min/max pair buffer to a nullptr, meaning
 *						   the function will return an error status.
 */
-void assertMinMaxPairEquals(TreeNodePair* expectedPair, const TreeMap* tm, GetMinMaxPair getMinMaxPairFunc,
+void assertMinMaxPairEquals(TreeNodePair* expectedPair, TreeMap* tm, GetMinMaxPair getMinMaxPairFunc,
 	Status expectedStat, bool dismissPair);
 
 /*